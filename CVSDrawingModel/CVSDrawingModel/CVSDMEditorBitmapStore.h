@@ -56,6 +56,11 @@ extern bool CVSEditorBitmapStoreIdentifierIsValid(const CVSEditorBitmapStoreIden
  */
 - (void)renderUsingContextRenderBlock:(CVSMutableBitmapCGContextRenderBlock)pContextRenderBlock bitmapStoreIdentifier:(CVSEditorBitmapStoreIdentifier)pIdentifier;
 
+/**
+ @brief render to the bitmap specified, marking only the tiles the client modifies
+ */
+- (void)renderUsingTiledContextRenderBlock:(CVSMutableBitmapTiledCGContextRenderBlock)pContextRenderBlock bitmapStoreIdentifier:(CVSEditorBitmapStoreIdentifier)pIdentifier;
+
 /**
  @brief clears the bitmap's contents
  */
@@ -80,4 +85,14 @@ extern bool CVSEditorBitmapStoreIdentifierIsValid(const CVSEditorBitmapStoreIden
  */
 - (void)writeBitmapContents:(CVSDMImmutableDataReference *)pImmutableDataReference bitmapStoreIdentifier:(CVSEditorBitmapStoreIdentifier)pIdentifier;
 
+/**
+ @brief copies the tiles of the selected bitmap which were modified after @p pStamp. see CVSDMMutableBitmap.
+ */
+- (NSData *)newTilesModifiedSinceStamp:(uint64_t)pStamp outModificationStamp:(uint64_t*)pOutModificationStamp outTileCount:(size_t*)pOutTileCount bitmapStoreIdentifier:(CVSEditorBitmapStoreIdentifier)pIdentifier;
+
+/**
+ @brief writes packed tiles to the selected bitmap. see CVSDMMutableBitmap.
+ */
+- (size_t)writeTiles:(NSArray *)pPackedTiles skippingTilesNotModifiedSinceStamp:(uint64_t)pStamp bitmapStoreIdentifier:(CVSEditorBitmapStoreIdentifier)pIdentifier;
+
 @end
@@ -96,6 +96,11 @@ bool CVSEditorBitmapStoreIdentifierIsValid(const CVSEditorBitmapStoreIdentifier
     [[self bitmap:pIdentifier] renderUsingContextRenderBlock:pContextRenderBlock];
 }
 
+- (void)renderUsingTiledContextRenderBlock:(CVSMutableBitmapTiledCGContextRenderBlock)pContextRenderBlock bitmapStoreIdentifier:(CVSEditorBitmapStoreIdentifier)pIdentifier
+{
+    [[self bitmap:pIdentifier] renderUsingTiledContextRenderBlock:pContextRenderBlock];
+}
+
 - (void)clear:(CVSEditorBitmapStoreIdentifier)pIdentifier
 {
     [[self bitmap:pIdentifier] clear];
@@ -123,4 +128,14 @@ bool CVSEditorBitmapStoreIdentifierIsValid(const CVSEditorBitmapStoreIdentifier
     [[self bitmap:pIdentifier] writeBitmapContents:pImmutableDataReference];
 }
 
+- (NSData *)newTilesModifiedSinceStamp:(uint64_t)pStamp outModificationStamp:(uint64_t*)pOutModificationStamp outTileCount:(size_t*)pOutTileCount bitmapStoreIdentifier:(CVSEditorBitmapStoreIdentifier)pIdentifier
+{
+    return [[self bitmap:pIdentifier] newTilesModifiedSinceStamp:pStamp outModificationStamp:pOutModificationStamp outTileCount:pOutTileCount];
+}
+
+- (size_t)writeTiles:(NSArray *)pPackedTiles skippingTilesNotModifiedSinceStamp:(uint64_t)pStamp bitmapStoreIdentifier:(CVSEditorBitmapStoreIdentifier)pIdentifier
+{
+    return [[self bitmap:pIdentifier] writeTiles:pPackedTiles skippingTilesNotModifiedSinceStamp:pStamp];
+}
+
 @end
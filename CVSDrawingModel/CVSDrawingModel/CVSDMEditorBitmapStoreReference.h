@@ -20,6 +20,7 @@
 - (BOOL)areDimensionsEqualTo:(CVSDMMutableBitmap *)pOther;
 - (void)drawImageInRect:(CGRect)pRect context:(CGContextRef)pContext;
 - (void)renderUsingContextRenderBlock:(CVSMutableBitmapCGContextRenderBlock)pContextRenderBlock;
+- (void)renderUsingTiledContextRenderBlock:(CVSMutableBitmapTiledCGContextRenderBlock)pContextRenderBlock;
 - (void)clear;
 
 /**
@@ -42,4 +43,19 @@
  */
 - (void)writeBitmapContents:(CVSDMImmutableDataReference *)pImmutableDataReference;
 
+/**
+ @brief copies the tiles which were modified after @p pStamp. see CVSDMMutableBitmap.
+ */
+- (NSData *)newTilesModifiedSinceStamp:(uint64_t)pStamp outModificationStamp:(uint64_t*)pOutModificationStamp outTileCount:(size_t*)pOutTileCount;
+
+/**
+ @brief writes packed tiles to self's bitmap. see CVSDMMutableBitmap.
+ */
+- (size_t)writeTiles:(NSArray *)pPackedTiles skippingTilesNotModifiedSinceStamp:(uint64_t)pStamp;
+
+/**
+ @return YES if self and @p pOther refer to the same bitmap
+ */
+- (BOOL)isEqualToBitmapStoreReference:(CVSDMEditorBitmapStoreReference *)pOther;
+
 @end
@@ -63,6 +63,11 @@
     [self.bitmapStore renderUsingContextRenderBlock:pContextRenderBlock bitmapStoreIdentifier:self.bitmapStoreIdentifier];
 }
 
+- (void)renderUsingTiledContextRenderBlock:(CVSMutableBitmapTiledCGContextRenderBlock)pContextRenderBlock
+{
+    [self.bitmapStore renderUsingTiledContextRenderBlock:pContextRenderBlock bitmapStoreIdentifier:self.bitmapStoreIdentifier];
+}
+
 - (void)clear
 {
     [self.bitmapStore clear:self.bitmapStoreIdentifier];
@@ -91,4 +96,20 @@
     [self.bitmapStore writeBitmapContents:pImmutableDataReference bitmapStoreIdentifier:self.bitmapStoreIdentifier];
 }
 
+- (NSData *)newTilesModifiedSinceStamp:(uint64_t)pStamp outModificationStamp:(uint64_t*)pOutModificationStamp outTileCount:(size_t*)pOutTileCount
+{
+    return [self.bitmapStore newTilesModifiedSinceStamp:pStamp outModificationStamp:pOutModificationStamp outTileCount:pOutTileCount bitmapStoreIdentifier:self.bitmapStoreIdentifier];
+}
+
+- (size_t)writeTiles:(NSArray *)pPackedTiles skippingTilesNotModifiedSinceStamp:(uint64_t)pStamp
+{
+    assert(pPackedTiles);
+    return [self.bitmapStore writeTiles:pPackedTiles skippingTilesNotModifiedSinceStamp:pStamp bitmapStoreIdentifier:self.bitmapStoreIdentifier];
+}
+
+- (BOOL)isEqualToBitmapStoreReference:(CVSDMEditorBitmapStoreReference *)pOther
+{
+    return pOther.bitmapStore == self.bitmapStore && pOther.bitmapStoreIdentifier == self.bitmapStoreIdentifier;
+}
+
 @end
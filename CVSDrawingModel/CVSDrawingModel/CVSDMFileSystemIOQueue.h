@@ -13,6 +13,11 @@ typedef void(^CVSDMFileSystemIOQueueTask)(void);
  */
 typedef void(^CVSDMFileSystemIOQueueClosure)(void);
 
+/**
+ @brief a block which is performed on a client specified dispatch queue after an I/O task has completed.
+ */
+typedef void(^CVSDMFileSystemIOQueueCompletion)(void);
+
 /**
  @class an interface for a named I/O queues, used for filesystem operations.
  @details the class defines a one named serial dispatch queue (FIFO) and one named concurrent dispatch queue.
@@ -36,6 +41,11 @@ typedef void(^CVSDMFileSystemIOQueueClosure)(void);
  */
 - (void)dispatch:(CVSDMFileSystemIOQueueTask)pTask;
 
+/**
+ @brief adds the I/O task @p pTask to the queue. when it has completed, @p pCompletion is performed asynchronously on @p pCompletionQueue. the blocks are copied.
+ */
+- (void)dispatch:(CVSDMFileSystemIOQueueTask)pTask completionQueue:(dispatch_queue_t)pCompletionQueue completion:(CVSDMFileSystemIOQueueCompletion)pCompletion;
+
 ///// Convenience Methods /////
 
 - (void)removeItemAtURL:(NSURL *)pURL;
@@ -72,6 +72,19 @@ static const char CVSDMFileSystemIOQueue_Queue_Concurrent[] = "as.canv.CVSDMFile
     dispatch_async(self.queue, pTask);
 }
 
+- (void)dispatch:(CVSDMFileSystemIOQueueTask)pTask completionQueue:(dispatch_queue_t)pCompletionQueue completion:(CVSDMFileSystemIOQueueCompletion)pCompletion
+{
+    assert(pTask);
+    assert(pCompletionQueue);
+    assert(pCompletion);
+    CVSDMFileSystemIOQueueTask task = [pTask copy];
+    CVSDMFileSystemIOQueueCompletion completion = [pCompletion copy];
+    dispatch_async(self.queue, ^{
+        task();
+        dispatch_async(pCompletionQueue, completion);
+    });
+}
+
 - (void)removeItemAtURL:(NSURL *)pURL
 {
     __strong NSURL * url = pURL.copy;
@@ -6,29 +6,36 @@
 typedef void(^CVSDMImageSnapshotQueueAsyncIOTask)(void);
 
 /**
- @brief completion closure.
+ @brief called on the main queue when a restore has completed.
+ @p pStrokeCount the stroke count of the snapshot which was written, or CVSDMImageSnapshot_NonSnapshotStrokeCount if no snapshot was written.
  */
-typedef void (^CVSDMImageSnapshotQueueCompletionClosure)(void);
+typedef void (^CVSDMImageSnapshotQueueRestoreCompletion)(NSUInteger pStrokeCount);
 
 /**
- @brief initiation block containing completion closure.
+ @brief constant defines a number which represents the non-snapshot value.
  */
-typedef CVSDMImageSnapshotQueueCompletionClosure (^CVSDMImageSnapshotQueueInitiationBlock)(void);
+extern const uint32_t CVSDMImageSnapshot_NonSnapshotStrokeCount;
 
+/**
+ @brief the default number of bytes of snapshot tiles the queue holds in memory
+ */
+extern const size_t CVSDMImageSnapshotQueueDefaultMemoryBudget;
 
 /**
- @brief constant defines a number which represents the non-snapshot value.
+ @brief the default number of bytes of snapshot tiles the queue holds on disk
  */
-extern const uint32_t CVSDMImageSnapshot_NonSnapshotStrokeCount;
+extern const size_t CVSDMImageSnapshotQueueDefaultDiskBudget;
 
 /**
  @class defines a snapshot queue
- @details note that this is a temporary V2 compatibility implementation. the destination, persistence, and abiity to simply swap bitmap store references does not currently exist, but they would be good additions.
+ @details snapshots hold only the tiles which were modified since the previous snapshot (a delta), with a snapshot of every tile (a keyframe)
+ periodically, so a restore applies at most a few deltas. snapshots are held in memory until the memory budget is exceeded, then the snapshots
+ furthest from the current stroke count are moved to disk. when the disk budget is exceeded, snapshots are evicted -- see -enforceBudgets.
  */
 @interface CVSDMImageSnapshotQueue : NSObject
 
 /**
- @brief initializes self to support bitmaps of the specified size for import and export. the queue uses one buffer for all import and export operations.
+ @brief initializes self to support bitmaps of the specified size for import and export.
  */
 - (instancetype)initWithFileSystemIOQueue:(CVSDMFileSystemIOQueue *)pFileSystemIOQueue bitmapDimensions:(CVSDMBitmapDimensions)pBitmapDimensions;
 
@@ -37,6 +44,16 @@ extern const uint32_t CVSDMImageSnapshot_NonSnapshotStrokeCount;
  */
 - (CVSDMBitmapDimensions)bitmapDimensions;
 
+/**
+ @brief the number of bytes of snapshot tiles which may be held in memory. defaults to CVSDMImageSnapshotQueueDefaultMemoryBudget.
+ */
+@property (nonatomic, assign, readwrite) size_t memoryBudget;
+
+/**
+ @brief the number of bytes of snapshot tiles which may be held on disk. defaults to CVSDMImageSnapshotQueueDefaultDiskBudget. 0 disables the disk.
+ */
+@property (nonatomic, assign, readwrite) size_t diskBudget;
+
 /**
  @brief invalidates all temporary images
  */
@@ -44,7 +61,7 @@ extern const uint32_t CVSDMImageSnapshot_NonSnapshotStrokeCount;
 
 /**
  @brief requests the snapshot create a snapshot of @p pBitmapReference with an associated stroke count of @p pCurrentStrokeCount.
- @details the queue uses one buffer. if the request would block, then the request may not be honored. otherwise, the time complexity is equivalent to the time required to copy.
+ @details the time complexity is equivalent to the time required to copy the tiles modified since the previous snapshot.
  */
 - (void)enqueueSnapshotForStrokeCount:(NSUInteger)pCurrentStrokeCount bitmapReference:(CVSDMEditorBitmapStoreReference *)pBitmapReference;
 
@@ -54,14 +71,28 @@ extern const uint32_t CVSDMImageSnapshot_NonSnapshotStrokeCount;
 - (void)invalidateSnapshotsWithCountsGreaterThan:(NSUInteger)pCurrentStrokeCount;
 
 /**
- @brief performs a SYNCHRONOUS load of the latest snapshot.
- @p pBitmapReference the destination bitmap to write to
- @return the stroke count of the snapshot which was written. if 0 is returned, the snapshot was not written, and you probably want to clear the destination.
- @details the import was wrapped up quickly to jump to new features. this was never intended to be a blocking design.
+ @brief restores the latest snapshot asynchronously. the tiles are read and written to the destination on the I/O queue, then @p pCompletion is called on the main queue.
+ the tiles are read into memory before the destination is locked, so readers of the destination wait only while the tiles are copied to it.
+ @p pDestinationBitmapReference the destination bitmap to write to. when it is the bitmap the snapshots were taken of, only the tiles which were modified after the snapshot are written.
+ the client should not render to the destination until the completion is called.
+ @details the snapshots to restore are chosen when this is called; snapshots which are invalidated while the restore is in progress are still written.
  */
-- (NSUInteger)loadMostRecentSnapshot:(CVSDMEditorBitmapStoreReference *)pDestinationBitmapReference outIsImporting:(BOOL*)pOutIsImporting initiationBlock:(CVSDMImageSnapshotQueueInitiationBlock)pInitiationBlock;
+- (void)restoreMostRecentSnapshotTo:(CVSDMEditorBitmapStoreReference *)pDestinationBitmapReference completion:(CVSDMImageSnapshotQueueRestoreCompletion)pCompletion;
 
-@end
+/**
+ @brief restores the latest snapshot of at most @p pStrokeCount strokes, as -restoreMostRecentSnapshotTo:completion:. the later snapshots are not
+ invalidated, so a client may seek back and forth through the strokes (e.g. playback).
+ */
+- (void)restoreSnapshotForStrokeCount:(NSUInteger)pStrokeCount to:(CVSDMEditorBitmapStoreReference *)pDestinationBitmapReference completion:(CVSDMImageSnapshotQueueRestoreCompletion)pCompletion;
+
+/**
+ @return the stroke count of the latest snapshot, or CVSDMImageSnapshot_NonSnapshotStrokeCount if there are no snapshots.
+ */
+- (NSUInteger)strokeCountOfMostRecentSnapshot;
 
+/**
+ @return a summary of the latencies of recent restores, measured from the request to the call of the completion.
+ */
+- (CVSDMLatencySummary)restoreLatencySummary;
 
-extern bool CVSDMImageSnapshotQueue_ApplyHack_NotSoSlowIn_3_0_0(void);
+@end
@@ -3,45 +3,56 @@
 // Created by justin carlson on 10/24/13.
 // Copyright (c) 2013 Canvas. All rights reserved.
 
+#import <QuartzCore/QuartzCore.h>
 #import "CVSDrawingModel.h"
 #import "Private/CVSDMImageSnapshot.h"
-#import "Private/CVSDMImageSnapshotQueueBitmap.h"
 #import "Private/CVSDMImageSnapshotQueue-Private_CVSDMImageSnapshot.h"
 
 const uint32_t CVSDMImageSnapshot_NonSnapshotStrokeCount = 0;
 
+const size_t CVSDMImageSnapshotQueueDefaultMemoryBudget = 24U * 1024U * 1024U;
+const size_t CVSDMImageSnapshotQueueDefaultDiskBudget = 96U * 1024U * 1024U;
+
 /* the minimum number of strokes to accumulate before a snapshot is saved. */
-static const NSInteger NStrokesPerSnapshot = 20;
+static const NSInteger NStrokesPerSnapshot = 10;
 
-// this is to avoid a slowness bug in DQ 3.0.0. it disables fs caching, and should not be present after 3.0.0
-bool CVSDMImageSnapshotQueue_ApplyHack_NotSoSlowIn_3_0_0(void) {return true;}
-// this is to avoid a slowness bug in DQ 3.0.0. it disables fs caching, and should not be present after 3.0.0
-static const NSInteger NStrokesPerSnapshot_ForHack_NotSoSlowIn3_0_0 = 30;
+/* the maximum number of deltas between keyframes -- bounds the number of snapshots a restore reads. */
+static const NSUInteger NDeltasPerKeyframe = 7;
 
 @interface CVSDMImageSnapshotQueue ()
 
-/* CVSDMImageSnapshot[] */
+/* CVSDMImageSnapshot[], ordered by ascending image snapshot index */
 @property (nonatomic, strong, readwrite) NSMutableArray * snapshots;
 @property (nonatomic, strong, readwrite) NSLock * snapshotsLock;
 
 @property (nonatomic, strong, readwrite) CVSDMFileSystemIOQueue * fileSystemIOQueue;
 @property (nonatomic, readonly) CVSDMTemporaryDirectory * temporaryDirectory;
-@property (nonatomic, readonly) CVSDMImageSnapshotQueueBitmap * imageSnapshotQueueBitmap;
-// this is to avoid a slowness bug in DQ 3.0.0. it disables I/O, and should not be present after 3.0.0
-@property (nonatomic, assign, readwrite) NSUInteger inMemorySnapshotIndex_ForHack_NotSoSlowIn3_0_0;
+// the bitmap the snapshots were taken of. deltas are only meaningful relative to its modification stamps.
+@property (nonatomic, strong, readwrite) CVSDMEditorBitmapStoreReference * sourceBitmapReference;
+// the most recent stroke count the queue was told of. eviction keeps snapshots near it.
+@property (nonatomic, assign, readwrite) NSUInteger currentStrokeCount;
+// incremented on every snapshot creation and restore. the snapshots' lastUse values.
+@property (nonatomic, assign, readwrite) uint64_t useClock;
+// guarded by snapshotsLock
+@property (nonatomic, readonly) CVSDMLatencyRecorder* restoreLatencyRecorder;
 
 @end
 
 @implementation CVSDMImageSnapshotQueue
+{
+    CVSDMBitmapDimensions _bitmapDimensions;
+}
 
 @synthesize snapshots = _snapshots;
 @synthesize snapshotsLock = _snapshotsLock;
 @synthesize fileSystemIOQueue = _fileSystemIOQueue;
 @synthesize temporaryDirectory = _temporaryDirectory;
-@synthesize imageSnapshotQueueBitmap = _imageSnapshotQueueBitmap;
-
-// this is to avoid a slowness bug in DQ 3.0.0. it disables I/O, and should not be present after 3.0.0
-@synthesize inMemorySnapshotIndex_ForHack_NotSoSlowIn3_0_0 = _inMemorySnapshotIndex_ForHack_NotSoSlowIn3_0_0;
+@synthesize sourceBitmapReference = _sourceBitmapReference;
+@synthesize currentStrokeCount = _currentStrokeCount;
+@synthesize useClock = _useClock;
+@synthesize restoreLatencyRecorder = _restoreLatencyRecorder;
+@synthesize memoryBudget = _memoryBudget;
+@synthesize diskBudget = _diskBudget;
 
 - (id)init
 {
@@ -60,9 +71,12 @@ static const NSInteger NStrokesPerSnapshot_ForHack_NotSoSlowIn3_0_0 = 30;
     _snapshots = [NSMutableArray new];
     _snapshotsLock = [NSLock new];
     _fileSystemIOQueue = pFileSystemIOQueue;
-    _imageSnapshotQueueBitmap = [[CVSDMImageSnapshotQueueBitmap alloc] initWithFileSystemIOQueue:pFileSystemIOQueue bitmapDimensions:pBitmapDimensions];
+    _bitmapDimensions = pBitmapDimensions;
+    _memoryBudget = CVSDMImageSnapshotQueueDefaultMemoryBudget;
+    _diskBudget = CVSDMImageSnapshotQueueDefaultDiskBudget;
+    _restoreLatencyRecorder = CVSDMLatencyRecorderCreate(CVSDMLatencyRecorderDefaultCapacity);
 
-    if (!_temporaryDirectory || !_snapshots || !_snapshotsLock || !_fileSystemIOQueue || !_imageSnapshotQueueBitmap) {
+    if (!_temporaryDirectory || !_snapshots || !_snapshotsLock || !_fileSystemIOQueue || !_restoreLatencyRecorder) {
         assert(0 && "error creating image snapshot queue");
         return nil;
     }
@@ -75,26 +89,38 @@ static const NSInteger NStrokesPerSnapshot_ForHack_NotSoSlowIn3_0_0 = 30;
         [self invalidateAllTemporaryImages];
         _snapshots = nil;
         _snapshotsLock = nil;
-        _imageSnapshotQueueBitmap = nil;
         _temporaryDirectory = nil;
         _fileSystemIOQueue = nil;
     }
+    CVSDMLatencyRecorderDestroy(_restoreLatencyRecorder), _restoreLatencyRecorder = NULL;
 }
 
 - (CVSDMBitmapDimensions)bitmapDimensions
 {
-    return self.imageSnapshotQueueBitmap.bitmapDimensions;
+    return _bitmapDimensions;
+}
+
+- (void)setMemoryBudget:(size_t)pMemoryBudget
+{
+    CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
+        _memoryBudget = pMemoryBudget;
+        [self enforceBudgets_unlocked];
+    });
+}
+
+- (void)setDiskBudget:(size_t)pDiskBudget
+{
+    CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
+        _diskBudget = pDiskBudget;
+        [self enforceBudgets_unlocked];
+    });
 }
 
 - (void)invalidateAllTemporaryImages
 {
     CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
         @autoreleasepool {
-            if (self.snapshots.count) {
-                NSArray * const removed = self.snapshots.copy;
-                [self.snapshots removeAllObjects];
-                [self.imageSnapshotQueueBitmap snapshotsWereInvalidated:removed activeSnapshots:self.snapshots];
-            }
+            [self.snapshots removeAllObjects];
         }
     });
 }
@@ -102,30 +128,14 @@ static const NSInteger NStrokesPerSnapshot_ForHack_NotSoSlowIn3_0_0 = 30;
 // caller must lock
 - (void)popStrokesGreaterThanOrEqualTo_unlocked:(NSUInteger)pCurrentStrokeCount
 {
-
-    // 3.0.0 HACK ALERT
-    if (CVSDMImageSnapshotQueue_ApplyHack_NotSoSlowIn_3_0_0()) {
-        if (self.inMemorySnapshotIndex_ForHack_NotSoSlowIn3_0_0 >= pCurrentStrokeCount) {
-            self.inMemorySnapshotIndex_ForHack_NotSoSlowIn3_0_0 = CVSDMImageSnapshot_NonSnapshotStrokeCount;
-        }
-        return;
+    // later snapshots depend on earlier snapshots, never the reverse, so the tail may simply be removed
+    NSUInteger count = self.snapshots.count;
+    while (count && pCurrentStrokeCount <= [self.snapshots[count - 1] imageSnapshotIndex]) {
+        --count;
     }
-    else {
-        // pop the old snapshots
-        NSMutableArray * remove = [NSMutableArray new];
-        for (CVSDMImageSnapshot * at in self.snapshots) {
-            if (pCurrentStrokeCount <= at.imageSnapshotIndex) {
-                [remove addObject:at];
-            }
-        }
-        if (remove.count) {
-            @autoreleasepool {
-                // NSLog(@"Pre Pop | %i: %@", (int)pCurrentStrokeCount, self.snapshots);
-                // NSLog(@"Removing: %@", remove);
-                [self.snapshots removeObjectsInArray:remove];
-                [self.imageSnapshotQueueBitmap snapshotsWereInvalidated:remove activeSnapshots:self.snapshots];
-                // NSLog(@"Post Pop: %@", self.snapshots);
-            }
+    if (count != self.snapshots.count) {
+        @autoreleasepool {
+            [self.snapshots removeObjectsInRange:NSMakeRange(count, self.snapshots.count - count)];
         }
     }
 }
@@ -133,129 +143,315 @@ static const NSInteger NStrokesPerSnapshot_ForHack_NotSoSlowIn3_0_0 = 30;
 - (void)invalidateSnapshotsWithCountsGreaterThan:(NSUInteger)pCurrentStrokeCount
 {
     CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
+        self.currentStrokeCount = pCurrentStrokeCount;
         [self popStrokesGreaterThanOrEqualTo_unlocked:1U + pCurrentStrokeCount];
     });
 }
 
+// caller must lock. returns the number of deltas which follow the last keyframe.
+- (NSUInteger)deltaCountSinceKeyframe_unlocked
+{
+    NSUInteger result = 0;
+    for (CVSDMImageSnapshot * at in self.snapshots.reverseObjectEnumerator) {
+        if (at.isKeyframe) {
+            break;
+        }
+        ++result;
+    }
+    return result;
+}
+
 - (void)enqueueSnapshotForStrokeCount:(NSUInteger)pCurrentStrokeCount bitmapReference:(CVSDMEditorBitmapStoreReference *)pBitmapReference
 {
-    // 3.0.0 HACK ALERT
-    if (CVSDMImageSnapshotQueue_ApplyHack_NotSoSlowIn_3_0_0()) {
-        assert(self.inMemorySnapshotIndex_ForHack_NotSoSlowIn3_0_0 < pCurrentStrokeCount);
+    assert(pBitmapReference);
+    assert(CVSDMBitmapDimensionsAreEqual(pBitmapReference.bitmapDimensions, self.bitmapDimensions));
+    CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
+        const CVSDMImageSnapshotIndex snapshotIndex = (CVSDMImageSnapshotIndex)pCurrentStrokeCount;
+        const NSInteger currentStrokeCount = (NSInteger)pCurrentStrokeCount;
+        self.currentStrokeCount = pCurrentStrokeCount;
+        [self popStrokesGreaterThanOrEqualTo_unlocked:pCurrentStrokeCount];
+        if (self.sourceBitmapReference && ![self.sourceBitmapReference isEqualToBitmapStoreReference:pBitmapReference]) {
+            // the deltas describe another bitmap
+            [self.snapshots removeAllObjects];
+        }
+        self.sourceBitmapReference = pBitmapReference;
+        // determine the current stroke count
+        NSInteger strokeCountOfLastSnapshot = CVSDMImageSnapshot_NonSnapshotStrokeCount;
+        CVSDMImageSnapshot * const last = self.snapshots.lastObject;
+        if (last) {
+            strokeCountOfLastSnapshot = (NSInteger)last.imageSnapshotIndex;
+        }
 
-        const NSUInteger present = self.inMemorySnapshotIndex_ForHack_NotSoSlowIn3_0_0 / NStrokesPerSnapshot_ForHack_NotSoSlowIn3_0_0;
-        const NSUInteger next = pCurrentStrokeCount / NStrokesPerSnapshot_ForHack_NotSoSlowIn3_0_0;
+        assert(strokeCountOfLastSnapshot <= currentStrokeCount);
+        const NSInteger nStrokesSinceLastSnapshot = currentStrokeCount - strokeCountOfLastSnapshot;
+        if (NStrokesPerSnapshot > nStrokesSinceLastSnapshot) {
+            // don't bother recording a snapshot which is so recent
+            return;
+        }
 
-        if (present == next) {
+        // a keyframe copies every tile (every tile's stamp is greater than 0)
+        const BOOL isKeyframe = nil == last || NDeltasPerKeyframe <= [self deltaCountSinceKeyframe_unlocked];
+        const uint64_t baseStamp = isKeyframe ? 0 : last.modificationStamp;
+        uint64_t outModificationStamp = 0;
+        size_t outTileCount = 0;
+        NSData * const tiles = [pBitmapReference newTilesModifiedSinceStamp:baseStamp outModificationStamp:&outModificationStamp outTileCount:&outTileCount];
+        if (!tiles) {
+            return;
+        }
+        CVSDMImageSnapshot * const snapshot = [[CVSDMImageSnapshot alloc] initWithImageSnapshotIndex:snapshotIndex
+                                                                                    modificationStamp:outModificationStamp
+                                                                                           isKeyframe:isKeyframe
+                                                                                                tiles:tiles];
+        assert(snapshot);
+        if (!snapshot) {
             return;
         }
+        self.useClock = self.useClock + 1;
+        snapshot.lastUse = self.useClock;
+        [self.snapshots addObject:snapshot];
+        [self enforceBudgets_unlocked];
+        // NSLog(@"Post Enqueue: %@", self.snapshots);
+    });
+}
+
+#pragma mark - Budgets
 
-        [self.imageSnapshotQueueBitmap notSoSlowIn300_setContentTo:pBitmapReference];
-        self.inMemorySnapshotIndex_ForHack_NotSoSlowIn3_0_0 = pCurrentStrokeCount;
-        return;
+// caller must lock. the distance of the snapshot from the current stroke count.
+- (uint64_t)distanceOfSnapshot_unlocked:(CVSDMImageSnapshot *)pSnapshot
+{
+    const uint64_t index = pSnapshot.imageSnapshotIndex;
+    const uint64_t current = self.currentStrokeCount;
+    return current > index ? current - index : 0;
+}
+
+// caller must lock. returns YES if @p pA is preferred over @p pB as the next snapshot to move to disk.
+- (BOOL)isSnapshot_unlocked:(CVSDMImageSnapshot *)pA preferredForDiskOverSnapshot:(CVSDMImageSnapshot *)pB
+{
+    const uint64_t a = [self distanceOfSnapshot_unlocked:pA];
+    const uint64_t b = [self distanceOfSnapshot_unlocked:pB];
+    if (a != b) {
+        return a > b;
     }
-    else {
-        assert(pBitmapReference);
-        CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
-            const CVSDMImageSnapshotIndex snapshotIndex = (CVSDMImageSnapshotIndex)pCurrentStrokeCount;
-            const NSInteger currentStrokeCount = (NSInteger)pCurrentStrokeCount;
-            [self popStrokesGreaterThanOrEqualTo_unlocked:pCurrentStrokeCount];
-            // determine the current stroke count
-            NSInteger strokeCountOfLastSnapshot = CVSDMImageSnapshot_NonSnapshotStrokeCount;
-            CVSDMImageSnapshot * const last = self.snapshots.lastObject;
-            if (last) {
-                strokeCountOfLastSnapshot = (NSInteger)last.imageSnapshotIndex;
-            }
+    return pA.lastUse < pB.lastUse;
+}
 
-            assert(strokeCountOfLastSnapshot <= currentStrokeCount);
-            const NSInteger nStrokesSinceLastSnapshot = currentStrokeCount - strokeCountOfLastSnapshot;
-            if (NStrokesPerSnapshot > nStrokesSinceLastSnapshot) {
-                // don't bother recording a snapshot which is so recent
-                return;
-            }
+/*
+ caller must lock. returns the index of the snapshot to evict, or NSNotFound. when @p pOnDiskOnly is YES, only snapshots on disk are candidates.
+
+ the most recent snapshot is never evicted. of the rest, the snapshot whose neighbours are closest together relative to its
+ distance from the current stroke count is evicted (ties go to the least recently used), which leaves snapshots spaced roughly
+ in proportion to their distance -- dense where undo is likely, sparse (but present) far back in the drawing. the choice
+ depends only on the snapshots' indices and uses, so it is deterministic.
+ */
+- (NSUInteger)indexOfSnapshotToEvictOnDiskOnly_unlocked:(BOOL)pOnDiskOnly
+{
+    NSArray * const snapshots = self.snapshots;
+    const NSUInteger count = snapshots.count;
+    NSUInteger result = NSNotFound;
+    uint64_t resultDistance = 0;
+    uint64_t resultGap = 1;
+    uint64_t resultLastUse = 0;
+    for (NSUInteger idx = 0; idx + 1 < count; ++idx) {
+        CVSDMImageSnapshot * const at = snapshots[idx];
+        if (pOnDiskOnly && 0 == at.diskByteCount) {
+            continue;
+        }
+        const uint64_t previous = idx ? [snapshots[idx - 1] imageSnapshotIndex] : CVSDMImageSnapshot_NonSnapshotStrokeCount;
+        const uint64_t gap = [snapshots[idx + 1] imageSnapshotIndex] - previous;
+        const uint64_t distance = [self distanceOfSnapshot_unlocked:at];
+        // compare distance / gap without division
+        const uint64_t lhs = distance * resultGap;
+        const uint64_t rhs = resultDistance * gap;
+        if (NSNotFound == result || lhs > rhs || (lhs == rhs && at.lastUse < resultLastUse)) {
+            result = idx;
+            resultDistance = distance;
+            resultGap = gap;
+            resultLastUse = at.lastUse;
+        }
+    }
+    return result;
+}
 
-            {
-                // make room for the next snapshot -- this must happen prior to creation
-                const uint32_t MaxCacheMB = 200;
-                const uint32_t MBPerSnapshot = 12;
-                // GitHub ISSUE #338 -- the cache should rebuild itself if many undo actions have occurred
-                const NSUInteger MaxSnapshots = MaxCacheMB/MBPerSnapshot;
-                const NSUInteger nSnapshots = self.snapshots.count;
-                assert(MaxSnapshots >= nSnapshots);
-
-                if (MaxSnapshots == nSnapshots) {
-                    // leave the latest close by. although it is naive, it will balance out pretty well in typical usage.
-                    const NSUInteger i = arc4random_uniform((uint32_t)(MaxSnapshots - 3U));
-                    NSArray * const removed = [NSArray arrayWithObject:self.snapshots[i]];
-                    [self.snapshots removeObjectAtIndex:i];
-                    [self.imageSnapshotQueueBitmap snapshotsWereInvalidated:removed activeSnapshots:self.snapshots];
+// caller must lock. moves snapshots to disk and evicts snapshots until the budgets are met.
+- (void)enforceBudgets_unlocked
+{
+    while (1) {
+        size_t residentByteCount = 0;
+        size_t diskByteCount = 0;
+        CVSDMImageSnapshot * toMove = nil;
+        for (CVSDMImageSnapshot * at in self.snapshots) {
+            const size_t onDisk = at.diskByteCount;
+            diskByteCount += onDisk;
+            if (0 == onDisk) {
+                residentByteCount += at.memoryByteCount;
+                if (nil == toMove || [self isSnapshot_unlocked:at preferredForDiskOverSnapshot:toMove]) {
+                    toMove = at;
                 }
             }
-
-            // create and record the snapshot
-            CVSDMImageSnapshot * const snapshot = [self.imageSnapshotQueueBitmap nonBlockingAttemptToCreateSnapshotUsingBitmapReferencesData:pBitmapReference
-                                                                                                                          parentDirectoryURL:self.temporaryDirectory.URL
-                                                                                                                          imageSnapshotQueue:self
-                                                                                                                          imageSnapshotIndex:snapshotIndex];
-
-            if (nil == snapshot) {
-                // nil indicates the operation would block (e.g. the shared I/O bitmap buffer is presently in use by another task)
+        }
+        const bool isOverMemoryBudget = residentByteCount > self.memoryBudget;
+        const bool isOverDiskBudget = diskByteCount > self.diskBudget;
+        if (isOverDiskBudget || (isOverMemoryBudget && 0 == self.diskBudget)) {
+            const NSUInteger idx = [self indexOfSnapshotToEvictOnDiskOnly_unlocked:isOverDiskBudget];
+            if (NSNotFound == idx) {
                 return;
             }
-
-            [self.snapshots addObject:snapshot];
-            // NSLog(@"Post Enqueue: %@", self.snapshots);
-        });
+            @autoreleasepool {
+                // the successor must hold the evicted snapshot's tiles, or restores of the successor would be incomplete
+                [self.snapshots[idx + 1] mergeTilesOfPredecessor:self.snapshots[idx] fileSystemIOQueue:self.fileSystemIOQueue parentDirectoryURL:self.temporaryDirectory.URL];
+                [self.snapshots removeObjectAtIndex:idx];
+            }
+        }
+        else if (isOverMemoryBudget && toMove) {
+            [toMove moveToDiskWithFileSystemIOQueue:self.fileSystemIOQueue parentDirectoryURL:self.temporaryDirectory.URL];
+        }
+        else {
+            return;
+        }
     }
 }
 
-- (NSUInteger)loadMostRecentSnapshot:(CVSDMEditorBitmapStoreReference *)pDestinationBitmapReference outIsImporting:(BOOL*)pOutIsImporting initiationBlock:(CVSDMImageSnapshotQueueInitiationBlock)pInitiationBlock
+#pragma mark - Restore
+
+/*
+ returns the tiles of @p pChain (newest first), each tile taken from the first snapshot which holds it, packed in one buffer
+ in memory, ordered by tile index. reading a snapshot on disk pages it in, so call this on the I/O queue, and before taking
+ the destination's write lock: the lock is then held only to copy the tiles into the bitmap.
+ */
+static NSData * CVSDMImageSnapshotQueueNewResolvedTiles(NSArray * const pChain)
 {
-    assert(pDestinationBitmapReference);
-    assert(pInitiationBlock);
-    assert(pOutIsImporting);
-    assert(NO == *pOutIsImporting);
-
-    // 3.0.0 HACK ALERT
-    if (CVSDMImageSnapshotQueue_ApplyHack_NotSoSlowIn_3_0_0()) {
-        *pOutIsImporting = NO;
-        [self.imageSnapshotQueueBitmap notSoSlowIn300_writeContentsTo:pDestinationBitmapReference];
-        return self.inMemorySnapshotIndex_ForHack_NotSoSlowIn3_0_0;
+    NSMutableArray * const chainTiles = [NSMutableArray arrayWithCapacity:pChain.count];
+    size_t tileCount = 0;
+    for (CVSDMImageSnapshot * at in pChain) {
+        NSData * const tiles = at.tiles;
+        [chainTiles addObject:tiles];
+        const char* tile = tiles.bytes;
+        const char* const end = tile + tiles.length;
+        while (tile < end) {
+            CVSDMPackedTileHeader header;
+            memcpy(&header, tile, sizeof(header));
+            tileCount = MAX(tileCount, (size_t)header.tileIndex + 1);
+            tile += sizeof(header) + header.byteCount;
+        }
+    }
+    // the first occurrence of each tile
+    const char** const sources = calloc(MAX(tileCount, 1), sizeof(const char*));
+    if (!sources) {
+        assert(0 && "failed to allocate tile sources");
+        return nil;
+    }
+    size_t length = 0;
+    for (NSData * tiles in chainTiles) {
+        const char* tile = tiles.bytes;
+        const char* const end = tile + tiles.length;
+        while (tile < end) {
+            CVSDMPackedTileHeader header;
+            memcpy(&header, tile, sizeof(header));
+            if (!sources[header.tileIndex]) {
+                sources[header.tileIndex] = tile;
+                length += sizeof(header) + header.byteCount;
+            }
+            tile += sizeof(header) + header.byteCount;
+        }
+    }
+    NSMutableData * const result = [[NSMutableData alloc] initWithLength:length];
+    if (result) {
+        char* at = result.mutableBytes;
+        for (size_t idx = 0; idx < tileCount; ++idx) {
+            if (sources[idx]) {
+                CVSDMPackedTileHeader header;
+                memcpy(&header, sources[idx], sizeof(header));
+                memcpy(at, sources[idx], sizeof(header) + header.byteCount);
+                at += sizeof(header) + header.byteCount;
+            }
+        }
     }
     else {
+        assert(0 && "failed to allocate resolved tiles");
+    }
+    free(sources);
+    return result;
+}
 
+- (void)restoreMostRecentSnapshotTo:(CVSDMEditorBitmapStoreReference *)pDestinationBitmapReference completion:(CVSDMImageSnapshotQueueRestoreCompletion)pCompletion
+{
+    [self restoreSnapshotForStrokeCount:NSUIntegerMax to:pDestinationBitmapReference completion:pCompletion];
+}
 
-        __block NSUInteger snapshotIndex = CVSDMImageSnapshot_NonSnapshotStrokeCount;
-        __block bool isEmpty = false;
-        // need to retry if the snapshot state changes
-        while (CVSDMImageSnapshot_NonSnapshotStrokeCount == snapshotIndex && NO == *pOutIsImporting && !isEmpty) {
-            CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
-                if (0 == self.snapshots.count) {
-                    isEmpty = true;
-                    return;
-                }
-                {
-                    // read the snapshot which is in memory, if possible
-                    CVSDMImageSnapshot * const snapshotInMemory = [self.imageSnapshotQueueBitmap copyBitmapDataTo:pDestinationBitmapReference outIsImporting:pOutIsImporting initiationBlock:pInitiationBlock];
-                    if (nil != snapshotInMemory) {
-                        assert(NO == *pOutIsImporting);
-                        assert([self.snapshots containsObject:snapshotInMemory]);
-                        snapshotIndex = snapshotInMemory.imageSnapshotIndex;
-                        return;
-                    }
-                }
-                if (*pOutIsImporting) {
-                    return;
-                }
-                BOOL outIsCurrentSnapshot = NO;
-                [self.imageSnapshotQueueBitmap attemptToImportSnapshot:self.snapshots.lastObject initiationBlock:pInitiationBlock outIsCurrentSnapshot:&outIsCurrentSnapshot];
-                if (!outIsCurrentSnapshot) {
-                    *pOutIsImporting = YES;
-                }
-            });
+- (void)restoreSnapshotForStrokeCount:(NSUInteger)pStrokeCount to:(CVSDMEditorBitmapStoreReference *)pDestinationBitmapReference completion:(CVSDMImageSnapshotQueueRestoreCompletion)pCompletion
+{
+    assert(pDestinationBitmapReference);
+    assert(pCompletion);
+    const CFTimeInterval start = CACurrentMediaTime();
+
+    // choose the snapshots now. the tiles are read (and paged in, if they are on disk) on the I/O queue.
+    NSMutableArray * const chain = [NSMutableArray new];
+    __block NSUInteger snapshotIndex = CVSDMImageSnapshot_NonSnapshotStrokeCount;
+    __block uint64_t stamp = 0;
+    CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
+        NSUInteger count = self.snapshots.count;
+        while (count && pStrokeCount < [self.snapshots[count - 1] imageSnapshotIndex]) {
+            --count;
         }
-        return snapshotIndex;
-    }
+        if (!count) {
+            return;
+        }
+        CVSDMImageSnapshot * const last = self.snapshots[count - 1];
+        // newest first, back to the keyframe
+        self.useClock = self.useClock + 1;
+        while (count) {
+            CVSDMImageSnapshot * const at = self.snapshots[--count];
+            [chain addObject:at];
+            at.lastUse = self.useClock;
+            if (at.isKeyframe) {
+                break;
+            }
+        }
+        // tiles of the source which have not been modified since the snapshot are already correct
+        const bool isSource = [self.sourceBitmapReference isEqualToBitmapStoreReference:pDestinationBitmapReference];
+        stamp = isSource ? last.modificationStamp : 0;
+        snapshotIndex = last.imageSnapshotIndex;
+    });
+
+    CVSDMImageSnapshotQueueRestoreCompletion completion = [pCompletion copy];
+    [self.fileSystemIOQueue dispatch:^{
+        if (!chain.count) {
+            return;
+        }
+        @autoreleasepool {
+            NSData * const tiles = CVSDMImageSnapshotQueueNewResolvedTiles(chain);
+            if (tiles) {
+                [pDestinationBitmapReference writeTiles:@[tiles] skippingTilesNotModifiedSinceStamp:stamp];
+            }
+        }
+    } completionQueue:dispatch_get_main_queue() completion:^{
+        const CFTimeInterval latency = CACurrentMediaTime() - start;
+        CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
+            CVSDMLatencyRecorderRecord(self.restoreLatencyRecorder, latency);
+        });
+        completion(snapshotIndex);
+    }];
+}
+
+- (NSUInteger)strokeCountOfMostRecentSnapshot
+{
+    __block NSUInteger result = CVSDMImageSnapshot_NonSnapshotStrokeCount;
+    CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
+        CVSDMImageSnapshot * const last = self.snapshots.lastObject;
+        if (last) {
+            result = last.imageSnapshotIndex;
+        }
+    });
+    return result;
+}
+
+- (CVSDMLatencySummary)restoreLatencySummary
+{
+    __block CVSDMLatencySummary result = {0, 0.0, 0.0, 0.0, 0.0};
+    CVSDMLockingBlock_NSLocking(self.snapshotsLock, ^{
+        result = CVSDMLatencyRecorderGetSummary(self.restoreLatencyRecorder);
+    });
+    return result;
 }
 
 @end
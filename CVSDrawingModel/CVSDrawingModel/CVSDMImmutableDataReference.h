@@ -17,11 +17,24 @@
  */
 - (instancetype)initWithDataAtURL:(NSURL *)pURL;
 
+/**
+ @brief initializes self with a read-only memory mapping of the file at the specified URL. pages are read from the page cache as they are
+ accessed and may be discarded by the system under memory pressure, so the file's content is never copied into the heap.
+ the mapping is removed when the data (which may outlive self) is deallocated. the file must not be modified while it is mapped.
+ @return nil if the file could not be mapped (e.g. it is empty).
+ */
+- (instancetype)initWithMappedFileAtURL:(NSURL *)pURL;
+
 /**
  @return the NSData self represents.
  */
 - (NSData *)data;
 
+/**
+ @return YES if the data is a memory mapping of the file at the reference URL.
+ */
+- (BOOL)isMemoryMapped;
+
 /**
  @return the reference URL if the origin is known, else nil.
  @details be aware of cases where you may use a link rather than a physical copy.
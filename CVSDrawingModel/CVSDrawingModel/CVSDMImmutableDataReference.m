@@ -3,12 +3,76 @@
 // Created by justin carlson on 10/21/13.
 // Copyright (c) 2013 Canvas. All rights reserved.
 
+#import <sys/mman.h>
+#import <sys/stat.h>
 #import "CVSDrawingModel.h"
 
+/**
+ @brief NSData which owns a read-only file mapping. the mapping is removed when the data is deallocated.
+ */
+@interface CVSDMMappedData : NSData
+- (instancetype)initWithMappedFileAtURL:(NSURL *)pURL;
+@end
+
+@implementation CVSDMMappedData
+{
+    void* address;
+    NSUInteger length;
+}
+
+- (instancetype)initWithMappedFileAtURL:(NSURL *)pURL
+{
+    assert(pURL);
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    const int fd = open(pURL.fileSystemRepresentation, O_RDONLY);
+    if (-1 == fd) {
+        return nil;
+    }
+    struct stat st;
+    if (0 != fstat(fd, &st) || 0 >= st.st_size) {
+        close(fd);
+        return nil;
+    }
+    void* const mapping = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_FILE | MAP_PRIVATE, fd, 0);
+    // the mapping holds its own reference to the file
+    close(fd);
+    if (MAP_FAILED == mapping) {
+        return nil;
+    }
+    // readers (e.g. snapshot restores) walk the file from start to end
+    (void)madvise(mapping, (size_t)st.st_size, MADV_SEQUENTIAL);
+    address = mapping;
+    length = (NSUInteger)st.st_size;
+    return self;
+}
+
+- (void)dealloc
+{
+    if (address) {
+        munmap(address, length), address = NULL;
+    }
+}
+
+- (const void*)bytes
+{
+    return address;
+}
+
+- (NSUInteger)length
+{
+    return length;
+}
+
+@end
+
 @implementation CVSDMImmutableDataReference
 {
     NSData * data;
     NSURL * URL;
+    BOOL isMemoryMapped;
 }
 
 - (instancetype)initWithData:(NSData *)pData
@@ -43,6 +107,26 @@
     return self;
 }
 
+- (instancetype)initWithMappedFileAtURL:(NSURL *)pURL
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    data = [[CVSDMMappedData alloc] initWithMappedFileAtURL:pURL];
+    if (!data) {
+        return nil;
+    }
+    URL = pURL.copy;
+    isMemoryMapped = YES;
+    return self;
+}
+
+- (BOOL)isMemoryMapped
+{
+    return isMemoryMapped;
+}
+
 - (NSData *)data
 {
     return data;
@@ -0,0 +1,85 @@
+// CVSDMLatencyRecorder.c
+// CVSDrawingModel
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CVSDMLatencyRecorder.h"
+
+struct CVSDMLatencyRecorder {
+    size_t capacity;
+    uint64_t totalCount;
+    double* samples;
+};
+
+CVSDMLatencyRecorder* CVSDMLatencyRecorderCreate(const size_t pCapacity) {
+    assert(pCapacity);
+    CVSDMLatencyRecorder* const result = calloc(1, sizeof(CVSDMLatencyRecorder));
+    if (!result) {
+        return NULL;
+    }
+    result->capacity = pCapacity;
+    result->samples = calloc(pCapacity, sizeof(double));
+    if (!result->samples) {
+        free(result);
+        return NULL;
+    }
+    return result;
+}
+
+void CVSDMLatencyRecorderDestroy(CVSDMLatencyRecorder* const pRecorder) {
+    if (!pRecorder) {
+        return;
+    }
+    free(pRecorder->samples);
+    free(pRecorder);
+}
+
+void CVSDMLatencyRecorderRecord(CVSDMLatencyRecorder* const pRecorder, const double pSeconds) {
+    assert(pRecorder);
+    pRecorder->samples[pRecorder->totalCount % pRecorder->capacity] = pSeconds;
+    ++pRecorder->totalCount;
+}
+
+uint64_t CVSDMLatencyRecorderGetTotalCount(const CVSDMLatencyRecorder* const pRecorder) {
+    assert(pRecorder);
+    return pRecorder->totalCount;
+}
+
+static int CVSDMLatencyRecorderCompareSamples(const void* const pA, const void* const pB) {
+    const double a = *(const double*)pA;
+    const double b = *(const double*)pB;
+    return (a > b) - (a < b);
+}
+
+// nearest rank
+static double CVSDMLatencyRecorderPercentile(const double* const pSorted, const size_t pCount, const size_t pPercent) {
+    size_t rank = (pPercent * pCount + 99) / 100;
+    rank = rank ? rank : 1;
+    return pSorted[rank - 1];
+}
+
+CVSDMLatencySummary CVSDMLatencyRecorderGetSummary(const CVSDMLatencyRecorder* const pRecorder) {
+    assert(pRecorder);
+    CVSDMLatencySummary result = {0, 0.0, 0.0, 0.0, 0.0};
+    const size_t count = pRecorder->totalCount < pRecorder->capacity ? (size_t)pRecorder->totalCount : pRecorder->capacity;
+    if (!count) {
+        return result;
+    }
+    double* const sorted = malloc(count * sizeof(double));
+    if (!sorted) {
+        assert(0 && "failed to allocate samples");
+        return result;
+    }
+    memcpy(sorted, pRecorder->samples, count * sizeof(double));
+    qsort(sorted, count, sizeof(double), CVSDMLatencyRecorderCompareSamples);
+    result.count = count;
+    result.p50 = CVSDMLatencyRecorderPercentile(sorted, count, 50);
+    result.p90 = CVSDMLatencyRecorderPercentile(sorted, count, 90);
+    result.p99 = CVSDMLatencyRecorderPercentile(sorted, count, 99);
+    result.max = sorted[count - 1];
+    free(sorted);
+    return result;
+}
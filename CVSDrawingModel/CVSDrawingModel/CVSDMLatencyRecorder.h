@@ -0,0 +1,46 @@
+// CVSDMLatencyRecorder.h
+// CVSDrawingModel
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+/**
+ @brief records the most recent latencies of an operation (e.g. snapshot restores) and summarizes them as percentiles.
+ @details the recorder retains a fixed number of samples; older samples are overwritten. it is not thread safe; the owner serializes access.
+ */
+typedef struct CVSDMLatencyRecorder CVSDMLatencyRecorder;
+
+/**
+ @brief the default number of samples retained
+ */
+enum { CVSDMLatencyRecorderDefaultCapacity = 256 };
+
+/**
+ @brief a summary of the retained samples, in seconds. percentiles are nearest rank. every field is 0 if there are no samples.
+ */
+typedef struct {
+    size_t count;
+    double p50;
+    double p90;
+    double p99;
+    double max;
+} CVSDMLatencySummary;
+
+/**
+ @return a new recorder which retains up to @p pCapacity samples, or NULL on failure. destroy it with CVSDMLatencyRecorderDestroy.
+ */
+extern CVSDMLatencyRecorder* CVSDMLatencyRecorderCreate(const size_t pCapacity);
+extern void CVSDMLatencyRecorderDestroy(CVSDMLatencyRecorder* const pRecorder);
+
+/**
+ @brief records one sample, in seconds
+ */
+extern void CVSDMLatencyRecorderRecord(CVSDMLatencyRecorder* const pRecorder, const double pSeconds);
+
+/**
+ @return the total number of samples recorded, including those which are no longer retained
+ */
+extern uint64_t CVSDMLatencyRecorderGetTotalCount(const CVSDMLatencyRecorder* const pRecorder);
+
+/**
+ @return a summary of the retained samples
+ */
+extern CVSDMLatencySummary CVSDMLatencyRecorderGetSummary(const CVSDMLatencyRecorder* const pRecorder);
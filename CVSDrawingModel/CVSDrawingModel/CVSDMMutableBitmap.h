@@ -10,8 +10,16 @@
  */
 typedef void (^CVSMutableBitmapCGContextRenderBlock)(CGContextRef pContext);
 
+/**
+ @brief block prototype for a client render in CGContext function which reports what it modified
+ @details the client must mark every tile it modifies in @p pTileGrid (e.g. CVSDMTileGridMarkRect with device space rects).
+ */
+typedef void (^CVSMutableBitmapTiledCGContextRenderBlock)(CGContextRef pContext, CVSDMTileGrid* pTileGrid);
+
 /**
  @brief specifically, an 8bpc color bitmap with premultiplied alpha.
+ @details the bitmap is divided into tiles (CVSDMTileGrid) which record when they were modified. only modified tiles are
+ copied when the bitmap is drawn.
  */
 @interface CVSDMMutableBitmap : NSObject <CVSDMFileExportDestinationDataProvider>
 
@@ -24,9 +32,15 @@ typedef void (^CVSMutableBitmapCGContextRenderBlock)(CGContextRef pContext);
 
 /**
  @brief rather than providing the CGContext (e.g. by an accessor), the approach here is to offer a client block for rendering using a CGContext. the client must never hold on to the block beyond the scope of the block.
+ @details every tile is considered modified. prefer -renderUsingTiledContextRenderBlock: where the client knows what it draws.
  */
 - (void)renderUsingContextRenderBlock:(CVSMutableBitmapCGContextRenderBlock)pContextRenderBlock;
 
+/**
+ @brief like -renderUsingContextRenderBlock:, but only the tiles which the client marks are considered modified.
+ */
+- (void)renderUsingTiledContextRenderBlock:(CVSMutableBitmapTiledCGContextRenderBlock)pContextRenderBlock;
+
 /**
  @brief fills the bitmap with opaque black
  */
@@ -35,7 +49,10 @@ typedef void (^CVSMutableBitmapCGContextRenderBlock)(CGContextRef pContext);
 
 /**
  @brief note that this method does nothing special to set up the context. it's the client's responsibility to configure and clip the context as needed.
- @details we want to avoid handing out the image. the CGImage wrapper is generally cheap to "create", but modern implementations add copy on write protection.
+ @details we want to avoid handing out the image. the CGImage wrapper is generally cheap to "create", but modern implementations add copy on write protection,
+ which copies the entire bitmap on the next render. instead, the bitmap is drawn as one image per tile. only the tiles within the context's clip are drawn,
+ and a tile's image is only recreated (copied) when the tile has been modified since it was last drawn, or when its image was released: only the images of
+ the most recently drawn tiles are kept, within a few megabytes. @p pRect should map tiles to whole pixels to avoid seams.
  */
 - (void)drawImageInRect:(CGRect)pRect context:(CGContextRef)pContext;
 
@@ -54,4 +71,20 @@ typedef void (^CVSMutableBitmapCGContextRenderBlock)(CGContextRef pContext);
  */
 - (void)writeBitmapContents:(CVSDMImmutableDataReference *)pImmutableDataReference;
 
+/**
+ @brief copies the tiles which were modified after @p pStamp. pass 0 to copy every tile.
+ @p pOutModificationStamp receives the bitmap's modification stamp at the time of the copy -- the stamp to pass to the next request.
+ @p pOutTileCount receives the number of tiles copied.
+ @return the tiles, packed as CVSDMPackedTileHeader describes.
+ */
+- (NSData *)newTilesModifiedSinceStamp:(uint64_t)pStamp outModificationStamp:(uint64_t*)pOutModificationStamp outTileCount:(size_t*)pOutTileCount;
+
+/**
+ @brief writes packed tiles (see -newTilesModifiedSinceStamp:outModificationStamp:outTileCount:) to the bitmap.
+ @p pPackedTiles NSData[]. when a tile appears in more than one, the first occurrence is written.
+ @p pStamp tiles which have not been modified after this stamp are not written. pass 0 to write every tile.
+ @return the number of tiles written. the written tiles are marked as modified.
+ */
+- (size_t)writeTiles:(NSArray *)pPackedTiles skippingTilesNotModifiedSinceStamp:(uint64_t)pStamp;
+
 @end
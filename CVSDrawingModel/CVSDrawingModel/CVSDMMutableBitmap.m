@@ -6,19 +6,36 @@
 #import <QuartzCore/QuartzCore.h>
 #import "CVSDrawingModel.h"
 
+/* the most memory the tile images may hold after a draw: each image is a copy of its tile's pixels. the images of the tiles which
+ were drawn longest ago are released first. a draw of more than this (e.g. the whole bitmap) copies its tiles again next time. */
+static const size_t TileImagesMemoryBudget = 4U * 1024U * 1024U;
+
 @interface CVSDMMutableBitmap () <CVSDMReadWriteLockProvider>
 
 @property (nonatomic, readonly) CVSDMAlignedMemory * pixelBuffer;
 @property (nonatomic, readonly) CGContextRef bitmapContext;
 @property (nonatomic, readonly) CVSDMReadWriteLock * rwlock;
+// guards the tile images, which are updated by readers (-drawImageInRect:context:)
+@property (nonatomic, readonly) NSLock * tileImagesLock;
 
 @end
 
 @implementation CVSDMMutableBitmap
+{
+    CVSDMTileGrid* tileGrid;
+    // the image drawn for each tile (or NSNull), and the tile's modification stamp when its image was created
+    NSMutableArray * tileImages;
+    uint64_t* tileImageStamps;
+    // the draw in which each tile's image was last drawn, the number of draws, and the bytes of the tile images
+    uint64_t* tileImageUses;
+    uint64_t tileImageClock;
+    size_t tileImagesByteCount;
+}
 
 @synthesize pixelBuffer = _pixelBuffer;
 @synthesize bitmapContext = _bitmapContext;
 @synthesize rwlock = _rwlock;
+@synthesize tileImagesLock = _tileImagesLock;
 
 - (instancetype)initWithBitmapDimensions:(CVSDMBitmapDimensions)pBitmapDimensions
 {
@@ -47,12 +64,34 @@
     if (NULL == _bitmapContext) {
         return nil;
     }
+
+    tileGrid = CVSDMTileGridCreate(pBitmapDimensions, CVSDMTileGridDefaultTileSize);
+    if (!tileGrid) {
+        assert(0 && "failed to create tile grid");
+        return nil;
+    }
+    const size_t tileCount = CVSDMTileGridGetTileCount(tileGrid);
+    tileImageStamps = calloc(tileCount, sizeof(uint64_t));
+    tileImageUses = calloc(tileCount, sizeof(uint64_t));
+    if (!tileImageStamps || !tileImageUses) {
+        return nil;
+    }
+    tileImages = [NSMutableArray arrayWithCapacity:tileCount];
+    for (size_t idx = 0; idx < tileCount; ++idx) {
+        [tileImages addObject:[NSNull null]];
+    }
+    _tileImagesLock = [NSLock new];
+    // every tile's stamp must differ from its (absent) image's stamp
+    CVSDMTileGridMarkAll(tileGrid);
     return self;
 }
 
 - (void)dealloc
 {
     CGContextRelease(_bitmapContext), _bitmapContext = NULL;
+    CVSDMTileGridDestroy(tileGrid), tileGrid = NULL;
+    free(tileImageStamps), tileImageStamps = NULL;
+    free(tileImageUses), tileImageUses = NULL;
 }
 
 - (id<CVSDMReadWriteLocking>)readWriteLock
@@ -89,6 +128,7 @@
 {
     CVSDMReadWriteLocking_ReadWriteLockProvider_Write(self, ^{
         CGContextClearRect(self.context, pRect);
+        CVSDMTileGridMarkRect(tileGrid, pRect);
     });
 }
 
@@ -106,16 +146,97 @@
         CGContextSaveGState(context);
         pContextRenderBlock(self.context);
         CGContextRestoreGState(context);
+        CVSDMTileGridMarkAll(tileGrid);
     });
 }
 
+- (void)renderUsingTiledContextRenderBlock:(CVSMutableBitmapTiledCGContextRenderBlock)pContextRenderBlock
+{
+    CVSDMReadWriteLocking_ReadWriteLockProvider_Write(self, ^{
+        CGContextRef context = self.context;
+        assert(context);
+        CGContextSaveGState(context);
+        pContextRenderBlock(self.context, tileGrid);
+        CGContextRestoreGState(context);
+    });
+}
+
+// returns a new image of the tile's pixels. the caller must hold the read lock.
+- (CGImageRef)newImageOfTile:(size_t)pTileIndex
+{
+    CGContextRef gtx = self.context;
+    const CGRect tileRect = CVSDMTileGridGetTileRect(tileGrid, pTileIndex);
+    const size_t width = (size_t)CGRectGetWidth(tileRect);
+    const size_t height = (size_t)CGRectGetHeight(tileRect);
+    const size_t tileBytesPerRow = 4 * width;
+    NSMutableData * const data = [NSMutableData dataWithLength:tileBytesPerRow * height];
+    CVSDMTileGridCopyTilePixels(tileGrid, pTileIndex, self.pixelBuffer.bytes, CGBitmapContextGetBytesPerRow(gtx), data.mutableBytes);
+    CGDataProviderRef provider = CGDataProviderCreateWithCFData((__bridge CFDataRef)data);
+    CGImageRef image = CGImageCreate(width, height, CGBitmapContextGetBitsPerComponent(gtx), CGBitmapContextGetBitsPerPixel(gtx), tileBytesPerRow,
+                                     CGBitmapContextGetColorSpace(gtx), CGBitmapContextGetBitmapInfo(gtx), provider, NULL, false, kCGRenderingIntentDefault);
+    CGDataProviderRelease(provider);
+    return image;
+}
+
+// releases the images of the tiles which were last drawn before the draw @p pUse. the caller must hold the tile images lock.
+- (void)releaseTileImagesDrawnBefore:(uint64_t)pUse
+{
+    const size_t tileCount = CVSDMTileGridGetTileCount(tileGrid);
+    for (size_t idx = 0; idx < tileCount && tileImagesByteCount; ++idx) {
+        if (tileImageUses[idx] < pUse && [NSNull null] != tileImages[idx]) {
+            tileImages[idx] = [NSNull null];
+            // no tile's stamp is 0, so the image is recreated when the tile is drawn
+            tileImageStamps[idx] = 0;
+            tileImagesByteCount -= CVSDMTileGridGetTileByteCount(tileGrid, idx);
+        }
+    }
+}
+
 - (void)drawImageInRect:(CGRect)pRect context:(CGContextRef)pContext
 {
     CVSDMReadWriteLocking_ReadWriteLockProvider_Read(self, ^{
-        CGImageRef image = CGBitmapContextCreateImage(self.context);
-        assert(image);
-        CGContextDrawImage(pContext, pRect, image);
-        CGImageRelease(image);
+        CVSDMLockingBlock_NSLocking(self.tileImagesLock, ^{
+            const CVSDMBitmapDimensions dim = self.bitmapDimensions;
+            const CGFloat scaleX = CGRectGetWidth(pRect) / dim.width;
+            const CGFloat scaleY = CGRectGetHeight(pRect) / dim.height;
+            // the context's clip, in the bitmap's space. tiles outside of it are neither copied nor drawn.
+            const CGRect clip = CGContextGetClipBoundingBox(pContext);
+            const CGRect visible = CGRectMake((CGRectGetMinX(clip) - CGRectGetMinX(pRect)) / scaleX, (CGRectGetMinY(clip) - CGRectGetMinY(pRect)) / scaleY,
+                                              CGRectGetWidth(clip) / scaleX, CGRectGetHeight(clip) / scaleY);
+            const CVSDMTileRange range = CVSDMTileGridGetTileRangeForRect(tileGrid, visible);
+            const uint32_t columnCount = CVSDMTileGridGetColumnCount(tileGrid);
+            const uint64_t use = ++tileImageClock;
+            for (uint32_t row = range.minRow; row < range.maxRow; ++row) {
+                for (uint32_t column = range.minColumn; column < range.maxColumn; ++column) {
+                    const size_t tileIndex = (size_t)row * columnCount + column;
+                    const uint64_t stamp = CVSDMTileGridGetTileModificationStamp(tileGrid, tileIndex);
+                    if (stamp != tileImageStamps[tileIndex]) {
+                        CGImageRef image = [self newImageOfTile:tileIndex];
+                        assert(image);
+                        if (!image) {
+                            continue;
+                        }
+                        if ([NSNull null] == tileImages[tileIndex]) {
+                            tileImagesByteCount += CVSDMTileGridGetTileByteCount(tileGrid, tileIndex);
+                        }
+                        tileImages[tileIndex] = (__bridge_transfer id)image;
+                        tileImageStamps[tileIndex] = stamp;
+                    }
+                    tileImageUses[tileIndex] = use;
+                    const CGRect tileRect = CVSDMTileGridGetTileRect(tileGrid, tileIndex);
+                    const CGRect destination = CGRectMake(CGRectGetMinX(pRect) + CGRectGetMinX(tileRect) * scaleX, CGRectGetMinY(pRect) + CGRectGetMinY(tileRect) * scaleY,
+                                                          CGRectGetWidth(tileRect) * scaleX, CGRectGetHeight(tileRect) * scaleY);
+                    CGContextDrawImage(pContext, destination, (__bridge CGImageRef)tileImages[tileIndex]);
+                }
+            }
+            // keep the images of this draw's tiles if they fit, otherwise none
+            if (TileImagesMemoryBudget < tileImagesByteCount) {
+                [self releaseTileImagesDrawnBefore:use];
+            }
+            if (TileImagesMemoryBudget < tileImagesByteCount) {
+                [self releaseTileImagesDrawnBefore:use + 1];
+            }
+        });
     });
 }
 
@@ -125,6 +246,7 @@
     CVSDMReadWriteLocking_ReadWriteLockProvider_Read(pBitmap, ^{
         CVSDMReadWriteLocking_ReadWriteLockProvider_Write(self, ^{
             [self.pixelBuffer copyMemoryFrom:pBitmap.pixelBuffer];
+            CVSDMTileGridMarkAll(tileGrid);
         });
     });
 }
@@ -148,7 +270,89 @@
     assert(pImmutableDataReference);
     CVSDMReadWriteLocking_ReadWriteLockProvider_Write(self, ^{
         [self.pixelBuffer setMemoryContentsToContentOfImmutableData:pImmutableDataReference];
+        CVSDMTileGridMarkAll(tileGrid);
+    });
+}
+
+- (NSData *)newTilesModifiedSinceStamp:(uint64_t)pStamp outModificationStamp:(uint64_t*)pOutModificationStamp outTileCount:(size_t*)pOutTileCount
+{
+    assert(pOutModificationStamp);
+    assert(pOutTileCount);
+    __block NSMutableData * result = nil;
+    CVSDMReadWriteLocking_ReadWriteLockProvider_Read(self, ^{
+        const size_t tileCount = CVSDMTileGridGetTileCount(tileGrid);
+        size_t length = 0;
+        size_t nTiles = 0;
+        for (size_t idx = 0; idx < tileCount; ++idx) {
+            if (pStamp < CVSDMTileGridGetTileModificationStamp(tileGrid, idx)) {
+                length += sizeof(CVSDMPackedTileHeader) + CVSDMTileGridGetTileByteCount(tileGrid, idx);
+                ++nTiles;
+            }
+        }
+        result = [[NSMutableData alloc] initWithLength:length];
+        if (!result) {
+            assert(0 && "failed to allocate tiles");
+            return;
+        }
+        const size_t bytesPerRow = CGBitmapContextGetBytesPerRow(self.context);
+        char* at = result.mutableBytes;
+        for (size_t idx = 0; idx < tileCount; ++idx) {
+            if (pStamp < CVSDMTileGridGetTileModificationStamp(tileGrid, idx)) {
+                const CVSDMPackedTileHeader header = {(uint32_t)idx, (uint32_t)CVSDMTileGridGetTileByteCount(tileGrid, idx)};
+                memcpy(at, &header, sizeof(header));
+                at += sizeof(header);
+                CVSDMTileGridCopyTilePixels(tileGrid, idx, self.pixelBuffer.bytes, bytesPerRow, at);
+                at += header.byteCount;
+            }
+        }
+        *pOutModificationStamp = CVSDMTileGridGetModificationStamp(tileGrid);
+        *pOutTileCount = nTiles;
+    });
+    return result;
+}
+
+- (size_t)writeTiles:(NSArray *)pPackedTiles skippingTilesNotModifiedSinceStamp:(uint64_t)pStamp
+{
+    assert(pPackedTiles);
+    __block size_t nTilesWritten = 0;
+    CVSDMReadWriteLocking_ReadWriteLockProvider_Write(self, ^{
+        const size_t tileCount = CVSDMTileGridGetTileCount(tileGrid);
+        // non-zero for the tiles which have been written (or need not be)
+        NSMutableData * const visited = [[NSMutableData alloc] initWithLength:tileCount];
+        NSMutableData * const written = [[NSMutableData alloc] initWithLength:tileCount];
+        if (!visited || !written) {
+            assert(0 && "failed to allocate tile flags");
+            return;
+        }
+        uint8_t* const isVisited = visited.mutableBytes;
+        uint8_t* const isWritten = written.mutableBytes;
+        for (size_t idx = 0; idx < tileCount; ++idx) {
+            isVisited[idx] = CVSDMTileGridGetTileModificationStamp(tileGrid, idx) <= pStamp;
+        }
+        const size_t bytesPerRow = CGBitmapContextGetBytesPerRow(self.context);
+        for (NSData * tiles in pPackedTiles) {
+            const char* at = tiles.bytes;
+            const char* const end = at + tiles.length;
+            while (at < end) {
+                CVSDMPackedTileHeader header;
+                memcpy(&header, at, sizeof(header));
+                at += sizeof(header);
+                assert(header.tileIndex < tileCount);
+                assert(header.byteCount == CVSDMTileGridGetTileByteCount(tileGrid, header.tileIndex));
+                if (!isVisited[header.tileIndex]) {
+                    CVSDMTileGridWriteTilePixels(tileGrid, header.tileIndex, at, self.pixelBuffer.mutableBytes, bytesPerRow);
+                    isVisited[header.tileIndex] = 1;
+                    isWritten[header.tileIndex] = 1;
+                    ++nTilesWritten;
+                }
+                at += header.byteCount;
+            }
+        }
+        if (nTilesWritten) {
+            CVSDMTileGridMarkTiles(tileGrid, isWritten);
+        }
     });
+    return nTilesWritten;
 }
 
 @end
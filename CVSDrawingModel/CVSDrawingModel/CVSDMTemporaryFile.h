@@ -35,7 +35,7 @@
 - (NSURL *)URL;
 
 /**
- @return the immutable data reference. the file must be accessible.
+ @return the immutable data reference -- a memory mapping of the file, created on first use and shared by subsequent requests. the file must be accessible.
  */
 - (CVSDMImmutableDataReference *)dataReference;
 
@@ -11,12 +11,14 @@ static const int CVSDMTemporaryFileInvalidFileNo = -1;
 
 @property (atomic, assign, readwrite) bool isFileAccessible;
 @property (atomic, assign, readwrite) bool didExportData;
+@property (atomic, strong, readwrite) CVSDMImmutableDataReference * mappedDataReference;
 @end
 
 @implementation CVSDMTemporaryFile
 
 @synthesize isFileAccessible = _isFileAccessible;
 @synthesize didExportData = _didExportData;
+@synthesize mappedDataReference = _mappedDataReference;
 
 + (NSURL *)createUniqueTemporaryFileWithParentDirectoryURL:(NSURL *)pParentDirectoryURL filePrefix:(NSString *)pFilePrefix
 {
@@ -159,10 +161,16 @@ static const int CVSDMTemporaryFileInvalidFileNo = -1;
         assert(0 && "illegal attempt to access content of temporary file");
         return nil;
     }
+    CVSDMImmutableDataReference * data = self.mappedDataReference;
+    if (data) {
+        return data;
+    }
     NSURL * const url = self.URL;
     assert(url);
-    CVSDMImmutableDataReference * const data = [[CVSDMImmutableDataReference alloc] initWithDataAtURL:self.URL];
+    // the file is written once, so one mapping serves every reader. a race may map the file twice, which is harmless.
+    data = [[CVSDMImmutableDataReference alloc] initWithMappedFileAtURL:url];
     assert(data);
+    self.mappedDataReference = data;
     return data;
 }
 
@@ -0,0 +1,194 @@
+// CVSDMTileGrid.c
+// CVSDrawingModel
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <CoreGraphics/CoreGraphics.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CVSDMBitmapDimensions.h"
+#include "CVSDMTileGrid.h"
+
+struct CVSDMTileGrid {
+    CVSDMBitmapDimensions bitmapDimensions;
+    uint32_t tileSize;
+    uint32_t columnCount;
+    uint32_t rowCount;
+    uint64_t modificationStamp;
+    uint64_t* tileModificationStamps;
+};
+
+CVSDMTileGrid* CVSDMTileGridCreate(const CVSDMBitmapDimensions pBitmapDimensions, const uint32_t pTileSize) {
+    assert(pBitmapDimensions.width && pBitmapDimensions.height);
+    assert(pTileSize);
+    CVSDMTileGrid* const result = calloc(1, sizeof(CVSDMTileGrid));
+    if (!result) {
+        return NULL;
+    }
+    result->bitmapDimensions = pBitmapDimensions;
+    result->tileSize = pTileSize;
+    result->columnCount = (pBitmapDimensions.width + pTileSize - 1) / pTileSize;
+    result->rowCount = (pBitmapDimensions.height + pTileSize - 1) / pTileSize;
+    result->tileModificationStamps = calloc((size_t)result->columnCount * result->rowCount, sizeof(uint64_t));
+    if (!result->tileModificationStamps) {
+        free(result);
+        return NULL;
+    }
+    return result;
+}
+
+void CVSDMTileGridDestroy(CVSDMTileGrid* const pTileGrid) {
+    if (!pTileGrid) {
+        return;
+    }
+    free(pTileGrid->tileModificationStamps);
+    free(pTileGrid);
+}
+
+uint32_t CVSDMTileGridGetTileSize(const CVSDMTileGrid* const pTileGrid) {
+    assert(pTileGrid);
+    return pTileGrid->tileSize;
+}
+
+uint32_t CVSDMTileGridGetColumnCount(const CVSDMTileGrid* const pTileGrid) {
+    assert(pTileGrid);
+    return pTileGrid->columnCount;
+}
+
+uint32_t CVSDMTileGridGetRowCount(const CVSDMTileGrid* const pTileGrid) {
+    assert(pTileGrid);
+    return pTileGrid->rowCount;
+}
+
+size_t CVSDMTileGridGetTileCount(const CVSDMTileGrid* const pTileGrid) {
+    assert(pTileGrid);
+    return (size_t)pTileGrid->columnCount * pTileGrid->rowCount;
+}
+
+CGRect CVSDMTileGridGetTileRect(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex) {
+    assert(pTileGrid);
+    assert(pTileIndex < CVSDMTileGridGetTileCount(pTileGrid));
+    const uint32_t tileSize = pTileGrid->tileSize;
+    const uint32_t x = (uint32_t)(pTileIndex % pTileGrid->columnCount) * tileSize;
+    const uint32_t y = (uint32_t)(pTileIndex / pTileGrid->columnCount) * tileSize;
+    const uint32_t width = (x + tileSize) > pTileGrid->bitmapDimensions.width ? pTileGrid->bitmapDimensions.width - x : tileSize;
+    const uint32_t height = (y + tileSize) > pTileGrid->bitmapDimensions.height ? pTileGrid->bitmapDimensions.height - y : tileSize;
+    return CGRectMake(x, y, width, height);
+}
+
+CVSDMTileRange CVSDMTileGridGetTileRangeForRect(const CVSDMTileGrid* const pTileGrid, const CGRect pRect) {
+    assert(pTileGrid);
+    const CGRect bitmapRect = CGRectMake(0, 0, pTileGrid->bitmapDimensions.width, pTileGrid->bitmapDimensions.height);
+    const CGRect rect = CGRectIntersection(CGRectStandardize(pRect), bitmapRect);
+    if (CGRectIsNull(rect) || CGRectIsEmpty(rect)) {
+        return (CVSDMTileRange){0, 0, 0, 0};
+    }
+    const CGFloat tileSize = pTileGrid->tileSize;
+    CVSDMTileRange result = {
+        (uint32_t)floor(CGRectGetMinX(rect) / tileSize),
+        (uint32_t)floor(CGRectGetMinY(rect) / tileSize),
+        (uint32_t)ceil(CGRectGetMaxX(rect) / tileSize),
+        (uint32_t)ceil(CGRectGetMaxY(rect) / tileSize)
+    };
+    result.maxColumn = result.maxColumn > pTileGrid->columnCount ? pTileGrid->columnCount : result.maxColumn;
+    result.maxRow = result.maxRow > pTileGrid->rowCount ? pTileGrid->rowCount : result.maxRow;
+    return result;
+}
+
+bool CVSDMTileRangeIsEmpty(const CVSDMTileRange pTileRange) {
+    return pTileRange.minColumn >= pTileRange.maxColumn || pTileRange.minRow >= pTileRange.maxRow;
+}
+
+#pragma mark - Tile Pixels
+
+size_t CVSDMTileGridGetTileByteCount(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex) {
+    const CGRect tileRect = CVSDMTileGridGetTileRect(pTileGrid, pTileIndex);
+    return 4 * (size_t)CGRectGetWidth(tileRect) * (size_t)CGRectGetHeight(tileRect);
+}
+
+// the tile's first row in memory, its x offset in bytes, its row size in bytes, and its height
+static void CVSDMTileGridGetTileLayout(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex, size_t* const pOutFirstRow, size_t* const pOutOffset, size_t* const pOutRowByteCount, size_t* const pOutHeight) {
+    const CGRect tileRect = CVSDMTileGridGetTileRect(pTileGrid, pTileIndex);
+    // device space's origin is the bottom left. the first row in memory is the top row.
+    *pOutFirstRow = pTileGrid->bitmapDimensions.height - (size_t)CGRectGetMaxY(tileRect);
+    *pOutOffset = 4 * (size_t)CGRectGetMinX(tileRect);
+    *pOutRowByteCount = 4 * (size_t)CGRectGetWidth(tileRect);
+    *pOutHeight = (size_t)CGRectGetHeight(tileRect);
+}
+
+void CVSDMTileGridCopyTilePixels(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex, const void* const pPixels, const size_t pBytesPerRow, void* const pDestination) {
+    assert(pTileGrid);
+    assert(pPixels);
+    assert(pDestination);
+    size_t firstRow, offset, rowByteCount, height;
+    CVSDMTileGridGetTileLayout(pTileGrid, pTileIndex, &firstRow, &offset, &rowByteCount, &height);
+    const uint8_t* const source = pPixels;
+    uint8_t* const destination = pDestination;
+    for (size_t row = 0; row < height; ++row) {
+        memcpy(&destination[row * rowByteCount], &source[(firstRow + row) * pBytesPerRow + offset], rowByteCount);
+    }
+}
+
+void CVSDMTileGridWriteTilePixels(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex, const void* const pSource, void* const pPixels, const size_t pBytesPerRow) {
+    assert(pTileGrid);
+    assert(pSource);
+    assert(pPixels);
+    size_t firstRow, offset, rowByteCount, height;
+    CVSDMTileGridGetTileLayout(pTileGrid, pTileIndex, &firstRow, &offset, &rowByteCount, &height);
+    const uint8_t* const source = pSource;
+    uint8_t* const destination = pPixels;
+    for (size_t row = 0; row < height; ++row) {
+        memcpy(&destination[(firstRow + row) * pBytesPerRow + offset], &source[row * rowByteCount], rowByteCount);
+    }
+}
+
+#pragma mark - Modifications
+
+uint64_t CVSDMTileGridGetModificationStamp(const CVSDMTileGrid* const pTileGrid) {
+    assert(pTileGrid);
+    return pTileGrid->modificationStamp;
+}
+
+uint64_t CVSDMTileGridGetTileModificationStamp(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex) {
+    assert(pTileGrid);
+    assert(pTileIndex < CVSDMTileGridGetTileCount(pTileGrid));
+    return pTileGrid->tileModificationStamps[pTileIndex];
+}
+
+void CVSDMTileGridMarkRect(CVSDMTileGrid* const pTileGrid, const CGRect pRect) {
+    assert(pTileGrid);
+    const CVSDMTileRange range = CVSDMTileGridGetTileRangeForRect(pTileGrid, pRect);
+    if (CVSDMTileRangeIsEmpty(range)) {
+        return;
+    }
+    const uint64_t stamp = ++pTileGrid->modificationStamp;
+    for (uint32_t row = range.minRow; row < range.maxRow; ++row) {
+        uint64_t* const stamps = &pTileGrid->tileModificationStamps[(size_t)row * pTileGrid->columnCount];
+        for (uint32_t column = range.minColumn; column < range.maxColumn; ++column) {
+            stamps[column] = stamp;
+        }
+    }
+}
+
+void CVSDMTileGridMarkTiles(CVSDMTileGrid* const pTileGrid, const uint8_t* const pTiles) {
+    assert(pTileGrid);
+    assert(pTiles);
+    const uint64_t stamp = ++pTileGrid->modificationStamp;
+    const size_t tileCount = CVSDMTileGridGetTileCount(pTileGrid);
+    for (size_t idx = 0; idx < tileCount; ++idx) {
+        if (pTiles[idx]) {
+            pTileGrid->tileModificationStamps[idx] = stamp;
+        }
+    }
+}
+
+void CVSDMTileGridMarkAll(CVSDMTileGrid* const pTileGrid) {
+    assert(pTileGrid);
+    const uint64_t stamp = ++pTileGrid->modificationStamp;
+    const size_t tileCount = CVSDMTileGridGetTileCount(pTileGrid);
+    for (size_t idx = 0; idx < tileCount; ++idx) {
+        pTileGrid->tileModificationStamps[idx] = stamp;
+    }
+}
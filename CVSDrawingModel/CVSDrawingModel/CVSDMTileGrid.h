@@ -0,0 +1,101 @@
+// CVSDMTileGrid.h
+// CVSDrawingModel
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+/**
+ @brief divides a bitmap into square tiles and records when each tile was last modified.
+ @details rects are in the bitmap context's device space (pixels, origin at the bottom left -- as CG). tiles in the last
+ column and row may be partial. every modification is assigned a new, increasing stamp, so any number of clients (the
+ tile images drawn to the screen, snapshots) may find what changed since they last looked by remembering a stamp.
+ the grid is not thread safe; the owner serializes access (e.g. CVSDMMutableBitmap's read/write lock).
+ */
+typedef struct CVSDMTileGrid CVSDMTileGrid;
+
+/**
+ @brief the default tile size. a multiple of every screen scale, so tiles drawn at point size stay pixel aligned.
+ */
+enum { CVSDMTileGridDefaultTileSize = 128 };
+
+/**
+ @brief an inclusive-exclusive range of tile columns and rows
+ */
+typedef struct {
+    uint32_t minColumn;
+    uint32_t minRow;
+    uint32_t maxColumn;
+    uint32_t maxRow;
+} CVSDMTileRange;
+
+/**
+ @return a new tile grid with no modifications (every tile's stamp is 0), or NULL on failure. destroy it with CVSDMTileGridDestroy.
+ */
+extern CVSDMTileGrid* CVSDMTileGridCreate(const CVSDMBitmapDimensions pBitmapDimensions, const uint32_t pTileSize);
+extern void CVSDMTileGridDestroy(CVSDMTileGrid* const pTileGrid);
+
+extern uint32_t CVSDMTileGridGetTileSize(const CVSDMTileGrid* const pTileGrid);
+extern uint32_t CVSDMTileGridGetColumnCount(const CVSDMTileGrid* const pTileGrid);
+extern uint32_t CVSDMTileGridGetRowCount(const CVSDMTileGrid* const pTileGrid);
+/**
+ @return the number of tiles. tile indices are row * columnCount + column.
+ */
+extern size_t CVSDMTileGridGetTileCount(const CVSDMTileGrid* const pTileGrid);
+
+/**
+ @return the tile's rect, clipped to the bitmap
+ */
+extern CGRect CVSDMTileGridGetTileRect(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex);
+
+/**
+ @return the range of tiles which intersect the rect. the range is empty (min == max) if the rect is outside the bitmap.
+ */
+extern CVSDMTileRange CVSDMTileGridGetTileRangeForRect(const CVSDMTileGrid* const pTileGrid, const CGRect pRect);
+extern bool CVSDMTileRangeIsEmpty(const CVSDMTileRange pTileRange);
+
+#pragma mark - Tile Pixels
+
+/**
+ @return the size of the tile's pixels in bytes (4 bytes per pixel, no row padding)
+ */
+extern size_t CVSDMTileGridGetTileByteCount(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex);
+
+/**
+ @brief copies the tile's pixels from the bitmap @p pPixels (whose first row is the top row) to @p pDestination. the destination's rows are top to bottom, without padding.
+ */
+extern void CVSDMTileGridCopyTilePixels(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex, const void* const pPixels, const size_t pBytesPerRow, void* const pDestination);
+
+/**
+ @brief the inverse of CVSDMTileGridCopyTilePixels -- writes the tile's pixels from @p pSource to the bitmap @p pPixels.
+ */
+extern void CVSDMTileGridWriteTilePixels(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex, const void* const pSource, void* const pPixels, const size_t pBytesPerRow);
+
+/**
+ @brief the header of a tile in a packed tile buffer. the tile's pixels (CVSDMTileGridCopyTilePixels' layout) immediately follow
+ the header, and the next header follows the pixels. tiles are ordered by ascending tile index, and each tile appears once.
+ */
+typedef struct {
+    uint32_t tileIndex;
+    uint32_t byteCount;
+} CVSDMPackedTileHeader;
+
+#pragma mark - Modifications
+
+/**
+ @return the stamp of the most recent modification, or 0 if there have been none
+ */
+extern uint64_t CVSDMTileGridGetModificationStamp(const CVSDMTileGrid* const pTileGrid);
+extern uint64_t CVSDMTileGridGetTileModificationStamp(const CVSDMTileGrid* const pTileGrid, const size_t pTileIndex);
+
+/**
+ @brief marks the tiles which intersect the rect as modified (one new stamp).
+ */
+extern void CVSDMTileGridMarkRect(CVSDMTileGrid* const pTileGrid, const CGRect pRect);
+
+/**
+ @brief marks the tiles whose entries in @p pTiles are non-zero as modified (one new stamp). @p pTiles has one entry per tile.
+ */
+extern void CVSDMTileGridMarkTiles(CVSDMTileGrid* const pTileGrid, const uint8_t* const pTiles);
+
+/**
+ @brief marks every tile as modified (one new stamp)
+ */
+extern void CVSDMTileGridMarkAll(CVSDMTileGrid* const pTileGrid);
@@ -19,6 +19,8 @@
 
 // library
 #import "CVSDMBitmapDimensions.h"
+#import "CVSDMTileGrid.h"
+#import "CVSDMLatencyRecorder.h"
 
 // filesystem/resources
 #import "CVSDMImmutableDataReference.h"
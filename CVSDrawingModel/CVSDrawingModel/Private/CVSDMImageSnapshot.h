@@ -9,37 +9,77 @@
 typedef uint32_t CVSDMImageSnapshotIndex;
 
 /**
- @class defines an image snapshot.
- @details note that this is a temporary V2 compatibility implementation.
+ @class defines an image snapshot -- the tiles of a bitmap (packed, see CVSDMPackedTileHeader) at a stroke count.
+ @details a keyframe holds every tile. a delta holds only the tiles which were modified since its predecessor in the
+ CVSDMImageSnapshotQueue, so a bitmap is restored by applying a delta, then its predecessors back to (and including) the
+ nearest keyframe, each tile taken from the first snapshot which holds it.
+ the tiles are held in memory until the snapshot is moved to disk. snapshots are not thread safe, except where noted;
+ the queue serializes access.
  */
 @interface CVSDMImageSnapshot : NSObject
 
 /**
- @return a new instance which associates the snapshot index with a URL. when self is deallocated, the resource at the URL specified is removed. designated initializer.
+ @return a new in memory snapshot. designated initializer.
+ @p pModificationStamp the source bitmap's modification stamp when the tiles were copied.
+ @p pTiles the packed tiles.
  */
-- (instancetype)initWithFileSystemIOQueue:(CVSDMFileSystemIOQueue *)pFileSystemIOQueue
-                       parentDirectoryURL:(NSURL *)pParentDirectoryURL
-                       imageSnapshotQueue:(CVSDMImageSnapshotQueue *)pImageSnapshotQueue
-                       imageSnapshotIndex:(CVSDMImageSnapshotIndex)pImageSnapshotIndex
-                             dataProvider:(id<CVSDMFileExportDestinationDataProvider>)pDataProvider
-                            exportClosure:(CVSDMFileExportDestinationExportClosure)pExportClosure;
+- (instancetype)initWithImageSnapshotIndex:(CVSDMImageSnapshotIndex)pImageSnapshotIndex
+                         modificationStamp:(uint64_t)pModificationStamp
+                                isKeyframe:(BOOL)pIsKeyframe
+                                     tiles:(NSData *)pTiles;
 
 /**
  @return the image snapshot index self was given at initialization.
  */
 - (CVSDMImageSnapshotIndex)imageSnapshotIndex;
 
-//// I/O ////
+/**
+ @return the source bitmap's modification stamp when the tiles were copied.
+ */
+- (uint64_t)modificationStamp;
+
+/**
+ @return YES if self holds every tile.
+ */
+- (BOOL)isKeyframe;
+
+/**
+ @brief the queue's clock value when self was last created or restored. used to order evictions.
+ */
+@property (nonatomic, assign, readwrite) uint64_t lastUse;
+
+/**
+ @return the size of self's packed tiles.
+ */
+- (size_t)byteCount;
+
+/**
+ @return the number of bytes self holds in memory. thread safe.
+ @details a snapshot which is being moved to disk is counted in memory and on disk until the write completes.
+ */
+- (size_t)memoryByteCount;
+
+/**
+ @return the number of bytes self holds on disk.
+ */
+- (size_t)diskByteCount;
+
+/**
+ @return the packed tiles. the data is memory mapped if self was moved to disk. thread safe.
+ */
+- (NSData *)tiles;
 
 /**
- @return YES if the data reference is accessible. a data reference may not be accessible if it's not yet completed writing.
+ @brief writes self's tiles to a new temporary file in @p pParentDirectoryURL asynchronously. the tiles are released from memory when the write completes.
  */
-- (BOOL)isDataReferenceAccessible;
+- (void)moveToDiskWithFileSystemIOQueue:(CVSDMFileSystemIOQueue *)pFileSystemIOQueue parentDirectoryURL:(NSURL *)pParentDirectoryURL;
 
 /**
- @return a data reference to the previously written file. note that the data reference is held by self by default. you can dispose it using -disposeDataReference.
- @details the data is memory mapped, where possible.
+ @brief merges the tiles of @p pPredecessor into self, as is needed when the predecessor is evicted. tiles which self holds are kept.
+ @details self inherits the predecessor's keyframe status immediately. the tiles are merged asynchronously on @p pFileSystemIOQueue,
+ so the tasks added to the queue afterwards (e.g. restores) see the merged tiles. a keyframe holds every tile, so it is not merged.
+ if self was on disk, the merged tiles are written to a new temporary file in @p pParentDirectoryURL, as -moveToDiskWithFileSystemIOQueue:parentDirectoryURL: does.
  */
-- (CVSDMImmutableDataReference *)dataReference;
+- (void)mergeTilesOfPredecessor:(CVSDMImageSnapshot *)pPredecessor fileSystemIOQueue:(CVSDMFileSystemIOQueue *)pFileSystemIOQueue parentDirectoryURL:(NSURL *)pParentDirectoryURL;
 
 @end
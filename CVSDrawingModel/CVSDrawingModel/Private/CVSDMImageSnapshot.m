@@ -5,25 +5,54 @@
 
 #import "CVSDrawingModel.h"
 #import "CVSDMImageSnapshot.h"
-#import "CVSDMImageSnapshotQueue-Private_CVSDMImageSnapshot.h"
+
+/**
+ @brief provides the tiles captured when a move to disk began, regardless of what the snapshot holds when the write is performed.
+ */
+@interface CVSDMImageSnapshotTilesProvider : NSObject <CVSDMFileExportDestinationDataProvider>
+@property (nonatomic, strong, readwrite) NSData * tiles;
+@end
+
+@implementation CVSDMImageSnapshotTilesProvider
+
+@synthesize tiles = _tiles;
+
+- (void)provideDataToExportDestination:(id<CVSDMFileExportDestination>)pFileExportDestination closure:(CVSDMFileExportDestinationExportClosure)pClosure
+{
+    assert(pFileExportDestination);
+    assert(pClosure);
+    assert(self.tiles);
+    [pFileExportDestination exportDataToDestination:self.tiles closure:pClosure];
+}
+
+@end
 
 @interface CVSDMImageSnapshot ()
 
-@property (nonatomic, strong, readwrite) NSURL * parentDirectoryURL;
+// guards memoryTiles, temporaryFile and moveGeneration -- a move to disk completes on another thread
+@property (nonatomic, strong, readonly) NSLock * lock;
+@property (nonatomic, strong, readwrite) NSData * memoryTiles;
 @property (nonatomic, strong, readwrite) CVSDMTemporaryFile * temporaryFile;
-@property (nonatomic, strong, readwrite) CVSDMImageSnapshotQueue * imageSnapshotQueue;
-@property (nonatomic, assign, readwrite) CVSDMImageSnapshotIndex imageSnapshotIndex;
-@property (nonatomic, strong, readwrite) CVSDMImmutableDataReference * privateDataReference;
+// incremented when the tiles change, so a stale move to disk does not release the current tiles
+@property (nonatomic, assign, readwrite) uint64_t moveGeneration;
+@property (nonatomic, assign, readwrite) BOOL isKeyframe;
+@property (nonatomic, assign, readwrite) size_t byteCount;
 
 @end
 
 @implementation CVSDMImageSnapshot
+{
+    CVSDMImageSnapshotIndex _imageSnapshotIndex;
+    uint64_t _modificationStamp;
+}
 
-@synthesize parentDirectoryURL = _parentDirectoryURL;
+@synthesize lock = _lock;
+@synthesize memoryTiles = _memoryTiles;
 @synthesize temporaryFile = _temporaryFile;
-@synthesize imageSnapshotQueue = _imageSnapshotQueue;
-@synthesize imageSnapshotIndex = _imageSnapshotIndex;
-@synthesize privateDataReference = _privateDataReference;
+@synthesize moveGeneration = _moveGeneration;
+@synthesize isKeyframe = _isKeyframe;
+@synthesize byteCount = _byteCount;
+@synthesize lastUse = _lastUse;
 
 - (id)init
 {
@@ -31,66 +60,186 @@
     return nil;
 }
 
-- (instancetype)initWithFileSystemIOQueue:(CVSDMFileSystemIOQueue *)pFileSystemIOQueue
-                       parentDirectoryURL:(NSURL *)pParentDirectoryURL
-                       imageSnapshotQueue:(CVSDMImageSnapshotQueue *)pImageSnapshotQueue
-                       imageSnapshotIndex:(CVSDMImageSnapshotIndex)pImageSnapshotIndex
-                             dataProvider:(id<CVSDMFileExportDestinationDataProvider>)pDataProvider
-                            exportClosure:(CVSDMFileExportDestinationExportClosure)pExportClosure
+- (instancetype)initWithImageSnapshotIndex:(CVSDMImageSnapshotIndex)pImageSnapshotIndex
+                         modificationStamp:(uint64_t)pModificationStamp
+                                isKeyframe:(BOOL)pIsKeyframe
+                                     tiles:(NSData *)pTiles
 {
     self = [super init];
     if (!self) {
         assert(0 && "init error");
         return nil;
     }
-    _parentDirectoryURL = pParentDirectoryURL.copy;
-    _temporaryFile = [[CVSDMTemporaryFile alloc] initWithFileSystemIOQueue:pFileSystemIOQueue
-                                                        parentDirectoryURL:pParentDirectoryURL
-                                                             removalOption:CVSDMTemporaryResourceRemovalOption_Remove
-                                                              dataProvider:pDataProvider
-                                                             exportClosure:pExportClosure
-                      ];
-    _imageSnapshotQueue = pImageSnapshotQueue;
+    _lock = [NSLock new];
+    _memoryTiles = pTiles;
     _imageSnapshotIndex = pImageSnapshotIndex;
-    if (!_parentDirectoryURL || !_temporaryFile || !_imageSnapshotQueue || !_imageSnapshotIndex) {
+    _modificationStamp = pModificationStamp;
+    _isKeyframe = pIsKeyframe;
+    _byteCount = pTiles.length;
+    if (!_lock || !_memoryTiles || !_imageSnapshotIndex) {
         assert(0 && "invalid parameter");
         return nil;
     }
     return self;
 }
 
-- (void)dealloc
+- (NSString *)debugDescription
 {
-    @autoreleasepool {
-        [self disposeDataReference];
-        self.temporaryFile = nil;
-    }
+    return [NSString stringWithFormat:@"%@ | %i | %s | %zu bytes | %@", [super debugDescription], (int)self.imageSnapshotIndex, self.isKeyframe ? "keyframe" : "delta", self.byteCount, self.temporaryFile];
 }
 
-- (NSString *)debugDescription
+- (CVSDMImageSnapshotIndex)imageSnapshotIndex
 {
-    return [NSString stringWithFormat:@"%@ | %i | %@", [super debugDescription], (int)self.imageSnapshotIndex, self.temporaryFile];
+    return _imageSnapshotIndex;
 }
 
-- (BOOL)isDataReferenceAccessible
+- (uint64_t)modificationStamp
 {
-    return self.temporaryFile.isFileAccessible;
+    return _modificationStamp;
 }
 
-- (CVSDMImmutableDataReference *)dataReference
+- (size_t)memoryByteCount
 {
-    return self.temporaryFile.dataReference;
+    __block size_t result = 0;
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        result = self.memoryTiles.length;
+    });
+    return result;
 }
 
-- (void)disposeDataReference
+- (size_t)diskByteCount
 {
-    if (!self.privateDataReference) {
-        return;
+    __block size_t result = 0;
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        result = self.temporaryFile ? self.byteCount : 0;
+    });
+    return result;
+}
+
+- (NSData *)tiles
+{
+    __block NSData * memoryTiles = nil;
+    __block CVSDMTemporaryFile * temporaryFile = nil;
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        memoryTiles = self.memoryTiles;
+        temporaryFile = self.temporaryFile;
+    });
+    if (memoryTiles) {
+        return memoryTiles;
     }
+    assert(temporaryFile.isFileAccessible);
+    NSData * const result = temporaryFile.dataReference.data;
+    assert(result.length == self.byteCount);
+    return result;
+}
 
-    @autoreleasepool {
-        self.privateDataReference = nil;
+- (void)moveToDiskWithFileSystemIOQueue:(CVSDMFileSystemIOQueue *)pFileSystemIOQueue parentDirectoryURL:(NSURL *)pParentDirectoryURL
+{
+    assert(pFileSystemIOQueue);
+    assert(pParentDirectoryURL);
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        if (self.temporaryFile || !self.memoryTiles) {
+            assert(0 && "the snapshot is already on disk");
+            return;
+        }
+        CVSDMImageSnapshotTilesProvider * const provider = [CVSDMImageSnapshotTilesProvider new];
+        provider.tiles = self.memoryTiles;
+        const uint64_t generation = self.moveGeneration;
+        __weak CVSDMImageSnapshot * weakSelf = self;
+        CVSDMFileExportDestinationExportClosure closure = ^{
+            CVSDMImageSnapshot * const snapshot = weakSelf;
+            if (!snapshot) {
+                return;
+            }
+            CVSDMLockingBlock_NSLocking(snapshot.lock, ^{
+                if (generation == snapshot.moveGeneration) {
+                    snapshot.memoryTiles = nil;
+                }
+            });
+        };
+        self.temporaryFile = [[CVSDMTemporaryFile alloc] initWithFileSystemIOQueue:pFileSystemIOQueue
+                                                                parentDirectoryURL:pParentDirectoryURL
+                                                                     removalOption:CVSDMTemporaryResourceRemovalOption_Remove
+                                                                      dataProvider:provider
+                                                                     exportClosure:closure];
+        assert(self.temporaryFile);
+    });
+}
+
+// returns the tiles of both, ordered by tile index. where both hold a tile, the newer tile is kept.
+static NSData * CVSDMImageSnapshotNewMergedTiles(NSData * const pNewer, NSData * const pOlder)
+{
+    NSMutableData * const merged = [[NSMutableData alloc] initWithCapacity:pNewer.length + pOlder.length];
+    if (!merged) {
+        assert(0 && "failed to allocate merged tiles");
+        return nil;
+    }
+    // both are ordered by tile index, so this is a merge of two sorted sequences. the newer tile wins.
+    const char* a = pNewer.bytes;
+    const char* const aEnd = a + pNewer.length;
+    const char* b = pOlder.bytes;
+    const char* const bEnd = b + pOlder.length;
+    while (a < aEnd || b < bEnd) {
+        CVSDMPackedTileHeader aHeader = {UINT32_MAX, 0};
+        CVSDMPackedTileHeader bHeader = {UINT32_MAX, 0};
+        if (a < aEnd) {
+            memcpy(&aHeader, a, sizeof(aHeader));
+        }
+        if (b < bEnd) {
+            memcpy(&bHeader, b, sizeof(bHeader));
+        }
+        if (aHeader.tileIndex <= bHeader.tileIndex) {
+            const size_t length = sizeof(aHeader) + aHeader.byteCount;
+            [merged appendBytes:a length:length];
+            a += length;
+            if (aHeader.tileIndex == bHeader.tileIndex) {
+                b += sizeof(bHeader) + bHeader.byteCount;
+            }
+        }
+        else {
+            const size_t length = sizeof(bHeader) + bHeader.byteCount;
+            [merged appendBytes:b length:length];
+            b += length;
+        }
+    }
+    return merged;
+}
+
+- (void)mergeTilesOfPredecessor:(CVSDMImageSnapshot *)pPredecessor fileSystemIOQueue:(CVSDMFileSystemIOQueue *)pFileSystemIOQueue parentDirectoryURL:(NSURL *)pParentDirectoryURL
+{
+    assert(pPredecessor);
+    assert(pPredecessor.imageSnapshotIndex < self.imageSnapshotIndex);
+    assert(pFileSystemIOQueue);
+    assert(pParentDirectoryURL);
+    if (self.isKeyframe) {
+        // self holds every tile
+        return;
     }
+    const BOOL isKeyframe = pPredecessor.isKeyframe;
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        self.isKeyframe = isKeyframe;
+    });
+    // reading the tiles of a snapshot on disk pages them in, and writing them back is I/O, so neither is done by the caller
+    [pFileSystemIOQueue dispatch:^{
+        @autoreleasepool {
+            NSData * const merged = CVSDMImageSnapshotNewMergedTiles(self.tiles, pPredecessor.tiles);
+            if (!merged) {
+                return;
+            }
+            __block BOOL wasOnDisk = NO;
+            CVSDMLockingBlock_NSLocking(self.lock, ^{
+                self.memoryTiles = merged;
+                self.byteCount = merged.length;
+                // a move in progress refers to the old tiles
+                self.moveGeneration = self.moveGeneration + 1;
+                wasOnDisk = nil != self.temporaryFile;
+                self.temporaryFile = nil;
+            });
+            if (wasOnDisk) {
+                [self moveToDiskWithFileSystemIOQueue:pFileSystemIOQueue parentDirectoryURL:pParentDirectoryURL];
+            }
+        }
+    }];
 }
 
 @end
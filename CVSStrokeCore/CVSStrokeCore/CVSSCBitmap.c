@@ -0,0 +1,162 @@
+// CVSSCBitmap.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <string.h>
+#include "CVSSCBitmap.h"
+
+CVSSCBitmap CVSSCBitmapMake(uint8_t* const pPixels, const uint32_t pWidth, const uint32_t pHeight, const size_t pBytesPerRow) {
+    assert(pPixels || 0 == pWidth * pHeight);
+    assert(pBytesPerRow >= 4 * (size_t)pWidth);
+    const CVSSCBitmap result = {pPixels, pWidth, pHeight, pBytesPerRow};
+    return result;
+}
+
+CVSSCPixelRect CVSSCBitmapGetPixelRect(const CVSSCBitmap* const pBitmap) {
+    assert(pBitmap);
+    const CVSSCPixelRect result = {0, 0, (int32_t)pBitmap->width, (int32_t)pBitmap->height};
+    return result;
+}
+
+bool CVSSCPixelRectIsEmpty(const CVSSCPixelRect pRect) {
+    return pRect.minX >= pRect.maxX || pRect.minY >= pRect.maxY;
+}
+
+CVSSCPixelRect CVSSCPixelRectIntersection(const CVSSCPixelRect pA, const CVSSCPixelRect pB) {
+    CVSSCPixelRect result = {
+        pA.minX > pB.minX ? pA.minX : pB.minX,
+        pA.minY > pB.minY ? pA.minY : pB.minY,
+        pA.maxX < pB.maxX ? pA.maxX : pB.maxX,
+        pA.maxY < pB.maxY ? pA.maxY : pB.maxY
+    };
+    if (CVSSCPixelRectIsEmpty(result)) {
+        result.maxX = result.minX;
+        result.maxY = result.minY;
+    }
+    return result;
+}
+
+void CVSSCBitmapClear(const CVSSCBitmap* const pBitmap, const CVSSCPixelRect pRect) {
+    assert(pBitmap);
+    const CVSSCPixelRect rect = CVSSCPixelRectIntersection(pRect, CVSSCBitmapGetPixelRect(pBitmap));
+    if (CVSSCPixelRectIsEmpty(rect)) {
+        return;
+    }
+    const size_t rowLength = 4 * (size_t)(rect.maxX - rect.minX);
+    for (int32_t y = rect.minY; y < rect.maxY; ++y) {
+        memset(CVSSCBitmapGetPixel(pBitmap, (uint32_t)rect.minX, (uint32_t)y), 0, rowLength);
+    }
+}
+
+void CVSSCBitmapFill(const CVSSCBitmap* const pBitmap, const CVSSCPixelRect pRect, const CVSSCColor pColor) {
+    assert(pBitmap);
+    const CVSSCPixelRect rect = CVSSCPixelRectIntersection(pRect, CVSSCBitmapGetPixelRect(pBitmap));
+    const double alpha = pColor.alpha < 0.0 ? 0.0 : pColor.alpha > 1.0 ? 1.0 : pColor.alpha;
+    const double components[3] = {pColor.red, pColor.green, pColor.blue};
+    uint8_t pixel[4];
+    for (int channel = 0; channel < 3; ++channel) {
+        const double value = components[channel] < 0.0 ? 0.0 : components[channel] > 1.0 ? 1.0 : components[channel];
+        pixel[channel] = (uint8_t)(value * alpha * 255.0 + 0.5);
+    }
+    pixel[3] = (uint8_t)(alpha * 255.0 + 0.5);
+    for (int32_t y = rect.minY; y < rect.maxY; ++y) {
+        uint8_t* const row = CVSSCBitmapGetPixel(pBitmap, (uint32_t)rect.minX, (uint32_t)y);
+        for (int32_t x = 0; x < rect.maxX - rect.minX; ++x) {
+            memcpy(&row[4 * x], pixel, sizeof(pixel));
+        }
+    }
+}
+
+// composites one premultiplied pixel over another
+static void CompositePixel(uint8_t* const pDestination, const uint8_t* const pSource) {
+    const unsigned inverse = 255U - pSource[3];
+    if (0 == inverse) {
+        memcpy(pDestination, pSource, 4);
+        return;
+    }
+    for (int channel = 0; channel < 4; ++channel) {
+        const unsigned value = pSource[channel] + (pDestination[channel] * inverse + 127U) / 255U;
+        pDestination[channel] = (uint8_t)(value > 255U ? 255U : value);
+    }
+}
+
+void CVSSCBitmapDrawOver(const CVSSCBitmap* const pBitmap, const CVSSCBitmap* const pSource) {
+    assert(pBitmap);
+    assert(pSource);
+    const uint32_t width = pBitmap->width < pSource->width ? pBitmap->width : pSource->width;
+    const uint32_t height = pBitmap->height < pSource->height ? pBitmap->height : pSource->height;
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* const row = CVSSCBitmapGetPixel(pBitmap, 0, y);
+        const uint8_t* const sourceRow = CVSSCBitmapGetPixel(pSource, 0, y);
+        for (uint32_t x = 0; x < width; ++x) {
+            if (sourceRow[4 * x + 3]) {
+                CompositePixel(&row[4 * x], &sourceRow[4 * x]);
+            }
+        }
+    }
+}
+
+void CVSSCBitmapDrawScaledOver(const CVSSCBitmap* const pBitmap, const CVSSCBitmap* const pSource) {
+    assert(pBitmap);
+    assert(pSource);
+    if (0 == pSource->width || 0 == pSource->height) {
+        return;
+    }
+    const double scaleX = (double)pSource->width / pBitmap->width;
+    const double scaleY = (double)pSource->height / pBitmap->height;
+    const bool isReduced = scaleX >= 1.0 && scaleY >= 1.0;
+    for (uint32_t y = 0; y < pBitmap->height; ++y) {
+        uint8_t* const row = CVSSCBitmapGetPixel(pBitmap, 0, y);
+        for (uint32_t x = 0; x < pBitmap->width; ++x) {
+            uint8_t pixel[4];
+            if (isReduced) {
+                // the average of the source pixels the destination pixel covers
+                const uint32_t minX = (uint32_t)(x * scaleX);
+                const uint32_t minY = (uint32_t)(y * scaleY);
+                uint32_t maxX = (uint32_t)((x + 1) * scaleX + 0.999);
+                uint32_t maxY = (uint32_t)((y + 1) * scaleY + 0.999);
+                maxX = maxX > pSource->width ? pSource->width : maxX;
+                maxY = maxY > pSource->height ? pSource->height : maxY;
+                uint32_t sums[4] = {0, 0, 0, 0};
+                for (uint32_t sy = minY; sy < maxY; ++sy) {
+                    const uint8_t* const sourceRow = CVSSCBitmapGetPixel(pSource, 0, sy);
+                    for (uint32_t sx = minX; sx < maxX; ++sx) {
+                        for (int channel = 0; channel < 4; ++channel) {
+                            sums[channel] += sourceRow[4 * sx + channel];
+                        }
+                    }
+                }
+                const uint32_t count = (maxX - minX) * (maxY - minY);
+                for (int channel = 0; channel < 4; ++channel) {
+                    pixel[channel] = (uint8_t)((sums[channel] + count / 2) / count);
+                }
+            }
+            else {
+                // sample at the destination pixel's center
+                double sx = (x + 0.5) * scaleX - 0.5;
+                double sy = (y + 0.5) * scaleY - 0.5;
+                sx = sx < 0.0 ? 0.0 : sx > pSource->width - 1 ? pSource->width - 1 : sx;
+                sy = sy < 0.0 ? 0.0 : sy > pSource->height - 1 ? pSource->height - 1 : sy;
+                const uint32_t x0 = (uint32_t)sx;
+                const uint32_t y0 = (uint32_t)sy;
+                const uint32_t x1 = x0 + 1 < pSource->width ? x0 + 1 : x0;
+                const uint32_t y1 = y0 + 1 < pSource->height ? y0 + 1 : y0;
+                const double fx = sx - x0;
+                const double fy = sy - y0;
+                const uint8_t* const a = CVSSCBitmapGetPixel(pSource, x0, y0);
+                const uint8_t* const b = CVSSCBitmapGetPixel(pSource, x1, y0);
+                const uint8_t* const c = CVSSCBitmapGetPixel(pSource, x0, y1);
+                const uint8_t* const d = CVSSCBitmapGetPixel(pSource, x1, y1);
+                for (int channel = 0; channel < 4; ++channel) {
+                    const double top = a[channel] + (b[channel] - a[channel]) * fx;
+                    const double bottom = c[channel] + (d[channel] - c[channel]) * fx;
+                    pixel[channel] = (uint8_t)(top + (bottom - top) * fy + 0.5);
+                }
+            }
+            if (pixel[3]) {
+                CompositePixel(&row[4 * x], pixel);
+            }
+        }
+    }
+}
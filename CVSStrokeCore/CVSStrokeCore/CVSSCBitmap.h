@@ -0,0 +1,80 @@
+// CVSSCBitmap.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCBitmap_h
+#define CVSStrokeCore_CVSSCBitmap_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CVSSCColor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @brief a view of 8bpc RGBA pixels, premultiplied, alpha last -- the layout of CVSDMMutableBitmap. row 0 is the top row.
+ @details the bitmap does not own its pixels.
+ */
+typedef struct {
+    uint8_t* pixels;
+    uint32_t width;
+    uint32_t height;
+    size_t bytesPerRow;
+} CVSSCBitmap;
+
+/**
+ @brief an integral rect of pixels. max is exclusive.
+ */
+typedef struct {
+    int32_t minX;
+    int32_t minY;
+    int32_t maxX;
+    int32_t maxY;
+} CVSSCPixelRect;
+
+extern CVSSCBitmap CVSSCBitmapMake(uint8_t* const pPixels, const uint32_t pWidth, const uint32_t pHeight, const size_t pBytesPerRow);
+
+/**
+ @return the bitmap's pixel at (x, y)
+ */
+static inline uint8_t* CVSSCBitmapGetPixel(const CVSSCBitmap* const pBitmap, const uint32_t pX, const uint32_t pY) {
+    return pBitmap->pixels + (size_t)pY * pBitmap->bytesPerRow + 4 * (size_t)pX;
+}
+
+/**
+ @return the rect of all of the bitmap's pixels
+ */
+extern CVSSCPixelRect CVSSCBitmapGetPixelRect(const CVSSCBitmap* const pBitmap);
+
+extern bool CVSSCPixelRectIsEmpty(const CVSSCPixelRect pRect);
+extern CVSSCPixelRect CVSSCPixelRectIntersection(const CVSSCPixelRect pA, const CVSSCPixelRect pB);
+
+/**
+ @brief sets every pixel in the rect (clipped to the bitmap) to transparent black.
+ */
+extern void CVSSCBitmapClear(const CVSSCBitmap* const pBitmap, const CVSSCPixelRect pRect);
+
+/**
+ @brief sets every pixel in the rect (clipped to the bitmap) to the color, premultiplied.
+ */
+extern void CVSSCBitmapFill(const CVSSCBitmap* const pBitmap, const CVSSCPixelRect pRect, const CVSSCColor pColor);
+
+/**
+ @brief composites @p pSource over the bitmap (source over), aligned at the top left. pixels outside either bitmap are not drawn.
+ */
+extern void CVSSCBitmapDrawOver(const CVSSCBitmap* const pBitmap, const CVSSCBitmap* const pSource);
+
+/**
+ @brief stretches @p pSource to fill the bitmap and composites it over the bitmap (source over), as the app draws the template image
+ into the canvas. a source which is reduced in both dimensions is box filtered; otherwise it is bilinearly interpolated.
+ */
+extern void CVSSCBitmapDrawScaledOver(const CVSSCBitmap* const pBitmap, const CVSSCBitmap* const pSource);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
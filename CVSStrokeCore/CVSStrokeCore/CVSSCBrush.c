@@ -0,0 +1,86 @@
+// CVSSCBrush.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include "CVSSCBrush.h"
+
+// these values must remain equal to those in CVSDrawingTypes.m
+static const CVSSCBrushAttributes kPenBrushAttributes = {
+    .brushType = CVSSCBrushTypePen,
+    .lineWidth = 2.9,
+    .alpha = 1.0,
+    .lineCap = CVSSCLineCapRound,
+    .clears = false
+};
+
+static const CVSSCBrushAttributes kMarkerBrushAttributes = {
+    .brushType = CVSSCBrushTypeMarker,
+    .lineWidth = 20.0,
+    .alpha = 1.0,
+    .lineCap = CVSSCLineCapRound,
+    .clears = false
+};
+
+static const CVSSCBrushAttributes kPaintbrushBrushAttributes = {
+    .brushType = CVSSCBrushTypePaintbrush,
+    .lineWidth = 20.18,
+    .alpha = 0.38,
+    .lineCap = CVSSCLineCapRound,
+    .clears = false
+};
+
+static const CVSSCBrushAttributes kEraserBrushAttributes = {
+    .brushType = CVSSCBrushTypeEraser,
+    .lineWidth = 15.0,
+    .alpha = 1.0,
+    .lineCap = CVSSCLineCapRound,
+    .clears = true
+};
+
+static const CVSSCBrushAttributes kSpraypaintBrushAttributes = {
+    .brushType = CVSSCBrushTypeSpraypaint,
+    .lineWidth = 32.0,
+    .alpha = 1.0,
+    .lineCap = CVSSCLineCapRound,
+    .clears = false,
+    .stamp = CVSSCBrushStampSpray
+};
+
+static const CVSSCBrushAttributes kCrayonBrushAttributes = {
+    .brushType = CVSSCBrushTypeCrayon,
+    .lineWidth = 8.0,
+    .alpha = 0.9,
+    .lineCap = CVSSCLineCapRound,
+    .clears = false,
+    .stamp = CVSSCBrushStampCrayon
+};
+
+static const CVSSCBrushAttributes kPaintbucketBrushAttributes = {
+    .brushType = CVSSCBrushTypePaintbucket,
+    .lineWidth = 5000.0,
+    .alpha = 0.5,
+    .lineCap = CVSSCLineCapSquare,
+    .clears = false
+};
+
+const CVSSCBrushAttributes* CVSSCBrushAttributesForBrushType(const CVSSCBrushType pBrushType) {
+    switch (pBrushType) {
+        case CVSSCBrushTypePen:
+            return &kPenBrushAttributes;
+        case CVSSCBrushTypeMarker:
+            return &kMarkerBrushAttributes;
+        case CVSSCBrushTypePaintbrush:
+            return &kPaintbrushBrushAttributes;
+        case CVSSCBrushTypeEraser:
+            return &kEraserBrushAttributes;
+        case CVSSCBrushTypeSpraypaint:
+            return &kSpraypaintBrushAttributes;
+        case CVSSCBrushTypeCrayon:
+            return &kCrayonBrushAttributes;
+        case CVSSCBrushTypePaintbucket:
+            return &kPaintbucketBrushAttributes;
+        default:
+            break;
+    }
+    return &kPenBrushAttributes;
+}
@@ -0,0 +1,67 @@
+// CVSSCBrush.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCBrush_h
+#define CVSStrokeCore_CVSSCBrush_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @brief equal to CVSBrushType. THE VALUES OF THESE CANNOT CHANGE.
+ */
+enum {
+    CVSSCBrushTypeUndefined = 0,
+    CVSSCBrushTypePen = 1,
+    CVSSCBrushTypeMarker,
+    CVSSCBrushTypePaintbrush,
+    CVSSCBrushTypeEraser,
+    CVSSCBrushTypeSpraypaint,
+    CVSSCBrushTypeCrayon,
+    CVSSCBrushTypePaintbucket
+};
+typedef uint32_t CVSSCBrushType;
+
+typedef enum {
+    CVSSCLineCapRound = 0,
+    CVSSCLineCapSquare
+} CVSSCLineCap;
+
+/**
+ @brief how a brush lays down paint: by stroking its path, or by stamping dabs along it (see CVSSCStamp.h)
+ */
+typedef enum {
+    CVSSCBrushStampNone = 0,
+    CVSSCBrushStampSpray,
+    CVSSCBrushStampCrayon
+} CVSSCBrushStamp;
+
+/**
+ @brief the portable subset of CVSBrushAttributes. joins are always round.
+ */
+typedef struct {
+    CVSSCBrushType brushType;
+    double lineWidth;
+    double alpha;
+    CVSSCLineCap lineCap;
+    /** @brief true if the brush clears (kCGBlendModeClear) rather than paints */
+    bool clears;
+    /** @brief the stamp of a dab brush. the dabs are within lineWidth of the path, so its bounds are those of a stroked brush. */
+    CVSSCBrushStamp stamp;
+} CVSSCBrushAttributes;
+
+/**
+ @return the attributes of the brush type. like CVSBrushAttributesReferenceForBrushType, unknown types use the pen.
+ */
+extern const CVSSCBrushAttributes* CVSSCBrushAttributesForBrushType(const CVSSCBrushType pBrushType);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
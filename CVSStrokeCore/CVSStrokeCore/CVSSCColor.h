@@ -0,0 +1,26 @@
+// CVSSCColor.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCColor_h
+#define CVSStrokeCore_CVSSCColor_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @brief a device RGB color, components in [0...1], not premultiplied. equal to the values of DQDictionaryFromColor.
+ */
+typedef struct {
+    double red;
+    double green;
+    double blue;
+    double alpha;
+} CVSSCColor;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
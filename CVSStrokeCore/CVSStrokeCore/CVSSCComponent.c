@@ -0,0 +1,162 @@
+// CVSSCComponent.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CVSSCComponent.h"
+
+static const uint32_t CVSSCComponentBlobSignature = 0x43535643; // 'CVSC'
+static const uint16_t CVSSCComponentBlobVersion = 1;
+
+typedef struct {
+    uint32_t signature;
+    uint16_t version;
+    uint16_t recordSize;
+    uint32_t count;
+    uint32_t reserved;
+} CVSSCComponentBlobHeader;
+
+CVSSCComponent CVSSCComponentMakePoint(const CVSSCPoint pFromPoint, const CVSSCPoint pToPoint) {
+    const CVSSCComponent result = {
+        .type = CVSSCComponentTypePoint,
+        .reserved = 0,
+        .fromPoint = pFromPoint,
+        .toPoint = pToPoint,
+        .controlPoint1 = {0, 0},
+        .controlPoint2 = {0, 0}
+    };
+    return result;
+}
+
+CVSSCComponent CVSSCComponentMakeCurve(const CVSSCPoint pFromPoint, const CVSSCPoint pControlPoint1, const CVSSCPoint pControlPoint2, const CVSSCPoint pToPoint) {
+    const CVSSCComponent result = {
+        .type = CVSSCComponentTypeCurve,
+        .reserved = 0,
+        .fromPoint = pFromPoint,
+        .toPoint = pToPoint,
+        .controlPoint1 = pControlPoint1,
+        .controlPoint2 = pControlPoint2
+    };
+    return result;
+}
+
+CVSSCComponent CVSSCComponentMakeFill(const CVSSCPoint pSeedPoint) {
+    const CVSSCComponent result = {
+        .type = CVSSCComponentTypeFill,
+        .reserved = 0,
+        .fromPoint = pSeedPoint,
+        .toPoint = pSeedPoint,
+        .controlPoint1 = {0, 0},
+        .controlPoint2 = {0, 0}
+    };
+    return result;
+}
+
+bool CVSSCComponentsAreFill(const CVSSCComponent* const pComponents, const size_t pCount) {
+    assert(pComponents || 0 == pCount);
+    return 1 == pCount && CVSSCComponentTypeFill == pComponents[0].type;
+}
+
+static bool PointsAreEqual(const CVSSCPoint pA, const CVSSCPoint pB) {
+    return pA.x == pB.x && pA.y == pB.y;
+}
+
+bool CVSSCComponentIsEqual(const CVSSCComponent* const pA, const CVSSCComponent* const pB) {
+    assert(pA);
+    assert(pB);
+    if (pA->type != pB->type || !PointsAreEqual(pA->fromPoint, pB->fromPoint) || !PointsAreEqual(pA->toPoint, pB->toPoint)) {
+        return false;
+    }
+    if (CVSSCComponentTypeCurve == pA->type) {
+        return PointsAreEqual(pA->controlPoint1, pB->controlPoint1) && PointsAreEqual(pA->controlPoint2, pB->controlPoint2);
+    }
+    return true;
+}
+
+#pragma mark - Blob
+
+size_t CVSSCComponentBlobLength(const size_t pCount) {
+    return sizeof(CVSSCComponentBlobHeader) + pCount * sizeof(CVSSCComponent);
+}
+
+void CVSSCComponentBlobWrite(void* const pDestination, const CVSSCComponent* const pComponents, const size_t pCount) {
+    assert(pDestination);
+    assert(pComponents || 0 == pCount);
+    assert(UINT32_MAX > pCount);
+    const CVSSCComponentBlobHeader header = {
+        .signature = CVSSCComponentBlobSignature,
+        .version = CVSSCComponentBlobVersion,
+        .recordSize = (uint16_t)sizeof(CVSSCComponent),
+        .count = (uint32_t)pCount,
+        .reserved = 0
+    };
+    char* const at = pDestination;
+    memcpy(at, &header, sizeof(header));
+    if (pCount) {
+        memcpy(at + sizeof(header), pComponents, pCount * sizeof(CVSSCComponent));
+    }
+}
+
+bool CVSSCComponentBlobRead(const void* const pBlob, const size_t pLength, const CVSSCComponent** const pOutComponents, size_t* const pOutCount) {
+    assert(pOutComponents);
+    assert(pOutCount);
+    *pOutComponents = NULL;
+    *pOutCount = 0;
+    if (NULL == pBlob || 0 == pLength) {
+        return true;
+    }
+    if (sizeof(CVSSCComponentBlobHeader) > pLength) {
+        return false;
+    }
+    CVSSCComponentBlobHeader header;
+    memcpy(&header, pBlob, sizeof(header));
+    if (CVSSCComponentBlobSignature != header.signature || CVSSCComponentBlobVersion != header.version || sizeof(CVSSCComponent) != header.recordSize) {
+        return false;
+    }
+    if (CVSSCComponentBlobLength(header.count) != pLength) {
+        return false;
+    }
+    const char* const records = (const char*)pBlob + sizeof(header);
+    // the records are read in place. malloc'd blobs are sufficiently aligned.
+    assert(0 == ((uintptr_t)records % sizeof(double)) && "misaligned component blob");
+    *pOutComponents = header.count ? (const CVSSCComponent*)records : NULL;
+    *pOutCount = header.count;
+    return true;
+}
+
+#pragma mark - Legacy String Points
+
+static bool IsFPComponent(const char p) {
+    return '-' == p || '.' == p || ('0' <= p && '9' >= p);
+}
+
+bool CVSSCPointParse(const char* const pString, CVSSCPoint* const pOutPoint) {
+    assert(pOutPoint);
+    const CVSSCPoint zero = {0, 0};
+    *pOutPoint = zero;
+    if (NULL == pString) {
+        return false;
+    }
+    const char* at = pString;
+    while (*at && !IsFPComponent(*at)) {
+        ++at;
+    }
+    if (!(*at)) {
+        return false;
+    }
+    char* end = NULL;
+    const double x = strtod(at, &end);
+    at = end;
+    while (*at && !IsFPComponent(*at)) {
+        ++at;
+    }
+    if (!(*at)) {
+        return false;
+    }
+    const double y = strtod(at, NULL);
+    pOutPoint->x = x;
+    pOutPoint->y = y;
+    return true;
+}
@@ -0,0 +1,118 @@
+// CVSSCComponent.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCComponent_h
+#define CVSStrokeCore_CVSSCComponent_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @brief a point. double precision, so that points parsed from the legacy string representation are preserved exactly.
+ */
+typedef struct {
+    double x;
+    double y;
+} CVSSCPoint;
+
+/**
+ @brief the component type. THE VALUES OF THESE CANNOT CHANGE -- they are persisted and are equal to CVSStrokeComponentType.
+ */
+enum {
+    /** @constant a line from fromPoint to toPoint */
+    CVSSCComponentTypePoint = 0,
+    /** @constant a cubic bezier from fromPoint to toPoint */
+    CVSSCComponentTypeCurve = 1,
+    /** @constant a flood fill seeded at fromPoint (the paint bucket). toPoint is equal to fromPoint. it adds nothing to a path.
+        playback JSON represents it as a point marked "fill" (see CVSSCPlaybackJSON.h), not by this value. */
+    CVSSCComponentTypeFill = 2
+};
+typedef uint32_t CVSSCComponentType;
+
+/**
+ @brief a fixed size, plain stroke component. this is the in-memory and the persisted (blob) representation of a component.
+ @details control points are zero for CVSSCComponentTypePoint and CVSSCComponentTypeFill.
+ */
+typedef struct {
+    CVSSCComponentType type;
+    uint32_t reserved;
+    CVSSCPoint fromPoint;
+    CVSSCPoint toPoint;
+    CVSSCPoint controlPoint1;
+    CVSSCPoint controlPoint2;
+} CVSSCComponent;
+
+/**
+ @return a line component
+ */
+extern CVSSCComponent CVSSCComponentMakePoint(const CVSSCPoint pFromPoint, const CVSSCPoint pToPoint);
+
+/**
+ @return a curve component
+ */
+extern CVSSCComponent CVSSCComponentMakeCurve(const CVSSCPoint pFromPoint, const CVSSCPoint pControlPoint1, const CVSSCPoint pControlPoint2, const CVSSCPoint pToPoint);
+
+/**
+ @return a fill component, seeded at @p pSeedPoint
+ */
+extern CVSSCComponent CVSSCComponentMakeFill(const CVSSCPoint pSeedPoint);
+
+/**
+ @return true if the components are a single fill component -- a stroke which is a flood fill, rather than a path
+ */
+extern bool CVSSCComponentsAreFill(const CVSSCComponent* const pComponents, const size_t pCount);
+
+/**
+ @return true if the components are bitwise equal in all of their meaningful fields
+ */
+extern bool CVSSCComponentIsEqual(const CVSSCComponent* const pA, const CVSSCComponent* const pB);
+
+#pragma mark - Blob
+
+/*
+ Blob layout (little endian, which is every target we build for):
+   uint32_t signature  'CVSC'
+   uint16_t version    1
+   uint16_t recordSize sizeof(CVSSCComponent)
+   uint32_t count
+   uint32_t reserved
+   CVSSCComponent records[count]
+ The header is 16 bytes, so the records are 8 byte aligned when the blob is malloc'd.
+ */
+
+/**
+ @return the number of octets required to store @p pCount components as a blob
+ */
+extern size_t CVSSCComponentBlobLength(const size_t pCount);
+
+/**
+ @brief writes the header and the components to @p pDestination, which must be at least CVSSCComponentBlobLength(pCount) octets.
+ */
+extern void CVSSCComponentBlobWrite(void* const pDestination, const CVSSCComponent* const pComponents, const size_t pCount);
+
+/**
+ @brief validates the blob and returns its records without copying.
+ @return false if the blob is malformed. an empty/NULL blob is valid and has 0 components.
+ @details the records point into @p pBlob, so they are only valid as long as the blob.
+ */
+extern bool CVSSCComponentBlobRead(const void* const pBlob, const size_t pLength, const CVSSCComponent** const pOutComponents, size_t* const pOutCount);
+
+#pragma mark - Legacy String Points
+
+/**
+ @brief parses a point in the legacy string format ("{x, y}", as written by NSStringFromCGPoint).
+ @return false if a point could not be read, in which case *pOutPoint is set to {0,0} (which matches the legacy behavior).
+ */
+extern bool CVSSCPointParse(const char* const pString, CVSSCPoint* const pOutPoint);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,300 @@
+// CVSSCFloodFill.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <string.h>
+#include "CVSSCFloodFill.h"
+#include "CVSSCMemory.h"
+#include "CVSSCSpan.h"
+
+const uint8_t CVSSCFloodFillDefaultTolerance = 32;
+
+typedef struct {
+    int32_t x;
+    int32_t y;
+} Seed;
+
+struct CVSSCFloodFiller {
+    // the spans of the last fill
+    CVSSCFillSpan* spans;
+    size_t spanCount;
+    size_t spanCapacity;
+    // the pixels which remain to be extended to spans
+    Seed* seeds;
+    size_t seedCount;
+    size_t seedCapacity;
+    // one bit per pixel of the bitmap, set once the pixel is in a span. all bits are clear between fills.
+    uint8_t* visited;
+    size_t visitedCapacity;
+    // the bitmap and underlay of the fill being found. NULL between fills.
+    const CVSSCBitmap* bitmap;
+    const CVSSCBitmap* underlay;
+    // with an underlay, the bitmap composited over it (width x 4 bytes per row), and one flag per row which is set once the
+    // row has been composited
+    uint8_t* composite;
+    size_t compositeCapacity;
+    uint8_t* compositedRows;
+    size_t compositedRowsCapacity;
+};
+
+#pragma mark - Scratch
+
+static bool Reserve(void** const pMemory, size_t* const pCapacity, const size_t pCount, const size_t pElementSize) {
+    if (pCount <= *pCapacity) {
+        return true;
+    }
+    size_t capacity = *pCapacity ? *pCapacity : 64;
+    while (capacity < pCount) {
+        capacity *= 2;
+    }
+    void* const memory = CVSSCReallocate(*pMemory, capacity * pElementSize);
+    if (!memory) {
+        return false;
+    }
+    *pMemory = memory;
+    *pCapacity = capacity;
+    return true;
+}
+
+CVSSCFloodFiller* CVSSCFloodFillerCreate(void) {
+    CVSSCFloodFiller* const result = CVSSCAllocate(sizeof(CVSSCFloodFiller));
+    if (result) {
+        memset(result, 0, sizeof(CVSSCFloodFiller));
+    }
+    return result;
+}
+
+void CVSSCFloodFillerDestroy(CVSSCFloodFiller* const pFiller) {
+    if (!pFiller) {
+        return;
+    }
+    CVSSCFree(pFiller->spans);
+    CVSSCFree(pFiller->seeds);
+    CVSSCFree(pFiller->visited);
+    CVSSCFree(pFiller->composite);
+    CVSSCFree(pFiller->compositedRows);
+    CVSSCFree(pFiller);
+}
+
+#pragma mark - Visited
+
+static inline bool IsVisited(const uint8_t* const pVisited, const size_t pBit) {
+    return 0 != (pVisited[pBit >> 3] & (1U << (pBit & 7)));
+}
+
+// sets (or clears) pCount bits from pBit
+static void SetVisited(uint8_t* const pVisited, size_t pBit, size_t pCount, const bool pValue) {
+    for (; pCount && (pBit & 7); ++pBit, --pCount) {
+        pVisited[pBit >> 3] = (uint8_t)(pValue ? pVisited[pBit >> 3] | (1U << (pBit & 7)) : pVisited[pBit >> 3] & ~(1U << (pBit & 7)));
+    }
+    if (pCount >= 8) {
+        memset(&pVisited[pBit >> 3], pValue ? 0xFF : 0, pCount >> 3);
+        pBit += pCount & ~(size_t)7;
+        pCount &= 7;
+    }
+    for (; pCount; ++pBit, --pCount) {
+        pVisited[pBit >> 3] = (uint8_t)(pValue ? pVisited[pBit >> 3] | (1U << (pBit & 7)) : pVisited[pBit >> 3] & ~(1U << (pBit & 7)));
+    }
+}
+
+#pragma mark - Underlay
+
+// exact (rounded) x / 255 for x in [0...65535]
+static inline uint32_t Div255(const uint32_t x) {
+    const uint32_t t = x + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+// composites pCount pixels of pSource over pUnderlay (source over, premultiplied) into pResult
+static void CompositeRow(uint8_t* const pResult, const uint8_t* const pSource, const uint8_t* const pUnderlay, const size_t pCount) {
+    for (size_t idx = 0; idx < 4 * pCount; idx += 4) {
+        const uint32_t inverse = 255 - (uint32_t)pSource[idx + 3];
+        pResult[idx + 0] = (uint8_t)(pSource[idx + 0] + Div255((uint32_t)pUnderlay[idx + 0] * inverse));
+        pResult[idx + 1] = (uint8_t)(pSource[idx + 1] + Div255((uint32_t)pUnderlay[idx + 1] * inverse));
+        pResult[idx + 2] = (uint8_t)(pSource[idx + 2] + Div255((uint32_t)pUnderlay[idx + 2] * inverse));
+        pResult[idx + 3] = (uint8_t)(pSource[idx + 3] + Div255((uint32_t)pUnderlay[idx + 3] * inverse));
+    }
+}
+
+// returns the pixel (pX, pY) of the fill's bitmap as it is seen: composited over the underlay, if there is one
+static const uint8_t* GetPixel(CVSSCFloodFiller* const pFiller, const int32_t pX, const int32_t pY) {
+    const CVSSCBitmap* const bitmap = pFiller->bitmap;
+    if (!pFiller->underlay) {
+        return CVSSCBitmapGetPixel(bitmap, (uint32_t)pX, (uint32_t)pY);
+    }
+    uint8_t* const row = pFiller->composite + 4 * (size_t)bitmap->width * (size_t)pY;
+    if (!pFiller->compositedRows[pY]) {
+        CompositeRow(row, CVSSCBitmapGetPixel(bitmap, 0, (uint32_t)pY), CVSSCBitmapGetPixel(pFiller->underlay, 0, (uint32_t)pY), bitmap->width);
+        pFiller->compositedRows[pY] = 1;
+    }
+    return row + 4 * (size_t)pX;
+}
+
+#pragma mark - Finding
+
+static bool PushSeed(CVSSCFloodFiller* const pFiller, const int32_t pX, const int32_t pY) {
+    if (!Reserve((void**)&pFiller->seeds, &pFiller->seedCapacity, pFiller->seedCount + 1, sizeof(Seed))) {
+        return false;
+    }
+    pFiller->seeds[pFiller->seedCount++] = (Seed){pX, pY};
+    return true;
+}
+
+// pushes a seed for each run of matching, unvisited pixels of row pY within [pMinX, pMaxX). a run which is visited is part
+// of a span which was found, all of whose pixels were visited at once.
+static bool PushRowSeeds(CVSSCFloodFiller* const pFiller, const int32_t pY, const int32_t pMinX, const int32_t pMaxX, const uint8_t* const pColor, const uint8_t pTolerance) {
+    const size_t rowBit = (size_t)pY * pFiller->bitmap->width;
+    int32_t x = pMinX;
+    while (x < pMaxX) {
+        const uint8_t* const pixels = GetPixel(pFiller, x, pY);
+        const size_t matching = CVSSCSpanMatchLength(pixels, (size_t)(pMaxX - x), pColor, pTolerance, true);
+        if (matching) {
+            if (!IsVisited(pFiller->visited, rowBit + (size_t)x) && !PushSeed(pFiller, x, pY)) {
+                return false;
+            }
+            x += (int32_t)matching;
+        }
+        else {
+            x += (int32_t)CVSSCSpanMatchLength(pixels, (size_t)(pMaxX - x), pColor, pTolerance, false);
+        }
+    }
+    return true;
+}
+
+bool CVSSCFloodFillerFind(CVSSCFloodFiller* const pFiller, const CVSSCBitmap* const pBitmap, const CVSSCBitmap* const pUnderlay, const int32_t pSeedX, const int32_t pSeedY, const uint8_t pTolerance) {
+    assert(pFiller);
+    assert(pBitmap);
+    assert(!pUnderlay || (pUnderlay->width == pBitmap->width && pUnderlay->height == pBitmap->height));
+    pFiller->spanCount = 0;
+    pFiller->seedCount = 0;
+    if (pSeedX < 0 || pSeedY < 0 || (uint32_t)pSeedX >= pBitmap->width || (uint32_t)pSeedY >= pBitmap->height) {
+        return true;
+    }
+    const size_t bitCount = (size_t)pBitmap->width * pBitmap->height;
+    const size_t previousCapacity = pFiller->visitedCapacity;
+    if (!Reserve((void**)&pFiller->visited, &pFiller->visitedCapacity, (bitCount + 7) >> 3, sizeof(uint8_t))) {
+        return false;
+    }
+    if (previousCapacity != pFiller->visitedCapacity) {
+        memset(pFiller->visited, 0, pFiller->visitedCapacity);
+    }
+    if (pUnderlay) {
+        if (!Reserve((void**)&pFiller->composite, &pFiller->compositeCapacity, 4 * bitCount, sizeof(uint8_t))
+            || !Reserve((void**)&pFiller->compositedRows, &pFiller->compositedRowsCapacity, pBitmap->height, sizeof(uint8_t))) {
+            return false;
+        }
+        memset(pFiller->compositedRows, 0, pBitmap->height);
+    }
+    pFiller->bitmap = pBitmap;
+    pFiller->underlay = pUnderlay;
+
+    uint8_t color[4];
+    memcpy(color, GetPixel(pFiller, pSeedX, pSeedY), sizeof(color));
+    bool succeeded = PushSeed(pFiller, pSeedX, pSeedY);
+    while (succeeded && pFiller->seedCount) {
+        const Seed seed = pFiller->seeds[--pFiller->seedCount];
+        const size_t rowBit = (size_t)seed.y * pBitmap->width;
+        if (IsVisited(pFiller->visited, rowBit + (size_t)seed.x)) {
+            continue;
+        }
+        // seeds match, so the span includes the seed
+        const uint8_t* const pixel = GetPixel(pFiller, seed.x, seed.y);
+        const int32_t minX = seed.x + 1 - (int32_t)CVSSCSpanMatchLengthReverse(pixel, (size_t)seed.x + 1, color, pTolerance, true);
+        const int32_t maxX = seed.x + (int32_t)CVSSCSpanMatchLength(pixel, pBitmap->width - (size_t)seed.x, color, pTolerance, true);
+        assert(minX <= seed.x && seed.x < maxX);
+        if (!Reserve((void**)&pFiller->spans, &pFiller->spanCapacity, pFiller->spanCount + 1, sizeof(CVSSCFillSpan))) {
+            succeeded = false;
+            break;
+        }
+        pFiller->spans[pFiller->spanCount++] = (CVSSCFillSpan){seed.y, minX, maxX};
+        SetVisited(pFiller->visited, rowBit + (size_t)minX, (size_t)(maxX - minX), true);
+        if (0 < seed.y) {
+            succeeded = PushRowSeeds(pFiller, seed.y - 1, minX, maxX, color, pTolerance);
+        }
+        if (succeeded && (uint32_t)seed.y + 1 < pBitmap->height) {
+            succeeded = PushRowSeeds(pFiller, seed.y + 1, minX, maxX, color, pTolerance);
+        }
+    }
+
+    // restore the clear bits for the next fill, which costs the fill's area rather than the bitmap's
+    for (size_t idx = 0; idx < pFiller->spanCount; ++idx) {
+        const CVSSCFillSpan* const at = &pFiller->spans[idx];
+        SetVisited(pFiller->visited, (size_t)at->y * pBitmap->width + (size_t)at->minX, (size_t)(at->maxX - at->minX), false);
+    }
+    if (!succeeded) {
+        pFiller->spanCount = 0;
+        pFiller->seedCount = 0;
+    }
+    pFiller->bitmap = NULL;
+    pFiller->underlay = NULL;
+    return succeeded;
+}
+
+const CVSSCFillSpan* CVSSCFloodFillerGetSpans(const CVSSCFloodFiller* const pFiller, size_t* const pOutCount) {
+    assert(pFiller);
+    assert(pOutCount);
+    *pOutCount = pFiller->spanCount;
+    return pFiller->spans;
+}
+
+#pragma mark - Spans
+
+CVSSCPixelRect CVSSCFillSpansGetBounds(const CVSSCFillSpan* const pSpans, const size_t pCount) {
+    assert(pSpans || 0 == pCount);
+    if (0 == pCount) {
+        return (CVSSCPixelRect){0, 0, 0, 0};
+    }
+    CVSSCPixelRect result = {pSpans[0].minX, pSpans[0].y, pSpans[0].maxX, pSpans[0].y + 1};
+    for (size_t idx = 1; idx < pCount; ++idx) {
+        const CVSSCFillSpan* const at = &pSpans[idx];
+        result.minX = at->minX < result.minX ? at->minX : result.minX;
+        result.maxX = at->maxX > result.maxX ? at->maxX : result.maxX;
+        result.minY = at->y < result.minY ? at->y : result.minY;
+        result.maxY = at->y + 1 > result.maxY ? at->y + 1 : result.maxY;
+    }
+    return result;
+}
+
+static inline uint8_t ColorComponentToByte(const double pValue) {
+    const double clamped = pValue < 0.0 ? 0.0 : (pValue > 1.0 ? 1.0 : pValue);
+    return (uint8_t)(clamped * 255.0 + 0.5);
+}
+
+void CVSSCFillSpansBlend(const CVSSCBitmap* const pBitmap, const CVSSCPixelRect pClip, const CVSSCFillSpan* const pSpans, const size_t pCount, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor) {
+    assert(pBitmap);
+    assert(pBrush);
+    assert(pSpans || 0 == pCount);
+    const CVSSCPixelRect clip = CVSSCPixelRectIntersection(pClip, CVSSCBitmapGetPixelRect(pBitmap));
+    if (CVSSCPixelRectIsEmpty(clip)) {
+        return;
+    }
+    const CVSSCSpanPaint paint = {
+        ColorComponentToByte(pColor.red),
+        ColorComponentToByte(pColor.green),
+        ColorComponentToByte(pColor.blue),
+        ColorComponentToByte(pColor.alpha * pBrush->alpha)
+    };
+    // full coverage, blended in chunks
+    enum { CoverageLength = 256 };
+    uint8_t coverage[CoverageLength];
+    memset(coverage, 255, sizeof(coverage));
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        const CVSSCFillSpan* const at = &pSpans[idx];
+        if (at->y < clip.minY || at->y >= clip.maxY) {
+            continue;
+        }
+        const int32_t minX = at->minX > clip.minX ? at->minX : clip.minX;
+        const int32_t maxX = at->maxX < clip.maxX ? at->maxX : clip.maxX;
+        if (minX >= maxX) {
+            continue;
+        }
+        uint8_t* pixels = CVSSCBitmapGetPixel(pBitmap, (uint32_t)minX, (uint32_t)at->y);
+        for (size_t remaining = (size_t)(maxX - minX); remaining; ) {
+            const size_t count = remaining < CoverageLength ? remaining : CoverageLength;
+            CVSSCSpanBlendNormal(pixels, coverage, count, paint);
+            pixels += 4 * count;
+            remaining -= count;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+// CVSSCFloodFill.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCFloodFill_h
+#define CVSStrokeCore_CVSSCFloodFill_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CVSSCBitmap.h"
+#include "CVSSCBrush.h"
+#include "CVSSCColor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ A scanline flood fill -- the paint bucket.
+
+ The fill is the 4-connected region of pixels around a seed pixel whose colors match the seed's, within a tolerance (see
+ CVSSCSpanMatchLength). It is found a row at a time: a seed is extended left and right to the run of matching pixels
+ (a span), and the runs of unvisited matching pixels above and below the span become seeds. The region is a list of
+ spans, which is blended separately -- so a fill may be found once and blended again, e.g. when its stroke is replayed.
+
+ The pixels below the bitmap (e.g. the quest's template, which is composited under the strokes but is not in their bitmap)
+ may be given as an underlay. The fill then matches the colors which are seen: the bitmap composited over the underlay.
+ */
+
+/**
+ @brief the default tolerance of a fill: pixels within an eighth of the seed's color, which includes most of the
+ antialiased edge of a stroke which bounds the fill.
+ */
+extern const uint8_t CVSSCFloodFillDefaultTolerance;
+
+/**
+ @brief a run of pixels in row y. maxX is exclusive.
+ */
+typedef struct {
+    int32_t y;
+    int32_t minX;
+    int32_t maxX;
+} CVSSCFillSpan;
+
+/**
+ @brief holds the filler's scratch memory and the spans of its last fill, which are reused from fill to fill. not thread safe.
+ */
+typedef struct CVSSCFloodFiller CVSSCFloodFiller;
+
+/**
+ @return a new filler, or NULL if memory could not be allocated. destroy it with CVSSCFloodFillerDestroy.
+ */
+extern CVSSCFloodFiller* CVSSCFloodFillerCreate(void);
+extern void CVSSCFloodFillerDestroy(CVSSCFloodFiller* const pFiller);
+
+/**
+ @brief finds the region of the fill seeded at pixel (@p pSeedX, @p pSeedY). the bitmap is not modified.
+ @param pUnderlay the pixels below the bitmap, the same size as it, or NULL. the rows of the fill are composited (source
+ over) into the filler's scratch memory as they are visited.
+ @return false if scratch memory could not be allocated. a seed outside the bitmap has no spans.
+ */
+extern bool CVSSCFloodFillerFind(CVSSCFloodFiller* const pFiller, const CVSSCBitmap* const pBitmap, const CVSSCBitmap* const pUnderlay, const int32_t pSeedX, const int32_t pSeedY, const uint8_t pTolerance);
+
+/**
+ @return the spans of the last fill, ordered as they were found. they are valid until the filler is used again.
+ */
+extern const CVSSCFillSpan* CVSSCFloodFillerGetSpans(const CVSSCFloodFiller* const pFiller, size_t* const pOutCount);
+
+/**
+ @return the smallest rect which contains the spans. empty if there are no spans.
+ */
+extern CVSSCPixelRect CVSSCFillSpansGetBounds(const CVSSCFillSpan* const pSpans, const size_t pCount);
+
+/**
+ @brief composites the color over the pixels of the spans (source over), within the clip. the paint's alpha is the brush
+ alpha times the color alpha, as the rasterizer's.
+ */
+extern void CVSSCFillSpansBlend(const CVSSCBitmap* const pBitmap, const CVSSCPixelRect pClip, const CVSSCFillSpan* const pSpans, const size_t pCount, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,153 @@
+// CVSSCGeometry.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include "CVSSCGeometry.h"
+
+#pragma mark - Points
+
+double CVSSCPointDistance(const CVSSCPoint pA, const CVSSCPoint pB) {
+    const double dx = pB.x - pA.x;
+    const double dy = pB.y - pA.y;
+    return sqrt(dx * dx + dy * dy);
+}
+
+#pragma mark - Rects
+
+CVSSCRect CVSSCRectNull(void) {
+    const CVSSCRect result = {INFINITY, INFINITY, 0, 0};
+    return result;
+}
+
+bool CVSSCRectIsNull(const CVSSCRect pRect) {
+    return isinf(pRect.x) || isinf(pRect.y);
+}
+
+CVSSCRect CVSSCRectMake(const double pX, const double pY, const double pWidth, const double pHeight) {
+    const CVSSCRect result = {pX, pY, pWidth, pHeight};
+    return result;
+}
+
+CVSSCRect CVSSCRectUnion(const CVSSCRect pA, const CVSSCRect pB) {
+    if (CVSSCRectIsNull(pA)) {
+        return pB;
+    }
+    if (CVSSCRectIsNull(pB)) {
+        return pA;
+    }
+    const double minX = fmin(pA.x, pB.x);
+    const double minY = fmin(pA.y, pB.y);
+    const double maxX = fmax(pA.x + pA.width, pB.x + pB.width);
+    const double maxY = fmax(pA.y + pA.height, pB.y + pB.height);
+    return CVSSCRectMake(minX, minY, maxX - minX, maxY - minY);
+}
+
+CVSSCRect CVSSCRectUnionPoint(const CVSSCRect pRect, const CVSSCPoint pPoint) {
+    return CVSSCRectUnion(pRect, CVSSCRectMake(pPoint.x, pPoint.y, 0, 0));
+}
+
+bool CVSSCRectIntersectsRect(const CVSSCRect pA, const CVSSCRect pB) {
+    if (CVSSCRectIsNull(pA) || CVSSCRectIsNull(pB)) {
+        return false;
+    }
+    return pA.x < pB.x + pB.width && pB.x < pA.x + pA.width && pA.y < pB.y + pB.height && pB.y < pA.y + pA.height;
+}
+
+CVSSCRect CVSSCRectIntegral(const CVSSCRect pRect) {
+    if (CVSSCRectIsNull(pRect)) {
+        return pRect;
+    }
+    const double minX = floor(pRect.x);
+    const double minY = floor(pRect.y);
+    const double maxX = ceil(pRect.x + pRect.width);
+    const double maxY = ceil(pRect.y + pRect.height);
+    return CVSSCRectMake(minX, minY, maxX - minX, maxY - minY);
+}
+
+#pragma mark - Transforms
+
+CVSSCTransform CVSSCTransformIdentity(void) {
+    return CVSSCTransformMake(1.0, 0.0, 0.0, 1.0, 0.0, 0.0);
+}
+
+CVSSCTransform CVSSCTransformMake(const double pA, const double pB, const double pC, const double pD, const double pTX, const double pTY) {
+    const CVSSCTransform result = {pA, pB, pC, pD, pTX, pTY};
+    return result;
+}
+
+CVSSCPoint CVSSCTransformApplyToPoint(const CVSSCTransform* const pTransform, const CVSSCPoint pPoint) {
+    assert(pTransform);
+    const CVSSCPoint result = {
+        pTransform->a * pPoint.x + pTransform->c * pPoint.y + pTransform->tx,
+        pTransform->b * pPoint.x + pTransform->d * pPoint.y + pTransform->ty
+    };
+    return result;
+}
+
+double CVSSCTransformGetScale(const CVSSCTransform* const pTransform) {
+    assert(pTransform);
+    return sqrt(fabs(pTransform->a * pTransform->d - pTransform->b * pTransform->c));
+}
+
+#pragma mark - Components
+
+CVSSCRect CVSSCComponentsGetControlBounds(const CVSSCComponent* const pComponents, const size_t pCount) {
+    assert(pComponents || 0 == pCount);
+    if (0 == pCount) {
+        return CVSSCRectNull();
+    }
+    double minX = pComponents[0].fromPoint.x;
+    double minY = pComponents[0].fromPoint.y;
+    double maxX = minX;
+    double maxY = minY;
+#define CVSSC_ACCUMULATE_POINT(p) do { \
+    minX = fmin(minX, (p).x); maxX = fmax(maxX, (p).x); \
+    minY = fmin(minY, (p).y); maxY = fmax(maxY, (p).y); \
+} while (0)
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        const CVSSCComponent* const at = &pComponents[idx];
+        CVSSC_ACCUMULATE_POINT(at->fromPoint);
+        CVSSC_ACCUMULATE_POINT(at->toPoint);
+        if (CVSSCComponentTypeCurve == at->type) {
+            CVSSC_ACCUMULATE_POINT(at->controlPoint1);
+            CVSSC_ACCUMULATE_POINT(at->controlPoint2);
+        }
+    }
+#undef CVSSC_ACCUMULATE_POINT
+    return CVSSCRectMake(minX, minY, maxX - minX, maxY - minY);
+}
+
+CVSSCRect CVSSCComponentsGetStrokeBounds(const CVSSCComponent* const pComponents, const size_t pCount, const double pLineWidth) {
+    assert(0 < pLineWidth);
+    const CVSSCRect controlBounds = CVSSCComponentsGetControlBounds(pComponents, pCount);
+    if (CVSSCRectIsNull(controlBounds)) {
+        return controlBounds;
+    }
+    const double brushWidthScaling = 0.5 * pLineWidth;
+    const CVSSCRect inflated = CVSSCRectMake(controlBounds.x - brushWidthScaling,
+                                             controlBounds.y - brushWidthScaling,
+                                             controlBounds.width + pLineWidth,
+                                             controlBounds.height + pLineWidth);
+    return CVSSCRectIntegral(inflated);
+}
+
+#pragma mark - Segment Assembly
+
+void CVSSCComponentsAddToPathSink(const CVSSCComponent* const pComponents, const size_t pCount, const CVSSCPathSink* const pSink) {
+    assert(pComponents || 0 == pCount);
+    assert(pSink);
+    void* const context = pSink->context;
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        const CVSSCComponent* const at = &pComponents[idx];
+        if (CVSSCComponentTypeCurve == at->type) {
+            pSink->moveToPoint(context, at->fromPoint);
+            pSink->addCurveToPoint(context, at->controlPoint1, at->controlPoint2, at->toPoint);
+        }
+        else if (CVSSCComponentTypePoint == at->type) {
+            pSink->moveToPoint(context, at->fromPoint);
+            pSink->addLineToPoint(context, at->toPoint);
+        }
+    }
+}
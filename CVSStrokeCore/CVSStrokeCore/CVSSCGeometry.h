@@ -0,0 +1,112 @@
+// CVSSCGeometry.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCGeometry_h
+#define CVSStrokeCore_CVSSCGeometry_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "CVSSCComponent.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#pragma mark - Points
+
+/**
+ @return the distance between the points (equal to CVSLineDistance)
+ */
+extern double CVSSCPointDistance(const CVSSCPoint pA, const CVSSCPoint pB);
+
+#pragma mark - Rects
+
+/**
+ @brief a rect with the same semantics as CGRect (origin is the minimum, size is never negative).
+ */
+typedef struct {
+    double x;
+    double y;
+    double width;
+    double height;
+} CVSSCRect;
+
+/**
+ @return the null rect. the union of the null rect and r is r.
+ */
+extern CVSSCRect CVSSCRectNull(void);
+extern bool CVSSCRectIsNull(const CVSSCRect pRect);
+extern CVSSCRect CVSSCRectMake(const double pX, const double pY, const double pWidth, const double pHeight);
+extern CVSSCRect CVSSCRectUnion(const CVSSCRect pA, const CVSSCRect pB);
+/**
+ @return the rect expanded to include the point
+ */
+extern CVSSCRect CVSSCRectUnionPoint(const CVSSCRect pRect, const CVSSCPoint pPoint);
+/**
+ @return true if the rects overlap (area > 0). a null rect intersects nothing.
+ */
+extern bool CVSSCRectIntersectsRect(const CVSSCRect pA, const CVSSCRect pB);
+/**
+ @return the smallest rect with integral values which contains the rect (equal to CGRectIntegral)
+ */
+extern CVSSCRect CVSSCRectIntegral(const CVSSCRect pRect);
+
+#pragma mark - Transforms
+
+/**
+ @brief an affine transform with the same semantics as CGAffineTransform: x' = a*x + c*y + tx, y' = b*x + d*y + ty
+ */
+typedef struct {
+    double a;
+    double b;
+    double c;
+    double d;
+    double tx;
+    double ty;
+} CVSSCTransform;
+
+extern CVSSCTransform CVSSCTransformIdentity(void);
+extern CVSSCTransform CVSSCTransformMake(const double pA, const double pB, const double pC, const double pD, const double pTX, const double pTY);
+extern CVSSCPoint CVSSCTransformApplyToPoint(const CVSSCTransform* const pTransform, const CVSSCPoint pPoint);
+/**
+ @return the factor by which the transform scales lengths (the square root of the determinant's magnitude). used to scale line widths.
+ */
+extern double CVSSCTransformGetScale(const CVSSCTransform* const pTransform);
+
+#pragma mark - Components
+
+/**
+ @return the bounds of all of the components' points, including control points (equal to CGPathGetBoundingBox).
+ @details returns the null rect if @p pCount is 0.
+ */
+extern CVSSCRect CVSSCComponentsGetControlBounds(const CVSSCComponent* const pComponents, const size_t pCount);
+
+/**
+ @return the smallest integral rect which fits the components as they are rendered with a brush of @p pLineWidth.
+ @details returns the null rect if @p pCount is 0.
+ */
+extern CVSSCRect CVSSCComponentsGetStrokeBounds(const CVSSCComponent* const pComponents, const size_t pCount, const double pLineWidth);
+
+#pragma mark - Segment Assembly
+
+/**
+ @brief receives the path elements of components. used to build a CGPath, a CGContext's path, or a rasterizer's edge list from the same code.
+ */
+typedef struct {
+    void* context;
+    void (*moveToPoint)(void* const pContext, const CVSSCPoint pPoint);
+    void (*addLineToPoint)(void* const pContext, const CVSSCPoint pPoint);
+    void (*addCurveToPoint)(void* const pContext, const CVSSCPoint pControlPoint1, const CVSSCPoint pControlPoint2, const CVSSCPoint pPoint);
+} CVSSCPathSink;
+
+/**
+ @brief emits the path elements of the components to the sink. every component begins a new subpath (a move), which is how strokes have always been built. fill components emit nothing.
+ */
+extern void CVSSCComponentsAddToPathSink(const CVSSCComponent* const pComponents, const size_t pCount, const CVSSCPathSink* const pSink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
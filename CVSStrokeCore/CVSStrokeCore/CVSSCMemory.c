@@ -0,0 +1,45 @@
+// CVSSCMemory.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <stdlib.h>
+#include "CVSSCMemory.h"
+
+static uint64_t CVSSCMemoryAllocations = 0;
+static uint64_t CVSSCMemoryReallocations = 0;
+static uint64_t CVSSCMemoryFrees = 0;
+
+static void Increment(uint64_t* const pCounter) {
+    __atomic_fetch_add(pCounter, 1, __ATOMIC_RELAXED);
+}
+
+static uint64_t Load(uint64_t* const pCounter) {
+    return __atomic_load_n(pCounter, __ATOMIC_RELAXED);
+}
+
+void* CVSSCAllocate(const size_t pSize) {
+    Increment(&CVSSCMemoryAllocations);
+    return malloc(pSize);
+}
+
+void* CVSSCReallocate(void* const pMemory, const size_t pSize) {
+    Increment(&CVSSCMemoryReallocations);
+    return realloc(pMemory, pSize);
+}
+
+void CVSSCFree(void* const pMemory) {
+    if (NULL == pMemory) {
+        return;
+    }
+    Increment(&CVSSCMemoryFrees);
+    free(pMemory);
+}
+
+CVSSCMemoryStatistics CVSSCMemoryGetStatistics(void) {
+    const CVSSCMemoryStatistics result = {
+        .allocations = Load(&CVSSCMemoryAllocations),
+        .reallocations = Load(&CVSSCMemoryReallocations),
+        .frees = Load(&CVSSCMemoryFrees)
+    };
+    return result;
+}
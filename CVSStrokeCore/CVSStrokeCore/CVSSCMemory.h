@@ -0,0 +1,50 @@
+// CVSSCMemory.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCMemory_h
+#define CVSStrokeCore_CVSSCMemory_h
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ All heap memory of the library is requested through these functions so that the allocation behavior of the hot paths
+ may be measured (see CVSSCMemoryGetStatistics). The counters are updated atomically.
+ */
+
+/**
+ @return a new allocation of @p pSize octets, or NULL
+ */
+extern void* CVSSCAllocate(const size_t pSize);
+
+/**
+ @return the reallocated memory, or NULL (in which case @p pMemory remains valid)
+ */
+extern void* CVSSCReallocate(void* const pMemory, const size_t pSize);
+
+/**
+ @brief frees memory returned by CVSSCAllocate or CVSSCReallocate. NULL is ignored.
+ */
+extern void CVSSCFree(void* const pMemory);
+
+typedef struct {
+    uint64_t allocations;
+    uint64_t reallocations;
+    uint64_t frees;
+} CVSSCMemoryStatistics;
+
+/**
+ @return the number of calls made since the process started
+ */
+extern CVSSCMemoryStatistics CVSSCMemoryGetStatistics(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,553 @@
+// CVSSCPNG.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <string.h>
+#include <zlib.h>
+#include "CVSSCPNG.h"
+#include "CVSSCMemory.h"
+
+#pragma mark - Declarations
+
+static const uint8_t Signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+typedef enum {
+    ColorType_Gray = 0,
+    ColorType_RGB = 2,
+    ColorType_Palette = 3,
+    ColorType_GrayAlpha = 4,
+    ColorType_RGBA = 6
+} ColorType;
+
+typedef enum {
+    Filter_None = 0,
+    Filter_Sub,
+    Filter_Up,
+    Filter_Average,
+    Filter_Paeth,
+    Filter_Count
+} Filter;
+
+// the size of the IDAT chunks written, and of the deflate output buffer
+enum { ChunkLength = 32 * 1024 };
+
+static voidpf ZAllocate(voidpf pOpaque, uInt pItems, uInt pSize) {
+    (void)pOpaque;
+    if (pSize && pItems > SIZE_MAX / pSize) {
+        return Z_NULL;
+    }
+    return CVSSCAllocate((size_t)pItems * pSize);
+}
+
+static void ZFree(voidpf pOpaque, voidpf pAddress) {
+    (void)pOpaque;
+    CVSSCFree(pAddress);
+}
+
+static uint32_t ReadUInt32BE(const uint8_t* const pBytes) {
+    return (uint32_t)pBytes[0] << 24 | (uint32_t)pBytes[1] << 16 | (uint32_t)pBytes[2] << 8 | (uint32_t)pBytes[3];
+}
+
+static void WriteUInt32BE(uint8_t* const pBytes, const uint32_t pValue) {
+    pBytes[0] = (uint8_t)(pValue >> 24);
+    pBytes[1] = (uint8_t)(pValue >> 16);
+    pBytes[2] = (uint8_t)(pValue >> 8);
+    pBytes[3] = (uint8_t)pValue;
+}
+
+static uint8_t Paeth(const uint8_t pA, const uint8_t pB, const uint8_t pC) {
+    const int p = (int)pA + (int)pB - (int)pC;
+    const int pa = p > pA ? p - pA : pA - p;
+    const int pb = p > pB ? p - pB : pB - p;
+    const int pc = p > pC ? p - pC : pC - p;
+    if (pa <= pb && pa <= pc) {
+        return pA;
+    }
+    return pb <= pc ? pB : pC;
+}
+
+#pragma mark - Writer
+
+static bool WriteChunk(const CVSSCPlaybackOutput* const pOutput, const char* const pType, const uint8_t* const pData, const uint32_t pLength) {
+    uint8_t header[8];
+    WriteUInt32BE(header, pLength);
+    memcpy(&header[4], pType, 4);
+    uLong crc = crc32(0L, &header[4], 4);
+    if (pLength) {
+        crc = crc32(crc, pData, pLength);
+    }
+    uint8_t trailer[4];
+    WriteUInt32BE(trailer, (uint32_t)crc);
+    return pOutput->write(pOutput->context, header, sizeof(header))
+        && (0 == pLength || pOutput->write(pOutput->context, pData, pLength))
+        && pOutput->write(pOutput->context, trailer, sizeof(trailer));
+}
+
+static bool IsOpaque(const CVSSCBitmap* const pBitmap) {
+    for (uint32_t y = 0; y < pBitmap->height; ++y) {
+        const uint8_t* const row = CVSSCBitmapGetPixel(pBitmap, 0, y);
+        for (uint32_t x = 0; x < pBitmap->width; ++x) {
+            if (255 != row[4 * x + 3]) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// writes the row's samples (unpremultiplied) to pOut
+static void ReadRow(const CVSSCBitmap* const pBitmap, const uint32_t pY, const bool pIsOpaque, uint8_t* const pOut) {
+    const uint8_t* const row = CVSSCBitmapGetPixel(pBitmap, 0, pY);
+    uint8_t* out = pOut;
+    for (uint32_t x = 0; x < pBitmap->width; ++x) {
+        const uint8_t* const pixel = &row[4 * x];
+        const unsigned alpha = pixel[3];
+        if (pIsOpaque) {
+            *out++ = pixel[0];
+            *out++ = pixel[1];
+            *out++ = pixel[2];
+        }
+        else {
+            for (int channel = 0; channel < 3; ++channel) {
+                const unsigned value = alpha ? ((unsigned)pixel[channel] * 255U + alpha / 2U) / alpha : 0U;
+                *out++ = (uint8_t)(value > 255U ? 255U : value);
+            }
+            *out++ = (uint8_t)alpha;
+        }
+    }
+}
+
+// filters the row with pFilter into pOut (filter type octet first). returns the sum of the filtered octets as signed magnitudes.
+static size_t FilterRow(const Filter pFilter, const uint8_t* const pRow, const uint8_t* const pPrevious, const size_t pLength, const size_t pBytesPerPixel, uint8_t* const pOut) {
+    pOut[0] = (uint8_t)pFilter;
+    uint8_t* const out = &pOut[1];
+    size_t sum = 0;
+    for (size_t idx = 0; idx < pLength; ++idx) {
+        const uint8_t a = idx >= pBytesPerPixel ? pRow[idx - pBytesPerPixel] : 0;
+        const uint8_t b = pPrevious[idx];
+        const uint8_t c = idx >= pBytesPerPixel ? pPrevious[idx - pBytesPerPixel] : 0;
+        uint8_t predictor = 0;
+        switch (pFilter) {
+            case Filter_Sub:
+                predictor = a;
+                break;
+            case Filter_Up:
+                predictor = b;
+                break;
+            case Filter_Average:
+                predictor = (uint8_t)(((unsigned)a + (unsigned)b) / 2U);
+                break;
+            case Filter_Paeth:
+                predictor = Paeth(a, b, c);
+                break;
+            default:
+                break;
+        }
+        const uint8_t value = (uint8_t)(pRow[idx] - predictor);
+        out[idx] = value;
+        sum += value < 128 ? value : 256U - value;
+    }
+    return sum;
+}
+
+// deflates the input, writing an IDAT chunk whenever the output buffer fills
+static bool Deflate(z_stream* const pStream, const uint8_t* const pBytes, const size_t pLength, const int pFlush, uint8_t* const pChunk, const CVSSCPlaybackOutput* const pOutput) {
+    pStream->next_in = (Bytef*)pBytes;
+    pStream->avail_in = (uInt)pLength;
+    for (;;) {
+        const int status = deflate(pStream, pFlush);
+        if (Z_STREAM_ERROR == status) {
+            return false;
+        }
+        if (0 == pStream->avail_out || Z_STREAM_END == status) {
+            const uint32_t length = ChunkLength - pStream->avail_out;
+            if (length && !WriteChunk(pOutput, "IDAT", pChunk, length)) {
+                return false;
+            }
+            pStream->next_out = pChunk;
+            pStream->avail_out = ChunkLength;
+        }
+        if (Z_STREAM_END == status) {
+            return true;
+        }
+        if (Z_FINISH != pFlush && 0 == pStream->avail_in && 0 != pStream->avail_out) {
+            return true;
+        }
+    }
+}
+
+bool CVSSCPNGWrite(const CVSSCBitmap* const pBitmap, const int pCompressionLevel, const CVSSCPlaybackOutput* const pOutput) {
+    assert(pBitmap);
+    assert(pOutput && pOutput->write);
+    assert(-1 <= pCompressionLevel && 9 >= pCompressionLevel);
+    if (0 == pBitmap->width || 0 == pBitmap->height) {
+        return false;
+    }
+    const bool isOpaque = IsOpaque(pBitmap);
+    const size_t bytesPerPixel = isOpaque ? 3 : 4;
+    const size_t rowLength = bytesPerPixel * pBitmap->width;
+    // the current and previous rows, the best filtered row, and a candidate, then the deflate output
+    uint8_t* const memory = CVSSCAllocate(4 * (rowLength + 1) + ChunkLength);
+    if (NULL == memory) {
+        return false;
+    }
+    uint8_t* row = memory;
+    uint8_t* previous = row + rowLength + 1;
+    uint8_t* best = previous + rowLength + 1;
+    uint8_t* candidate = best + rowLength + 1;
+    uint8_t* const chunk = candidate + rowLength + 1;
+    memset(previous, 0, rowLength);
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    stream.zalloc = ZAllocate;
+    stream.zfree = ZFree;
+    if (Z_OK != deflateInit(&stream, pCompressionLevel)) {
+        CVSSCFree(memory);
+        return false;
+    }
+    stream.next_out = chunk;
+    stream.avail_out = ChunkLength;
+
+    uint8_t header[13];
+    WriteUInt32BE(&header[0], pBitmap->width);
+    WriteUInt32BE(&header[4], pBitmap->height);
+    header[8] = 8;
+    header[9] = isOpaque ? ColorType_RGB : ColorType_RGBA;
+    header[10] = 0;
+    header[11] = 0;
+    header[12] = 0;
+    bool result = pOutput->write(pOutput->context, Signature, sizeof(Signature)) && WriteChunk(pOutput, "IHDR", header, sizeof(header));
+    for (uint32_t y = 0; result && y < pBitmap->height; ++y) {
+        ReadRow(pBitmap, y, isOpaque, row);
+        // the filter with the least sum of magnitudes usually compresses best
+        size_t bestSum = FilterRow(Filter_None, row, previous, rowLength, bytesPerPixel, best);
+        for (int filter = Filter_Sub; filter < Filter_Count; ++filter) {
+            const size_t sum = FilterRow((Filter)filter, row, previous, rowLength, bytesPerPixel, candidate);
+            if (sum < bestSum) {
+                uint8_t* const swap = best;
+                best = candidate;
+                candidate = swap;
+                bestSum = sum;
+            }
+        }
+        result = Deflate(&stream, best, rowLength + 1, Z_NO_FLUSH, chunk, pOutput);
+        uint8_t* const swap = previous;
+        previous = row;
+        row = swap;
+    }
+    result = result && Deflate(&stream, NULL, 0, Z_FINISH, chunk, pOutput);
+    result = result && WriteChunk(pOutput, "IEND", NULL, 0);
+    deflateEnd(&stream);
+    CVSSCFree(memory);
+    return result;
+}
+
+#pragma mark - Reader
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    uint8_t bitDepth;
+    uint8_t colorType;
+    uint8_t channelCount;
+    size_t bytesPerPixel;
+    size_t rowLength;
+    uint8_t palette[256][4];
+    size_t paletteCount;
+    // the tRNS color key of gray and RGB images, as samples
+    uint32_t key[3];
+    bool hasKey;
+} Image;
+
+static bool ReadHeader(const uint8_t* const pData, const uint32_t pLength, Image* const pImage) {
+    if (13 != pLength) {
+        return false;
+    }
+    pImage->width = ReadUInt32BE(&pData[0]);
+    pImage->height = ReadUInt32BE(&pData[4]);
+    pImage->bitDepth = pData[8];
+    pImage->colorType = pData[9];
+    const bool isSupported = 0 == pData[10] && 0 == pData[11] && 0 == pData[12];
+    if (!isSupported || 0 == pImage->width || 0 == pImage->height || (uint64_t)pImage->width * pImage->height > CVSSCPNGMaxPixelCount) {
+        return false;
+    }
+    const uint8_t depth = pImage->bitDepth;
+    const bool isSubByte = 1 == depth || 2 == depth || 4 == depth;
+    switch (pImage->colorType) {
+        case ColorType_Gray:
+            pImage->channelCount = 1;
+            return isSubByte || 8 == depth || 16 == depth;
+        case ColorType_Palette:
+            pImage->channelCount = 1;
+            return isSubByte || 8 == depth;
+        case ColorType_GrayAlpha:
+            pImage->channelCount = 2;
+            return 8 == depth || 16 == depth;
+        case ColorType_RGB:
+            pImage->channelCount = 3;
+            return 8 == depth || 16 == depth;
+        case ColorType_RGBA:
+            pImage->channelCount = 4;
+            return 8 == depth || 16 == depth;
+        default:
+            return false;
+    }
+}
+
+static bool ReadPalette(const uint8_t* const pData, const uint32_t pLength, Image* const pImage) {
+    if (0 != pLength % 3 || 3 * 256 < pLength) {
+        return false;
+    }
+    if (ColorType_Palette != pImage->colorType) {
+        // a suggested palette
+        return true;
+    }
+    if (0 == pLength) {
+        return false;
+    }
+    pImage->paletteCount = pLength / 3;
+    for (size_t idx = 0; idx < pImage->paletteCount; ++idx) {
+        memcpy(pImage->palette[idx], &pData[3 * idx], 3);
+        pImage->palette[idx][3] = 255;
+    }
+    return true;
+}
+
+static bool ReadTransparency(const uint8_t* const pData, const uint32_t pLength, Image* const pImage) {
+    switch (pImage->colorType) {
+        case ColorType_Palette:
+            if (pLength > pImage->paletteCount) {
+                return false;
+            }
+            for (size_t idx = 0; idx < pLength; ++idx) {
+                pImage->palette[idx][3] = pData[idx];
+            }
+            return true;
+        case ColorType_Gray:
+        case ColorType_RGB:
+            if ((size_t)2 * pImage->channelCount != pLength) {
+                return false;
+            }
+            for (uint8_t channel = 0; channel < pImage->channelCount; ++channel) {
+                pImage->key[channel] = (uint32_t)pData[2 * channel] << 8 | pData[2 * channel + 1];
+            }
+            pImage->hasKey = true;
+            return true;
+        default:
+            // not permitted with an alpha channel
+            return false;
+    }
+}
+
+static void Unfilter(uint8_t* const pRow, const uint8_t* const pPrevious, const uint8_t pFilter, const size_t pLength, const size_t pBytesPerPixel) {
+    for (size_t idx = 0; idx < pLength; ++idx) {
+        const uint8_t a = idx >= pBytesPerPixel ? pRow[idx - pBytesPerPixel] : 0;
+        const uint8_t b = pPrevious ? pPrevious[idx] : 0;
+        const uint8_t c = idx >= pBytesPerPixel && pPrevious ? pPrevious[idx - pBytesPerPixel] : 0;
+        switch (pFilter) {
+            case Filter_Sub:
+                pRow[idx] = (uint8_t)(pRow[idx] + a);
+                break;
+            case Filter_Up:
+                pRow[idx] = (uint8_t)(pRow[idx] + b);
+                break;
+            case Filter_Average:
+                pRow[idx] = (uint8_t)(pRow[idx] + (((unsigned)a + (unsigned)b) / 2U));
+                break;
+            case Filter_Paeth:
+                pRow[idx] = (uint8_t)(pRow[idx] + Paeth(a, b, c));
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static uint32_t GetSample(const uint8_t* const pRow, const size_t pIndex, const uint8_t pBitDepth) {
+    switch (pBitDepth) {
+        case 16:
+            return (uint32_t)pRow[2 * pIndex] << 8 | pRow[2 * pIndex + 1];
+        case 8:
+            return pRow[pIndex];
+        default: {
+            const size_t bit = pIndex * pBitDepth;
+            const unsigned shift = 8U - pBitDepth - (unsigned)(bit % 8);
+            return (uint32_t)(pRow[bit / 8] >> shift) & ((1U << pBitDepth) - 1U);
+        }
+    }
+}
+
+static uint8_t ScaleSample(const uint32_t pSample, const uint8_t pBitDepth) {
+    switch (pBitDepth) {
+        case 16:
+            return (uint8_t)(pSample >> 8);
+        case 8:
+            return (uint8_t)pSample;
+        default:
+            return (uint8_t)(pSample * 255U / ((1U << pBitDepth) - 1U));
+    }
+}
+
+static uint8_t Premultiply(const uint8_t pValue, const uint8_t pAlpha) {
+    return (uint8_t)(((unsigned)pValue * pAlpha + 127U) / 255U);
+}
+
+// converts an unfiltered row to premultiplied RGBA. returns false if a palette index is out of range.
+static bool ConvertRow(const Image* const pImage, const uint8_t* const pRow, uint8_t* const pOut) {
+    const uint8_t depth = pImage->bitDepth;
+    for (uint32_t x = 0; x < pImage->width; ++x) {
+        uint8_t rgba[4] = {0, 0, 0, 255};
+        if (ColorType_Palette == pImage->colorType) {
+            const uint32_t index = GetSample(pRow, x, depth);
+            if (index >= pImage->paletteCount) {
+                return false;
+            }
+            memcpy(rgba, pImage->palette[index], 4);
+        }
+        else {
+            uint32_t samples[4] = {0, 0, 0, 0};
+            for (uint8_t channel = 0; channel < pImage->channelCount; ++channel) {
+                samples[channel] = GetSample(pRow, (size_t)x * pImage->channelCount + channel, depth);
+            }
+            const bool isGray = ColorType_Gray == pImage->colorType || ColorType_GrayAlpha == pImage->colorType;
+            const uint8_t colorCount = isGray ? 1 : 3;
+            for (int channel = 0; channel < 3; ++channel) {
+                rgba[channel] = ScaleSample(samples[isGray ? 0 : channel], depth);
+            }
+            if (colorCount < pImage->channelCount) {
+                rgba[3] = ScaleSample(samples[colorCount], depth);
+            }
+            else if (pImage->hasKey) {
+                bool isKey = true;
+                for (uint8_t channel = 0; channel < colorCount; ++channel) {
+                    isKey = isKey && samples[channel] == pImage->key[channel];
+                }
+                rgba[3] = isKey ? 0 : 255;
+            }
+        }
+        uint8_t* const pixel = &pOut[4 * (size_t)x];
+        for (int channel = 0; channel < 3; ++channel) {
+            pixel[channel] = Premultiply(rgba[channel], rgba[3]);
+        }
+        pixel[3] = rgba[3];
+    }
+    return true;
+}
+
+bool CVSSCPNGRead(const void* const pBytes, const size_t pLength, CVSSCBitmap* const pOutBitmap) {
+    assert(pBytes || !pLength);
+    assert(pOutBitmap);
+    const uint8_t* at = pBytes;
+    const uint8_t* const end = at + pLength;
+    if (pLength < sizeof(Signature) || 0 != memcmp(at, Signature, sizeof(Signature))) {
+        return false;
+    }
+    at += sizeof(Signature);
+
+    Image image;
+    memset(&image, 0, sizeof(image));
+    // the filtered rows, each preceded by its filter type, as inflated from the IDAT chunks
+    uint8_t* filtered = NULL;
+    size_t filteredLength = 0;
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    stream.zalloc = ZAllocate;
+    stream.zfree = ZFree;
+    bool hasStream = false;
+    bool hasHeader = false;
+    bool isStreamEnd = false;
+    bool isEnd = false;
+    bool result = true;
+    while (result && !isEnd) {
+        if (end - at < 12) {
+            result = false;
+            break;
+        }
+        const uint32_t length = ReadUInt32BE(at);
+        const uint8_t* const type = &at[4];
+        const uint8_t* const data = &at[8];
+        if (length > (size_t)(end - data) - 4) {
+            result = false;
+            break;
+        }
+        const uint32_t crc = ReadUInt32BE(&data[length]);
+        result = crc == (uint32_t)crc32(crc32(0L, type, 4), data, length);
+        at = &data[length + 4];
+        if (!result) {
+            break;
+        }
+        if (0 == memcmp(type, "IHDR", 4)) {
+            result = !hasHeader && ReadHeader(data, length, &image);
+            hasHeader = true;
+            if (result) {
+                image.bytesPerPixel = ((size_t)image.channelCount * image.bitDepth + 7) / 8;
+                image.rowLength = ((size_t)image.width * image.channelCount * image.bitDepth + 7) / 8;
+                filteredLength = (image.rowLength + 1) * image.height;
+                filtered = CVSSCAllocate(filteredLength);
+                result = NULL != filtered && Z_OK == inflateInit(&stream);
+                hasStream = result;
+                stream.next_out = filtered;
+                stream.avail_out = (uInt)filteredLength;
+            }
+        }
+        else if (!hasHeader) {
+            result = false;
+        }
+        else if (0 == memcmp(type, "PLTE", 4)) {
+            result = ReadPalette(data, length, &image);
+        }
+        else if (0 == memcmp(type, "tRNS", 4)) {
+            result = ReadTransparency(data, length, &image);
+        }
+        else if (0 == memcmp(type, "IDAT", 4)) {
+            if (isStreamEnd) {
+                // data after the end of the stream is ignored
+                continue;
+            }
+            stream.next_in = (Bytef*)data;
+            stream.avail_in = length;
+            while (result && stream.avail_in && !isStreamEnd) {
+                const int status = inflate(&stream, Z_NO_FLUSH);
+                isStreamEnd = Z_STREAM_END == status;
+                // more data than the image holds is malformed
+                result = Z_OK == status || isStreamEnd;
+            }
+        }
+        else if (0 == memcmp(type, "IEND", 4)) {
+            isEnd = true;
+        }
+        else if (!(type[0] & 0x20)) {
+            // an unknown critical chunk
+            result = false;
+        }
+    }
+    result = result && isStreamEnd && 0 == stream.avail_out;
+    if (hasStream) {
+        inflateEnd(&stream);
+    }
+
+    uint8_t* pixels = NULL;
+    if (result) {
+        pixels = CVSSCAllocate(4 * (size_t)image.width * image.height);
+        result = NULL != pixels;
+    }
+    for (uint32_t y = 0; result && y < image.height; ++y) {
+        uint8_t* const row = &filtered[(image.rowLength + 1) * y];
+        const uint8_t filter = row[0];
+        const uint8_t* const previous = y ? &filtered[(image.rowLength + 1) * (y - 1) + 1] : NULL;
+        result = filter < Filter_Count;
+        if (result) {
+            Unfilter(&row[1], previous, filter, image.rowLength, image.bytesPerPixel);
+            result = ConvertRow(&image, &row[1], &pixels[4 * (size_t)image.width * y]);
+        }
+    }
+    CVSSCFree(filtered);
+    if (!result) {
+        CVSSCFree(pixels);
+        return false;
+    }
+    *pOutBitmap = CVSSCBitmapMake(pixels, image.width, image.height, 4 * (size_t)image.width);
+    return true;
+}
@@ -0,0 +1,46 @@
+// CVSSCPNG.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCPNG_h
+#define CVSStrokeCore_CVSSCPNG_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "CVSSCBitmap.h"
+#include "CVSSCPlaybackJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ A PNG codec for CVSSCBitmap, so that tools may read template images and write renderings without an image library.
+ The deflate layer is zlib's.
+ */
+
+/**
+ @brief the largest image (in pixels) the reader accepts. it bounds the memory a malformed file can request.
+ */
+enum { CVSSCPNGMaxPixelCount = 1 << 27 };
+
+/**
+ @brief writes the bitmap as a non-interlaced 8bpc PNG: RGB when every pixel is opaque, else RGBA (the pixels are unpremultiplied).
+ @param pCompressionLevel the zlib level, 0...9, or -1 for zlib's default.
+ @return false if memory could not be allocated or the output failed.
+ */
+extern bool CVSSCPNGWrite(const CVSSCBitmap* const pBitmap, const int pCompressionLevel, const CVSSCPlaybackOutput* const pOutput);
+
+/**
+ @brief reads a non-interlaced PNG of any color type and bit depth (16 bit samples are truncated to 8).
+ @param pOutBitmap receives the image as premultiplied RGBA (tRNS transparency is applied). its pixels are allocated with
+ CVSSCAllocate; free them with CVSSCFree.
+ @return false if the data is malformed, unsupported, or larger than CVSSCPNGMaxPixelCount, or memory could not be allocated.
+ */
+extern bool CVSSCPNGRead(const void* const pBytes, const size_t pLength, CVSSCBitmap* const pOutBitmap);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,170 @@
+// CVSSCPalette.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <string.h>
+#include "CVSSCPalette.h"
+#include "CVSSCMemory.h"
+
+struct CVSSCPalette {
+    // the colors, in index order
+    CVSSCColor* colors;
+    size_t count;
+    size_t capacity;
+    // an open addressed hash table of the colors' indices. empty slots are CVSSCPaletteIndexNone. the slot count is a power
+    // of two, at least twice the count.
+    CVSSCPaletteIndex* slots;
+    size_t slotCount;
+    // the index found last. consecutive strokes are usually the same color.
+    CVSSCPaletteIndex lastIndex;
+};
+
+enum { MinimumSlotCount = 32 };
+
+CVSSCPalette* CVSSCPaletteCreate(void) {
+    CVSSCPalette* const result = CVSSCAllocate(sizeof(CVSSCPalette));
+    if (result) {
+        memset(result, 0, sizeof(CVSSCPalette));
+        result->lastIndex = CVSSCPaletteIndexNone;
+    }
+    return result;
+}
+
+void CVSSCPaletteDestroy(CVSSCPalette* const pPalette) {
+    if (!pPalette) {
+        return;
+    }
+    CVSSCFree(pPalette->colors);
+    CVSSCFree(pPalette->slots);
+    CVSSCFree(pPalette);
+}
+
+#pragma mark - Hashing
+
+static bool AreColorsIdentical(const CVSSCColor* const pA, const CVSSCColor* const pB) {
+    return 0 == memcmp(pA, pB, sizeof(CVSSCColor));
+}
+
+static size_t Hash(const CVSSCColor* const pColor) {
+    uint64_t words[4];
+    memcpy(words, pColor, sizeof(words));
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (size_t idx = 0; idx < 4; ++idx) {
+        hash = (hash ^ words[idx]) * 0x100000001B3ULL;
+        hash ^= hash >> 29;
+    }
+    return (size_t)(hash ^ (hash >> 32));
+}
+
+// returns the slot of the color, or the empty slot where it belongs
+static size_t FindSlot(const CVSSCPalette* const pPalette, const CVSSCColor* const pColor) {
+    assert(pPalette->slotCount);
+    const size_t mask = pPalette->slotCount - 1;
+    size_t slot = Hash(pColor) & mask;
+    while (CVSSCPaletteIndexNone != pPalette->slots[slot] && !AreColorsIdentical(&pPalette->colors[pPalette->slots[slot]], pColor)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static bool Rehash(CVSSCPalette* const pPalette, const size_t pSlotCount) {
+    CVSSCPaletteIndex* const slots = CVSSCAllocate(pSlotCount * sizeof(CVSSCPaletteIndex));
+    if (!slots) {
+        return false;
+    }
+    // CVSSCPaletteIndexNone is all bits set
+    memset(slots, 0xFF, pSlotCount * sizeof(CVSSCPaletteIndex));
+    CVSSCFree(pPalette->slots);
+    pPalette->slots = slots;
+    pPalette->slotCount = pSlotCount;
+    for (size_t idx = 0; idx < pPalette->count; ++idx) {
+        pPalette->slots[FindSlot(pPalette, &pPalette->colors[idx])] = (CVSSCPaletteIndex)idx;
+    }
+    return true;
+}
+
+#pragma mark - Lookup
+
+bool CVSSCPaletteFind(const CVSSCPalette* const pPalette, const CVSSCColor pColor, CVSSCPaletteIndex* const pOutIndex) {
+    assert(pPalette);
+    assert(pOutIndex);
+    if (!pPalette->count) {
+        return false;
+    }
+    const CVSSCPaletteIndex index = pPalette->slots[FindSlot(pPalette, &pColor)];
+    if (CVSSCPaletteIndexNone == index) {
+        return false;
+    }
+    *pOutIndex = index;
+    return true;
+}
+
+bool CVSSCPaletteFindOrAdd(CVSSCPalette* const pPalette, const CVSSCColor pColor, CVSSCPaletteIndex* const pOutIndex, bool* const pOutAdded) {
+    assert(pPalette);
+    assert(pOutIndex);
+    if (pOutAdded) {
+        *pOutAdded = false;
+    }
+    if (pPalette->lastIndex < pPalette->count && AreColorsIdentical(&pPalette->colors[pPalette->lastIndex], &pColor)) {
+        *pOutIndex = pPalette->lastIndex;
+        return true;
+    }
+    if (CVSSCPaletteFind(pPalette, pColor, pOutIndex)) {
+        pPalette->lastIndex = *pOutIndex;
+        return true;
+    }
+    if (CVSSCPaletteMaxCount == pPalette->count) {
+        return false;
+    }
+    if (pPalette->count == pPalette->capacity) {
+        const size_t capacity = pPalette->capacity ? 2 * pPalette->capacity : 16;
+        CVSSCColor* const colors = CVSSCReallocate(pPalette->colors, capacity * sizeof(CVSSCColor));
+        if (!colors) {
+            return false;
+        }
+        pPalette->colors = colors;
+        pPalette->capacity = capacity;
+    }
+    if (2 * (pPalette->count + 1) > pPalette->slotCount) {
+        const size_t slotCount = pPalette->slotCount ? 2 * pPalette->slotCount : MinimumSlotCount;
+        if (!Rehash(pPalette, slotCount)) {
+            return false;
+        }
+    }
+    const CVSSCPaletteIndex index = (CVSSCPaletteIndex)pPalette->count;
+    pPalette->colors[index] = pColor;
+    pPalette->slots[FindSlot(pPalette, &pColor)] = index;
+    ++pPalette->count;
+    pPalette->lastIndex = index;
+    *pOutIndex = index;
+    if (pOutAdded) {
+        *pOutAdded = true;
+    }
+    return true;
+}
+
+size_t CVSSCPaletteGetCount(const CVSSCPalette* const pPalette) {
+    assert(pPalette);
+    return pPalette->count;
+}
+
+CVSSCColor CVSSCPaletteGetColor(const CVSSCPalette* const pPalette, const CVSSCPaletteIndex pIndex) {
+    assert(pPalette);
+    assert(pIndex < pPalette->count);
+    return pPalette->colors[pIndex];
+}
+
+const CVSSCColor* CVSSCPaletteGetColors(const CVSSCPalette* const pPalette) {
+    assert(pPalette);
+    return pPalette->colors;
+}
+
+void CVSSCPaletteRemoveAll(CVSSCPalette* const pPalette) {
+    assert(pPalette);
+    pPalette->count = 0;
+    pPalette->lastIndex = CVSSCPaletteIndexNone;
+    if (pPalette->slots) {
+        memset(pPalette->slots, 0xFF, pPalette->slotCount * sizeof(CVSSCPaletteIndex));
+    }
+}
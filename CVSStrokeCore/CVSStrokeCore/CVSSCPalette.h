@@ -0,0 +1,82 @@
+// CVSSCPalette.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCPalette_h
+#define CVSStrokeCore_CVSSCPalette_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CVSSCColor.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ A color lookup table: the unique colors of a drawing (or a document), each of which is identified by a small index. A
+ drawing uses a handful of colors, so strokes (and the records of the serialized formats) refer to their colors by index
+ rather than each carrying one.
+
+ Colors are appended, and keep their index until the palette is emptied. Two colors are the same if their components are
+ identical (bit for bit) -- the palette never merges colors which are merely close.
+ */
+
+/**
+ @brief the index of a color in a palette.
+ */
+typedef uint16_t CVSSCPaletteIndex;
+
+/**
+ @brief an index which is not in any palette.
+ */
+enum { CVSSCPaletteIndexNone = UINT16_MAX };
+
+/**
+ @brief the most colors a palette holds (every index but CVSSCPaletteIndexNone).
+ */
+enum { CVSSCPaletteMaxCount = UINT16_MAX };
+
+typedef struct CVSSCPalette CVSSCPalette;
+
+/**
+ @return a new, empty palette, or NULL. destroy using CVSSCPaletteDestroy.
+ */
+extern CVSSCPalette* CVSSCPaletteCreate(void);
+extern void CVSSCPaletteDestroy(CVSSCPalette* const pPalette);
+
+/**
+ @return true if the color is in the palette, in which case @p pOutIndex receives its index.
+ */
+extern bool CVSSCPaletteFind(const CVSSCPalette* const pPalette, const CVSSCColor pColor, CVSSCPaletteIndex* const pOutIndex);
+
+/**
+ @brief finds the color in the palette, appending it if it is not found.
+ @param pOutAdded optional. receives true if the color was appended.
+ @return false if the color was not found and could not be appended (the palette is full, or memory could not be allocated).
+ */
+extern bool CVSSCPaletteFindOrAdd(CVSSCPalette* const pPalette, const CVSSCColor pColor, CVSSCPaletteIndex* const pOutIndex, bool* const pOutAdded);
+
+extern size_t CVSSCPaletteGetCount(const CVSSCPalette* const pPalette);
+
+/**
+ @return the color at @p pIndex, which must be less than the count.
+ */
+extern CVSSCColor CVSSCPaletteGetColor(const CVSSCPalette* const pPalette, const CVSSCPaletteIndex pIndex);
+
+/**
+ @return the colors, in index order. valid until a color is added or the palette is emptied.
+ */
+extern const CVSSCColor* CVSSCPaletteGetColors(const CVSSCPalette* const pPalette);
+
+/**
+ @brief empties the palette. its memory is kept for reuse.
+ */
+extern void CVSSCPaletteRemoveAll(CVSSCPalette* const pPalette);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
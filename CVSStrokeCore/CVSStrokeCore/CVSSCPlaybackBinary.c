@@ -0,0 +1,820 @@
+// CVSSCPlaybackBinary.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include <zlib.h>
+#include "CVSSCPlaybackBinary.h"
+#include "CVSSCMemory.h"
+#include "CVSSCPalette.h"
+
+#pragma mark - Declarations
+
+typedef enum {
+    Opcode_End = 0,
+    Opcode_UsesTemplate = 1,
+    Opcode_Color = 2,
+    Opcode_Stroke = 3
+} Opcode;
+
+enum { HeaderLength = 8 };
+static const uint8_t Signature[4] = {'C', 'V', 'S', 'P'};
+// the size of the chunks passed to the output, and of the reader's inflation steps
+enum { ChunkLength = 16 * 1024 };
+// the longest varint of a uint64_t
+enum { MaxVarintLength = 10 };
+// a record may not be larger than this. it bounds the reader's buffer for malformed input.
+enum { MaxRecordLength = 64 * 1024 * 1024 };
+// quantized coordinates beyond this lose integral precision as doubles
+static const double MaxQuantizedMagnitude = 4503599627370496.0; // 2^52
+
+bool CVSSCPlaybackBinaryHasSignature(const void* const pBytes, const size_t pLength) {
+    assert(pBytes || !pLength);
+    return pLength >= sizeof(Signature) && 0 == memcmp(pBytes, Signature, sizeof(Signature));
+}
+
+CVSSCPlaybackBinaryOptions CVSSCPlaybackBinaryOptionsDefault(void) {
+    const CVSSCPlaybackBinaryOptions result = {CVSSCPlaybackBinaryDefaultCoordinateShift, true};
+    return result;
+}
+
+#pragma mark - zlib
+
+static voidpf ZAllocate(voidpf pOpaque, uInt pItems, uInt pSize) {
+    (void)pOpaque;
+    if (pSize && pItems > SIZE_MAX / pSize) {
+        return Z_NULL;
+    }
+    return CVSSCAllocate((size_t)pItems * pSize);
+}
+
+static void ZFree(voidpf pOpaque, voidpf pAddress) {
+    (void)pOpaque;
+    CVSSCFree(pAddress);
+}
+
+#pragma mark - Encoding
+
+static size_t EncodeVarint(uint8_t* const pOut, uint64_t pValue) {
+    size_t length = 0;
+    while (pValue >= 0x80) {
+        pOut[length++] = (uint8_t)(pValue | 0x80);
+        pValue >>= 7;
+    }
+    pOut[length++] = (uint8_t)pValue;
+    return length;
+}
+
+static uint64_t ZigZagEncode(const int64_t pValue) {
+    return ((uint64_t)pValue << 1) ^ (pValue < 0 ? UINT64_MAX : 0);
+}
+
+static int64_t ZigZagDecode(const uint64_t pValue) {
+    return (int64_t)(pValue >> 1) ^ -(int64_t)(pValue & 1);
+}
+
+// reads a varint from [*pAt, pEnd). returns false if it is incomplete or too long.
+static bool DecodeVarint(const uint8_t** const pAt, const uint8_t* const pEnd, uint64_t* const pOutValue) {
+    uint64_t value = 0;
+    const uint8_t* at = *pAt;
+    for (unsigned shift = 0; at < pEnd && shift < 7 * MaxVarintLength; shift += 7) {
+        const uint8_t octet = *at++;
+        value |= (uint64_t)(octet & 0x7F) << shift;
+        if (!(octet & 0x80)) {
+            *pAt = at;
+            *pOutValue = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint64_t EncodeDouble(const double pValue) {
+    uint64_t result = 0;
+    memcpy(&result, &pValue, sizeof(result));
+    return result;
+}
+
+static double DecodeDouble(const uint64_t pBits) {
+    double result = 0;
+    memcpy(&result, &pBits, sizeof(result));
+    return result;
+}
+
+#pragma mark - Writer
+
+struct CVSSCPlaybackBinaryWriter {
+    CVSSCPlaybackOutput output;
+    CVSSCPlaybackBinaryOptions options;
+    double scale;
+    bool failed;
+    bool finished;
+    z_stream zStream;
+    bool hasZStream;
+    // the color table, as written
+    CVSSCPalette* palette;
+    // the payload of the record being written
+    uint8_t* payload;
+    size_t payloadLength;
+    size_t payloadCapacity;
+    // pending output
+    size_t length;
+    uint8_t buffer[ChunkLength];
+};
+
+static bool WriterFlush(CVSSCPlaybackBinaryWriter* const pWriter) {
+    if (!pWriter->failed && pWriter->length) {
+        pWriter->failed = !pWriter->output.write(pWriter->output.context, pWriter->buffer, pWriter->length);
+    }
+    pWriter->length = 0;
+    return !pWriter->failed;
+}
+
+// appends to the output, uncompressed
+static bool WriterAppendRaw(CVSSCPlaybackBinaryWriter* const pWriter, const uint8_t* pBytes, size_t pLength) {
+    while (pLength) {
+        if (ChunkLength == pWriter->length && !WriterFlush(pWriter)) {
+            return false;
+        }
+        const size_t length = pLength < ChunkLength - pWriter->length ? pLength : ChunkLength - pWriter->length;
+        memcpy(&pWriter->buffer[pWriter->length], pBytes, length);
+        pWriter->length += length;
+        pBytes += length;
+        pLength -= length;
+    }
+    return true;
+}
+
+// runs deflate over the input, passing full chunks to the output
+static bool WriterDeflate(CVSSCPlaybackBinaryWriter* const pWriter, const uint8_t* const pBytes, const size_t pLength, const int pFlush) {
+    z_stream* const stream = &pWriter->zStream;
+    stream->next_in = (Bytef*)pBytes;
+    stream->avail_in = (uInt)pLength;
+    for (;;) {
+        if (ChunkLength == pWriter->length && !WriterFlush(pWriter)) {
+            return false;
+        }
+        stream->next_out = &pWriter->buffer[pWriter->length];
+        stream->avail_out = (uInt)(ChunkLength - pWriter->length);
+        const int status = deflate(stream, pFlush);
+        pWriter->length = ChunkLength - stream->avail_out;
+        if (Z_STREAM_ERROR == status) {
+            pWriter->failed = true;
+            return false;
+        }
+        // finishing continues until the end of the stream. otherwise, until the input is consumed.
+        if (Z_STREAM_END == status || (Z_FINISH != pFlush && 0 == stream->avail_in && 0 != stream->avail_out)) {
+            return true;
+        }
+    }
+}
+
+static bool WriterEmit(CVSSCPlaybackBinaryWriter* const pWriter, const uint8_t* const pBytes, const size_t pLength) {
+    if (pWriter->failed) {
+        return false;
+    }
+    if (pWriter->hasZStream) {
+        assert(pLength <= UINT32_MAX);
+        return WriterDeflate(pWriter, pBytes, pLength, Z_NO_FLUSH);
+    }
+    return WriterAppendRaw(pWriter, pBytes, pLength);
+}
+
+static bool PayloadReserve(CVSSCPlaybackBinaryWriter* const pWriter, const size_t pLength) {
+    if (pWriter->payloadCapacity - pWriter->payloadLength >= pLength) {
+        return true;
+    }
+    size_t capacity = pWriter->payloadCapacity ? pWriter->payloadCapacity : 1024;
+    while (capacity - pWriter->payloadLength < pLength) {
+        capacity *= 2;
+    }
+    uint8_t* const payload = CVSSCReallocate(pWriter->payload, capacity);
+    if (NULL == payload) {
+        return false;
+    }
+    pWriter->payload = payload;
+    pWriter->payloadCapacity = capacity;
+    return true;
+}
+
+// the caller has reserved the space
+static void PayloadAppendVarint(CVSSCPlaybackBinaryWriter* const pWriter, const uint64_t pValue) {
+    assert(pWriter->payloadCapacity - pWriter->payloadLength >= MaxVarintLength);
+    pWriter->payloadLength += EncodeVarint(&pWriter->payload[pWriter->payloadLength], pValue);
+}
+
+static void PayloadAppendUInt64(CVSSCPlaybackBinaryWriter* const pWriter, const uint64_t pValue) {
+    assert(pWriter->payloadCapacity - pWriter->payloadLength >= 8);
+    uint8_t* const at = &pWriter->payload[pWriter->payloadLength];
+    for (size_t idx = 0; idx < 8; ++idx) {
+        at[idx] = (uint8_t)(pValue >> (8 * idx));
+    }
+    pWriter->payloadLength += 8;
+}
+
+static bool WriterEmitRecord(CVSSCPlaybackBinaryWriter* const pWriter, const Opcode pOpcode) {
+    if (pWriter->payloadLength > MaxRecordLength) {
+        pWriter->payloadLength = 0;
+        return false;
+    }
+    uint8_t prefix[2 * MaxVarintLength];
+    size_t length = EncodeVarint(prefix, pOpcode);
+    length += EncodeVarint(&prefix[length], pWriter->payloadLength);
+    const bool result = WriterEmit(pWriter, prefix, length) && WriterEmit(pWriter, pWriter->payload, pWriter->payloadLength);
+    pWriter->payloadLength = 0;
+    return result;
+}
+
+CVSSCPlaybackBinaryWriter* CVSSCPlaybackBinaryWriterCreate(const CVSSCPlaybackOutput* const pOutput, const CVSSCPlaybackBinaryOptions* const pOptions) {
+    assert(pOutput);
+    assert(pOutput->write);
+    assert(pOptions);
+    if (pOptions->coordinateShift > CVSSCPlaybackBinaryMaxCoordinateShift) {
+        assert(0 && "invalid coordinate shift");
+        return NULL;
+    }
+    CVSSCPlaybackBinaryWriter* const writer = CVSSCAllocate(sizeof(CVSSCPlaybackBinaryWriter));
+    if (NULL == writer) {
+        return NULL;
+    }
+    memset(writer, 0, sizeof(*writer) - sizeof(writer->buffer));
+    writer->output = *pOutput;
+    writer->options = *pOptions;
+    writer->scale = ldexp(1.0, pOptions->coordinateShift);
+    writer->palette = CVSSCPaletteCreate();
+    if (NULL == writer->palette) {
+        CVSSCFree(writer);
+        return NULL;
+    }
+    if (pOptions->deflate) {
+        writer->zStream.zalloc = ZAllocate;
+        writer->zStream.zfree = ZFree;
+        if (Z_OK != deflateInit(&writer->zStream, Z_DEFAULT_COMPRESSION)) {
+            CVSSCPaletteDestroy(writer->palette);
+            CVSSCFree(writer);
+            return NULL;
+        }
+        writer->hasZStream = true;
+    }
+    const uint8_t header[HeaderLength] = {
+        Signature[0], Signature[1], Signature[2], Signature[3],
+        CVSSCPlaybackBinaryVersion,
+        pOptions->deflate ? CVSSCPlaybackBinaryFlagDeflated : 0,
+        pOptions->coordinateShift,
+        0
+    };
+    // the header is never compressed
+    WriterAppendRaw(writer, header, sizeof(header));
+    return writer;
+}
+
+void CVSSCPlaybackBinaryWriterDestroy(CVSSCPlaybackBinaryWriter* const pWriter) {
+    if (NULL == pWriter) {
+        return;
+    }
+    if (pWriter->hasZStream) {
+        deflateEnd(&pWriter->zStream);
+    }
+    CVSSCPaletteDestroy(pWriter->palette);
+    CVSSCFree(pWriter->payload);
+    CVSSCFree(pWriter);
+}
+
+bool CVSSCPlaybackBinaryWriterWriteUsesTemplate(CVSSCPlaybackBinaryWriter* const pWriter, const bool pUsesTemplate) {
+    assert(pWriter);
+    assert(!pWriter->finished);
+    if (!PayloadReserve(pWriter, 1)) {
+        return false;
+    }
+    pWriter->payload[pWriter->payloadLength++] = pUsesTemplate ? 1 : 0;
+    return WriterEmitRecord(pWriter, Opcode_UsesTemplate);
+}
+
+// finds the color in the table, writing a Color record if it is new
+static bool WriterColorIndex(CVSSCPlaybackBinaryWriter* const pWriter, const CVSSCColor pColor, CVSSCPaletteIndex* const pOutIndex) {
+    bool added = false;
+    if (!CVSSCPaletteFindOrAdd(pWriter->palette, pColor, pOutIndex, &added)) {
+        return false;
+    }
+    if (!added) {
+        return true;
+    }
+    // the table now has the color, so the document is unusable if its record is not written
+    const uint64_t color[4] = {EncodeDouble(pColor.red), EncodeDouble(pColor.green), EncodeDouble(pColor.blue), EncodeDouble(pColor.alpha)};
+    if (!PayloadReserve(pWriter, sizeof(color))) {
+        pWriter->failed = true;
+        return false;
+    }
+    for (size_t idx = 0; idx < 4; ++idx) {
+        PayloadAppendUInt64(pWriter, color[idx]);
+    }
+    if (!WriterEmitRecord(pWriter, Opcode_Color)) {
+        pWriter->failed = true;
+        return false;
+    }
+    return true;
+}
+
+static bool Quantize(const CVSSCPlaybackBinaryWriter* const pWriter, const CVSSCPoint pPoint, int64_t* const pOutX, int64_t* const pOutY) {
+    const double x = pPoint.x * pWriter->scale;
+    const double y = pPoint.y * pWriter->scale;
+    if (!(fabs(x) < MaxQuantizedMagnitude) || !(fabs(y) < MaxQuantizedMagnitude)) {
+        return false;
+    }
+    *pOutX = (int64_t)llround(x);
+    *pOutY = (int64_t)llround(y);
+    return true;
+}
+
+static bool IsWritableComponent(const CVSSCComponent* const pComponent) {
+    return CVSSCComponentTypePoint == pComponent->type || CVSSCComponentTypeCurve == pComponent->type || CVSSCComponentTypeFill == pComponent->type;
+}
+
+// true if the point at pPointIdx (fromPoint, controlPoint1, controlPoint2, toPoint) of a component of the type is stored
+static bool IsStoredPoint(const uint64_t pType, const size_t pPointIdx) {
+    switch (pType) {
+        case CVSSCComponentTypeCurve:
+            return true;
+        case CVSSCComponentTypeFill:
+            return 0 == pPointIdx;
+        default:
+            return 0 == pPointIdx || 3 == pPointIdx;
+    }
+}
+
+bool CVSSCPlaybackBinaryWriterWriteStroke(CVSSCPlaybackBinaryWriter* const pWriter, const CVSSCPlaybackStroke* const pStroke) {
+    assert(pWriter);
+    assert(pStroke);
+    assert(pStroke->components || !pStroke->componentCount);
+    assert(!pWriter->finished);
+    CVSSCPaletteIndex colorIndex = 0;
+    if (pWriter->failed || !WriterColorIndex(pWriter, pStroke->color, &colorIndex)) {
+        return false;
+    }
+    size_t componentCount = 0;
+    for (size_t idx = 0; idx < pStroke->componentCount; ++idx) {
+        componentCount += IsWritableComponent(&pStroke->components[idx]) ? 1 : 0;
+    }
+    if (!PayloadReserve(pWriter, 3 * MaxVarintLength)) {
+        return false;
+    }
+    PayloadAppendVarint(pWriter, pStroke->brushType);
+    PayloadAppendVarint(pWriter, colorIndex);
+    PayloadAppendVarint(pWriter, componentCount);
+    int64_t cursor[2] = {0, 0};
+    for (size_t idx = 0; idx < pStroke->componentCount; ++idx) {
+        const CVSSCComponent* const component = &pStroke->components[idx];
+        if (!IsWritableComponent(component)) {
+            continue;
+        }
+        // fromPoint, controlPoint1, controlPoint2, toPoint
+        const CVSSCPoint points[4] = {component->fromPoint, component->controlPoint1, component->controlPoint2, component->toPoint};
+        int64_t quantized[4][2];
+        for (size_t pointIdx = 0; pointIdx < 4; ++pointIdx) {
+            if (IsStoredPoint(component->type, pointIdx) && !Quantize(pWriter, points[pointIdx], &quantized[pointIdx][0], &quantized[pointIdx][1])) {
+                pWriter->payloadLength = 0;
+                return false;
+            }
+        }
+        const bool continues = quantized[0][0] == cursor[0] && quantized[0][1] == cursor[1];
+        if (!PayloadReserve(pWriter, 9 * MaxVarintLength)) {
+            pWriter->payloadLength = 0;
+            return false;
+        }
+        PayloadAppendVarint(pWriter, (uint64_t)component->type << 1 | (continues ? 1 : 0));
+        for (size_t pointIdx = continues ? 1 : 0; pointIdx < 4; ++pointIdx) {
+            if (!IsStoredPoint(component->type, pointIdx)) {
+                continue;
+            }
+            PayloadAppendVarint(pWriter, ZigZagEncode(quantized[pointIdx][0] - cursor[0]));
+            PayloadAppendVarint(pWriter, ZigZagEncode(quantized[pointIdx][1] - cursor[1]));
+            cursor[0] = quantized[pointIdx][0];
+            cursor[1] = quantized[pointIdx][1];
+        }
+    }
+    return WriterEmitRecord(pWriter, Opcode_Stroke);
+}
+
+bool CVSSCPlaybackBinaryWriterFinish(CVSSCPlaybackBinaryWriter* const pWriter) {
+    assert(pWriter);
+    assert(!pWriter->finished);
+    pWriter->finished = true;
+    assert(0 == pWriter->payloadLength);
+    if (!WriterEmitRecord(pWriter, Opcode_End)) {
+        return false;
+    }
+    if (pWriter->hasZStream && !WriterDeflate(pWriter, NULL, 0, Z_FINISH)) {
+        return false;
+    }
+    return WriterFlush(pWriter);
+}
+
+#pragma mark - Reader
+
+struct CVSSCPlaybackBinaryReader {
+    CVSSCPlaybackJSONReaderCallbacks callbacks;
+    CVSSCPlaybackBinaryReaderStatus status;
+    size_t strokeCount;
+    uint8_t header[HeaderLength];
+    size_t headerLength;
+    double inverseScale;
+    z_stream zStream;
+    bool hasZStream;
+    // the body (inflated), from which whole records are read
+    uint8_t* buffer;
+    size_t bufferLength;
+    size_t bufferCapacity;
+    CVSSCColor* colors;
+    size_t colorCount;
+    size_t colorCapacity;
+    CVSSCComponent* components;
+    size_t componentCapacity;
+};
+
+CVSSCPlaybackBinaryReader* CVSSCPlaybackBinaryReaderCreate(const CVSSCPlaybackJSONReaderCallbacks* const pCallbacks) {
+    assert(pCallbacks);
+    assert(pCallbacks->readStroke);
+    CVSSCPlaybackBinaryReader* const reader = CVSSCAllocate(sizeof(CVSSCPlaybackBinaryReader));
+    if (NULL == reader) {
+        return NULL;
+    }
+    memset(reader, 0, sizeof(*reader));
+    reader->callbacks = *pCallbacks;
+    reader->status = CVSSCPlaybackBinaryReaderStatusReading;
+    return reader;
+}
+
+void CVSSCPlaybackBinaryReaderDestroy(CVSSCPlaybackBinaryReader* const pReader) {
+    if (NULL == pReader) {
+        return;
+    }
+    if (pReader->hasZStream) {
+        inflateEnd(&pReader->zStream);
+    }
+    CVSSCFree(pReader->buffer);
+    CVSSCFree(pReader->colors);
+    CVSSCFree(pReader->components);
+    CVSSCFree(pReader);
+}
+
+CVSSCPlaybackBinaryReaderStatus CVSSCPlaybackBinaryReaderGetStatus(const CVSSCPlaybackBinaryReader* const pReader) {
+    assert(pReader);
+    return pReader->status;
+}
+
+size_t CVSSCPlaybackBinaryReaderGetStrokeCount(const CVSSCPlaybackBinaryReader* const pReader) {
+    assert(pReader);
+    return pReader->strokeCount;
+}
+
+static bool Fail(CVSSCPlaybackBinaryReader* const pReader) {
+    if (CVSSCPlaybackBinaryReaderStatusCancelled != pReader->status) {
+        pReader->status = CVSSCPlaybackBinaryReaderStatusMalformed;
+    }
+    return false;
+}
+
+static bool ReaderReserve(CVSSCPlaybackBinaryReader* const pReader, const size_t pLength) {
+    if (pReader->bufferCapacity - pReader->bufferLength >= pLength) {
+        return true;
+    }
+    size_t capacity = pReader->bufferCapacity ? pReader->bufferCapacity : 2 * ChunkLength;
+    while (capacity - pReader->bufferLength < pLength) {
+        capacity *= 2;
+    }
+    uint8_t* const buffer = CVSSCReallocate(pReader->buffer, capacity);
+    if (NULL == buffer) {
+        return false;
+    }
+    pReader->buffer = buffer;
+    pReader->bufferCapacity = capacity;
+    return true;
+}
+
+static bool ReadHeader(CVSSCPlaybackBinaryReader* const pReader) {
+    const uint8_t* const header = pReader->header;
+    if (!CVSSCPlaybackBinaryHasSignature(header, HeaderLength) || CVSSCPlaybackBinaryVersion != header[4]) {
+        return Fail(pReader);
+    }
+    const uint8_t flags = header[5];
+    const uint8_t coordinateShift = header[6];
+    if ((flags & ~CVSSCPlaybackBinaryFlagDeflated) || coordinateShift > CVSSCPlaybackBinaryMaxCoordinateShift) {
+        return Fail(pReader);
+    }
+    pReader->inverseScale = ldexp(1.0, -(int)coordinateShift);
+    if (flags & CVSSCPlaybackBinaryFlagDeflated) {
+        pReader->zStream.zalloc = ZAllocate;
+        pReader->zStream.zfree = ZFree;
+        if (Z_OK != inflateInit(&pReader->zStream)) {
+            return Fail(pReader);
+        }
+        pReader->hasZStream = true;
+    }
+    return true;
+}
+
+static bool ReadColor(CVSSCPlaybackBinaryReader* const pReader, const uint8_t* const pPayload, const size_t pLength) {
+    if (32 != pLength) {
+        return Fail(pReader);
+    }
+    if (pReader->colorCount == pReader->colorCapacity) {
+        const size_t capacity = pReader->colorCapacity ? 2 * pReader->colorCapacity : 16;
+        CVSSCColor* const colors = CVSSCReallocate(pReader->colors, capacity * sizeof(CVSSCColor));
+        if (NULL == colors) {
+            return Fail(pReader);
+        }
+        pReader->colors = colors;
+        pReader->colorCapacity = capacity;
+    }
+    double channels[4];
+    for (size_t idx = 0; idx < 4; ++idx) {
+        uint64_t bits = 0;
+        for (size_t octetIdx = 0; octetIdx < 8; ++octetIdx) {
+            bits |= (uint64_t)pPayload[8 * idx + octetIdx] << (8 * octetIdx);
+        }
+        channels[idx] = DecodeDouble(bits);
+    }
+    const CVSSCColor color = {channels[0], channels[1], channels[2], channels[3]};
+    pReader->colors[pReader->colorCount++] = color;
+    return true;
+}
+
+static bool ReadPoint(CVSSCPlaybackBinaryReader* const pReader, const uint8_t** const pAt, const uint8_t* const pEnd, int64_t pCursor[2], CVSSCPoint* const pOutPoint) {
+    uint64_t x = 0;
+    uint64_t y = 0;
+    if (!DecodeVarint(pAt, pEnd, &x) || !DecodeVarint(pAt, pEnd, &y)) {
+        return false;
+    }
+    pCursor[0] += ZigZagDecode(x);
+    pCursor[1] += ZigZagDecode(y);
+    pOutPoint->x = (double)pCursor[0] * pReader->inverseScale;
+    pOutPoint->y = (double)pCursor[1] * pReader->inverseScale;
+    return true;
+}
+
+static bool ReadStroke(CVSSCPlaybackBinaryReader* const pReader, const uint8_t* const pPayload, const size_t pLength) {
+    const uint8_t* at = pPayload;
+    const uint8_t* const end = pPayload + pLength;
+    uint64_t brushType = 0;
+    uint64_t colorIndex = 0;
+    uint64_t componentCount = 0;
+    if (!DecodeVarint(&at, end, &brushType) || !DecodeVarint(&at, end, &colorIndex) || !DecodeVarint(&at, end, &componentCount)) {
+        return Fail(pReader);
+    }
+    // a component is at least three octets, which bounds the allocation for malformed input
+    if (brushType > UINT32_MAX || colorIndex >= pReader->colorCount || componentCount > (uint64_t)(end - at) / 3) {
+        return Fail(pReader);
+    }
+    if (componentCount > pReader->componentCapacity) {
+        CVSSCComponent* const components = CVSSCReallocate(pReader->components, (size_t)componentCount * sizeof(CVSSCComponent));
+        if (NULL == components) {
+            return Fail(pReader);
+        }
+        pReader->components = components;
+        pReader->componentCapacity = (size_t)componentCount;
+    }
+    int64_t cursor[2] = {0, 0};
+    for (size_t idx = 0; idx < componentCount; ++idx) {
+        uint64_t tag = 0;
+        if (!DecodeVarint(&at, end, &tag)) {
+            return Fail(pReader);
+        }
+        const uint64_t type = tag >> 1;
+        const bool continues = tag & 1;
+        CVSSCPoint points[4] = {{0, 0}, {0, 0}, {0, 0}, {0, 0}};
+        if (CVSSCComponentTypePoint != type && CVSSCComponentTypeCurve != type && CVSSCComponentTypeFill != type) {
+            return Fail(pReader);
+        }
+        if (continues) {
+            points[0].x = (double)cursor[0] * pReader->inverseScale;
+            points[0].y = (double)cursor[1] * pReader->inverseScale;
+        }
+        for (size_t pointIdx = continues ? 1 : 0; pointIdx < 4; ++pointIdx) {
+            if (!IsStoredPoint(type, pointIdx)) {
+                continue;
+            }
+            if (!ReadPoint(pReader, &at, end, cursor, &points[pointIdx])) {
+                return Fail(pReader);
+            }
+        }
+        switch (type) {
+            case CVSSCComponentTypeCurve:
+                pReader->components[idx] = CVSSCComponentMakeCurve(points[0], points[1], points[2], points[3]);
+                break;
+            case CVSSCComponentTypeFill:
+                pReader->components[idx] = CVSSCComponentMakeFill(points[0]);
+                break;
+            default:
+                pReader->components[idx] = CVSSCComponentMakePoint(points[0], points[3]);
+                break;
+        }
+    }
+    if (at != end) {
+        return Fail(pReader);
+    }
+    const CVSSCPlaybackStroke stroke = {(uint32_t)brushType, pReader->colors[colorIndex], pReader->components, (size_t)componentCount};
+    ++pReader->strokeCount;
+    if (!pReader->callbacks.readStroke(pReader->callbacks.context, &stroke)) {
+        pReader->status = CVSSCPlaybackBinaryReaderStatusCancelled;
+        return false;
+    }
+    return true;
+}
+
+static bool ReadRecord(CVSSCPlaybackBinaryReader* const pReader, const uint64_t pOpcode, const uint8_t* const pPayload, const size_t pLength) {
+    switch (pOpcode) {
+        case Opcode_End:
+            if (pLength) {
+                return Fail(pReader);
+            }
+            pReader->status = CVSSCPlaybackBinaryReaderStatusComplete;
+            return true;
+        case Opcode_UsesTemplate:
+            if (1 != pLength) {
+                return Fail(pReader);
+            }
+            if (pReader->callbacks.readUsesTemplate) {
+                pReader->callbacks.readUsesTemplate(pReader->callbacks.context, 0 != pPayload[0]);
+            }
+            return true;
+        case Opcode_Color:
+            return ReadColor(pReader, pPayload, pLength);
+        case Opcode_Stroke:
+            return ReadStroke(pReader, pPayload, pLength);
+        default:
+            // a record of a later minor revision
+            return true;
+    }
+}
+
+// reads the whole records of the buffer, and keeps the remainder
+static bool ReadRecords(CVSSCPlaybackBinaryReader* const pReader) {
+    const uint8_t* at = pReader->buffer;
+    const uint8_t* const end = pReader->buffer + pReader->bufferLength;
+    while (CVSSCPlaybackBinaryReaderStatusReading == pReader->status && at < end) {
+        const uint8_t* payload = at;
+        uint64_t opcode = 0;
+        uint64_t length = 0;
+        if (!DecodeVarint(&payload, end, &opcode) || !DecodeVarint(&payload, end, &length)) {
+            if (end - at >= 2 * MaxVarintLength) {
+                return Fail(pReader);
+            }
+            break;
+        }
+        if (length > MaxRecordLength) {
+            return Fail(pReader);
+        }
+        if ((uint64_t)(end - payload) < length) {
+            break;
+        }
+        if (!ReadRecord(pReader, opcode, payload, (size_t)length)) {
+            return false;
+        }
+        at = payload + length;
+    }
+    const size_t remaining = (size_t)(end - at);
+    memmove(pReader->buffer, at, remaining);
+    pReader->bufferLength = remaining;
+    return true;
+}
+
+static bool ReadInflated(CVSSCPlaybackBinaryReader* const pReader, const uint8_t* const pBytes, const size_t pLength) {
+    z_stream* const stream = &pReader->zStream;
+    stream->next_in = (Bytef*)pBytes;
+    stream->avail_in = (uInt)pLength;
+    while (stream->avail_in && CVSSCPlaybackBinaryReaderStatusReading == pReader->status) {
+        if (!ReaderReserve(pReader, ChunkLength)) {
+            return Fail(pReader);
+        }
+        stream->next_out = &pReader->buffer[pReader->bufferLength];
+        stream->avail_out = (uInt)(pReader->bufferCapacity - pReader->bufferLength);
+        const int status = inflate(stream, Z_NO_FLUSH);
+        pReader->bufferLength = pReader->bufferCapacity - stream->avail_out;
+        if (Z_OK != status && Z_STREAM_END != status) {
+            return Fail(pReader);
+        }
+        if (!ReadRecords(pReader)) {
+            return false;
+        }
+        if (Z_STREAM_END == status) {
+            // the body must end with the End record
+            return CVSSCPlaybackBinaryReaderStatusComplete == pReader->status || Fail(pReader);
+        }
+    }
+    return true;
+}
+
+bool CVSSCPlaybackBinaryReaderAppend(CVSSCPlaybackBinaryReader* const pReader, const void* const pBytes, const size_t pLength) {
+    assert(pReader);
+    assert(pBytes || !pLength);
+    const uint8_t* bytes = pBytes;
+    size_t length = pLength;
+    if (CVSSCPlaybackBinaryReaderStatusReading != pReader->status) {
+        // anything after the End record is ignored
+        return CVSSCPlaybackBinaryReaderStatusComplete == pReader->status;
+    }
+    if (pReader->headerLength < HeaderLength) {
+        const size_t headerLength = length < HeaderLength - pReader->headerLength ? length : HeaderLength - pReader->headerLength;
+        memcpy(&pReader->header[pReader->headerLength], bytes, headerLength);
+        pReader->headerLength += headerLength;
+        bytes += headerLength;
+        length -= headerLength;
+        if (HeaderLength == pReader->headerLength && !ReadHeader(pReader)) {
+            return false;
+        }
+    }
+    if (!length) {
+        return true;
+    }
+    if (pReader->hasZStream) {
+        // zlib counts in uInt
+        while (length) {
+            const size_t chunkLength = length < UINT32_MAX ? length : UINT32_MAX;
+            if (!ReadInflated(pReader, bytes, chunkLength)) {
+                return false;
+            }
+            bytes += chunkLength;
+            length -= chunkLength;
+        }
+        return true;
+    }
+    if (!ReaderReserve(pReader, length)) {
+        return Fail(pReader);
+    }
+    memcpy(&pReader->buffer[pReader->bufferLength], bytes, length);
+    pReader->bufferLength += length;
+    return ReadRecords(pReader);
+}
+
+bool CVSSCPlaybackBinaryReaderFinish(CVSSCPlaybackBinaryReader* const pReader) {
+    assert(pReader);
+    if (CVSSCPlaybackBinaryReaderStatusComplete != pReader->status) {
+        Fail(pReader);
+        return false;
+    }
+    return true;
+}
+
+#pragma mark - Conversion
+
+typedef struct {
+    CVSSCPlaybackBinaryWriter* binaryWriter;
+    CVSSCPlaybackJSONWriter* jsonWriter;
+    bool failed;
+} Converter;
+
+static void ConverterWriteUsesTemplate(void* const pContext, const bool pUsesTemplate) {
+    Converter* const converter = pContext;
+    if (converter->binaryWriter) {
+        converter->failed = converter->failed || !CVSSCPlaybackBinaryWriterWriteUsesTemplate(converter->binaryWriter, pUsesTemplate);
+    }
+    else {
+        converter->failed = converter->failed || !CVSSCPlaybackJSONWriterWriteUsesTemplate(converter->jsonWriter, pUsesTemplate);
+    }
+}
+
+static bool ConverterWriteStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    Converter* const converter = pContext;
+    if (converter->binaryWriter) {
+        converter->failed = converter->failed || !CVSSCPlaybackBinaryWriterWriteStroke(converter->binaryWriter, pStroke);
+    }
+    else {
+        converter->failed = converter->failed || !CVSSCPlaybackJSONWriterWriteStroke(converter->jsonWriter, pStroke);
+    }
+    return !converter->failed;
+}
+
+bool CVSSCPlaybackConvertJSONToBinary(const void* const pJSON, const size_t pLength, const CVSSCPlaybackBinaryOptions* const pOptions, const CVSSCPlaybackOutput* const pOutput) {
+    assert(pJSON || !pLength);
+    assert(pOptions);
+    assert(pOutput);
+    Converter converter = {CVSSCPlaybackBinaryWriterCreate(pOutput, pOptions), NULL, false};
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {&converter, ConverterWriteUsesTemplate, ConverterWriteStroke};
+    CVSSCPlaybackJSONReader* const reader = converter.binaryWriter ? CVSSCPlaybackJSONReaderCreate(&callbacks) : NULL;
+    bool result = NULL != reader
+        && CVSSCPlaybackJSONReaderAppend(reader, pJSON, pLength)
+        && CVSSCPlaybackJSONReaderFinish(reader)
+        && !converter.failed;
+    result = result && CVSSCPlaybackBinaryWriterFinish(converter.binaryWriter);
+    CVSSCPlaybackJSONReaderDestroy(reader);
+    CVSSCPlaybackBinaryWriterDestroy(converter.binaryWriter);
+    return result;
+}
+
+bool CVSSCPlaybackConvertBinaryToJSON(const void* const pBinary, const size_t pLength, const CVSSCPlaybackOutput* const pOutput) {
+    assert(pBinary || !pLength);
+    assert(pOutput);
+    Converter converter = {NULL, CVSSCPlaybackJSONWriterCreate(pOutput), false};
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {&converter, ConverterWriteUsesTemplate, ConverterWriteStroke};
+    CVSSCPlaybackBinaryReader* const reader = converter.jsonWriter ? CVSSCPlaybackBinaryReaderCreate(&callbacks) : NULL;
+    bool result = NULL != reader
+        && CVSSCPlaybackBinaryReaderAppend(reader, pBinary, pLength)
+        && CVSSCPlaybackBinaryReaderFinish(reader)
+        && !converter.failed;
+    result = result && CVSSCPlaybackJSONWriterFinish(converter.jsonWriter);
+    CVSSCPlaybackBinaryReaderDestroy(reader);
+    CVSSCPlaybackJSONWriterDestroy(converter.jsonWriter);
+    return result;
+}
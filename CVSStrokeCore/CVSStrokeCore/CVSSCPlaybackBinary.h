@@ -0,0 +1,150 @@
+// CVSSCPlaybackBinary.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCPlaybackBinary_h
+#define CVSStrokeCore_CVSSCPlaybackBinary_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CVSSCPlaybackJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ The binary playback format: the content of playback JSON at a fraction of its size and parse time.
+
+ header (8 octets):
+   'C' 'V' 'S' 'P'
+   version           CVSSCPlaybackBinaryVersion
+   flags             CVSSCPlaybackBinaryFlagDeflated: the body is a zlib stream
+   coordinateShift   coordinates are stored as round(value * 2^coordinateShift)
+   reserved          0
+ body: a sequence of records -- varint opcode, varint payload length, payload. unknown opcodes are skipped.
+   UsesTemplate  one octet, 0 or 1
+   Color         red, green, blue, alpha as little endian float64. appended to the color table.
+   Stroke        varint brushType, varint color table index, varint componentCount, then the components. each
+                 component is a varint (type << 1 | continues) followed by its points as zig-zag varint deltas of the
+                 quantized x and y from the previous point of the stroke (the first point is relative to 0,0). when
+                 'continues' is set the fromPoint is the previous component's toPoint and is not stored. the points
+                 are, in order: fromPoint, controlPoint1, controlPoint2 (curves only), toPoint (not of fills, whose
+                 toPoint is the fromPoint).
+   End           empty. the last record.
+ varints are unsigned LEB128.
+
+ Coordinates are quantized, so a JSON -> binary -> JSON round trip moves points by at most 2^-(coordinateShift + 1)
+ points. Colors are exact.
+ */
+
+enum { CVSSCPlaybackBinaryVersion = 1 };
+
+enum {
+    CVSSCPlaybackBinaryFlagDeflated = 1 << 0
+};
+
+/**
+ @brief the default quantization: 1/32 point, well below what the renderer can show.
+ */
+enum { CVSSCPlaybackBinaryDefaultCoordinateShift = 5 };
+enum { CVSSCPlaybackBinaryMaxCoordinateShift = 16 };
+
+/**
+ @return true if @p pBytes begins with the binary playback signature. @p pLength may be less than a header.
+ */
+extern bool CVSSCPlaybackBinaryHasSignature(const void* const pBytes, const size_t pLength);
+
+#pragma mark - Writer
+
+typedef struct {
+    uint8_t coordinateShift;
+    bool deflate;
+} CVSSCPlaybackBinaryOptions;
+
+/**
+ @return the default options: CVSSCPlaybackBinaryDefaultCoordinateShift and deflated.
+ */
+extern CVSSCPlaybackBinaryOptions CVSSCPlaybackBinaryOptionsDefault(void);
+
+typedef struct CVSSCPlaybackBinaryWriter CVSSCPlaybackBinaryWriter;
+
+/**
+ @return a new writer, or NULL. destroy using CVSSCPlaybackBinaryWriterDestroy.
+ */
+extern CVSSCPlaybackBinaryWriter* CVSSCPlaybackBinaryWriterCreate(const CVSSCPlaybackOutput* const pOutput, const CVSSCPlaybackBinaryOptions* const pOptions);
+extern void CVSSCPlaybackBinaryWriterDestroy(CVSSCPlaybackBinaryWriter* const pWriter);
+
+extern bool CVSSCPlaybackBinaryWriterWriteUsesTemplate(CVSSCPlaybackBinaryWriter* const pWriter, const bool pUsesTemplate);
+
+/**
+ @brief components of a type other than point, curve or fill are not written (as they carry no geometry in playback JSON).
+ @return false if the output failed, a coordinate cannot be quantized (NaN, infinite, or beyond 2^52 quanta), or the stroke's
+ color would be beyond the color table's CVSSCPaletteMaxCount colors.
+ */
+extern bool CVSSCPlaybackBinaryWriterWriteStroke(CVSSCPlaybackBinaryWriter* const pWriter, const CVSSCPlaybackStroke* const pStroke);
+
+/**
+ @brief writes the End record and flushes the output. nothing may be written afterwards.
+ */
+extern bool CVSSCPlaybackBinaryWriterFinish(CVSSCPlaybackBinaryWriter* const pWriter);
+
+#pragma mark - Reader
+
+/*
+ A streaming reader of the binary format. It delivers strokes through the callbacks of the JSON reader so that a client
+ reads either format the same way (see CVSSCPlaybackBinaryHasSignature).
+ */
+
+typedef struct CVSSCPlaybackBinaryReader CVSSCPlaybackBinaryReader;
+
+typedef enum {
+    CVSSCPlaybackBinaryReaderStatusReading = 0,
+    CVSSCPlaybackBinaryReaderStatusComplete,
+    CVSSCPlaybackBinaryReaderStatusMalformed,
+    CVSSCPlaybackBinaryReaderStatusCancelled
+} CVSSCPlaybackBinaryReaderStatus;
+
+/**
+ @return a new reader, or NULL. destroy using CVSSCPlaybackBinaryReaderDestroy.
+ */
+extern CVSSCPlaybackBinaryReader* CVSSCPlaybackBinaryReaderCreate(const CVSSCPlaybackJSONReaderCallbacks* const pCallbacks);
+extern void CVSSCPlaybackBinaryReaderDestroy(CVSSCPlaybackBinaryReader* const pReader);
+
+/**
+ @brief reads the next chunk of the document. callbacks are made synchronously.
+ @return false if the document is malformed (or has an unsupported version) or reading was cancelled.
+ */
+extern bool CVSSCPlaybackBinaryReaderAppend(CVSSCPlaybackBinaryReader* const pReader, const void* const pBytes, const size_t pLength);
+
+/**
+ @brief call after the last chunk has been appended.
+ @return true if a complete document was read.
+ */
+extern bool CVSSCPlaybackBinaryReaderFinish(CVSSCPlaybackBinaryReader* const pReader);
+
+extern CVSSCPlaybackBinaryReaderStatus CVSSCPlaybackBinaryReaderGetStatus(const CVSSCPlaybackBinaryReader* const pReader);
+
+/**
+ @return the number of strokes delivered so far
+ */
+extern size_t CVSSCPlaybackBinaryReaderGetStrokeCount(const CVSSCPlaybackBinaryReader* const pReader);
+
+#pragma mark - Conversion
+
+/**
+ @brief converts a complete playback JSON document to the binary format.
+ */
+extern bool CVSSCPlaybackConvertJSONToBinary(const void* const pJSON, const size_t pLength, const CVSSCPlaybackBinaryOptions* const pOptions, const CVSSCPlaybackOutput* const pOutput);
+
+/**
+ @brief converts a complete binary document to playback JSON (the format the server accepts).
+ */
+extern bool CVSSCPlaybackConvertBinaryToJSON(const void* const pBinary, const size_t pLength, const CVSSCPlaybackOutput* const pOutput);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
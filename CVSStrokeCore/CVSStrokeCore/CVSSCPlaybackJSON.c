@@ -0,0 +1,791 @@
+// CVSSCPlaybackJSON.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CVSSCPlaybackJSON.h"
+#include "CVSSCMemory.h"
+
+#pragma mark - Declarations
+
+// what a container (or the value of a key) means to the playback document
+typedef enum {
+    Context_Document = 0,
+    Context_Root,
+    Context_Strokes,
+    Context_Stroke,
+    Context_Color,
+    Context_Components,
+    Context_Component,
+    Context_Skip
+} Context;
+
+typedef enum {
+    Key_Unknown = 0,
+    Key_UsesTemplate,
+    Key_Strokes,
+    Key_BrushType,
+    Key_StrokeColor,
+    Key_Components,
+    Key_Red,
+    Key_Green,
+    Key_Blue,
+    Key_Alpha,
+    Key_Type,
+    Key_FromPoint,
+    Key_ToPoint,
+    Key_ControlPoint1,
+    Key_ControlPoint2,
+    Key_Fill
+} Key;
+
+typedef enum {
+    Lexer_Default = 0,
+    Lexer_String,
+    Lexer_StringEscape,
+    Lexer_StringUnicode,
+    Lexer_Number,
+    Lexer_Literal
+} Lexer;
+
+enum { MaxDepth = 64 };
+
+typedef struct {
+    Context context;
+    bool isObject;
+    bool expectingKey;
+    bool awaitingValue;
+    Key key;
+} Frame;
+
+struct CVSSCPlaybackJSONReader {
+    CVSSCPlaybackJSONReaderCallbacks callbacks;
+    CVSSCPlaybackJSONReaderStatus status;
+    size_t strokeCount;
+    // lexer
+    Lexer lexer;
+    char* scratch;
+    size_t scratchLength;
+    size_t scratchCapacity;
+    uint32_t unicodeValue;
+    uint32_t unicodeDigits;
+    // parser
+    Frame frames[MaxDepth];
+    size_t depth;
+    // the stroke being read
+    CVSSCPlaybackStroke stroke;
+    CVSSCComponent* components;
+    size_t componentCapacity;
+    // the component being read, and whether it is marked as a fill
+    CVSSCComponent component;
+    bool componentIsFill;
+};
+
+#pragma mark - Buffers
+
+static bool ScratchAppend(CVSSCPlaybackJSONReader* const pReader, const char pChar) {
+    if (pReader->scratchLength + 1 >= pReader->scratchCapacity) {
+        const size_t capacity = pReader->scratchCapacity ? 2 * pReader->scratchCapacity : 64;
+        char* const scratch = CVSSCReallocate(pReader->scratch, capacity);
+        if (NULL == scratch) {
+            return false;
+        }
+        pReader->scratch = scratch;
+        pReader->scratchCapacity = capacity;
+    }
+    pReader->scratch[pReader->scratchLength++] = pChar;
+    pReader->scratch[pReader->scratchLength] = 0;
+    return true;
+}
+
+static void ScratchReset(CVSSCPlaybackJSONReader* const pReader) {
+    pReader->scratchLength = 0;
+    if (pReader->scratch) {
+        pReader->scratch[0] = 0;
+    }
+}
+
+static bool ComponentsAppend(CVSSCPlaybackJSONReader* const pReader, const CVSSCComponent* const pComponent) {
+    const size_t count = pReader->stroke.componentCount;
+    if (count == pReader->componentCapacity) {
+        const size_t capacity = pReader->componentCapacity ? 2 * pReader->componentCapacity : 256;
+        CVSSCComponent* const components = CVSSCReallocate(pReader->components, capacity * sizeof(CVSSCComponent));
+        if (NULL == components) {
+            return false;
+        }
+        pReader->components = components;
+        pReader->componentCapacity = capacity;
+    }
+    pReader->components[count] = *pComponent;
+    pReader->stroke.componentCount = count + 1;
+    return true;
+}
+
+#pragma mark - Lifetime
+
+CVSSCPlaybackJSONReader* CVSSCPlaybackJSONReaderCreate(const CVSSCPlaybackJSONReaderCallbacks* const pCallbacks) {
+    assert(pCallbacks);
+    assert(pCallbacks->readStroke);
+    CVSSCPlaybackJSONReader* const reader = CVSSCAllocate(sizeof(CVSSCPlaybackJSONReader));
+    if (NULL == reader) {
+        return NULL;
+    }
+    memset(reader, 0, sizeof(*reader));
+    reader->callbacks = *pCallbacks;
+    reader->status = CVSSCPlaybackJSONReaderStatusReading;
+    reader->frames[0].context = Context_Document;
+    reader->depth = 1;
+    return reader;
+}
+
+void CVSSCPlaybackJSONReaderDestroy(CVSSCPlaybackJSONReader* const pReader) {
+    if (NULL == pReader) {
+        return;
+    }
+    CVSSCFree(pReader->scratch);
+    CVSSCFree(pReader->components);
+    CVSSCFree(pReader);
+}
+
+CVSSCPlaybackJSONReaderStatus CVSSCPlaybackJSONReaderGetStatus(const CVSSCPlaybackJSONReader* const pReader) {
+    assert(pReader);
+    return pReader->status;
+}
+
+size_t CVSSCPlaybackJSONReaderGetStrokeCount(const CVSSCPlaybackJSONReader* const pReader) {
+    assert(pReader);
+    return pReader->strokeCount;
+}
+
+#pragma mark - Parser
+
+static Frame* ValueFrame(CVSSCPlaybackJSONReader* const pReader) {
+    return &pReader->frames[pReader->depth - 1];
+}
+
+static bool Fail(CVSSCPlaybackJSONReader* const pReader) {
+    if (CVSSCPlaybackJSONReaderStatusReading == pReader->status) {
+        pReader->status = CVSSCPlaybackJSONReaderStatusMalformed;
+    }
+    return false;
+}
+
+static Key KeyForName(const Context pContext, const char* const pName) {
+    switch (pContext) {
+        case Context_Root:
+            if (0 == strcmp(pName, "usesTemplate")) return Key_UsesTemplate;
+            if (0 == strcmp(pName, "strokes")) return Key_Strokes;
+            break;
+        case Context_Stroke:
+            if (0 == strcmp(pName, "brushType")) return Key_BrushType;
+            if (0 == strcmp(pName, "strokeColor")) return Key_StrokeColor;
+            if (0 == strcmp(pName, "components")) return Key_Components;
+            break;
+        case Context_Color:
+            if (0 == strcmp(pName, "r")) return Key_Red;
+            if (0 == strcmp(pName, "g")) return Key_Green;
+            if (0 == strcmp(pName, "b")) return Key_Blue;
+            if (0 == strcmp(pName, "a")) return Key_Alpha;
+            break;
+        case Context_Component:
+            if (0 == strcmp(pName, "type")) return Key_Type;
+            if (0 == strcmp(pName, "fromPoint")) return Key_FromPoint;
+            if (0 == strcmp(pName, "toPoint")) return Key_ToPoint;
+            if (0 == strcmp(pName, "controlPoint1")) return Key_ControlPoint1;
+            if (0 == strcmp(pName, "controlPoint2")) return Key_ControlPoint2;
+            if (0 == strcmp(pName, "fill")) return Key_Fill;
+            break;
+        case Context_Document:
+        case Context_Strokes:
+        case Context_Components:
+        case Context_Skip:
+            break;
+    }
+    return Key_Unknown;
+}
+
+// @return the context of a container which begins in the current frame
+static Context ContextOfNewContainer(const Frame* const pParent, const bool pIsObject) {
+    switch (pParent->context) {
+        case Context_Document:
+            return pIsObject ? Context_Root : Context_Skip;
+        case Context_Root:
+            return (!pIsObject && Key_Strokes == pParent->key) ? Context_Strokes : Context_Skip;
+        case Context_Strokes:
+            return pIsObject ? Context_Stroke : Context_Skip;
+        case Context_Stroke:
+            if (pIsObject && Key_StrokeColor == pParent->key) return Context_Color;
+            if (!pIsObject && Key_Components == pParent->key) return Context_Components;
+            return Context_Skip;
+        case Context_Components:
+            return pIsObject ? Context_Component : Context_Skip;
+        case Context_Color:
+        case Context_Component:
+        case Context_Skip:
+            break;
+    }
+    return Context_Skip;
+}
+
+static bool ValueWillBegin(CVSSCPlaybackJSONReader* const pReader) {
+    const Frame* const frame = ValueFrame(pReader);
+    if (frame->isObject && !frame->awaitingValue) {
+        // a value where a key was expected
+        return Fail(pReader);
+    }
+    if (Context_Document == frame->context && CVSSCPlaybackJSONReaderStatusReading != pReader->status) {
+        return Fail(pReader);
+    }
+    return true;
+}
+
+static bool BeginContainer(CVSSCPlaybackJSONReader* const pReader, const bool pIsObject) {
+    if (!ValueWillBegin(pReader)) {
+        return false;
+    }
+    if (MaxDepth == pReader->depth) {
+        return Fail(pReader);
+    }
+    const Context context = ContextOfNewContainer(&pReader->frames[pReader->depth - 1], pIsObject);
+    Frame* const frame = &pReader->frames[pReader->depth++];
+    frame->context = context;
+    frame->isObject = pIsObject;
+    frame->expectingKey = pIsObject;
+    frame->awaitingValue = false;
+    frame->key = Key_Unknown;
+
+    if (Context_Stroke == context) {
+        const CVSSCColor black = {0, 0, 0, 1};
+        pReader->stroke.brushType = 0;
+        pReader->stroke.color = black;
+        pReader->stroke.components = NULL;
+        pReader->stroke.componentCount = 0;
+    }
+    else if (Context_Component == context) {
+        memset(&pReader->component, 0, sizeof(pReader->component));
+        pReader->componentIsFill = false;
+    }
+    return true;
+}
+
+static bool EndContainer(CVSSCPlaybackJSONReader* const pReader, const bool pIsObject) {
+    if (1 >= pReader->depth) {
+        return Fail(pReader);
+    }
+    const Frame* const frame = &pReader->frames[pReader->depth - 1];
+    if (frame->isObject != pIsObject || frame->awaitingValue) {
+        // mismatched, or a key without a value
+        return Fail(pReader);
+    }
+    const Context context = frame->context;
+    --pReader->depth;
+    ValueFrame(pReader)->awaitingValue = false;
+
+    if (Context_Component == context) {
+        CVSSCComponent* const component = &pReader->component;
+        if (pReader->componentIsFill && CVSSCComponentTypePoint == component->type) {
+            // a fill as it is written for players which predate fills. see WriterAppendComponent.
+            *component = CVSSCComponentMakeFill(component->fromPoint);
+        }
+        if (CVSSCComponentTypeCurve != component->type) {
+            component->controlPoint1.x = component->controlPoint1.y = 0;
+            component->controlPoint2.x = component->controlPoint2.y = 0;
+        }
+        if (!ComponentsAppend(pReader, component)) {
+            return Fail(pReader);
+        }
+    }
+    else if (Context_Stroke == context) {
+        pReader->stroke.components = pReader->components;
+        ++pReader->strokeCount;
+        if (!pReader->callbacks.readStroke(pReader->callbacks.context, &pReader->stroke)) {
+            pReader->status = CVSSCPlaybackJSONReaderStatusCancelled;
+            return false;
+        }
+        pReader->stroke.componentCount = 0;
+    }
+    else if (Context_Root == context) {
+        pReader->status = CVSSCPlaybackJSONReaderStatusComplete;
+    }
+    return true;
+}
+
+static bool ReadString(CVSSCPlaybackJSONReader* const pReader, const char* const pString) {
+    Frame* const frame = ValueFrame(pReader);
+    if (frame->isObject && frame->expectingKey) {
+        frame->key = KeyForName(frame->context, pString);
+        frame->expectingKey = false;
+        frame->awaitingValue = true;
+        return true;
+    }
+    if (!ValueWillBegin(pReader)) {
+        return false;
+    }
+    frame->awaitingValue = false;
+    if (Context_Component == frame->context) {
+        CVSSCComponent* const component = &pReader->component;
+        switch (frame->key) {
+            case Key_FromPoint:
+                CVSSCPointParse(pString, &component->fromPoint);
+                break;
+            case Key_ToPoint:
+                CVSSCPointParse(pString, &component->toPoint);
+                break;
+            case Key_ControlPoint1:
+                CVSSCPointParse(pString, &component->controlPoint1);
+                break;
+            case Key_ControlPoint2:
+                CVSSCPointParse(pString, &component->controlPoint2);
+                break;
+            default:
+                break;
+        }
+    }
+    return true;
+}
+
+static bool ReadNumber(CVSSCPlaybackJSONReader* const pReader, const double pNumber) {
+    if (!ValueWillBegin(pReader)) {
+        return false;
+    }
+    Frame* const frame = ValueFrame(pReader);
+    frame->awaitingValue = false;
+    switch (frame->context) {
+        case Context_Root:
+            if (Key_UsesTemplate == frame->key && pReader->callbacks.readUsesTemplate) {
+                pReader->callbacks.readUsesTemplate(pReader->callbacks.context, 0 != pNumber);
+            }
+            break;
+        case Context_Stroke:
+            if (Key_BrushType == frame->key) {
+                pReader->stroke.brushType = (uint32_t)pNumber;
+            }
+            break;
+        case Context_Color:
+            switch (frame->key) {
+                case Key_Red: pReader->stroke.color.red = pNumber; break;
+                case Key_Green: pReader->stroke.color.green = pNumber; break;
+                case Key_Blue: pReader->stroke.color.blue = pNumber; break;
+                case Key_Alpha: pReader->stroke.color.alpha = pNumber; break;
+                default: break;
+            }
+            break;
+        case Context_Component:
+            if (Key_Type == frame->key) {
+                pReader->component.type = (CVSSCComponentType)pNumber;
+            }
+            else if (Key_Fill == frame->key) {
+                pReader->componentIsFill = 0 != pNumber;
+            }
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+static bool ReadLiteral(CVSSCPlaybackJSONReader* const pReader, const char* const pLiteral) {
+    if (0 == strcmp(pLiteral, "true")) {
+        return ReadNumber(pReader, 1);
+    }
+    if (0 == strcmp(pLiteral, "false")) {
+        return ReadNumber(pReader, 0);
+    }
+    if (0 == strcmp(pLiteral, "null")) {
+        if (!ValueWillBegin(pReader)) {
+            return false;
+        }
+        ValueFrame(pReader)->awaitingValue = false;
+        return true;
+    }
+    return Fail(pReader);
+}
+
+static bool ReadSeparator(CVSSCPlaybackJSONReader* const pReader, const char pChar) {
+    Frame* const frame = ValueFrame(pReader);
+    if (':' == pChar) {
+        return (frame->isObject && frame->awaitingValue) ? true : Fail(pReader);
+    }
+    // ','
+    if (Context_Document == frame->context) {
+        return Fail(pReader);
+    }
+    if (frame->isObject) {
+        if (frame->awaitingValue) {
+            return Fail(pReader);
+        }
+        frame->expectingKey = true;
+        frame->key = Key_Unknown;
+    }
+    return true;
+}
+
+#pragma mark - Lexer
+
+static bool IsNumberChar(const char p) {
+    return ('0' <= p && '9' >= p) || '-' == p || '+' == p || '.' == p || 'e' == p || 'E' == p;
+}
+
+static bool IsLiteralChar(const char p) {
+    return 'a' <= p && 'z' >= p;
+}
+
+static int HexValue(const char p) {
+    if ('0' <= p && '9' >= p) return p - '0';
+    if ('a' <= p && 'f' >= p) return 10 + p - 'a';
+    if ('A' <= p && 'F' >= p) return 10 + p - 'A';
+    return -1;
+}
+
+static bool AppendUTF8(CVSSCPlaybackJSONReader* const pReader, const uint32_t pCodePoint) {
+    if (0x80 > pCodePoint) {
+        return ScratchAppend(pReader, (char)pCodePoint);
+    }
+    if (0x800 > pCodePoint) {
+        return ScratchAppend(pReader, (char)(0xC0 | (pCodePoint >> 6))) && ScratchAppend(pReader, (char)(0x80 | (pCodePoint & 0x3F)));
+    }
+    return ScratchAppend(pReader, (char)(0xE0 | (pCodePoint >> 12)))
+        && ScratchAppend(pReader, (char)(0x80 | ((pCodePoint >> 6) & 0x3F)))
+        && ScratchAppend(pReader, (char)(0x80 | (pCodePoint & 0x3F)));
+}
+
+// @return false if the token is invalid
+static bool FinishToken(CVSSCPlaybackJSONReader* const pReader) {
+    const Lexer lexer = pReader->lexer;
+    pReader->lexer = Lexer_Default;
+    const char* const token = pReader->scratch ? pReader->scratch : "";
+    bool result = true;
+    if (Lexer_Number == lexer) {
+        char* end = NULL;
+        const double value = strtod(token, &end);
+        result = (end != token && 0 == *end) ? ReadNumber(pReader, value) : Fail(pReader);
+    }
+    else if (Lexer_Literal == lexer) {
+        result = ReadLiteral(pReader, token);
+    }
+    else if (Lexer_String == lexer) {
+        result = ReadString(pReader, token);
+    }
+    ScratchReset(pReader);
+    return result;
+}
+
+static bool ReadDefault(CVSSCPlaybackJSONReader* const pReader, const char pChar) {
+    switch (pChar) {
+        case ' ': case '\t': case '\n': case '\r':
+            return true;
+        case '{':
+            return BeginContainer(pReader, true);
+        case '[':
+            return BeginContainer(pReader, false);
+        case '}':
+            return EndContainer(pReader, true);
+        case ']':
+            return EndContainer(pReader, false);
+        case ':': case ',':
+            return ReadSeparator(pReader, pChar);
+        case '"':
+            pReader->lexer = Lexer_String;
+            ScratchReset(pReader);
+            return true;
+        default:
+            break;
+    }
+    if (IsNumberChar(pChar)) {
+        pReader->lexer = Lexer_Number;
+        return ScratchAppend(pReader, pChar) ? true : Fail(pReader);
+    }
+    if (IsLiteralChar(pChar)) {
+        pReader->lexer = Lexer_Literal;
+        return ScratchAppend(pReader, pChar) ? true : Fail(pReader);
+    }
+    return Fail(pReader);
+}
+
+bool CVSSCPlaybackJSONReaderAppend(CVSSCPlaybackJSONReader* const pReader, const void* const pBytes, const size_t pLength) {
+    assert(pReader);
+    assert(pBytes || 0 == pLength);
+    const char* const bytes = pBytes;
+    size_t idx = 0;
+    while (idx < pLength) {
+        if (CVSSCPlaybackJSONReaderStatusMalformed == pReader->status || CVSSCPlaybackJSONReaderStatusCancelled == pReader->status) {
+            return false;
+        }
+        const char at = bytes[idx];
+        switch (pReader->lexer) {
+            case Lexer_Default:
+                if (!ReadDefault(pReader, at)) {
+                    return false;
+                }
+                break;
+            case Lexer_String:
+                if ('"' == at) {
+                    if (!FinishToken(pReader)) {
+                        return false;
+                    }
+                }
+                else if ('\\' == at) {
+                    pReader->lexer = Lexer_StringEscape;
+                }
+                else if (!ScratchAppend(pReader, at)) {
+                    return Fail(pReader);
+                }
+                break;
+            case Lexer_StringEscape: {
+                char unescaped = at;
+                switch (at) {
+                    case 'b': unescaped = '\b'; break;
+                    case 'f': unescaped = '\f'; break;
+                    case 'n': unescaped = '\n'; break;
+                    case 'r': unescaped = '\r'; break;
+                    case 't': unescaped = '\t'; break;
+                    case 'u':
+                        pReader->lexer = Lexer_StringUnicode;
+                        pReader->unicodeValue = 0;
+                        pReader->unicodeDigits = 0;
+                        break;
+                    default:
+                        break;
+                }
+                if (Lexer_StringEscape == pReader->lexer) {
+                    pReader->lexer = Lexer_String;
+                    if (!ScratchAppend(pReader, unescaped)) {
+                        return Fail(pReader);
+                    }
+                }
+                break;
+            }
+            case Lexer_StringUnicode: {
+                const int value = HexValue(at);
+                if (0 > value) {
+                    return Fail(pReader);
+                }
+                pReader->unicodeValue = (pReader->unicodeValue << 4) | (uint32_t)value;
+                if (4 == ++pReader->unicodeDigits) {
+                    pReader->lexer = Lexer_String;
+                    if (!AppendUTF8(pReader, pReader->unicodeValue)) {
+                        return Fail(pReader);
+                    }
+                }
+                break;
+            }
+            case Lexer_Number:
+            case Lexer_Literal:
+                if ((Lexer_Number == pReader->lexer && IsNumberChar(at)) || (Lexer_Literal == pReader->lexer && IsLiteralChar(at))) {
+                    if (!ScratchAppend(pReader, at)) {
+                        return Fail(pReader);
+                    }
+                }
+                else {
+                    if (!FinishToken(pReader)) {
+                        return false;
+                    }
+                    // the terminating character is read again in the default state
+                    continue;
+                }
+                break;
+        }
+        ++idx;
+    }
+    return CVSSCPlaybackJSONReaderStatusMalformed != pReader->status && CVSSCPlaybackJSONReaderStatusCancelled != pReader->status;
+}
+
+bool CVSSCPlaybackJSONReaderFinish(CVSSCPlaybackJSONReader* const pReader) {
+    assert(pReader);
+    if (Lexer_Number == pReader->lexer || Lexer_Literal == pReader->lexer) {
+        if (!FinishToken(pReader)) {
+            return false;
+        }
+    }
+    if (CVSSCPlaybackJSONReaderStatusComplete != pReader->status) {
+        Fail(pReader);
+        return false;
+    }
+    return true;
+}
+
+#pragma mark - Writer
+
+// the size of the chunks passed to the output
+enum { WriterBufferCapacity = 16 * 1024 };
+// the longest number representation ("%.17g" of a double) or point, with room to spare
+enum { WriterMaxTokenLength = 128 };
+
+struct CVSSCPlaybackJSONWriter {
+    CVSSCPlaybackOutput output;
+    bool failed;
+    bool finished;
+    bool hasUsesTemplate;
+    // usesTemplate was written after the first stroke, so it follows the strokes
+    bool usesTemplateIsPending;
+    bool usesTemplate;
+    bool strokesBegan;
+    size_t strokeCount;
+    size_t length;
+    char buffer[WriterBufferCapacity];
+};
+
+CVSSCPlaybackJSONWriter* CVSSCPlaybackJSONWriterCreate(const CVSSCPlaybackOutput* const pOutput) {
+    assert(pOutput);
+    assert(pOutput->write);
+    CVSSCPlaybackJSONWriter* const writer = CVSSCAllocate(sizeof(CVSSCPlaybackJSONWriter));
+    if (NULL == writer) {
+        return NULL;
+    }
+    memset(writer, 0, sizeof(*writer) - sizeof(writer->buffer));
+    writer->output = *pOutput;
+    // the root object is opened here so that usesTemplate may precede the strokes
+    writer->buffer[0] = '{';
+    writer->length = 1;
+    return writer;
+}
+
+void CVSSCPlaybackJSONWriterDestroy(CVSSCPlaybackJSONWriter* const pWriter) {
+    CVSSCFree(pWriter);
+}
+
+static bool WriterFlush(CVSSCPlaybackJSONWriter* const pWriter) {
+    if (!pWriter->failed && pWriter->length) {
+        pWriter->failed = !pWriter->output.write(pWriter->output.context, pWriter->buffer, pWriter->length);
+    }
+    pWriter->length = 0;
+    return !pWriter->failed;
+}
+
+static bool WriterAppend(CVSSCPlaybackJSONWriter* const pWriter, const char* const pString, const size_t pLength) {
+    assert(pLength <= WriterBufferCapacity);
+    if (WriterBufferCapacity - pWriter->length < pLength && !WriterFlush(pWriter)) {
+        return false;
+    }
+    memcpy(&pWriter->buffer[pWriter->length], pString, pLength);
+    pWriter->length += pLength;
+    return true;
+}
+
+static bool WriterAppendString(CVSSCPlaybackJSONWriter* const pWriter, const char* const pString) {
+    return WriterAppend(pWriter, pString, strlen(pString));
+}
+
+// the shortest representation which reads back as the same double, so that "12.5" is not written as 12.500000000000000
+static bool FormatNumber(char* const pOut, const size_t pCapacity, const double pNumber) {
+    if (!isfinite(pNumber)) {
+        return false;
+    }
+    for (int precision = 15; precision <= 17; ++precision) {
+        snprintf(pOut, pCapacity, "%.*g", precision, pNumber);
+        if (strtod(pOut, NULL) == pNumber) {
+            break;
+        }
+    }
+    return true;
+}
+
+// as NSStringFromCGPoint
+static bool WriterAppendPoint(CVSSCPlaybackJSONWriter* const pWriter, const char* const pKey, const CVSSCPoint pPoint) {
+    char x[WriterMaxTokenLength / 2];
+    char y[WriterMaxTokenLength / 2];
+    if (!FormatNumber(x, sizeof(x), pPoint.x) || !FormatNumber(y, sizeof(y), pPoint.y)) {
+        return false;
+    }
+    char token[WriterMaxTokenLength + 32];
+    const int length = snprintf(token, sizeof(token), ",\"%s\":\"{%s, %s}\"", pKey, x, y);
+    assert(length > 0 && (size_t)length < sizeof(token));
+    return WriterAppend(pWriter, token, (size_t)length);
+}
+
+static bool WriterAppendColor(CVSSCPlaybackJSONWriter* const pWriter, const CVSSCColor pColor) {
+    char r[WriterMaxTokenLength / 2];
+    char g[WriterMaxTokenLength / 2];
+    char b[WriterMaxTokenLength / 2];
+    if (!FormatNumber(r, sizeof(r), pColor.red) || !FormatNumber(g, sizeof(g), pColor.green) || !FormatNumber(b, sizeof(b), pColor.blue)) {
+        return false;
+    }
+    // as DQDictionaryFromColor, there is no alpha
+    char token[2 * WriterMaxTokenLength];
+    const int length = snprintf(token, sizeof(token), "\"strokeColor\":{\"r\":%s,\"g\":%s,\"b\":%s}", r, g, b);
+    assert(length > 0 && (size_t)length < sizeof(token));
+    return WriterAppend(pWriter, token, (size_t)length);
+}
+
+static bool WriterAppendComponent(CVSSCPlaybackJSONWriter* const pWriter, const CVSSCComponent* const pComponent) {
+    // as CVSStrokeComponent +componentRepresentationWithPackedComponent:
+    if (CVSSCComponentTypePoint != pComponent->type && CVSSCComponentTypeCurve != pComponent->type && CVSSCComponentTypeFill != pComponent->type) {
+        return WriterAppendString(pWriter, "{}");
+    }
+    // a fill is written as a point at its seed, marked with "fill". players which predate fills read it as the paint bucket
+    // stroke they recorded (a point, stroked wide enough to cover the canvas), rather than as a component they do not know.
+    const bool isFill = CVSSCComponentTypeFill == pComponent->type;
+    char type[32];
+    snprintf(type, sizeof(type), "{\"type\":%u", (unsigned)(isFill ? CVSSCComponentTypePoint : pComponent->type));
+    if (!WriterAppendString(pWriter, type)
+        || !WriterAppendPoint(pWriter, "fromPoint", pComponent->fromPoint)
+        || !WriterAppendPoint(pWriter, "toPoint", pComponent->toPoint)) {
+        return false;
+    }
+    if (CVSSCComponentTypeCurve == pComponent->type) {
+        if (!WriterAppendPoint(pWriter, "controlPoint1", pComponent->controlPoint1)
+            || !WriterAppendPoint(pWriter, "controlPoint2", pComponent->controlPoint2)) {
+            return false;
+        }
+    }
+    return WriterAppendString(pWriter, isFill ? ",\"fill\":1}" : "}");
+}
+
+bool CVSSCPlaybackJSONWriterWriteUsesTemplate(CVSSCPlaybackJSONWriter* const pWriter, const bool pUsesTemplate) {
+    assert(pWriter);
+    assert(!pWriter->finished);
+    assert(!pWriter->hasUsesTemplate && "usesTemplate was already written");
+    pWriter->hasUsesTemplate = true;
+    pWriter->usesTemplate = pUsesTemplate;
+    if (pWriter->strokesBegan) {
+        pWriter->usesTemplateIsPending = true;
+        return !pWriter->failed;
+    }
+    return WriterAppendString(pWriter, pUsesTemplate ? "\"usesTemplate\":1," : "\"usesTemplate\":0,");
+}
+
+bool CVSSCPlaybackJSONWriterWriteStroke(CVSSCPlaybackJSONWriter* const pWriter, const CVSSCPlaybackStroke* const pStroke) {
+    assert(pWriter);
+    assert(pStroke);
+    assert(!pWriter->finished);
+    if (pWriter->failed) {
+        return false;
+    }
+    char brushType[64];
+    snprintf(brushType, sizeof(brushType), "%s{\"brushType\":%u,", pWriter->strokesBegan ? "," : "\"strokes\":[", (unsigned)pStroke->brushType);
+    pWriter->strokesBegan = true;
+    if (!WriterAppendString(pWriter, brushType) || !WriterAppendColor(pWriter, pStroke->color) || !WriterAppendString(pWriter, ",\"components\":[")) {
+        pWriter->failed = true;
+        return false;
+    }
+    for (size_t idx = 0; idx < pStroke->componentCount; ++idx) {
+        if ((idx && !WriterAppendString(pWriter, ",")) || !WriterAppendComponent(pWriter, &pStroke->components[idx])) {
+            pWriter->failed = true;
+            return false;
+        }
+    }
+    if (!WriterAppendString(pWriter, "]}")) {
+        return false;
+    }
+    ++pWriter->strokeCount;
+    return true;
+}
+
+bool CVSSCPlaybackJSONWriterFinish(CVSSCPlaybackJSONWriter* const pWriter) {
+    assert(pWriter);
+    assert(!pWriter->finished);
+    pWriter->finished = true;
+    if (!WriterAppendString(pWriter, pWriter->strokesBegan ? "]" : "\"strokes\":[]")) {
+        return false;
+    }
+    if (pWriter->usesTemplateIsPending) {
+        if (!WriterAppendString(pWriter, pWriter->usesTemplate ? ",\"usesTemplate\":1" : ",\"usesTemplate\":0")) {
+            return false;
+        }
+    }
+    return WriterAppendString(pWriter, "}") && WriterFlush(pWriter);
+}
@@ -0,0 +1,122 @@
+// CVSSCPlaybackJSON.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCPlaybackJSON_h
+#define CVSStrokeCore_CVSSCPlaybackJSON_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CVSSCColor.h"
+#include "CVSSCComponent.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ A streaming reader of playback JSON (the format written by CVSDrawing -writePlaybackDataAsJSONToPath:):
+
+ {"usesTemplate":1,"strokes":[{"brushType":1,"strokeColor":{"r":0,"g":0,"b":0},"components":[{"type":1,"fromPoint":"{x, y}",...},...]},...]}
+
+ Input may be appended in chunks of any size (e.g. as it arrives from the network). Each stroke is delivered as soon as
+ its closing brace has been read. Keys may be in any order, and unknown keys are skipped.
+
+ A fill (CVSSCComponentTypeFill) is a point component at its seed with "fill":1 -- {"type":0,"fromPoint":"{x, y}",
+ "toPoint":"{x, y}","fill":1} -- so that players which predate fills draw the paint bucket stroke they recorded. The
+ reader delivers it as a fill. A component of type 2 is also read as a fill.
+ */
+
+typedef struct CVSSCPlaybackJSONReader CVSSCPlaybackJSONReader;
+
+/**
+ @brief a stroke, as delivered to the reader's client. components are only valid for the duration of the callback.
+ */
+typedef struct {
+    uint32_t brushType;
+    CVSSCColor color;
+    const CVSSCComponent* components;
+    size_t componentCount;
+} CVSSCPlaybackStroke;
+
+typedef struct {
+    void* context;
+    /** @brief optional. called when usesTemplate is read. */
+    void (*readUsesTemplate)(void* const pContext, const bool pUsesTemplate);
+    /** @brief called for every stroke, in order. return false to cancel reading. */
+    bool (*readStroke)(void* const pContext, const CVSSCPlaybackStroke* const pStroke);
+} CVSSCPlaybackJSONReaderCallbacks;
+
+typedef enum {
+    CVSSCPlaybackJSONReaderStatusReading = 0,
+    CVSSCPlaybackJSONReaderStatusComplete,
+    CVSSCPlaybackJSONReaderStatusMalformed,
+    CVSSCPlaybackJSONReaderStatusCancelled
+} CVSSCPlaybackJSONReaderStatus;
+
+/**
+ @return a new reader, or NULL. destroy using CVSSCPlaybackJSONReaderDestroy.
+ */
+extern CVSSCPlaybackJSONReader* CVSSCPlaybackJSONReaderCreate(const CVSSCPlaybackJSONReaderCallbacks* const pCallbacks);
+extern void CVSSCPlaybackJSONReaderDestroy(CVSSCPlaybackJSONReader* const pReader);
+
+/**
+ @brief reads the next chunk of the document. callbacks are made synchronously.
+ @return false if the document is malformed or reading was cancelled.
+ */
+extern bool CVSSCPlaybackJSONReaderAppend(CVSSCPlaybackJSONReader* const pReader, const void* const pBytes, const size_t pLength);
+
+/**
+ @brief call after the last chunk has been appended.
+ @return true if a complete document was read.
+ */
+extern bool CVSSCPlaybackJSONReaderFinish(CVSSCPlaybackJSONReader* const pReader);
+
+extern CVSSCPlaybackJSONReaderStatus CVSSCPlaybackJSONReaderGetStatus(const CVSSCPlaybackJSONReader* const pReader);
+
+/**
+ @return the number of strokes delivered so far
+ */
+extern size_t CVSSCPlaybackJSONReaderGetStrokeCount(const CVSSCPlaybackJSONReader* const pReader);
+
+/*
+ A writer of playback JSON in the format of CVSDrawing -writePlaybackDataAsJSONToPath: (points as "{x, y}", colors as
+ r/g/b), for converting other representations to the format the server accepts. Output is buffered and passed to the
+ client in chunks.
+ */
+
+typedef struct {
+    void* context;
+    /** @brief called with each chunk of output, in order. return false to fail writing. */
+    bool (*write)(void* const pContext, const void* const pBytes, const size_t pLength);
+} CVSSCPlaybackOutput;
+
+typedef struct CVSSCPlaybackJSONWriter CVSSCPlaybackJSONWriter;
+
+/**
+ @return a new writer, or NULL. destroy using CVSSCPlaybackJSONWriterDestroy.
+ */
+extern CVSSCPlaybackJSONWriter* CVSSCPlaybackJSONWriterCreate(const CVSSCPlaybackOutput* const pOutput);
+extern void CVSSCPlaybackJSONWriterDestroy(CVSSCPlaybackJSONWriter* const pWriter);
+
+/**
+ @brief writes usesTemplate. written before the strokes if it is written before the first stroke, else after them.
+ */
+extern bool CVSSCPlaybackJSONWriterWriteUsesTemplate(CVSSCPlaybackJSONWriter* const pWriter, const bool pUsesTemplate);
+
+/**
+ @return false if the output failed, or the stroke has a coordinate which JSON cannot represent (NaN or infinite).
+ */
+extern bool CVSSCPlaybackJSONWriterWriteStroke(CVSSCPlaybackJSONWriter* const pWriter, const CVSSCPlaybackStroke* const pStroke);
+
+/**
+ @brief closes the document and flushes the output. nothing may be written afterwards.
+ */
+extern bool CVSSCPlaybackJSONWriterFinish(CVSSCPlaybackJSONWriter* const pWriter);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
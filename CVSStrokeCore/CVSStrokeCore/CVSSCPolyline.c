@@ -0,0 +1,252 @@
+// CVSSCPolyline.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "CVSSCMemory.h"
+#include "CVSSCPolyline.h"
+#include "CVSSCRaster.h"
+
+const double CVSSCPolylineFinestTolerance = 1.0 / 32.0;
+
+// the rasterizer's limit
+enum { MaximumCurveSegmentCount = 256 };
+
+// a level is used within half the rasterizer's tolerance: the rasterizer's flattening of the curves is itself up to
+// CVSSCRasterFlatteningTolerance off them, so a level as coarse as that could be twice as far from the components' rendering
+static const double LevelToleranceFraction = 0.5;
+
+// the points and the subpath starts follow the header, in the same allocation
+struct CVSSCPolyline {
+    size_t pointCount;
+    size_t subpathCount;
+    const float* points;
+    const uint32_t* subpathStarts;
+};
+
+double CVSSCPolylineLevelGetTolerance(const CVSSCPolylineLevel pLevel) {
+    assert(0 <= pLevel && pLevel < CVSSCPolylineLevelCount);
+    return ldexp(CVSSCPolylineFinestTolerance, pLevel);
+}
+
+CVSSCPolylineLevel CVSSCPolylineLevelForScale(const double pScale) {
+    if (!(pScale > 0.0)) {
+        return CVSSCPolylineLevelNone;
+    }
+    CVSSCPolylineLevel result = CVSSCPolylineLevelNone;
+    for (CVSSCPolylineLevel level = 0; level < CVSSCPolylineLevelCount; ++level) {
+        if (CVSSCPolylineLevelGetTolerance(level) * pScale <= LevelToleranceFraction * CVSSCRasterFlatteningTolerance) {
+            result = level;
+        }
+    }
+    return result;
+}
+
+#pragma mark - Building
+
+typedef struct {
+    float* points;
+    size_t pointCount;
+    size_t pointCapacity;
+    uint32_t* subpathStarts;
+    size_t subpathCount;
+    size_t subpathCapacity;
+    // the end of the current subpath, before it was rounded to floats
+    CVSSCPoint currentPoint;
+    double tolerance;
+    bool failed;
+} Builder;
+
+static bool Reserve(void** const pMemory, size_t* const pCapacity, const size_t pCount, const size_t pElementSize) {
+    if (pCount <= *pCapacity) {
+        return true;
+    }
+    size_t capacity = *pCapacity ? *pCapacity : 64;
+    while (capacity < pCount) {
+        capacity *= 2;
+    }
+    void* const memory = CVSSCReallocate(*pMemory, capacity * pElementSize);
+    if (!memory) {
+        return false;
+    }
+    *pMemory = memory;
+    *pCapacity = capacity;
+    return true;
+}
+
+static void AddPoint(Builder* const pBuilder, const CVSSCPoint pPoint) {
+    if (pBuilder->failed) {
+        return;
+    }
+    if (!Reserve((void**)&pBuilder->points, &pBuilder->pointCapacity, 2 * (pBuilder->pointCount + 1), sizeof(float))) {
+        pBuilder->failed = true;
+        return;
+    }
+    pBuilder->points[2 * pBuilder->pointCount] = (float)pPoint.x;
+    pBuilder->points[2 * pBuilder->pointCount + 1] = (float)pPoint.y;
+    ++pBuilder->pointCount;
+    pBuilder->currentPoint = pPoint;
+}
+
+static void BeginSubpath(Builder* const pBuilder, const CVSSCPoint pPoint) {
+    if (pBuilder->failed) {
+        return;
+    }
+    if (pBuilder->pointCount > UINT32_MAX || !Reserve((void**)&pBuilder->subpathStarts, &pBuilder->subpathCapacity, pBuilder->subpathCount + 1, sizeof(uint32_t))) {
+        pBuilder->failed = true;
+        return;
+    }
+    pBuilder->subpathStarts[pBuilder->subpathCount++] = (uint32_t)pBuilder->pointCount;
+    AddPoint(pBuilder, pPoint);
+}
+
+static void AddLine(Builder* const pBuilder, const CVSSCPoint pTo) {
+    // a repeated point is kept only to give a dot its second point
+    const size_t subpathLength = pBuilder->pointCount - pBuilder->subpathStarts[pBuilder->subpathCount - 1];
+    if (1 < subpathLength && pTo.x == pBuilder->currentPoint.x && pTo.y == pBuilder->currentPoint.y) {
+        return;
+    }
+    AddPoint(pBuilder, pTo);
+}
+
+// subdivides as the rasterizer does (Wang's formula), within the builder's tolerance
+static void AddCurve(Builder* const pBuilder, const CVSSCPoint p0, const CVSSCPoint p1, const CVSSCPoint p2, const CVSSCPoint p3) {
+    const double ddx = fmax(fabs(p0.x - 2.0 * p1.x + p2.x), fabs(p1.x - 2.0 * p2.x + p3.x));
+    const double ddy = fmax(fabs(p0.y - 2.0 * p1.y + p2.y), fabs(p1.y - 2.0 * p2.y + p3.y));
+    const double segmentCountEstimate = ceil(sqrt(0.75 * sqrt(ddx * ddx + ddy * ddy) / pBuilder->tolerance));
+    const int segmentCount = segmentCountEstimate < 1.0 ? 1 : (segmentCountEstimate > MaximumCurveSegmentCount ? MaximumCurveSegmentCount : (int)segmentCountEstimate);
+    for (int idx = 1; idx <= segmentCount; ++idx) {
+        const double t = (double)idx / segmentCount;
+        const double mt = 1.0 - t;
+        const double w0 = mt * mt * mt;
+        const double w1 = 3.0 * mt * mt * t;
+        const double w2 = 3.0 * mt * t * t;
+        const double w3 = t * t * t;
+        const CVSSCPoint to = idx == segmentCount ? p3 : (CVSSCPoint){
+            w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x,
+            w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y
+        };
+        AddLine(pBuilder, to);
+    }
+}
+
+static bool PointsAreEqual(const CVSSCPoint pA, const CVSSCPoint pB) {
+    return pA.x == pB.x && pA.y == pB.y;
+}
+
+// adds the component to the current subpath if either of its ends is the subpath's end. otherwise it begins a subpath,
+// in the direction which lets the next component join it: components are usually appended newest first, so each one's
+// toPoint is the fromPoint of the one before it, and the chain is traversed from toPoint to fromPoint.
+static void AddComponent(Builder* const pBuilder, const CVSSCComponent* const pComponent, const CVSSCComponent* const pNext) {
+    const bool isCurve = CVSSCComponentTypeCurve == pComponent->type;
+    if (!isCurve && CVSSCComponentTypePoint != pComponent->type) {
+        return;
+    }
+    const bool hasSubpath = 0 != pBuilder->subpathCount;
+    bool isReversed;
+    if (hasSubpath && PointsAreEqual(pComponent->fromPoint, pBuilder->currentPoint)) {
+        isReversed = false;
+    }
+    else if (hasSubpath && PointsAreEqual(pComponent->toPoint, pBuilder->currentPoint)) {
+        isReversed = true;
+    }
+    else {
+        isReversed = NULL != pNext && !PointsAreEqual(pComponent->toPoint, pNext->fromPoint) && !PointsAreEqual(pComponent->toPoint, pNext->toPoint);
+        BeginSubpath(pBuilder, isReversed ? pComponent->toPoint : pComponent->fromPoint);
+    }
+    if (pBuilder->failed) {
+        return;
+    }
+    const CVSSCPoint from = isReversed ? pComponent->toPoint : pComponent->fromPoint;
+    const CVSSCPoint to = isReversed ? pComponent->fromPoint : pComponent->toPoint;
+    if (isCurve) {
+        const CVSSCPoint c1 = isReversed ? pComponent->controlPoint2 : pComponent->controlPoint1;
+        const CVSSCPoint c2 = isReversed ? pComponent->controlPoint1 : pComponent->controlPoint2;
+        AddCurve(pBuilder, from, c1, c2, to);
+    }
+    else {
+        AddLine(pBuilder, to);
+    }
+}
+
+CVSSCPolyline* CVSSCPolylineCreate(const CVSSCComponent* const pComponents, const size_t pCount, const double pTolerance) {
+    assert(pComponents || 0 == pCount);
+    assert(pTolerance > 0.0);
+    Builder builder;
+    memset(&builder, 0, sizeof(builder));
+    builder.tolerance = pTolerance;
+    for (size_t idx = 0; idx < pCount && !builder.failed; ++idx) {
+        AddComponent(&builder, &pComponents[idx], idx + 1 < pCount ? &pComponents[idx + 1] : NULL);
+    }
+    CVSSCPolyline* result = NULL;
+    if (!builder.failed) {
+        const size_t pointsLength = 2 * builder.pointCount * sizeof(float);
+        const size_t startsLength = builder.subpathCount * sizeof(uint32_t);
+        result = CVSSCAllocate(sizeof(CVSSCPolyline) + pointsLength + startsLength);
+        if (result) {
+            float* const points = (float*)(result + 1);
+            uint32_t* const starts = (uint32_t*)((uint8_t*)points + pointsLength);
+            if (pointsLength) {
+                memcpy(points, builder.points, pointsLength);
+            }
+            if (startsLength) {
+                memcpy(starts, builder.subpathStarts, startsLength);
+            }
+            result->pointCount = builder.pointCount;
+            result->subpathCount = builder.subpathCount;
+            result->points = points;
+            result->subpathStarts = starts;
+        }
+    }
+    CVSSCFree(builder.points);
+    CVSSCFree(builder.subpathStarts);
+    return result;
+}
+
+void CVSSCPolylineDestroy(CVSSCPolyline* const pPolyline) {
+    CVSSCFree(pPolyline);
+}
+
+#pragma mark - Access
+
+const float* CVSSCPolylineGetPoints(const CVSSCPolyline* const pPolyline) {
+    assert(pPolyline);
+    return pPolyline->points;
+}
+
+size_t CVSSCPolylineGetPointCount(const CVSSCPolyline* const pPolyline) {
+    assert(pPolyline);
+    return pPolyline->pointCount;
+}
+
+const uint32_t* CVSSCPolylineGetSubpathStarts(const CVSSCPolyline* const pPolyline) {
+    assert(pPolyline);
+    return pPolyline->subpathStarts;
+}
+
+size_t CVSSCPolylineGetSubpathCount(const CVSSCPolyline* const pPolyline) {
+    assert(pPolyline);
+    return pPolyline->subpathCount;
+}
+
+size_t CVSSCPolylineGetByteCount(const CVSSCPolyline* const pPolyline) {
+    assert(pPolyline);
+    return sizeof(CVSSCPolyline) + 2 * pPolyline->pointCount * sizeof(float) + pPolyline->subpathCount * sizeof(uint32_t);
+}
+
+void CVSSCPolylineAddToPathSink(const CVSSCPolyline* const pPolyline, const CVSSCPathSink* const pSink) {
+    assert(pPolyline);
+    assert(pSink);
+    void* const context = pSink->context;
+    const float* const points = pPolyline->points;
+    for (size_t subpath = 0; subpath < pPolyline->subpathCount; ++subpath) {
+        const size_t start = pPolyline->subpathStarts[subpath];
+        const size_t end = subpath + 1 < pPolyline->subpathCount ? pPolyline->subpathStarts[subpath + 1] : pPolyline->pointCount;
+        pSink->moveToPoint(context, (CVSSCPoint){points[2 * start], points[2 * start + 1]});
+        for (size_t idx = start + 1; idx < end; ++idx) {
+            pSink->addLineToPoint(context, (CVSSCPoint){points[2 * idx], points[2 * idx + 1]});
+        }
+    }
+}
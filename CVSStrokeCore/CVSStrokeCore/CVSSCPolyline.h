@@ -0,0 +1,96 @@
+// CVSSCPolyline.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCPolyline_h
+#define CVSStrokeCore_CVSSCPolyline_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CVSSCComponent.h"
+#include "CVSSCGeometry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ A stroke's path flattened to polylines within a tolerance: a level of detail of the stroke, which a renderer strokes
+ without subdividing curves.
+
+ There are a few levels, each twice as coarse as the last. A renderer uses the coarsest level which is visually exact at
+ its scale -- within half of CVSSCRasterFlatteningTolerance device pixels of the curves, so it is always finer than the
+ rasterizer's own flattening of them -- so a zoomed out canvas or a thumbnail strokes far fewer segments, and a deep zoom
+ falls back to the curves. The chosen level has between sqrt(2) and 2 times the segments the rasterizer would flatten the
+ curves to at that scale; it saves the subdivision, not segments.
+
+ The components of a stroke are connected, usually newest first (each component's toPoint is the fromPoint of the one
+ before it), so the polyline joins them into subpaths, traversing a component backwards where that continues the subpath,
+ rather than keeping a subpath per component. The path is stroked with round caps and
+ joins, so the shape is the same. Points are floats, 8 bytes per point, in one allocation.
+ */
+
+/**
+ @brief a level of detail. level 0 is the finest.
+ */
+typedef int32_t CVSSCPolylineLevel;
+
+enum {
+    /** @brief no level is exact at the scale: render the curves */
+    CVSSCPolylineLevelNone = -1,
+    CVSSCPolylineLevelCount = 7
+};
+
+/**
+ @brief the tolerance of level 0, in user space units (points)
+ */
+extern const double CVSSCPolylineFinestTolerance;
+
+/**
+ @return the tolerance of the level, in user space units: CVSSCPolylineFinestTolerance * 2^level.
+ */
+extern double CVSSCPolylineLevelGetTolerance(const CVSSCPolylineLevel pLevel);
+
+/**
+ @return the coarsest level whose tolerance is within half of CVSSCRasterFlatteningTolerance device pixels at @p pScale device
+ pixels per unit, or CVSSCPolylineLevelNone if even the finest level is not.
+ */
+extern CVSSCPolylineLevel CVSSCPolylineLevelForScale(const double pScale);
+
+typedef struct CVSSCPolyline CVSSCPolyline;
+
+/**
+ @return the components flattened within @p pTolerance (curves are subdivided as the rasterizer subdivides them), or NULL if
+ memory could not be allocated. destroy using CVSSCPolylineDestroy.
+ */
+extern CVSSCPolyline* CVSSCPolylineCreate(const CVSSCComponent* const pComponents, const size_t pCount, const double pTolerance);
+extern void CVSSCPolylineDestroy(CVSSCPolyline* const pPolyline);
+
+/**
+ @return the points of every subpath, as x, y pairs. subpath i is the points from its start to the next subpath's start.
+ */
+extern const float* CVSSCPolylineGetPoints(const CVSSCPolyline* const pPolyline);
+extern size_t CVSSCPolylineGetPointCount(const CVSSCPolyline* const pPolyline);
+
+/**
+ @return the index of the first point of each subpath. every subpath has at least two points (a dot repeats its point).
+ */
+extern const uint32_t* CVSSCPolylineGetSubpathStarts(const CVSSCPolyline* const pPolyline);
+extern size_t CVSSCPolylineGetSubpathCount(const CVSSCPolyline* const pPolyline);
+
+/**
+ @return the bytes the polyline occupies, for memory budgets
+ */
+extern size_t CVSSCPolylineGetByteCount(const CVSSCPolyline* const pPolyline);
+
+/**
+ @brief adds the subpaths to the sink (move to, then lines). the sink's addCurveToPoint is not called.
+ */
+extern void CVSSCPolylineAddToPathSink(const CVSSCPolyline* const pPolyline, const CVSSCPathSink* const pSink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
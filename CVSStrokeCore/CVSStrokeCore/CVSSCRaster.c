@@ -0,0 +1,420 @@
+// CVSSCRaster.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "CVSSCMemory.h"
+#include "CVSSCRaster.h"
+#include "CVSSCSpan.h"
+
+const double CVSSCRasterFlatteningTolerance = 0.25;
+
+// the most segments a single curve is flattened to
+enum { MaximumCurveSegmentCount = 256 };
+
+typedef struct {
+    double x0;
+    double y0;
+    double x1;
+    double y1;
+} Segment;
+
+// maxX == 0 means the row is untouched
+typedef struct {
+    int32_t minX;
+    int32_t maxX;
+} RowExtent;
+
+struct CVSSCRasterizer {
+    // flattened device space segments of the current stroke
+    Segment* segments;
+    size_t segmentCount;
+    size_t segmentCapacity;
+    // coverage of the current stroke, one byte per pixel of maskRect
+    uint8_t* mask;
+    size_t maskCapacity;
+    CVSSCPixelRect maskRect;
+    // the touched columns of each mask row
+    RowExtent* rows;
+    size_t rowCapacity;
+    // state of the path sink
+    const CVSSCTransform* transform;
+    CVSSCPoint currentPoint;
+    bool failed;
+};
+
+#pragma mark - Scratch
+
+static bool Reserve(void** const pMemory, size_t* const pCapacity, const size_t pCount, const size_t pElementSize) {
+    if (pCount <= *pCapacity) {
+        return true;
+    }
+    size_t capacity = *pCapacity ? *pCapacity : 64;
+    while (capacity < pCount) {
+        capacity *= 2;
+    }
+    void* const memory = CVSSCReallocate(*pMemory, capacity * pElementSize);
+    if (!memory) {
+        return false;
+    }
+    *pMemory = memory;
+    *pCapacity = capacity;
+    return true;
+}
+
+CVSSCRasterizer* CVSSCRasterizerCreate(void) {
+    CVSSCRasterizer* const result = CVSSCAllocate(sizeof(CVSSCRasterizer));
+    if (result) {
+        memset(result, 0, sizeof(CVSSCRasterizer));
+    }
+    return result;
+}
+
+void CVSSCRasterizerDestroy(CVSSCRasterizer* const pRasterizer) {
+    if (!pRasterizer) {
+        return;
+    }
+    CVSSCFree(pRasterizer->segments);
+    CVSSCFree(pRasterizer->mask);
+    CVSSCFree(pRasterizer->rows);
+    CVSSCFree(pRasterizer);
+}
+
+#pragma mark - Flattening
+
+static void AddSegment(CVSSCRasterizer* const pRasterizer, const CVSSCPoint pFrom, const CVSSCPoint pTo) {
+    if (pRasterizer->failed) {
+        return;
+    }
+    if (!Reserve((void**)&pRasterizer->segments, &pRasterizer->segmentCapacity, pRasterizer->segmentCount + 1, sizeof(Segment))) {
+        pRasterizer->failed = true;
+        return;
+    }
+    const Segment segment = {pFrom.x, pFrom.y, pTo.x, pTo.y};
+    pRasterizer->segments[pRasterizer->segmentCount++] = segment;
+}
+
+static void SinkMoveToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    CVSSCRasterizer* const rasterizer = pContext;
+    rasterizer->currentPoint = CVSSCTransformApplyToPoint(rasterizer->transform, pPoint);
+}
+
+static void SinkAddLineToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    CVSSCRasterizer* const rasterizer = pContext;
+    const CVSSCPoint to = CVSSCTransformApplyToPoint(rasterizer->transform, pPoint);
+    AddSegment(rasterizer, rasterizer->currentPoint, to);
+    rasterizer->currentPoint = to;
+}
+
+static void SinkAddCurveToPoint(void* const pContext, const CVSSCPoint pControlPoint1, const CVSSCPoint pControlPoint2, const CVSSCPoint pPoint) {
+    CVSSCRasterizer* const rasterizer = pContext;
+    const CVSSCPoint p0 = rasterizer->currentPoint;
+    const CVSSCPoint p1 = CVSSCTransformApplyToPoint(rasterizer->transform, pControlPoint1);
+    const CVSSCPoint p2 = CVSSCTransformApplyToPoint(rasterizer->transform, pControlPoint2);
+    const CVSSCPoint p3 = CVSSCTransformApplyToPoint(rasterizer->transform, pPoint);
+    // Wang's formula: the segment count which keeps the flattened curve within the tolerance
+    const double ddx = fmax(fabs(p0.x - 2.0 * p1.x + p2.x), fabs(p1.x - 2.0 * p2.x + p3.x));
+    const double ddy = fmax(fabs(p0.y - 2.0 * p1.y + p2.y), fabs(p1.y - 2.0 * p2.y + p3.y));
+    const double segmentCountEstimate = ceil(sqrt(0.75 * sqrt(ddx * ddx + ddy * ddy) / CVSSCRasterFlatteningTolerance));
+    const int segmentCount = segmentCountEstimate < 1.0 ? 1 : (segmentCountEstimate > MaximumCurveSegmentCount ? MaximumCurveSegmentCount : (int)segmentCountEstimate);
+    CVSSCPoint from = p0;
+    for (int idx = 1; idx <= segmentCount; ++idx) {
+        const double t = (double)idx / segmentCount;
+        const double mt = 1.0 - t;
+        const double w0 = mt * mt * mt;
+        const double w1 = 3.0 * mt * mt * t;
+        const double w2 = 3.0 * mt * t * t;
+        const double w3 = t * t * t;
+        const CVSSCPoint to = idx == segmentCount ? p3 : (CVSSCPoint){
+            w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x,
+            w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y
+        };
+        AddSegment(rasterizer, from, to);
+        from = to;
+    }
+    rasterizer->currentPoint = p3;
+}
+
+#pragma mark - Coverage
+
+static inline uint8_t CoverageFromSignedDistance(const double pSignedDistance) {
+    const double coverage = 0.5 - pSignedDistance;
+    if (coverage <= 0.0) {
+        return 0;
+    }
+    if (coverage >= 1.0) {
+        return 255;
+    }
+    return (uint8_t)(coverage * 255.0 + 0.5);
+}
+
+// the signed distance from the point to the capsule (a round capped segment) of radius pRadius
+static inline double CapsuleSignedDistance(const Segment* const pSegment, const double pLengthSquared, const double pX, const double pY, const double pRadius) {
+    const double dx = pSegment->x1 - pSegment->x0;
+    const double dy = pSegment->y1 - pSegment->y0;
+    const double px = pX - pSegment->x0;
+    const double py = pY - pSegment->y0;
+    double t = pLengthSquared > 0.0 ? (px * dx + py * dy) / pLengthSquared : 0.0;
+    t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+    const double ex = px - t * dx;
+    const double ey = py - t * dy;
+    return sqrt(ex * ex + ey * ey) - pRadius;
+}
+
+// the signed distance from the point to the box of a square capped segment of radius pRadius
+static inline double BoxSignedDistance(const Segment* const pSegment, const double pLength, const double pX, const double pY, const double pRadius) {
+    // a degenerate segment is an axis aligned square
+    const double ux = pLength > 0.0 ? (pSegment->x1 - pSegment->x0) / pLength : 1.0;
+    const double uy = pLength > 0.0 ? (pSegment->y1 - pSegment->y0) / pLength : 0.0;
+    const double cx = 0.5 * (pSegment->x0 + pSegment->x1);
+    const double cy = 0.5 * (pSegment->y0 + pSegment->y1);
+    const double px = pX - cx;
+    const double py = pY - cy;
+    const double along = fabs(px * ux + py * uy) - (0.5 * pLength + pRadius);
+    const double across = fabs(py * ux - px * uy) - pRadius;
+    const double outsideX = fmax(along, 0.0);
+    const double outsideY = fmax(across, 0.0);
+    return sqrt(outsideX * outsideX + outsideY * outsideY) + fmin(fmax(along, across), 0.0);
+}
+
+// narrows [*pMin, *pMax] to the x for which pOffset + pSlope * x is within [pLower, pUpper]
+static inline void ClipIntervalLinear(double* const pMin, double* const pMax, const double pOffset, const double pSlope, const double pLower, const double pUpper) {
+    if (fabs(pSlope) < 1.0e-12) {
+        if (pOffset < pLower || pOffset > pUpper) {
+            *pMax = -INFINITY;
+        }
+        return;
+    }
+    const double a = (pLower - pOffset) / pSlope;
+    const double b = (pUpper - pOffset) / pSlope;
+    *pMin = fmax(*pMin, fmin(a, b));
+    *pMax = fmin(*pMax, fmax(a, b));
+}
+
+static inline void UnionIntervalDisk(double* const pMin, double* const pMax, const double pX, const double pY, const double pRadius, const double pRowY) {
+    const double dy = pRowY - pY;
+    const double squared = pRadius * pRadius - dy * dy;
+    if (squared < 0.0) {
+        return;
+    }
+    const double half = sqrt(squared);
+    *pMin = fmin(*pMin, pX - half);
+    *pMax = fmax(*pMax, pX + half);
+}
+
+// the interval of x where (x, pRowY) is within pRadius of the segment (round), or within its box extended by pRadius (square).
+// both shapes are convex, so the interval is the union of the shape's pieces.
+static bool SegmentRowInterval(const Segment* const pSegment, const double pUX, const double pUY, const double pLength, const double pRadius, const bool pSquare, const double pRowY, double* const pOutMin, double* const pOutMax) {
+    const double ry = pRowY - pSegment->y0;
+    double bandMin = -INFINITY, bandMax = INFINITY;
+    const double alongMin = pSquare ? -pRadius : 0.0;
+    const double alongMax = pSquare ? pLength + pRadius : pLength;
+    ClipIntervalLinear(&bandMin, &bandMax, -pSegment->x0 * pUX + ry * pUY, pUX, alongMin, alongMax);
+    ClipIntervalLinear(&bandMin, &bandMax, pSegment->x0 * pUY + ry * pUX, -pUY, -pRadius, pRadius);
+    double resultMin = INFINITY, resultMax = -INFINITY;
+    if (bandMin <= bandMax) {
+        resultMin = bandMin;
+        resultMax = bandMax;
+    }
+    if (!pSquare) {
+        UnionIntervalDisk(&resultMin, &resultMax, pSegment->x0, pSegment->y0, pRadius, pRowY);
+        UnionIntervalDisk(&resultMin, &resultMax, pSegment->x1, pSegment->y1, pRadius, pRowY);
+    }
+    *pOutMin = resultMin;
+    *pOutMax = resultMax;
+    return resultMin <= resultMax;
+}
+
+static void AccumulateSegment(CVSSCRasterizer* const pRasterizer, const Segment* const pSegment, const double pRadius, const bool pSquare) {
+    const CVSSCPixelRect maskRect = pRasterizer->maskRect;
+    // the square cap's box extends by at most radius * sqrt(2) beyond the end points
+    const double reach = pRadius * (pSquare ? 1.5 : 1.0) + 1.0;
+    const int32_t minY = (int32_t)fmax(floor(fmin(pSegment->y0, pSegment->y1) - reach), maskRect.minY);
+    const int32_t maxY = (int32_t)fmin(ceil(fmax(pSegment->y0, pSegment->y1) + reach), maskRect.maxY);
+    // a segment beside the mask (e.g. of a stroke which crosses a tile's clip) has no rows to visit
+    if (minY >= maxY || floor(fmin(pSegment->x0, pSegment->x1) - reach) >= maskRect.maxX || ceil(fmax(pSegment->x0, pSegment->x1) + reach) <= maskRect.minX) {
+        return;
+    }
+    const double dx = pSegment->x1 - pSegment->x0;
+    const double dy = pSegment->y1 - pSegment->y0;
+    const double lengthSquared = dx * dx + dy * dy;
+    const double length = sqrt(lengthSquared);
+    // a degenerate segment is oriented along x
+    const double ux = length > 0.0 ? dx / length : 1.0;
+    const double uy = length > 0.0 ? dy / length : 0.0;
+    const size_t maskWidth = (size_t)(maskRect.maxX - maskRect.minX);
+    for (int32_t y = minY; y < maxY; ++y) {
+        const double sampleY = y + 0.5;
+        // pixels whose centers are within the outer interval have coverage. those within the inner interval are covered.
+        double outerMin, outerMax;
+        if (!SegmentRowInterval(pSegment, ux, uy, length, pRadius + 0.5, pSquare, sampleY, &outerMin, &outerMax)) {
+            continue;
+        }
+        double innerMin = INFINITY, innerMax = -INFINITY;
+        if (pRadius > 0.5) {
+            SegmentRowInterval(pSegment, ux, uy, length, pRadius - 0.5, pSquare, sampleY, &innerMin, &innerMax);
+        }
+        const int32_t minX = (int32_t)fmax(ceil(outerMin - 0.5), maskRect.minX);
+        const int32_t maxX = (int32_t)fmin(floor(outerMax - 0.5) + 1.0, maskRect.maxX);
+        if (minX >= maxX) {
+            continue;
+        }
+        const int32_t coveredMinX = (int32_t)fmax(ceil(innerMin - 0.5), minX);
+        const int32_t coveredMaxX = (int32_t)fmin(floor(innerMax - 0.5) + 1.0, maxX);
+        const size_t row = (size_t)(y - maskRect.minY);
+        uint8_t* const maskRow = pRasterizer->mask + row * maskWidth - maskRect.minX;
+        for (int32_t x = minX; x < maxX; ++x) {
+            if (x >= coveredMinX && x < coveredMaxX) {
+                memset(&maskRow[x], 255, (size_t)(coveredMaxX - x));
+                x = coveredMaxX - 1;
+                continue;
+            }
+            if (255 == maskRow[x]) {
+                continue;
+            }
+            const double sampleX = x + 0.5;
+            const double signedDistance = pSquare ? BoxSignedDistance(pSegment, length, sampleX, sampleY, pRadius) : CapsuleSignedDistance(pSegment, lengthSquared, sampleX, sampleY, pRadius);
+            const uint8_t coverage = CoverageFromSignedDistance(signedDistance);
+            if (coverage > maskRow[x]) {
+                maskRow[x] = coverage;
+            }
+        }
+        RowExtent* const extent = &pRasterizer->rows[row];
+        if (0 == extent->maxX || minX < extent->minX) {
+            extent->minX = minX;
+        }
+        if (maxX > extent->maxX) {
+            extent->maxX = maxX;
+        }
+    }
+}
+
+#pragma mark - Rendering
+
+static inline uint8_t ColorComponentToByte(const double pValue) {
+    const double clamped = pValue < 0.0 ? 0.0 : (pValue > 1.0 ? 1.0 : pValue);
+    return (uint8_t)(clamped * 255.0 + 0.5);
+}
+
+// renders the flattened segments as one path: their coverage is accumulated in one mask, which is blended once
+static bool RenderFlattened(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor) {
+    if (pRasterizer->failed) {
+        return false;
+    }
+    if (0 == pRasterizer->segmentCount) {
+        return true;
+    }
+
+    // the mask covers the segments' bounds within the clip
+    const double radius = 0.5 * pBrush->lineWidth * CVSSCTransformGetScale(pTransform);
+    const bool square = CVSSCLineCapSquare == pBrush->lineCap;
+    const double reach = radius * (square ? 1.5 : 1.0) + 1.0;
+    double minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    for (size_t idx = 0; idx < pRasterizer->segmentCount; ++idx) {
+        const Segment* const at = &pRasterizer->segments[idx];
+        minX = fmin(minX, fmin(at->x0, at->x1));
+        minY = fmin(minY, fmin(at->y0, at->y1));
+        maxX = fmax(maxX, fmax(at->x0, at->x1));
+        maxY = fmax(maxY, fmax(at->y0, at->y1));
+    }
+    const CVSSCPixelRect limit = CVSSCPixelRectIntersection(pClip, CVSSCBitmapGetPixelRect(pBitmap));
+    if (CVSSCPixelRectIsEmpty(limit) || !isfinite(minX) || !isfinite(minY) || !isfinite(maxX) || !isfinite(maxY)) {
+        return true;
+    }
+    const CVSSCPixelRect strokeRect = {
+        (int32_t)fmax(floor(minX - reach), limit.minX),
+        (int32_t)fmax(floor(minY - reach), limit.minY),
+        (int32_t)fmin(ceil(maxX + reach), limit.maxX),
+        (int32_t)fmin(ceil(maxY + reach), limit.maxY)
+    };
+    const CVSSCPixelRect maskRect = CVSSCPixelRectIntersection(strokeRect, limit);
+    if (CVSSCPixelRectIsEmpty(maskRect)) {
+        return true;
+    }
+    const size_t maskWidth = (size_t)(maskRect.maxX - maskRect.minX);
+    const size_t maskHeight = (size_t)(maskRect.maxY - maskRect.minY);
+    if (!Reserve((void**)&pRasterizer->mask, &pRasterizer->maskCapacity, maskWidth * maskHeight, sizeof(uint8_t))) {
+        return false;
+    }
+    if (!Reserve((void**)&pRasterizer->rows, &pRasterizer->rowCapacity, maskHeight, sizeof(RowExtent))) {
+        return false;
+    }
+    memset(pRasterizer->mask, 0, maskWidth * maskHeight);
+    memset(pRasterizer->rows, 0, maskHeight * sizeof(RowExtent));
+    pRasterizer->maskRect = maskRect;
+
+    // coverage
+    for (size_t idx = 0; idx < pRasterizer->segmentCount; ++idx) {
+        AccumulateSegment(pRasterizer, &pRasterizer->segments[idx], radius, square);
+    }
+
+    // blend
+    const CVSSCSpanPaint paint = {
+        ColorComponentToByte(pColor.red),
+        ColorComponentToByte(pColor.green),
+        ColorComponentToByte(pColor.blue),
+        ColorComponentToByte(pColor.alpha * pBrush->alpha)
+    };
+    for (size_t row = 0; row < maskHeight; ++row) {
+        const int32_t rowMinX = pRasterizer->rows[row].minX;
+        const int32_t rowMaxX = pRasterizer->rows[row].maxX;
+        if (0 == rowMaxX) {
+            continue;
+        }
+        const uint8_t* const coverage = pRasterizer->mask + row * maskWidth + (size_t)(rowMinX - maskRect.minX);
+        uint8_t* const pixels = CVSSCBitmapGetPixel(pBitmap, (uint32_t)rowMinX, (uint32_t)(maskRect.minY + (int32_t)row));
+        const size_t count = (size_t)(rowMaxX - rowMinX);
+        if (pBrush->clears) {
+            CVSSCSpanBlendClear(pixels, coverage, count);
+        }
+        else {
+            CVSSCSpanBlendNormal(pixels, coverage, count, paint);
+        }
+    }
+    return true;
+}
+
+static void BeginFlattening(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCBrushAttributes* const pBrush) {
+    assert(pRasterizer);
+    assert(pBitmap);
+    assert(pTransform);
+    assert(pBrush);
+    pRasterizer->segmentCount = 0;
+    pRasterizer->transform = pTransform;
+    pRasterizer->failed = false;
+}
+
+static bool RenderStrokes(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCComponent* const* const pComponents, const size_t* const pCounts, const size_t pStrokeCount) {
+    BeginFlattening(pRasterizer, pBitmap, pTransform, pBrush);
+    const CVSSCPathSink sink = {pRasterizer, SinkMoveToPoint, SinkAddLineToPoint, SinkAddCurveToPoint};
+    for (size_t idx = 0; idx < pStrokeCount; ++idx) {
+        assert(pComponents[idx] || 0 == pCounts[idx]);
+        CVSSCComponentsAddToPathSink(pComponents[idx], pCounts[idx], &sink);
+    }
+    pRasterizer->transform = NULL;
+    return RenderFlattened(pRasterizer, pBitmap, pTransform, pClip, pBrush, pColor);
+}
+
+bool CVSSCRasterizerRenderStroke(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCComponent* const pComponents, const size_t pCount) {
+    return RenderStrokes(pRasterizer, pBitmap, pTransform, pClip, pBrush, pColor, &pComponents, &pCount, 1);
+}
+
+bool CVSSCRasterizerRenderStrokes(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCComponent* const* const pComponents, const size_t* const pCounts, const size_t pStrokeCount) {
+    assert(pComponents || 0 == pStrokeCount);
+    assert(pCounts || 0 == pStrokeCount);
+    return RenderStrokes(pRasterizer, pBitmap, pTransform, pClip, pBrush, pColor, pComponents, pCounts, pStrokeCount);
+}
+
+bool CVSSCRasterizerRenderPolylines(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCPolyline* const* const pPolylines, const size_t pCount) {
+    assert(pPolylines || 0 == pCount);
+    BeginFlattening(pRasterizer, pBitmap, pTransform, pBrush);
+    // the polylines have no curves: only their points are transformed
+    const CVSSCPathSink sink = {pRasterizer, SinkMoveToPoint, SinkAddLineToPoint, SinkAddCurveToPoint};
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        CVSSCPolylineAddToPathSink(pPolylines[idx], &sink);
+    }
+    pRasterizer->transform = NULL;
+    return RenderFlattened(pRasterizer, pBitmap, pTransform, pClip, pBrush, pColor);
+}
@@ -0,0 +1,79 @@
+// CVSSCRaster.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCRaster_h
+#define CVSStrokeCore_CVSSCRaster_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "CVSSCBitmap.h"
+#include "CVSSCBrush.h"
+#include "CVSSCColor.h"
+#include "CVSSCComponent.h"
+#include "CVSSCGeometry.h"
+#include "CVSSCPolyline.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ A software stroke rasterizer -- the alternative to stroking through CoreGraphics.
+
+ Each stroke's components are transformed to device space and flattened (curves within CVSSCRasterFlatteningTolerance
+ pixels). Every flattened segment is a capsule (round caps) or an extended box (square caps) of the brush's width, so
+ joins are round. The coverage of all of a stroke's segments is accumulated (max) in a mask before it is blended, so a
+ stroke which overlaps itself is blended once -- as it is when CG strokes a path.
+ */
+
+/**
+ @brief the maximum distance in device pixels between a curve and its flattened segments
+ */
+extern const double CVSSCRasterFlatteningTolerance;
+
+/**
+ @brief holds the rasterizer's scratch memory, which is reused from stroke to stroke. not thread safe; use one per thread.
+ */
+typedef struct CVSSCRasterizer CVSSCRasterizer;
+
+/**
+ @return a new rasterizer, or NULL if memory could not be allocated. destroy it with CVSSCRasterizerDestroy.
+ */
+extern CVSSCRasterizer* CVSSCRasterizerCreate(void);
+extern void CVSSCRasterizerDestroy(CVSSCRasterizer* const pRasterizer);
+
+/**
+ @brief renders one stroke into the bitmap.
+ @param pTransform maps the components' (user space) coordinates to the bitmap's pixels, where row 0 is the top row.
+ @param pClip the pixels which may be modified. it is clipped to the bitmap.
+ @param pBrush the brush's width, cap, alpha and blend mode. brushes which clear ignore the color. the stamp is ignored:
+ the strokes of stamped brushes are rendered by CVSSCStamperRenderStroke.
+ @return false if scratch memory could not be allocated (the bitmap is not modified).
+ */
+extern bool CVSSCRasterizerRenderStroke(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCComponent* const pComponents, const size_t pCount);
+
+/**
+ @brief renders the strokes into the bitmap as one path: where they overlap, they are blended once. the parameters are
+ those of CVSSCRasterizerRenderStroke, for each stroke.
+ @details use this to render a batch of strokes of the same brush and color (see CVSSCStrokeBatch.h), as CG does when
+ their components are added to one path.
+ @param pComponents the components of each stroke.
+ @param pCounts the component count of each stroke.
+ @return false if scratch memory could not be allocated (the bitmap is not modified).
+ */
+extern bool CVSSCRasterizerRenderStrokes(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCComponent* const* const pComponents, const size_t* const pCounts, const size_t pStrokeCount);
+
+/**
+ @brief renders the polylines into the bitmap as one path, as CVSSCRasterizerRenderStrokes renders strokes. the curves were
+ flattened when the polylines were created, so this only transforms their points.
+ @details use a level of detail which is exact at the transform's scale (CVSSCPolylineLevelForScale).
+ @return false if scratch memory could not be allocated (the bitmap is not modified).
+ */
+extern bool CVSSCRasterizerRenderPolylines(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCPolyline* const* const pPolylines, const size_t pCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,318 @@
+// CVSSCRenderCost.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include "CVSSCGeometry.h"
+#include "CVSSCRaster.h"
+#include "CVSSCRenderCost.h"
+
+// the rasterizer's limit, so that the segment count is the rasterizer's
+enum { MaximumCurveSegmentCount = 256 };
+
+// the coefficients, in the order of a sample's row
+enum {
+    CoefficientPerStroke = 0,
+    CoefficientPerSegment,
+    CoefficientPerRow,
+    CoefficientPerSweptPixel,
+    CoefficientPerBoundsPixel,
+    CoefficientCount = CoefficientPerBoundsPixel + CVSSCRenderCostBlendCount
+};
+
+// fitted by CVSSCRenderCostCalibration.c (-s 2) with the software rasterizer. the fixed and swept costs are within the others.
+const CVSSCRenderCostModel CVSSCRenderCostDefaultModel = {
+    .perStroke = 0.0,
+    .perSegment = 2.7754e-07,
+    .perRow = 1.1778e-07,
+    .perSweptPixel = 0.0,
+    .perBoundsPixel = {1.0791e-10, 1.7665e-10, 1.6246e-10}
+};
+
+const double CVSSCFrameBudgetDefaultDuration = 0.5 / 60.0;
+
+#pragma mark - Features
+
+// the flattened segments are counted, not stored. coordinates are device pixels.
+typedef struct {
+    double scale;
+    // the brush's width, and the clip inflated by half of it: segments outside of it are not rendered
+    double width;
+    double minX, minY, maxX, maxY;
+    CVSSCPoint currentPoint;
+    CVSSCRenderCostFeatures* features;
+} Flattening;
+
+static void AddSegment(Flattening* const pFlattening, const CVSSCPoint pFrom, const CVSSCPoint pTo) {
+    const double minY = fmax(fmin(pFrom.y, pTo.y), pFlattening->minY);
+    const double maxY = fmin(fmax(pFrom.y, pTo.y), pFlattening->maxY);
+    if (minY > maxY || fmin(pFrom.x, pTo.x) > pFlattening->maxX || fmax(pFrom.x, pTo.x) < pFlattening->minX) {
+        return;
+    }
+    CVSSCRenderCostFeatures* const features = pFlattening->features;
+    features->segmentCount += 1.0;
+    features->rowCount += maxY - minY + pFlattening->width;
+    features->sweptArea += (CVSSCPointDistance(pFrom, pTo) + pFlattening->width) * pFlattening->width;
+}
+
+static void SinkMoveToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    Flattening* const flattening = pContext;
+    flattening->currentPoint = (CVSSCPoint){pPoint.x * flattening->scale, pPoint.y * flattening->scale};
+}
+
+static void SinkAddLineToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    Flattening* const flattening = pContext;
+    const CVSSCPoint to = {pPoint.x * flattening->scale, pPoint.y * flattening->scale};
+    AddSegment(flattening, flattening->currentPoint, to);
+    flattening->currentPoint = to;
+}
+
+// flattens as the rasterizer does (Wang's formula)
+static void SinkAddCurveToPoint(void* const pContext, const CVSSCPoint pControlPoint1, const CVSSCPoint pControlPoint2, const CVSSCPoint pPoint) {
+    Flattening* const flattening = pContext;
+    const double scale = flattening->scale;
+    const CVSSCPoint p0 = flattening->currentPoint;
+    const CVSSCPoint p1 = {pControlPoint1.x * scale, pControlPoint1.y * scale};
+    const CVSSCPoint p2 = {pControlPoint2.x * scale, pControlPoint2.y * scale};
+    const CVSSCPoint p3 = {pPoint.x * scale, pPoint.y * scale};
+    const double ddx = fmax(fabs(p0.x - 2.0 * p1.x + p2.x), fabs(p1.x - 2.0 * p2.x + p3.x));
+    const double ddy = fmax(fabs(p0.y - 2.0 * p1.y + p2.y), fabs(p1.y - 2.0 * p2.y + p3.y));
+    const double segmentCountEstimate = ceil(sqrt(0.75 * sqrt(ddx * ddx + ddy * ddy) / CVSSCRasterFlatteningTolerance));
+    const int segmentCount = !(segmentCountEstimate >= 1.0) ? 1 : (segmentCountEstimate > MaximumCurveSegmentCount ? MaximumCurveSegmentCount : (int)segmentCountEstimate);
+    CVSSCPoint from = p0;
+    for (int idx = 1; idx <= segmentCount; ++idx) {
+        const double t = (double)idx / segmentCount;
+        const double mt = 1.0 - t;
+        const double w0 = mt * mt * mt;
+        const double w1 = 3.0 * mt * mt * t;
+        const double w2 = 3.0 * mt * t * t;
+        const double w3 = t * t * t;
+        const CVSSCPoint to = idx == segmentCount ? p3 : (CVSSCPoint){
+            w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x,
+            w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y
+        };
+        AddSegment(flattening, from, to);
+        from = to;
+    }
+    flattening->currentPoint = p3;
+}
+
+CVSSCRenderCostFeatures CVSSCRenderCostGetFeatures(const CVSSCBrushAttributes* const pBrush, const CVSSCComponent* const pComponents, const size_t pCount, const double pScale, const CVSSCRect pClip) {
+    assert(pBrush);
+    assert(pComponents || 0 == pCount);
+    assert(pScale > 0.0);
+    CVSSCRenderCostFeatures result = {
+        .blend = pBrush->clears ? CVSSCRenderCostBlendClear : (pBrush->alpha < 1.0 ? CVSSCRenderCostBlendTranslucent : CVSSCRenderCostBlendOpaque),
+        .segmentCount = 0.0,
+        .rowCount = 0.0,
+        .sweptArea = 0.0,
+        .boundsArea = 0.0
+    };
+    const double width = pBrush->lineWidth * pScale;
+    const Flattening flattening = {
+        .scale = pScale,
+        .width = width,
+        .minX = pClip.x * pScale - 0.5 * width,
+        .minY = pClip.y * pScale - 0.5 * width,
+        .maxX = (pClip.x + pClip.width) * pScale + 0.5 * width,
+        .maxY = (pClip.y + pClip.height) * pScale + 0.5 * width,
+        .currentPoint = {0.0, 0.0},
+        .features = &result
+    };
+    const CVSSCPathSink sink = {(void*)&flattening, SinkMoveToPoint, SinkAddLineToPoint, SinkAddCurveToPoint};
+    CVSSCComponentsAddToPathSink(pComponents, pCount, &sink);
+    const CVSSCRect bounds = CVSSCComponentsGetStrokeBounds(pComponents, pCount, pBrush->lineWidth);
+    if (!CVSSCRectIsNull(bounds)) {
+        const double boundsWidth = fmin(bounds.x + bounds.width, pClip.x + pClip.width) - fmax(bounds.x, pClip.x);
+        const double boundsHeight = fmin(bounds.y + bounds.height, pClip.y + pClip.height) - fmax(bounds.y, pClip.y);
+        result.boundsArea = boundsWidth > 0.0 && boundsHeight > 0.0 ? boundsWidth * boundsHeight * pScale * pScale : 0.0;
+    }
+    return result;
+}
+
+#pragma mark - Estimate
+
+// the row of a sample with the features. the model's estimate is the dot product of the row and the coefficients.
+static void GetRow(const CVSSCRenderCostFeatures* const pFeatures, double* const pRow) {
+    for (int idx = 0; idx < CoefficientCount; ++idx) {
+        pRow[idx] = 0.0;
+    }
+    pRow[CoefficientPerStroke] = 1.0;
+    pRow[CoefficientPerSegment] = pFeatures->segmentCount;
+    pRow[CoefficientPerRow] = pFeatures->rowCount;
+    pRow[CoefficientPerSweptPixel] = pFeatures->sweptArea;
+    pRow[CoefficientPerBoundsPixel + pFeatures->blend] = pFeatures->boundsArea;
+}
+
+static void GetCoefficients(const CVSSCRenderCostModel* const pModel, double* const pCoefficients) {
+    pCoefficients[CoefficientPerStroke] = pModel->perStroke;
+    pCoefficients[CoefficientPerSegment] = pModel->perSegment;
+    pCoefficients[CoefficientPerRow] = pModel->perRow;
+    pCoefficients[CoefficientPerSweptPixel] = pModel->perSweptPixel;
+    for (int blend = 0; blend < CVSSCRenderCostBlendCount; ++blend) {
+        pCoefficients[CoefficientPerBoundsPixel + blend] = pModel->perBoundsPixel[blend];
+    }
+}
+
+static void SetCoefficients(CVSSCRenderCostModel* const pModel, const double* const pCoefficients) {
+    pModel->perStroke = pCoefficients[CoefficientPerStroke];
+    pModel->perSegment = pCoefficients[CoefficientPerSegment];
+    pModel->perRow = pCoefficients[CoefficientPerRow];
+    pModel->perSweptPixel = pCoefficients[CoefficientPerSweptPixel];
+    for (int blend = 0; blend < CVSSCRenderCostBlendCount; ++blend) {
+        pModel->perBoundsPixel[blend] = pCoefficients[CoefficientPerBoundsPixel + blend];
+    }
+}
+
+double CVSSCRenderCostEstimate(const CVSSCRenderCostModel* const pModel, const CVSSCRenderCostFeatures* const pFeatures) {
+    assert(pModel);
+    assert(pFeatures);
+    assert(CVSSCRenderCostBlendCount > pFeatures->blend);
+    double row[CoefficientCount];
+    double coefficients[CoefficientCount];
+    GetRow(pFeatures, row);
+    GetCoefficients(pModel, coefficients);
+    double result = 0.0;
+    for (int idx = 0; idx < CoefficientCount; ++idx) {
+        result += row[idx] * coefficients[idx];
+    }
+    return result > 0.0 ? result : 0.0;
+}
+
+#pragma mark - Fit
+
+// solves the n x n system in place by gaussian elimination with partial pivoting. returns false if it is singular.
+static bool Solve(double pMatrix[CoefficientCount][CoefficientCount], double* const pVector, const int pN) {
+    for (int column = 0; column < pN; ++column) {
+        int pivot = column;
+        for (int row = column + 1; row < pN; ++row) {
+            pivot = fabs(pMatrix[row][column]) > fabs(pMatrix[pivot][column]) ? row : pivot;
+        }
+        // the columns are scaled to a unit diagonal, so a tiny pivot is a dependent column
+        if (!(fabs(pMatrix[pivot][column]) > 1.0e-12)) {
+            return false;
+        }
+        if (pivot != column) {
+            for (int idx = 0; idx < pN; ++idx) {
+                const double swap = pMatrix[column][idx];
+                pMatrix[column][idx] = pMatrix[pivot][idx];
+                pMatrix[pivot][idx] = swap;
+            }
+            const double swap = pVector[column];
+            pVector[column] = pVector[pivot];
+            pVector[pivot] = swap;
+        }
+        for (int row = column + 1; row < pN; ++row) {
+            const double factor = pMatrix[row][column] / pMatrix[column][column];
+            for (int idx = column; idx < pN; ++idx) {
+                pMatrix[row][idx] -= factor * pMatrix[column][idx];
+            }
+            pVector[row] -= factor * pVector[column];
+        }
+    }
+    for (int row = pN - 1; row >= 0; --row) {
+        double sum = pVector[row];
+        for (int idx = row + 1; idx < pN; ++idx) {
+            sum -= pMatrix[row][idx] * pVector[idx];
+        }
+        pVector[row] = sum / pMatrix[row][row];
+    }
+    return true;
+}
+
+bool CVSSCRenderCostModelFit(const CVSSCRenderCostSample* const pSamples, const size_t pCount, CVSSCRenderCostModel* const pOutModel) {
+    assert(pSamples || 0 == pCount);
+    assert(pOutModel);
+    // the normal equations of the rows divided by the measured times, whose targets are 1: the relative errors
+    double normal[CoefficientCount][CoefficientCount] = {{0.0}};
+    double target[CoefficientCount] = {0.0};
+    size_t sampleCount = 0;
+    for (size_t sample = 0; sample < pCount; ++sample) {
+        if (!(pSamples[sample].seconds > 0.0) || CVSSCRenderCostBlendCount <= pSamples[sample].features.blend) {
+            continue;
+        }
+        double row[CoefficientCount];
+        GetRow(&pSamples[sample].features, row);
+        for (int idx = 0; idx < CoefficientCount; ++idx) {
+            row[idx] /= pSamples[sample].seconds;
+        }
+        for (int i = 0; i < CoefficientCount; ++i) {
+            target[i] += row[i];
+            for (int j = 0; j < CoefficientCount; ++j) {
+                normal[i][j] += row[i] * row[j];
+            }
+        }
+        ++sampleCount;
+    }
+
+    // coefficients without support (no sample has the feature) are 0. a coefficient which the fit makes negative is
+    // removed, and the rest are refit (an active set method, which converges in at most CoefficientCount passes).
+    bool active[CoefficientCount];
+    int activeCount = 0;
+    for (int idx = 0; idx < CoefficientCount; ++idx) {
+        active[idx] = normal[idx][idx] > 0.0;
+        activeCount += active[idx];
+    }
+    double coefficients[CoefficientCount];
+    while (activeCount) {
+        if (sampleCount < (size_t)activeCount) {
+            return false;
+        }
+        int columns[CoefficientCount];
+        int n = 0;
+        for (int idx = 0; idx < CoefficientCount; ++idx) {
+            if (active[idx]) {
+                columns[n++] = idx;
+            }
+        }
+        // scaled to a unit diagonal, since the features differ by orders of magnitude
+        double matrix[CoefficientCount][CoefficientCount];
+        double vector[CoefficientCount];
+        for (int i = 0; i < n; ++i) {
+            const double si = 1.0 / sqrt(normal[columns[i]][columns[i]]);
+            vector[i] = target[columns[i]] * si;
+            for (int j = 0; j < n; ++j) {
+                matrix[i][j] = normal[columns[i]][columns[j]] * si / sqrt(normal[columns[j]][columns[j]]);
+            }
+        }
+        if (!Solve(matrix, vector, n)) {
+            return false;
+        }
+        int mostNegative = -1;
+        for (int idx = 0; idx < CoefficientCount; ++idx) {
+            coefficients[idx] = 0.0;
+        }
+        for (int i = 0; i < n; ++i) {
+            const double coefficient = vector[i] / sqrt(normal[columns[i]][columns[i]]);
+            coefficients[columns[i]] = coefficient;
+            if (coefficient < 0.0 && (-1 == mostNegative || coefficient * sqrt(normal[columns[i]][columns[i]]) < coefficients[mostNegative] * sqrt(normal[mostNegative][mostNegative]))) {
+                mostNegative = columns[i];
+            }
+        }
+        if (-1 == mostNegative) {
+            SetCoefficients(pOutModel, coefficients);
+            return true;
+        }
+        active[mostNegative] = false;
+        --activeCount;
+    }
+    return false;
+}
+
+#pragma mark - Frame Budget
+
+CVSSCFrameBudget CVSSCFrameBudgetMake(const double pNow, const double pDuration) {
+    const CVSSCFrameBudget result = {pNow + pDuration, 0};
+    return result;
+}
+
+bool CVSSCFrameBudgetCanAfford(const CVSSCFrameBudget* const pBudget, const double pNow, const double pCost) {
+    assert(pBudget);
+    return 0 == pBudget->itemCount || pNow + pCost <= pBudget->deadline;
+}
+
+void CVSSCFrameBudgetCharge(CVSSCFrameBudget* const pBudget) {
+    assert(pBudget);
+    ++pBudget->itemCount;
+}
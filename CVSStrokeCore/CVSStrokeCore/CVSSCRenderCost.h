@@ -0,0 +1,136 @@
+// CVSSCRenderCost.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCRenderCost_h
+#define CVSStrokeCore_CVSSCRenderCost_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "CVSSCBrush.h"
+#include "CVSSCComponent.h"
+#include "CVSSCGeometry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ An estimate of the time it takes to render a stroke, and a budget of that time per frame.
+
+ A stroke's cost is linear in a few features of the stroke as it is rendered at a scale, within a clip: a fixed cost per
+ stroke, a cost per flattened segment and per row of pixels a segment spans (where the rasterizer finds the segment's
+ extent), a cost per pixel swept by the brush along the flattened path, and a cost per pixel of the stroke's bounds (the
+ mask which is cleared, and the rows which are blended -- whose cost depends on the blend). The coefficients are fitted
+ from measured render times by least squares -- see CVSSCRenderCostCalibration.c, which prints the coefficients of
+ CVSSCRenderCostDefaultModel.
+ */
+
+/**
+ @brief how a stroke's pixels are blended
+ */
+typedef enum {
+    /** @constant source over, with an opaque brush */
+    CVSSCRenderCostBlendOpaque = 0,
+    /** @constant source over, with a translucent brush */
+    CVSSCRenderCostBlendTranslucent,
+    /** @constant clear (the eraser) */
+    CVSSCRenderCostBlendClear,
+    CVSSCRenderCostBlendCount
+} CVSSCRenderCostBlend;
+
+/**
+ @brief the features of a stroke which its render cost is estimated from. they count only what is within the clip, in
+ device pixels.
+ */
+typedef struct {
+    CVSSCRenderCostBlend blend;
+    /** @brief the number of segments the components are flattened to (within CVSSCRasterFlatteningTolerance) */
+    double segmentCount;
+    /** @brief the rows of pixels spanned by the segments, each inflated by the brush */
+    double rowCount;
+    /** @brief the flattened path's length times the brush width, plus a cap per segment */
+    double sweptArea;
+    /** @brief the area of the stroke's bounds */
+    double boundsArea;
+} CVSSCRenderCostFeatures;
+
+/**
+ @brief the coefficients of the cost, in seconds
+ */
+typedef struct {
+    double perStroke;
+    double perSegment;
+    double perRow;
+    double perSweptPixel;
+    double perBoundsPixel[CVSSCRenderCostBlendCount];
+} CVSSCRenderCostModel;
+
+/**
+ @brief the model fitted on the reference device, timing the software rasterizer. recalibrate it with CVSSCRenderCostCalibration.c
+ when the renderer changes. it paces playback (DQPlaybackStrokeView); the editor keeps its own estimate, the component count.
+ */
+extern const CVSSCRenderCostModel CVSSCRenderCostDefaultModel;
+
+/**
+ @return the features of the components, rendered with the brush at @p pScale pixels per point
+ @param pClip the rect (in points) which is rendered, e.g. the canvas
+ */
+extern CVSSCRenderCostFeatures CVSSCRenderCostGetFeatures(const CVSSCBrushAttributes* const pBrush, const CVSSCComponent* const pComponents, const size_t pCount, const double pScale, const CVSSCRect pClip);
+
+/**
+ @return the estimated render time of a stroke with the features, in seconds. never negative.
+ */
+extern double CVSSCRenderCostEstimate(const CVSSCRenderCostModel* const pModel, const CVSSCRenderCostFeatures* const pFeatures);
+
+/**
+ @brief a measured render time of a stroke with the features
+ */
+typedef struct {
+    CVSSCRenderCostFeatures features;
+    double seconds;
+} CVSSCRenderCostSample;
+
+/**
+ @brief fits a model to the samples, minimizing the squared relative error of the estimates. coefficients which would be
+ negative are 0, as are the coefficients of blends which no sample has.
+ @return false if the samples do not determine a model (e.g. fewer samples than coefficients). no memory is allocated.
+ */
+extern bool CVSSCRenderCostModelFit(const CVSSCRenderCostSample* const pSamples, const size_t pCount, CVSSCRenderCostModel* const pOutModel);
+
+#pragma mark - Frame Budget
+
+/**
+ @brief the default time per frame for rendering strokes: half of a 60 Hz frame, which leaves the rest to compositing and events
+ */
+extern const double CVSSCFrameBudgetDefaultDuration;
+
+/**
+ @brief the render time which remains in a frame. times are in seconds, on any monotonic clock (e.g. CACurrentMediaTime).
+ */
+typedef struct {
+    double deadline;
+    size_t itemCount;
+} CVSSCFrameBudget;
+
+/**
+ @return a budget of @p pDuration seconds from @p pNow
+ */
+extern CVSSCFrameBudget CVSSCFrameBudgetMake(const double pNow, const double pDuration);
+
+/**
+ @return true if work with the estimated cost @p pCost, begun at @p pNow, would end by the deadline. the first item of a
+ frame is always affordable, so that work progresses however costly its items are.
+ */
+extern bool CVSSCFrameBudgetCanAfford(const CVSSCFrameBudget* const pBudget, const double pNow, const double pCost);
+
+/**
+ @brief counts an item of work which was done
+ */
+extern void CVSSCFrameBudgetCharge(CVSSCFrameBudget* const pBudget);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,259 @@
+// CVSSCSimplify.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include "CVSSCGeometry.h"
+#include "CVSSCSimplify.h"
+
+// the points sampled along each curve of a run. the fit is measured at these points.
+enum { SamplesPerCurve = 8 };
+// the most curves which are merged into one. bounds the scratch (on the stack) and the cost of the greedy search.
+enum { MaximumRunLength = 48 };
+enum { MaximumSampleCount = MaximumRunLength * SamplesPerCurve + 1 };
+// Newton iterations which improve the samples' parameters when a fit is close
+enum { ReparameterizationCount = 3 };
+
+#pragma mark - Vectors
+
+static inline CVSSCPoint Add(const CVSSCPoint pA, const CVSSCPoint pB) {
+    const CVSSCPoint result = {pA.x + pB.x, pA.y + pB.y};
+    return result;
+}
+
+static inline CVSSCPoint Subtract(const CVSSCPoint pA, const CVSSCPoint pB) {
+    const CVSSCPoint result = {pA.x - pB.x, pA.y - pB.y};
+    return result;
+}
+
+static inline CVSSCPoint Scale(const CVSSCPoint pA, const double pScale) {
+    const CVSSCPoint result = {pA.x * pScale, pA.y * pScale};
+    return result;
+}
+
+static inline double Dot(const CVSSCPoint pA, const CVSSCPoint pB) {
+    return pA.x * pB.x + pA.y * pB.y;
+}
+
+// returns false (and leaves pOutUnit unchanged) if the vector has no direction
+static inline bool Normalize(const CVSSCPoint pVector, CVSSCPoint* const pOutUnit) {
+    const double length = sqrt(Dot(pVector, pVector));
+    if (!(length > 0.0)) {
+        return false;
+    }
+    *pOutUnit = Scale(pVector, 1.0 / length);
+    return true;
+}
+
+#pragma mark - Beziers
+
+// p[0] and p[3] are the end points, p[1] and p[2] the control points
+static CVSSCPoint BezierPoint(const CVSSCPoint* const p, const double t) {
+    const double s = 1.0 - t;
+    const double b0 = s * s * s, b1 = 3.0 * s * s * t, b2 = 3.0 * s * t * t, b3 = t * t * t;
+    const CVSSCPoint result = {
+        b0 * p[0].x + b1 * p[1].x + b2 * p[2].x + b3 * p[3].x,
+        b0 * p[0].y + b1 * p[1].y + b2 * p[2].y + b3 * p[3].y
+    };
+    return result;
+}
+
+static CVSSCPoint BezierDerivative(const CVSSCPoint* const p, const double t) {
+    const double s = 1.0 - t;
+    const CVSSCPoint d0 = Subtract(p[1], p[0]), d1 = Subtract(p[2], p[1]), d2 = Subtract(p[3], p[2]);
+    return Scale(Add(Add(Scale(d0, s * s), Scale(d1, 2.0 * s * t)), Scale(d2, t * t)), 3.0);
+}
+
+static CVSSCPoint BezierSecondDerivative(const CVSSCPoint* const p, const double t) {
+    const CVSSCPoint e0 = Add(Subtract(p[2], Scale(p[1], 2.0)), p[0]);
+    const CVSSCPoint e1 = Add(Subtract(p[3], Scale(p[2], 2.0)), p[1]);
+    return Scale(Add(Scale(e0, 1.0 - t), Scale(e1, t)), 6.0);
+}
+
+// the component's curve, from toPoint to fromPoint if pReversed
+static void BezierFromComponent(const CVSSCComponent* const pComponent, const bool pReversed, CVSSCPoint* const p) {
+    p[pReversed ? 3 : 0] = pComponent->fromPoint;
+    p[pReversed ? 2 : 1] = pComponent->controlPoint1;
+    p[pReversed ? 1 : 2] = pComponent->controlPoint2;
+    p[pReversed ? 0 : 3] = pComponent->toPoint;
+}
+
+#pragma mark - Runs
+
+static inline bool IsFinitePoint(const CVSSCPoint pPoint) {
+    return isfinite(pPoint.x) && isfinite(pPoint.y);
+}
+
+static bool IsFiniteCurve(const CVSSCComponent* const pComponent) {
+    return CVSSCComponentTypeCurve == pComponent->type
+        && IsFinitePoint(pComponent->fromPoint) && IsFinitePoint(pComponent->controlPoint1)
+        && IsFinitePoint(pComponent->controlPoint2) && IsFinitePoint(pComponent->toPoint);
+}
+
+static inline bool IsEqualPoint(const CVSSCPoint pA, const CVSSCPoint pB) {
+    return pA.x == pB.x && pA.y == pB.y;
+}
+
+// returns true if the next component continues the previous in the run's direction
+static bool Continues(const CVSSCComponent* const pPrevious, const CVSSCComponent* const pNext, const bool pBackward) {
+    return pBackward ? IsEqualPoint(pNext->toPoint, pPrevious->fromPoint) : IsEqualPoint(pPrevious->toPoint, pNext->fromPoint);
+}
+
+// the run's pIndex'th curve, such that each curve begins where the previous one ends (the curves of a backward run are reversed)
+static void RunBezier(const CVSSCComponent* const pComponents, const bool pBackward, const size_t pIndex, CVSSCPoint* const p) {
+    BezierFromComponent(&pComponents[pIndex], pBackward, p);
+}
+
+// the direction in which the curve leaves its first point (pAtEnd false), or enters its last point, reversed (pAtEnd true)
+static CVSSCPoint Tangent(const CVSSCPoint* const p, const bool pAtEnd) {
+    const CVSSCPoint origin = pAtEnd ? p[3] : p[0];
+    CVSSCPoint result = {pAtEnd ? -1.0 : 1.0, 0.0};
+    for (size_t idx = 1; idx < 4; ++idx) {
+        if (Normalize(Subtract(p[pAtEnd ? 3 - idx : idx], origin), &result)) {
+            break;
+        }
+    }
+    return result;
+}
+
+// samples the run's curves, with the run's last point last. returns the number of samples.
+static size_t SampleRun(const CVSSCComponent* const pComponents, const size_t pCount, const bool pBackward, CVSSCPoint* const pOutPoints) {
+    size_t result = 0;
+    CVSSCPoint p[4];
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        RunBezier(pComponents, pBackward, idx, p);
+        for (size_t sample = 0; sample < SamplesPerCurve; ++sample) {
+            pOutPoints[result++] = BezierPoint(p, (double)sample / SamplesPerCurve);
+        }
+    }
+    pOutPoints[result++] = p[3];
+    return result;
+}
+
+static void ChordLengthParameterize(const CVSSCPoint* const pPoints, const size_t pCount, double* const pOutParameters) {
+    pOutParameters[0] = 0.0;
+    for (size_t idx = 1; idx < pCount; ++idx) {
+        pOutParameters[idx] = pOutParameters[idx - 1] + CVSSCPointDistance(pPoints[idx - 1], pPoints[idx]);
+    }
+    const double total = pOutParameters[pCount - 1];
+    for (size_t idx = 1; idx < pCount; ++idx) {
+        pOutParameters[idx] = total > 0.0 ? pOutParameters[idx] / total : (double)idx / (double)(pCount - 1);
+    }
+}
+
+// fits the control points by least squares, with the end points and the directions of the end tangents fixed
+static void FitBezier(const CVSSCPoint* const pPoints, const double* const pParameters, const size_t pCount, const CVSSCPoint pTangent1, const CVSSCPoint pTangent2, CVSSCPoint* const p) {
+    const CVSSCPoint first = pPoints[0];
+    const CVSSCPoint last = pPoints[pCount - 1];
+    double c00 = 0.0, c01 = 0.0, c11 = 0.0, x0 = 0.0, x1 = 0.0;
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        const double t = pParameters[idx];
+        const double s = 1.0 - t;
+        const double b0 = s * s * s, b1 = 3.0 * s * s * t, b2 = 3.0 * s * t * t, b3 = t * t * t;
+        const CVSSCPoint a1 = Scale(pTangent1, b1);
+        const CVSSCPoint a2 = Scale(pTangent2, b2);
+        c00 += Dot(a1, a1);
+        c01 += Dot(a1, a2);
+        c11 += Dot(a2, a2);
+        const CVSSCPoint residual = Subtract(pPoints[idx], Add(Scale(first, b0 + b1), Scale(last, b2 + b3)));
+        x0 += Dot(a1, residual);
+        x1 += Dot(a2, residual);
+    }
+    const double determinant = c00 * c11 - c01 * c01;
+    double alpha1 = 0.0 != determinant ? (x0 * c11 - x1 * c01) / determinant : 0.0;
+    double alpha2 = 0.0 != determinant ? (c00 * x1 - c01 * x0) / determinant : 0.0;
+    const double chord = CVSSCPointDistance(first, last);
+    const double epsilon = 1.0e-6 * chord;
+    if (!(alpha1 >= epsilon) || !(alpha2 >= epsilon)) {
+        // no sensible least squares solution; Schneider's fallback
+        alpha1 = alpha2 = chord / 3.0;
+    }
+    p[0] = first;
+    p[1] = Add(first, Scale(pTangent1, alpha1));
+    p[2] = Add(last, Scale(pTangent2, alpha2));
+    p[3] = last;
+}
+
+static double MaximumErrorSquared(const CVSSCPoint* const pPoints, const double* const pParameters, const size_t pCount, const CVSSCPoint* const p) {
+    double result = 0.0;
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        const CVSSCPoint delta = Subtract(BezierPoint(p, pParameters[idx]), pPoints[idx]);
+        result = fmax(result, Dot(delta, delta));
+    }
+    return result;
+}
+
+// moves each parameter to the nearest point of the curve to its sample (one Newton step)
+static void Reparameterize(const CVSSCPoint* const pPoints, double* const pParameters, const size_t pCount, const CVSSCPoint* const p) {
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        const double t = pParameters[idx];
+        const CVSSCPoint delta = Subtract(BezierPoint(p, t), pPoints[idx]);
+        const CVSSCPoint d1 = BezierDerivative(p, t);
+        const CVSSCPoint d2 = BezierSecondDerivative(p, t);
+        const double denominator = Dot(d1, d1) + Dot(delta, d2);
+        if (0.0 != denominator) {
+            const double next = t - Dot(delta, d1) / denominator;
+            pParameters[idx] = next < 0.0 ? 0.0 : (next > 1.0 ? 1.0 : next);
+        }
+    }
+}
+
+// returns true if the run is fit by one curve within the tolerance. the curve has the direction of the run's components.
+static bool FitRun(const CVSSCComponent* const pComponents, const size_t pCount, const bool pBackward, const double pTolerance, CVSSCComponent* const pOutComponent) {
+    assert(pCount <= MaximumRunLength);
+    CVSSCPoint points[MaximumSampleCount];
+    double parameters[MaximumSampleCount];
+    const size_t sampleCount = SampleRun(pComponents, pCount, pBackward, points);
+    ChordLengthParameterize(points, sampleCount, parameters);
+    CVSSCPoint p[4];
+    RunBezier(pComponents, pBackward, 0, p);
+    const CVSSCPoint tangent1 = Tangent(p, false);
+    RunBezier(pComponents, pBackward, pCount - 1, p);
+    const CVSSCPoint tangent2 = Tangent(p, true);
+    const double toleranceSquared = pTolerance * pTolerance;
+    FitBezier(points, parameters, sampleCount, tangent1, tangent2, p);
+    double error = MaximumErrorSquared(points, parameters, sampleCount, p);
+    // a fit which is not far off may be brought within the tolerance by better parameters
+    for (size_t iteration = 0; error > toleranceSquared && error < 16.0 * toleranceSquared && iteration < ReparameterizationCount; ++iteration) {
+        Reparameterize(points, parameters, sampleCount, p);
+        FitBezier(points, parameters, sampleCount, tangent1, tangent2, p);
+        error = MaximumErrorSquared(points, parameters, sampleCount, p);
+    }
+    if (!(error <= toleranceSquared)) {
+        return false;
+    }
+    *pOutComponent = pBackward ? CVSSCComponentMakeCurve(p[3], p[2], p[1], p[0]) : CVSSCComponentMakeCurve(p[0], p[1], p[2], p[3]);
+    return true;
+}
+
+#pragma mark - Simplification
+
+size_t CVSSCSimplifyComponents(const CVSSCComponent* const pComponents, const size_t pCount, const double pTolerance, CVSSCComponent* const pOutComponents) {
+    assert(pComponents || 0 == pCount);
+    assert(pOutComponents || 0 == pCount);
+    size_t result = 0;
+    size_t idx = 0;
+    while (idx < pCount) {
+        const CVSSCComponent* const first = &pComponents[idx];
+        CVSSCComponent merged = *first;
+        size_t mergedCount = 1;
+        if (pTolerance > 0.0 && IsFiniteCurve(first) && idx + 1 < pCount) {
+            // the direction of the run is that of its first two curves
+            const bool backward = !Continues(first, first + 1, false);
+            // grow the run while it still fits
+            for (size_t count = 2; count <= MaximumRunLength && idx + count <= pCount; ++count) {
+                const CVSSCComponent* const next = &pComponents[idx + count - 1];
+                CVSSCComponent fit;
+                if (!IsFiniteCurve(next) || !Continues(next - 1, next, backward) || !FitRun(first, count, backward, pTolerance, &fit)) {
+                    break;
+                }
+                merged = fit;
+                mergedCount = count;
+            }
+        }
+        pOutComponents[result++] = merged;
+        idx += mergedCount;
+    }
+    return result;
+}
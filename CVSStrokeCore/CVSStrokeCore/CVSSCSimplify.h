@@ -0,0 +1,43 @@
+// CVSSCSimplify.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCSimplify_h
+#define CVSStrokeCore_CVSSCSimplify_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "CVSSCComponent.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Error-bounded simplification of a finished stroke's components.
+
+ The smoothing emits a curve per touch sample, so a slow stroke has many short curves which continue one another. A run of
+ connected curves (each begins where the previous one ends) is refit as fewer cubics: the run's end points and end tangents
+ are kept, the control points are fit by least squares to points sampled along the run (Schneider's method), and a fit is
+ accepted only if every sample is within the tolerance of it. Runs grow greedily from the first curve.
+
+ Each component is its own subpath with round caps, so merging connected curves of a round capped brush changes the
+ stroke's outline by at most the tolerance. Square caps would lose the corners of the caps between the curves which are
+ merged; do not simplify those strokes.
+ */
+
+/**
+ @brief merges runs of connected curves. lines, curves with non-finite points, and curves which do not begin where the
+ previous component ends are copied unchanged, and end a run.
+ @param pTolerance the maximum distance between a merged curve and the curves it replaces, in the components' units.
+ 0 copies every component.
+ @param pOutComponents receives the components. it must have room for @p pCount components, and must not overlap @p pComponents.
+ @return the number of components written, which is at most @p pCount. no memory is allocated.
+ */
+extern size_t CVSSCSimplifyComponents(const CVSSCComponent* const pComponents, const size_t pCount, const double pTolerance, CVSSCComponent* const pOutComponents);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,60 @@
+// CVSSCSmoothing.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include "CVSSCSmoothing.h"
+#include "CVSSCGeometry.h"
+
+const double CVSSCSmoothingDefaultSmoothValue = 0.5;
+
+CVSSCComponent CVSSCSmoothingMakeComponent(const CVSSCPoint* const pSamples, const size_t pCount, const double pSmoothValue) {
+    assert(pSamples);
+    assert(0 < pCount && CVSSCSmoothingSampleCount >= pCount);
+
+    if (CVSSCSmoothingSampleCount > pCount) {
+        if (1 == pCount) {
+            return CVSSCComponentMakePoint(pSamples[0], pSamples[0]);
+        }
+        // note: this intentionally matches the editor's original ordering (second sample to first sample).
+        return CVSSCComponentMakePoint(pSamples[1], pSamples[0]);
+    }
+
+    // the editor's original naming: samplePoint0 is the newest
+    const CVSSCPoint samplePoint0 = pSamples[3];
+    const CVSSCPoint samplePoint1 = pSamples[2];
+    const CVSSCPoint samplePoint2 = pSamples[1];
+    const CVSSCPoint samplePoint3 = pSamples[0];
+
+    // calculate the midpoint of lines formed by sample points
+    const double line1MidpointX = (samplePoint0.x + samplePoint1.x) / 2.0;
+    const double line1MidpointY = (samplePoint0.y + samplePoint1.y) / 2.0;
+    const double line2MidpointX = (samplePoint1.x + samplePoint2.x) / 2.0;
+    const double line2MidpointY = (samplePoint1.y + samplePoint2.y) / 2.0;
+    const double line3MidpointX = (samplePoint2.x + samplePoint3.x) / 2.0;
+    const double line3MidpointY = (samplePoint2.y + samplePoint3.y) / 2.0;
+
+    const double line1Length = CVSSCPointDistance(samplePoint0, samplePoint1);
+    const double line2Length = CVSSCPointDistance(samplePoint1, samplePoint2);
+    const double line3Length = CVSSCPointDistance(samplePoint2, samplePoint3);
+
+    // JC: if the sum of lengths is tiny, the coefficients should be 0. however, i have not seen this manifest (error would be control point with a NaN).
+    const double coefficient1 = line1Length / (line1Length + line2Length);
+    const double coefficient2 = line2Length / (line2Length + line3Length);
+
+    const double xm1 = line1MidpointX + (line2MidpointX - line1MidpointX) * coefficient1;
+    const double ym1 = line1MidpointY + (line2MidpointY - line1MidpointY) * coefficient1;
+    const double xm2 = line2MidpointX + (line3MidpointX - line2MidpointX) * coefficient2;
+    const double ym2 = line2MidpointY + (line3MidpointY - line2MidpointY) * coefficient2;
+
+    const CVSSCPoint controlPoint1 = {
+        xm1 + (line2MidpointX - xm1) * pSmoothValue + samplePoint1.x - xm1,
+        ym1 + (line2MidpointY - ym1) * pSmoothValue + samplePoint1.y - ym1
+    };
+    const CVSSCPoint controlPoint2 = {
+        xm2 + (line2MidpointX - xm2) * pSmoothValue + samplePoint2.x - xm2,
+        ym2 + (line2MidpointY - ym2) * pSmoothValue + samplePoint2.y - ym2
+    };
+
+    return CVSSCComponentMakeCurve(samplePoint1, controlPoint1, controlPoint2, samplePoint2);
+}
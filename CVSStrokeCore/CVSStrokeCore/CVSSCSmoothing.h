@@ -0,0 +1,38 @@
+// CVSSCSmoothing.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCSmoothing_h
+#define CVSStrokeCore_CVSSCSmoothing_h
+
+#include <stddef.h>
+#include "CVSSCComponent.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ @brief the number of touch samples which are used to produce a curve.
+ */
+enum { CVSSCSmoothingSampleCount = 4 };
+
+/**
+ @brief the smoothing the editor has always used.
+ */
+extern const double CVSSCSmoothingDefaultSmoothValue;
+
+/**
+ @brief produces the component for the most recent touch samples. this is the editor's Catmull-Rom style smoothing.
+ @param pSamples the samples, oldest first.
+ @param pCount [1...CVSSCSmoothingSampleCount]. fewer than CVSSCSmoothingSampleCount samples produce a line.
+ @details given samples (a,b,c,d) oldest first, the curve is between b and c, with control points derived from the
+ midpoints of the sample lines weighted by their lengths.
+ */
+extern CVSSCComponent CVSSCSmoothingMakeComponent(const CVSSCPoint* const pSamples, const size_t pCount, const double pSmoothValue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,445 @@
+// CVSSCSpan.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <string.h>
+#include "CVSSCSpan.h"
+
+#if defined(CVSSC_SPAN_SCALAR)
+// the scalar implementation was requested
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define CVSSC_SPAN_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define CVSSC_SPAN_NEON 1
+#endif
+
+#pragma mark - Scalar
+
+// exact (rounded) x / 255 for x in [0...65535]
+static inline uint32_t Div255(const uint32_t x) {
+    const uint32_t t = x + 128;
+    return (t + (t >> 8)) >> 8;
+}
+
+static inline void BlendNormalPixel(uint8_t* const pPixel, const uint8_t pCoverage, const CVSSCSpanPaint pPaint) {
+    const uint32_t a = Div255((uint32_t)pPaint.alpha * pCoverage);
+    const uint32_t inverse = 255 - a;
+    pPixel[0] = (uint8_t)(Div255((uint32_t)pPaint.red * a) + Div255((uint32_t)pPixel[0] * inverse));
+    pPixel[1] = (uint8_t)(Div255((uint32_t)pPaint.green * a) + Div255((uint32_t)pPixel[1] * inverse));
+    pPixel[2] = (uint8_t)(Div255((uint32_t)pPaint.blue * a) + Div255((uint32_t)pPixel[2] * inverse));
+    pPixel[3] = (uint8_t)(Div255(255 * a) + Div255((uint32_t)pPixel[3] * inverse));
+}
+
+static inline void BlendClearPixel(uint8_t* const pPixel, const uint8_t pCoverage) {
+    const uint32_t inverse = 255 - (uint32_t)pCoverage;
+    pPixel[0] = (uint8_t)Div255((uint32_t)pPixel[0] * inverse);
+    pPixel[1] = (uint8_t)Div255((uint32_t)pPixel[1] * inverse);
+    pPixel[2] = (uint8_t)Div255((uint32_t)pPixel[2] * inverse);
+    pPixel[3] = (uint8_t)Div255((uint32_t)pPixel[3] * inverse);
+}
+
+static void BlendNormalScalar(uint8_t* pPixels, const uint8_t* pCoverage, size_t pCount, const CVSSCSpanPaint pPaint) {
+    for (; pCount; --pCount, pPixels += 4, ++pCoverage) {
+        const uint8_t coverage = *pCoverage;
+        if (0 != coverage) {
+            BlendNormalPixel(pPixels, coverage, pPaint);
+        }
+    }
+}
+
+static void BlendClearScalar(uint8_t* pPixels, const uint8_t* pCoverage, size_t pCount) {
+    for (; pCount; --pCount, pPixels += 4, ++pCoverage) {
+        const uint8_t coverage = *pCoverage;
+        if (0 != coverage) {
+            BlendClearPixel(pPixels, coverage);
+        }
+    }
+}
+
+static void CoverageMaxScalar(uint8_t* pCoverage, const uint8_t* pSource, size_t pCount) {
+    for (; pCount; --pCount, ++pCoverage, ++pSource) {
+        if (*pSource > *pCoverage) {
+            *pCoverage = *pSource;
+        }
+    }
+}
+
+static void CoverageAddScalar(uint8_t* pCoverage, const uint8_t* pSource, size_t pCount) {
+    for (; pCount; --pCount, ++pCoverage, ++pSource) {
+        const uint32_t sum = (uint32_t)*pCoverage + *pSource;
+        *pCoverage = (uint8_t)(sum > 255 ? 255 : sum);
+    }
+}
+
+static void CoverageMultiplyScalar(uint8_t* pCoverage, const uint8_t* pSource, size_t pCount) {
+    for (; pCount; --pCount, ++pCoverage, ++pSource) {
+        *pCoverage = (uint8_t)Div255((uint32_t)*pCoverage * *pSource);
+    }
+}
+
+static inline bool PixelMatches(const uint8_t* const pPixel, const uint8_t* const pColor, const uint8_t pTolerance) {
+    for (size_t idx = 0; idx < 4; ++idx) {
+        const int difference = (int)pPixel[idx] - (int)pColor[idx];
+        if ((difference < 0 ? -difference : difference) > pTolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t MatchLengthScalar(const uint8_t* const pPixels, const size_t pCount, const uint8_t* const pColor, const uint8_t pTolerance, const bool pMatching) {
+    size_t result = 0;
+    while (result < pCount && pMatching == PixelMatches(pPixels + 4 * result, pColor, pTolerance)) {
+        ++result;
+    }
+    return result;
+}
+
+static size_t MatchLengthReverseScalar(const uint8_t* const pPixels, const size_t pCount, const uint8_t* const pColor, const uint8_t pTolerance, const bool pMatching) {
+    size_t result = 0;
+    while (result < pCount && pMatching == PixelMatches(pPixels - 4 * result, pColor, pTolerance)) {
+        ++result;
+    }
+    return result;
+}
+
+#pragma mark - SSE2
+
+#if CVSSC_SPAN_SSE2
+
+static inline __m128i Div255x8(const __m128i x) {
+    const __m128i t = _mm_add_epi16(x, _mm_set1_epi16(128));
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// expands 4 coverage values to two vectors of 8 16 bit lanes (each value repeated for the 4 channels of its pixel)
+static inline void ExpandCoverage(const uint8_t* const pCoverage, __m128i* const pOutLow, __m128i* const pOutHigh) {
+    uint32_t packed;
+    memcpy(&packed, pCoverage, sizeof(packed));
+    const __m128i zero = _mm_setzero_si128();
+    __m128i c = _mm_cvtsi32_si128((int)packed);
+    c = _mm_unpacklo_epi8(c, c);
+    c = _mm_unpacklo_epi16(c, c);
+    *pOutLow = _mm_unpacklo_epi8(c, zero);
+    *pOutHigh = _mm_unpackhi_epi8(c, zero);
+}
+
+static void BlendNormalSSE2(uint8_t* pPixels, const uint8_t* pCoverage, size_t pCount, const CVSSCSpanPaint pPaint) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maximum = _mm_set1_epi16(255);
+    const __m128i alpha = _mm_set1_epi16(pPaint.alpha);
+    const __m128i color = _mm_setr_epi16(pPaint.red, pPaint.green, pPaint.blue, 255, pPaint.red, pPaint.green, pPaint.blue, 255);
+    for (; pCount >= 4; pCount -= 4, pPixels += 16, pCoverage += 4) {
+        uint32_t packed;
+        memcpy(&packed, pCoverage, sizeof(packed));
+        if (0 == packed) {
+            continue;
+        }
+        __m128i coverageLow, coverageHigh;
+        ExpandCoverage(pCoverage, &coverageLow, &coverageHigh);
+        const __m128i aLow = Div255x8(_mm_mullo_epi16(alpha, coverageLow));
+        const __m128i aHigh = Div255x8(_mm_mullo_epi16(alpha, coverageHigh));
+        const __m128i pixels = _mm_loadu_si128((const __m128i*)pPixels);
+        const __m128i dstLow = _mm_unpacklo_epi8(pixels, zero);
+        const __m128i dstHigh = _mm_unpackhi_epi8(pixels, zero);
+        const __m128i outLow = _mm_add_epi16(Div255x8(_mm_mullo_epi16(color, aLow)), Div255x8(_mm_mullo_epi16(dstLow, _mm_sub_epi16(maximum, aLow))));
+        const __m128i outHigh = _mm_add_epi16(Div255x8(_mm_mullo_epi16(color, aHigh)), Div255x8(_mm_mullo_epi16(dstHigh, _mm_sub_epi16(maximum, aHigh))));
+        _mm_storeu_si128((__m128i*)pPixels, _mm_packus_epi16(outLow, outHigh));
+    }
+    BlendNormalScalar(pPixels, pCoverage, pCount, pPaint);
+}
+
+static void BlendClearSSE2(uint8_t* pPixels, const uint8_t* pCoverage, size_t pCount) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maximum = _mm_set1_epi16(255);
+    for (; pCount >= 4; pCount -= 4, pPixels += 16, pCoverage += 4) {
+        uint32_t packed;
+        memcpy(&packed, pCoverage, sizeof(packed));
+        if (0 == packed) {
+            continue;
+        }
+        __m128i coverageLow, coverageHigh;
+        ExpandCoverage(pCoverage, &coverageLow, &coverageHigh);
+        const __m128i pixels = _mm_loadu_si128((const __m128i*)pPixels);
+        const __m128i outLow = Div255x8(_mm_mullo_epi16(_mm_unpacklo_epi8(pixels, zero), _mm_sub_epi16(maximum, coverageLow)));
+        const __m128i outHigh = Div255x8(_mm_mullo_epi16(_mm_unpackhi_epi8(pixels, zero), _mm_sub_epi16(maximum, coverageHigh)));
+        _mm_storeu_si128((__m128i*)pPixels, _mm_packus_epi16(outLow, outHigh));
+    }
+    BlendClearScalar(pPixels, pCoverage, pCount);
+}
+
+static void CoverageMaxSSE2(uint8_t* pCoverage, const uint8_t* pSource, size_t pCount) {
+    for (; pCount >= 16; pCount -= 16, pCoverage += 16, pSource += 16) {
+        const __m128i coverage = _mm_loadu_si128((const __m128i*)pCoverage);
+        _mm_storeu_si128((__m128i*)pCoverage, _mm_max_epu8(coverage, _mm_loadu_si128((const __m128i*)pSource)));
+    }
+    CoverageMaxScalar(pCoverage, pSource, pCount);
+}
+
+static void CoverageAddSSE2(uint8_t* pCoverage, const uint8_t* pSource, size_t pCount) {
+    for (; pCount >= 16; pCount -= 16, pCoverage += 16, pSource += 16) {
+        const __m128i coverage = _mm_loadu_si128((const __m128i*)pCoverage);
+        _mm_storeu_si128((__m128i*)pCoverage, _mm_adds_epu8(coverage, _mm_loadu_si128((const __m128i*)pSource)));
+    }
+    CoverageAddScalar(pCoverage, pSource, pCount);
+}
+
+static void CoverageMultiplySSE2(uint8_t* pCoverage, const uint8_t* pSource, size_t pCount) {
+    const __m128i zero = _mm_setzero_si128();
+    for (; pCount >= 16; pCount -= 16, pCoverage += 16, pSource += 16) {
+        const __m128i coverage = _mm_loadu_si128((const __m128i*)pCoverage);
+        const __m128i source = _mm_loadu_si128((const __m128i*)pSource);
+        const __m128i low = Div255x8(_mm_mullo_epi16(_mm_unpacklo_epi8(coverage, zero), _mm_unpacklo_epi8(source, zero)));
+        const __m128i high = Div255x8(_mm_mullo_epi16(_mm_unpackhi_epi8(coverage, zero), _mm_unpackhi_epi8(source, zero)));
+        _mm_storeu_si128((__m128i*)pCoverage, _mm_packus_epi16(low, high));
+    }
+    CoverageMultiplyScalar(pCoverage, pSource, pCount);
+}
+
+typedef struct {
+    __m128i color;
+    __m128i tolerance;
+} MatchState;
+
+static inline MatchState MatchStateMake(const uint8_t* const pColor, const uint8_t pTolerance) {
+    uint32_t packed;
+    memcpy(&packed, pColor, sizeof(packed));
+    const MatchState result = {_mm_set1_epi32((int)packed), _mm_set1_epi8((char)pTolerance)};
+    return result;
+}
+
+// bit n is set if pixel n of the 4 pixels matches
+static inline unsigned MatchBits4(const MatchState* const pState, const uint8_t* const pPixels) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i pixels = _mm_loadu_si128((const __m128i*)pPixels);
+    const __m128i difference = _mm_or_si128(_mm_subs_epu8(pixels, pState->color), _mm_subs_epu8(pState->color, pixels));
+    const __m128i componentMatches = _mm_cmpeq_epi8(_mm_subs_epu8(difference, pState->tolerance), zero);
+    const __m128i pixelMatches = _mm_cmpeq_epi32(componentMatches, _mm_cmpeq_epi8(zero, zero));
+    return (unsigned)_mm_movemask_ps(_mm_castsi128_ps(pixelMatches));
+}
+
+#endif
+
+#pragma mark - NEON
+
+#if CVSSC_SPAN_NEON
+
+static inline uint16x8_t Div255x8(const uint16x8_t x) {
+    const uint16x8_t t = vaddq_u16(x, vdupq_n_u16(128));
+    return vshrq_n_u16(vaddq_u16(t, vshrq_n_u16(t, 8)), 8);
+}
+
+// expands 2 coverage values to 8 16 bit lanes (each value repeated for the 4 channels of its pixel)
+static inline uint16x8_t ExpandCoverage2(const uint8_t* const pCoverage) {
+    const uint16x4_t low = vdup_n_u16(pCoverage[0]);
+    const uint16x4_t high = vdup_n_u16(pCoverage[1]);
+    return vcombine_u16(low, high);
+}
+
+static void BlendNormalNEON(uint8_t* pPixels, const uint8_t* pCoverage, size_t pCount, const CVSSCSpanPaint pPaint) {
+    const uint16x8_t maximum = vdupq_n_u16(255);
+    const uint16x8_t alpha = vdupq_n_u16(pPaint.alpha);
+    const uint16_t colorValues[8] = {pPaint.red, pPaint.green, pPaint.blue, 255, pPaint.red, pPaint.green, pPaint.blue, 255};
+    const uint16x8_t color = vld1q_u16(colorValues);
+    for (; pCount >= 4; pCount -= 4, pPixels += 16, pCoverage += 4) {
+        if (0 == (pCoverage[0] | pCoverage[1] | pCoverage[2] | pCoverage[3])) {
+            continue;
+        }
+        const uint8x16_t pixels = vld1q_u8(pPixels);
+        const uint16x8_t aLow = Div255x8(vmulq_u16(alpha, ExpandCoverage2(pCoverage)));
+        const uint16x8_t aHigh = Div255x8(vmulq_u16(alpha, ExpandCoverage2(pCoverage + 2)));
+        const uint16x8_t dstLow = vmovl_u8(vget_low_u8(pixels));
+        const uint16x8_t dstHigh = vmovl_u8(vget_high_u8(pixels));
+        const uint16x8_t outLow = vaddq_u16(Div255x8(vmulq_u16(color, aLow)), Div255x8(vmulq_u16(dstLow, vsubq_u16(maximum, aLow))));
+        const uint16x8_t outHigh = vaddq_u16(Div255x8(vmulq_u16(color, aHigh)), Div255x8(vmulq_u16(dstHigh, vsubq_u16(maximum, aHigh))));
+        vst1q_u8(pPixels, vcombine_u8(vmovn_u16(outLow), vmovn_u16(outHigh)));
+    }
+    BlendNormalScalar(pPixels, pCoverage, pCount, pPaint);
+}
+
+static void BlendClearNEON(uint8_t* pPixels, const uint8_t* pCoverage, size_t pCount) {
+    const uint16x8_t maximum = vdupq_n_u16(255);
+    for (; pCount >= 4; pCount -= 4, pPixels += 16, pCoverage += 4) {
+        if (0 == (pCoverage[0] | pCoverage[1] | pCoverage[2] | pCoverage[3])) {
+            continue;
+        }
+        const uint8x16_t pixels = vld1q_u8(pPixels);
+        const uint16x8_t outLow = Div255x8(vmulq_u16(vmovl_u8(vget_low_u8(pixels)), vsubq_u16(maximum, ExpandCoverage2(pCoverage))));
+        const uint16x8_t outHigh = Div255x8(vmulq_u16(vmovl_u8(vget_high_u8(pixels)), vsubq_u16(maximum, ExpandCoverage2(pCoverage + 2))));
+        vst1q_u8(pPixels, vcombine_u8(vmovn_u16(outLow), vmovn_u16(outHigh)));
+    }
+    BlendClearScalar(pPixels, pCoverage, pCount);
+}
+
+static void CoverageMaxNEON(uint8_t* pCoverage, const uint8_t* pSource, size_t pCount) {
+    for (; pCount >= 16; pCount -= 16, pCoverage += 16, pSource += 16) {
+        vst1q_u8(pCoverage, vmaxq_u8(vld1q_u8(pCoverage), vld1q_u8(pSource)));
+    }
+    CoverageMaxScalar(pCoverage, pSource, pCount);
+}
+
+static void CoverageAddNEON(uint8_t* pCoverage, const uint8_t* pSource, size_t pCount) {
+    for (; pCount >= 16; pCount -= 16, pCoverage += 16, pSource += 16) {
+        vst1q_u8(pCoverage, vqaddq_u8(vld1q_u8(pCoverage), vld1q_u8(pSource)));
+    }
+    CoverageAddScalar(pCoverage, pSource, pCount);
+}
+
+static void CoverageMultiplyNEON(uint8_t* pCoverage, const uint8_t* pSource, size_t pCount) {
+    for (; pCount >= 16; pCount -= 16, pCoverage += 16, pSource += 16) {
+        const uint8x16_t coverage = vld1q_u8(pCoverage);
+        const uint8x16_t source = vld1q_u8(pSource);
+        const uint16x8_t low = Div255x8(vmull_u8(vget_low_u8(coverage), vget_low_u8(source)));
+        const uint16x8_t high = Div255x8(vmull_u8(vget_high_u8(coverage), vget_high_u8(source)));
+        vst1q_u8(pCoverage, vcombine_u8(vmovn_u16(low), vmovn_u16(high)));
+    }
+    CoverageMultiplyScalar(pCoverage, pSource, pCount);
+}
+
+typedef struct {
+    uint8x16_t color;
+    uint8x16_t tolerance;
+} MatchState;
+
+static inline MatchState MatchStateMake(const uint8_t* const pColor, const uint8_t pTolerance) {
+    uint32_t packed;
+    memcpy(&packed, pColor, sizeof(packed));
+    const MatchState result = {vreinterpretq_u8_u32(vdupq_n_u32(packed)), vdupq_n_u8(pTolerance)};
+    return result;
+}
+
+// bit n is set if pixel n of the 4 pixels matches
+static inline unsigned MatchBits4(const MatchState* const pState, const uint8_t* const pPixels) {
+    const uint8x16_t componentMatches = vcleq_u8(vabdq_u8(vld1q_u8(pPixels), pState->color), pState->tolerance);
+    const uint32x4_t pixelMatches = vceqq_u32(vreinterpretq_u32_u8(componentMatches), vdupq_n_u32(0xFFFFFFFFU));
+    // one 16 bit lane per pixel
+    const uint64_t lanes = vget_lane_u64(vreinterpret_u64_u16(vmovn_u32(pixelMatches)), 0);
+    return (unsigned)((lanes & 1U) | ((lanes >> 15) & 2U) | ((lanes >> 30) & 4U) | ((lanes >> 45) & 8U));
+}
+
+#endif
+
+#pragma mark - Vector Matching
+
+#if CVSSC_SPAN_SSE2 || CVSSC_SPAN_NEON
+
+static size_t MatchLengthVector(const uint8_t* const pPixels, const size_t pCount, const uint8_t* const pColor, const uint8_t pTolerance, const bool pMatching) {
+    const MatchState state = MatchStateMake(pColor, pTolerance);
+    const unsigned expected = pMatching ? 0xFU : 0U;
+    size_t result = 0;
+    for (; result + 4 <= pCount; result += 4) {
+        const unsigned bits = MatchBits4(&state, pPixels + 4 * result);
+        if (expected != bits) {
+            // the first pixel which differs
+            unsigned differs = (bits ^ expected) & 0xFU;
+            while (!(differs & 1U)) {
+                differs >>= 1;
+                ++result;
+            }
+            return result;
+        }
+    }
+    return result + MatchLengthScalar(pPixels + 4 * result, pCount - result, pColor, pTolerance, pMatching);
+}
+
+static size_t MatchLengthReverseVector(const uint8_t* const pPixels, const size_t pCount, const uint8_t* const pColor, const uint8_t pTolerance, const bool pMatching) {
+    const MatchState state = MatchStateMake(pColor, pTolerance);
+    const unsigned expected = pMatching ? 0xFU : 0U;
+    size_t result = 0;
+    for (; result + 4 <= pCount; result += 4) {
+        // the 4 pixels which end at the pixel result pixels before the last
+        const unsigned bits = MatchBits4(&state, pPixels - 4 * (result + 3));
+        if (expected != bits) {
+            // the last pixel which differs
+            unsigned differs = ((bits ^ expected) << 1) & 0x1EU;
+            while (!(differs & 0x10U)) {
+                differs <<= 1;
+                ++result;
+            }
+            return result;
+        }
+    }
+    return result + MatchLengthReverseScalar(pPixels - 4 * result, pCount - result, pColor, pTolerance, pMatching);
+}
+
+#endif
+
+#pragma mark - Public
+
+void CVSSCSpanBlendNormal(uint8_t* const pPixels, const uint8_t* const pCoverage, const size_t pCount, const CVSSCSpanPaint pPaint) {
+#if CVSSC_SPAN_SSE2
+    BlendNormalSSE2(pPixels, pCoverage, pCount, pPaint);
+#elif CVSSC_SPAN_NEON
+    BlendNormalNEON(pPixels, pCoverage, pCount, pPaint);
+#else
+    BlendNormalScalar(pPixels, pCoverage, pCount, pPaint);
+#endif
+}
+
+void CVSSCSpanBlendClear(uint8_t* const pPixels, const uint8_t* const pCoverage, const size_t pCount) {
+#if CVSSC_SPAN_SSE2
+    BlendClearSSE2(pPixels, pCoverage, pCount);
+#elif CVSSC_SPAN_NEON
+    BlendClearNEON(pPixels, pCoverage, pCount);
+#else
+    BlendClearScalar(pPixels, pCoverage, pCount);
+#endif
+}
+
+void CVSSCSpanCoverageMax(uint8_t* const pCoverage, const uint8_t* const pSource, const size_t pCount) {
+#if CVSSC_SPAN_SSE2
+    CoverageMaxSSE2(pCoverage, pSource, pCount);
+#elif CVSSC_SPAN_NEON
+    CoverageMaxNEON(pCoverage, pSource, pCount);
+#else
+    CoverageMaxScalar(pCoverage, pSource, pCount);
+#endif
+}
+
+void CVSSCSpanCoverageAdd(uint8_t* const pCoverage, const uint8_t* const pSource, const size_t pCount) {
+#if CVSSC_SPAN_SSE2
+    CoverageAddSSE2(pCoverage, pSource, pCount);
+#elif CVSSC_SPAN_NEON
+    CoverageAddNEON(pCoverage, pSource, pCount);
+#else
+    CoverageAddScalar(pCoverage, pSource, pCount);
+#endif
+}
+
+void CVSSCSpanCoverageMultiply(uint8_t* const pCoverage, const uint8_t* const pSource, const size_t pCount) {
+#if CVSSC_SPAN_SSE2
+    CoverageMultiplySSE2(pCoverage, pSource, pCount);
+#elif CVSSC_SPAN_NEON
+    CoverageMultiplyNEON(pCoverage, pSource, pCount);
+#else
+    CoverageMultiplyScalar(pCoverage, pSource, pCount);
+#endif
+}
+
+size_t CVSSCSpanMatchLength(const uint8_t* const pPixels, const size_t pCount, const uint8_t* const pColor, const uint8_t pTolerance, const bool pMatching) {
+#if CVSSC_SPAN_SSE2 || CVSSC_SPAN_NEON
+    return MatchLengthVector(pPixels, pCount, pColor, pTolerance, pMatching);
+#else
+    return MatchLengthScalar(pPixels, pCount, pColor, pTolerance, pMatching);
+#endif
+}
+
+size_t CVSSCSpanMatchLengthReverse(const uint8_t* const pPixels, const size_t pCount, const uint8_t* const pColor, const uint8_t pTolerance, const bool pMatching) {
+#if CVSSC_SPAN_SSE2 || CVSSC_SPAN_NEON
+    return MatchLengthReverseVector(pPixels, pCount, pColor, pTolerance, pMatching);
+#else
+    return MatchLengthReverseScalar(pPixels, pCount, pColor, pTolerance, pMatching);
+#endif
+}
+
+const char* CVSSCSpanImplementationName(void) {
+#if CVSSC_SPAN_SSE2
+    return "SSE2";
+#elif CVSSC_SPAN_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,79 @@
+// CVSSCSpan.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCSpan_h
+#define CVSStrokeCore_CVSSCSpan_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Span compositing of a coverage mask into 8bpc RGBA premultiplied pixels, accumulation of coverage masks, and color matching of those pixels. SSE2 and NEON implementations are used when
+ the compiler targets them, otherwise a scalar implementation is used. All implementations produce identical results.
+ define CVSSC_SPAN_SCALAR to build the scalar implementation on any target.
+ */
+
+/**
+ @brief a paint source. the components are 8 bit, not premultiplied.
+ */
+typedef struct {
+    uint8_t red;
+    uint8_t green;
+    uint8_t blue;
+    /** @brief the brush alpha (color alpha x brush alpha) */
+    uint8_t alpha;
+} CVSSCSpanPaint;
+
+/**
+ @brief source-over: for each pixel, the paint with alpha (paint.alpha x coverage) is composited over the pixel. (kCGBlendModeNormal)
+ */
+extern void CVSSCSpanBlendNormal(uint8_t* const pPixels, const uint8_t* const pCoverage, const size_t pCount, const CVSSCSpanPaint pPaint);
+
+/**
+ @brief clear: for each pixel, the pixel is reduced by coverage. (kCGBlendModeClear)
+ */
+extern void CVSSCSpanBlendClear(uint8_t* const pPixels, const uint8_t* const pCoverage, const size_t pCount);
+
+/**
+ @brief for each value, the greater of the coverage and the source. (a union of shapes, e.g. overlapping dabs of a crayon)
+ */
+extern void CVSSCSpanCoverageMax(uint8_t* const pCoverage, const uint8_t* const pSource, const size_t pCount);
+
+/**
+ @brief for each value, the sum of the coverage and the source, saturated at 255. (a build up, e.g. of the specks of a spray)
+ */
+extern void CVSSCSpanCoverageAdd(uint8_t* const pCoverage, const uint8_t* const pSource, const size_t pCount);
+
+/**
+ @brief for each value, the product of the coverage and the source, each in [0...255] as [0...1]. (a mask of the coverage, e.g. a texture)
+ */
+extern void CVSSCSpanCoverageMultiply(uint8_t* const pCoverage, const uint8_t* const pSource, const size_t pCount);
+
+/**
+ @return the number of leading pixels of @p pPixels (at most @p pCount) whose match of @p pColor is @p pMatching. a pixel
+ matches if none of its 4 components differs from the color's by more than @p pTolerance.
+ @param pColor a pixel, premultiplied (as the pixels are stored)
+ */
+extern size_t CVSSCSpanMatchLength(const uint8_t* const pPixels, const size_t pCount, const uint8_t* const pColor, const uint8_t pTolerance, const bool pMatching);
+
+/**
+ @brief as CVSSCSpanMatchLength, leftwards: @p pPixels is the last pixel of the span, and the pixels before it are matched.
+ */
+extern size_t CVSSCSpanMatchLengthReverse(const uint8_t* const pPixels, const size_t pCount, const uint8_t* const pColor, const uint8_t pTolerance, const bool pMatching);
+
+/**
+ @return the name of the implementation in use ("SSE2", "NEON" or "scalar")
+ */
+extern const char* CVSSCSpanImplementationName(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
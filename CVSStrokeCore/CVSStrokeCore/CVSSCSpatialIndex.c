@@ -0,0 +1,432 @@
+// CVSSCSpatialIndex.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CVSSCMemory.h"
+#include "CVSSCSpatialIndex.h"
+
+// items which cover more cells than this are kept in the large item list
+enum { LargeItemCellCount = 16 };
+// cell coordinates beyond this magnitude are not stored in cells (avoids overflowing the range arithmetic)
+static const double MaxCellCoordinate = 1 << 24;
+
+typedef struct {
+    uint64_t key;
+    CVSSCRect bounds;
+    bool isLive;
+} Item;
+
+typedef struct {
+    int32_t column;
+    int32_t row;
+    bool isOccupied;
+    size_t count;
+    size_t capacity;
+    uint64_t* keys;
+} Cell;
+
+// an inclusive range of cells
+typedef struct {
+    int32_t minColumn;
+    int32_t minRow;
+    int32_t maxColumn;
+    int32_t maxRow;
+} CellRange;
+
+struct CVSSCSpatialIndex {
+    double cellSize;
+    // ordered by key. removed items remain until the index is purged.
+    Item* items;
+    size_t itemCount;
+    size_t itemCapacity;
+    size_t liveCount;
+    // removals whose cell entries have not been purged
+    size_t staleCount;
+    // open addressing, the capacity is a power of 2
+    Cell* cells;
+    size_t cellCapacity;
+    size_t occupiedCellCount;
+    // the range of the occupied cells, valid if occupiedCellCount
+    CellRange extent;
+    uint64_t* largeKeys;
+    size_t largeCount;
+    size_t largeCapacity;
+    uint64_t* results;
+    size_t resultCapacity;
+};
+
+#pragma mark - Buffers
+
+// grows the buffer to hold at least pCount elements
+static bool Reserve(void** const pBuffer, size_t* const pCapacity, const size_t pCount, const size_t pElementSize) {
+    if (pCount <= *pCapacity) {
+        return true;
+    }
+    size_t capacity = *pCapacity ? *pCapacity : 16;
+    while (capacity < pCount) {
+        capacity *= 2;
+    }
+    void* const buffer = CVSSCReallocate(*pBuffer, capacity * pElementSize);
+    if (!buffer) {
+        return false;
+    }
+    *pBuffer = buffer;
+    *pCapacity = capacity;
+    return true;
+}
+
+static bool AppendKey(uint64_t** const pKeys, size_t* const pCount, size_t* const pCapacity, const uint64_t pKey) {
+    void* keys = *pKeys;
+    if (!Reserve(&keys, pCapacity, *pCount + 1, sizeof(uint64_t))) {
+        return false;
+    }
+    *pKeys = keys;
+    (*pKeys)[(*pCount)++] = pKey;
+    return true;
+}
+
+#pragma mark - Cells
+
+static size_t CellHash(const int32_t pColumn, const int32_t pRow) {
+    return (size_t)(((uint32_t)pColumn * 0x9E3779B1u) ^ ((uint32_t)pRow * 0x85EBCA77u));
+}
+
+// returns the cell's slot, or the empty slot where it would be inserted
+static Cell* FindCellSlot(Cell* const pCells, const size_t pCapacity, const int32_t pColumn, const int32_t pRow) {
+    const size_t mask = pCapacity - 1;
+    for (size_t slot = CellHash(pColumn, pRow) & mask;; slot = (slot + 1) & mask) {
+        Cell* const cell = &pCells[slot];
+        if (!cell->isOccupied || (cell->column == pColumn && cell->row == pRow)) {
+            return cell;
+        }
+    }
+}
+
+static bool GrowCells(CVSSCSpatialIndex* const pIndex) {
+    const size_t capacity = pIndex->cellCapacity ? pIndex->cellCapacity * 2 : 64;
+    Cell* const cells = CVSSCAllocate(capacity * sizeof(Cell));
+    if (!cells) {
+        return false;
+    }
+    memset(cells, 0, capacity * sizeof(Cell));
+    for (size_t idx = 0; idx < pIndex->cellCapacity; ++idx) {
+        const Cell* const cell = &pIndex->cells[idx];
+        if (cell->isOccupied) {
+            *FindCellSlot(cells, capacity, cell->column, cell->row) = *cell;
+        }
+    }
+    CVSSCFree(pIndex->cells);
+    pIndex->cells = cells;
+    pIndex->cellCapacity = capacity;
+    return true;
+}
+
+// returns the cell, creating it if needed, or NULL on allocation failure
+static Cell* GetCell(CVSSCSpatialIndex* const pIndex, const int32_t pColumn, const int32_t pRow) {
+    if (pIndex->cellCapacity) {
+        Cell* const cell = FindCellSlot(pIndex->cells, pIndex->cellCapacity, pColumn, pRow);
+        if (cell->isOccupied) {
+            return cell;
+        }
+    }
+    // keep the load factor at or below 1/2
+    if (2 * (pIndex->occupiedCellCount + 1) > pIndex->cellCapacity && !GrowCells(pIndex)) {
+        return NULL;
+    }
+    Cell* const cell = FindCellSlot(pIndex->cells, pIndex->cellCapacity, pColumn, pRow);
+    assert(!cell->isOccupied);
+    cell->column = pColumn;
+    cell->row = pRow;
+    cell->isOccupied = true;
+    if (pIndex->occupiedCellCount) {
+        pIndex->extent.minColumn = pColumn < pIndex->extent.minColumn ? pColumn : pIndex->extent.minColumn;
+        pIndex->extent.minRow = pRow < pIndex->extent.minRow ? pRow : pIndex->extent.minRow;
+        pIndex->extent.maxColumn = pColumn > pIndex->extent.maxColumn ? pColumn : pIndex->extent.maxColumn;
+        pIndex->extent.maxRow = pRow > pIndex->extent.maxRow ? pRow : pIndex->extent.maxRow;
+    }
+    else {
+        pIndex->extent = (CellRange){pColumn, pRow, pColumn, pRow};
+    }
+    ++pIndex->occupiedCellCount;
+    return cell;
+}
+
+// returns false if the rect is null, empty or too far from the origin to be stored in cells
+static bool GetCellRange(const CVSSCSpatialIndex* const pIndex, const CVSSCRect pRect, CellRange* const pOutRange) {
+    if (CVSSCRectIsNull(pRect) || !(0 < pRect.width) || !(0 < pRect.height)) {
+        return false;
+    }
+    const double minColumn = floor(pRect.x / pIndex->cellSize);
+    const double minRow = floor(pRect.y / pIndex->cellSize);
+    // the max edge is exclusive -- a rect which ends on a cell boundary does not intersect the next cell
+    const double maxColumn = ceil((pRect.x + pRect.width) / pIndex->cellSize) - 1;
+    const double maxRow = ceil((pRect.y + pRect.height) / pIndex->cellSize) - 1;
+    if (!(fabs(minColumn) < MaxCellCoordinate && fabs(minRow) < MaxCellCoordinate && fabs(maxColumn) < MaxCellCoordinate && fabs(maxRow) < MaxCellCoordinate)) {
+        return false;
+    }
+    *pOutRange = (CellRange){
+        (int32_t)minColumn,
+        (int32_t)minRow,
+        (int32_t)(maxColumn < minColumn ? minColumn : maxColumn),
+        (int32_t)(maxRow < minRow ? minRow : maxRow)
+    };
+    return true;
+}
+
+static size_t CellRangeGetCount(const CellRange pRange) {
+    return (size_t)(pRange.maxColumn - pRange.minColumn + 1) * (size_t)(pRange.maxRow - pRange.minRow + 1);
+}
+
+// adds the item's key to its cells, or to the large item list
+static bool AddItemToCells(CVSSCSpatialIndex* const pIndex, const Item* const pItem) {
+    if (CVSSCRectIsNull(pItem->bounds)) {
+        return true;
+    }
+    CellRange range;
+    if (!GetCellRange(pIndex, pItem->bounds, &range) || LargeItemCellCount < CellRangeGetCount(range)) {
+        return AppendKey(&pIndex->largeKeys, &pIndex->largeCount, &pIndex->largeCapacity, pItem->key);
+    }
+    for (int32_t row = range.minRow; row <= range.maxRow; ++row) {
+        for (int32_t column = range.minColumn; column <= range.maxColumn; ++column) {
+            Cell* const cell = GetCell(pIndex, column, row);
+            if (!cell || !AppendKey(&cell->keys, &cell->count, &cell->capacity, pItem->key)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// removes the removed items and their cell entries. the cells are retained.
+static bool Purge(CVSSCSpatialIndex* const pIndex) {
+    for (size_t idx = 0; idx < pIndex->cellCapacity; ++idx) {
+        pIndex->cells[idx].count = 0;
+    }
+    pIndex->largeCount = 0;
+    size_t liveCount = 0;
+    for (size_t idx = 0; idx < pIndex->itemCount; ++idx) {
+        if (pIndex->items[idx].isLive) {
+            pIndex->items[liveCount++] = pIndex->items[idx];
+        }
+    }
+    assert(liveCount == pIndex->liveCount);
+    pIndex->itemCount = liveCount;
+    pIndex->staleCount = 0;
+    for (size_t idx = 0; idx < pIndex->itemCount; ++idx) {
+        if (!AddItemToCells(pIndex, &pIndex->items[idx])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#pragma mark - Items
+
+// returns the position of the first item whose key is not less than pKey
+static size_t LowerBound(const CVSSCSpatialIndex* const pIndex, const uint64_t pKey) {
+    size_t low = 0;
+    size_t high = pIndex->itemCount;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (pIndex->items[mid].key < pKey) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+static int CompareKeys(const void* const pA, const void* const pB) {
+    const uint64_t a = *(const uint64_t*)pA;
+    const uint64_t b = *(const uint64_t*)pB;
+    return (a > b) - (a < b);
+}
+
+#pragma mark - Interface
+
+CVSSCSpatialIndex* CVSSCSpatialIndexCreate(const double pCellSize) {
+    assert(0 < pCellSize);
+    CVSSCSpatialIndex* const result = CVSSCAllocate(sizeof(CVSSCSpatialIndex));
+    if (!result) {
+        return NULL;
+    }
+    memset(result, 0, sizeof(CVSSCSpatialIndex));
+    result->cellSize = pCellSize;
+    return result;
+}
+
+void CVSSCSpatialIndexDestroy(CVSSCSpatialIndex* const pIndex) {
+    if (!pIndex) {
+        return;
+    }
+    for (size_t idx = 0; idx < pIndex->cellCapacity; ++idx) {
+        CVSSCFree(pIndex->cells[idx].keys);
+    }
+    CVSSCFree(pIndex->cells);
+    CVSSCFree(pIndex->items);
+    CVSSCFree(pIndex->largeKeys);
+    CVSSCFree(pIndex->results);
+    CVSSCFree(pIndex);
+}
+
+size_t CVSSCSpatialIndexGetCount(const CVSSCSpatialIndex* const pIndex) {
+    assert(pIndex);
+    return pIndex->liveCount;
+}
+
+bool CVSSCSpatialIndexInsert(CVSSCSpatialIndex* const pIndex, const uint64_t pKey, const CVSSCRect pBounds) {
+    assert(pIndex);
+    // removed items at the end may have keys which are being reused. their cell entries remain stale.
+    while (pIndex->itemCount && pKey <= pIndex->items[pIndex->itemCount - 1].key && !pIndex->items[pIndex->itemCount - 1].isLive) {
+        --pIndex->itemCount;
+    }
+    if (pIndex->itemCount && pKey <= pIndex->items[pIndex->itemCount - 1].key) {
+        assert(0 && "keys must be inserted in ascending order");
+        return false;
+    }
+    void* items = pIndex->items;
+    if (!Reserve(&items, &pIndex->itemCapacity, pIndex->itemCount + 1, sizeof(Item))) {
+        return false;
+    }
+    pIndex->items = items;
+    Item* const item = &pIndex->items[pIndex->itemCount];
+    *item = (Item){pKey, pBounds, true};
+    if (!AddItemToCells(pIndex, item)) {
+        // some cells may hold the key. they are stale now.
+        item->isLive = false;
+        ++pIndex->itemCount;
+        ++pIndex->staleCount;
+        return false;
+    }
+    ++pIndex->itemCount;
+    ++pIndex->liveCount;
+    return true;
+}
+
+bool CVSSCSpatialIndexRemove(CVSSCSpatialIndex* const pIndex, const uint64_t pKey) {
+    assert(pIndex);
+    const size_t position = LowerBound(pIndex, pKey);
+    if (position == pIndex->itemCount || pIndex->items[position].key != pKey || !pIndex->items[position].isLive) {
+        return false;
+    }
+    pIndex->items[position].isLive = false;
+    --pIndex->liveCount;
+    ++pIndex->staleCount;
+    // purging is linear in the number of items, so it is deferred until it is amortized by the removals
+    if (pIndex->staleCount > pIndex->liveCount + 64) {
+        // the purge only fails if it could not restore entries which it removed. the queries would miss those items.
+        const bool purged = Purge(pIndex);
+        assert(purged && "failed to purge the spatial index");
+        (void)purged;
+    }
+    return true;
+}
+
+void CVSSCSpatialIndexRemoveAll(CVSSCSpatialIndex* const pIndex) {
+    assert(pIndex);
+    for (size_t idx = 0; idx < pIndex->cellCapacity; ++idx) {
+        pIndex->cells[idx].count = 0;
+    }
+    pIndex->largeCount = 0;
+    pIndex->itemCount = 0;
+    pIndex->liveCount = 0;
+    pIndex->staleCount = 0;
+}
+
+bool CVSSCSpatialIndexQuery(CVSSCSpatialIndex* const pIndex, const CVSSCRect pRect, const uint64_t** const pOutKeys, size_t* const pOutCount) {
+    assert(pIndex);
+    assert(pOutKeys);
+    assert(pOutCount);
+    *pOutKeys = pIndex->results;
+    *pOutCount = 0;
+    if (!pIndex->liveCount || CVSSCRectIsNull(pRect)) {
+        return true;
+    }
+    // gather the candidates: the keys of the cells within the rect, and the large items
+    size_t count = 0;
+    CellRange range;
+    if (!GetCellRange(pIndex, pRect, &range)) {
+        // the rect is beyond the cells' range. every cell is a candidate.
+        range = pIndex->extent;
+    }
+    else if (pIndex->occupiedCellCount) {
+        range.minColumn = range.minColumn < pIndex->extent.minColumn ? pIndex->extent.minColumn : range.minColumn;
+        range.minRow = range.minRow < pIndex->extent.minRow ? pIndex->extent.minRow : range.minRow;
+        range.maxColumn = range.maxColumn > pIndex->extent.maxColumn ? pIndex->extent.maxColumn : range.maxColumn;
+        range.maxRow = range.maxRow > pIndex->extent.maxRow ? pIndex->extent.maxRow : range.maxRow;
+    }
+    if (pIndex->occupiedCellCount && range.minColumn <= range.maxColumn && range.minRow <= range.maxRow) {
+        const bool visitOccupiedCells = pIndex->occupiedCellCount < CellRangeGetCount(range);
+        const size_t visitCount = visitOccupiedCells ? pIndex->cellCapacity : CellRangeGetCount(range);
+        for (size_t idx = 0; idx < visitCount; ++idx) {
+            const Cell* cell = NULL;
+            if (visitOccupiedCells) {
+                cell = &pIndex->cells[idx];
+                if (!cell->isOccupied || cell->column < range.minColumn || cell->column > range.maxColumn || cell->row < range.minRow || cell->row > range.maxRow) {
+                    continue;
+                }
+            }
+            else {
+                const int32_t columnCount = range.maxColumn - range.minColumn + 1;
+                const int32_t column = range.minColumn + (int32_t)(idx % (size_t)columnCount);
+                const int32_t row = range.minRow + (int32_t)(idx / (size_t)columnCount);
+                cell = FindCellSlot(pIndex->cells, pIndex->cellCapacity, column, row);
+                if (!cell->isOccupied) {
+                    continue;
+                }
+            }
+            if (!cell->count) {
+                continue;
+            }
+            void* results = pIndex->results;
+            if (!Reserve(&results, &pIndex->resultCapacity, count + cell->count, sizeof(uint64_t))) {
+                return false;
+            }
+            pIndex->results = results;
+            memcpy(&pIndex->results[count], cell->keys, cell->count * sizeof(uint64_t));
+            count += cell->count;
+        }
+    }
+    if (pIndex->largeCount) {
+        void* results = pIndex->results;
+        if (!Reserve(&results, &pIndex->resultCapacity, count + pIndex->largeCount, sizeof(uint64_t))) {
+            return false;
+        }
+        pIndex->results = results;
+        memcpy(&pIndex->results[count], pIndex->largeKeys, pIndex->largeCount * sizeof(uint64_t));
+        count += pIndex->largeCount;
+    }
+    if (!count) {
+        return true;
+    }
+    // an item which covers several cells is a candidate once per cell. the candidates are filtered in place, walking
+    // the items alongside them (both are in ascending order).
+    qsort(pIndex->results, count, sizeof(uint64_t), CompareKeys);
+    size_t resultCount = 0;
+    size_t position = 0;
+    for (size_t idx = 0; idx < count; ++idx) {
+        const uint64_t key = pIndex->results[idx];
+        if (resultCount && pIndex->results[resultCount - 1] == key) {
+            continue;
+        }
+        while (position < pIndex->itemCount && pIndex->items[position].key < key) {
+            ++position;
+        }
+        if (position == pIndex->itemCount) {
+            break;
+        }
+        const Item* const item = &pIndex->items[position];
+        if (item->key == key && item->isLive && CVSSCRectIntersectsRect(item->bounds, pRect)) {
+            pIndex->results[resultCount++] = key;
+        }
+    }
+    *pOutKeys = pIndex->results;
+    *pOutCount = resultCount;
+    return true;
+}
@@ -0,0 +1,71 @@
+// CVSSCSpatialIndex.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCSpatialIndex_h
+#define CVSStrokeCore_CVSSCSpatialIndex_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CVSSCGeometry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ A uniform grid of item bounds, for finding the items which intersect a rect (e.g. the strokes under a dirty rect)
+ without visiting every item. Items are identified by keys which the client assigns in ascending order -- the order in
+ which the strokes are drawn -- and queries return keys in ascending order.
+ Only the occupied cells are allocated, so the grid is unbounded. Items which cover many cells are kept in a separate
+ list rather than in every cell. Removal is lazy: a removed item's cell entries are skipped by queries and purged when
+ enough of them have accumulated.
+ */
+typedef struct CVSSCSpatialIndex CVSSCSpatialIndex;
+
+/**
+ @brief the default cell size, in the units of the bounds (points).
+ */
+enum { CVSSCSpatialIndexDefaultCellSize = 64 };
+
+/**
+ @return a new empty index, or NULL. destroy it with CVSSCSpatialIndexDestroy.
+ */
+extern CVSSCSpatialIndex* CVSSCSpatialIndexCreate(const double pCellSize);
+extern void CVSSCSpatialIndexDestroy(CVSSCSpatialIndex* const pIndex);
+
+/**
+ @return the number of items in the index
+ */
+extern size_t CVSSCSpatialIndexGetCount(const CVSSCSpatialIndex* const pIndex);
+
+/**
+ @brief adds an item. @p pKey must be greater than the key of every item in the index (a removed item's key may be reused).
+ an item with null bounds is held, but is never returned by a query.
+ @return false on allocation failure, in which case the index is unchanged.
+ */
+extern bool CVSSCSpatialIndexInsert(CVSSCSpatialIndex* const pIndex, const uint64_t pKey, const CVSSCRect pBounds);
+
+/**
+ @brief removes the item. @return false if there is no item with the key.
+ */
+extern bool CVSSCSpatialIndexRemove(CVSSCSpatialIndex* const pIndex, const uint64_t pKey);
+
+/**
+ @brief removes every item. the index retains its allocations.
+ */
+extern void CVSSCSpatialIndexRemoveAll(CVSSCSpatialIndex* const pIndex);
+
+/**
+ @brief finds the items whose bounds intersect @p pRect (as CVSSCRectIntersectsRect).
+ @p pOutKeys is set to the keys, in ascending order. the keys are owned by the index and are valid until it is next mutated or queried.
+ @return false on allocation failure.
+ */
+extern bool CVSSCSpatialIndexQuery(CVSSCSpatialIndex* const pIndex, const CVSSCRect pRect, const uint64_t** const pOutKeys, size_t* const pOutCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
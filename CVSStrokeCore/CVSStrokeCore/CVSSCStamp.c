@@ -0,0 +1,531 @@
+// CVSSCStamp.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "CVSSCMemory.h"
+#include "CVSSCRaster.h"
+#include "CVSSCSpan.h"
+#include "CVSSCStamp.h"
+
+// the variants of each stamp
+enum { StampVariantCount = 4 };
+// the largest dab, in pixels. larger dabs (e.g. at an extreme scale) are stamped at this size.
+enum { MaximumStampSize = 512 };
+// the most dabs one component places. the dabs of a longer component are spaced further apart.
+enum { MaximumComponentDabCount = 4096 };
+// the most points a single curve is flattened to
+enum { MaximumCurveSegmentCount = 256 };
+// the crayon's paper grain is a tile of GrainSize x GrainSize pixels, repeated over the bitmap
+enum { GrainSize = 64 };
+
+typedef struct {
+    // the diameter of a dab, as a fraction of the brush's width
+    double dabScale;
+    // the distance between dabs, as a fraction of a dab's diameter
+    double spacing;
+    // the greatest offset of a dab's center on each axis, as a fraction of the brush's width. a dab is within the
+    // brush's width of the path: dabScale / 2 + jitter * sqrt(2) <= 1 / 2.
+    double jitter;
+    // true if the dabs are added, false if they are combined (max)
+    bool accumulates;
+    // true if the coverage is masked by the paper grain
+    bool grained;
+    // seeds the stamps and the dabs' jitter
+    uint32_t seed;
+} StampStyle;
+
+static const StampStyle kSprayStampStyle = {
+    .dabScale = 0.8,
+    .spacing = 0.2,
+    .jitter = 0.07,
+    .accumulates = true,
+    .grained = false,
+    .seed = 0x5350A1U
+};
+
+static const StampStyle kCrayonStampStyle = {
+    .dabScale = 0.9,
+    .spacing = 0.15,
+    .jitter = 0.035,
+    .accumulates = false,
+    .grained = true,
+    .seed = 0xC4A70U
+};
+
+// the fraction of the spray's pixels which are specks at the center of a dab. it falls off to 0 at the edge.
+static const double SprayDensity = 0.25;
+// the most the crayon's radius is pulled in at a pixel of its edge, as a fraction of the radius
+static const double CrayonRaggedness = 0.2;
+// grain values below the floor are bare paper; those above the ceiling take all of the crayon
+static const double GrainFloor = 0.2;
+static const double GrainCeiling = 0.6;
+
+typedef struct {
+    // CVSSCBrushStampNone until the masks are generated
+    CVSSCBrushStamp kind;
+    int32_t size;
+    // StampVariantCount masks of size x size
+    uint8_t* masks;
+    size_t capacity;
+} Stamp;
+
+// a dab, placed at its top left pixel
+typedef struct {
+    int32_t x;
+    int32_t y;
+    uint32_t variant;
+} Dab;
+
+// maxX == 0 means the row is untouched
+typedef struct {
+    int32_t minX;
+    int32_t maxX;
+} RowExtent;
+
+struct CVSSCStamper {
+    // one stamp per stamped brush, indexed by CVSSCBrushStamp - 1
+    Stamp stamps[2];
+    uint8_t grain[GrainSize * GrainSize];
+    // the dabs of the current stroke
+    Dab* dabs;
+    size_t dabCount;
+    size_t dabCapacity;
+    // the device space points of the current component, flattened
+    CVSSCPoint* points;
+    size_t pointCount;
+    size_t pointCapacity;
+    // coverage of the current stroke, one byte per pixel of maskRect
+    uint8_t* mask;
+    size_t maskCapacity;
+    CVSSCPixelRect maskRect;
+    // the touched columns of each mask row
+    RowExtent* rows;
+    size_t rowCapacity;
+    // the grain of a mask row
+    uint8_t* grainRow;
+    size_t grainRowCapacity;
+};
+
+#pragma mark - Randomness
+
+// a 32 bit integer hash (lowbias32). every stamp and every jitter is a hash of fixed values, so they are the same on every target.
+static inline uint32_t Hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7FEB352DU;
+    x ^= x >> 15;
+    x *= 0x846CA68BU;
+    x ^= x >> 16;
+    return x;
+}
+
+static inline uint32_t HashPixel(const uint32_t pSeed, const int32_t pX, const int32_t pY) {
+    return Hash32(pSeed ^ Hash32((uint32_t)pX ^ Hash32((uint32_t)pY)));
+}
+
+// [0...1)
+static inline double UnitFromHash(const uint32_t pHash) {
+    return (double)(pHash >> 8) * (1.0 / 16777216.0);
+}
+
+static inline uint32_t NextRandom(uint32_t* const pState) {
+    *pState += 0x9E3779B9U;
+    return Hash32(*pState);
+}
+
+#pragma mark - Scratch
+
+static bool Reserve(void** const pMemory, size_t* const pCapacity, const size_t pCount, const size_t pElementSize) {
+    if (pCount <= *pCapacity) {
+        return true;
+    }
+    size_t capacity = *pCapacity ? *pCapacity : 64;
+    while (capacity < pCount) {
+        capacity *= 2;
+    }
+    void* const memory = CVSSCReallocate(*pMemory, capacity * pElementSize);
+    if (!memory) {
+        return false;
+    }
+    *pMemory = memory;
+    *pCapacity = capacity;
+    return true;
+}
+
+#pragma mark - Stamps
+
+static const StampStyle* StyleForStamp(const CVSSCBrushStamp pStamp) {
+    return CVSSCBrushStampCrayon == pStamp ? &kCrayonStampStyle : &kSprayStampStyle;
+}
+
+// sparse specks, denser toward the center
+static void GenerateSprayMask(uint8_t* const pMask, const int32_t pSize, const uint32_t pSeed) {
+    const double radius = 0.5 * pSize;
+    for (int32_t y = 0; y < pSize; ++y) {
+        for (int32_t x = 0; x < pSize; ++x) {
+            const double dx = x + 0.5 - radius;
+            const double dy = y + 0.5 - radius;
+            const double distanceSquared = (dx * dx + dy * dy) / (radius * radius);
+            uint8_t coverage = 0;
+            if (distanceSquared < 1.0) {
+                const double falloff = 1.0 - distanceSquared;
+                const uint32_t hash = HashPixel(pSeed, x, y);
+                if (UnitFromHash(hash) < SprayDensity * falloff * falloff) {
+                    coverage = (uint8_t)(64 + (Hash32(hash) >> 25));
+                }
+            }
+            pMask[(size_t)y * (size_t)pSize + (size_t)x] = coverage;
+        }
+    }
+}
+
+// a disc whose edge is ragged
+static void GenerateCrayonMask(uint8_t* const pMask, const int32_t pSize, const uint32_t pSeed) {
+    const double radius = 0.5 * pSize;
+    for (int32_t y = 0; y < pSize; ++y) {
+        for (int32_t x = 0; x < pSize; ++x) {
+            const double dx = x + 0.5 - radius;
+            const double dy = y + 0.5 - radius;
+            const double ragged = radius * (1.0 - CrayonRaggedness * UnitFromHash(HashPixel(pSeed, x, y)));
+            const double coverage = ragged - sqrt(dx * dx + dy * dy) + 0.5;
+            pMask[(size_t)y * (size_t)pSize + (size_t)x] = coverage <= 0.0 ? 0 : (coverage >= 1.0 ? 255 : (uint8_t)(coverage * 255.0 + 0.5));
+        }
+    }
+}
+
+// value noise on a lattice which wraps at the tile's edges, roughened by per pixel noise
+static void GenerateGrain(uint8_t* const pGrain, const uint32_t pSeed) {
+    enum { LatticeSpacing = 4, LatticeCount = GrainSize / LatticeSpacing };
+    for (int32_t y = 0; y < GrainSize; ++y) {
+        const int32_t row = y / LatticeSpacing;
+        const double fy = (double)(y % LatticeSpacing) / LatticeSpacing;
+        for (int32_t x = 0; x < GrainSize; ++x) {
+            const int32_t column = x / LatticeSpacing;
+            const double fx = (double)(x % LatticeSpacing) / LatticeSpacing;
+            const double v00 = UnitFromHash(HashPixel(pSeed, column, row));
+            const double v10 = UnitFromHash(HashPixel(pSeed, (column + 1) % LatticeCount, row));
+            const double v01 = UnitFromHash(HashPixel(pSeed, column, (row + 1) % LatticeCount));
+            const double v11 = UnitFromHash(HashPixel(pSeed, (column + 1) % LatticeCount, (row + 1) % LatticeCount));
+            const double smooth = (v00 * (1.0 - fx) + v10 * fx) * (1.0 - fy) + (v01 * (1.0 - fx) + v11 * fx) * fy;
+            const double value = 0.65 * smooth + 0.35 * UnitFromHash(HashPixel(pSeed + 1U, x, y));
+            const double grain = (value - GrainFloor) / (GrainCeiling - GrainFloor);
+            pGrain[y * GrainSize + x] = grain <= 0.0 ? 0 : (grain >= 1.0 ? 255 : (uint8_t)(grain * 255.0 + 0.5));
+        }
+    }
+}
+
+// returns the stamp's masks at the size, generating them if the size changed. returns NULL if memory could not be allocated.
+static const uint8_t* PrepareStamp(CVSSCStamper* const pStamper, const CVSSCBrushStamp pKind, const int32_t pSize) {
+    Stamp* const stamp = &pStamper->stamps[CVSSCBrushStampCrayon == pKind ? 1 : 0];
+    if (pKind == stamp->kind && pSize == stamp->size) {
+        return stamp->masks;
+    }
+    stamp->kind = CVSSCBrushStampNone;
+    const size_t maskLength = (size_t)pSize * (size_t)pSize;
+    if (!Reserve((void**)&stamp->masks, &stamp->capacity, StampVariantCount * maskLength, sizeof(uint8_t))) {
+        return NULL;
+    }
+    const StampStyle* const style = StyleForStamp(pKind);
+    for (uint32_t variant = 0; variant < StampVariantCount; ++variant) {
+        uint8_t* const mask = stamp->masks + variant * maskLength;
+        if (CVSSCBrushStampCrayon == pKind) {
+            GenerateCrayonMask(mask, pSize, Hash32(style->seed + variant));
+        }
+        else {
+            GenerateSprayMask(mask, pSize, Hash32(style->seed + variant));
+        }
+    }
+    stamp->kind = pKind;
+    stamp->size = pSize;
+    return stamp->masks;
+}
+
+CVSSCStamper* CVSSCStamperCreate(void) {
+    CVSSCStamper* const result = CVSSCAllocate(sizeof(CVSSCStamper));
+    if (result) {
+        memset(result, 0, sizeof(CVSSCStamper));
+        GenerateGrain(result->grain, kCrayonStampStyle.seed);
+    }
+    return result;
+}
+
+void CVSSCStamperDestroy(CVSSCStamper* const pStamper) {
+    if (!pStamper) {
+        return;
+    }
+    CVSSCFree(pStamper->stamps[0].masks);
+    CVSSCFree(pStamper->stamps[1].masks);
+    CVSSCFree(pStamper->dabs);
+    CVSSCFree(pStamper->points);
+    CVSSCFree(pStamper->mask);
+    CVSSCFree(pStamper->rows);
+    CVSSCFree(pStamper->grainRow);
+    CVSSCFree(pStamper);
+}
+
+#pragma mark - Dabs
+
+static bool AddPoint(CVSSCStamper* const pStamper, const CVSSCPoint pPoint) {
+    if (!Reserve((void**)&pStamper->points, &pStamper->pointCapacity, pStamper->pointCount + 1, sizeof(CVSSCPoint))) {
+        return false;
+    }
+    pStamper->points[pStamper->pointCount++] = pPoint;
+    return true;
+}
+
+// flattens the component to device space points, as the rasterizer flattens it
+static bool FlattenComponent(CVSSCStamper* const pStamper, const CVSSCTransform* const pTransform, const CVSSCComponent* const pComponent) {
+    pStamper->pointCount = 0;
+    const CVSSCPoint p0 = CVSSCTransformApplyToPoint(pTransform, pComponent->fromPoint);
+    const CVSSCPoint p3 = CVSSCTransformApplyToPoint(pTransform, pComponent->toPoint);
+    if (!AddPoint(pStamper, p0)) {
+        return false;
+    }
+    if (CVSSCComponentTypeCurve != pComponent->type) {
+        return AddPoint(pStamper, p3);
+    }
+    const CVSSCPoint p1 = CVSSCTransformApplyToPoint(pTransform, pComponent->controlPoint1);
+    const CVSSCPoint p2 = CVSSCTransformApplyToPoint(pTransform, pComponent->controlPoint2);
+    const double ddx = fmax(fabs(p0.x - 2.0 * p1.x + p2.x), fabs(p1.x - 2.0 * p2.x + p3.x));
+    const double ddy = fmax(fabs(p0.y - 2.0 * p1.y + p2.y), fabs(p1.y - 2.0 * p2.y + p3.y));
+    const double segmentCountEstimate = ceil(sqrt(0.75 * sqrt(ddx * ddx + ddy * ddy) / CVSSCRasterFlatteningTolerance));
+    const int segmentCount = segmentCountEstimate < 1.0 ? 1 : (segmentCountEstimate > MaximumCurveSegmentCount ? MaximumCurveSegmentCount : (int)segmentCountEstimate);
+    for (int idx = 1; idx <= segmentCount; ++idx) {
+        const double t = (double)idx / segmentCount;
+        const double mt = 1.0 - t;
+        const double w0 = mt * mt * mt;
+        const double w1 = 3.0 * mt * mt * t;
+        const double w2 = 3.0 * mt * t * t;
+        const double w3 = t * t * t;
+        const CVSSCPoint to = idx == segmentCount ? p3 : (CVSSCPoint){
+            w0 * p0.x + w1 * p1.x + w2 * p2.x + w3 * p3.x,
+            w0 * p0.y + w1 * p1.y + w2 * p2.y + w3 * p3.y
+        };
+        if (!AddPoint(pStamper, to)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// adds a dab centered near the point. the offset and the variant are the next values of the generator.
+static bool AddDab(CVSSCStamper* const pStamper, const CVSSCPoint pCenter, const int32_t pSize, const double pJitter, uint32_t* const pRandom) {
+    const double x = pCenter.x + (2.0 * UnitFromHash(NextRandom(pRandom)) - 1.0) * pJitter;
+    const double y = pCenter.y + (2.0 * UnitFromHash(NextRandom(pRandom)) - 1.0) * pJitter;
+    const uint32_t variant = NextRandom(pRandom) % StampVariantCount;
+    // a dab which is far outside of any bitmap (or not finite) is not placed
+    if (!(fabs(x) < 1.0e9 && fabs(y) < 1.0e9)) {
+        return true;
+    }
+    if (!Reserve((void**)&pStamper->dabs, &pStamper->dabCapacity, pStamper->dabCount + 1, sizeof(Dab))) {
+        return false;
+    }
+    // dabs are placed on whole pixels; the stamps' texture hides the rounding
+    const Dab dab = {
+        (int32_t)floor(x - 0.5 * pSize + 0.5),
+        (int32_t)floor(y - 0.5 * pSize + 0.5),
+        variant
+    };
+    pStamper->dabs[pStamper->dabCount++] = dab;
+    return true;
+}
+
+// places dabs along the flattened component: one at its start, then one every pSpacing pixels of its length. the last
+// component of a stroke also places one at its end.
+static bool PlaceComponentDabs(CVSSCStamper* const pStamper, const int32_t pSize, const double pSpacing, const double pJitter, const uint32_t pSeed, const bool pIsLast) {
+    const CVSSCPoint* const points = pStamper->points;
+    const size_t pointCount = pStamper->pointCount;
+    double length = 0.0;
+    for (size_t idx = 1; idx < pointCount; ++idx) {
+        length += CVSSCPointDistance(points[idx - 1], points[idx]);
+    }
+    if (!isfinite(length)) {
+        return true;
+    }
+    const double spacing = fmax(pSpacing, length / MaximumComponentDabCount);
+    uint32_t random = pSeed;
+    if (!AddDab(pStamper, points[0], pSize, pJitter, &random)) {
+        return false;
+    }
+    double travelled = 0.0;
+    double next = spacing;
+    for (size_t idx = 1; idx < pointCount; ++idx) {
+        const CVSSCPoint from = points[idx - 1];
+        const CVSSCPoint to = points[idx];
+        const double segmentLength = CVSSCPointDistance(from, to);
+        while (next < travelled + segmentLength) {
+            const double t = (next - travelled) / segmentLength;
+            const CVSSCPoint center = {from.x + t * (to.x - from.x), from.y + t * (to.y - from.y)};
+            if (!AddDab(pStamper, center, pSize, pJitter, &random)) {
+                return false;
+            }
+            next += spacing;
+        }
+        travelled += segmentLength;
+    }
+    if (pIsLast && 0.0 < length) {
+        return AddDab(pStamper, points[pointCount - 1], pSize, pJitter, &random);
+    }
+    return true;
+}
+
+#pragma mark - Coverage
+
+static void AccumulateDab(CVSSCStamper* const pStamper, const Dab* const pDab, const uint8_t* const pMasks, const int32_t pSize, const bool pAccumulates) {
+    const CVSSCPixelRect maskRect = pStamper->maskRect;
+    const int32_t minX = pDab->x > maskRect.minX ? pDab->x : maskRect.minX;
+    const int32_t minY = pDab->y > maskRect.minY ? pDab->y : maskRect.minY;
+    const int32_t maxX = pDab->x + pSize < maskRect.maxX ? pDab->x + pSize : maskRect.maxX;
+    const int32_t maxY = pDab->y + pSize < maskRect.maxY ? pDab->y + pSize : maskRect.maxY;
+    if (minX >= maxX || minY >= maxY) {
+        return;
+    }
+    const size_t maskWidth = (size_t)(maskRect.maxX - maskRect.minX);
+    const size_t count = (size_t)(maxX - minX);
+    const uint8_t* const stamp = pMasks + pDab->variant * (size_t)pSize * (size_t)pSize;
+    for (int32_t y = minY; y < maxY; ++y) {
+        const size_t row = (size_t)(y - maskRect.minY);
+        uint8_t* const coverage = pStamper->mask + row * maskWidth + (size_t)(minX - maskRect.minX);
+        const uint8_t* const source = stamp + (size_t)(y - pDab->y) * (size_t)pSize + (size_t)(minX - pDab->x);
+        if (pAccumulates) {
+            CVSSCSpanCoverageAdd(coverage, source, count);
+        }
+        else {
+            CVSSCSpanCoverageMax(coverage, source, count);
+        }
+        RowExtent* const extent = &pStamper->rows[row];
+        if (0 == extent->maxX || minX < extent->minX) {
+            extent->minX = minX;
+        }
+        if (maxX > extent->maxX) {
+            extent->maxX = maxX;
+        }
+    }
+}
+
+// masks the coverage of pixels [pMinX, pMinX + pCount) of row pY by the grain
+static void ApplyGrain(CVSSCStamper* const pStamper, uint8_t* const pCoverage, const int32_t pMinX, const int32_t pY, const size_t pCount) {
+    const uint8_t* const grainLine = &pStamper->grain[((uint32_t)pY & (GrainSize - 1)) * GrainSize];
+    size_t filled = 0;
+    uint32_t x = (uint32_t)pMinX;
+    while (filled < pCount) {
+        const uint32_t column = x & (GrainSize - 1);
+        const size_t remaining = pCount - filled;
+        const size_t count = GrainSize - column < remaining ? GrainSize - column : remaining;
+        memcpy(&pStamper->grainRow[filled], &grainLine[column], count);
+        filled += count;
+        x += (uint32_t)count;
+    }
+    CVSSCSpanCoverageMultiply(pCoverage, pStamper->grainRow, pCount);
+}
+
+#pragma mark - Rendering
+
+static inline uint8_t ColorComponentToByte(const double pValue) {
+    const double clamped = pValue < 0.0 ? 0.0 : (pValue > 1.0 ? 1.0 : pValue);
+    return (uint8_t)(clamped * 255.0 + 0.5);
+}
+
+bool CVSSCStamperRenderStroke(CVSSCStamper* const pStamper, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCComponent* const pComponents, const size_t pCount) {
+    assert(pStamper);
+    assert(pBitmap);
+    assert(pTransform);
+    assert(pBrush);
+    assert(CVSSCBrushStampNone != pBrush->stamp);
+    assert(pComponents || 0 == pCount);
+    pStamper->dabCount = 0;
+    const StampStyle* const style = StyleForStamp(pBrush->stamp);
+    const double width = pBrush->lineWidth * CVSSCTransformGetScale(pTransform);
+    const double diameter = width * style->dabScale;
+    if (!(diameter > 0.0) || 0 == pCount) {
+        return true;
+    }
+    const int32_t size = diameter >= MaximumStampSize ? MaximumStampSize : (int32_t)ceil(diameter);
+    const double spacing = fmax(style->spacing * diameter, 1.0);
+    const double jitter = width * style->jitter;
+
+    // place. each component's generator is seeded by its index, so the dabs do not depend on the coordinates' precision.
+    const uint32_t strokeSeed = Hash32(style->seed ^ Hash32((uint32_t)pCount));
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        if (CVSSCComponentTypeFill == pComponents[idx].type) {
+            continue;
+        }
+        const uint32_t seed = Hash32(strokeSeed + (uint32_t)idx * 0x9E3779B9U);
+        if (!FlattenComponent(pStamper, pTransform, &pComponents[idx])
+            || !PlaceComponentDabs(pStamper, size, spacing, jitter, seed, idx + 1 == pCount)) {
+            return false;
+        }
+    }
+    if (0 == pStamper->dabCount) {
+        return true;
+    }
+    const uint8_t* const masks = PrepareStamp(pStamper, pBrush->stamp, size);
+    if (!masks) {
+        return false;
+    }
+
+    // the mask covers the dabs within the clip
+    CVSSCPixelRect dabsRect = {pStamper->dabs[0].x, pStamper->dabs[0].y, pStamper->dabs[0].x + size, pStamper->dabs[0].y + size};
+    for (size_t idx = 1; idx < pStamper->dabCount; ++idx) {
+        const Dab* const at = &pStamper->dabs[idx];
+        dabsRect.minX = at->x < dabsRect.minX ? at->x : dabsRect.minX;
+        dabsRect.minY = at->y < dabsRect.minY ? at->y : dabsRect.minY;
+        dabsRect.maxX = at->x + size > dabsRect.maxX ? at->x + size : dabsRect.maxX;
+        dabsRect.maxY = at->y + size > dabsRect.maxY ? at->y + size : dabsRect.maxY;
+    }
+    const CVSSCPixelRect maskRect = CVSSCPixelRectIntersection(dabsRect, CVSSCPixelRectIntersection(pClip, CVSSCBitmapGetPixelRect(pBitmap)));
+    if (CVSSCPixelRectIsEmpty(maskRect)) {
+        return true;
+    }
+    const size_t maskWidth = (size_t)(maskRect.maxX - maskRect.minX);
+    const size_t maskHeight = (size_t)(maskRect.maxY - maskRect.minY);
+    if (!Reserve((void**)&pStamper->mask, &pStamper->maskCapacity, maskWidth * maskHeight, sizeof(uint8_t))
+        || !Reserve((void**)&pStamper->rows, &pStamper->rowCapacity, maskHeight, sizeof(RowExtent))
+        || (style->grained && !Reserve((void**)&pStamper->grainRow, &pStamper->grainRowCapacity, maskWidth, sizeof(uint8_t)))) {
+        return false;
+    }
+    memset(pStamper->mask, 0, maskWidth * maskHeight);
+    memset(pStamper->rows, 0, maskHeight * sizeof(RowExtent));
+    pStamper->maskRect = maskRect;
+
+    // coverage
+    for (size_t idx = 0; idx < pStamper->dabCount; ++idx) {
+        AccumulateDab(pStamper, &pStamper->dabs[idx], masks, size, style->accumulates);
+    }
+
+    // blend
+    const CVSSCSpanPaint paint = {
+        ColorComponentToByte(pColor.red),
+        ColorComponentToByte(pColor.green),
+        ColorComponentToByte(pColor.blue),
+        ColorComponentToByte(pColor.alpha * pBrush->alpha)
+    };
+    for (size_t row = 0; row < maskHeight; ++row) {
+        const int32_t rowMinX = pStamper->rows[row].minX;
+        const int32_t rowMaxX = pStamper->rows[row].maxX;
+        if (0 == rowMaxX) {
+            continue;
+        }
+        const int32_t y = maskRect.minY + (int32_t)row;
+        uint8_t* const coverage = pStamper->mask + row * maskWidth + (size_t)(rowMinX - maskRect.minX);
+        uint8_t* const pixels = CVSSCBitmapGetPixel(pBitmap, (uint32_t)rowMinX, (uint32_t)y);
+        const size_t count = (size_t)(rowMaxX - rowMinX);
+        if (style->grained) {
+            ApplyGrain(pStamper, coverage, rowMinX, y, count);
+        }
+        if (pBrush->clears) {
+            CVSSCSpanBlendClear(pixels, coverage, count);
+        }
+        else {
+            CVSSCSpanBlendNormal(pixels, coverage, count, paint);
+        }
+    }
+    return true;
+}
+
+size_t CVSSCStamperGetDabCount(const CVSSCStamper* const pStamper) {
+    assert(pStamper);
+    return pStamper->dabCount;
+}
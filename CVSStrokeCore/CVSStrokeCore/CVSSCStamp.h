@@ -0,0 +1,61 @@
+// CVSSCStamp.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCStamp_h
+#define CVSStrokeCore_CVSSCStamp_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "CVSSCBitmap.h"
+#include "CVSSCBrush.h"
+#include "CVSSCColor.h"
+#include "CVSSCComponent.h"
+#include "CVSSCGeometry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ A dab brush engine -- the renderer of the stamped brushes (CVSSCBrushAttributes.stamp), the spray paint and the crayon.
+
+ A stamped stroke is a sequence of dabs placed along its flattened components at a spacing. A dab is a stamp: a coverage
+ mask which is generated once per brush and dab size, in a few variants. Each dab's variant and offset are jittered by a
+ generator seeded with the brush, the stroke's component count and the index of the component which places the dab --
+ never by the coordinates, which playback formats may quantize -- so a stroke's dabs are the same every time it is
+ rendered, at any scale and within any clip.
+
+ The dabs are accumulated in the stroke's coverage mask a row at a time: the spray's specks are added (so paint builds up
+ where the stroke lingers), and the crayon's dabs are combined (max), then masked by a paper grain which is fixed to the
+ pixels. The mask is blended into the bitmap once, as CVSSCRaster blends.
+ */
+
+/**
+ @brief holds the stamper's stamps and scratch memory, which are reused from stroke to stroke. not thread safe; use one per thread.
+ */
+typedef struct CVSSCStamper CVSSCStamper;
+
+/**
+ @return a new stamper, or NULL if memory could not be allocated. destroy it with CVSSCStamperDestroy.
+ */
+extern CVSSCStamper* CVSSCStamperCreate(void);
+extern void CVSSCStamperDestroy(CVSSCStamper* const pStamper);
+
+/**
+ @brief renders one stroke of a stamped brush into the bitmap. the parameters are those of CVSSCRasterizerRenderStroke.
+ @param pBrush a brush whose stamp is not CVSSCBrushStampNone.
+ @return false if memory could not be allocated (the bitmap is not modified).
+ */
+extern bool CVSSCStamperRenderStroke(CVSSCStamper* const pStamper, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCComponent* const pComponents, const size_t pCount);
+
+/**
+ @return the number of dabs of the last stroke rendered, including those outside of the clip.
+ */
+extern size_t CVSSCStamperGetDabCount(const CVSSCStamper* const pStamper);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,58 @@
+// CVSSCStrokeBatch.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <string.h>
+#include "CVSSCStrokeBatch.h"
+
+const double CVSSCStrokeBatchMaximumSparseness = 4.0;
+
+bool CVSSCStrokeBatchMayMerge(const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor) {
+    assert(pBrush);
+    if (CVSSCBrushStampNone != pBrush->stamp || pBrush->alpha < 1.0) {
+        return false;
+    }
+    // a brush which clears ignores the color
+    return pBrush->clears || pColor.alpha >= 1.0;
+}
+
+CVSSCStrokeBatch CVSSCStrokeBatchMakeEmpty(void) {
+    const CVSSCStrokeBatch result = {
+        .brushType = CVSSCBrushTypeUndefined,
+        .color = {0.0, 0.0, 0.0, 0.0},
+        .bounds = CVSSCRectNull(),
+        .strokesArea = 0.0,
+        .count = 0
+    };
+    return result;
+}
+
+static double Area(const CVSSCRect pRect) {
+    return CVSSCRectIsNull(pRect) ? 0.0 : pRect.width * pRect.height;
+}
+
+bool CVSSCStrokeBatchAddStroke(CVSSCStrokeBatch* const pBatch, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCRect pBounds) {
+    assert(pBatch);
+    assert(pBrush);
+    if (!CVSSCStrokeBatchMayMerge(pBrush, pColor) || CVSSCRectIsNull(pBounds)) {
+        return false;
+    }
+    const CVSSCRect bounds = CVSSCRectUnion(pBatch->bounds, pBounds);
+    const double strokesArea = pBatch->strokesArea + Area(pBounds);
+    if (pBatch->count) {
+        // colors are the same if they are identical, as they are in a palette
+        if (CVSSCStrokeBatchMaximumStrokeCount == pBatch->count || pBatch->brushType != pBrush->brushType || 0 != memcmp(&pBatch->color, &pColor, sizeof(CVSSCColor))) {
+            return false;
+        }
+        if (Area(bounds) > CVSSCStrokeBatchMaximumSparseness * strokesArea) {
+            return false;
+        }
+    }
+    pBatch->brushType = pBrush->brushType;
+    pBatch->color = pColor;
+    pBatch->bounds = bounds;
+    pBatch->strokesArea = strokesArea;
+    ++pBatch->count;
+    return true;
+}
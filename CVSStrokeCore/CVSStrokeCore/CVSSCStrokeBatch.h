@@ -0,0 +1,79 @@
+// CVSSCStrokeBatch.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCStrokeBatch_h
+#define CVSStrokeCore_CVSSCStrokeBatch_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "CVSSCBrush.h"
+#include "CVSSCColor.h"
+#include "CVSSCGeometry.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ State-sorted batching: a run of consecutive strokes with the same brush and color is rendered as one path (one
+ CGContextStrokePath, or one CVSSCRasterizerRenderStrokes) rather than one path per stroke.
+
+ A path is blended once where its strokes overlap, while strokes rendered one after another are each blended. The two are
+ the same where the later stroke replaces what is beneath it: paint which is opaque (the brush's alpha and the color's
+ alpha are 1, blended normally), or a brush which clears. They differ where the paint is translucent -- the paintbrush's
+ overlaps darken when stroked one at a time -- so those strokes are never merged. Stamped brushes have no path.
+
+ Where the antialiased edges of two merged strokes overlap, the path's coverage is the union of theirs, which is a little
+ less than blending one over the other; fully covered pixels are the same. CVSSCStrokeBatchBenchmark verifies both.
+
+ A batch also ends when its bounds would become much larger than its strokes' (CVSSCStrokeBatchMaximumSparseness): the
+ strokes of a run may be far apart, and a renderer's work on a path is proportional to its bounds.
+ */
+
+/**
+ @brief the most strokes in a batch
+ */
+enum { CVSSCStrokeBatchMaximumStrokeCount = 32 };
+
+/**
+ @brief the largest ratio of a batch's bounds' area to the sum of its strokes' bounds' areas
+ */
+extern const double CVSSCStrokeBatchMaximumSparseness;
+
+/**
+ @return true if strokes of the brush and color may be merged: the brush is stroked (not stamped) and either clears or paints
+ opaquely.
+ */
+extern bool CVSSCStrokeBatchMayMerge(const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor);
+
+/**
+ @brief a run of consecutive strokes which may be rendered as one path. the client keeps the strokes; the batch decides
+ which may join it.
+ */
+typedef struct {
+    CVSSCBrushType brushType;
+    CVSSCColor color;
+    CVSSCRect bounds;
+    double strokesArea;
+    size_t count;
+} CVSSCStrokeBatch;
+
+/**
+ @return an empty batch
+ */
+extern CVSSCStrokeBatch CVSSCStrokeBatchMakeEmpty(void);
+
+/**
+ @brief adds the stroke to the batch if it may join it. an empty batch accepts any stroke whose brush and color may merge.
+ @param pBounds the stroke's bounds (CVSSCComponentsGetStrokeBounds).
+ @return false if the stroke may not join the batch, which is not modified. render the batch's strokes, then start a new
+ batch with the stroke.
+ */
+extern bool CVSSCStrokeBatchAddStroke(CVSSCStrokeBatch* const pBatch, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCRect pBounds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,236 @@
+// CVSSCStrokeJournal.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+#include <zlib.h>
+#include "CVSSCStrokeJournal.h"
+
+static const uint32_t CVSSCStrokeJournalSignature = 0x4A535643; // 'CVSJ'
+static const uint16_t CVSSCStrokeJournalVersion = 1;
+
+typedef struct {
+    uint32_t signature;
+    uint16_t version;
+    uint16_t reserved;
+} Header;
+
+typedef struct {
+    uint32_t length;
+    uint32_t checksum;
+} RecordHeader;
+
+typedef struct {
+    uint32_t type;
+    uint32_t value;
+} Body;
+
+typedef struct {
+    double red;
+    double green;
+    double blue;
+    double alpha;
+} StrokeColor;
+
+// the palette index of a PaletteStroke's color, padded to 8 octets
+typedef struct {
+    uint32_t color;
+    uint32_t reserved;
+} StrokeColorIndex;
+
+static uint32_t Checksum(const uint8_t* const pBytes, const size_t pLength) {
+    uLong result = crc32(0L, Z_NULL, 0);
+    // zlib counts in uInt
+    for (size_t offset = 0; offset < pLength;) {
+        const size_t length = pLength - offset < UINT_MAX ? pLength - offset : UINT_MAX;
+        result = crc32(result, &pBytes[offset], (uInt)length);
+        offset += length;
+    }
+    return (uint32_t)result;
+}
+
+// writes the record header of the body which follows it
+static size_t FinishRecord(uint8_t* const pRecord, const size_t pBodyLength) {
+    assert(0 == pBodyLength % 8);
+    assert(UINT32_MAX >= pBodyLength);
+    const RecordHeader header = {(uint32_t)pBodyLength, Checksum(pRecord + sizeof(RecordHeader), pBodyLength)};
+    memcpy(pRecord, &header, sizeof(header));
+    return sizeof(RecordHeader) + pBodyLength;
+}
+
+#pragma mark - Writing
+
+void CVSSCStrokeJournalWriteHeader(void* const pDestination) {
+    assert(pDestination);
+    const Header header = {CVSSCStrokeJournalSignature, CVSSCStrokeJournalVersion, 0};
+    memcpy(pDestination, &header, sizeof(header));
+}
+
+size_t CVSSCStrokeJournalStrokeRecordLength(const size_t pComponentCount) {
+    return sizeof(RecordHeader) + sizeof(Body) + sizeof(StrokeColorIndex) + CVSSCComponentBlobLength(pComponentCount);
+}
+
+size_t CVSSCStrokeJournalWriteStrokeRecord(void* const pDestination, const CVSSCPlaybackStroke* const pStroke, const CVSSCPaletteIndex pColorIndex) {
+    assert(pDestination);
+    assert(pStroke);
+    assert(CVSSCPaletteIndexNone != pColorIndex);
+    uint8_t* const record = pDestination;
+    const Body body = {CVSSCStrokeJournalRecordPaletteStroke, pStroke->brushType};
+    const StrokeColorIndex color = {pColorIndex, 0};
+    uint8_t* at = record + sizeof(RecordHeader);
+    memcpy(at, &body, sizeof(body));
+    at += sizeof(body);
+    memcpy(at, &color, sizeof(color));
+    at += sizeof(color);
+    CVSSCComponentBlobWrite(at, pStroke->components, pStroke->componentCount);
+    return FinishRecord(record, sizeof(body) + sizeof(color) + CVSSCComponentBlobLength(pStroke->componentCount));
+}
+
+size_t CVSSCStrokeJournalWriteColorRecord(void* const pDestination, const CVSSCPaletteIndex pIndex, const CVSSCColor pColor) {
+    assert(pDestination);
+    assert(CVSSCPaletteIndexNone != pIndex);
+    uint8_t* const record = pDestination;
+    const Body body = {CVSSCStrokeJournalRecordColor, pIndex};
+    const StrokeColor color = {pColor.red, pColor.green, pColor.blue, pColor.alpha};
+    memcpy(record + sizeof(RecordHeader), &body, sizeof(body));
+    memcpy(record + sizeof(RecordHeader) + sizeof(body), &color, sizeof(color));
+    return FinishRecord(record, sizeof(body) + sizeof(color));
+}
+
+size_t CVSSCStrokeJournalWriteEventRecord(void* const pDestination, const CVSSCStrokeJournalRecordType pType, const uint32_t pValue) {
+    assert(pDestination);
+    assert(CVSSCStrokeJournalRecordUndo == pType || CVSSCStrokeJournalRecordRedo == pType || CVSSCStrokeJournalRecordUsesTemplate == pType);
+    uint8_t* const record = pDestination;
+    const Body body = {(uint32_t)pType, pValue};
+    memcpy(record + sizeof(RecordHeader), &body, sizeof(body));
+    return FinishRecord(record, sizeof(body));
+}
+
+#pragma mark - Reading
+
+static CVSSCColor ReadColor(const uint8_t* const pPayload) {
+    StrokeColor color;
+    memcpy(&color, pPayload, sizeof(color));
+    const CVSSCColor result = {color.red, color.green, color.blue, color.alpha};
+    return result;
+}
+
+// returns false if the stroke's payload is malformed
+static bool ReadStroke(const uint8_t* const pPayload, const size_t pLength, const uint32_t pBrushType, CVSSCPlaybackStroke* const pOutStroke) {
+    if (sizeof(StrokeColor) > pLength) {
+        return false;
+    }
+    pOutStroke->brushType = pBrushType;
+    pOutStroke->color = ReadColor(pPayload);
+    return CVSSCComponentBlobRead(pPayload + sizeof(StrokeColor), pLength - sizeof(StrokeColor), &pOutStroke->components, &pOutStroke->componentCount);
+}
+
+// returns false if the stroke's payload is malformed, or its color is not in the palette
+static bool ReadPaletteStroke(const uint8_t* const pPayload, const size_t pLength, const uint32_t pBrushType, const CVSSCPalette* const pPalette, CVSSCPlaybackStroke* const pOutStroke) {
+    if (sizeof(StrokeColorIndex) > pLength) {
+        return false;
+    }
+    StrokeColorIndex color;
+    memcpy(&color, pPayload, sizeof(color));
+    if (color.color >= CVSSCPaletteGetCount(pPalette)) {
+        return false;
+    }
+    pOutStroke->brushType = pBrushType;
+    pOutStroke->color = CVSSCPaletteGetColor(pPalette, (CVSSCPaletteIndex)color.color);
+    return CVSSCComponentBlobRead(pPayload + sizeof(color), pLength - sizeof(color), &pOutStroke->components, &pOutStroke->componentCount);
+}
+
+CVSSCStrokeJournalStatus CVSSCStrokeJournalRead(const void* const pBytes, const size_t pLength, const CVSSCStrokeJournalCallbacks* const pCallbacks, CVSSCPalette* const pPalette, size_t* const pOutValidLength) {
+    assert(pBytes || 0 == pLength);
+    assert(pPalette);
+    assert(pOutValidLength);
+    *pOutValidLength = 0;
+    CVSSCPaletteRemoveAll(pPalette);
+    Header header;
+    if (sizeof(header) > pLength) {
+        return CVSSCStrokeJournalStatusMalformed;
+    }
+    memcpy(&header, pBytes, sizeof(header));
+    if (CVSSCStrokeJournalSignature != header.signature || CVSSCStrokeJournalVersion != header.version) {
+        return CVSSCStrokeJournalStatusMalformed;
+    }
+    return CVSSCStrokeJournalReadRecords(pBytes, pLength, sizeof(header), pCallbacks, pPalette, pOutValidLength);
+}
+
+CVSSCStrokeJournalStatus CVSSCStrokeJournalReadRecords(const void* const pBytes, const size_t pLength, const size_t pOffset, const CVSSCStrokeJournalCallbacks* const pCallbacks, CVSSCPalette* const pPalette, size_t* const pOutValidLength) {
+    assert(pBytes || 0 == pLength);
+    assert(pCallbacks);
+    assert(pPalette);
+    assert(pOutValidLength);
+    assert(0 == ((uintptr_t)pBytes % sizeof(double)) && "misaligned journal");
+    assert(sizeof(Header) <= pOffset && pOffset <= pLength);
+    assert(0 == pOffset % 8);
+    const uint8_t* const bytes = pBytes;
+    size_t offset = pOffset;
+    *pOutValidLength = offset;
+    while (offset < pLength) {
+        RecordHeader record;
+        if (sizeof(record) > pLength - offset) {
+            return CVSSCStrokeJournalStatusTruncated;
+        }
+        memcpy(&record, &bytes[offset], sizeof(record));
+        const uint8_t* const body = &bytes[offset + sizeof(record)];
+        if (record.length > pLength - offset - sizeof(record) || sizeof(Body) > record.length || 0 != record.length % 8
+            || record.checksum != Checksum(body, record.length)) {
+            return CVSSCStrokeJournalStatusTruncated;
+        }
+        Body fields;
+        memcpy(&fields, body, sizeof(fields));
+        bool shouldContinue = true;
+        switch (fields.type) {
+            case CVSSCStrokeJournalRecordStroke: {
+                CVSSCPlaybackStroke stroke;
+                if (!ReadStroke(body + sizeof(fields), record.length - sizeof(fields), fields.value, &stroke)) {
+                    // intact but malformed: written by a defective writer. nothing after it is trusted.
+                    return CVSSCStrokeJournalStatusTruncated;
+                }
+                shouldContinue = NULL == pCallbacks->readStroke || pCallbacks->readStroke(pCallbacks->context, &stroke);
+                break;
+            }
+            case CVSSCStrokeJournalRecordColor: {
+                if (sizeof(fields) + sizeof(StrokeColor) != record.length || CVSSCPaletteGetCount(pPalette) != fields.value) {
+                    return CVSSCStrokeJournalStatusTruncated;
+                }
+                CVSSCPaletteIndex index = CVSSCPaletteIndexNone;
+                bool added = false;
+                if (!CVSSCPaletteFindOrAdd(pPalette, ReadColor(body + sizeof(fields)), &index, &added)) {
+                    return CVSSCPaletteMaxCount == CVSSCPaletteGetCount(pPalette) ? CVSSCStrokeJournalStatusTruncated : CVSSCStrokeJournalStatusFailed;
+                }
+                if (!added) {
+                    // each color is written once
+                    return CVSSCStrokeJournalStatusTruncated;
+                }
+                break;
+            }
+            case CVSSCStrokeJournalRecordPaletteStroke: {
+                CVSSCPlaybackStroke stroke;
+                if (!ReadPaletteStroke(body + sizeof(fields), record.length - sizeof(fields), fields.value, pPalette, &stroke)) {
+                    return CVSSCStrokeJournalStatusTruncated;
+                }
+                shouldContinue = NULL == pCallbacks->readStroke || pCallbacks->readStroke(pCallbacks->context, &stroke);
+                break;
+            }
+            case CVSSCStrokeJournalRecordUndo:
+            case CVSSCStrokeJournalRecordRedo:
+            case CVSSCStrokeJournalRecordUsesTemplate:
+                shouldContinue = NULL == pCallbacks->readEvent || pCallbacks->readEvent(pCallbacks->context, (CVSSCStrokeJournalRecordType)fields.type, fields.value);
+                break;
+            default:
+                // a later version's record
+                break;
+        }
+        offset += sizeof(record) + record.length;
+        *pOutValidLength = offset;
+        if (!shouldContinue) {
+            return CVSSCStrokeJournalStatusCancelled;
+        }
+    }
+    return CVSSCStrokeJournalStatusComplete;
+}
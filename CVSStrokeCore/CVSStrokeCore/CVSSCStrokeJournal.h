@@ -0,0 +1,160 @@
+// CVSSCStrokeJournal.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCStrokeJournal_h
+#define CVSStrokeCore_CVSSCStrokeJournal_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CVSSCPalette.h"
+#include "CVSSCPlaybackJSON.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ The append-only journal of a draft: the edits of the drawing, in the order they were made. The draft is the result of
+ replaying them. A record is only ever appended, so a crash (or kill) while a record is written damages only that record.
+
+ Layout (little endian; every offset is a multiple of 8):
+   header
+     uint32_t signature  'CVSJ'
+     uint16_t version    1
+     uint16_t reserved
+   records
+     uint32_t length     of the body, a multiple of 8
+     uint32_t checksum   CRC-32 (zlib) of the body
+     body
+       uint32_t type     CVSSCStrokeJournalRecordType
+       uint32_t value    Stroke, PaletteStroke: the brush type. Color: the color's palette index. UsesTemplate: 0 or 1.
+                         otherwise 0.
+       Stroke and Color only:
+         double red, green, blue, alpha
+       PaletteStroke only:
+         uint32_t color    the palette index of the stroke's color
+         uint32_t reserved
+       Stroke and PaletteStroke only:
+         a component blob (CVSSCComponentBlobWrite)
+
+ The journal's palette is the colors of its Color records, in order: a Color record's index is the number of Color records
+ before it. A stroke refers to its color by index, so a color's 32 octets are written once rather than with every stroke;
+ the writer appends a Color record before the first stroke of a color which is not in the palette.
+
+ Replay stops at the first record which is incomplete or fails its checksum. Everything before it is the draft; the writer
+ truncates the journal to that length before it appends again. An intact record which contradicts the records before it (a
+ Color record out of order, a stroke of a color which is not in the palette) ends the replay as a damaged record does.
+ */
+
+/**
+ @brief record types. THE VALUES OF THESE CANNOT CHANGE -- they are persisted.
+ */
+typedef enum {
+    /** @constant a stroke was committed, with its color. written by journals which predate the palette; still read. */
+    CVSSCStrokeJournalRecordStroke = 1,
+    /** @constant the last stroke of the drawing was undone */
+    CVSSCStrokeJournalRecordUndo = 2,
+    /** @constant the most recently undone stroke was redone */
+    CVSSCStrokeJournalRecordRedo = 3,
+    /** @constant usesTemplate was set */
+    CVSSCStrokeJournalRecordUsesTemplate = 4,
+    /** @constant a color was appended to the journal's palette */
+    CVSSCStrokeJournalRecordColor = 5,
+    /** @constant a stroke was committed. it is appended to the drawing. its color is in the palette. */
+    CVSSCStrokeJournalRecordPaletteStroke = 6
+} CVSSCStrokeJournalRecordType;
+
+/**
+ @brief the length of the header, which begins every journal.
+ */
+enum { CVSSCStrokeJournalHeaderLength = 8 };
+
+/**
+ @brief writes the header to @p pDestination, which must be at least CVSSCStrokeJournalHeaderLength octets.
+ */
+extern void CVSSCStrokeJournalWriteHeader(void* const pDestination);
+
+/**
+ @return the length of the stroke's (PaletteStroke) record
+ */
+extern size_t CVSSCStrokeJournalStrokeRecordLength(const size_t pComponentCount);
+
+/**
+ @brief writes the stroke's PaletteStroke record to @p pDestination, which must be at least CVSSCStrokeJournalStrokeRecordLength
+ octets. the stroke's color is not written: @p pColorIndex is its index in the journal's palette.
+ @return the length written
+ */
+extern size_t CVSSCStrokeJournalWriteStrokeRecord(void* const pDestination, const CVSSCPlaybackStroke* const pStroke, const CVSSCPaletteIndex pColorIndex);
+
+/**
+ @brief the length of a Color record.
+ */
+enum { CVSSCStrokeJournalColorRecordLength = 48 };
+
+/**
+ @brief writes a Color record to @p pDestination, which must be at least CVSSCStrokeJournalColorRecordLength octets.
+ @param pIndex the number of colors in the journal's palette before this one.
+ @return the length written
+ */
+extern size_t CVSSCStrokeJournalWriteColorRecord(void* const pDestination, const CVSSCPaletteIndex pIndex, const CVSSCColor pColor);
+
+/**
+ @brief the length of the records which have no payload (Undo, Redo and UsesTemplate).
+ */
+enum { CVSSCStrokeJournalEventRecordLength = 16 };
+
+/**
+ @brief writes an Undo, Redo or UsesTemplate record to @p pDestination, which must be at least
+ CVSSCStrokeJournalEventRecordLength octets.
+ @return the length written
+ */
+extern size_t CVSSCStrokeJournalWriteEventRecord(void* const pDestination, const CVSSCStrokeJournalRecordType pType, const uint32_t pValue);
+
+typedef struct {
+    void* context;
+    /** @brief called for every Stroke and PaletteStroke record. the components point into the journal's bytes. return false to cancel. */
+    bool (*readStroke)(void* const pContext, const CVSSCPlaybackStroke* const pStroke);
+    /** @brief called for every Undo, Redo and UsesTemplate record. return false to cancel. */
+    bool (*readEvent)(void* const pContext, const CVSSCStrokeJournalRecordType pType, const uint32_t pValue);
+} CVSSCStrokeJournalCallbacks;
+
+typedef enum {
+    /** @constant every record was read */
+    CVSSCStrokeJournalStatusComplete = 0,
+    /** @constant the records were read up to one which is incomplete or damaged (the tail of a crash) */
+    CVSSCStrokeJournalStatusTruncated,
+    /** @constant the header is not a journal's, or its version is not supported. nothing was read. */
+    CVSSCStrokeJournalStatusMalformed,
+    /** @constant a callback returned false */
+    CVSSCStrokeJournalStatusCancelled,
+    /** @constant memory could not be allocated. the records before pOutValidLength were read; the rest are not known to be damaged. */
+    CVSSCStrokeJournalStatusFailed
+} CVSSCStrokeJournalStatus;
+
+/**
+ @brief reads the journal's records in order. records of unknown types are skipped.
+ @param pBytes the journal. must be 8 byte aligned (e.g. the bytes of NSData, or a mapping).
+ @param pPalette is emptied, and receives the journal's palette as it is read. a writer which appends to the journal
+ continues it.
+ @param pOutValidLength receives the length of the header and the records which were read intact: the length to which the
+ journal is truncated before more records are appended. 0 if Malformed.
+ */
+extern CVSSCStrokeJournalStatus CVSSCStrokeJournalRead(const void* const pBytes, const size_t pLength, const CVSSCStrokeJournalCallbacks* const pCallbacks, CVSSCPalette* const pPalette, size_t* const pOutValidLength);
+
+/**
+ @brief reads the records which follow @p pOffset, as CVSSCStrokeJournalRead. the header is not read.
+ @param pOffset the end of an intact record (or of the header): a valid length returned by an earlier read of the journal.
+ e.g. a client which has the state of the draft at some length reads only the records after it.
+ @param pPalette the palette of the records before @p pOffset, as the read which ended there left it. receives the colors
+ of the records which are read.
+ @param pOutValidLength receives @p pOffset plus the length of the records which were read intact.
+ */
+extern CVSSCStrokeJournalStatus CVSSCStrokeJournalReadRecords(const void* const pBytes, const size_t pLength, const size_t pOffset, const CVSSCStrokeJournalCallbacks* const pCallbacks, CVSSCPalette* const pPalette, size_t* const pOutValidLength);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,102 @@
+// CVSSCStrokeTracker.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <string.h>
+#include "CVSSCMemory.h"
+#include "CVSSCSmoothing.h"
+#include "CVSSCStrokeTracker.h"
+
+struct CVSSCStrokeTracker {
+    // the most recent samples. the oldest is at samples[sampleStart] once the ring is full.
+    CVSSCPoint samples[CVSSCSmoothingSampleCount];
+    size_t sampleStart;
+    size_t sampleCount;
+    CVSSCComponent* components;
+    size_t componentCount;
+    size_t componentCapacity;
+};
+
+static bool Reserve(CVSSCStrokeTracker* const pTracker, const size_t pCount) {
+    if (pCount <= pTracker->componentCapacity) {
+        return true;
+    }
+    size_t capacity = pTracker->componentCapacity ? pTracker->componentCapacity : 64;
+    while (capacity < pCount) {
+        capacity *= 2;
+    }
+    CVSSCComponent* const components = CVSSCReallocate(pTracker->components, capacity * sizeof(CVSSCComponent));
+    if (!components) {
+        return false;
+    }
+    pTracker->components = components;
+    pTracker->componentCapacity = capacity;
+    return true;
+}
+
+CVSSCStrokeTracker* CVSSCStrokeTrackerCreate(const size_t pCapacity) {
+    CVSSCStrokeTracker* const result = CVSSCAllocate(sizeof(CVSSCStrokeTracker));
+    if (!result) {
+        return NULL;
+    }
+    memset(result, 0, sizeof(CVSSCStrokeTracker));
+    if (!Reserve(result, pCapacity)) {
+        CVSSCFree(result);
+        return NULL;
+    }
+    return result;
+}
+
+void CVSSCStrokeTrackerDestroy(CVSSCStrokeTracker* const pTracker) {
+    if (!pTracker) {
+        return;
+    }
+    CVSSCFree(pTracker->components);
+    CVSSCFree(pTracker);
+}
+
+void CVSSCStrokeTrackerReset(CVSSCStrokeTracker* const pTracker) {
+    assert(pTracker);
+    pTracker->sampleStart = 0;
+    pTracker->sampleCount = 0;
+    pTracker->componentCount = 0;
+}
+
+const CVSSCComponent* CVSSCStrokeTrackerRepeatComponent(CVSSCStrokeTracker* const pTracker) {
+    assert(pTracker);
+    assert(0 < pTracker->sampleCount);
+    if (!Reserve(pTracker, pTracker->componentCount + 1)) {
+        return NULL;
+    }
+    // the smoothing takes the samples oldest first
+    CVSSCPoint samples[CVSSCSmoothingSampleCount];
+    for (size_t idx = 0; idx < pTracker->sampleCount; ++idx) {
+        samples[idx] = pTracker->samples[(pTracker->sampleStart + idx) % CVSSCSmoothingSampleCount];
+    }
+    CVSSCComponent* const result = &pTracker->components[pTracker->componentCount++];
+    *result = CVSSCSmoothingMakeComponent(samples, pTracker->sampleCount, CVSSCSmoothingDefaultSmoothValue);
+    return result;
+}
+
+const CVSSCComponent* CVSSCStrokeTrackerAddSample(CVSSCStrokeTracker* const pTracker, const CVSSCPoint pSample) {
+    assert(pTracker);
+    if (CVSSCSmoothingSampleCount == pTracker->sampleCount) {
+        // replace the oldest
+        pTracker->samples[pTracker->sampleStart] = pSample;
+        pTracker->sampleStart = (pTracker->sampleStart + 1) % CVSSCSmoothingSampleCount;
+    } else {
+        pTracker->samples[pTracker->sampleCount++] = pSample;
+    }
+    return CVSSCStrokeTrackerRepeatComponent(pTracker);
+}
+
+size_t CVSSCStrokeTrackerGetComponentCount(const CVSSCStrokeTracker* const pTracker) {
+    assert(pTracker);
+    return pTracker->componentCount;
+}
+
+const CVSSCComponent* CVSSCStrokeTrackerGetComponents(const CVSSCStrokeTracker* const pTracker) {
+    assert(pTracker);
+    return pTracker->components;
+}
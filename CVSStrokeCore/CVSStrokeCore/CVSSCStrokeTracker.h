@@ -0,0 +1,61 @@
+// CVSSCStrokeTracker.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCStrokeTracker_h
+#define CVSStrokeCore_CVSSCStrokeTracker_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "CVSSCComponent.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ The touch to component pipeline of a stroke in progress (CVSStrokeGenerator).
+
+ The most recent touch samples are kept in a fixed ring, and each sample's smoothed component (CVSSCSmoothing) is appended
+ to a buffer of component records. The buffer is kept between strokes, so once it has grown to the length of a long stroke,
+ tracking allocates nothing. Objects (CVSStroke) are made only from the finished components.
+ */
+typedef struct CVSSCStrokeTracker CVSSCStrokeTracker;
+
+/**
+ @param pCapacity the number of components to reserve. the buffer grows beyond it if needed.
+ @return a new tracker with no samples, or NULL if memory could not be allocated. destroy it with CVSSCStrokeTrackerDestroy.
+ */
+extern CVSSCStrokeTracker* CVSSCStrokeTrackerCreate(const size_t pCapacity);
+extern void CVSSCStrokeTrackerDestroy(CVSSCStrokeTracker* const pTracker);
+
+/**
+ @brief removes the samples and components, and keeps the memory.
+ */
+extern void CVSSCStrokeTrackerReset(CVSSCStrokeTracker* const pTracker);
+
+/**
+ @brief adds a touch sample and appends the component of the most recent samples.
+ @return the new component, which is valid until the tracker is next changed, or NULL if memory could not be allocated
+ (in which case the sample is added and the component is not).
+ */
+extern const CVSSCComponent* CVSSCStrokeTrackerAddSample(CVSSCStrokeTracker* const pTracker, const CVSSCPoint pSample);
+
+/**
+ @brief appends the component of the most recent samples again (a stroke which ends where it began).
+ @return the new component as CVSSCStrokeTrackerAddSample. there must be a sample.
+ */
+extern const CVSSCComponent* CVSSCStrokeTrackerRepeatComponent(CVSSCStrokeTracker* const pTracker);
+
+extern size_t CVSSCStrokeTrackerGetComponentCount(const CVSSCStrokeTracker* const pTracker);
+
+/**
+ @return the components, oldest first. valid until the tracker is next changed.
+ */
+extern const CVSSCComponent* CVSSCStrokeTrackerGetComponents(const CVSSCStrokeTracker* const pTracker);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+// CVSSCTileReplay.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+#include "CVSSCMemory.h"
+#include "CVSSCTileReplay.h"
+
+typedef struct {
+    const CVSSCBrushAttributes* brush;
+    CVSSCColor color;
+    const CVSSCComponent* components;
+    size_t count;
+} Stroke;
+
+typedef struct {
+    // indices into strokes, ascending
+    uint32_t* strokes;
+    size_t count;
+    size_t capacity;
+    // the number of strokes which have been rendered
+    size_t renderedCount;
+} Tile;
+
+struct CVSSCTileReplay {
+    CVSSCBitmap bitmap;
+    CVSSCTransform transform;
+    CVSSCPixelRect clip;
+    uint32_t tileSize;
+    uint32_t columnCount;
+    uint32_t rowCount;
+    Tile* tiles;
+    Stroke* strokes;
+    size_t strokeCount;
+    size_t strokeCapacity;
+};
+
+static bool Reserve(void** const pMemory, size_t* const pCapacity, const size_t pCount, const size_t pElementSize) {
+    if (pCount <= *pCapacity) {
+        return true;
+    }
+    size_t capacity = *pCapacity ? *pCapacity : 16;
+    while (capacity < pCount) {
+        capacity *= 2;
+    }
+    void* const memory = CVSSCReallocate(*pMemory, capacity * pElementSize);
+    if (!memory) {
+        return false;
+    }
+    *pMemory = memory;
+    *pCapacity = capacity;
+    return true;
+}
+
+CVSSCTileReplay* CVSSCTileReplayCreate(const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const uint32_t pTileSize) {
+    assert(pBitmap);
+    assert(pTransform);
+    assert(0 < pTileSize);
+    CVSSCTileReplay* const result = CVSSCAllocate(sizeof(CVSSCTileReplay));
+    if (!result) {
+        return NULL;
+    }
+    memset(result, 0, sizeof(CVSSCTileReplay));
+    result->bitmap = *pBitmap;
+    result->transform = *pTransform;
+    result->clip = CVSSCPixelRectIntersection(pClip, CVSSCBitmapGetPixelRect(pBitmap));
+    result->tileSize = pTileSize;
+    if (!CVSSCPixelRectIsEmpty(result->clip)) {
+        result->columnCount = (uint32_t)((result->clip.maxX - result->clip.minX) + (int32_t)pTileSize - 1) / pTileSize;
+        result->rowCount = (uint32_t)((result->clip.maxY - result->clip.minY) + (int32_t)pTileSize - 1) / pTileSize;
+        const size_t tileCount = (size_t)result->columnCount * result->rowCount;
+        result->tiles = CVSSCAllocate(tileCount * sizeof(Tile));
+        if (!result->tiles) {
+            CVSSCFree(result);
+            return NULL;
+        }
+        memset(result->tiles, 0, tileCount * sizeof(Tile));
+    }
+    return result;
+}
+
+void CVSSCTileReplayDestroy(CVSSCTileReplay* const pReplay) {
+    if (!pReplay) {
+        return;
+    }
+    const size_t tileCount = CVSSCTileReplayGetTileCount(pReplay);
+    for (size_t idx = 0; idx < tileCount; ++idx) {
+        CVSSCFree(pReplay->tiles[idx].strokes);
+    }
+    CVSSCFree(pReplay->tiles);
+    CVSSCFree(pReplay->strokes);
+    CVSSCFree(pReplay);
+}
+
+// the pixels the rasterizer may cover for the stroke, within the clip
+static CVSSCPixelRect StrokePixelRect(const CVSSCTileReplay* const pReplay, const CVSSCBrushAttributes* const pBrush, const CVSSCComponent* const pComponents, const size_t pCount) {
+    const CVSSCPixelRect empty = {0, 0, 0, 0};
+    const CVSSCRect bounds = CVSSCComponentsGetControlBounds(pComponents, pCount);
+    if (CVSSCRectIsNull(bounds)) {
+        return empty;
+    }
+    // flattened curves lie within their control points, so the transformed control bounds contain every segment
+    double minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+    const CVSSCPoint corners[4] = {
+        {bounds.x, bounds.y},
+        {bounds.x + bounds.width, bounds.y},
+        {bounds.x, bounds.y + bounds.height},
+        {bounds.x + bounds.width, bounds.y + bounds.height}
+    };
+    for (size_t idx = 0; idx < 4; ++idx) {
+        const CVSSCPoint at = CVSSCTransformApplyToPoint(&pReplay->transform, corners[idx]);
+        minX = fmin(minX, at.x);
+        minY = fmin(minY, at.y);
+        maxX = fmax(maxX, at.x);
+        maxY = fmax(maxY, at.y);
+    }
+    if (!isfinite(minX) || !isfinite(minY) || !isfinite(maxX) || !isfinite(maxY)) {
+        return empty;
+    }
+    // the rasterizer's reach beyond a segment (square caps extend furthest), and a pixel for rounding
+    const double radius = 0.5 * pBrush->lineWidth * CVSSCTransformGetScale(&pReplay->transform);
+    const double reach = radius * 1.5 + 2.0;
+    const CVSSCPixelRect clip = pReplay->clip;
+    const CVSSCPixelRect rect = {
+        (int32_t)fmax(floor(minX - reach), clip.minX),
+        (int32_t)fmax(floor(minY - reach), clip.minY),
+        (int32_t)fmin(ceil(maxX + reach), clip.maxX),
+        (int32_t)fmin(ceil(maxY + reach), clip.maxY)
+    };
+    return CVSSCPixelRectIntersection(rect, clip);
+}
+
+bool CVSSCTileReplayAddStroke(CVSSCTileReplay* const pReplay, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCComponent* const pComponents, const size_t pCount) {
+    assert(pReplay);
+    assert(pBrush);
+    assert(pComponents || 0 == pCount);
+    assert(pReplay->strokeCount < UINT32_MAX);
+    if (CVSSCComponentsAreFill(pComponents, pCount) || CVSSCBrushStampNone != pBrush->stamp) {
+        return false;
+    }
+    const CVSSCPixelRect rect = StrokePixelRect(pReplay, pBrush, pComponents, pCount);
+    if (CVSSCPixelRectIsEmpty(rect)) {
+        return true;
+    }
+    const uint32_t tileSize = pReplay->tileSize;
+    const uint32_t minColumn = (uint32_t)(rect.minX - pReplay->clip.minX) / tileSize;
+    const uint32_t minRow = (uint32_t)(rect.minY - pReplay->clip.minY) / tileSize;
+    const uint32_t maxColumn = (uint32_t)(rect.maxX - 1 - pReplay->clip.minX) / tileSize;
+    const uint32_t maxRow = (uint32_t)(rect.maxY - 1 - pReplay->clip.minY) / tileSize;
+    // reserve everything first, so that a failure leaves the replay unchanged
+    if (!Reserve((void**)&pReplay->strokes, &pReplay->strokeCapacity, pReplay->strokeCount + 1, sizeof(Stroke))) {
+        return false;
+    }
+    for (uint32_t row = minRow; row <= maxRow; ++row) {
+        for (uint32_t column = minColumn; column <= maxColumn; ++column) {
+            Tile* const tile = &pReplay->tiles[(size_t)row * pReplay->columnCount + column];
+            if (!Reserve((void**)&tile->strokes, &tile->capacity, tile->count + 1, sizeof(uint32_t))) {
+                return false;
+            }
+        }
+    }
+    const uint32_t strokeIndex = (uint32_t)pReplay->strokeCount;
+    const Stroke stroke = {pBrush, pColor, pComponents, pCount};
+    pReplay->strokes[pReplay->strokeCount++] = stroke;
+    for (uint32_t row = minRow; row <= maxRow; ++row) {
+        for (uint32_t column = minColumn; column <= maxColumn; ++column) {
+            Tile* const tile = &pReplay->tiles[(size_t)row * pReplay->columnCount + column];
+            tile->strokes[tile->count++] = strokeIndex;
+        }
+    }
+    return true;
+}
+
+size_t CVSSCTileReplayGetTileCount(const CVSSCTileReplay* const pReplay) {
+    assert(pReplay);
+    return (size_t)pReplay->columnCount * pReplay->rowCount;
+}
+
+CVSSCPixelRect CVSSCTileReplayGetTileRect(const CVSSCTileReplay* const pReplay, const size_t pTileIndex) {
+    assert(pReplay);
+    assert(pTileIndex < CVSSCTileReplayGetTileCount(pReplay));
+    const uint32_t column = (uint32_t)(pTileIndex % pReplay->columnCount);
+    const uint32_t row = (uint32_t)(pTileIndex / pReplay->columnCount);
+    const int32_t minX = pReplay->clip.minX + (int32_t)(column * pReplay->tileSize);
+    const int32_t minY = pReplay->clip.minY + (int32_t)(row * pReplay->tileSize);
+    const CVSSCPixelRect tile = {minX, minY, minX + (int32_t)pReplay->tileSize, minY + (int32_t)pReplay->tileSize};
+    return CVSSCPixelRectIntersection(tile, pReplay->clip);
+}
+
+size_t CVSSCTileReplayGetTileStrokeCount(const CVSSCTileReplay* const pReplay, const size_t pTileIndex) {
+    assert(pReplay);
+    assert(pTileIndex < CVSSCTileReplayGetTileCount(pReplay));
+    return pReplay->tiles[pTileIndex].count;
+}
+
+bool CVSSCTileReplayRenderTile(CVSSCTileReplay* const pReplay, CVSSCRasterizer* const pRasterizer, const size_t pTileIndex) {
+    assert(pReplay);
+    assert(pRasterizer);
+    assert(pTileIndex < CVSSCTileReplayGetTileCount(pReplay));
+    Tile* const tile = &pReplay->tiles[pTileIndex];
+    const CVSSCPixelRect clip = CVSSCTileReplayGetTileRect(pReplay, pTileIndex);
+    for (; tile->renderedCount < tile->count; ++tile->renderedCount) {
+        const Stroke* const stroke = &pReplay->strokes[tile->strokes[tile->renderedCount]];
+        if (!CVSSCRasterizerRenderStroke(pRasterizer, &pReplay->bitmap, &pReplay->transform, clip, stroke->brush, stroke->color, stroke->components, stroke->count)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,85 @@
+// CVSSCTileReplay.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#ifndef CVSStrokeCore_CVSSCTileReplay_h
+#define CVSStrokeCore_CVSSCTileReplay_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "CVSSCBitmap.h"
+#include "CVSSCBrush.h"
+#include "CVSSCColor.h"
+#include "CVSSCComponent.h"
+#include "CVSSCGeometry.h"
+#include "CVSSCRaster.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ Replays many strokes with the software rasterizer (CVSSCRaster) by tiles, so that the tiles may be rendered concurrently.
+
+ The clip is divided into square tiles of pixels. Each stroke is binned into the tiles which its device bounds touch, and
+ each tile renders its strokes in the order they were added, clipped to the tile. No tile writes another tile's pixels,
+ and the rasterizer's coverage of a pixel does not depend on the clip, so the result is identical to rendering the strokes
+ one after another with the whole clip.
+
+ The library does not create threads: the client renders the tiles from its own workers (e.g. dispatch_apply or pthreads),
+ each with its own rasterizer. A stroke is flattened once per tile it touches, so the tiles should not be too small.
+ */
+typedef struct CVSSCTileReplay CVSSCTileReplay;
+
+/**
+ @brief the default tile size, in pixels
+ */
+enum { CVSSCTileReplayDefaultTileSize = 256 };
+
+/**
+ @brief creates a replay of strokes into the bitmap.
+ @param pTransform maps the components' (user space) coordinates to the bitmap's pixels, as CVSSCRasterizerRenderStroke.
+ @param pClip the pixels which may be modified. it is clipped to the bitmap.
+ @param pTileSize the width and height of a tile, in pixels.
+ @return a new replay with no strokes, or NULL if memory could not be allocated. destroy it with CVSSCTileReplayDestroy.
+ */
+extern CVSSCTileReplay* CVSSCTileReplayCreate(const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const uint32_t pTileSize);
+extern void CVSSCTileReplayDestroy(CVSSCTileReplay* const pReplay);
+
+/**
+ @brief appends a stroke to the tiles it touches. the replay refers to the components; they must remain valid until the
+ replay is destroyed. a fill (CVSSCComponentsAreFill) cannot be replayed by tiles -- its region depends on every stroke
+ below it, in every tile -- so it is not appended. nor is a stroke of a stamped brush, which the rasterizer does not render
+ (see CVSSCStamp).
+ @return false if memory could not be allocated, or the stroke is a fill or is stamped, in which case the replay is unchanged.
+ */
+extern bool CVSSCTileReplayAddStroke(CVSSCTileReplay* const pReplay, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor, const CVSSCComponent* const pComponents, const size_t pCount);
+
+/**
+ @return the number of tiles. tiles are indexed in rows, from the top left.
+ */
+extern size_t CVSSCTileReplayGetTileCount(const CVSSCTileReplay* const pReplay);
+
+/**
+ @return the tile's pixels (within the clip)
+ */
+extern CVSSCPixelRect CVSSCTileReplayGetTileRect(const CVSSCTileReplay* const pReplay, const size_t pTileIndex);
+
+/**
+ @return the number of strokes binned into the tile. a tile with no strokes need not be rendered.
+ */
+extern size_t CVSSCTileReplayGetTileStrokeCount(const CVSSCTileReplay* const pReplay, const size_t pTileIndex);
+
+/**
+ @brief renders the tile's strokes which have not been rendered. distinct tiles may be rendered concurrently (with distinct
+ rasterizers); strokes must not be added while tiles are rendered.
+ @return false if the rasterizer's scratch memory could not be allocated. the strokes before the one which failed are
+ rendered; calling again resumes with it.
+ */
+extern bool CVSSCTileReplayRenderTile(CVSSCTileReplay* const pReplay, CVSSCRasterizer* const pRasterizer, const size_t pTileIndex);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
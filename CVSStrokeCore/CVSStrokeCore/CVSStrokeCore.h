@@ -0,0 +1,51 @@
+// CVSStrokeCore.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// master library import header for libCVSStrokeCore
+// library prefix: CVSSC
+// notes: this library is portable C99. it must not depend on UIKit, CoreData, or Foundation so that it may be built and
+// profiled outside of the app (e.g. on Linux). its one external library is zlib (link with -lz).
+
+#ifndef CVSStrokeCore_CVSStrokeCore_h
+#define CVSStrokeCore_CVSStrokeCore_h
+
+// external dependencies
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// memory
+#include "CVSSCMemory.h"
+
+// stroke data
+#include "CVSSCBrush.h"
+#include "CVSSCColor.h"
+#include "CVSSCComponent.h"
+#include "CVSSCPalette.h"
+
+// geometry
+#include "CVSSCGeometry.h"
+#include "CVSSCSmoothing.h"
+#include "CVSSCSimplify.h"
+#include "CVSSCPolyline.h"
+#include "CVSSCSpatialIndex.h"
+#include "CVSSCStrokeTracker.h"
+
+// rendering
+#include "CVSSCBitmap.h"
+#include "CVSSCFloodFill.h"
+#include "CVSSCRaster.h"
+#include "CVSSCRenderCost.h"
+#include "CVSSCStamp.h"
+#include "CVSSCStrokeBatch.h"
+#include "CVSSCTileReplay.h"
+#include "CVSSCSpan.h"
+#include "CVSSCPNG.h"
+
+// serialization
+#include "CVSSCPlaybackJSON.h"
+#include "CVSSCPlaybackBinary.h"
+#include "CVSSCStrokeJournal.h"
+
+#endif
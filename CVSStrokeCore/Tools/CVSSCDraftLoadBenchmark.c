@@ -0,0 +1,272 @@
+// CVSSCDraftLoadBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// models the two ways CVSStrokeManager opens a draft: replaying the journal and rendering every stroke, or replaying
+// the journal into an index of its strokes (no stroke objects) and restoring the draft image -- and reports the time
+// to the first frame of each.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCDraftLoadBenchmark.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCDraftLoadBenchmark
+//
+// usage:
+//   CVSSCDraftLoadBenchmark [-n strokes] [-i iterations] [-w width] [-h height] [-o directory] playback
+//
+// the playback file is JSON or binary (the format is detected). its strokes are repeated until there are strokes
+// (default 3000) and written to a journal in directory (default .), the drawing is rendered (width x height, default
+// 768x1024) and its pixels are written beside the journal as the draft image. each iteration then reads the files
+// back both ways. exits 1 if the restored image is not the rendering of the replayed strokes.
+
+#define _XOPEN_SOURCE 700
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static bool WriteFile(const char* const pPath, const void* const pBytes, const size_t pLength) {
+    FILE* const file = fopen(pPath, "wb");
+    if (NULL == file) {
+        return false;
+    }
+    const bool result = pLength == fwrite(pBytes, 1, pLength, file);
+    return 0 == fclose(file) && result;
+}
+
+#pragma mark - Replay
+
+// the replayed strokes, as CVSStrokeManager indexes them: the components point into the journal
+typedef struct {
+    CVSSCPlaybackStroke* strokes;
+    size_t count;
+    size_t capacity;
+} StrokeIndex;
+
+static bool IndexReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    StrokeIndex* const index = pContext;
+    if (index->count == index->capacity) {
+        index->capacity = index->capacity ? 2 * index->capacity : 1024;
+        CVSSCPlaybackStroke* const grown = realloc(index->strokes, index->capacity * sizeof(CVSSCPlaybackStroke));
+        if (NULL == grown) {
+            return false;
+        }
+        index->strokes = grown;
+    }
+    index->strokes[index->count++] = *pStroke;
+    return true;
+}
+
+static bool IndexReadEvent(void* const pContext, const CVSSCStrokeJournalRecordType pType, const uint32_t pValue) {
+    (void)pContext;
+    (void)pType;
+    (void)pValue;
+    return true;
+}
+
+static bool ReplayJournal(const char* const pPath, char** const pOutJournal, StrokeIndex* const pIndex) {
+    size_t length = 0;
+    char* const journal = CVSSCToolReadFile(pPath, &length);
+    if (NULL == journal) {
+        return false;
+    }
+    pIndex->count = 0;
+    const CVSSCStrokeJournalCallbacks callbacks = {pIndex, IndexReadStroke, IndexReadEvent};
+    CVSSCPalette* const palette = CVSSCPaletteCreate();
+    size_t validLength = 0;
+    const bool read = palette && CVSSCStrokeJournalStatusComplete == CVSSCStrokeJournalRead(journal, length, &callbacks, palette, &validLength);
+    CVSSCPaletteDestroy(palette);
+    if (!read) {
+        free(journal);
+        return false;
+    }
+    *pOutJournal = journal;
+    return true;
+}
+
+static bool RenderIndex(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const StrokeIndex* const pIndex) {
+    const CVSSCPixelRect clip = CVSSCBitmapGetPixelRect(pBitmap);
+    const CVSSCTransform transform = CVSSCTransformMake(1.0, 0.0, 0.0, 1.0, 0.0, 0.0);
+    CVSSCBitmapClear(pBitmap, clip);
+    for (size_t idx = 0; idx < pIndex->count; ++idx) {
+        const CVSSCPlaybackStroke* const stroke = &pIndex->strokes[idx];
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(stroke->brushType);
+        if (!CVSSCRasterizerRenderStroke(pRasterizer, pBitmap, &transform, clip, brush, stroke->color, stroke->components, stroke->componentCount)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#pragma mark -
+
+static void PrintUsage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-n strokes] [-i iterations] [-w width] [-h height] [-o directory] playback\n", pName);
+}
+
+int main(int argc, char** argv) {
+    size_t strokeCount = 3000;
+    int iterations = 5;
+    uint32_t width = 768;
+    uint32_t height = 1024;
+    const char* directory = ".";
+    const char* playbackPath = NULL;
+    for (int idx = 1; idx < argc; ++idx) {
+        if (0 == strcmp(argv[idx], "-n") && idx + 1 < argc) {
+            strokeCount = (size_t)atol(argv[++idx]);
+        } else if (0 == strcmp(argv[idx], "-i") && idx + 1 < argc) {
+            iterations = atoi(argv[++idx]);
+        } else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        } else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        } else if (0 == strcmp(argv[idx], "-o") && idx + 1 < argc) {
+            directory = argv[++idx];
+        } else if ('-' != argv[idx][0] && NULL == playbackPath) {
+            playbackPath = argv[idx];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (NULL == playbackPath || 0 == strokeCount || 0 >= iterations || 0 == width || 0 == height) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    size_t playbackLength = 0;
+    char* const playback = CVSSCToolReadFile(playbackPath, &playbackLength);
+    CVSSCToolRecording recording = {0};
+    if (NULL == playback || !CVSSCToolReadRecording(playback, playbackLength, &recording) || 0 == recording.strokeCount) {
+        fprintf(stderr, "could not read strokes from %s\n", playbackPath);
+        return 1;
+    }
+    free(playback);
+    char journalPath[4096];
+    char imagePath[4096];
+    snprintf(journalPath, sizeof(journalPath), "%s/CVSSCDraftLoadBenchmark.journal", directory);
+    snprintf(imagePath, sizeof(imagePath), "%s/CVSSCDraftLoadBenchmark.image", directory);
+
+    // the journal of the repeated strokes, at most a Color record per stroke
+    size_t journalCapacity = CVSSCStrokeJournalHeaderLength;
+    for (size_t idx = 0; idx < strokeCount; ++idx) {
+        journalCapacity += CVSSCStrokeJournalColorRecordLength + CVSSCStrokeJournalStrokeRecordLength(recording.strokes[idx % recording.strokeCount].componentCount);
+    }
+    uint8_t* const journal = malloc(journalCapacity);
+    CVSSCPalette* const palette = CVSSCPaletteCreate();
+    const size_t pixelLength = 4 * (size_t)width * height;
+    uint8_t* const pixels = malloc(pixelLength);
+    uint8_t* const restored = malloc(pixelLength);
+    CVSSCRasterizer* const rasterizer = CVSSCRasterizerCreate();
+    if (!journal || !palette || !pixels || !restored || !rasterizer) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    CVSSCStrokeJournalWriteHeader(journal);
+    size_t offset = CVSSCStrokeJournalHeaderLength;
+    size_t componentCount = 0;
+    for (size_t idx = 0; idx < strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const recorded = &recording.strokes[idx % recording.strokeCount];
+        const CVSSCPlaybackStroke stroke = {recorded->brushType, recorded->color, &recording.components[recorded->firstComponent], recorded->componentCount};
+        CVSSCPaletteIndex colorIndex = 0;
+        bool isNewColor = false;
+        if (!CVSSCPaletteFindOrAdd(palette, stroke.color, &colorIndex, &isNewColor)) {
+            fprintf(stderr, "the palette is full\n");
+            return 1;
+        }
+        if (isNewColor) {
+            offset += CVSSCStrokeJournalWriteColorRecord(journal + offset, colorIndex, stroke.color);
+        }
+        offset += CVSSCStrokeJournalWriteStrokeRecord(journal + offset, &stroke, colorIndex);
+        componentCount += stroke.componentCount;
+    }
+    const size_t journalLength = offset;
+    if (!WriteFile(journalPath, journal, journalLength)) {
+        fprintf(stderr, "could not write %s\n", journalPath);
+        return 1;
+    }
+    free(journal);
+    CVSSCPaletteDestroy(palette);
+
+    // the draft image: the rendering of the journal's strokes
+    const CVSSCBitmap bitmap = CVSSCBitmapMake(pixels, width, height, 4 * (size_t)width);
+    StrokeIndex index = {0};
+    char* replayed = NULL;
+    if (!ReplayJournal(journalPath, &replayed, &index) || index.count != strokeCount) {
+        fprintf(stderr, "could not replay %s\n", journalPath);
+        return 1;
+    }
+    if (!RenderIndex(rasterizer, &bitmap, &index) || !WriteFile(imagePath, pixels, pixelLength)) {
+        fprintf(stderr, "could not write %s\n", imagePath);
+        return 1;
+    }
+    free(replayed);
+
+    double renderReplaySeconds = 0.0, renderSeconds = 0.0, imageReplaySeconds = 0.0, imageSeconds = 0.0;
+    int result = 0;
+    for (int iteration = 0; 0 == result && iteration < iterations; ++iteration) {
+        // replay and render every stroke
+        double start = Now();
+        if (!ReplayJournal(journalPath, &replayed, &index)) {
+            result = 1;
+            break;
+        }
+        double replayEnd = Now();
+        if (!RenderIndex(rasterizer, &bitmap, &index)) {
+            result = 1;
+            break;
+        }
+        const double renderEnd = Now();
+        renderReplaySeconds += replayEnd - start;
+        renderSeconds += renderEnd - replayEnd;
+        free(replayed);
+
+        // replay into the index and restore the image
+        start = Now();
+        if (!ReplayJournal(journalPath, &replayed, &index)) {
+            result = 1;
+            break;
+        }
+        replayEnd = Now();
+        size_t imageLength = 0;
+        char* const image = CVSSCToolReadFile(imagePath, &imageLength);
+        if (NULL == image || pixelLength != imageLength) {
+            free(image);
+            result = 1;
+            break;
+        }
+        memcpy(restored, image, pixelLength);
+        const double imageEnd = Now();
+        imageReplaySeconds += replayEnd - start;
+        imageSeconds += imageEnd - replayEnd;
+        free(image);
+        free(replayed);
+        if (0 != memcmp(restored, pixels, pixelLength)) {
+            fprintf(stderr, "the restored image is not the rendering of the replayed strokes\n");
+            result = 1;
+        }
+    }
+    if (0 == result) {
+        const double scale = 1.0e3 / iterations;
+        printf("%s\n", playbackPath);
+        printf("  strokes: %zu components: %zu journal: %zu octets image: %zu octets canvas: %ux%u px\n", strokeCount, componentCount, journalLength, pixelLength, width, height);
+        printf("  render:  replay %8.3f ms + render  %9.3f ms = %9.3f ms to the first frame\n", scale * renderReplaySeconds, scale * renderSeconds, scale * (renderReplaySeconds + renderSeconds));
+        printf("  image:   replay %8.3f ms + restore %9.3f ms = %9.3f ms to the first frame\n", scale * imageReplaySeconds, scale * imageSeconds, scale * (imageReplaySeconds + imageSeconds));
+    } else {
+        fprintf(stderr, "the draft could not be loaded\n");
+    }
+    CVSSCRasterizerDestroy(rasterizer);
+    free(index.strokes);
+    free(pixels);
+    free(restored);
+    CVSSCToolRecordingFree(&recording);
+    return result;
+}
@@ -0,0 +1,445 @@
+// CVSSCFloodFillBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// renders recorded playback JSON with the software rasterizer, then flood fills (CVSSCFloodFill) from seeds spread
+// over the canvas. every fill is checked against a pixel at a time reference fill, and the throughput of both is
+// reported -- along with the cost of the legacy paint bucket (a 5000 point wide stroke) which the fill replaces.
+// the fills are found again with the strokes over a transparent canvas and a template of outlines as the underlay, and
+// checked against the reference fill of the strokes composited over the template. before the benchmark, a fill and a
+// legacy paint bucket point are written as playback JSON and read back, to check that the fill is written as a point
+// marked "fill" (which players that predate fills draw as the paint bucket stroke) and that only the fill reads as one.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCFloodFillBenchmark.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCFloodFillBenchmark
+// add -DCVSSC_SPAN_SCALAR to measure the scalar span matching.
+//
+// usage:
+//   CVSSCFloodFillBenchmark [-n seeds] [-t tolerance] [-w width] [-h height] [-s scale] playback.json ...
+//
+// exits 1 if the fill does not read back as written, or any fill (with or without the underlay) differs from the reference fill.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+#pragma mark - Rendering
+
+typedef struct {
+    CVSSCRasterizer* rasterizer;
+    const CVSSCBitmap* bitmap;
+    const CVSSCTransform* transform;
+} RenderContext;
+
+static bool RenderStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    const RenderContext* const context = pContext;
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(pStroke->brushType);
+    return CVSSCRasterizerRenderStroke(context->rasterizer, context->bitmap, context->transform, CVSSCBitmapGetPixelRect(context->bitmap),
+                                       brush, pStroke->color, pStroke->components, pStroke->componentCount);
+}
+
+static bool RenderFile(const char* const pPath, CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        return false;
+    }
+    const RenderContext context = {pRasterizer, pBitmap, pTransform};
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {(void*)&context, NULL, RenderStroke};
+    CVSSCPlaybackJSONReader* const reader = CVSSCPlaybackJSONReaderCreate(&callbacks);
+    const bool result = reader && CVSSCPlaybackJSONReaderAppend(reader, bytes, length) && CVSSCPlaybackJSONReaderFinish(reader);
+    CVSSCPlaybackJSONReaderDestroy(reader);
+    free(bytes);
+    return result;
+}
+
+#pragma mark - Reference Fill
+
+static bool PixelMatches(const uint8_t* const pPixel, const uint8_t* const pColor, const int pTolerance) {
+    for (int idx = 0; idx < 4; ++idx) {
+        if (abs((int)pPixel[idx] - (int)pColor[idx]) > pTolerance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a 4-connected fill, a pixel at a time. sets pMask (one byte per pixel) for the pixels of the fill.
+// pStack must hold a pixel index per pixel of the bitmap.
+static size_t ReferenceFill(const CVSSCBitmap* const pBitmap, const uint32_t pSeedX, const uint32_t pSeedY, const int pTolerance, uint8_t* const pMask, uint32_t* const pStack) {
+    const uint32_t width = pBitmap->width;
+    const uint32_t height = pBitmap->height;
+    uint8_t color[4];
+    memcpy(color, CVSSCBitmapGetPixel(pBitmap, pSeedX, pSeedY), sizeof(color));
+    size_t count = 0;
+    size_t stackCount = 0;
+    pStack[stackCount++] = pSeedY * width + pSeedX;
+    pMask[pSeedY * width + pSeedX] = 1;
+    while (stackCount) {
+        const uint32_t at = pStack[--stackCount];
+        ++count;
+        const uint32_t x = at % width;
+        const uint32_t y = at / width;
+        const int32_t neighbors[4][2] = {{(int32_t)x - 1, (int32_t)y}, {(int32_t)x + 1, (int32_t)y}, {(int32_t)x, (int32_t)y - 1}, {(int32_t)x, (int32_t)y + 1}};
+        for (int idx = 0; idx < 4; ++idx) {
+            const int32_t nx = neighbors[idx][0];
+            const int32_t ny = neighbors[idx][1];
+            if (nx < 0 || ny < 0 || (uint32_t)nx >= width || (uint32_t)ny >= height) {
+                continue;
+            }
+            const uint32_t neighbor = (uint32_t)ny * width + (uint32_t)nx;
+            if (!pMask[neighbor] && PixelMatches(CVSSCBitmapGetPixel(pBitmap, (uint32_t)nx, (uint32_t)ny), color, pTolerance)) {
+                pMask[neighbor] = 1;
+                pStack[stackCount++] = neighbor;
+            }
+        }
+    }
+    return count;
+}
+
+// returns true if the spans are disjoint and cover exactly the pixels of pReferenceMask, which has pReferenceCount pixels.
+// pFillMask (one byte per pixel) is scratch.
+static bool SpansMatchReference(const CVSSCFillSpan* const pSpans, const size_t pSpanCount, const uint32_t pWidth, const uint32_t pHeight,
+                                const uint8_t* const pReferenceMask, const size_t pReferenceCount, uint8_t* const pFillMask, size_t* const pOutFillCount) {
+    memset(pFillMask, 0, (size_t)pWidth * pHeight);
+    size_t fillCount = 0;
+    bool matches = true;
+    for (size_t idx = 0; matches && idx < pSpanCount; ++idx) {
+        for (int32_t x = pSpans[idx].minX; matches && x < pSpans[idx].maxX; ++x) {
+            const size_t at = (size_t)pSpans[idx].y * pWidth + (size_t)x;
+            matches = !pFillMask[at] && pReferenceMask[at];
+            pFillMask[at] = 1;
+            ++fillCount;
+        }
+    }
+    *pOutFillCount = fillCount;
+    return matches && fillCount == pReferenceCount;
+}
+
+#pragma mark - Underlay
+
+// the template: opaque white, with dark outlines of a grid of cells, as a quest template's line art
+static void DrawTemplate(const CVSSCBitmap* const pBitmap, const double pScale) {
+    const uint32_t cell = (uint32_t)(96.0 * pScale);
+    const uint32_t line = (uint32_t)(2.0 * pScale);
+    for (uint32_t y = 0; y < pBitmap->height; ++y) {
+        uint8_t* pixel = CVSSCBitmapGetPixel(pBitmap, 0, y);
+        for (uint32_t x = 0; x < pBitmap->width; ++x, pixel += 4) {
+            const bool isOutline = (x % cell) < line || (y % cell) < line;
+            pixel[0] = pixel[1] = pixel[2] = isOutline ? 40 : 255;
+            pixel[3] = 255;
+        }
+    }
+}
+
+// composites pSource over pUnderlay (source over, premultiplied, rounded) into pResult, a pixel at a time
+static void ReferenceComposite(const CVSSCBitmap* const pResult, const CVSSCBitmap* const pSource, const CVSSCBitmap* const pUnderlay) {
+    for (uint32_t y = 0; y < pResult->height; ++y) {
+        for (uint32_t x = 0; x < pResult->width; ++x) {
+            const uint8_t* const source = CVSSCBitmapGetPixel(pSource, x, y);
+            const uint8_t* const underlay = CVSSCBitmapGetPixel(pUnderlay, x, y);
+            uint8_t* const result = CVSSCBitmapGetPixel(pResult, x, y);
+            for (int idx = 0; idx < 4; ++idx) {
+                result[idx] = (uint8_t)(source[idx] + ((uint32_t)underlay[idx] * (255U - source[3]) * 2U + 255U) / 510U);
+            }
+        }
+    }
+}
+
+#pragma mark - Playback JSON
+
+typedef struct {
+    char bytes[1024];
+    size_t length;
+} JSONBuffer;
+
+static bool WriteToJSONBuffer(void* const pContext, const void* const pBytes, const size_t pLength) {
+    JSONBuffer* const buffer = pContext;
+    if (buffer->length + pLength >= sizeof(buffer->bytes)) {
+        return false;
+    }
+    memcpy(buffer->bytes + buffer->length, pBytes, pLength);
+    buffer->length += pLength;
+    buffer->bytes[buffer->length] = 0;
+    return true;
+}
+
+typedef struct {
+    CVSSCComponent components[2];
+    size_t count;
+} ReadComponents;
+
+static bool ReadComponent(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    ReadComponents* const read = pContext;
+    for (size_t idx = 0; idx < pStroke->componentCount && read->count < 2; ++idx) {
+        read->components[read->count++] = pStroke->components[idx];
+    }
+    return true;
+}
+
+// writes a fill stroke and a legacy paint bucket stroke (a point) as playback JSON and reads them back. returns false,
+// having printed why, if the fill is not written as a marked point or either does not read back as it was.
+static bool CheckFillJSON(void) {
+    const CVSSCPoint seed = {212.5, 96.25};
+    const CVSSCComponent written[2] = {CVSSCComponentMakeFill(seed), CVSSCComponentMakePoint(seed, seed)};
+    JSONBuffer buffer;
+    buffer.length = 0;
+    const CVSSCPlaybackOutput output = {&buffer, WriteToJSONBuffer};
+    CVSSCPlaybackJSONWriter* const writer = CVSSCPlaybackJSONWriterCreate(&output);
+    bool succeeded = NULL != writer;
+    for (size_t idx = 0; succeeded && idx < 2; ++idx) {
+        const CVSSCPlaybackStroke stroke = {CVSSCBrushTypePaintbucket, {0.25, 0.5, 0.75, 1}, &written[idx], 1};
+        succeeded = CVSSCPlaybackJSONWriterWriteStroke(writer, &stroke);
+    }
+    succeeded = succeeded && CVSSCPlaybackJSONWriterFinish(writer);
+    CVSSCPlaybackJSONWriterDestroy(writer);
+    if (!succeeded) {
+        printf("fill: the playback JSON could not be written\n");
+        return false;
+    }
+    if (NULL != strstr(buffer.bytes, "\"type\":2") || NULL == strstr(buffer.bytes, "\"type\":0,\"fromPoint\":\"{212.5, 96.25}\",\"toPoint\":\"{212.5, 96.25}\",\"fill\":1}")) {
+        printf("fill: not written as a point marked \"fill\": %s\n", buffer.bytes);
+        return false;
+    }
+    ReadComponents read;
+    memset(&read, 0, sizeof(read));
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {&read, NULL, ReadComponent};
+    CVSSCPlaybackJSONReader* const reader = CVSSCPlaybackJSONReaderCreate(&callbacks);
+    succeeded = NULL != reader && CVSSCPlaybackJSONReaderAppend(reader, buffer.bytes, buffer.length) && CVSSCPlaybackJSONReaderFinish(reader);
+    CVSSCPlaybackJSONReaderDestroy(reader);
+    if (!succeeded || 2 != read.count || !CVSSCComponentIsEqual(&read.components[0], &written[0]) || !CVSSCComponentIsEqual(&read.components[1], &written[1])) {
+        printf("fill: the playback JSON does not read back as written: %s\n", buffer.bytes);
+        return false;
+    }
+    return true;
+}
+
+#pragma mark - Benchmark
+
+typedef struct {
+    size_t fillCount;
+    size_t mismatchCount;
+    double filledPixels;
+    double findSeconds;
+    double blendSeconds;
+    double referenceSeconds;
+    double legacySeconds;
+    size_t underlayFillCount;
+    size_t underlayMismatchCount;
+    double underlayFilledPixels;
+    double underlayFindSeconds;
+} Totals;
+
+static uint32_t NextRandom(uint32_t* const pState) {
+    *pState = *pState * 1664525U + 1013904223U;
+    return *pState >> 8;
+}
+
+static int Benchmark(const char* const pPath, const int pSeedCount, const int pTolerance, const uint32_t pWidth, const uint32_t pHeight, const double pScale, Totals* const pTotals) {
+    const uint32_t width = (uint32_t)(pWidth * pScale + 0.5);
+    const uint32_t height = (uint32_t)(pHeight * pScale + 0.5);
+    const size_t pixelCount = (size_t)width * height;
+    uint8_t* const drawing = malloc(4 * pixelCount);
+    uint8_t* const scratch = malloc(4 * pixelCount);
+    uint8_t* const referenceMask = malloc(pixelCount);
+    uint8_t* const fillMask = malloc(pixelCount);
+    uint32_t* const stack = malloc(pixelCount * sizeof(uint32_t));
+    CVSSCRasterizer* const rasterizer = CVSSCRasterizerCreate();
+    CVSSCFloodFiller* const filler = CVSSCFloodFillerCreate();
+    int result = 0;
+    if (!drawing || !scratch || !referenceMask || !fillMask || !stack || !rasterizer || !filler) {
+        fprintf(stderr, "out of memory\n");
+        result = 1;
+    }
+    const CVSSCBitmap bitmap = CVSSCBitmapMake(drawing, width, height, 4 * (size_t)width);
+    const CVSSCBitmap scratchBitmap = CVSSCBitmapMake(scratch, width, height, 4 * (size_t)width);
+    const CVSSCTransform transform = CVSSCTransformMake(pScale, 0.0, 0.0, pScale, 0.0, 0.0);
+    if (0 == result) {
+        CVSSCBitmapFill(&bitmap, CVSSCBitmapGetPixelRect(&bitmap), (CVSSCColor){1.0, 1.0, 1.0, 1.0});
+        if (!RenderFile(pPath, rasterizer, &bitmap, &transform)) {
+            fprintf(stderr, "%s: could not be rendered\n", pPath);
+            result = 1;
+        }
+    }
+    const CVSSCColor paint = {0.9, 0.3, 0.1, 1.0};
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(CVSSCBrushTypePaintbucket);
+    uint32_t random = 0x2545F491U;
+    size_t mismatches = 0;
+    for (int seedIdx = 0; 0 == result && seedIdx < pSeedCount; ++seedIdx) {
+        const uint32_t seedX = NextRandom(&random) % width;
+        const uint32_t seedY = NextRandom(&random) % height;
+
+        double start = Now();
+        if (!CVSSCFloodFillerFind(filler, &bitmap, NULL, (int32_t)seedX, (int32_t)seedY, (uint8_t)pTolerance)) {
+            fprintf(stderr, "out of memory\n");
+            result = 1;
+            break;
+        }
+        pTotals->findSeconds += Now() - start;
+        size_t spanCount = 0;
+        const CVSSCFillSpan* const spans = CVSSCFloodFillerGetSpans(filler, &spanCount);
+
+        memcpy(scratch, drawing, 4 * pixelCount);
+        start = Now();
+        CVSSCFillSpansBlend(&scratchBitmap, CVSSCBitmapGetPixelRect(&scratchBitmap), spans, spanCount, brush, paint);
+        pTotals->blendSeconds += Now() - start;
+
+        // the legacy paint bucket: a line from the seed to itself, 5000 points wide
+        const CVSSCPoint seedPoint = {(seedX + 0.5) / pScale, (seedY + 0.5) / pScale};
+        const CVSSCComponent legacy = CVSSCComponentMakePoint(seedPoint, seedPoint);
+        start = Now();
+        if (!CVSSCRasterizerRenderStroke(rasterizer, &scratchBitmap, &transform, CVSSCBitmapGetPixelRect(&scratchBitmap), brush, paint, &legacy, 1)) {
+            fprintf(stderr, "out of memory\n");
+            result = 1;
+            break;
+        }
+        pTotals->legacySeconds += Now() - start;
+
+        memset(referenceMask, 0, pixelCount);
+        start = Now();
+        const size_t referenceCount = ReferenceFill(&bitmap, seedX, seedY, pTolerance, referenceMask, stack);
+        pTotals->referenceSeconds += Now() - start;
+
+        size_t fillCount = 0;
+        if (!SpansMatchReference(spans, spanCount, width, height, referenceMask, referenceCount, fillMask, &fillCount)) {
+            fprintf(stderr, "%s: the fill from %u,%u differs from the reference (%zu pixels vs %zu)\n", pPath, seedX, seedY, fillCount, referenceCount);
+            ++mismatches;
+        }
+        pTotals->filledPixels += (double)referenceCount;
+        ++pTotals->fillCount;
+    }
+    pTotals->mismatchCount += mismatches;
+
+    // the strokes over a transparent canvas (in scratch), with the template as the underlay. the reference fill is of the
+    // strokes composited over the template (in drawing).
+    uint8_t* const underlayPixels = 0 == result ? malloc(4 * pixelCount) : NULL;
+    if (0 == result && !underlayPixels) {
+        fprintf(stderr, "out of memory\n");
+        result = 1;
+    }
+    const CVSSCBitmap underlay = CVSSCBitmapMake(underlayPixels, width, height, 4 * (size_t)width);
+    if (0 == result) {
+        DrawTemplate(&underlay, pScale);
+        memset(scratch, 0, 4 * pixelCount);
+        if (!RenderFile(pPath, rasterizer, &scratchBitmap, &transform)) {
+            fprintf(stderr, "%s: could not be rendered\n", pPath);
+            result = 1;
+        }
+        ReferenceComposite(&bitmap, &scratchBitmap, &underlay);
+    }
+    random = 0x2545F491U;
+    mismatches = 0;
+    for (int seedIdx = 0; 0 == result && seedIdx < pSeedCount; ++seedIdx) {
+        const uint32_t seedX = NextRandom(&random) % width;
+        const uint32_t seedY = NextRandom(&random) % height;
+        const double start = Now();
+        if (!CVSSCFloodFillerFind(filler, &scratchBitmap, &underlay, (int32_t)seedX, (int32_t)seedY, (uint8_t)pTolerance)) {
+            fprintf(stderr, "out of memory\n");
+            result = 1;
+            break;
+        }
+        pTotals->underlayFindSeconds += Now() - start;
+        size_t spanCount = 0;
+        const CVSSCFillSpan* const spans = CVSSCFloodFillerGetSpans(filler, &spanCount);
+
+        memset(referenceMask, 0, pixelCount);
+        const size_t referenceCount = ReferenceFill(&bitmap, seedX, seedY, pTolerance, referenceMask, stack);
+        size_t fillCount = 0;
+        if (!SpansMatchReference(spans, spanCount, width, height, referenceMask, referenceCount, fillMask, &fillCount)) {
+            fprintf(stderr, "%s: the fill over the template from %u,%u differs from the reference (%zu pixels vs %zu)\n", pPath, seedX, seedY, fillCount, referenceCount);
+            ++mismatches;
+        }
+        pTotals->underlayFilledPixels += (double)referenceCount;
+        ++pTotals->underlayFillCount;
+    }
+    pTotals->underlayMismatchCount += mismatches;
+    free(underlayPixels);
+    CVSSCFloodFillerDestroy(filler);
+    CVSSCRasterizerDestroy(rasterizer);
+    free(stack);
+    free(fillMask);
+    free(referenceMask);
+    free(scratch);
+    free(drawing);
+    return result;
+}
+
+#pragma mark - Main
+
+static int Usage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-n seeds] [-t tolerance] [-w width] [-h height] [-s scale] playback.json ...\n", pName);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    int seedCount = 200;
+    int tolerance = CVSSCFloodFillDefaultTolerance;
+    uint32_t width = 768;
+    uint32_t height = 1024;
+    double scale = 2.0;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-n") && idx + 1 < argc) {
+            seedCount = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-t") && idx + 1 < argc) {
+            tolerance = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            scale = atof(argv[++idx]);
+        }
+        else {
+            return Usage(argv[0]);
+        }
+    }
+    if (idx == argc || 0 >= seedCount || tolerance < 0 || tolerance > 255 || 0 == width || 0 == height || !(scale > 0.0)) {
+        return Usage(argv[0]);
+    }
+    if (!CheckFillJSON()) {
+        return 1;
+    }
+    Totals totals;
+    memset(&totals, 0, sizeof(totals));
+    for (; idx < argc; ++idx) {
+        if (0 != Benchmark(argv[idx], seedCount, tolerance, width, height, scale, &totals)) {
+            return 1;
+        }
+    }
+    const double megapixels = totals.filledPixels * 1.0e-6;
+    printf("fills: %zu tolerance: %d scale: %.1f spans: %s mean fill: %.0f px\n", totals.fillCount, tolerance, scale, CVSSCSpanImplementationName(), totals.filledPixels / (double)totals.fillCount);
+    printf("  find:      %8.3f ms/fill %8.1f Mpx/sec\n", 1.0e3 * totals.findSeconds / (double)totals.fillCount, megapixels / totals.findSeconds);
+    printf("  blend:     %8.3f ms/fill %8.1f Mpx/sec\n", 1.0e3 * totals.blendSeconds / (double)totals.fillCount, megapixels / totals.blendSeconds);
+    printf("  reference: %8.3f ms/fill %8.1f Mpx/sec\n", 1.0e3 * totals.referenceSeconds / (double)totals.fillCount, megapixels / totals.referenceSeconds);
+    printf("  legacy paint bucket stroke: %8.3f ms/fill\n", 1.0e3 * totals.legacySeconds / (double)totals.fillCount);
+    printf("  find over the template: %8.3f ms/fill %8.1f Mpx/sec (mean fill: %.0f px)\n", 1.0e3 * totals.underlayFindSeconds / (double)totals.underlayFillCount,
+           totals.underlayFilledPixels * 1.0e-6 / totals.underlayFindSeconds, totals.underlayFilledPixels / (double)totals.underlayFillCount);
+    int result = 0;
+    if (totals.mismatchCount) {
+        printf("%zu fills differ from the reference\n", totals.mismatchCount);
+        result = 1;
+    }
+    if (totals.underlayMismatchCount) {
+        printf("%zu fills over the template differ from the reference\n", totals.underlayMismatchCount);
+        result = 1;
+    }
+    return result;
+}
@@ -0,0 +1,209 @@
+// CVSSCPlaybackConvert.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// converts playback data between JSON and the binary format, and compares their sizes and parse times.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCPlaybackConvert.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCPlaybackConvert
+//
+// usage:
+//   CVSSCPlaybackConvert [-s coordinateShift] [-raw] input output
+//     converts JSON to binary, or binary to JSON -- the input's format is detected. -raw omits the deflate layer.
+//   CVSSCPlaybackConvert -compare [-i iterations] playback.json [playback.json ...]
+//     converts each file to binary (raw and deflated) in memory and reports sizes and parse times of the three forms.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+#include "CVSSCPlaybackBinary.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+#pragma mark - Outputs
+
+static bool WriteToFile(void* const pContext, const void* const pBytes, const size_t pLength) {
+    return pLength == fwrite(pBytes, 1, pLength, (FILE*)pContext);
+}
+
+typedef struct {
+    char* bytes;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static bool WriteToBuffer(void* const pContext, const void* const pBytes, const size_t pLength) {
+    Buffer* const buffer = pContext;
+    if (buffer->capacity - buffer->length < pLength) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 1 << 16;
+        while (capacity - buffer->length < pLength) {
+            capacity *= 2;
+        }
+        char* const grown = realloc(buffer->bytes, capacity);
+        if (NULL == grown) {
+            return false;
+        }
+        buffer->bytes = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->bytes + buffer->length, pBytes, pLength);
+    buffer->length += pLength;
+    return true;
+}
+
+#pragma mark - Convert
+
+static int ConvertFile(const char* const pInputPath, const char* const pOutputPath, const CVSSCPlaybackBinaryOptions* const pOptions) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pInputPath, &length);
+    if (NULL == bytes) {
+        fprintf(stderr, "%s: unable to read\n", pInputPath);
+        return 1;
+    }
+    FILE* const file = fopen(pOutputPath, "wb");
+    if (NULL == file) {
+        fprintf(stderr, "%s: unable to write\n", pOutputPath);
+        free(bytes);
+        return 1;
+    }
+    const CVSSCPlaybackOutput output = {file, WriteToFile};
+    const bool isBinary = CVSSCPlaybackBinaryHasSignature(bytes, length);
+    const bool converted = isBinary ? CVSSCPlaybackConvertBinaryToJSON(bytes, length, &output) : CVSSCPlaybackConvertJSONToBinary(bytes, length, pOptions, &output);
+    const bool closed = 0 == fclose(file);
+    free(bytes);
+    if (!converted || !closed) {
+        fprintf(stderr, "%s: conversion failed (malformed input, or the output could not be written)\n", pInputPath);
+        remove(pOutputPath);
+        return 1;
+    }
+    return 0;
+}
+
+#pragma mark - Compare
+
+static bool CountStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    *(size_t*)pContext += pStroke->componentCount;
+    return true;
+}
+
+// returns the seconds per parse, or a negative value if the data is malformed
+static double TimeParse(const char* const pBytes, const size_t pLength, const int pIterations, size_t* const pOutComponentCount) {
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {pOutComponentCount, NULL, CountStroke};
+    const bool isBinary = CVSSCPlaybackBinaryHasSignature(pBytes, pLength);
+    const double start = Now();
+    for (int idx = 0; idx < pIterations; ++idx) {
+        *pOutComponentCount = 0;
+        bool succeeded = false;
+        if (isBinary) {
+            CVSSCPlaybackBinaryReader* const reader = CVSSCPlaybackBinaryReaderCreate(&callbacks);
+            succeeded = reader && CVSSCPlaybackBinaryReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackBinaryReaderFinish(reader);
+            CVSSCPlaybackBinaryReaderDestroy(reader);
+        }
+        else {
+            CVSSCPlaybackJSONReader* const reader = CVSSCPlaybackJSONReaderCreate(&callbacks);
+            succeeded = reader && CVSSCPlaybackJSONReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackJSONReaderFinish(reader);
+            CVSSCPlaybackJSONReaderDestroy(reader);
+        }
+        if (!succeeded) {
+            return -1.0;
+        }
+    }
+    return (Now() - start) / pIterations;
+}
+
+static int CompareFile(const char* const pPath, const int pIterations, const uint8_t pCoordinateShift) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        fprintf(stderr, "%s: unable to read\n", pPath);
+        return 1;
+    }
+    Buffer raw = {NULL, 0, 0};
+    Buffer deflated = {NULL, 0, 0};
+    const CVSSCPlaybackOutput rawOutput = {&raw, WriteToBuffer};
+    const CVSSCPlaybackOutput deflatedOutput = {&deflated, WriteToBuffer};
+    const CVSSCPlaybackBinaryOptions rawOptions = {pCoordinateShift, false};
+    const CVSSCPlaybackBinaryOptions deflatedOptions = {pCoordinateShift, true};
+    const double encodeStart = Now();
+    const bool converted = CVSSCPlaybackConvertJSONToBinary(bytes, length, &deflatedOptions, &deflatedOutput);
+    const double encodeSeconds = Now() - encodeStart;
+    if (!converted || !CVSSCPlaybackConvertJSONToBinary(bytes, length, &rawOptions, &rawOutput)) {
+        fprintf(stderr, "%s: malformed playback JSON\n", pPath);
+        free(bytes);
+        free(raw.bytes);
+        free(deflated.bytes);
+        return 1;
+    }
+    size_t jsonComponents = 0;
+    size_t rawComponents = 0;
+    size_t deflatedComponents = 0;
+    const double jsonSeconds = TimeParse(bytes, length, pIterations, &jsonComponents);
+    const double rawSeconds = TimeParse(raw.bytes, raw.length, pIterations, &rawComponents);
+    const double deflatedSeconds = TimeParse(deflated.bytes, deflated.length, pIterations, &deflatedComponents);
+    printf("%s\n", pPath);
+    printf("  components: %zu (convert to deflated binary: %.3f ms)\n", jsonComponents, 1.0e3 * encodeSeconds);
+    printf("  json:            %10zu octets %8.3f ms/parse\n", length, 1.0e3 * jsonSeconds);
+    printf("  binary:          %10zu octets %8.3f ms/parse (%.1fx smaller, %.1fx faster)\n",
+           raw.length, 1.0e3 * rawSeconds, (double)length / raw.length, jsonSeconds / rawSeconds);
+    printf("  binary+deflate:  %10zu octets %8.3f ms/parse (%.1fx smaller, %.1fx faster)\n",
+           deflated.length, 1.0e3 * deflatedSeconds, (double)length / deflated.length, jsonSeconds / deflatedSeconds);
+    const bool matches = jsonComponents == rawComponents && jsonComponents == deflatedComponents && 0 <= rawSeconds && 0 <= deflatedSeconds;
+    if (!matches) {
+        fprintf(stderr, "%s: the binary forms do not read back\n", pPath);
+    }
+    free(bytes);
+    free(raw.bytes);
+    free(deflated.bytes);
+    return matches ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    bool compare = false;
+    int iterations = 10;
+    int coordinateShift = CVSSCPlaybackBinaryDefaultCoordinateShift;
+    bool deflate = true;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-compare")) {
+            compare = true;
+        }
+        else if (0 == strcmp(argv[idx], "-i") && idx + 1 < argc) {
+            iterations = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            coordinateShift = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-raw")) {
+            deflate = false;
+        }
+        else {
+            break;
+        }
+    }
+    const bool validOptions = 0 < iterations && 0 <= coordinateShift && CVSSCPlaybackBinaryMaxCoordinateShift >= coordinateShift;
+    if (!validOptions || (compare ? idx == argc : idx + 2 != argc)) {
+        fprintf(stderr, "usage: %s [-s coordinateShift] [-raw] input output\n", argv[0]);
+        fprintf(stderr, "       %s -compare [-i iterations] [-s coordinateShift] playback.json [playback.json ...]\n", argv[0]);
+        return 2;
+    }
+    if (!compare) {
+        const CVSSCPlaybackBinaryOptions options = {(uint8_t)coordinateShift, deflate};
+        return ConvertFile(argv[idx], argv[idx + 1], &options);
+    }
+    int result = 0;
+    for (; idx < argc; ++idx) {
+        result |= CompareFile(argv[idx], iterations, (uint8_t)coordinateShift);
+    }
+    return result;
+}
@@ -0,0 +1,316 @@
+// CVSSCPolylineBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// measures the flattened levels of detail of strokes (CVSSCPolyline): the time and memory to flatten every stroke at each
+// level, and rendering at several scales from the components (the rasterizer flattens every curve) against rendering the
+// level CVSSCPolylineLevelForScale chooses, as CVSStrokeRenderer does. verifies that the chosen level is visually exact.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCPolylineBenchmark.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCPolylineBenchmark
+//
+// usage:
+//   CVSSCPolylineBenchmark [-i iterations] [-w width] [-h height] playback...
+//
+// each playback file is JSON or binary (the format is detected). its stroked strokes are rendered with the software
+// rasterizer into a width x height (points) canvas at 1/8 to 8 pixels per point, at the levels' scales and between them; a
+// canvas larger than 2048 pixels on a side is clipped to its top left. fills and stamped brushes are not stroked, so they
+// are skipped. each scale is also rendered from the curves flattened within 1/64 pixel, the reference. reports the level,
+// ms/drawing of each rendering, the pixels which differ between them, and how far each is from the reference. exits 1 if
+// a pixel of the level differs from the components' by more than MaximumPixelDifference, or if the level is farther from
+// the reference than the components are. both flatten the curves, the components within CVSSCRasterFlatteningTolerance and
+// the level within half of it, so their antialiased edges differ by a fraction of a pixel's coverage; the level is the
+// closer of the two to the curves. it saves the subdivision rather than segments, so it is not faster at every scale.
+
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+#pragma mark - Levels
+
+// the polylines of every stroke at one level
+typedef struct {
+    CVSSCPolyline** polylines;
+    size_t pointCount;
+    size_t byteCount;
+    double seconds;
+} Level;
+
+static void LevelDestroyPolylines(Level* const pLevel, const size_t pCount) {
+    if (pLevel->polylines) {
+        for (size_t idx = 0; idx < pCount; ++idx) {
+            CVSSCPolylineDestroy(pLevel->polylines[idx]);
+        }
+    }
+    free(pLevel->polylines);
+    pLevel->polylines = NULL;
+}
+
+// flattens every stroke at the level, keeping the last iteration's polylines
+static bool MakeLevel(const CVSSCToolRecording* const pRecording, const CVSSCPolylineLevel pLevel, const int pIterations, Level* const pOutLevel) {
+    memset(pOutLevel, 0, sizeof(Level));
+    pOutLevel->polylines = calloc(pRecording->strokeCount + 1, sizeof(CVSSCPolyline*));
+    if (NULL == pOutLevel->polylines) {
+        return false;
+    }
+    const double tolerance = CVSSCPolylineLevelGetTolerance(pLevel);
+    for (int iteration = 0; iteration < pIterations; ++iteration) {
+        LevelDestroyPolylines(pOutLevel, pRecording->strokeCount);
+        pOutLevel->polylines = calloc(pRecording->strokeCount + 1, sizeof(CVSSCPolyline*));
+        if (NULL == pOutLevel->polylines) {
+            return false;
+        }
+        const double start = Now();
+        for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+            const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[idx];
+            pOutLevel->polylines[idx] = CVSSCPolylineCreate(&pRecording->components[stroke->firstComponent], stroke->componentCount, tolerance);
+            if (NULL == pOutLevel->polylines[idx]) {
+                return false;
+            }
+        }
+        pOutLevel->seconds += Now() - start;
+    }
+    pOutLevel->seconds /= pIterations;
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        pOutLevel->pointCount += CVSSCPolylineGetPointCount(pOutLevel->polylines[idx]);
+        pOutLevel->byteCount += CVSSCPolylineGetByteCount(pOutLevel->polylines[idx]);
+    }
+    return true;
+}
+
+#pragma mark - Rendering
+
+// the largest difference of a channel of a pixel rendered from a level and from the components
+enum { MaximumPixelDifference = 32 };
+enum { MaximumCanvasSide = 2048 };
+// the reference's flattening tolerance, in pixels
+static const double ReferenceFlatteningTolerance = 1.0 / 64.0;
+
+static bool RenderComponents(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCToolRecording* const pRecording) {
+    const CVSSCPixelRect clip = CVSSCBitmapGetPixelRect(pBitmap);
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[idx];
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(stroke->brushType);
+        if (!CVSSCRasterizerRenderStroke(pRasterizer, pBitmap, pTransform, clip, brush, stroke->color, &pRecording->components[stroke->firstComponent], stroke->componentCount)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool RenderLevel(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCToolRecording* const pRecording, const Level* const pLevel) {
+    const CVSSCPixelRect clip = CVSSCBitmapGetPixelRect(pBitmap);
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[idx];
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(stroke->brushType);
+        const CVSSCPolyline* const polyline = pLevel->polylines[idx];
+        if (!CVSSCRasterizerRenderPolylines(pRasterizer, pBitmap, pTransform, clip, brush, stroke->color, &polyline, 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// renders the drawing from the curves flattened far more finely than the rasterizer flattens them: the reference which
+// both the components' and the level's renderings approximate
+static bool RenderReference(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCToolRecording* const pRecording) {
+    const CVSSCPixelRect clip = CVSSCBitmapGetPixelRect(pBitmap);
+    const double tolerance = ReferenceFlatteningTolerance / CVSSCTransformGetScale(pTransform);
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[idx];
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(stroke->brushType);
+        const CVSSCPolyline* const polyline = CVSSCPolylineCreate(&pRecording->components[stroke->firstComponent], stroke->componentCount, tolerance);
+        const bool rendered = polyline && CVSSCRasterizerRenderPolylines(pRasterizer, pBitmap, pTransform, clip, brush, stroke->color, &polyline, 1);
+        CVSSCPolylineDestroy((CVSSCPolyline*)polyline);
+        if (!rendered) {
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef struct {
+    size_t differingPixelCount;
+    int maximumDifference;
+} Difference;
+
+static Difference Compare(const uint8_t* const pA, const uint8_t* const pB, const size_t pLength) {
+    Difference result = {0, 0};
+    for (size_t idx = 0; idx < pLength; idx += 4) {
+        int difference = 0;
+        for (size_t channel = 0; channel < 4; ++channel) {
+            const int at = abs((int)pA[idx + channel] - (int)pB[idx + channel]);
+            difference = at > difference ? at : difference;
+        }
+        result.differingPixelCount += 0 != difference;
+        result.maximumDifference = difference > result.maximumDifference ? difference : result.maximumDifference;
+    }
+    return result;
+}
+
+// renders the drawing at the scale from the components, from the chosen level and from the reference, and compares them
+static int BenchmarkScale(CVSSCRasterizer* const pRasterizer, const CVSSCToolRecording* const pRecording, const Level* const pLevels, const int pIterations, const uint32_t pWidth, const uint32_t pHeight, const double pScale) {
+    const CVSSCPolylineLevel level = CVSSCPolylineLevelForScale(pScale);
+    if (CVSSCPolylineLevelNone == level) {
+        printf("  scale %6.3f: no level is exact, the curves are rendered\n", pScale);
+        return 0;
+    }
+    const double width = ceil(pWidth * pScale);
+    const double height = ceil(pHeight * pScale);
+    const uint32_t bitmapWidth = (uint32_t)fmin(fmax(width, 1.0), MaximumCanvasSide);
+    const uint32_t bitmapHeight = (uint32_t)fmin(fmax(height, 1.0), MaximumCanvasSide);
+    const size_t pixelsLength = 4 * (size_t)bitmapWidth * bitmapHeight;
+    uint8_t* const componentsPixels = malloc(pixelsLength);
+    uint8_t* const levelPixels = malloc(pixelsLength);
+    uint8_t* const referencePixels = malloc(pixelsLength);
+    int result = componentsPixels && levelPixels && referencePixels ? 0 : 1;
+    const CVSSCTransform transform = CVSSCTransformMake(pScale, 0.0, 0.0, pScale, 0.0, 0.0);
+    const CVSSCBitmap components = CVSSCBitmapMake(componentsPixels, bitmapWidth, bitmapHeight, 4 * (size_t)bitmapWidth);
+    const CVSSCBitmap flattened = CVSSCBitmapMake(levelPixels, bitmapWidth, bitmapHeight, 4 * (size_t)bitmapWidth);
+    const CVSSCBitmap reference = CVSSCBitmapMake(referencePixels, bitmapWidth, bitmapHeight, 4 * (size_t)bitmapWidth);
+    double componentsSeconds = 0.0;
+    double levelSeconds = 0.0;
+    for (int idx = 0; 0 == result && idx < pIterations; ++idx) {
+        CVSSCBitmapClear(&components, CVSSCBitmapGetPixelRect(&components));
+        double start = Now();
+        result = RenderComponents(pRasterizer, &components, &transform, pRecording) ? 0 : 1;
+        componentsSeconds += Now() - start;
+        CVSSCBitmapClear(&flattened, CVSSCBitmapGetPixelRect(&flattened));
+        start = Now();
+        result = 0 == result && RenderLevel(pRasterizer, &flattened, &transform, pRecording, &pLevels[level]) ? 0 : 1;
+        levelSeconds += Now() - start;
+    }
+    if (0 == result) {
+        CVSSCBitmapClear(&reference, CVSSCBitmapGetPixelRect(&reference));
+        result = RenderReference(pRasterizer, &reference, &transform, pRecording) ? 0 : 1;
+    }
+    if (0 != result) {
+        fprintf(stderr, "out of memory\n");
+    }
+    else {
+        const Difference fromComponents = Compare(componentsPixels, levelPixels, pixelsLength);
+        const Difference componentsError = Compare(componentsPixels, referencePixels, pixelsLength);
+        const Difference levelError = Compare(levelPixels, referencePixels, pixelsLength);
+        printf("  scale %6.3f: %ux%u px, level %d (%.4f pt): components %8.3f ms/drawing, level %8.3f ms/drawing %6.2fx, %zu px differ (by at most %d)\n",
+               pScale, bitmapWidth, bitmapHeight, (int)level, CVSSCPolylineLevelGetTolerance(level), 1.0e3 * componentsSeconds / pIterations, 1.0e3 * levelSeconds / pIterations,
+               levelSeconds > 0.0 ? componentsSeconds / levelSeconds : 0.0, fromComponents.differingPixelCount, fromComponents.maximumDifference);
+        printf("                 from the reference: components %zu px (by at most %d), level %zu px (by at most %d)\n",
+               componentsError.differingPixelCount, componentsError.maximumDifference, levelError.differingPixelCount, levelError.maximumDifference);
+        if (MaximumPixelDifference < fromComponents.maximumDifference) {
+            printf("  THE LEVEL DIFFERS FROM THE COMPONENTS BY MORE THAN %d\n", MaximumPixelDifference);
+            result = 1;
+        }
+        if (componentsError.maximumDifference < levelError.maximumDifference) {
+            printf("  THE LEVEL IS FARTHER FROM THE REFERENCE THAN THE COMPONENTS\n");
+            result = 1;
+        }
+    }
+    free(componentsPixels);
+    free(levelPixels);
+    free(referencePixels);
+    return result;
+}
+
+#pragma mark - Benchmark
+
+static const double Scales[] = {0.125, 0.3, 0.5, 1.0, 1.5, 2.0, 3.0, 8.0};
+
+static int Benchmark(const char* const pPath, const int pIterations, const uint32_t pWidth, const uint32_t pHeight) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        fprintf(stderr, "%s: could not be read\n", pPath);
+        return 1;
+    }
+    CVSSCToolRecording recording;
+    memset(&recording, 0, sizeof(recording));
+    recording.skipsUnstrokedStrokes = true;
+    const bool read = CVSSCToolReadRecording(bytes, length, &recording);
+    free(bytes);
+    if (!read) {
+        fprintf(stderr, "%s: malformed playback data\n", pPath);
+        CVSSCToolRecordingFree(&recording);
+        return 1;
+    }
+
+    printf("%s\n", pPath);
+    printf("  strokes: %zu (%zu fills and stamped skipped) components: %zu (%zu bytes) iterations: %d\n", recording.strokeCount, recording.skippedStrokeCount,
+           recording.componentCount, recording.componentCount * sizeof(CVSSCComponent), pIterations);
+    Level levels[CVSSCPolylineLevelCount];
+    memset(levels, 0, sizeof(levels));
+    CVSSCRasterizer* const rasterizer = CVSSCRasterizerCreate();
+    int result = rasterizer ? 0 : 1;
+    for (CVSSCPolylineLevel level = 0; 0 == result && level < CVSSCPolylineLevelCount; ++level) {
+        if (!MakeLevel(&recording, level, pIterations, &levels[level])) {
+            result = 1;
+            break;
+        }
+        printf("  level %d (%.4f pt): %8zu points %9zu bytes (%5.1f%% of the components) %8.3f ms to flatten\n", (int)level, CVSSCPolylineLevelGetTolerance(level),
+               levels[level].pointCount, levels[level].byteCount, recording.componentCount ? 100.0 * levels[level].byteCount / (recording.componentCount * sizeof(CVSSCComponent)) : 0.0,
+               1.0e3 * levels[level].seconds);
+    }
+    if (0 != result) {
+        fprintf(stderr, "out of memory\n");
+    }
+    for (size_t idx = 0; 0 == result && idx < sizeof(Scales) / sizeof(Scales[0]); ++idx) {
+        result = BenchmarkScale(rasterizer, &recording, levels, pIterations, pWidth, pHeight, Scales[idx]);
+    }
+
+    for (CVSSCPolylineLevel level = 0; level < CVSSCPolylineLevelCount; ++level) {
+        LevelDestroyPolylines(&levels[level], recording.strokeCount);
+    }
+    CVSSCRasterizerDestroy(rasterizer);
+    CVSSCToolRecordingFree(&recording);
+    return result;
+}
+
+#pragma mark - Main
+
+static int Usage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-i iterations] [-w width] [-h height] playback...\n", pName);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 3;
+    uint32_t width = 768;
+    uint32_t height = 1024;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-i") && idx + 1 < argc) {
+            iterations = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        }
+        else {
+            return Usage(argv[0]);
+        }
+    }
+    if (idx == argc || 0 >= iterations || 0 == width || 0 == height) {
+        return Usage(argv[0]);
+    }
+    int result = 0;
+    for (; idx < argc; ++idx) {
+        result |= Benchmark(argv[idx], iterations, width, height);
+    }
+    return result;
+}
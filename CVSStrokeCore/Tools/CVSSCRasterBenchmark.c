@@ -0,0 +1,391 @@
+// CVSSCRasterBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// renders recorded playback JSON with the software rasterizer (CVSSCRaster), reports throughput, and compares
+// renderings -- against the golden images of the CoreGraphics renderer in CVSStrokeCore/Goldens, or any two images.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCRasterBenchmark.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCRasterBenchmark
+//
+// usage:
+//   CVSSCRasterBenchmark [-i iterations] [-w width] [-h height] [-s scale] [-o out.pam] playback.json
+//   CVSSCRasterBenchmark -compare [-t tolerance] [-p percent] a.pam b.pam
+//   CVSSCRasterBenchmark -golden CVSStrokeCore/Goldens/Goldens.txt
+//
+// render: draws every stroke of the file into a width x height (points) canvas at scale pixels per point, as
+//   CVSStrokeRenderer draws with RenderOption_UseSoftwareRasterizer. -o writes the last iteration as a PAM
+//   (netpbm RGB_ALPHA, premultiplied) which may be converted with any netpbm/ImageMagick install.
+// compare: exits 0 if the images are the same size and at most percent% of their pixels differ by more than
+//   tolerance in any channel. prints the max difference and the differing fraction either way.
+// golden: renders each drawing of the manifest as its line specifies and compares it to the line's golden image (the
+//   CG rendering, captured with CVSSCRenderGoldens) with the line's tolerance. the rendering is written to PNG and read
+//   back first, so that both images are quantized alike. exits 1 if any rendering does not match, or a golden is missing.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+#pragma mark - PAM
+
+static bool WritePAM(const char* const pPath, const CVSSCBitmap* const pBitmap) {
+    FILE* const file = fopen(pPath, "wb");
+    if (NULL == file) {
+        return false;
+    }
+    fprintf(file, "P7\nWIDTH %u\nHEIGHT %u\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", pBitmap->width, pBitmap->height);
+    bool result = true;
+    for (uint32_t y = 0; result && y < pBitmap->height; ++y) {
+        result = pBitmap->width == fwrite(CVSSCBitmapGetPixel(pBitmap, 0, y), 4, pBitmap->width, file);
+    }
+    return 0 == fclose(file) && result;
+}
+
+// reads a PAM with DEPTH 4 and MAXVAL 255. the pixels are malloc'd.
+static bool ReadPAM(const char* const pPath, CVSSCBitmap* const pOutBitmap) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        return false;
+    }
+    unsigned width = 0, height = 0, depth = 0, maxval = 0;
+    const char* const end = strstr(bytes, "ENDHDR\n");
+    bool result = 0 == strncmp(bytes, "P7\n", 3) && NULL != end;
+    if (result) {
+        const char* at = strstr(bytes, "WIDTH ");
+        result = at && 1 == sscanf(at, "WIDTH %u", &width);
+        at = strstr(bytes, "HEIGHT ");
+        result = result && at && 1 == sscanf(at, "HEIGHT %u", &height);
+        at = strstr(bytes, "DEPTH ");
+        result = result && at && 1 == sscanf(at, "DEPTH %u", &depth);
+        at = strstr(bytes, "MAXVAL ");
+        result = result && at && 1 == sscanf(at, "MAXVAL %u", &maxval);
+    }
+    const size_t headerLength = result ? (size_t)(end - bytes) + strlen("ENDHDR\n") : 0;
+    result = result && 4 == depth && 255 == maxval && length - headerLength == 4 * (size_t)width * height;
+    if (result) {
+        uint8_t* const pixels = malloc(4 * (size_t)width * height + 1);
+        result = NULL != pixels;
+        if (result) {
+            memcpy(pixels, bytes + headerLength, 4 * (size_t)width * height);
+            *pOutBitmap = CVSSCBitmapMake(pixels, width, height, 4 * (size_t)width);
+        }
+    }
+    free(bytes);
+    return result;
+}
+
+// the largest difference of any channel of any pixel, and the percentage of pixels which differ by more than pTolerance.
+// the bitmaps are the same size.
+static void CompareBitmaps(const CVSSCBitmap* const pA, const CVSSCBitmap* const pB, const int pTolerance, int* const pOutMaximumDifference, double* const pOutPercent) {
+    int maximumDifference = 0;
+    size_t differing = 0;
+    for (uint32_t y = 0; y < pA->height; ++y) {
+        const uint8_t* const rowA = CVSSCBitmapGetPixel(pA, 0, y);
+        const uint8_t* const rowB = CVSSCBitmapGetPixel(pB, 0, y);
+        for (uint32_t x = 0; x < pA->width; ++x) {
+            int pixelDifference = 0;
+            for (int channel = 0; channel < 4; ++channel) {
+                const int difference = abs((int)rowA[4 * x + channel] - (int)rowB[4 * x + channel]);
+                pixelDifference = difference > pixelDifference ? difference : pixelDifference;
+            }
+            maximumDifference = pixelDifference > maximumDifference ? pixelDifference : maximumDifference;
+            differing += pixelDifference > pTolerance;
+        }
+    }
+    *pOutMaximumDifference = maximumDifference;
+    *pOutPercent = 100.0 * (double)differing / ((double)pA->width * pA->height);
+}
+
+static int Compare(const char* const pPathA, const char* const pPathB, const int pTolerance, const double pPercent) {
+    CVSSCBitmap a, b;
+    if (!ReadPAM(pPathA, &a)) {
+        fprintf(stderr, "%s: could not be read as a 4 channel PAM\n", pPathA);
+        return 2;
+    }
+    if (!ReadPAM(pPathB, &b)) {
+        fprintf(stderr, "%s: could not be read as a 4 channel PAM\n", pPathB);
+        free(a.pixels);
+        return 2;
+    }
+    if (a.width != b.width || a.height != b.height) {
+        printf("size mismatch: %ux%u vs %ux%u\n", a.width, a.height, b.width, b.height);
+        free(a.pixels);
+        free(b.pixels);
+        return 1;
+    }
+    int maximumDifference = 0;
+    double percent = 0.0;
+    CompareBitmaps(&a, &b, pTolerance, &maximumDifference, &percent);
+    printf("max difference: %d, pixels differing by more than %d: %.4f%%\n", maximumDifference, pTolerance, percent);
+    free(a.pixels);
+    free(b.pixels);
+    return percent <= pPercent ? 0 : 1;
+}
+
+#pragma mark - Rendering
+
+static bool RenderRecording(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCToolRecording* const pRecording) {
+    const CVSSCPixelRect clip = CVSSCBitmapGetPixelRect(pBitmap);
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[idx];
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(stroke->brushType);
+        if (!CVSSCRasterizerRenderStroke(pRasterizer, pBitmap, pTransform, clip, brush, stroke->color, &pRecording->components[stroke->firstComponent], stroke->componentCount)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool ReadRecordingFile(const char* const pPath, CVSSCToolRecording* const pRecording) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        fprintf(stderr, "%s: could not be read\n", pPath);
+        return false;
+    }
+    const bool result = CVSSCToolReadRecording(bytes, length, pRecording);
+    free(bytes);
+    if (!result) {
+        fprintf(stderr, "%s: malformed playback data\n", pPath);
+    }
+    return result;
+}
+
+static int Render(const char* const pPath, const int pIterations, const uint32_t pWidth, const uint32_t pHeight, const double pScale, const char* const pOutPath) {
+    CVSSCToolRecording recording;
+    memset(&recording, 0, sizeof(recording));
+    if (!ReadRecordingFile(pPath, &recording)) {
+        CVSSCToolRecordingFree(&recording);
+        return 1;
+    }
+
+    const uint32_t width = (uint32_t)(pWidth * pScale + 0.5);
+    const uint32_t height = (uint32_t)(pHeight * pScale + 0.5);
+    uint8_t* const pixels = malloc(4 * (size_t)width * height);
+    CVSSCRasterizer* const rasterizer = CVSSCRasterizerCreate();
+    int result = 0;
+    if (NULL == pixels || NULL == rasterizer) {
+        fprintf(stderr, "out of memory\n");
+        result = 1;
+    }
+    if (0 == result) {
+        // the canvas is in points with its origin at the top left, as the playback view's is
+        const CVSSCBitmap bitmap = CVSSCBitmapMake(pixels, width, height, 4 * (size_t)width);
+        const CVSSCTransform transform = CVSSCTransformMake(pScale, 0.0, 0.0, pScale, 0.0, 0.0);
+        double seconds = 0.0;
+        for (int idx = 0; 0 == result && idx < pIterations; ++idx) {
+            CVSSCBitmapClear(&bitmap, CVSSCBitmapGetPixelRect(&bitmap));
+            const double start = Now();
+            if (!RenderRecording(rasterizer, &bitmap, &transform, &recording)) {
+                fprintf(stderr, "out of memory\n");
+                result = 1;
+            }
+            seconds += Now() - start;
+        }
+        if (0 == result) {
+            const double strokes = (double)recording.strokeCount * pIterations;
+            const double components = (double)recording.componentCount * pIterations;
+            printf("%s\n", pPath);
+            printf("  strokes: %zu components: %zu canvas: %ux%u px iterations: %d spans: %s\n", recording.strokeCount, recording.componentCount, width, height, pIterations, CVSSCSpanImplementationName());
+            printf("  render: %10.0f strokes/sec %12.0f components/sec %8.3f ms/drawing\n", strokes / seconds, components / seconds, 1.0e3 * seconds / pIterations);
+        }
+        if (0 == result && pOutPath && !WritePAM(pOutPath, &bitmap)) {
+            fprintf(stderr, "%s: could not be written\n", pOutPath);
+            result = 1;
+        }
+    }
+    CVSSCRasterizerDestroy(rasterizer);
+    free(pixels);
+    CVSSCToolRecordingFree(&recording);
+    return result;
+}
+
+#pragma mark - Goldens
+
+typedef struct {
+    uint8_t* bytes;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+static bool WriteToBuffer(void* const pContext, const void* const pBytes, const size_t pLength) {
+    Buffer* const buffer = pContext;
+    if (buffer->length + pLength > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 1 << 16;
+        while (buffer->length + pLength > capacity) {
+            capacity *= 2;
+        }
+        uint8_t* const grown = realloc(buffer->bytes, capacity);
+        if (NULL == grown) {
+            return false;
+        }
+        buffer->bytes = grown;
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->bytes + buffer->length, pBytes, pLength);
+    buffer->length += pLength;
+    return true;
+}
+
+// the bitmap as it is read back from a PNG: a golden is unpremultiplied when it is written, and premultiplied again when it
+// is read. the pixels are allocated with CVSSCAllocate.
+static bool RoundTripPNG(const CVSSCBitmap* const pBitmap, CVSSCBitmap* const pOutBitmap) {
+    Buffer buffer = {NULL, 0, 0};
+    const CVSSCPlaybackOutput output = {&buffer, WriteToBuffer};
+    const bool result = CVSSCPNGWrite(pBitmap, 1, &output) && CVSSCPNGRead(buffer.bytes, buffer.length, pOutBitmap);
+    free(buffer.bytes);
+    return result;
+}
+
+// renders the golden's drawing and compares it to the golden. returns 0 if it matches, 1 if it does not, 2 on failure.
+static int CompareGolden(const char* const pManifestPath, const CVSSCToolGolden* const pGolden, CVSSCRasterizer* const pRasterizer) {
+    char drawingPath[1024];
+    char goldenPath[1024];
+    if (!CVSSCToolGetGoldenPath(pManifestPath, pGolden->drawing, ".json", drawingPath, sizeof(drawingPath))
+        || !CVSSCToolGetGoldenPath(pManifestPath, pGolden->name, ".png", goldenPath, sizeof(goldenPath))) {
+        fprintf(stderr, "%s: path too long\n", pGolden->name);
+        return 2;
+    }
+    CVSSCBitmap golden;
+    if (!CVSSCToolReadPNG(goldenPath, &golden)) {
+        printf("%-16s missing: capture %s with CVSSCRenderGoldens\n", pGolden->name, goldenPath);
+        return 1;
+    }
+    // the goldens are of CG's stroking: the stamped brushes and fills are not rendered by it
+    CVSSCToolRecording recording;
+    memset(&recording, 0, sizeof(recording));
+    recording.skipsUnstrokedStrokes = true;
+    const uint32_t width = (uint32_t)(pGolden->width * pGolden->scale + 0.5);
+    const uint32_t height = (uint32_t)(pGolden->height * pGolden->scale + 0.5);
+    uint8_t* const pixels = calloc(4 * (size_t)width, height);
+    CVSSCBitmap rendering;
+    memset(&rendering, 0, sizeof(rendering));
+    bool rendered = false;
+    if (NULL != pixels && ReadRecordingFile(drawingPath, &recording)) {
+        // the canvas is cleared: the cache bitmap is transparent, and the template is composited under it
+        const CVSSCBitmap bitmap = CVSSCBitmapMake(pixels, width, height, 4 * (size_t)width);
+        const CVSSCTransform transform = CVSSCTransformMake(pGolden->scale, 0.0, 0.0, pGolden->scale, 0.0, 0.0);
+        rendered = RenderRecording(pRasterizer, &bitmap, &transform, &recording) && RoundTripPNG(&bitmap, &rendering);
+    }
+    int result = 2;
+    if (!rendered) {
+        fprintf(stderr, "%s: could not be rendered\n", pGolden->name);
+    }
+    else if (golden.width != rendering.width || golden.height != rendering.height) {
+        printf("%-16s size mismatch: %ux%u vs %ux%u\n", pGolden->name, golden.width, golden.height, rendering.width, rendering.height);
+        result = 1;
+    }
+    else {
+        int maximumDifference = 0;
+        double percent = 0.0;
+        CompareBitmaps(&golden, &rendering, pGolden->tolerance, &maximumDifference, &percent);
+        result = percent <= pGolden->percent ? 0 : 1;
+        printf("%-16s max difference: %3d, pixels differing by more than %d: %.4f%% (limit %.4f%%) %s\n", pGolden->name, maximumDifference,
+               pGolden->tolerance, percent, pGolden->percent, 0 == result ? "ok" : "FAILED");
+    }
+    CVSSCFree(rendering.pixels);
+    CVSSCFree(golden.pixels);
+    free(pixels);
+    CVSSCToolRecordingFree(&recording);
+    return result;
+}
+
+static int CompareGoldens(const char* const pManifestPath) {
+    enum { MaximumGoldenCount = 64 };
+    CVSSCToolGolden goldens[MaximumGoldenCount];
+    const size_t count = CVSSCToolReadGoldens(pManifestPath, goldens, MaximumGoldenCount);
+    if (0 == count) {
+        fprintf(stderr, "%s: could not be read as a golden manifest\n", pManifestPath);
+        return 2;
+    }
+    CVSSCRasterizer* const rasterizer = CVSSCRasterizerCreate();
+    if (NULL == rasterizer) {
+        fprintf(stderr, "out of memory\n");
+        return 2;
+    }
+    int result = 0;
+    for (size_t idx = 0; idx < count; ++idx) {
+        const int status = CompareGolden(pManifestPath, &goldens[idx], rasterizer);
+        result = status > result ? status : result;
+    }
+    CVSSCRasterizerDestroy(rasterizer);
+    return result;
+}
+
+#pragma mark - Main
+
+static int Usage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-i iterations] [-w width] [-h height] [-s scale] [-o out.pam] playback.json\n", pName);
+    fprintf(stderr, "       %s -compare [-t tolerance] [-p percent] a.pam b.pam\n", pName);
+    fprintf(stderr, "       %s -golden Goldens.txt\n", pName);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10;
+    uint32_t width = 768;
+    uint32_t height = 1024;
+    double scale = 1.0;
+    const char* outPath = NULL;
+    bool compare = false;
+    const char* manifestPath = NULL;
+    int tolerance = 8;
+    double percent = 0.5;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-compare")) {
+            compare = true;
+        }
+        else if (0 == strcmp(argv[idx], "-golden") && idx + 1 < argc) {
+            manifestPath = argv[++idx];
+        }
+        else if (0 == strcmp(argv[idx], "-i") && idx + 1 < argc) {
+            iterations = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            scale = atof(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-o") && idx + 1 < argc) {
+            outPath = argv[++idx];
+        }
+        else if (0 == strcmp(argv[idx], "-t") && idx + 1 < argc) {
+            tolerance = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-p") && idx + 1 < argc) {
+            percent = atof(argv[++idx]);
+        }
+        else {
+            return Usage(argv[0]);
+        }
+    }
+    if (manifestPath) {
+        return idx == argc ? CompareGoldens(manifestPath) : Usage(argv[0]);
+    }
+    if (compare) {
+        return idx + 2 == argc ? Compare(argv[idx], argv[idx + 1], tolerance, percent) : Usage(argv[0]);
+    }
+    if (idx + 1 != argc || 0 >= iterations || 0 == width || 0 == height || !(scale > 0.0)) {
+        return Usage(argv[0]);
+    }
+    return Render(argv[idx], iterations, width, height, scale, outPath);
+}
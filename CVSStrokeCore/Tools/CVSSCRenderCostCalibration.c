@@ -0,0 +1,390 @@
+// CVSSCRenderCostCalibration.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// fits the render cost model (CVSSCRenderCost) to the measured render times of the strokes of a corpus of drawings, and
+// reports how well it predicts them -- and how well the component count (the editor's estimate) predicted them.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCRenderCostCalibration.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCRenderCostCalibration
+//
+// usage:
+//   CVSSCRenderCostCalibration [-s scale] [-w width] [-h height] [-r repeats] [-p percent] input [input ...]
+//
+// each input is a playback file (JSON or binary -- the format is detected) or a directory, whose *.json and *.cvsp files are
+// read in name order. every stroke is rendered with the software rasterizer into a width x height (points) canvas at scale
+// pixels per point (default 768x1024 at 2), repeats times (default 5), and its fastest time is its sample. the model is fitted
+// to the even samples and measured on the odd ones, then fitted to all of them and printed as the initializer of
+// CVSSCRenderCostDefaultModel. exits 1 if the median relative error of the held out estimates exceeds percent% (default 25).
+
+#define _XOPEN_SOURCE 700
+
+#include <dirent.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static bool IsDirectory(const char* const pPath) {
+    struct stat info;
+    return 0 == stat(pPath, &info) && S_ISDIR(info.st_mode);
+}
+
+static bool HasSuffix(const char* const pString, const char* const pSuffix) {
+    const size_t length = strlen(pString);
+    const size_t suffixLength = strlen(pSuffix);
+    return length > suffixLength && 0 == strcmp(pString + length - suffixLength, pSuffix);
+}
+
+static int CompareDoubles(const void* const pA, const void* const pB) {
+    const double a = *(const double*)pA;
+    const double b = *(const double*)pB;
+    return a < b ? -1 : (a > b ? 1 : 0);
+}
+
+#pragma mark - Inputs
+
+typedef struct {
+    char** paths;
+    size_t count;
+    size_t capacity;
+} PathList;
+
+static bool PathListAppend(PathList* const pList, const char* const pPath) {
+    if (pList->count == pList->capacity) {
+        const size_t capacity = pList->capacity ? 2 * pList->capacity : 64;
+        char** const grown = realloc(pList->paths, capacity * sizeof(char*));
+        if (NULL == grown) {
+            return false;
+        }
+        pList->paths = grown;
+        pList->capacity = capacity;
+    }
+    char* const copy = malloc(strlen(pPath) + 1);
+    if (NULL == copy) {
+        return false;
+    }
+    strcpy(copy, pPath);
+    pList->paths[pList->count++] = copy;
+    return true;
+}
+
+static int ComparePaths(const void* const pA, const void* const pB) {
+    return strcmp(*(char* const*)pA, *(char* const*)pB);
+}
+
+// appends the playback files of the directory, in name order
+static bool PathListAppendDirectory(PathList* const pList, const char* const pDirectory) {
+    DIR* const directory = opendir(pDirectory);
+    if (NULL == directory) {
+        return false;
+    }
+    const size_t first = pList->count;
+    bool result = true;
+    for (struct dirent* entry = readdir(directory); result && entry; entry = readdir(directory)) {
+        const char* const name = entry->d_name;
+        if ('.' == name[0] || !(HasSuffix(name, ".json") || HasSuffix(name, ".cvsp"))) {
+            continue;
+        }
+        char* const path = malloc(strlen(pDirectory) + strlen(name) + 2);
+        result = NULL != path;
+        if (result) {
+            sprintf(path, "%s/%s", pDirectory, name);
+            result = PathListAppend(pList, path);
+            free(path);
+        }
+    }
+    closedir(directory);
+    qsort(&pList->paths[first], pList->count - first, sizeof(char*), ComparePaths);
+    return result;
+}
+
+static void PathListDestroy(PathList* const pList) {
+    for (size_t idx = 0; idx < pList->count; ++idx) {
+        free(pList->paths[idx]);
+    }
+    free(pList->paths);
+}
+
+#pragma mark - Samples
+
+typedef struct {
+    double scale;
+    int repeats;
+    CVSSCRasterizer* rasterizer;
+    CVSSCBitmap canvas;
+    CVSSCTransform transform;
+    // the canvas, in points
+    CVSSCRect clip;
+    // the samples, and the component count of each (for the editor's estimate)
+    CVSSCRenderCostSample* samples;
+    double* componentCounts;
+    size_t count;
+    size_t capacity;
+    bool failed;
+} Calibration;
+
+static bool CalibrationReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    Calibration* const calibration = pContext;
+    if (!pStroke->componentCount || CVSSCBrushTypePen > pStroke->brushType || CVSSCBrushTypePaintbucket < pStroke->brushType) {
+        // as CVSPlaybackStrokes, strokes which cannot be rendered are skipped
+        return true;
+    }
+    if (calibration->count == calibration->capacity) {
+        const size_t capacity = calibration->capacity ? 2 * calibration->capacity : 1024;
+        CVSSCRenderCostSample* const samples = realloc(calibration->samples, capacity * sizeof(CVSSCRenderCostSample));
+        if (samples) {
+            calibration->samples = samples;
+        }
+        double* const componentCounts = realloc(calibration->componentCounts, capacity * sizeof(double));
+        if (componentCounts) {
+            calibration->componentCounts = componentCounts;
+        }
+        if (!samples || !componentCounts) {
+            calibration->failed = true;
+            return false;
+        }
+        calibration->capacity = capacity;
+    }
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(pStroke->brushType);
+    // opaque, as the playback view draws
+    const CVSSCColor color = {pStroke->color.red, pStroke->color.green, pStroke->color.blue, 1.0};
+    double fastest = INFINITY;
+    for (int repeat = 0; repeat < calibration->repeats; ++repeat) {
+        const double start = Now();
+        if (!CVSSCRasterizerRenderStroke(calibration->rasterizer, &calibration->canvas, &calibration->transform, CVSSCBitmapGetPixelRect(&calibration->canvas), brush, color, pStroke->components, pStroke->componentCount)) {
+            calibration->failed = true;
+            return false;
+        }
+        const double seconds = Now() - start;
+        fastest = seconds < fastest ? seconds : fastest;
+    }
+    CVSSCRenderCostSample* const sample = &calibration->samples[calibration->count];
+    sample->features = CVSSCRenderCostGetFeatures(brush, pStroke->components, pStroke->componentCount, calibration->scale, calibration->clip);
+    sample->seconds = fastest;
+    calibration->componentCounts[calibration->count] = (double)pStroke->componentCount;
+    ++calibration->count;
+    return true;
+}
+
+static bool ReadDrawing(Calibration* const pCalibration, const char* const pBytes, const size_t pLength) {
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {pCalibration, NULL, CalibrationReadStroke};
+    if (CVSSCPlaybackBinaryHasSignature(pBytes, pLength)) {
+        CVSSCPlaybackBinaryReader* const reader = CVSSCPlaybackBinaryReaderCreate(&callbacks);
+        const bool result = reader && CVSSCPlaybackBinaryReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackBinaryReaderFinish(reader);
+        CVSSCPlaybackBinaryReaderDestroy(reader);
+        return result;
+    }
+    CVSSCPlaybackJSONReader* const reader = CVSSCPlaybackJSONReaderCreate(&callbacks);
+    const bool result = reader && CVSSCPlaybackJSONReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackJSONReaderFinish(reader);
+    CVSSCPlaybackJSONReaderDestroy(reader);
+    return result;
+}
+
+#pragma mark - Errors
+
+typedef struct {
+    double median;
+    double p90;
+    // the estimated and measured times of all of the samples
+    double estimatedSeconds;
+    double measuredSeconds;
+} Errors;
+
+// the relative errors of the estimates of every pStride'th sample from pFirst. pEstimates are parallel to the samples.
+static Errors GetErrors(const Calibration* const pCalibration, const double* const pEstimates, const size_t pFirst, const size_t pStride, double* const pScratch) {
+    Errors result = {0.0, 0.0, 0.0, 0.0};
+    size_t count = 0;
+    for (size_t idx = pFirst; idx < pCalibration->count; idx += pStride) {
+        const double seconds = pCalibration->samples[idx].seconds;
+        pScratch[count++] = fabs(pEstimates[idx] - seconds) / seconds;
+        result.estimatedSeconds += pEstimates[idx];
+        result.measuredSeconds += seconds;
+    }
+    if (count) {
+        qsort(pScratch, count, sizeof(double), CompareDoubles);
+        result.median = pScratch[count / 2];
+        result.p90 = pScratch[(count * 9) / 10];
+    }
+    return result;
+}
+
+// the editor's estimate: a cost per component, fitted (minimizing the squared relative error) to every pStride'th sample from pFirst
+static double FitPerComponent(const Calibration* const pCalibration, const size_t pFirst, const size_t pStride) {
+    double numerator = 0.0, denominator = 0.0;
+    for (size_t idx = pFirst; idx < pCalibration->count; idx += pStride) {
+        const double ratio = pCalibration->componentCounts[idx] / pCalibration->samples[idx].seconds;
+        numerator += ratio;
+        denominator += ratio * ratio;
+    }
+    return denominator > 0.0 ? numerator / denominator : 0.0;
+}
+
+// fits to every pStride'th sample from pFirst, into a scratch copy of the samples
+static bool FitModel(const Calibration* const pCalibration, const size_t pFirst, const size_t pStride, CVSSCRenderCostSample* const pScratch, CVSSCRenderCostModel* const pOutModel) {
+    size_t count = 0;
+    for (size_t idx = pFirst; idx < pCalibration->count; idx += pStride) {
+        pScratch[count++] = pCalibration->samples[idx];
+    }
+    return CVSSCRenderCostModelFit(pScratch, count, pOutModel);
+}
+
+static void PrintErrors(const char* const pName, const Errors pErrors) {
+    printf("  %-28s %9.1f%% %9.1f%% %13.1f %13.1f\n", pName, 100.0 * pErrors.median, 100.0 * pErrors.p90, 1.0e3 * pErrors.estimatedSeconds, 1.0e3 * pErrors.measuredSeconds);
+}
+
+#pragma mark - Main
+
+static int Usage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-s scale] [-w width] [-h height] [-r repeats] [-p percent] input [input ...]\n", pName);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    double scale = 2.0;
+    uint32_t width = 768;
+    uint32_t height = 1024;
+    int repeats = 5;
+    double percent = 25.0;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            scale = atof(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-r") && idx + 1 < argc) {
+            repeats = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-p") && idx + 1 < argc) {
+            percent = atof(argv[++idx]);
+        }
+        else {
+            return Usage(argv[0]);
+        }
+    }
+    if (idx == argc || !(scale > 0.0) || 0 == width || 0 == height || 0 >= repeats) {
+        return Usage(argv[0]);
+    }
+    PathList inputs = {NULL, 0, 0};
+    for (; idx < argc; ++idx) {
+        const bool appended = IsDirectory(argv[idx]) ? PathListAppendDirectory(&inputs, argv[idx]) : PathListAppend(&inputs, argv[idx]);
+        if (!appended) {
+            fprintf(stderr, "%s: could not be read\n", argv[idx]);
+            PathListDestroy(&inputs);
+            return 1;
+        }
+    }
+
+    const uint32_t pixelWidth = (uint32_t)(width * scale + 0.5);
+    const uint32_t pixelHeight = (uint32_t)(height * scale + 0.5);
+    Calibration calibration;
+    memset(&calibration, 0, sizeof(calibration));
+    calibration.scale = scale;
+    calibration.repeats = repeats;
+    calibration.transform = CVSSCTransformMake(scale, 0.0, 0.0, scale, 0.0, 0.0);
+    calibration.clip = CVSSCRectMake(0.0, 0.0, width, height);
+    calibration.rasterizer = CVSSCRasterizerCreate();
+    uint8_t* const pixels = calloc(4 * (size_t)pixelWidth * pixelHeight, 1);
+    int result = calibration.rasterizer && pixels ? 0 : 1;
+    if (0 != result) {
+        fprintf(stderr, "out of memory\n");
+    }
+    calibration.canvas = CVSSCBitmapMake(pixels, pixelWidth, pixelHeight, 4 * (size_t)pixelWidth);
+
+    size_t failedCount = 0;
+    for (size_t input = 0; 0 == result && input < inputs.count; ++input) {
+        const char* const path = inputs.paths[input];
+        size_t length = 0;
+        char* const bytes = CVSSCToolReadFile(path, &length);
+        if (NULL == bytes) {
+            fprintf(stderr, "%s: could not be read\n", path);
+            ++failedCount;
+            continue;
+        }
+        const bool read = ReadDrawing(&calibration, bytes, length);
+        free(bytes);
+        if (calibration.failed) {
+            fprintf(stderr, "out of memory\n");
+            result = 1;
+            break;
+        }
+        if (!read) {
+            fprintf(stderr, "%s: malformed playback data\n", path);
+            ++failedCount;
+        }
+    }
+
+    CVSSCRenderCostSample* const scratchSamples = 0 == result ? malloc((calibration.count + 1) * sizeof(CVSSCRenderCostSample)) : NULL;
+    double* const estimates = 0 == result ? malloc((calibration.count + 1) * sizeof(double)) : NULL;
+    double* const scratch = 0 == result ? malloc((calibration.count + 1) * sizeof(double)) : NULL;
+    if (0 == result && (!scratchSamples || !estimates || !scratch)) {
+        fprintf(stderr, "out of memory\n");
+        result = 1;
+    }
+    CVSSCRenderCostModel heldOut, fitted;
+    if (0 == result && !(FitModel(&calibration, 0, 2, scratchSamples, &heldOut) && FitModel(&calibration, 0, 1, scratchSamples, &fitted))) {
+        fprintf(stderr, "%zu samples do not determine a model\n", calibration.count);
+        result = 1;
+    }
+    if (0 == result) {
+        size_t blendCounts[CVSSCRenderCostBlendCount] = {0};
+        for (size_t sample = 0; sample < calibration.count; ++sample) {
+            ++blendCounts[calibration.samples[sample].features.blend];
+        }
+        printf("samples: %zu strokes (%zu opaque, %zu translucent, %zu clear) of %zu inputs, %ux%u px, fastest of %d renders, spans: %s\n", calibration.count,
+               blendCounts[CVSSCRenderCostBlendOpaque], blendCounts[CVSSCRenderCostBlendTranslucent], blendCounts[CVSSCRenderCostBlendClear],
+               inputs.count - failedCount, pixelWidth, pixelHeight, repeats, CVSSCSpanImplementationName());
+        printf("  %-28s %10s %10s %13s %13s\n", "held out (odd strokes)", "median err", "p90 err", "estimated ms", "measured ms");
+        const double perComponent = FitPerComponent(&calibration, 0, 2);
+        for (size_t sample = 0; sample < calibration.count; ++sample) {
+            estimates[sample] = perComponent * calibration.componentCounts[sample];
+        }
+        PrintErrors("per component", GetErrors(&calibration, estimates, 1, 2, scratch));
+        for (size_t sample = 0; sample < calibration.count; ++sample) {
+            estimates[sample] = CVSSCRenderCostEstimate(&CVSSCRenderCostDefaultModel, &calibration.samples[sample].features);
+        }
+        PrintErrors("CVSSCRenderCostDefaultModel", GetErrors(&calibration, estimates, 1, 2, scratch));
+        for (size_t sample = 0; sample < calibration.count; ++sample) {
+            estimates[sample] = CVSSCRenderCostEstimate(&heldOut, &calibration.samples[sample].features);
+        }
+        const Errors heldOutErrors = GetErrors(&calibration, estimates, 1, 2, scratch);
+        PrintErrors("fitted to even strokes", heldOutErrors);
+
+        printf("fitted to all strokes (scale %.2f):\n", scale);
+        printf("const CVSSCRenderCostModel CVSSCRenderCostDefaultModel = {\n");
+        printf("    .perStroke = %.4e,\n", fitted.perStroke);
+        printf("    .perSegment = %.4e,\n", fitted.perSegment);
+        printf("    .perRow = %.4e,\n", fitted.perRow);
+        printf("    .perSweptPixel = %.4e,\n", fitted.perSweptPixel);
+        printf("    .perBoundsPixel = {%.4e, %.4e, %.4e}\n", fitted.perBoundsPixel[CVSSCRenderCostBlendOpaque], fitted.perBoundsPixel[CVSSCRenderCostBlendTranslucent], fitted.perBoundsPixel[CVSSCRenderCostBlendClear]);
+        printf("};\n");
+        printf("held out median error %.1f%% (limit %.1f%%)\n", 100.0 * heldOutErrors.median, percent);
+        result = failedCount || 100.0 * heldOutErrors.median > percent ? 1 : 0;
+    }
+    CVSSCRasterizerDestroy(calibration.rasterizer);
+    free(calibration.samples);
+    free(calibration.componentCounts);
+    free(scratchSamples);
+    free(estimates);
+    free(scratch);
+    free(pixels);
+    PathListDestroy(&inputs);
+    return result;
+}
@@ -0,0 +1,154 @@
+// CVSSCRenderGoldens.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// captures the golden images of the software rasterizer: renders each drawing of the golden manifest
+// (CVSStrokeCore/Goldens/Goldens.txt) with CoreGraphics, configured as CVSStrokeRenderer configures the cache bitmap's context
+// (CVSDMMutableBitmap: 8bpc RGBA premultiplied last, device RGB), and writes <name>.png beside the manifest. compare the
+// rasterizer against them with CVSSCRasterBenchmark -golden. rerun it when CVSStrokeRenderer's CG configuration changes.
+//
+// build (macOS, from the repository root; CoreGraphics renders as it does on iOS):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCRenderGoldens.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -framework CoreGraphics -o CVSSCRenderGoldens
+//
+// usage:
+//   CVSSCRenderGoldens CVSStrokeCore/Goldens/Goldens.txt
+//
+// the strokes are rendered one path per stroke (CGContextStrokePath), in order, with the renderer's antialiasing, flatness,
+// line width, caps, joins, brush alpha and blend mode (clear for the eraser). the stamped brushes and fills, which CG does
+// not stroke, are skipped. exits 1 if any golden could not be written.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CoreGraphics/CoreGraphics.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Rendering
+
+static void PathMoveToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    CGContextMoveToPoint((CGContextRef)pContext, (CGFloat)pPoint.x, (CGFloat)pPoint.y);
+}
+
+static void PathAddLineToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    CGContextAddLineToPoint((CGContextRef)pContext, (CGFloat)pPoint.x, (CGFloat)pPoint.y);
+}
+
+static void PathAddCurveToPoint(void* const pContext, const CVSSCPoint pControlPoint1, const CVSSCPoint pControlPoint2, const CVSSCPoint pPoint) {
+    CGContextAddCurveToPoint((CGContextRef)pContext,
+                             (CGFloat)pControlPoint1.x, (CGFloat)pControlPoint1.y,
+                             (CGFloat)pControlPoint2.x, (CGFloat)pControlPoint2.y,
+                             (CGFloat)pPoint.x, (CGFloat)pPoint.y);
+}
+
+// as CVSStrokeRenderer's ConfigAntialiasing, ConfigFlatnessAndMiterLimit and ConfigBrushAttributes, and the stroke color of
+// CVSStrokeRendererContextWillRenderStroke
+static void RenderStroke(CGContextRef const pContext, const CVSSCToolRecording* const pRecording, const CVSSCToolRecordedStroke* const pStroke) {
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(pStroke->brushType);
+    CGContextSetAllowsAntialiasing(pContext, true);
+    CGContextSetShouldAntialias(pContext, true);
+    CGContextSetFlatness(pContext, 1.0);
+    CGContextSetLineJoin(pContext, kCGLineJoinRound);
+    CGContextSetLineCap(pContext, CVSSCLineCapSquare == brush->lineCap ? kCGLineCapSquare : kCGLineCapRound);
+    CGContextSetLineWidth(pContext, (CGFloat)brush->lineWidth);
+    CGContextSetBlendMode(pContext, brush->clears ? kCGBlendModeClear : kCGBlendModeNormal);
+    CGContextSetAlpha(pContext, (CGFloat)brush->alpha);
+    CGContextSetRGBStrokeColor(pContext, (CGFloat)pStroke->color.red, (CGFloat)pStroke->color.green, (CGFloat)pStroke->color.blue, (CGFloat)pStroke->color.alpha);
+    const CVSSCPathSink sink = {
+        .context = pContext,
+        .moveToPoint = PathMoveToPoint,
+        .addLineToPoint = PathAddLineToPoint,
+        .addCurveToPoint = PathAddCurveToPoint
+    };
+    CGContextBeginPath(pContext);
+    CVSSCComponentsAddToPathSink(&pRecording->components[pStroke->firstComponent], pStroke->componentCount, &sink);
+    CGContextStrokePath(pContext);
+}
+
+// renders the golden's drawing with CG and writes the golden. returns false on failure.
+static bool RenderGolden(const char* const pManifestPath, const CVSSCToolGolden* const pGolden) {
+    char drawingPath[1024];
+    char goldenPath[1024];
+    if (!CVSSCToolGetGoldenPath(pManifestPath, pGolden->drawing, ".json", drawingPath, sizeof(drawingPath))
+        || !CVSSCToolGetGoldenPath(pManifestPath, pGolden->name, ".png", goldenPath, sizeof(goldenPath))) {
+        fprintf(stderr, "%s: path too long\n", pGolden->name);
+        return false;
+    }
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(drawingPath, &length);
+    if (NULL == bytes) {
+        fprintf(stderr, "%s: could not be read\n", drawingPath);
+        return false;
+    }
+    CVSSCToolRecording recording;
+    memset(&recording, 0, sizeof(recording));
+    recording.skipsUnstrokedStrokes = true;
+    const bool read = CVSSCToolReadRecording(bytes, length, &recording);
+    free(bytes);
+    if (!read) {
+        fprintf(stderr, "%s: malformed playback data\n", drawingPath);
+        CVSSCToolRecordingFree(&recording);
+        return false;
+    }
+
+    const uint32_t width = (uint32_t)(pGolden->width * pGolden->scale + 0.5);
+    const uint32_t height = (uint32_t)(pGolden->height * pGolden->scale + 0.5);
+    const size_t bytesPerRow = 4 * (size_t)width;
+    uint8_t* const pixels = calloc(bytesPerRow, height);
+    uint8_t* const rows = malloc(bytesPerRow * height);
+    CGColorSpaceRef space = CGColorSpaceCreateDeviceRGB();
+    CGContextRef context = pixels && space ? CGBitmapContextCreate(pixels, width, height, 8, bytesPerRow, space, (CGBitmapInfo)kCGImageAlphaPremultipliedLast) : NULL;
+    CGColorSpaceRelease(space);
+    bool result = NULL != context && NULL != rows;
+    if (result) {
+        // the cache view's transform: points, with CG's origin at the bottom left
+        CGContextScaleCTM(context, (CGFloat)pGolden->scale, (CGFloat)pGolden->scale);
+        for (size_t idx = 0; idx < recording.strokeCount; ++idx) {
+            RenderStroke(context, &recording, &recording.strokes[idx]);
+        }
+        CGContextFlush(context);
+        // so the first row is y = 0, as the rasterizer renders the drawing in CVSSCRasterBenchmark
+        for (uint32_t y = 0; y < height; ++y) {
+            memcpy(rows + bytesPerRow * y, pixels + bytesPerRow * (height - 1 - y), bytesPerRow);
+        }
+        const CVSSCBitmap bitmap = CVSSCBitmapMake(rows, width, height, bytesPerRow);
+        result = CVSSCToolWritePNG(goldenPath, &bitmap, 9);
+        if (result) {
+            printf("%s: %zu strokes, %ux%u px\n", goldenPath, recording.strokeCount, width, height);
+        }
+        else {
+            fprintf(stderr, "%s: could not be written\n", goldenPath);
+        }
+    }
+    else {
+        fprintf(stderr, "out of memory\n");
+    }
+    CGContextRelease(context);
+    free(rows);
+    free(pixels);
+    CVSSCToolRecordingFree(&recording);
+    return result;
+}
+
+#pragma mark - Main
+
+int main(int argc, char** argv) {
+    if (2 != argc) {
+        fprintf(stderr, "usage: %s Goldens.txt\n", argv[0]);
+        return 2;
+    }
+    enum { MaximumGoldenCount = 64 };
+    CVSSCToolGolden goldens[MaximumGoldenCount];
+    const size_t count = CVSSCToolReadGoldens(argv[1], goldens, MaximumGoldenCount);
+    if (0 == count) {
+        fprintf(stderr, "%s: could not be read as a golden manifest\n", argv[1]);
+        return 2;
+    }
+    int result = 0;
+    for (size_t idx = 0; idx < count; ++idx) {
+        if (!RenderGolden(argv[1], &goldens[idx])) {
+            result = 1;
+        }
+    }
+    return result;
+}
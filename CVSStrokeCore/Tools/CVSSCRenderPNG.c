@@ -0,0 +1,459 @@
+// CVSSCRenderPNG.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// renders playback data over template images to PNGs with the software rasterizer (and the stamper, for the stamped
+// brushes) -- headless, on every core. for regenerating gallery images and thumbnails on a server without a GPU.
+//
+// build (from the repository root, any C99 compiler with pthreads; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCRenderPNG.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -lpthread -o CVSSCRenderPNG
+//
+// usage:
+//   CVSSCRenderPNG [-s scale] [-w width] [-h height] [-t template.png] [-j jobs] [-z level] -o outputDirectory input [input ...]
+//
+// each input is a playback file (JSON or binary -- the format is detected) or a directory, whose *.json and *.cvsp files are
+// rendered in name order. drawing <name> is written to outputDirectory/<name>.png. its template is <name>.template.png beside
+// the playback file when that exists, else -t, else none. the canvas is width x height points (default 1024 x 768, the
+// playback view's) rendered at scale pixels per point; the template is stretched to fill it, over white, as the playback
+// view draws it. -j defaults to the number of online processors. -z is the zlib level of the PNGs.
+// reports drawings/sec and the peak resident memory of the process. exits 1 if any drawing failed.
+
+#define _XOPEN_SOURCE 700
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static bool IsDirectory(const char* const pPath) {
+    struct stat info;
+    return 0 == stat(pPath, &info) && S_ISDIR(info.st_mode);
+}
+
+static bool HasSuffix(const char* const pString, const char* const pSuffix) {
+    const size_t length = strlen(pString);
+    const size_t suffixLength = strlen(pSuffix);
+    return length > suffixLength && 0 == strcmp(pString + length - suffixLength, pSuffix);
+}
+
+// returns a malloc'd copy of the path without its directory and extension
+static char* CopyName(const char* const pPath) {
+    const char* const slash = strrchr(pPath, '/');
+    const char* const name = slash ? slash + 1 : pPath;
+    const char* const dot = strrchr(name, '.');
+    const size_t length = dot && dot != name ? (size_t)(dot - name) : strlen(name);
+    char* const result = malloc(length + 1);
+    if (result) {
+        memcpy(result, name, length);
+        result[length] = 0;
+    }
+    return result;
+}
+
+// returns a malloc'd copy of the path with its extension replaced by pExtension
+static char* CopyPathWithExtension(const char* const pPath, const char* const pExtension) {
+    const char* const slash = strrchr(pPath, '/');
+    const char* const dot = strrchr(pPath, '.');
+    const size_t length = dot && (NULL == slash || dot > slash + 1) ? (size_t)(dot - pPath) : strlen(pPath);
+    char* const result = malloc(length + strlen(pExtension) + 1);
+    if (result) {
+        memcpy(result, pPath, length);
+        strcpy(result + length, pExtension);
+    }
+    return result;
+}
+
+// the peak resident memory of the process in octets
+static double PeakResidentOctets(void) {
+    struct rusage usage;
+    if (0 != getrusage(RUSAGE_SELF, &usage)) {
+        return 0.0;
+    }
+#if defined(__APPLE__)
+    return (double)usage.ru_maxrss;
+#else
+    return 1024.0 * (double)usage.ru_maxrss;
+#endif
+}
+
+#pragma mark - Inputs
+
+typedef struct {
+    char** paths;
+    size_t count;
+    size_t capacity;
+} PathList;
+
+static bool PathListAppend(PathList* const pList, const char* const pPath) {
+    if (pList->count == pList->capacity) {
+        const size_t capacity = pList->capacity ? 2 * pList->capacity : 64;
+        char** const grown = realloc(pList->paths, capacity * sizeof(char*));
+        if (NULL == grown) {
+            return false;
+        }
+        pList->paths = grown;
+        pList->capacity = capacity;
+    }
+    char* const copy = malloc(strlen(pPath) + 1);
+    if (NULL == copy) {
+        return false;
+    }
+    strcpy(copy, pPath);
+    pList->paths[pList->count++] = copy;
+    return true;
+}
+
+static int ComparePaths(const void* const pA, const void* const pB) {
+    return strcmp(*(char* const*)pA, *(char* const*)pB);
+}
+
+// appends the playback files of the directory, in name order
+static bool PathListAppendDirectory(PathList* const pList, const char* const pDirectory) {
+    DIR* const directory = opendir(pDirectory);
+    if (NULL == directory) {
+        return false;
+    }
+    const size_t first = pList->count;
+    bool result = true;
+    for (struct dirent* entry = readdir(directory); result && entry; entry = readdir(directory)) {
+        const char* const name = entry->d_name;
+        if ('.' == name[0] || !(HasSuffix(name, ".json") || HasSuffix(name, ".cvsp"))) {
+            continue;
+        }
+        char* const path = malloc(strlen(pDirectory) + strlen(name) + 2);
+        result = NULL != path;
+        if (result) {
+            sprintf(path, "%s/%s", pDirectory, name);
+            result = PathListAppend(pList, path);
+            free(path);
+        }
+    }
+    closedir(directory);
+    qsort(&pList->paths[first], pList->count - first, sizeof(char*), ComparePaths);
+    return result;
+}
+
+static void PathListDestroy(PathList* const pList) {
+    for (size_t idx = 0; idx < pList->count; ++idx) {
+        free(pList->paths[idx]);
+    }
+    free(pList->paths);
+}
+
+#pragma mark - Rendering
+
+typedef struct {
+    uint32_t width;
+    uint32_t height;
+    double scale;
+    int compressionLevel;
+    const char* outputDirectory;
+    // white, with the -t template (if any) drawn over it
+    CVSSCBitmap background;
+    const PathList* inputs;
+    // guarded by lock
+    pthread_mutex_t lock;
+    size_t nextInput;
+    size_t renderedCount;
+    size_t failedCount;
+    uint64_t strokeCount;
+    uint64_t componentCount;
+} Batch;
+
+typedef struct {
+    Batch* batch;
+    CVSSCRasterizer* rasterizer;
+    // renders the strokes of the stamped brushes
+    CVSSCStamper* stamper;
+    // the strokes, which are composited over the background and template
+    CVSSCBitmap layer;
+    CVSSCBitmap output;
+    CVSSCTransform transform;
+    size_t strokeCount;
+    size_t componentCount;
+} Worker;
+
+static bool WorkerReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    Worker* const worker = pContext;
+    if (!pStroke->componentCount || CVSSCBrushTypePen > pStroke->brushType || CVSSCBrushTypePaintbucket < pStroke->brushType) {
+        // as CVSPlaybackStrokes, strokes which cannot be rendered are skipped
+        return true;
+    }
+    // opaque, as the playback view draws
+    const CVSSCColor color = {pStroke->color.red, pStroke->color.green, pStroke->color.blue, 1.0};
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(pStroke->brushType);
+    ++worker->strokeCount;
+    worker->componentCount += pStroke->componentCount;
+    if (CVSSCBrushStampNone != brush->stamp) {
+        return CVSSCStamperRenderStroke(worker->stamper, &worker->layer, &worker->transform, CVSSCBitmapGetPixelRect(&worker->layer), brush, color, pStroke->components, pStroke->componentCount);
+    }
+    return CVSSCRasterizerRenderStroke(worker->rasterizer, &worker->layer, &worker->transform, CVSSCBitmapGetPixelRect(&worker->layer), brush, color, pStroke->components, pStroke->componentCount);
+}
+
+// renders the strokes into the layer as they are read
+static bool RenderStrokes(Worker* const pWorker, const char* const pBytes, const size_t pLength) {
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {pWorker, NULL, WorkerReadStroke};
+    if (CVSSCPlaybackBinaryHasSignature(pBytes, pLength)) {
+        CVSSCPlaybackBinaryReader* const reader = CVSSCPlaybackBinaryReaderCreate(&callbacks);
+        const bool result = reader && CVSSCPlaybackBinaryReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackBinaryReaderFinish(reader);
+        CVSSCPlaybackBinaryReaderDestroy(reader);
+        return result;
+    }
+    CVSSCPlaybackJSONReader* const reader = CVSSCPlaybackJSONReaderCreate(&callbacks);
+    const bool result = reader && CVSSCPlaybackJSONReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackJSONReaderFinish(reader);
+    CVSSCPlaybackJSONReaderDestroy(reader);
+    return result;
+}
+
+static bool RenderDrawing(Worker* const pWorker, const char* const pPath) {
+    const Batch* const batch = pWorker->batch;
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        fprintf(stderr, "%s: could not be read\n", pPath);
+        return false;
+    }
+    pWorker->strokeCount = 0;
+    pWorker->componentCount = 0;
+    CVSSCBitmapClear(&pWorker->layer, CVSSCBitmapGetPixelRect(&pWorker->layer));
+    const bool rendered = RenderStrokes(pWorker, bytes, length);
+    free(bytes);
+    if (!rendered) {
+        fprintf(stderr, "%s: malformed playback data (or out of memory)\n", pPath);
+        return false;
+    }
+
+    // the drawing's own template, else the batch's
+    char* const templatePath = CopyPathWithExtension(pPath, ".template.png");
+    CVSSCBitmap drawingTemplate = {NULL, 0, 0, 0};
+    const bool hasTemplate = templatePath && 0 == access(templatePath, R_OK);
+    if (hasTemplate && !CVSSCToolReadPNG(templatePath, &drawingTemplate)) {
+        fprintf(stderr, "%s: could not be read as a PNG\n", templatePath);
+        free(templatePath);
+        return false;
+    }
+    free(templatePath);
+    if (hasTemplate) {
+        const CVSSCColor white = {1.0, 1.0, 1.0, 1.0};
+        CVSSCBitmapFill(&pWorker->output, CVSSCBitmapGetPixelRect(&pWorker->output), white);
+        CVSSCBitmapDrawScaledOver(&pWorker->output, &drawingTemplate);
+        CVSSCFree(drawingTemplate.pixels);
+    }
+    else {
+        memcpy(pWorker->output.pixels, batch->background.pixels, pWorker->output.bytesPerRow * pWorker->output.height);
+    }
+    CVSSCBitmapDrawOver(&pWorker->output, &pWorker->layer);
+
+    char* const name = CopyName(pPath);
+    char* const outputPath = name ? malloc(strlen(batch->outputDirectory) + strlen(name) + 6) : NULL;
+    bool result = NULL != outputPath;
+    if (result) {
+        sprintf(outputPath, "%s/%s.png", batch->outputDirectory, name);
+        result = CVSSCToolWritePNG(outputPath, &pWorker->output, batch->compressionLevel);
+        if (!result) {
+            fprintf(stderr, "%s: could not be written\n", outputPath);
+        }
+    }
+    free(name);
+    free(outputPath);
+    return result;
+}
+
+static void* WorkerMain(void* const pContext) {
+    Worker* const worker = pContext;
+    Batch* const batch = worker->batch;
+    for (;;) {
+        pthread_mutex_lock(&batch->lock);
+        const size_t idx = batch->nextInput++;
+        pthread_mutex_unlock(&batch->lock);
+        if (idx >= batch->inputs->count) {
+            break;
+        }
+        const bool rendered = RenderDrawing(worker, batch->inputs->paths[idx]);
+        pthread_mutex_lock(&batch->lock);
+        if (rendered) {
+            ++batch->renderedCount;
+            batch->strokeCount += worker->strokeCount;
+            batch->componentCount += worker->componentCount;
+        }
+        else {
+            ++batch->failedCount;
+        }
+        pthread_mutex_unlock(&batch->lock);
+    }
+    return NULL;
+}
+
+static bool CreateBitmap(const uint32_t pWidth, const uint32_t pHeight, CVSSCBitmap* const pOutBitmap) {
+    uint8_t* const pixels = CVSSCAllocate(4 * (size_t)pWidth * pHeight);
+    if (NULL == pixels) {
+        return false;
+    }
+    *pOutBitmap = CVSSCBitmapMake(pixels, pWidth, pHeight, 4 * (size_t)pWidth);
+    return true;
+}
+
+static int RenderBatch(Batch* const pBatch, const char* const pTemplatePath, const int pJobCount) {
+    if (!CreateBitmap(pBatch->width, pBatch->height, &pBatch->background)) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    const CVSSCColor white = {1.0, 1.0, 1.0, 1.0};
+    CVSSCBitmapFill(&pBatch->background, CVSSCBitmapGetPixelRect(&pBatch->background), white);
+    if (pTemplatePath) {
+        CVSSCBitmap image;
+        if (!CVSSCToolReadPNG(pTemplatePath, &image)) {
+            fprintf(stderr, "%s: could not be read as a PNG\n", pTemplatePath);
+            CVSSCFree(pBatch->background.pixels);
+            return 1;
+        }
+        // stretched once for every drawing which uses it
+        CVSSCBitmapDrawScaledOver(&pBatch->background, &image);
+        CVSSCFree(image.pixels);
+    }
+
+    const int workerCount = (size_t)pJobCount < pBatch->inputs->count ? pJobCount : (int)pBatch->inputs->count;
+    Worker* const workers = calloc((size_t)workerCount, sizeof(Worker));
+    pthread_t* const threads = calloc((size_t)workerCount, sizeof(pthread_t));
+    bool* const isStarted = calloc((size_t)workerCount, sizeof(bool));
+    int result = workers && threads && isStarted ? 0 : 1;
+    const double start = Now();
+    for (int idx = 0; 0 == result && idx < workerCount; ++idx) {
+        Worker* const worker = &workers[idx];
+        worker->batch = pBatch;
+        worker->transform = CVSSCTransformMake(pBatch->scale, 0.0, 0.0, pBatch->scale, 0.0, 0.0);
+        worker->rasterizer = CVSSCRasterizerCreate();
+        worker->stamper = CVSSCStamperCreate();
+        const bool created = worker->rasterizer && worker->stamper && CreateBitmap(pBatch->width, pBatch->height, &worker->layer) && CreateBitmap(pBatch->width, pBatch->height, &worker->output);
+        isStarted[idx] = created && 0 == pthread_create(&threads[idx], NULL, WorkerMain, worker);
+        if (!isStarted[idx]) {
+            fprintf(stderr, "out of memory (or a thread could not be started)\n");
+            // the workers which started finish the batch
+            result = 0 == idx ? 1 : 0;
+            break;
+        }
+    }
+    for (int idx = 0; workers && threads && isStarted && idx < workerCount; ++idx) {
+        if (isStarted[idx]) {
+            pthread_join(threads[idx], NULL);
+        }
+        CVSSCRasterizerDestroy(workers[idx].rasterizer);
+        CVSSCStamperDestroy(workers[idx].stamper);
+        CVSSCFree(workers[idx].layer.pixels);
+        CVSSCFree(workers[idx].output.pixels);
+    }
+    const double seconds = Now() - start;
+    free(workers);
+    free(threads);
+    free(isStarted);
+    CVSSCFree(pBatch->background.pixels);
+    if (0 != result) {
+        return result;
+    }
+
+    printf("drawings: %zu rendered, %zu failed (%ux%u px, %d jobs, spans: %s)\n", pBatch->renderedCount, pBatch->failedCount, pBatch->width, pBatch->height, workerCount, CVSSCSpanImplementationName());
+    printf("  strokes: %llu components: %llu\n", (unsigned long long)pBatch->strokeCount, (unsigned long long)pBatch->componentCount);
+    printf("  time: %.3f s  %.2f drawings/sec  %.0f strokes/sec\n", seconds, pBatch->renderedCount / seconds, pBatch->strokeCount / seconds);
+    printf("  peak resident memory: %.1f MB\n", PeakResidentOctets() / (1024.0 * 1024.0));
+    return pBatch->failedCount ? 1 : 0;
+}
+
+#pragma mark - Main
+
+static int Usage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-s scale] [-w width] [-h height] [-t template.png] [-j jobs] [-z level] -o outputDirectory input [input ...]\n", pName);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    double scale = 1.0;
+    uint32_t width = 1024;
+    uint32_t height = 768;
+    const char* templatePath = NULL;
+    const long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+    int jobCount = 0 < processorCount ? (int)processorCount : 1;
+    int compressionLevel = -1;
+    const char* outputDirectory = NULL;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            scale = atof(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-t") && idx + 1 < argc) {
+            templatePath = argv[++idx];
+        }
+        else if (0 == strcmp(argv[idx], "-j") && idx + 1 < argc) {
+            jobCount = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-z") && idx + 1 < argc) {
+            compressionLevel = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-o") && idx + 1 < argc) {
+            outputDirectory = argv[++idx];
+        }
+        else {
+            return Usage(argv[0]);
+        }
+    }
+    const double pixelWidth = width * scale + 0.5;
+    const double pixelHeight = height * scale + 0.5;
+    const bool validOptions = scale > 0.0 && 1.0 <= pixelWidth && 1.0 <= pixelHeight && pixelWidth * pixelHeight <= CVSSCPNGMaxPixelCount
+        && 0 < jobCount && -1 <= compressionLevel && 9 >= compressionLevel && outputDirectory;
+    if (!validOptions || idx == argc) {
+        return Usage(argv[0]);
+    }
+    if (!IsDirectory(outputDirectory)) {
+        fprintf(stderr, "%s: not a directory\n", outputDirectory);
+        return 2;
+    }
+
+    PathList inputs = {NULL, 0, 0};
+    for (; idx < argc; ++idx) {
+        const bool appended = IsDirectory(argv[idx]) ? PathListAppendDirectory(&inputs, argv[idx]) : PathListAppend(&inputs, argv[idx]);
+        if (!appended) {
+            fprintf(stderr, "%s: could not be read\n", argv[idx]);
+            PathListDestroy(&inputs);
+            return 1;
+        }
+    }
+    if (0 == inputs.count) {
+        fprintf(stderr, "no playback files\n");
+        PathListDestroy(&inputs);
+        return 1;
+    }
+
+    Batch batch;
+    memset(&batch, 0, sizeof(batch));
+    batch.width = (uint32_t)pixelWidth;
+    batch.height = (uint32_t)pixelHeight;
+    batch.scale = scale;
+    batch.compressionLevel = compressionLevel;
+    batch.outputDirectory = outputDirectory;
+    batch.inputs = &inputs;
+    pthread_mutex_init(&batch.lock, NULL);
+    const int result = RenderBatch(&batch, templatePath, jobCount);
+    pthread_mutex_destroy(&batch.lock);
+    PathListDestroy(&inputs);
+    return result;
+}
@@ -0,0 +1,263 @@
+// CVSSCReplayBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// replays recorded playback JSON through the stroke geometry core and reports throughput and allocations.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCReplayBenchmark.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCReplayBenchmark
+//
+// usage:
+//   CVSSCReplayBenchmark [-i iterations] [-c chunkSize] playback.json [playback.json ...]
+//
+// phases, per file:
+//   parse:  the streaming reader, fed in chunks of chunkSize octets (as if from the network)
+//   replay: for every stroke -- segment assembly (to a flattening sink), brush-inflated stroke bounds, and the
+//           generator's smoothing run over the stroke's points (as if drawn again)
+// allocations are those made by the library (see CVSSCMemory.h).
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static uint64_t AllocationCount(void) {
+    const CVSSCMemoryStatistics statistics = CVSSCMemoryGetStatistics();
+    return statistics.allocations + statistics.reallocations;
+}
+
+#pragma mark - Recorded Strokes
+
+// the strokes of a file, copied out of the reader so that replay may be measured without parsing
+typedef struct {
+    CVSSCBrushType brushType;
+    size_t firstComponent;
+    size_t componentCount;
+} RecordedStroke;
+
+typedef struct {
+    RecordedStroke* strokes;
+    size_t strokeCount;
+    size_t strokeCapacity;
+    CVSSCComponent* components;
+    size_t componentCount;
+    size_t componentCapacity;
+} Recording;
+
+static bool RecordingReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    Recording* const recording = pContext;
+    if (recording->strokeCount == recording->strokeCapacity) {
+        recording->strokeCapacity = recording->strokeCapacity ? 2 * recording->strokeCapacity : 1024;
+        recording->strokes = realloc(recording->strokes, recording->strokeCapacity * sizeof(RecordedStroke));
+    }
+    while (recording->componentCount + pStroke->componentCount > recording->componentCapacity) {
+        recording->componentCapacity = recording->componentCapacity ? 2 * recording->componentCapacity : 1 << 14;
+        recording->components = realloc(recording->components, recording->componentCapacity * sizeof(CVSSCComponent));
+    }
+    if (NULL == recording->strokes || NULL == recording->components) {
+        return false;
+    }
+    const RecordedStroke stroke = {pStroke->brushType, recording->componentCount, pStroke->componentCount};
+    recording->strokes[recording->strokeCount++] = stroke;
+    memcpy(&recording->components[recording->componentCount], pStroke->components, pStroke->componentCount * sizeof(CVSSCComponent));
+    recording->componentCount += pStroke->componentCount;
+    return true;
+}
+
+static bool CountStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    size_t* const componentCount = pContext;
+    *componentCount += pStroke->componentCount;
+    return true;
+}
+
+#pragma mark - Replay
+
+// flattens curves to a fixed number of segments and accumulates their length, so the work cannot be elided
+typedef struct {
+    CVSSCPoint current;
+    double length;
+    size_t elements;
+} FlatteningSink;
+
+static void SinkMoveToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    FlatteningSink* const sink = pContext;
+    sink->current = pPoint;
+    ++sink->elements;
+}
+
+static void SinkAddLineToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    FlatteningSink* const sink = pContext;
+    sink->length += CVSSCPointDistance(sink->current, pPoint);
+    sink->current = pPoint;
+    ++sink->elements;
+}
+
+static void SinkAddCurveToPoint(void* const pContext, const CVSSCPoint pControlPoint1, const CVSSCPoint pControlPoint2, const CVSSCPoint pPoint) {
+    FlatteningSink* const sink = pContext;
+    enum { Segments = 8 };
+    const CVSSCPoint p0 = sink->current;
+    CVSSCPoint previous = p0;
+    for (int idx = 1; idx <= Segments; ++idx) {
+        const double t = (double)idx / Segments;
+        const double u = 1.0 - t;
+        const double b0 = u * u * u, b1 = 3 * u * u * t, b2 = 3 * u * t * t, b3 = t * t * t;
+        const CVSSCPoint at = {
+            b0 * p0.x + b1 * pControlPoint1.x + b2 * pControlPoint2.x + b3 * pPoint.x,
+            b0 * p0.y + b1 * pControlPoint1.y + b2 * pControlPoint2.y + b3 * pPoint.y
+        };
+        sink->length += CVSSCPointDistance(previous, at);
+        previous = at;
+    }
+    sink->current = pPoint;
+    ++sink->elements;
+}
+
+typedef struct {
+    double length;
+    double boundsArea;
+    double controlSum;
+    size_t elements;
+} ReplayResult;
+
+static void ReplayStroke(const CVSSCBrushType pBrushType, const CVSSCComponent* const pComponents, const size_t pCount, ReplayResult* const pResult) {
+    FlatteningSink sink = {{0, 0}, 0, 0};
+    const CVSSCPathSink pathSink = {&sink, SinkMoveToPoint, SinkAddLineToPoint, SinkAddCurveToPoint};
+    CVSSCComponentsAddToPathSink(pComponents, pCount, &pathSink);
+    pResult->length += sink.length;
+    pResult->elements += sink.elements;
+
+    const CVSSCRect bounds = CVSSCComponentsGetStrokeBounds(pComponents, pCount, CVSSCBrushAttributesForBrushType(pBrushType)->lineWidth);
+    if (!CVSSCRectIsNull(bounds)) {
+        pResult->boundsArea += bounds.width * bounds.height;
+    }
+
+    // smooth the stroke's points again, as the generator does while tracking
+    CVSSCPoint samples[CVSSCSmoothingSampleCount];
+    size_t nSamples = 0;
+    for (size_t idx = 0; idx < pCount; ++idx) {
+        if (CVSSCSmoothingSampleCount == nSamples) {
+            memmove(&samples[0], &samples[1], (CVSSCSmoothingSampleCount - 1) * sizeof(CVSSCPoint));
+            --nSamples;
+        }
+        samples[nSamples++] = pComponents[idx].toPoint;
+        const CVSSCComponent smoothed = CVSSCSmoothingMakeComponent(samples, nSamples, CVSSCSmoothingDefaultSmoothValue);
+        pResult->controlSum += smoothed.controlPoint1.x + smoothed.controlPoint2.y;
+    }
+}
+
+static void ReplayRecording(const Recording* const pRecording, ReplayResult* const pResult) {
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        const RecordedStroke* const stroke = &pRecording->strokes[idx];
+        ReplayStroke(stroke->brushType, &pRecording->components[stroke->firstComponent], stroke->componentCount, pResult);
+    }
+}
+
+#pragma mark - Main
+
+static bool Parse(const char* const pBytes, const size_t pLength, const size_t pChunkSize, const CVSSCPlaybackJSONReaderCallbacks* const pCallbacks) {
+    CVSSCPlaybackJSONReader* const reader = CVSSCPlaybackJSONReaderCreate(pCallbacks);
+    if (NULL == reader) {
+        return false;
+    }
+    bool result = true;
+    for (size_t offset = 0; result && offset < pLength; offset += pChunkSize) {
+        const size_t length = (pLength - offset) < pChunkSize ? (pLength - offset) : pChunkSize;
+        result = CVSSCPlaybackJSONReaderAppend(reader, pBytes + offset, length);
+    }
+    result = result && CVSSCPlaybackJSONReaderFinish(reader);
+    CVSSCPlaybackJSONReaderDestroy(reader);
+    return result;
+}
+
+static int BenchmarkFile(const char* const pPath, const int pIterations, const size_t pChunkSize) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        fprintf(stderr, "%s: could not be read\n", pPath);
+        return 1;
+    }
+
+    Recording recording;
+    memset(&recording, 0, sizeof(recording));
+    const CVSSCPlaybackJSONReaderCallbacks recordingCallbacks = {&recording, NULL, RecordingReadStroke};
+    if (!Parse(bytes, length, pChunkSize, &recordingCallbacks)) {
+        fprintf(stderr, "%s: malformed playback data\n", pPath);
+        free(bytes);
+        return 1;
+    }
+
+    // parse
+    size_t parsedComponents = 0;
+    const CVSSCPlaybackJSONReaderCallbacks countingCallbacks = {&parsedComponents, NULL, CountStroke};
+    const uint64_t parseAllocationsBefore = AllocationCount();
+    const double parseStart = Now();
+    for (int idx = 0; idx < pIterations; ++idx) {
+        Parse(bytes, length, pChunkSize, &countingCallbacks);
+    }
+    const double parseSeconds = Now() - parseStart;
+    const uint64_t parseAllocations = AllocationCount() - parseAllocationsBefore;
+
+    // replay
+    ReplayResult replay;
+    memset(&replay, 0, sizeof(replay));
+    const uint64_t replayAllocationsBefore = AllocationCount();
+    const double replayStart = Now();
+    for (int idx = 0; idx < pIterations; ++idx) {
+        ReplayRecording(&recording, &replay);
+    }
+    const double replaySeconds = Now() - replayStart;
+    const uint64_t replayAllocations = AllocationCount() - replayAllocationsBefore;
+
+    const double strokes = (double)recording.strokeCount * pIterations;
+    const double components = (double)recording.componentCount * pIterations;
+    printf("%s\n", pPath);
+    printf("  strokes: %zu components: %zu octets: %zu iterations: %d\n", recording.strokeCount, recording.componentCount, length, pIterations);
+    printf("  parse:  %10.0f components/sec %8.2f MB/sec %6.3f allocations/stroke\n",
+           components / parseSeconds, ((double)length * pIterations) / parseSeconds / 1.0e6, strokes > 0 ? parseAllocations / strokes : 0.0);
+    printf("  replay: %10.0f components/sec %8.3f us/stroke %6.3f allocations/stroke\n",
+           components / replaySeconds, strokes > 0 ? 1.0e6 * replaySeconds / strokes : 0.0, strokes > 0 ? replayAllocations / strokes : 0.0);
+    printf("  (checksum %.3f)\n", replay.length + replay.boundsArea + replay.controlSum + (double)replay.elements + (double)parsedComponents);
+
+    free(recording.strokes);
+    free(recording.components);
+    free(bytes);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 10;
+    size_t chunkSize = 1 << 14;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-i") && idx + 1 < argc) {
+            iterations = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-c") && idx + 1 < argc) {
+            chunkSize = (size_t)atol(argv[++idx]);
+        }
+        else {
+            break;
+        }
+    }
+    if (idx == argc || 0 >= iterations || 0 == chunkSize) {
+        fprintf(stderr, "usage: %s [-i iterations] [-c chunkSize] playback.json [playback.json ...]\n", argv[0]);
+        return 2;
+    }
+    int result = 0;
+    for (; idx < argc; ++idx) {
+        result |= BenchmarkFile(argv[idx], iterations, chunkSize);
+    }
+    return result;
+}
@@ -0,0 +1,372 @@
+// CVSSCSimplifyBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// measures commit-time stroke simplification (CVSSCSimplify) over a corpus of drawings: the reduction in components, the
+// time it takes, and how much it changes the drawings' pixels.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCSimplifyBenchmark.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCSimplifyBenchmark
+//
+// usage:
+//   CVSSCSimplifyBenchmark [-e tolerance] [-s scale] [-w width] [-h height] [-t difference] [-r radius] [-p percent] input [input ...]
+//
+// each input is a playback file (JSON or binary -- the format is detected) or a directory, whose *.json and *.cvsp files are
+// read in name order. the strokes of round capped brushes are simplified as CVSStrokeGenerator simplifies them when they
+// end: -e is the tolerance in pixels (default 0.5) at scale pixels per point (default 2). every drawing is rendered with the
+// software rasterizer before and after simplification into a width x height (points) canvas, and the renderings are
+// compared. a pixel differs if a channel is more than difference (default 32) outside the range of that channel over the pixels
+// within radius (default 1) pixels of it in the other rendering: edges which moved by up to the tolerance (plus the rasterizer's
+// flattening error) are within the range, and only changes of shape count. exits 1 if more than percent% (default 0.05) of any
+// drawing's pixels differ.
+
+#define _XOPEN_SOURCE 700
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static bool IsDirectory(const char* const pPath) {
+    struct stat info;
+    return 0 == stat(pPath, &info) && S_ISDIR(info.st_mode);
+}
+
+static bool HasSuffix(const char* const pString, const char* const pSuffix) {
+    const size_t length = strlen(pString);
+    const size_t suffixLength = strlen(pSuffix);
+    return length > suffixLength && 0 == strcmp(pString + length - suffixLength, pSuffix);
+}
+
+#pragma mark - Inputs
+
+typedef struct {
+    char** paths;
+    size_t count;
+    size_t capacity;
+} PathList;
+
+static bool PathListAppend(PathList* const pList, const char* const pPath) {
+    if (pList->count == pList->capacity) {
+        const size_t capacity = pList->capacity ? 2 * pList->capacity : 64;
+        char** const grown = realloc(pList->paths, capacity * sizeof(char*));
+        if (NULL == grown) {
+            return false;
+        }
+        pList->paths = grown;
+        pList->capacity = capacity;
+    }
+    char* const copy = malloc(strlen(pPath) + 1);
+    if (NULL == copy) {
+        return false;
+    }
+    strcpy(copy, pPath);
+    pList->paths[pList->count++] = copy;
+    return true;
+}
+
+static int ComparePaths(const void* const pA, const void* const pB) {
+    return strcmp(*(char* const*)pA, *(char* const*)pB);
+}
+
+// appends the playback files of the directory, in name order
+static bool PathListAppendDirectory(PathList* const pList, const char* const pDirectory) {
+    DIR* const directory = opendir(pDirectory);
+    if (NULL == directory) {
+        return false;
+    }
+    const size_t first = pList->count;
+    bool result = true;
+    for (struct dirent* entry = readdir(directory); result && entry; entry = readdir(directory)) {
+        const char* const name = entry->d_name;
+        if ('.' == name[0] || !(HasSuffix(name, ".json") || HasSuffix(name, ".cvsp"))) {
+            continue;
+        }
+        char* const path = malloc(strlen(pDirectory) + strlen(name) + 2);
+        result = NULL != path;
+        if (result) {
+            sprintf(path, "%s/%s", pDirectory, name);
+            result = PathListAppend(pList, path);
+            free(path);
+        }
+    }
+    closedir(directory);
+    qsort(&pList->paths[first], pList->count - first, sizeof(char*), ComparePaths);
+    return result;
+}
+
+static void PathListDestroy(PathList* const pList) {
+    for (size_t idx = 0; idx < pList->count; ++idx) {
+        free(pList->paths[idx]);
+    }
+    free(pList->paths);
+}
+
+#pragma mark - Drawings
+
+typedef struct {
+    double tolerance;
+    // the drawing's strokes are rendered into original as they are read; the simplified strokes into simplified
+    CVSSCRasterizer* rasterizer;
+    CVSSCBitmap original;
+    CVSSCBitmap simplified;
+    CVSSCTransform transform;
+    // room for the simplified components of a stroke
+    CVSSCComponent* components;
+    size_t componentCapacity;
+    bool failed;
+    // per drawing
+    size_t strokeCount;
+    size_t componentCount;
+    size_t simplifiedComponentCount;
+    double seconds;
+} Corpus;
+
+static bool CorpusReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    Corpus* const corpus = pContext;
+    if (!pStroke->componentCount || CVSSCBrushTypePen > pStroke->brushType || CVSSCBrushTypePaintbucket < pStroke->brushType) {
+        // as CVSPlaybackStrokes, strokes which cannot be rendered are skipped
+        return true;
+    }
+    if (pStroke->componentCount > corpus->componentCapacity) {
+        free(corpus->components);
+        corpus->componentCapacity = 2 * pStroke->componentCount;
+        corpus->components = malloc(corpus->componentCapacity * sizeof(CVSSCComponent));
+        if (NULL == corpus->components) {
+            corpus->componentCapacity = 0;
+            corpus->failed = true;
+            return false;
+        }
+    }
+    // as CVSStrokeGenerator: strokes of square capped brushes are not simplified
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(pStroke->brushType);
+    const double start = Now();
+    const size_t simplifiedCount = CVSSCLineCapRound == brush->lineCap ? CVSSCSimplifyComponents(pStroke->components, pStroke->componentCount, corpus->tolerance, corpus->components) : 0;
+    corpus->seconds += Now() - start;
+    const CVSSCComponent* const simplified = simplifiedCount ? corpus->components : pStroke->components;
+    ++corpus->strokeCount;
+    corpus->componentCount += pStroke->componentCount;
+    corpus->simplifiedComponentCount += simplifiedCount ? simplifiedCount : pStroke->componentCount;
+
+    // opaque, as the playback view draws
+    const CVSSCColor color = {pStroke->color.red, pStroke->color.green, pStroke->color.blue, 1.0};
+    const bool rendered = CVSSCRasterizerRenderStroke(corpus->rasterizer, &corpus->original, &corpus->transform, CVSSCBitmapGetPixelRect(&corpus->original), brush, color, pStroke->components, pStroke->componentCount)
+        && CVSSCRasterizerRenderStroke(corpus->rasterizer, &corpus->simplified, &corpus->transform, CVSSCBitmapGetPixelRect(&corpus->simplified), brush, color, simplified, simplifiedCount ? simplifiedCount : pStroke->componentCount);
+    corpus->failed = corpus->failed || !rendered;
+    return rendered;
+}
+
+static bool ReadDrawing(Corpus* const pCorpus, const char* const pBytes, const size_t pLength) {
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {pCorpus, NULL, CorpusReadStroke};
+    if (CVSSCPlaybackBinaryHasSignature(pBytes, pLength)) {
+        CVSSCPlaybackBinaryReader* const reader = CVSSCPlaybackBinaryReaderCreate(&callbacks);
+        const bool result = reader && CVSSCPlaybackBinaryReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackBinaryReaderFinish(reader);
+        CVSSCPlaybackBinaryReaderDestroy(reader);
+        return result;
+    }
+    CVSSCPlaybackJSONReader* const reader = CVSSCPlaybackJSONReaderCreate(&callbacks);
+    const bool result = reader && CVSSCPlaybackJSONReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackJSONReaderFinish(reader);
+    CVSSCPlaybackJSONReaderDestroy(reader);
+    return result;
+}
+
+// returns true if every channel of the pixel at (x, y) of pA is within pDifference of the range of that channel over the pixels of
+// pB within pRadius of (x, y). an antialiased edge which moved by less than pRadius is within the range.
+static bool IsWithinNeighborhood(const CVSSCBitmap* const pA, const CVSSCBitmap* const pB, const uint32_t pX, const uint32_t pY, const int pDifference, const int pRadius) {
+    const uint8_t* const pixel = CVSSCBitmapGetPixel(pA, pX, pY);
+    int minimum[4] = {255, 255, 255, 255};
+    int maximum[4] = {0, 0, 0, 0};
+    for (int64_t y = (int64_t)pY - pRadius; y <= (int64_t)pY + pRadius; ++y) {
+        for (int64_t x = (int64_t)pX - pRadius; x <= (int64_t)pX + pRadius; ++x) {
+            if (x < 0 || y < 0 || x >= pB->width || y >= pB->height) {
+                continue;
+            }
+            const uint8_t* const neighbor = CVSSCBitmapGetPixel(pB, (uint32_t)x, (uint32_t)y);
+            for (int channel = 0; channel < 4; ++channel) {
+                minimum[channel] = neighbor[channel] < minimum[channel] ? neighbor[channel] : minimum[channel];
+                maximum[channel] = neighbor[channel] > maximum[channel] ? neighbor[channel] : maximum[channel];
+            }
+        }
+    }
+    for (int channel = 0; channel < 4; ++channel) {
+        if (pixel[channel] + pDifference < minimum[channel] || pixel[channel] > maximum[channel] + pDifference) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// counts the pixels which are not within pDifference of the other rendering's neighborhood (either way), so that edges which
+// moved by less than pRadius are not counted. sets *pOutMaximum to the largest difference between pixels at the same position.
+static size_t CountDifferingPixels(const CVSSCBitmap* const pA, const CVSSCBitmap* const pB, const int pDifference, const int pRadius, int* const pOutMaximum) {
+    size_t result = 0;
+    int maximum = 0;
+    for (uint32_t y = 0; y < pA->height; ++y) {
+        const uint8_t* const rowA = CVSSCBitmapGetPixel(pA, 0, y);
+        const uint8_t* const rowB = CVSSCBitmapGetPixel(pB, 0, y);
+        for (uint32_t x = 0; x < pA->width; ++x) {
+            int pixelDifference = 0;
+            for (int channel = 0; channel < 4; ++channel) {
+                const int difference = abs((int)rowA[4 * x + channel] - (int)rowB[4 * x + channel]);
+                pixelDifference = difference > pixelDifference ? difference : pixelDifference;
+            }
+            maximum = pixelDifference > maximum ? pixelDifference : maximum;
+            if (pixelDifference > pDifference) {
+                result += !IsWithinNeighborhood(pA, pB, x, y, pDifference, pRadius) || !IsWithinNeighborhood(pB, pA, x, y, pDifference, pRadius);
+            }
+        }
+    }
+    *pOutMaximum = maximum;
+    return result;
+}
+
+#pragma mark - Main
+
+static int Usage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-e tolerance] [-s scale] [-w width] [-h height] [-t difference] [-r radius] [-p percent] input [input ...]\n", pName);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    double tolerance = 0.5;
+    double scale = 2.0;
+    uint32_t width = 768;
+    uint32_t height = 1024;
+    int difference = 32;
+    int radius = 1;
+    double percent = 0.05;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-e") && idx + 1 < argc) {
+            tolerance = atof(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            scale = atof(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-t") && idx + 1 < argc) {
+            difference = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-r") && idx + 1 < argc) {
+            radius = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-p") && idx + 1 < argc) {
+            percent = atof(argv[++idx]);
+        }
+        else {
+            return Usage(argv[0]);
+        }
+    }
+    if (idx == argc || !(tolerance >= 0.0) || !(scale > 0.0) || 0 == width || 0 == height || 0 > radius) {
+        return Usage(argv[0]);
+    }
+    PathList inputs = {NULL, 0, 0};
+    for (; idx < argc; ++idx) {
+        const bool appended = IsDirectory(argv[idx]) ? PathListAppendDirectory(&inputs, argv[idx]) : PathListAppend(&inputs, argv[idx]);
+        if (!appended) {
+            fprintf(stderr, "%s: could not be read\n", argv[idx]);
+            PathListDestroy(&inputs);
+            return 1;
+        }
+    }
+
+    const uint32_t pixelWidth = (uint32_t)(width * scale + 0.5);
+    const uint32_t pixelHeight = (uint32_t)(height * scale + 0.5);
+    const size_t pixelsLength = 4 * (size_t)pixelWidth * pixelHeight;
+    Corpus corpus;
+    memset(&corpus, 0, sizeof(corpus));
+    // the tolerance is in pixels; the components are in points
+    corpus.tolerance = tolerance / scale;
+    corpus.transform = CVSSCTransformMake(scale, 0.0, 0.0, scale, 0.0, 0.0);
+    corpus.rasterizer = CVSSCRasterizerCreate();
+    uint8_t* const originalPixels = malloc(pixelsLength);
+    uint8_t* const simplifiedPixels = malloc(pixelsLength);
+    int result = corpus.rasterizer && originalPixels && simplifiedPixels ? 0 : 1;
+    if (0 != result) {
+        fprintf(stderr, "out of memory\n");
+    }
+    corpus.original = CVSSCBitmapMake(originalPixels, pixelWidth, pixelHeight, 4 * (size_t)pixelWidth);
+    corpus.simplified = CVSSCBitmapMake(simplifiedPixels, pixelWidth, pixelHeight, 4 * (size_t)pixelWidth);
+
+    size_t drawingCount = 0, failedCount = 0, strokeCount = 0, componentCount = 0, simplifiedComponentCount = 0;
+    double seconds = 0.0, worstPercent = 0.0;
+    int worstMaximum = 0;
+    if (0 == result) {
+        printf("tolerance: %.3f px at %.2fx (%.4f pt), canvas: %ux%u px, spans: %s\n", tolerance, scale, corpus.tolerance, pixelWidth, pixelHeight, CVSSCSpanImplementationName());
+        printf("  %-32s %8s %10s %10s %8s %8s %10s\n", "drawing", "strokes", "components", "simplified", "saved", "max diff", "differing");
+    }
+    for (size_t input = 0; 0 == result && input < inputs.count; ++input) {
+        const char* const path = inputs.paths[input];
+        size_t length = 0;
+        char* const bytes = CVSSCToolReadFile(path, &length);
+        if (NULL == bytes) {
+            fprintf(stderr, "%s: could not be read\n", path);
+            ++failedCount;
+            continue;
+        }
+        CVSSCBitmapClear(&corpus.original, CVSSCBitmapGetPixelRect(&corpus.original));
+        CVSSCBitmapClear(&corpus.simplified, CVSSCBitmapGetPixelRect(&corpus.simplified));
+        corpus.strokeCount = corpus.componentCount = corpus.simplifiedComponentCount = 0;
+        corpus.seconds = 0.0;
+        corpus.failed = false;
+        const bool read = ReadDrawing(&corpus, bytes, length);
+        free(bytes);
+        if (corpus.failed) {
+            fprintf(stderr, "out of memory\n");
+            result = 1;
+            break;
+        }
+        if (!read) {
+            fprintf(stderr, "%s: malformed playback data\n", path);
+            ++failedCount;
+            continue;
+        }
+        int maximum = 0;
+        const size_t differing = CountDifferingPixels(&corpus.original, &corpus.simplified, difference, radius, &maximum);
+        const double differingPercent = 100.0 * (double)differing / ((double)pixelWidth * pixelHeight);
+        const char* const slash = strrchr(path, '/');
+        printf("  %-32s %8zu %10zu %10zu %7.1f%% %8d %9.4f%%%s\n", slash ? slash + 1 : path, corpus.strokeCount, corpus.componentCount, corpus.simplifiedComponentCount,
+               corpus.componentCount ? 100.0 * (1.0 - (double)corpus.simplifiedComponentCount / corpus.componentCount) : 0.0,
+               maximum, differingPercent, differingPercent > percent ? "  EXCEEDS" : "");
+        ++drawingCount;
+        strokeCount += corpus.strokeCount;
+        componentCount += corpus.componentCount;
+        simplifiedComponentCount += corpus.simplifiedComponentCount;
+        seconds += corpus.seconds;
+        worstMaximum = maximum > worstMaximum ? maximum : worstMaximum;
+        worstPercent = differingPercent > worstPercent ? differingPercent : worstPercent;
+    }
+    if (0 == result) {
+        printf("drawings: %zu read, %zu failed\n", drawingCount, failedCount);
+        printf("  components: %zu -> %zu (%.1f%% fewer), %.1f -> %.1f per stroke, %zu -> %zu KB as blobs\n", componentCount, simplifiedComponentCount,
+               componentCount ? 100.0 * (1.0 - (double)simplifiedComponentCount / componentCount) : 0.0,
+               strokeCount ? (double)componentCount / strokeCount : 0.0, strokeCount ? (double)simplifiedComponentCount / strokeCount : 0.0,
+               componentCount * sizeof(CVSSCComponent) / 1024, simplifiedComponentCount * sizeof(CVSSCComponent) / 1024);
+        printf("  simplify: %.0f components/sec, %.1f us/stroke\n", seconds > 0.0 ? componentCount / seconds : 0.0, strokeCount ? 1.0e6 * seconds / strokeCount : 0.0);
+        printf("  visual difference: max %d, worst drawing %.4f%% of pixels differ by more than %d within %d px (limit %.4f%%)\n", worstMaximum, worstPercent, difference, radius, percent);
+        result = failedCount || worstPercent > percent ? 1 : 0;
+    }
+    CVSSCRasterizerDestroy(corpus.rasterizer);
+    free(corpus.components);
+    free(originalPixels);
+    free(simplifiedPixels);
+    PathListDestroy(&inputs);
+    return result;
+}
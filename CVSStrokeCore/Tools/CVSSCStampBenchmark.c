@@ -0,0 +1,308 @@
+// CVSSCStampBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// renders the strokes of recorded playback JSON with each stamped brush (CVSSCStamp) -- the spray paint and the crayon --
+// in place of the brushes they were drawn with, and reports dabs/sec and strokes/sec against the rasterizer stroking the
+// same strokes with a brush of the same width. every drawing is rendered twice with the whole canvas as the clip and once
+// by tiles, and the renderings must be identical: a stamped stroke's dabs do not depend on when or within which clip it
+// is rendered. the checksums of the renderings are printed; the SIMD and scalar (CVSSC_SPAN_SCALAR) builds must print
+// the same checksums.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCStampBenchmark.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCStampBenchmark
+//
+// usage:
+//   CVSSCStampBenchmark [-r repeats] [-w width] [-h height] [-s scale] [-o prefix] playback.json ...
+// -o writes the renderings of the last drawing to <prefix>-spray.png and <prefix>-crayon.png.
+//
+// exits 1 if any renderings of a drawing differ.
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+// FNV-1a
+static uint64_t Checksum(const uint8_t* const pBytes, const size_t pLength) {
+    uint64_t result = 0xCBF29CE484222325ULL;
+    for (size_t idx = 0; idx < pLength; ++idx) {
+        result = (result ^ pBytes[idx]) * 0x100000001B3ULL;
+    }
+    return result;
+}
+
+#pragma mark - Recording
+
+typedef struct {
+    CVSSCColor color;
+    size_t firstComponent;
+    size_t componentCount;
+} Stroke;
+
+typedef struct {
+    Stroke* strokes;
+    size_t strokeCount;
+    size_t strokeCapacity;
+    CVSSCComponent* components;
+    size_t componentCount;
+    size_t componentCapacity;
+} Recording;
+
+static bool ReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    Recording* const recording = pContext;
+    if (CVSSCComponentsAreFill(pStroke->components, pStroke->componentCount)) {
+        return true;
+    }
+    if (recording->strokeCount == recording->strokeCapacity) {
+        const size_t capacity = recording->strokeCapacity ? 2 * recording->strokeCapacity : 256;
+        Stroke* const grown = realloc(recording->strokes, capacity * sizeof(Stroke));
+        if (NULL == grown) {
+            return false;
+        }
+        recording->strokes = grown;
+        recording->strokeCapacity = capacity;
+    }
+    while (recording->componentCount + pStroke->componentCount > recording->componentCapacity) {
+        const size_t capacity = recording->componentCapacity ? 2 * recording->componentCapacity : 4096;
+        CVSSCComponent* const grown = realloc(recording->components, capacity * sizeof(CVSSCComponent));
+        if (NULL == grown) {
+            return false;
+        }
+        recording->components = grown;
+        recording->componentCapacity = capacity;
+    }
+    memcpy(&recording->components[recording->componentCount], pStroke->components, pStroke->componentCount * sizeof(CVSSCComponent));
+    const Stroke stroke = {pStroke->color, recording->componentCount, pStroke->componentCount};
+    recording->strokes[recording->strokeCount++] = stroke;
+    recording->componentCount += pStroke->componentCount;
+    return true;
+}
+
+static bool ReadRecording(const char* const pPath, Recording* const pRecording) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        return false;
+    }
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {pRecording, NULL, ReadStroke};
+    CVSSCPlaybackJSONReader* const reader = CVSSCPlaybackJSONReaderCreate(&callbacks);
+    const bool result = reader && CVSSCPlaybackJSONReaderAppend(reader, bytes, length) && CVSSCPlaybackJSONReaderFinish(reader);
+    CVSSCPlaybackJSONReaderDestroy(reader);
+    free(bytes);
+    return result;
+}
+
+#pragma mark - Rendering
+
+// renders every stroke with the brush, within the clip. the dabs of the strokes are added to *pDabCount.
+static bool RenderStamped(CVSSCStamper* const pStamper, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCBrushAttributes* const pBrush, const Recording* const pRecording, size_t* const pDabCount) {
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        const Stroke* const stroke = &pRecording->strokes[idx];
+        if (!CVSSCStamperRenderStroke(pStamper, pBitmap, pTransform, pClip, pBrush, stroke->color, &pRecording->components[stroke->firstComponent], stroke->componentCount)) {
+            return false;
+        }
+        *pDabCount += CVSSCStamperGetDabCount(pStamper);
+    }
+    return true;
+}
+
+static bool RenderStroked(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCBrushAttributes* const pBrush, const Recording* const pRecording) {
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        const Stroke* const stroke = &pRecording->strokes[idx];
+        if (!CVSSCRasterizerRenderStroke(pRasterizer, pBitmap, pTransform, CVSSCBitmapGetPixelRect(pBitmap), pBrush, stroke->color, &pRecording->components[stroke->firstComponent], stroke->componentCount)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#pragma mark - Benchmark
+
+typedef struct {
+    size_t strokeCount;
+    size_t dabCount;
+    double stampSeconds;
+    double strokeSeconds;
+} BrushTotals;
+
+static const CVSSCBrushType kStampedBrushTypes[] = {CVSSCBrushTypeSpraypaint, CVSSCBrushTypeCrayon};
+static const char* const kStampedBrushNames[] = {"spray", "crayon"};
+enum { StampedBrushCount = 2 };
+
+static int Benchmark(const char* const pPath, const int pRepeats, const uint32_t pWidth, const uint32_t pHeight, const double pScale, const char* const pOutputPrefix, BrushTotals* const pTotals) {
+    Recording recording;
+    memset(&recording, 0, sizeof(recording));
+    if (!ReadRecording(pPath, &recording)) {
+        fprintf(stderr, "%s: could not be read\n", pPath);
+        free(recording.strokes);
+        free(recording.components);
+        return 1;
+    }
+    const uint32_t width = (uint32_t)(pWidth * pScale + 0.5);
+    const uint32_t height = (uint32_t)(pHeight * pScale + 0.5);
+    const size_t length = 4 * (size_t)width * height;
+    uint8_t* const pixels = malloc(length);
+    uint8_t* const again = malloc(length);
+    uint8_t* const tiled = malloc(length);
+    CVSSCStamper* const stamper = CVSSCStamperCreate();
+    CVSSCRasterizer* const rasterizer = CVSSCRasterizerCreate();
+    int result = 0;
+    if (!pixels || !again || !tiled || !stamper || !rasterizer) {
+        fprintf(stderr, "out of memory\n");
+        result = 1;
+    }
+    const CVSSCBitmap bitmap = CVSSCBitmapMake(pixels, width, height, 4 * (size_t)width);
+    const CVSSCBitmap againBitmap = CVSSCBitmapMake(again, width, height, 4 * (size_t)width);
+    const CVSSCBitmap tiledBitmap = CVSSCBitmapMake(tiled, width, height, 4 * (size_t)width);
+    const CVSSCTransform transform = CVSSCTransformMake(pScale, 0.0, 0.0, pScale, 0.0, 0.0);
+    const CVSSCColor white = {1.0, 1.0, 1.0, 1.0};
+    for (int brushIdx = 0; 0 == result && brushIdx < StampedBrushCount; ++brushIdx) {
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(kStampedBrushTypes[brushIdx]);
+        BrushTotals* const totals = &pTotals[brushIdx];
+
+        // timed: the whole canvas as the clip
+        for (int repeat = 0; 0 == result && repeat < pRepeats; ++repeat) {
+            CVSSCBitmapFill(&bitmap, CVSSCBitmapGetPixelRect(&bitmap), white);
+            size_t dabCount = 0;
+            const double start = Now();
+            if (!RenderStamped(stamper, &bitmap, &transform, CVSSCBitmapGetPixelRect(&bitmap), brush, &recording, &dabCount)) {
+                fprintf(stderr, "out of memory\n");
+                result = 1;
+            }
+            totals->stampSeconds += Now() - start;
+            totals->dabCount += dabCount;
+            totals->strokeCount += recording.strokeCount;
+        }
+
+        // the rasterizer, stroking with a brush of the same width and alpha
+        CVSSCBrushAttributes stroked = *brush;
+        stroked.stamp = CVSSCBrushStampNone;
+        for (int repeat = 0; 0 == result && repeat < pRepeats; ++repeat) {
+            CVSSCBitmapFill(&againBitmap, CVSSCBitmapGetPixelRect(&againBitmap), white);
+            const double start = Now();
+            if (!RenderStroked(rasterizer, &againBitmap, &transform, &stroked, &recording)) {
+                fprintf(stderr, "out of memory\n");
+                result = 1;
+            }
+            totals->strokeSeconds += Now() - start;
+        }
+
+        // again with a new stamper, and by tiles: every tile renders every stroke within the tile's clip
+        CVSSCStamper* const fresh = CVSSCStamperCreate();
+        size_t ignored = 0;
+        CVSSCBitmapFill(&againBitmap, CVSSCBitmapGetPixelRect(&againBitmap), white);
+        CVSSCBitmapFill(&tiledBitmap, CVSSCBitmapGetPixelRect(&tiledBitmap), white);
+        bool rendered = 0 == result && fresh && RenderStamped(fresh, &againBitmap, &transform, CVSSCBitmapGetPixelRect(&againBitmap), brush, &recording, &ignored);
+        const int32_t tileSize = 100;
+        for (int32_t y = 0; rendered && y < (int32_t)height; y += tileSize) {
+            for (int32_t x = 0; rendered && x < (int32_t)width; x += tileSize) {
+                const CVSSCPixelRect tile = {x, y, x + tileSize, y + tileSize};
+                rendered = RenderStamped(stamper, &tiledBitmap, &transform, tile, brush, &recording, &ignored);
+            }
+        }
+        CVSSCStamperDestroy(fresh);
+        if (0 == result && !rendered) {
+            fprintf(stderr, "out of memory\n");
+            result = 1;
+        }
+        if (0 == result) {
+            const uint64_t checksum = Checksum(pixels, length);
+            printf("%s %s: %016llx\n", pPath, kStampedBrushNames[brushIdx], (unsigned long long)checksum);
+            if (0 != memcmp(pixels, again, length)) {
+                fprintf(stderr, "%s %s: the renderings of two stampers differ\n", pPath, kStampedBrushNames[brushIdx]);
+                result = 1;
+            }
+            if (0 != memcmp(pixels, tiled, length)) {
+                fprintf(stderr, "%s %s: the rendering by tiles differs\n", pPath, kStampedBrushNames[brushIdx]);
+                result = 1;
+            }
+        }
+        if (0 == result && pOutputPrefix) {
+            char path[1024];
+            snprintf(path, sizeof(path), "%s-%s.png", pOutputPrefix, kStampedBrushNames[brushIdx]);
+            if (!CVSSCToolWritePNG(path, &bitmap, 6)) {
+                fprintf(stderr, "%s: could not be written\n", path);
+                result = 1;
+            }
+        }
+    }
+    CVSSCRasterizerDestroy(rasterizer);
+    CVSSCStamperDestroy(stamper);
+    free(tiled);
+    free(again);
+    free(pixels);
+    free(recording.strokes);
+    free(recording.components);
+    return result;
+}
+
+#pragma mark - Main
+
+static int Usage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-r repeats] [-w width] [-h height] [-s scale] [-o prefix] playback.json ...\n", pName);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    int repeats = 3;
+    uint32_t width = 768;
+    uint32_t height = 1024;
+    double scale = 2.0;
+    const char* outputPrefix = NULL;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-r") && idx + 1 < argc) {
+            repeats = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            scale = atof(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-o") && idx + 1 < argc) {
+            outputPrefix = argv[++idx];
+        }
+        else {
+            return Usage(argv[0]);
+        }
+    }
+    if (idx == argc || 0 >= repeats || 0 == width || 0 == height || !(scale > 0.0)) {
+        return Usage(argv[0]);
+    }
+    BrushTotals totals[StampedBrushCount];
+    memset(totals, 0, sizeof(totals));
+    for (; idx < argc; ++idx) {
+        if (0 != Benchmark(argv[idx], repeats, width, height, scale, outputPrefix, totals)) {
+            return 1;
+        }
+    }
+    printf("scale: %.1f spans: %s\n", scale, CVSSCSpanImplementationName());
+    for (int brushIdx = 0; brushIdx < StampedBrushCount; ++brushIdx) {
+        const BrushTotals* const at = &totals[brushIdx];
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(kStampedBrushTypes[brushIdx]);
+        printf("  %-7s (%4.1f pt): %8.2f Mdabs/sec %8.0f strokes/sec %6.1f dabs/stroke -- stroked: %8.0f strokes/sec\n",
+               kStampedBrushNames[brushIdx], brush->lineWidth,
+               (double)at->dabCount * 1.0e-6 / at->stampSeconds,
+               (double)at->strokeCount / at->stampSeconds,
+               (double)at->dabCount / (double)at->strokeCount,
+               (double)at->strokeCount / at->strokeSeconds);
+    }
+    return 0;
+}
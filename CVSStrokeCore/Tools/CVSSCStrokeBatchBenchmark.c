@@ -0,0 +1,413 @@
+// CVSSCStrokeBatchBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// measures state-sorted batching (CVSSCStrokeBatch): rendering runs of consecutive strokes of the same brush and color as
+// one path, as CVSStrokeRenderer does, against rendering each stroke as its own path. verifies that merging is safe where
+// CVSSCStrokeBatchMayMerge allows it, and shows that it is not where the paint is translucent.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCStrokeBatchBenchmark.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCStrokeBatchBenchmark
+//
+// usage:
+//   CVSSCStrokeBatchBenchmark [-i iterations] [-w width] [-h height] [-s scale] playback...
+//
+// each playback file is JSON or binary (the format is detected). its strokes are rendered into a width x height (points)
+// canvas at scale pixels per point with the software rasterizer: one path per stroke, then one path per batch. reports the
+// paths submitted and ms/drawing of each, and the pixels of the drawing which differ.
+//
+// then each batch of two or more strokes is rendered over a patterned background both ways, within its bounds. a merged
+// batch may differ only where the antialiased edges of its strokes overlap: a pixel which the merged path fully covers (or
+// does not cover) must be identical. the differences at the edges are reported. the same is done for the runs of
+// translucent strokes (same brush and color) which are not merged, to show what merging them would change. exits 1 if a
+// merged batch differs at a pixel it fully covers, or does not cover.
+
+#define _XOPEN_SOURCE 700
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+#pragma mark - Runs
+
+// consecutive strokes [first, first + count)
+typedef struct {
+    size_t first;
+    size_t count;
+} Run;
+
+typedef struct {
+    Run* runs;
+    size_t count;
+} Runs;
+
+static bool IsFill(const CVSSCToolRecording* const pRecording, const CVSSCToolRecordedStroke* const pStroke) {
+    return CVSSCComponentsAreFill(&pRecording->components[pStroke->firstComponent], pStroke->componentCount);
+}
+
+// the batches of the strokes, as CVSStrokeRenderer forms them. a stroke which may not be merged is a batch of one.
+static bool MakeBatches(const CVSSCToolRecording* const pRecording, Runs* const pOutBatches) {
+    pOutBatches->runs = malloc((pRecording->strokeCount + 1) * sizeof(Run));
+    pOutBatches->count = 0;
+    if (NULL == pOutBatches->runs) {
+        return false;
+    }
+    CVSSCStrokeBatch batch = CVSSCStrokeBatchMakeEmpty();
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[idx];
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(stroke->brushType);
+        const bool isStroked = !IsFill(pRecording, stroke);
+        if (isStroked && batch.count && CVSSCStrokeBatchAddStroke(&batch, brush, stroke->color, stroke->bounds)) {
+            pOutBatches->runs[pOutBatches->count - 1].count = batch.count;
+            continue;
+        }
+        // the stroke begins a batch. a batch which it may not join is left empty, so the next stroke begins another.
+        batch = CVSSCStrokeBatchMakeEmpty();
+        if (isStroked) {
+            CVSSCStrokeBatchAddStroke(&batch, brush, stroke->color, stroke->bounds);
+        }
+        pOutBatches->runs[pOutBatches->count++] = (Run){idx, 1};
+    }
+    return true;
+}
+
+// the runs of two or more strokes which batching refuses because their paint is translucent: consecutive strokes of the
+// same stroked brush and color, within the batch's count and sparseness limits
+static bool MakeTranslucentRuns(const CVSSCToolRecording* const pRecording, Runs* const pOutRuns) {
+    pOutRuns->runs = malloc((pRecording->strokeCount + 1) * sizeof(Run));
+    pOutRuns->count = 0;
+    if (NULL == pOutRuns->runs) {
+        return false;
+    }
+    Run run = {0, 0};
+    CVSSCRect bounds = CVSSCRectNull();
+    double strokesArea = 0.0;
+    for (size_t idx = 0; idx <= pRecording->strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const stroke = idx < pRecording->strokeCount ? &pRecording->strokes[idx] : NULL;
+        const CVSSCBrushAttributes* const brush = stroke ? CVSSCBrushAttributesForBrushType(stroke->brushType) : NULL;
+        const bool isCandidate = stroke && !IsFill(pRecording, stroke) && !CVSSCRectIsNull(stroke->bounds)
+            && CVSSCBrushStampNone == brush->stamp && !CVSSCStrokeBatchMayMerge(brush, stroke->color);
+        if (isCandidate && run.count) {
+            const CVSSCToolRecordedStroke* const first = &pRecording->strokes[run.first];
+            const CVSSCRect unionBounds = CVSSCRectUnion(bounds, stroke->bounds);
+            const double area = strokesArea + stroke->bounds.width * stroke->bounds.height;
+            if (first->brushType == stroke->brushType && 0 == memcmp(&first->color, &stroke->color, sizeof(CVSSCColor))
+                && run.count < CVSSCStrokeBatchMaximumStrokeCount && unionBounds.width * unionBounds.height <= CVSSCStrokeBatchMaximumSparseness * area) {
+                ++run.count;
+                bounds = unionBounds;
+                strokesArea = area;
+                continue;
+            }
+        }
+        if (1 < run.count) {
+            pOutRuns->runs[pOutRuns->count++] = run;
+        }
+        run = (Run){idx, isCandidate ? 1 : 0};
+        bounds = isCandidate ? stroke->bounds : CVSSCRectNull();
+        strokesArea = isCandidate ? stroke->bounds.width * stroke->bounds.height : 0.0;
+    }
+    return true;
+}
+
+#pragma mark - Rendering
+
+enum { MaximumRunStrokeCount = CVSSCStrokeBatchMaximumStrokeCount };
+
+static bool RenderStroke(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCToolRecording* const pRecording, const size_t pIndex) {
+    const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[pIndex];
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(stroke->brushType);
+    return CVSSCRasterizerRenderStroke(pRasterizer, pBitmap, pTransform, pClip, brush, stroke->color, &pRecording->components[stroke->firstComponent], stroke->componentCount);
+}
+
+// renders the run's strokes as one path, with the brush and color of its first stroke
+static bool RenderRunMerged(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCToolRecording* const pRecording, const Run pRun, const CVSSCBrushAttributes* const pBrush, const CVSSCColor pColor) {
+    assert(pRun.count <= MaximumRunStrokeCount);
+    const CVSSCComponent* components[MaximumRunStrokeCount];
+    size_t counts[MaximumRunStrokeCount];
+    for (size_t idx = 0; idx < pRun.count; ++idx) {
+        const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[pRun.first + idx];
+        components[idx] = &pRecording->components[stroke->firstComponent];
+        counts[idx] = stroke->componentCount;
+    }
+    return CVSSCRasterizerRenderStrokes(pRasterizer, pBitmap, pTransform, pClip, pBrush, pColor, components, counts, pRun.count);
+}
+
+static bool RenderRunSerially(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCPixelRect pClip, const CVSSCToolRecording* const pRecording, const Run pRun) {
+    for (size_t idx = 0; idx < pRun.count; ++idx) {
+        if (!RenderStroke(pRasterizer, pBitmap, pTransform, pClip, pRecording, pRun.first + idx)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool RenderBatches(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCToolRecording* const pRecording, const Runs* const pBatches) {
+    const CVSSCPixelRect clip = CVSSCBitmapGetPixelRect(pBitmap);
+    for (size_t idx = 0; idx < pBatches->count; ++idx) {
+        const Run batch = pBatches->runs[idx];
+        const CVSSCToolRecordedStroke* const first = &pRecording->strokes[batch.first];
+        const bool rendered = 1 == batch.count
+            ? RenderStroke(pRasterizer, pBitmap, pTransform, clip, pRecording, batch.first)
+            : RenderRunMerged(pRasterizer, pBitmap, pTransform, clip, pRecording, batch, CVSSCBrushAttributesForBrushType(first->brushType), first->color);
+        if (!rendered) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#pragma mark - Verification
+
+typedef struct {
+    size_t runCount;
+    // pixels the merged path covers partially, and those of them which differ from the serial rendering
+    size_t edgePixelCount;
+    size_t differingEdgePixelCount;
+    int maximumEdgeDifference;
+    // pixels the merged path fully covers or does not cover which differ from the serial rendering
+    size_t differingSolidPixelCount;
+} Comparison;
+
+// an opaque pattern, so that painting and clearing both change the pixels
+static void FillBackground(const CVSSCBitmap* const pBitmap, const CVSSCPixelRect pRect) {
+    for (int32_t y = pRect.minY; y < pRect.maxY; ++y) {
+        uint8_t* pixel = CVSSCBitmapGetPixel(pBitmap, (uint32_t)pRect.minX, (uint32_t)y);
+        for (int32_t x = pRect.minX; x < pRect.maxX; ++x, pixel += 4) {
+            pixel[0] = (uint8_t)(x * 7 + y * 3);
+            pixel[1] = (uint8_t)(x * 2 + y * 11);
+            pixel[2] = (uint8_t)((x ^ y) * 5);
+            pixel[3] = 255;
+        }
+    }
+}
+
+// renders the run over the background serially and merged, and its merged coverage, and compares them within its bounds
+static bool CompareRun(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pSerial, const CVSSCBitmap* const pMerged, const CVSSCBitmap* const pCoverage, const CVSSCTransform* const pTransform, const CVSSCToolRecording* const pRecording, const Run pRun, Comparison* const pComparison) {
+    CVSSCRect bounds = CVSSCRectNull();
+    for (size_t idx = 0; idx < pRun.count; ++idx) {
+        bounds = CVSSCRectUnion(bounds, pRecording->strokes[pRun.first + idx].bounds);
+    }
+    const double scale = CVSSCTransformGetScale(pTransform);
+    const CVSSCPixelRect boundsRect = {
+        (int32_t)floor(bounds.x * scale) - 2,
+        (int32_t)floor(bounds.y * scale) - 2,
+        (int32_t)ceil((bounds.x + bounds.width) * scale) + 2,
+        (int32_t)ceil((bounds.y + bounds.height) * scale) + 2
+    };
+    const CVSSCPixelRect rect = CVSSCPixelRectIntersection(boundsRect, CVSSCBitmapGetPixelRect(pSerial));
+    if (CVSSCPixelRectIsEmpty(rect)) {
+        return true;
+    }
+    const CVSSCToolRecordedStroke* const first = &pRecording->strokes[pRun.first];
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(first->brushType);
+    // the coverage is the alpha of opaque white painted with the brush's geometry
+    CVSSCBrushAttributes coverageBrush = *brush;
+    coverageBrush.alpha = 1.0;
+    coverageBrush.clears = false;
+    const CVSSCColor white = {1.0, 1.0, 1.0, 1.0};
+    FillBackground(pSerial, rect);
+    FillBackground(pMerged, rect);
+    CVSSCBitmapClear(pCoverage, rect);
+    if (!RenderRunSerially(pRasterizer, pSerial, pTransform, rect, pRecording, pRun)
+        || !RenderRunMerged(pRasterizer, pMerged, pTransform, rect, pRecording, pRun, brush, first->color)
+        || !RenderRunMerged(pRasterizer, pCoverage, pTransform, rect, pRecording, pRun, &coverageBrush, white)) {
+        return false;
+    }
+    ++pComparison->runCount;
+    for (int32_t y = rect.minY; y < rect.maxY; ++y) {
+        const uint8_t* serial = CVSSCBitmapGetPixel(pSerial, (uint32_t)rect.minX, (uint32_t)y);
+        const uint8_t* merged = CVSSCBitmapGetPixel(pMerged, (uint32_t)rect.minX, (uint32_t)y);
+        const uint8_t* coverage = CVSSCBitmapGetPixel(pCoverage, (uint32_t)rect.minX, (uint32_t)y);
+        for (int32_t x = rect.minX; x < rect.maxX; ++x, serial += 4, merged += 4, coverage += 4) {
+            int difference = 0;
+            for (int channel = 0; channel < 4; ++channel) {
+                const int at = abs((int)serial[channel] - (int)merged[channel]);
+                difference = at > difference ? at : difference;
+            }
+            const bool isEdge = 0 < coverage[3] && coverage[3] < 255;
+            if (isEdge) {
+                ++pComparison->edgePixelCount;
+                if (difference) {
+                    ++pComparison->differingEdgePixelCount;
+                    pComparison->maximumEdgeDifference = difference > pComparison->maximumEdgeDifference ? difference : pComparison->maximumEdgeDifference;
+                }
+            }
+            else if (difference) {
+                ++pComparison->differingSolidPixelCount;
+            }
+        }
+    }
+    return true;
+}
+
+static bool CompareRuns(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pSerial, const CVSSCBitmap* const pMerged, const CVSSCBitmap* const pCoverage, const CVSSCTransform* const pTransform, const CVSSCToolRecording* const pRecording, const Runs* const pRuns, Comparison* const pComparison) {
+    memset(pComparison, 0, sizeof(Comparison));
+    for (size_t idx = 0; idx < pRuns->count; ++idx) {
+        if (1 < pRuns->runs[idx].count && !CompareRun(pRasterizer, pSerial, pMerged, pCoverage, pTransform, pRecording, pRuns->runs[idx], pComparison)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void PrintComparison(const char* const pName, const Comparison* const pComparison) {
+    printf("  %s: %zu runs, %zu edge px (%zu differ, by at most %d), %zu covered or uncovered px differ\n", pName, pComparison->runCount,
+           pComparison->edgePixelCount, pComparison->differingEdgePixelCount, pComparison->maximumEdgeDifference, pComparison->differingSolidPixelCount);
+}
+
+#pragma mark - Benchmark
+
+static int Benchmark(const char* const pPath, const int pIterations, const uint32_t pWidth, const uint32_t pHeight, const double pScale) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        fprintf(stderr, "%s: could not be read\n", pPath);
+        return 1;
+    }
+    CVSSCToolRecording recording;
+    memset(&recording, 0, sizeof(recording));
+    const bool read = CVSSCToolReadRecording(bytes, length, &recording);
+    free(bytes);
+    if (!read) {
+        fprintf(stderr, "%s: malformed playback data\n", pPath);
+        CVSSCToolRecordingFree(&recording);
+        return 1;
+    }
+
+    const uint32_t width = (uint32_t)(pWidth * pScale + 0.5);
+    const uint32_t height = (uint32_t)(pHeight * pScale + 0.5);
+    const size_t pixelsLength = 4 * (size_t)width * height;
+    uint8_t* const serialPixels = malloc(pixelsLength);
+    uint8_t* const batchedPixels = malloc(pixelsLength);
+    uint8_t* const coveragePixels = malloc(pixelsLength);
+    CVSSCRasterizer* const rasterizer = CVSSCRasterizerCreate();
+    Runs batches = {NULL, 0};
+    Runs translucentRuns = {NULL, 0};
+    int result = serialPixels && batchedPixels && coveragePixels && rasterizer && MakeBatches(&recording, &batches) && MakeTranslucentRuns(&recording, &translucentRuns) ? 0 : 1;
+    if (0 != result) {
+        fprintf(stderr, "out of memory\n");
+    }
+
+    // the canvas is in points with its origin at the top left, as the playback view's is
+    const CVSSCTransform transform = CVSSCTransformMake(pScale, 0.0, 0.0, pScale, 0.0, 0.0);
+    const CVSSCBitmap serial = CVSSCBitmapMake(serialPixels, width, height, 4 * (size_t)width);
+    const CVSSCBitmap batched = CVSSCBitmapMake(batchedPixels, width, height, 4 * (size_t)width);
+    const CVSSCBitmap coverage = CVSSCBitmapMake(coveragePixels, width, height, 4 * (size_t)width);
+    const CVSSCPixelRect canvas = CVSSCBitmapGetPixelRect(&serial);
+    double serialSeconds = 0.0;
+    double batchedSeconds = 0.0;
+    for (int idx = 0; 0 == result && idx < pIterations; ++idx) {
+        CVSSCBitmapClear(&serial, canvas);
+        double start = Now();
+        for (size_t stroke = 0; 0 == result && stroke < recording.strokeCount; ++stroke) {
+            result = RenderStroke(rasterizer, &serial, &transform, canvas, &recording, stroke) ? 0 : 1;
+        }
+        serialSeconds += Now() - start;
+        CVSSCBitmapClear(&batched, canvas);
+        start = Now();
+        result = 0 == result && RenderBatches(rasterizer, &batched, &transform, &recording, &batches) ? 0 : 1;
+        batchedSeconds += Now() - start;
+        if (0 != result) {
+            fprintf(stderr, "out of memory\n");
+        }
+    }
+    if (0 == result) {
+        size_t differingPixelCount = 0;
+        for (size_t idx = 0; idx < pixelsLength; idx += 4) {
+            differingPixelCount += 0 != memcmp(&serialPixels[idx], &batchedPixels[idx], 4);
+        }
+        size_t mergedStrokeCount = 0;
+        size_t mergedBatchCount = 0;
+        for (size_t idx = 0; idx < batches.count; ++idx) {
+            if (1 < batches.runs[idx].count) {
+                mergedStrokeCount += batches.runs[idx].count;
+                ++mergedBatchCount;
+            }
+        }
+        printf("%s\n", pPath);
+        printf("  strokes: %zu components: %zu canvas: %ux%u px iterations: %d\n", recording.strokeCount, recording.componentCount, width, height, pIterations);
+        printf("  merged: %zu strokes (%.1f%%) in %zu batches, %.2f strokes/batch\n", mergedStrokeCount, recording.strokeCount ? 100.0 * mergedStrokeCount / recording.strokeCount : 0.0,
+               mergedBatchCount, mergedBatchCount ? (double)mergedStrokeCount / mergedBatchCount : 0.0);
+        printf("  by stroke: %6zu paths %8.3f ms/drawing\n", recording.strokeCount, 1.0e3 * serialSeconds / pIterations);
+        printf("  by batch:  %6zu paths %8.3f ms/drawing %6.2fx, %zu px differ\n", batches.count, 1.0e3 * batchedSeconds / pIterations,
+               batchedSeconds > 0.0 ? serialSeconds / batchedSeconds : 0.0, differingPixelCount);
+    }
+
+    // the comparisons reuse the renderings' bitmaps
+    Comparison merged, translucent;
+    if (0 == result && (!CompareRuns(rasterizer, &serial, &batched, &coverage, &transform, &recording, &batches, &merged)
+                        || !CompareRuns(rasterizer, &serial, &batched, &coverage, &transform, &recording, &translucentRuns, &translucent))) {
+        fprintf(stderr, "out of memory\n");
+        result = 1;
+    }
+    if (0 == result) {
+        PrintComparison("merged batches", &merged);
+        PrintComparison("translucent runs, if merged", &translucent);
+        if (merged.differingSolidPixelCount) {
+            printf("  MERGED BATCHES DIFFER FROM SERIAL RENDERING AWAY FROM THEIR EDGES\n");
+            result = 1;
+        }
+    }
+
+    CVSSCRasterizerDestroy(rasterizer);
+    free(batches.runs);
+    free(translucentRuns.runs);
+    free(serialPixels);
+    free(batchedPixels);
+    free(coveragePixels);
+    CVSSCToolRecordingFree(&recording);
+    return result;
+}
+
+#pragma mark - Main
+
+static int Usage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-i iterations] [-w width] [-h height] [-s scale] playback...\n", pName);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 5;
+    uint32_t width = 768;
+    uint32_t height = 1024;
+    double scale = 2.0;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-i") && idx + 1 < argc) {
+            iterations = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            scale = atof(argv[++idx]);
+        }
+        else {
+            return Usage(argv[0]);
+        }
+    }
+    if (idx == argc || 0 >= iterations || 0 == width || 0 == height || !(scale > 0.0)) {
+        return Usage(argv[0]);
+    }
+    int result = 0;
+    for (; idx < argc; ++idx) {
+        result |= Benchmark(argv[idx], iterations, width, height, scale);
+    }
+    return result;
+}
@@ -0,0 +1,381 @@
+// CVSSCStrokeJournalCheck.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// journals the strokes of a drawing as CVSStrokeManager does (CVSSCStrokeJournal), reports the cost of committing a stroke
+// early and late in the drawing, and verifies that the journal survives a crash at any point.
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCStrokeJournalCheck.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCStrokeJournalCheck
+//
+// usage:
+//   CVSSCStrokeJournalCheck [-o journal] [-d delay] [-c corruptions] playback
+//
+// the playback file is JSON or binary (the format is detected). its strokes are appended to the journal (default
+// ./CVSSCStrokeJournalCheck.journal), with an undo and a redo after every tenth stroke, each record encoded and written
+// with write(2) -- and a Color record before the first stroke of each color. the file is synchronized (fsync) when delay ms (default 500) have passed since the last
+// synchronization, as CVSStrokeJournal batches them. then the journal is read back, and it is read cut short at every
+// offset within its last three records and at 1000 more offsets (the tail of a crash), and with corruptions (default 1000)
+// random octets changed: every read must deliver exactly the intact records before the damage. it is also read in two
+// parts which share the palette (as a replay to a mark), and a record of the format which predates the palette is read.
+// exits 1 if any read does not deliver what was written.
+
+#define _XOPEN_SOURCE 700
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+// a deterministic generator, so that failures may be reproduced
+static uint32_t Random(uint32_t* const pState) {
+    *pState = *pState * 1664525u + 1013904223u;
+    return *pState >> 8;
+}
+
+#pragma mark - Journal
+
+// a record as it was written
+typedef struct {
+    CVSSCStrokeJournalRecordType type;
+    // PaletteStroke: the index of the recorded stroke
+    size_t stroke;
+    // the offset of the end of the record
+    size_t end;
+} WrittenRecord;
+
+// compares what is read with what was written
+typedef struct {
+    const CVSSCToolRecording* recording;
+    const WrittenRecord* records;
+    size_t recordCount;
+    size_t readCount;
+    bool failed;
+} Verification;
+
+static bool IsEqualStroke(const CVSSCToolRecording* const pRecording, const size_t pIndex, const CVSSCPlaybackStroke* const pStroke) {
+    const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[pIndex];
+    if (stroke->brushType != pStroke->brushType || stroke->componentCount != pStroke->componentCount
+        || 0 != memcmp(&stroke->color, &pStroke->color, sizeof(CVSSCColor))) {
+        return false;
+    }
+    for (size_t idx = 0; idx < stroke->componentCount; ++idx) {
+        if (!CVSSCComponentIsEqual(&pRecording->components[stroke->firstComponent + idx], &pStroke->components[idx])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Color records are not delivered
+static void VerificationSkipColors(Verification* const pVerification, const size_t pCount) {
+    while (pVerification->readCount < pCount && CVSSCStrokeJournalRecordColor == pVerification->records[pVerification->readCount].type) {
+        ++pVerification->readCount;
+    }
+}
+
+static bool VerificationReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    Verification* const verification = pContext;
+    VerificationSkipColors(verification, verification->recordCount);
+    const WrittenRecord* const record = verification->readCount < verification->recordCount ? &verification->records[verification->readCount] : NULL;
+    if (!record || CVSSCStrokeJournalRecordPaletteStroke != record->type || !IsEqualStroke(verification->recording, record->stroke, pStroke)) {
+        verification->failed = true;
+        return false;
+    }
+    ++verification->readCount;
+    return true;
+}
+
+static bool VerificationReadEvent(void* const pContext, const CVSSCStrokeJournalRecordType pType, const uint32_t pValue) {
+    Verification* const verification = pContext;
+    VerificationSkipColors(verification, verification->recordCount);
+    const WrittenRecord* const record = verification->readCount < verification->recordCount ? &verification->records[verification->readCount] : NULL;
+    if (!record || pType != record->type || 0 != pValue) {
+        verification->failed = true;
+        return false;
+    }
+    ++verification->readCount;
+    return true;
+}
+
+// reads the journal, which has been damaged from pDamageOffset on. returns true if exactly the records before the damage were read.
+// if pSplit is not 0 (the end of an intact record), the records after it are read separately, continuing the palette.
+static bool Verify(const void* const pJournal, const size_t pLength, const size_t pDamageOffset, const size_t pSplit, CVSSCPalette* const pPalette, const CVSSCToolRecording* const pRecording, const WrittenRecord* const pRecords, const size_t pRecordCount) {
+    Verification verification = {pRecording, pRecords, pRecordCount, 0, false};
+    const CVSSCStrokeJournalCallbacks callbacks = {&verification, VerificationReadStroke, VerificationReadEvent};
+    size_t validLength = 0;
+    CVSSCStrokeJournalStatus status = CVSSCStrokeJournalRead(pJournal, pSplit ? pSplit : pLength, &callbacks, pPalette, &validLength);
+    if (pSplit && CVSSCStrokeJournalStatusComplete == status) {
+        status = CVSSCStrokeJournalReadRecords(pJournal, pLength, validLength, &callbacks, pPalette, &validLength);
+    }
+    if (pDamageOffset < CVSSCStrokeJournalHeaderLength) {
+        // a damaged header is not a journal, unless the damage did not change it
+        return CVSSCStrokeJournalStatusMalformed == status || (!verification.failed && CVSSCStrokeJournalStatusCancelled != status);
+    }
+    // the intact records are those which end at or before the damage
+    size_t intactCount = 0;
+    while (intactCount < pRecordCount && pRecords[intactCount].end <= pDamageOffset) {
+        ++intactCount;
+    }
+    const size_t intactLength = intactCount ? pRecords[intactCount - 1].end : CVSSCStrokeJournalHeaderLength;
+    if (verification.failed || (CVSSCStrokeJournalStatusComplete != status && CVSSCStrokeJournalStatusTruncated != status)) {
+        return false;
+    }
+    VerificationSkipColors(&verification, intactCount);
+    const CVSSCStrokeJournalStatus intactStatus = intactLength == pLength ? CVSSCStrokeJournalStatusComplete : CVSSCStrokeJournalStatusTruncated;
+    return intactStatus == status && intactCount == verification.readCount && intactLength == validLength;
+}
+
+// writes a journal of one Stroke record, as journals did before the palette (the color in the record), and reads it
+static bool VerifyLegacyStrokeRecord(const CVSSCToolRecording* const pRecording, CVSSCPalette* const pPalette) {
+    const CVSSCToolRecordedStroke* const recorded = &pRecording->strokes[0];
+    const size_t blobLength = CVSSCComponentBlobLength(recorded->componentCount);
+    const size_t bodyLength = 8 + 4 * sizeof(double) + blobLength;
+    // 8 byte aligned, as the journal's bytes are
+    double* const storage = calloc((CVSSCStrokeJournalHeaderLength + 8 + bodyLength) / sizeof(double) + 1, sizeof(double));
+    if (!storage) {
+        return false;
+    }
+    uint8_t* const journal = (uint8_t*)storage;
+    CVSSCStrokeJournalWriteHeader(journal);
+    uint8_t* const body = journal + CVSSCStrokeJournalHeaderLength + 8;
+    const uint32_t fields[2] = {CVSSCStrokeJournalRecordStroke, recorded->brushType};
+    const double color[4] = {recorded->color.red, recorded->color.green, recorded->color.blue, recorded->color.alpha};
+    memcpy(body, fields, sizeof(fields));
+    memcpy(body + sizeof(fields), color, sizeof(color));
+    CVSSCComponentBlobWrite(body + sizeof(fields) + sizeof(color), &pRecording->components[recorded->firstComponent], recorded->componentCount);
+    const uint32_t header[2] = {(uint32_t)bodyLength, (uint32_t)crc32(crc32(0L, Z_NULL, 0), body, (uInt)bodyLength)};
+    memcpy(journal + CVSSCStrokeJournalHeaderLength, header, sizeof(header));
+    // read as the PaletteStroke which the journal writes now
+    const WrittenRecord record = {CVSSCStrokeJournalRecordPaletteStroke, 0, CVSSCStrokeJournalHeaderLength + 8 + bodyLength};
+    const bool result = Verify(journal, record.end, record.end, 0, pPalette, pRecording, &record, 1);
+    free(storage);
+    return result;
+}
+
+#pragma mark -
+
+static void PrintUsage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-o journal] [-d delay] [-c corruptions] playback\n", pName);
+}
+
+int main(int argc, char** argv) {
+    const char* journalPath = "CVSSCStrokeJournalCheck.journal";
+    double delay = 0.5;
+    int corruptionCount = 1000;
+    const char* playbackPath = NULL;
+    for (int idx = 1; idx < argc; ++idx) {
+        if (0 == strcmp(argv[idx], "-o") && idx + 1 < argc) {
+            journalPath = argv[++idx];
+        } else if (0 == strcmp(argv[idx], "-d") && idx + 1 < argc) {
+            delay = atof(argv[++idx]) * 1.0e-3;
+        } else if (0 == strcmp(argv[idx], "-c") && idx + 1 < argc) {
+            corruptionCount = atoi(argv[++idx]);
+        } else if ('-' != argv[idx][0] && NULL == playbackPath) {
+            playbackPath = argv[idx];
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (NULL == playbackPath) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    size_t playbackLength = 0;
+    char* const playback = CVSSCToolReadFile(playbackPath, &playbackLength);
+    CVSSCToolRecording recording = {0};
+    if (NULL == playback || !CVSSCToolReadRecording(playback, playbackLength, &recording) || 0 == recording.strokeCount) {
+        fprintf(stderr, "could not read strokes from %s\n", playbackPath);
+        return 1;
+    }
+    free(playback);
+
+    // write
+    const int descriptor = open(journalPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (-1 == descriptor) {
+        fprintf(stderr, "could not create %s\n", journalPath);
+        return 1;
+    }
+    uint8_t header[CVSSCStrokeJournalHeaderLength];
+    CVSSCStrokeJournalWriteHeader(header);
+    if ((ssize_t)sizeof(header) != write(descriptor, header, sizeof(header))) {
+        fprintf(stderr, "could not write %s\n", journalPath);
+        return 1;
+    }
+    // at most a Color record per stroke
+    const size_t maximumRecordCount = 2 * recording.strokeCount + 2 * (recording.strokeCount / 10);
+    WrittenRecord* const records = malloc(maximumRecordCount * sizeof(WrittenRecord));
+    double* const commitSeconds = malloc(recording.strokeCount * sizeof(double));
+    uint8_t* buffer = NULL;
+    size_t bufferCapacity = 0;
+    CVSSCPalette* const palette = CVSSCPaletteCreate();
+    if (!records || !commitSeconds || !palette) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    size_t recordCount = 0;
+    size_t length = sizeof(header);
+    size_t synchronizationCount = 0;
+    double synchronizationSeconds = 0.0;
+    double lastSynchronization = Now();
+    const double writeStart = Now();
+    for (size_t idx = 0; idx < recording.strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const recorded = &recording.strokes[idx];
+        const CVSSCPlaybackStroke stroke = {recorded->brushType, recorded->color, &recording.components[recorded->firstComponent], recorded->componentCount};
+        // the commit: encoding (on the main thread) and writing (on the journal's queue)
+        const double start = Now();
+        CVSSCPaletteIndex colorIndex = 0;
+        bool isNewColor = false;
+        if (!CVSSCPaletteFindOrAdd(palette, stroke.color, &colorIndex, &isNewColor)) {
+            fprintf(stderr, "the palette is full\n");
+            return 1;
+        }
+        if (isNewColor) {
+            uint8_t colorRecord[CVSSCStrokeJournalColorRecordLength];
+            const size_t colorLength = CVSSCStrokeJournalWriteColorRecord(colorRecord, colorIndex, stroke.color);
+            if ((ssize_t)colorLength != write(descriptor, colorRecord, colorLength)) {
+                fprintf(stderr, "could not write %s\n", journalPath);
+                return 1;
+            }
+            length += colorLength;
+            records[recordCount++] = (WrittenRecord){CVSSCStrokeJournalRecordColor, 0, length};
+        }
+        const size_t recordLength = CVSSCStrokeJournalStrokeRecordLength(stroke.componentCount);
+        if (bufferCapacity < recordLength) {
+            bufferCapacity = recordLength * 2;
+            free(buffer);
+            buffer = malloc(bufferCapacity);
+            if (!buffer) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+        }
+        CVSSCStrokeJournalWriteStrokeRecord(buffer, &stroke, colorIndex);
+        if ((ssize_t)recordLength != write(descriptor, buffer, recordLength)) {
+            fprintf(stderr, "could not write %s\n", journalPath);
+            return 1;
+        }
+        commitSeconds[idx] = Now() - start;
+        length += recordLength;
+        records[recordCount++] = (WrittenRecord){CVSSCStrokeJournalRecordPaletteStroke, idx, length};
+        if (9 == idx % 10) {
+            const CVSSCStrokeJournalRecordType events[2] = {CVSSCStrokeJournalRecordUndo, CVSSCStrokeJournalRecordRedo};
+            for (size_t event = 0; event < 2; ++event) {
+                uint8_t eventRecord[CVSSCStrokeJournalEventRecordLength];
+                const size_t eventLength = CVSSCStrokeJournalWriteEventRecord(eventRecord, events[event], 0);
+                if ((ssize_t)eventLength != write(descriptor, eventRecord, eventLength)) {
+                    fprintf(stderr, "could not write %s\n", journalPath);
+                    return 1;
+                }
+                length += eventLength;
+                records[recordCount++] = (WrittenRecord){events[event], 0, length};
+            }
+        }
+        if (Now() - lastSynchronization >= delay) {
+            const double synchronizationStart = Now();
+            fsync(descriptor);
+            lastSynchronization = Now();
+            synchronizationSeconds += lastSynchronization - synchronizationStart;
+            ++synchronizationCount;
+        }
+    }
+    const double synchronizationStart = Now();
+    fsync(descriptor);
+    synchronizationSeconds += Now() - synchronizationStart;
+    ++synchronizationCount;
+    const double writeSeconds = Now() - writeStart;
+    close(descriptor);
+    free(buffer);
+
+    // the commit cost of the first and last tenth of the strokes
+    const size_t tenth = recording.strokeCount / 10 ? recording.strokeCount / 10 : 1;
+    double firstSeconds = 0.0, lastSeconds = 0.0;
+    size_t firstComponents = 0, lastComponents = 0;
+    for (size_t idx = 0; idx < tenth; ++idx) {
+        firstSeconds += commitSeconds[idx];
+        firstComponents += recording.strokes[idx].componentCount;
+        lastSeconds += commitSeconds[recording.strokeCount - 1 - idx];
+        lastComponents += recording.strokes[recording.strokeCount - 1 - idx].componentCount;
+    }
+    free(commitSeconds);
+    printf("%s: %zu strokes, %zu records, %zu colors, %zu KB journal, written in %.1f ms\n", playbackPath, recording.strokeCount, recordCount, CVSSCPaletteGetCount(palette), length / 1024, writeSeconds * 1.0e3);
+    printf("  commit: first tenth %.2f us/stroke (%.1f components), last tenth %.2f us/stroke (%.1f components)\n",
+           firstSeconds * 1.0e6 / (double)tenth, (double)firstComponents / (double)tenth, lastSeconds * 1.0e6 / (double)tenth, (double)lastComponents / (double)tenth);
+    printf("  fsync: %zu (every %.0f ms), %.2f ms each\n", synchronizationCount, delay * 1.0e3, synchronizationSeconds * 1.0e3 / (double)synchronizationCount);
+
+    // read back
+    size_t journalLength = 0;
+    char* const journal = CVSSCToolReadFile(journalPath, &journalLength);
+    if (!journal || journalLength != length) {
+        fprintf(stderr, "could not read %s\n", journalPath);
+        return 1;
+    }
+    size_t failureCount = 0;
+    const double readStart = Now();
+    if (!Verify(journal, journalLength, journalLength, 0, palette, &recording, records, recordCount)) {
+        printf("  FAILED: the journal does not read back as written\n");
+        ++failureCount;
+    }
+    printf("  read: %.1f ms\n", (Now() - readStart) * 1.0e3);
+    if (!Verify(journal, journalLength, journalLength, records[recordCount / 2].end, palette, &recording, records, recordCount)) {
+        printf("  FAILED: the journal does not read back in two parts\n");
+        ++failureCount;
+    }
+    if (!VerifyLegacyStrokeRecord(&recording, palette)) {
+        printf("  FAILED: a Stroke record which predates the palette does not read back\n");
+        ++failureCount;
+    }
+
+    // a crash while a record is written leaves a prefix of it
+    size_t cutCount = 0;
+    const size_t lastRecordsStart = recordCount > 3 ? records[recordCount - 4].end : CVSSCStrokeJournalHeaderLength;
+    for (size_t cut = lastRecordsStart; cut < journalLength; ++cut, ++cutCount) {
+        if (!Verify(journal, cut, cut, 0, palette, &recording, records, recordCount)) {
+            if (!failureCount++) {
+                printf("  FAILED: cut at %zu\n", cut);
+            }
+        }
+    }
+    uint32_t state = 1;
+    for (int idx = 0; idx < 1000; ++idx, ++cutCount) {
+        const size_t cut = CVSSCStrokeJournalHeaderLength + Random(&state) % (journalLength - CVSSCStrokeJournalHeaderLength);
+        if (!Verify(journal, cut, cut, 0, palette, &recording, records, recordCount)) {
+            if (!failureCount++) {
+                printf("  FAILED: cut at %zu\n", cut);
+            }
+        }
+    }
+    // damage within the file (e.g. a torn sector)
+    for (int idx = 0; idx < corruptionCount; ++idx) {
+        const size_t offset = Random(&state) % journalLength;
+        const char original = journal[offset];
+        journal[offset] = (char)(original ^ (char)(1 + Random(&state) % 255));
+        if (!Verify(journal, journalLength, offset, 0, palette, &recording, records, recordCount)) {
+            if (!failureCount++) {
+                printf("  FAILED: corruption at %zu\n", offset);
+            }
+        }
+        journal[offset] = original;
+    }
+    printf("  crash recovery: %zu cuts, %d corruptions, %zu failed\n", cutCount, corruptionCount, failureCount);
+
+    free(journal);
+    free(records);
+    CVSSCPaletteDestroy(palette);
+    CVSSCToolRecordingFree(&recording);
+    return failureCount ? 1 : 0;
+}
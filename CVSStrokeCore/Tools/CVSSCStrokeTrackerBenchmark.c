@@ -0,0 +1,241 @@
+// CVSSCStrokeTrackerBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// measures the per touch sample cost of CVSStrokeGenerator's tracking pipeline: before (boxed samples in a shifting array,
+// and an object per component) and after (CVSSCStrokeTracker's sample ring and component buffer).
+//
+// build (from the repository root, any C99 compiler; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCStrokeTrackerBenchmark.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -o CVSSCStrokeTrackerBenchmark
+//
+// usage:
+//   CVSSCStrokeTrackerBenchmark [-s strokes] [-n samples] [-i iterations]
+//
+// tracks strokes (default 1000) of samples (default 200) touch samples along synthetic scribbles, iterations (default 10)
+// times with each pipeline. the before pipeline is the generator's former one with the Foundation and Core Data objects
+// replaced by heap blocks (an NSValue per sample, -removeObjectAtIndex:0, an NSManagedObject per component, and an
+// NSMutableArray of them which is packed when the stroke ends), so its cost is a lower bound of the app's. reports ns and
+// library allocations per sample. exits 1 if the pipelines' components differ.
+
+#define _XOPEN_SOURCE 700
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "CVSStrokeCore.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+static uint64_t AllocationCount(void) {
+    const CVSSCMemoryStatistics statistics = CVSSCMemoryGetStatistics();
+    return statistics.allocations + statistics.reallocations;
+}
+
+// a scribble: a wandering loop, sampled at roughly the spacing of touch events
+static CVSSCPoint* MakeSamples(const size_t pStrokeCount, const size_t pSampleCount) {
+    CVSSCPoint* const result = malloc(pStrokeCount * pSampleCount * sizeof(CVSSCPoint));
+    if (!result) {
+        return NULL;
+    }
+    for (size_t stroke = 0; stroke < pStrokeCount; ++stroke) {
+        const double cx = 100.0 + (double)(stroke * 37 % 568);
+        const double cy = 100.0 + (double)(stroke * 61 % 824);
+        const double radius = 20.0 + (double)(stroke % 80);
+        for (size_t idx = 0; idx < pSampleCount; ++idx) {
+            const double t = (double)idx * 0.05;
+            CVSSCPoint* const at = &result[stroke * pSampleCount + idx];
+            at->x = floor((cx + radius * cos(t) + 0.3 * radius * cos(3.1 * t)) * 2.0) * 0.5;
+            at->y = floor((cy + radius * sin(1.3 * t) + 0.2 * radius * sin(4.7 * t)) * 2.0) * 0.5;
+        }
+    }
+    return result;
+}
+
+#pragma mark - Before
+
+typedef struct {
+    // the boxed samples, oldest first (NSMutableArray of NSValue)
+    CVSSCPoint* samples[CVSSCSmoothingSampleCount];
+    size_t sampleCount;
+    // the component objects (NSMutableArray of CVSStrokeComponent)
+    CVSSCComponent** components;
+    size_t componentCount;
+    size_t componentCapacity;
+} Before;
+
+static bool BeforeAddSample(Before* const pBefore, const CVSSCPoint pSample) {
+    if (CVSSCSmoothingSampleCount == pBefore->sampleCount) {
+        // -removeObjectAtIndex:0
+        CVSSCFree(pBefore->samples[0]);
+        memmove(pBefore->samples, pBefore->samples + 1, (CVSSCSmoothingSampleCount - 1) * sizeof(CVSSCPoint*));
+        --pBefore->sampleCount;
+    }
+    // +valueWithCGPoint:
+    CVSSCPoint* const box = CVSSCAllocate(sizeof(CVSSCPoint));
+    if (!box) {
+        return false;
+    }
+    *box = pSample;
+    pBefore->samples[pBefore->sampleCount++] = box;
+    // -nextStrokeComponent unboxes the samples
+    CVSSCPoint samples[CVSSCSmoothingSampleCount];
+    for (size_t idx = 0; idx < pBefore->sampleCount; ++idx) {
+        samples[idx] = *pBefore->samples[idx];
+    }
+    // -newStrokeComponent
+    CVSSCComponent* const component = CVSSCAllocate(sizeof(CVSSCComponent));
+    if (!component) {
+        return false;
+    }
+    *component = CVSSCSmoothingMakeComponent(samples, pBefore->sampleCount, CVSSCSmoothingDefaultSmoothValue);
+    if (pBefore->componentCount == pBefore->componentCapacity) {
+        const size_t capacity = pBefore->componentCapacity ? pBefore->componentCapacity * 2 : 16;
+        CVSSCComponent** const components = CVSSCReallocate(pBefore->components, capacity * sizeof(CVSSCComponent*));
+        if (!components) {
+            CVSSCFree(component);
+            return false;
+        }
+        pBefore->components = components;
+        pBefore->componentCapacity = capacity;
+    }
+    pBefore->components[pBefore->componentCount++] = component;
+    return true;
+}
+
+// packs the components (-setComponentsWithStrokeComponents:) and disposes of the stroke's objects
+static CVSSCComponent* BeforeEndStroke(Before* const pBefore, size_t* const pOutCount) {
+    CVSSCComponent* const result = CVSSCAllocate((pBefore->componentCount ? pBefore->componentCount : 1) * sizeof(CVSSCComponent));
+    for (size_t idx = 0; idx < pBefore->componentCount; ++idx) {
+        if (result) {
+            result[idx] = *pBefore->components[idx];
+        }
+        CVSSCFree(pBefore->components[idx]);
+    }
+    for (size_t idx = 0; idx < pBefore->sampleCount; ++idx) {
+        CVSSCFree(pBefore->samples[idx]);
+    }
+    *pOutCount = pBefore->componentCount;
+    CVSSCFree(pBefore->components);
+    memset(pBefore, 0, sizeof(Before));
+    return result;
+}
+
+#pragma mark -
+
+static void PrintUsage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-s strokes] [-n samples] [-i iterations]\n", pName);
+}
+
+int main(int argc, char** argv) {
+    size_t strokeCount = 1000;
+    size_t sampleCount = 200;
+    int iterations = 10;
+    for (int idx = 1; idx < argc; ++idx) {
+        if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            strokeCount = (size_t)atol(argv[++idx]);
+        } else if (0 == strcmp(argv[idx], "-n") && idx + 1 < argc) {
+            sampleCount = (size_t)atol(argv[++idx]);
+        } else if (0 == strcmp(argv[idx], "-i") && idx + 1 < argc) {
+            iterations = atoi(argv[++idx]);
+        } else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (0 == strokeCount || 0 == sampleCount || 0 >= iterations) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+    CVSSCPoint* const samples = MakeSamples(strokeCount, sampleCount);
+    CVSSCStrokeTracker* const tracker = CVSSCStrokeTrackerCreate(1024);
+    if (!samples || !tracker) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    const double totalSamples = (double)strokeCount * (double)sampleCount * (double)iterations;
+
+    // the pipelines must make the same components
+    size_t mismatchCount = 0;
+    for (size_t stroke = 0; stroke < strokeCount; ++stroke) {
+        Before before = {0};
+        CVSSCStrokeTrackerReset(tracker);
+        for (size_t idx = 0; idx < sampleCount; ++idx) {
+            if (!BeforeAddSample(&before, samples[stroke * sampleCount + idx]) || !CVSSCStrokeTrackerAddSample(tracker, samples[stroke * sampleCount + idx])) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+        }
+        size_t count = 0;
+        CVSSCComponent* const components = BeforeEndStroke(&before, &count);
+        if (!components) {
+            fprintf(stderr, "out of memory\n");
+            return 1;
+        }
+        if (count != CVSSCStrokeTrackerGetComponentCount(tracker)
+            || 0 != memcmp(components, CVSSCStrokeTrackerGetComponents(tracker), count * sizeof(CVSSCComponent))) {
+            ++mismatchCount;
+        }
+        CVSSCFree(components);
+    }
+
+    // before
+    uint64_t allocations = AllocationCount();
+    double start = Now();
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        for (size_t stroke = 0; stroke < strokeCount; ++stroke) {
+            Before before = {0};
+            for (size_t idx = 0; idx < sampleCount; ++idx) {
+                if (!BeforeAddSample(&before, samples[stroke * sampleCount + idx])) {
+                    fprintf(stderr, "out of memory\n");
+                    return 1;
+                }
+            }
+            size_t count = 0;
+            CVSSCComponent* const components = BeforeEndStroke(&before, &count);
+            if (!components) {
+                fprintf(stderr, "out of memory\n");
+                return 1;
+            }
+            CVSSCFree(components);
+        }
+    }
+    const double beforeSeconds = Now() - start;
+    const uint64_t beforeAllocations = AllocationCount() - allocations;
+
+    // after
+    allocations = AllocationCount();
+    start = Now();
+    for (int iteration = 0; iteration < iterations; ++iteration) {
+        for (size_t stroke = 0; stroke < strokeCount; ++stroke) {
+            CVSSCStrokeTrackerReset(tracker);
+            for (size_t idx = 0; idx < sampleCount; ++idx) {
+                if (!CVSSCStrokeTrackerAddSample(tracker, samples[stroke * sampleCount + idx])) {
+                    fprintf(stderr, "out of memory\n");
+                    return 1;
+                }
+            }
+        }
+    }
+    const double afterSeconds = Now() - start;
+    const uint64_t afterAllocations = AllocationCount() - allocations;
+
+    printf("%zu strokes x %zu samples, %d iterations\n", strokeCount, sampleCount, iterations);
+    printf("  before: %8.1f ns/sample, %6.3f allocations/sample\n", beforeSeconds * 1.0e9 / totalSamples, (double)beforeAllocations / totalSamples);
+    printf("  after:  %8.1f ns/sample, %6.3f allocations/sample\n", afterSeconds * 1.0e9 / totalSamples, (double)afterAllocations / totalSamples);
+    printf("  speedup: %.2fx\n", afterSeconds > 0.0 ? beforeSeconds / afterSeconds : 0.0);
+    if (mismatchCount) {
+        printf("  %zu strokes' components differ\n", mismatchCount);
+    }
+
+    CVSSCStrokeTrackerDestroy(tracker);
+    free(samples);
+    return mismatchCount ? 1 : 0;
+}
@@ -0,0 +1,245 @@
+// CVSSCTileReplayBenchmark.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// measures how tile-parallel replay (CVSSCTileReplay) scales with threads, and verifies that its output is identical to
+// rendering the strokes one after another.
+//
+// build (from the repository root, any C99 compiler with pthreads; no UIKit):
+//   cc -std=c99 -O2 -ICVSStrokeCore/CVSStrokeCore CVSStrokeCore/Tools/CVSSCTileReplayBenchmark.c CVSStrokeCore/Tools/CVSSCToolSupport.c CVSStrokeCore/CVSStrokeCore/*.c -lz -lm -lpthread -o CVSSCTileReplayBenchmark
+//
+// usage:
+//   CVSSCTileReplayBenchmark [-i iterations] [-w width] [-h height] [-s scale] [-t tileSize] [-j threads] playback
+//
+// the playback file is JSON or binary (the format is detected). its strokes are rendered into a width x height (points)
+// canvas at scale pixels per point: serially with one rasterizer, then by tiles with 1...threads worker threads (-j
+// defaults to the number of online processors). each tiled time includes binning the strokes. reports ms/drawing and the
+// speedup over serial for each thread count. exits 1 if any tiled rendering differs from the serial rendering.
+
+#define _XOPEN_SOURCE 700
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "CVSStrokeCore.h"
+#include "CVSSCToolSupport.h"
+
+#pragma mark - Utilities
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1.0e-9;
+}
+
+#pragma mark - Serial
+
+static bool RenderSerial(CVSSCRasterizer* const pRasterizer, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const CVSSCToolRecording* const pRecording) {
+    const CVSSCPixelRect clip = CVSSCBitmapGetPixelRect(pBitmap);
+    for (size_t idx = 0; idx < pRecording->strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[idx];
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(stroke->brushType);
+        if (!CVSSCRasterizerRenderStroke(pRasterizer, pBitmap, pTransform, clip, brush, stroke->color, &pRecording->components[stroke->firstComponent], stroke->componentCount)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#pragma mark - Tiled
+
+typedef struct {
+    CVSSCTileReplay* replay;
+    size_t tileCount;
+    // guarded by lock
+    pthread_mutex_t lock;
+    size_t nextTile;
+    bool failed;
+} Job;
+
+typedef struct {
+    Job* job;
+    CVSSCRasterizer* rasterizer;
+} Worker;
+
+static void* WorkerMain(void* const pContext) {
+    Worker* const worker = pContext;
+    Job* const job = worker->job;
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        const size_t idx = job->nextTile++;
+        pthread_mutex_unlock(&job->lock);
+        if (idx >= job->tileCount) {
+            break;
+        }
+        if (0 != CVSSCTileReplayGetTileStrokeCount(job->replay, idx) && !CVSSCTileReplayRenderTile(job->replay, worker->rasterizer, idx)) {
+            pthread_mutex_lock(&job->lock);
+            job->failed = true;
+            pthread_mutex_unlock(&job->lock);
+        }
+    }
+    return NULL;
+}
+
+// bins the strokes and renders the tiles on the workers' threads
+static bool RenderTiled(Worker* const pWorkers, const int pThreadCount, pthread_t* const pThreads, const CVSSCBitmap* const pBitmap, const CVSSCTransform* const pTransform, const uint32_t pTileSize, const CVSSCToolRecording* const pRecording) {
+    Job job;
+    memset(&job, 0, sizeof(job));
+    job.replay = CVSSCTileReplayCreate(pBitmap, pTransform, CVSSCBitmapGetPixelRect(pBitmap), pTileSize);
+    bool result = NULL != job.replay;
+    for (size_t idx = 0; result && idx < pRecording->strokeCount; ++idx) {
+        const CVSSCToolRecordedStroke* const stroke = &pRecording->strokes[idx];
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(stroke->brushType);
+        result = CVSSCTileReplayAddStroke(job.replay, brush, stroke->color, &pRecording->components[stroke->firstComponent], stroke->componentCount);
+    }
+    if (!result) {
+        CVSSCTileReplayDestroy(job.replay);
+        return false;
+    }
+    job.tileCount = CVSSCTileReplayGetTileCount(job.replay);
+    pthread_mutex_init(&job.lock, NULL);
+    int startedCount = 0;
+    for (; startedCount < pThreadCount; ++startedCount) {
+        pWorkers[startedCount].job = &job;
+        if (0 != pthread_create(&pThreads[startedCount], NULL, WorkerMain, &pWorkers[startedCount])) {
+            break;
+        }
+    }
+    for (int idx = 0; idx < startedCount; ++idx) {
+        pthread_join(pThreads[idx], NULL);
+    }
+    pthread_mutex_destroy(&job.lock);
+    CVSSCTileReplayDestroy(job.replay);
+    return startedCount == pThreadCount && !job.failed;
+}
+
+#pragma mark - Benchmark
+
+static int Benchmark(const char* const pPath, const int pIterations, const uint32_t pWidth, const uint32_t pHeight, const double pScale, const uint32_t pTileSize, const int pThreadCount) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        fprintf(stderr, "%s: could not be read\n", pPath);
+        return 1;
+    }
+    CVSSCToolRecording recording;
+    memset(&recording, 0, sizeof(recording));
+    const bool read = CVSSCToolReadRecording(bytes, length, &recording);
+    free(bytes);
+    if (!read) {
+        fprintf(stderr, "%s: malformed playback data\n", pPath);
+        CVSSCToolRecordingFree(&recording);
+        return 1;
+    }
+
+    const uint32_t width = (uint32_t)(pWidth * pScale + 0.5);
+    const uint32_t height = (uint32_t)(pHeight * pScale + 0.5);
+    const size_t pixelsLength = 4 * (size_t)width * height;
+    uint8_t* const expected = malloc(pixelsLength);
+    uint8_t* const pixels = malloc(pixelsLength);
+    Worker* const workers = calloc((size_t)pThreadCount, sizeof(Worker));
+    pthread_t* const threads = calloc((size_t)pThreadCount, sizeof(pthread_t));
+    int result = expected && pixels && workers && threads ? 0 : 1;
+    for (int idx = 0; 0 == result && idx < pThreadCount; ++idx) {
+        workers[idx].rasterizer = CVSSCRasterizerCreate();
+        result = workers[idx].rasterizer ? 0 : 1;
+    }
+    if (0 != result) {
+        fprintf(stderr, "out of memory\n");
+    }
+
+    // the canvas is in points with its origin at the top left, as the playback view's is
+    const CVSSCTransform transform = CVSSCTransformMake(pScale, 0.0, 0.0, pScale, 0.0, 0.0);
+    const CVSSCBitmap reference = CVSSCBitmapMake(expected, width, height, 4 * (size_t)width);
+    const CVSSCBitmap bitmap = CVSSCBitmapMake(pixels, width, height, 4 * (size_t)width);
+    double serialSeconds = 0.0;
+    for (int idx = 0; 0 == result && idx < pIterations; ++idx) {
+        CVSSCBitmapClear(&reference, CVSSCBitmapGetPixelRect(&reference));
+        const double start = Now();
+        if (!RenderSerial(workers[0].rasterizer, &reference, &transform, &recording)) {
+            fprintf(stderr, "out of memory\n");
+            result = 1;
+        }
+        serialSeconds += Now() - start;
+    }
+    if (0 == result) {
+        printf("%s\n", pPath);
+        printf("  strokes: %zu components: %zu canvas: %ux%u px tile: %u px iterations: %d spans: %s\n", recording.strokeCount, recording.componentCount, width, height, pTileSize, pIterations, CVSSCSpanImplementationName());
+        printf("  serial:     %8.3f ms/drawing\n", 1.0e3 * serialSeconds / pIterations);
+    }
+    for (int threadCount = 1; 0 == result && threadCount <= pThreadCount; ++threadCount) {
+        double seconds = 0.0;
+        for (int idx = 0; 0 == result && idx < pIterations; ++idx) {
+            CVSSCBitmapClear(&bitmap, CVSSCBitmapGetPixelRect(&bitmap));
+            const double start = Now();
+            if (!RenderTiled(workers, threadCount, threads, &bitmap, &transform, pTileSize, &recording)) {
+                fprintf(stderr, "out of memory (or a thread could not be started)\n");
+                result = 1;
+            }
+            seconds += Now() - start;
+        }
+        if (0 == result) {
+            const bool isIdentical = 0 == memcmp(expected, pixels, pixelsLength);
+            printf("  %2d threads: %8.3f ms/drawing %6.2fx %s\n", threadCount, 1.0e3 * seconds / pIterations, serialSeconds / seconds, isIdentical ? "identical" : "DIFFERS FROM SERIAL");
+            result = isIdentical ? 0 : 1;
+        }
+    }
+
+    for (int idx = 0; workers && idx < pThreadCount; ++idx) {
+        CVSSCRasterizerDestroy(workers[idx].rasterizer);
+    }
+    free(workers);
+    free(threads);
+    free(expected);
+    free(pixels);
+    CVSSCToolRecordingFree(&recording);
+    return result;
+}
+
+#pragma mark - Main
+
+static int Usage(const char* const pName) {
+    fprintf(stderr, "usage: %s [-i iterations] [-w width] [-h height] [-s scale] [-t tileSize] [-j threads] playback\n", pName);
+    return 2;
+}
+
+int main(int argc, char** argv) {
+    int iterations = 5;
+    uint32_t width = 768;
+    uint32_t height = 1024;
+    double scale = 2.0;
+    uint32_t tileSize = CVSSCTileReplayDefaultTileSize;
+    const long processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+    int threadCount = 0 < processorCount ? (int)processorCount : 1;
+    int idx = 1;
+    for (; idx < argc && '-' == argv[idx][0]; ++idx) {
+        if (0 == strcmp(argv[idx], "-i") && idx + 1 < argc) {
+            iterations = atoi(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-w") && idx + 1 < argc) {
+            width = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-h") && idx + 1 < argc) {
+            height = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-s") && idx + 1 < argc) {
+            scale = atof(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-t") && idx + 1 < argc) {
+            tileSize = (uint32_t)atol(argv[++idx]);
+        }
+        else if (0 == strcmp(argv[idx], "-j") && idx + 1 < argc) {
+            threadCount = atoi(argv[++idx]);
+        }
+        else {
+            return Usage(argv[0]);
+        }
+    }
+    if (idx + 1 != argc || 0 >= iterations || 0 == width || 0 == height || !(scale > 0.0) || 0 == tileSize || 0 >= threadCount) {
+        return Usage(argv[0]);
+    }
+    return Benchmark(argv[idx], iterations, width, height, scale, tileSize, threadCount);
+}
@@ -0,0 +1,170 @@
+// CVSSCToolSupport.c
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CVSSCToolSupport.h"
+
+char* CVSSCToolReadFile(const char* const pPath, size_t* const pOutLength) {
+    FILE* const file = fopen(pPath, "rb");
+    if (NULL == file) {
+        return NULL;
+    }
+    char* result = NULL;
+    size_t length = 0;
+    size_t capacity = 0;
+    for (;;) {
+        if (length == capacity) {
+            capacity = capacity ? 2 * capacity : 1 << 16;
+            char* const grown = realloc(result, capacity);
+            if (NULL == grown) {
+                free(result);
+                fclose(file);
+                return NULL;
+            }
+            result = grown;
+        }
+        const size_t nRead = fread(result + length, 1, capacity - length, file);
+        if (0 == nRead) {
+            break;
+        }
+        length += nRead;
+    }
+    fclose(file);
+    *pOutLength = length;
+    return result;
+}
+
+static bool RecordingReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    CVSSCToolRecording* const recording = pContext;
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType(pStroke->brushType);
+    if (recording->skipsUnstrokedStrokes && (CVSSCBrushStampNone != brush->stamp || CVSSCComponentsAreFill(pStroke->components, pStroke->componentCount))) {
+        ++recording->skippedStrokeCount;
+        return true;
+    }
+    if (recording->strokeCount == recording->strokeCapacity) {
+        const size_t capacity = recording->strokeCapacity ? 2 * recording->strokeCapacity : 1024;
+        CVSSCToolRecordedStroke* const grown = realloc(recording->strokes, capacity * sizeof(CVSSCToolRecordedStroke));
+        if (NULL == grown) {
+            return false;
+        }
+        recording->strokes = grown;
+        recording->strokeCapacity = capacity;
+    }
+    if (recording->componentCount + pStroke->componentCount > recording->componentCapacity) {
+        size_t capacity = recording->componentCapacity ? recording->componentCapacity : 1 << 14;
+        while (recording->componentCount + pStroke->componentCount > capacity) {
+            capacity *= 2;
+        }
+        CVSSCComponent* const grown = realloc(recording->components, capacity * sizeof(CVSSCComponent));
+        if (NULL == grown) {
+            return false;
+        }
+        recording->components = grown;
+        recording->componentCapacity = capacity;
+    }
+    const CVSSCToolRecordedStroke stroke = {
+        pStroke->brushType,
+        pStroke->color,
+        recording->componentCount,
+        pStroke->componentCount,
+        CVSSCComponentsGetStrokeBounds(pStroke->components, pStroke->componentCount, brush->lineWidth)
+    };
+    recording->strokes[recording->strokeCount++] = stroke;
+    memcpy(&recording->components[recording->componentCount], pStroke->components, pStroke->componentCount * sizeof(CVSSCComponent));
+    recording->componentCount += pStroke->componentCount;
+    return true;
+}
+
+bool CVSSCToolReadRecording(const char* const pBytes, const size_t pLength, CVSSCToolRecording* const pRecording) {
+    const CVSSCPlaybackJSONReaderCallbacks callbacks = {pRecording, NULL, RecordingReadStroke};
+    if (CVSSCPlaybackBinaryHasSignature(pBytes, pLength)) {
+        CVSSCPlaybackBinaryReader* const reader = CVSSCPlaybackBinaryReaderCreate(&callbacks);
+        const bool result = reader && CVSSCPlaybackBinaryReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackBinaryReaderFinish(reader);
+        CVSSCPlaybackBinaryReaderDestroy(reader);
+        return result;
+    }
+    CVSSCPlaybackJSONReader* const reader = CVSSCPlaybackJSONReaderCreate(&callbacks);
+    const bool result = reader && CVSSCPlaybackJSONReaderAppend(reader, pBytes, pLength) && CVSSCPlaybackJSONReaderFinish(reader);
+    CVSSCPlaybackJSONReaderDestroy(reader);
+    return result;
+}
+
+void CVSSCToolRecordingFree(CVSSCToolRecording* const pRecording) {
+    free(pRecording->strokes);
+    free(pRecording->components);
+    pRecording->strokes = NULL;
+    pRecording->components = NULL;
+    pRecording->strokeCount = pRecording->strokeCapacity = 0;
+    pRecording->componentCount = pRecording->componentCapacity = 0;
+}
+
+static bool WriteToFile(void* const pContext, const void* const pBytes, const size_t pLength) {
+    return pLength == fwrite(pBytes, 1, pLength, (FILE*)pContext);
+}
+
+bool CVSSCToolWritePNG(const char* const pPath, const CVSSCBitmap* const pBitmap, const int pCompressionLevel) {
+    FILE* const file = fopen(pPath, "wb");
+    if (NULL == file) {
+        return false;
+    }
+    const CVSSCPlaybackOutput output = {file, WriteToFile};
+    const bool written = CVSSCPNGWrite(pBitmap, pCompressionLevel, &output);
+    const bool closed = 0 == fclose(file);
+    if (!written || !closed) {
+        remove(pPath);
+        return false;
+    }
+    return true;
+}
+
+bool CVSSCToolReadPNG(const char* const pPath, CVSSCBitmap* const pOutBitmap) {
+    size_t length = 0;
+    char* const bytes = CVSSCToolReadFile(pPath, &length);
+    if (NULL == bytes) {
+        return false;
+    }
+    const bool result = CVSSCPNGRead(bytes, length, pOutBitmap);
+    free(bytes);
+    return result;
+}
+
+size_t CVSSCToolReadGoldens(const char* const pPath, CVSSCToolGolden* const pOutGoldens, const size_t pCapacity) {
+    FILE* const file = fopen(pPath, "r");
+    if (NULL == file) {
+        return 0;
+    }
+    size_t count = 0;
+    bool result = true;
+    char line[512];
+    while (result && fgets(line, sizeof(line), file)) {
+        const char* at = line;
+        while (' ' == *at || '\t' == *at) {
+            ++at;
+        }
+        if ('#' == *at || '\n' == *at || '\0' == *at) {
+            continue;
+        }
+        CVSSCToolGolden golden;
+        unsigned width = 0, height = 0;
+        result = count < pCapacity
+            && 7 == sscanf(at, "%63s %63s %u %u %lf %d %lf", golden.name, golden.drawing, &width, &height, &golden.scale, &golden.tolerance, &golden.percent)
+            && 0 < width && 0 < height && golden.scale > 0.0 && 0 <= golden.tolerance && golden.percent >= 0.0;
+        if (result) {
+            golden.width = width;
+            golden.height = height;
+            pOutGoldens[count++] = golden;
+        }
+    }
+    fclose(file);
+    return result ? count : 0;
+}
+
+bool CVSSCToolGetGoldenPath(const char* const pManifestPath, const char* const pFileName, const char* const pExtension, char* const pOutPath, const size_t pLength) {
+    const char* const slash = strrchr(pManifestPath, '/');
+    const int directoryLength = slash ? (int)(slash - pManifestPath + 1) : 0;
+    const int length = snprintf(pOutPath, pLength, "%.*s%s%s", directoryLength, pManifestPath, pFileName, pExtension);
+    return 0 <= length && (size_t)length < pLength;
+}
@@ -0,0 +1,97 @@
+// CVSSCToolSupport.h
+// CVSStrokeCore
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+// the file and playback reading which the tools share. compiled into each tool which uses it (see the tool's compile command);
+// it is not part of the library.
+
+#ifndef CVSStrokeCore_CVSSCToolSupport_h
+#define CVSStrokeCore_CVSSCToolSupport_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "CVSStrokeCore.h"
+
+/**
+ @return the contents of the file at @p pPath, which the caller frees, or NULL if it could not be read.
+ */
+extern char* CVSSCToolReadFile(const char* const pPath, size_t* const pOutLength);
+
+/**
+ @brief a stroke of a recording. its components are the recording's components [firstComponent, firstComponent + componentCount).
+ */
+typedef struct {
+    CVSSCBrushType brushType;
+    CVSSCColor color;
+    size_t firstComponent;
+    size_t componentCount;
+    // CVSSCComponentsGetStrokeBounds at the brush's line width
+    CVSSCRect bounds;
+} CVSSCToolRecordedStroke;
+
+/**
+ @brief the strokes of a playback file, copied out of the reader so that rendering may be measured without parsing.
+ zero initialize it. set skipsUnstrokedStrokes before reading to skip the fills and the stamped brushes' strokes.
+ */
+typedef struct {
+    CVSSCToolRecordedStroke* strokes;
+    size_t strokeCount;
+    size_t strokeCapacity;
+    CVSSCComponent* components;
+    size_t componentCount;
+    size_t componentCapacity;
+    bool skipsUnstrokedStrokes;
+    // the strokes which were skipped
+    size_t skippedStrokeCount;
+} CVSSCToolRecording;
+
+/**
+ @brief appends the strokes of playback data (JSON or binary -- the format is detected) to @p pRecording.
+ @return false if the data could not be read or memory could not be allocated.
+ */
+extern bool CVSSCToolReadRecording(const char* const pBytes, const size_t pLength, CVSSCToolRecording* const pRecording);
+
+/**
+ @brief frees the recording's strokes and components.
+ */
+extern void CVSSCToolRecordingFree(CVSSCToolRecording* const pRecording);
+
+/**
+ @brief writes the bitmap to @p pPath as a PNG (CVSSCPNGWrite). a file which could not be written entirely is removed.
+ */
+extern bool CVSSCToolWritePNG(const char* const pPath, const CVSSCBitmap* const pBitmap, const int pCompressionLevel);
+
+/**
+ @brief reads the PNG at @p pPath (CVSSCPNGRead). the pixels are allocated with CVSSCAllocate.
+ */
+extern bool CVSSCToolReadPNG(const char* const pPath, CVSSCBitmap* const pOutBitmap);
+
+/**
+ @brief a line of the golden image manifest (CVSStrokeCore/Goldens/Goldens.txt): the golden image <name>.png is the CG
+ rendering of the drawing <drawing>.json, beside the manifest, on a width x height point canvas at scale pixels per point.
+ the software rasterizer's rendering matches it if at most percent% of its pixels differ by more than tolerance in a channel.
+ */
+typedef struct {
+    char name[64];
+    char drawing[64];
+    uint32_t width;
+    uint32_t height;
+    double scale;
+    int tolerance;
+    double percent;
+} CVSSCToolGolden;
+
+/**
+ @brief reads the manifest at @p pPath into at most @p pCapacity goldens. blank lines and lines which begin with # are skipped.
+ @return the number of goldens, or 0 if the manifest could not be read or a line is malformed.
+ */
+extern size_t CVSSCToolReadGoldens(const char* const pPath, CVSSCToolGolden* const pOutGoldens, const size_t pCapacity);
+
+/**
+ @brief the path of @p pFileName in the directory of the manifest at @p pManifestPath.
+ @return false if it does not fit in @p pLength octets.
+ */
+extern bool CVSSCToolGetGoldenPath(const char* const pManifestPath, const char* const pFileName, const char* const pExtension, char* const pOutPath, const size_t pLength);
+
+#endif
@@ -8,10 +8,12 @@
 
 #import <Foundation/Foundation.h>
 #import <CoreData/CoreData.h>
+#include "CVSSCComponent.h"
 
 typedef enum {
-    CVSStrokeComponentTypePoint,
-    CVSStrokeComponentTypeCurve
+    CVSStrokeComponentTypePoint = CVSSCComponentTypePoint,
+    CVSStrokeComponentTypeCurve = CVSSCComponentTypeCurve,
+    CVSStrokeComponentTypeFill = CVSSCComponentTypeFill
 } CVSStrokeComponentType;
 
 @interface CVSStrokeComponent : NSManagedObject
@@ -29,6 +31,24 @@ typedef enum {
 @property (nonatomic) CGPoint controlPoint2;
 @property (nonatomic, strong) NSManagedObject *stroke;
 
+/**
+ @brief the component's values, read from (or written to) the persisted strings at full precision.
+ */
+@property (nonatomic) CVSSCComponent packedComponent;
+
+/**
+ @brief the component's representation in playback JSON. a fill is a point marked "fill" (see CVSSCPlaybackJSON.h).
+ */
 - (NSDictionary *)componentRepresentation;
 
+/**
+ @return the representation of a packed component. equal to componentRepresentation of an equivalent CVSStrokeComponent.
+ */
++ (NSDictionary *)componentRepresentationWithPackedComponent:(const CVSSCComponent *)pComponent;
+
+/**
+ @return the packed component of a representation, as returned by componentRepresentation.
+ */
++ (CVSSCComponent)packedComponentWithRepresentation:(NSDictionary *)pRepresentation;
+
 @end
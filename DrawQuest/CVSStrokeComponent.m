@@ -10,59 +10,54 @@
 #import <UIKit/UIKit.h>
 #import "CVSStrokeComponent.h"
 
-static bool IsFPComponent(const char p) {
-    return '-' == p || '.' == p || isnumber(p);
-}
+enum { CVSPointStringBufferSize = 64 };
 
-// 'handmade' replacement (beware) for CGPointFromString. Because these members below are strings
-// and not values, we end up creating a ton of temporary strings using CGPointFromString.
-static CGPoint CVSMakeCGPointFromNSString(NSString * const pString) {
-    // reference implementation:
-    // return CGPointFromString(pString);
-
-    if (nil == pString) {
-        return CGPointZero;
-    }
+// copies the point string to a C string. Because these members below are strings and not values,
+// we would otherwise end up creating a ton of temporary strings.
+static bool CVSCopyPointCString(NSString * const pString, char pBuffer[CVSPointStringBufferSize]) {
     const size_t length = pString.length;
-    enum { BufferSize = 64 };
-
     if (!length) {
-        return CGPointZero;
+        return false;
     }
-    if (length > BufferSize) {
+    if (length >= CVSPointStringBufferSize) {
         assert(0 && "was not expecting a point to be this long");
-        return CGPointZero;
+        return false;
     }
-
-    unichar unichars[BufferSize] = {0};
+    unichar unichars[CVSPointStringBufferSize];
     [pString getCharacters:unichars range:(NSRange){0, length}];
-    char chars[BufferSize] = {0};
-    for (size_t i = 0; i < BufferSize; ++i) {
+    for (size_t i = 0; i < length; ++i) {
         const unichar at = unichars[i];
         if (CHAR_MAX < at) {
             assert(0 && "weird point-string?");
-            return CGPointZero;
+            return false;
         }
-        assert(CHAR_MAX >= at);
-        chars[i] = (char)at;
-    }
-    CGPoint result = CGPointZero;
-    const char* at = chars;
-    while (*at && false == IsFPComponent(*at)) {
-        ++at;
+        pBuffer[i] = (char)at;
     }
-    if (!(*at)) return CGPointZero;
-    char* outEnd = NULL;
-    result.x = (CGFloat)strtod(at, &outEnd);
-    at = outEnd;
-    while (*at && false == IsFPComponent(*at)) {
-        ++at;
+    pBuffer[length] = 0;
+    return true;
+}
+
+static CVSSCPoint CVSMakeSCPointFromNSString(NSString * const pString) {
+    char chars[CVSPointStringBufferSize];
+    CVSSCPoint result = {0, 0};
+    if (CVSCopyPointCString(pString, chars)) {
+        CVSSCPointParse(chars, &result);
     }
-    if (!(*at)) return CGPointZero;
-    result.y = (CGFloat)strtod(at, NULL);
     return result;
 }
 
+// 'handmade' replacement (beware) for CGPointFromString.
+static CGPoint CVSMakeCGPointFromNSString(NSString * const pString) {
+    // reference implementation:
+    // return CGPointFromString(pString);
+    const CVSSCPoint p = CVSMakeSCPointFromNSString(pString);
+    return CGPointMake((CGFloat)p.x, (CGFloat)p.y);
+}
+
+static NSString * CVSNSStringFromSCPoint(const CVSSCPoint p) {
+    return NSStringFromCGPoint(CGPointMake((CGFloat)p.x, (CGFloat)p.y));
+}
+
 @implementation CVSStrokeComponent
 
 @dynamic typeNumber;
@@ -124,6 +119,29 @@ static CGPoint CVSMakeCGPointFromNSString(NSString * const pString) {
     self.controlPoint2String = NSStringFromCGPoint(controlPoint2);
 }
 
+- (CVSSCComponent)packedComponent
+{
+    const CVSSCPoint fromPoint = CVSMakeSCPointFromNSString(self.fromPointString);
+    const CVSSCPoint toPoint = CVSMakeSCPointFromNSString(self.toPointString);
+    if (self.type == CVSStrokeComponentTypeCurve) {
+        return CVSSCComponentMakeCurve(fromPoint, CVSMakeSCPointFromNSString(self.controlPoint1String), CVSMakeSCPointFromNSString(self.controlPoint2String), toPoint);
+    }
+    CVSSCComponent result = CVSSCComponentMakePoint(fromPoint, toPoint);
+    result.type = (CVSSCComponentType)self.type;
+    return result;
+}
+
+- (void)setPackedComponent:(CVSSCComponent)packedComponent
+{
+    self.type = (CVSStrokeComponentType)packedComponent.type;
+    self.fromPointString = CVSNSStringFromSCPoint(packedComponent.fromPoint);
+    self.toPointString = CVSNSStringFromSCPoint(packedComponent.toPoint);
+    if (packedComponent.type == CVSSCComponentTypeCurve) {
+        self.controlPoint1String = CVSNSStringFromSCPoint(packedComponent.controlPoint1);
+        self.controlPoint2String = CVSNSStringFromSCPoint(packedComponent.controlPoint2);
+    }
+}
+
 - (NSDictionary *)componentRepresentation
 {
     if (self.type == CVSStrokeComponentTypeCurve){
@@ -140,6 +158,60 @@ static CGPoint CVSMakeCGPointFromNSString(NSString * const pString) {
                  @"fromPoint" : self.fromPointString,
                  @"toPoint" : self.toPointString,
                  };
+    } else if (self.type == CVSStrokeComponentTypeFill) {
+        // a point marked as a fill, which players that predate fills draw as the paint bucket stroke. see CVSSCPlaybackJSON.h.
+        return @{
+                 @"type" : @(CVSStrokeComponentTypePoint),
+                 @"fromPoint" : self.fromPointString,
+                 @"toPoint" : self.toPointString,
+                 @"fill" : @1
+                 };
+    } else {
+        return @{};
+    }
+}
+
++ (CVSSCComponent)packedComponentWithRepresentation:(NSDictionary *)pRepresentation
+{
+    const CVSSCPoint fromPoint = CVSMakeSCPointFromNSString(pRepresentation[@"fromPoint"]);
+    const CVSSCPoint toPoint = CVSMakeSCPointFromNSString(pRepresentation[@"toPoint"]);
+    const CVSSCComponentType type = (CVSSCComponentType)[pRepresentation[@"type"] intValue];
+    if (type == CVSSCComponentTypeCurve) {
+        return CVSSCComponentMakeCurve(fromPoint, CVSMakeSCPointFromNSString(pRepresentation[@"controlPoint1"]), CVSMakeSCPointFromNSString(pRepresentation[@"controlPoint2"]), toPoint);
+    }
+    if (type == CVSSCComponentTypePoint && [pRepresentation[@"fill"] boolValue]) {
+        return CVSSCComponentMakeFill(fromPoint);
+    }
+    CVSSCComponent result = CVSSCComponentMakePoint(fromPoint, toPoint);
+    result.type = type;
+    return result;
+}
+
++ (NSDictionary *)componentRepresentationWithPackedComponent:(const CVSSCComponent *)pComponent
+{
+    assert(pComponent);
+    NSNumber * typeNumber = @((int)pComponent->type);
+    if (pComponent->type == CVSSCComponentTypeCurve) {
+        return @{
+                 @"type" : typeNumber,
+                 @"fromPoint" : CVSNSStringFromSCPoint(pComponent->fromPoint),
+                 @"toPoint" : CVSNSStringFromSCPoint(pComponent->toPoint),
+                 @"controlPoint1" : CVSNSStringFromSCPoint(pComponent->controlPoint1),
+                 @"controlPoint2" : CVSNSStringFromSCPoint(pComponent->controlPoint2)
+                 };
+    } else if (pComponent->type == CVSSCComponentTypePoint) {
+        return @{
+                 @"type" : typeNumber,
+                 @"fromPoint" : CVSNSStringFromSCPoint(pComponent->fromPoint),
+                 @"toPoint" : CVSNSStringFromSCPoint(pComponent->toPoint),
+                 };
+    } else if (pComponent->type == CVSSCComponentTypeFill) {
+        return @{
+                 @"type" : @((int)CVSSCComponentTypePoint),
+                 @"fromPoint" : CVSNSStringFromSCPoint(pComponent->fromPoint),
+                 @"toPoint" : CVSNSStringFromSCPoint(pComponent->toPoint),
+                 @"fill" : @1
+                 };
     } else {
         return @{};
     }
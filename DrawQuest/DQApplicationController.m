@@ -2060,12 +2060,12 @@ NSString *DQApplicationQuestOfTheDayDefaultsKey = @"QuestOfTheDayID";
         playbackButton.enabled = NO;
         __weak typeof(self) weakSelf = self;
         [self requestCachedQuestForComment:comment resultBlock:^(DQQuest *quest, DQComment *comment) {
-            [self.playbackDataManager requestDrawingAndTemplateImageForComment:comment inQuest:quest fromViewController:viewController resultBlock:^(CVSDrawing *drawing, UIImage *templateImage) {
+            [self.playbackDataManager requestPlaybackStrokesAndTemplateImageForComment:comment inQuest:quest fromViewController:viewController resultBlock:^(CVSPlaybackStrokes *playbackStrokes, UIImage *templateImage) {
                 playbackButton.enabled = YES;
                 if (playbackButton.selected && playbackImageView.window)
                 {
                     [playbackImageView stopDisplayingSpinner];
-                    [playbackImageView playbackDrawing:drawing withTemplateImage:templateImage completionBlock:^{
+                    [playbackImageView playbackStrokes:playbackStrokes withTemplateImage:templateImage completionBlock:^{
                         playbackButton.selected = NO;
                     }];
                     [weakSelf.playbackDataManager requestLogPlaybackForComment:comment withCompletionBlock:^(DQComment *newComment) {
@@ -9,7 +9,7 @@
 #import "DQController.h"
 
 // Models
-@class CVSDrawing;
+@class CVSPlaybackStrokes;
 @class DQComment;
 @class DQQuest;
 
@@ -21,11 +21,12 @@
 - (id)initWithImageController:(STHTTPResourceController *)imageController delegate:(id<DQControllerDelegate>)delegate;
 - (id)initWithDelegate:(id<DQControllerDelegate>)delegate MSDesignatedInitializer(initWithImageController:delegate:);
 
-- (void)reset;
+/**
+ @brief decodes the playback JSON into a new CVSPlaybackStrokes. the result block is called on the main queue once playback can begin -- decoding continues in the background.
+ */
+- (void)requestPlaybackStrokesForPlaybackJSONData:(NSData *)playbackJSONData resultBlock:(void (^)(CVSPlaybackStrokes *playbackStrokes))resultBlock;
 
-- (CVSDrawing *)drawingForPlaybackData:(NSDictionary *)playbackData;
-
-- (void)requestDrawingAndTemplateImageForComment:(DQComment *)comment inQuest:(DQQuest *)quest fromViewController:(UIViewController *)presentingViewController resultBlock:(void (^)(CVSDrawing *drawing, UIImage *templateImage))resultBlock failureBlock:(void (^)(NSError *error))failureBlock;
+- (void)requestPlaybackStrokesAndTemplateImageForComment:(DQComment *)comment inQuest:(DQQuest *)quest fromViewController:(UIViewController *)presentingViewController resultBlock:(void (^)(CVSPlaybackStrokes *playbackStrokes, UIImage *templateImage))resultBlock failureBlock:(void (^)(NSError *error))failureBlock;
 
 - (void)requestLogPlaybackForComment:(DQComment *)comment withCompletionBlock:(void (^)(DQComment *newComment))completionBlock;
 
@@ -9,13 +9,10 @@
 #import "DQPlaybackDataManager.h"
 
 // Additions
-#import "UIColor+DQAdditions.h"
 #import "NSDictionary+DQAPIConveniences.h"
 
 // Models
-#import "CVSDrawing.h"
-#import "CVSStroke.h"
-#import "CVSStrokeComponent.h"
+#import "CVSPlaybackStrokes.h"
 #import "DQComment.h"
 #import "DQQuest.h"
 
@@ -35,11 +32,6 @@
 @end
 
 @implementation DQPlaybackDataManager
-{
-    NSManagedObjectModel *_managedObjectModel;
-    NSPersistentStoreCoordinator *_persistentStoreCoordinator;
-    NSManagedObjectContext *_mainContext;
-}
 
 - (id)initWithImageController:(STHTTPResourceController *)imageController delegate:(id<DQControllerDelegate>)delegate
 {
@@ -47,74 +39,24 @@
     if (self)
     {
         _imageController = imageController;
-        [self reset];
     }
     return self;
 }
 
-- (void)reset
-{
-    NSString *modelPath = [[NSBundle mainBundle] pathForResource:@"Drawings" ofType:@"momd"];
-    _managedObjectModel = [[NSManagedObjectModel alloc] initWithContentsOfURL:[NSURL fileURLWithPath:modelPath]];
-    _persistentStoreCoordinator = [[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:_managedObjectModel];
-    [_persistentStoreCoordinator addPersistentStoreWithType:NSInMemoryStoreType configuration:nil URL:nil options:nil error:NULL];
-    _mainContext = [[NSManagedObjectContext alloc] init];
-    [_mainContext setPersistentStoreCoordinator:_persistentStoreCoordinator];
-}
-
-#pragma mark - Create Managed Objects From JSON
+#pragma mark - Decode Playback Strokes
 
-- (CVSDrawing *)drawingForPlaybackData:(NSDictionary *)playbackData
+- (void)requestPlaybackStrokesForPlaybackJSONData:(NSData *)playbackJSONData resultBlock:(void (^)(CVSPlaybackStrokes *playbackStrokes))resultBlock
 {
-    CVSDrawing *drawing = [[CVSDrawing alloc] initWithEntity:[NSEntityDescription entityForName:@"CVSDrawing" inManagedObjectContext:_mainContext] insertIntoManagedObjectContext:_mainContext];
-    drawing.usesTemplate = playbackData ? playbackData[@"usesTemplate"] : @NO;
-    
-    NSArray *strokeRepresentations = playbackData[@"strokes"];
-    NSMutableArray *newStrokes = [[NSMutableArray alloc] init];
-    [strokeRepresentations enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-        NSDictionary *representation = (NSDictionary *)obj;
-        [newStrokes addObject:[self strokeForRepresentation:representation]];
-    }];
-
-    drawing.strokes = [NSOrderedSet orderedSetWithArray:newStrokes];
-    return drawing;
-}
-
-- (CVSStroke *)strokeForRepresentation:(NSDictionary *)dictionary
-{
-    CVSStroke *stroke = [[CVSStroke alloc] initWithEntity:[NSEntityDescription entityForName:@"CVSStroke" inManagedObjectContext:_mainContext] insertIntoManagedObjectContext:_mainContext];
-    stroke.strokeColor = DQColorFromDictionary(dictionary[@"strokeColor"]);
-    stroke.brushTypeNumber = dictionary[@"brushType"];
-    
-    NSArray *componentRepresentations = dictionary[@"components"];
-    NSMutableArray *newComponents = [[NSMutableArray alloc] init];
-    [componentRepresentations enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-        NSDictionary *representation = (NSDictionary *)obj;
-        [newComponents addObject:[self strokeComponentForRepresentation:representation]];
+    CVSPlaybackStrokes *playbackStrokes = [CVSPlaybackStrokes new];
+    [playbackStrokes decodePlaybackData:playbackJSONData readyBlock:^{
+        if (resultBlock)
+        {
+            resultBlock(playbackStrokes);
+        }
     }];
-    
-    stroke.components = [NSOrderedSet orderedSetWithArray:newComponents];
-    
-    return stroke;
-}
-
-- (CVSStrokeComponent *)strokeComponentForRepresentation:(NSDictionary *)dictionary
-{
-    CVSStrokeComponent *strokeComponent = [[CVSStrokeComponent alloc] initWithEntity:[NSEntityDescription entityForName:@"CVSStrokeComponent" inManagedObjectContext:_mainContext] insertIntoManagedObjectContext:_mainContext];
-    
-    strokeComponent.typeNumber = dictionary[@"type"];
-    strokeComponent.fromPointString = dictionary[@"fromPoint"];
-    strokeComponent.toPointString = dictionary[@"toPoint"];
-    
-    if(strokeComponent.type == CVSStrokeComponentTypeCurve) {
-        strokeComponent.controlPoint1String = dictionary[@"controlPoint1"];
-        strokeComponent.controlPoint2String = dictionary[@"controlPoint2"];
-    }
-    
-    return strokeComponent;
 }
 
-- (void)requestDrawingAndTemplateImageForComment:(DQComment *)comment inQuest:(DQQuest *)quest fromViewController:(UIViewController *)presentingViewController resultBlock:(void (^)(CVSDrawing *drawing, UIImage *templateImage))resultBlock failureBlock:(void (^)(NSError *error))failureBlock
+- (void)requestPlaybackStrokesAndTemplateImageForComment:(DQComment *)comment inQuest:(DQQuest *)quest fromViewController:(UIViewController *)presentingViewController resultBlock:(void (^)(CVSPlaybackStrokes *playbackStrokes, UIImage *templateImage))resultBlock failureBlock:(void (^)(NSError *error))failureBlock
 {
     DQHUDView *hud = UI_USER_INTERFACE_IDIOM() == UIUserInterfaceIdiomPad ? [[DQHUDView alloc] initWithFrame:presentingViewController.view.bounds] : nil;
     if (hud)
@@ -124,22 +66,24 @@
     }
 
     __weak typeof(self) weakSelf = self;
-    [self.publicServiceController requestPlaybackDataForCommentID:comment.serverID withCompletionBlock:^(DQHTTPRequest *request, id JSONObject) {
+    [self.publicServiceController requestPlaybackJSONDataForCommentID:comment.serverID withCompletionBlock:^(DQHTTPRequest *request, id JSONObject) {
         if (request && JSONObject)
         {
-            CVSDrawing *drawing = [weakSelf drawingForPlaybackData:JSONObject];
-            [weakSelf requestTemplateImageForDrawing:(CVSDrawing *)drawing fromQuest:quest resultBlock:^(UIImage *image) {
-                [hud hideAnimated:YES];
-                if (resultBlock)
-                {
-                    resultBlock(drawing, image);
-                }
-            } failureBlock:^(NSError *error) {
-                [hud hideAnimated:YES];
-                if (failureBlock)
-                {
-                    failureBlock(error);
-                }
+            // playback may begin as soon as the first strokes are decoded
+            [weakSelf requestPlaybackStrokesForPlaybackJSONData:JSONObject resultBlock:^(CVSPlaybackStrokes *playbackStrokes) {
+                [weakSelf requestTemplateImageForPlaybackStrokes:playbackStrokes fromQuest:quest resultBlock:^(UIImage *image) {
+                    [hud hideAnimated:YES];
+                    if (resultBlock)
+                    {
+                        resultBlock(playbackStrokes, image);
+                    }
+                } failureBlock:^(NSError *error) {
+                    [hud hideAnimated:YES];
+                    if (failureBlock)
+                    {
+                        failureBlock(error);
+                    }
+                }];
             }];
         }
         else
@@ -154,9 +98,9 @@
     }];
 }
 
-- (void)requestTemplateImageForDrawing:(CVSDrawing *)drawing fromQuest:(DQQuest *)quest resultBlock:(void (^)(UIImage *image))resultBlock failureBlock:(void (^)(NSError *error))failureBlock
+- (void)requestTemplateImageForPlaybackStrokes:(CVSPlaybackStrokes *)playbackStrokes fromQuest:(DQQuest *)quest resultBlock:(void (^)(UIImage *image))resultBlock failureBlock:(void (^)(NSError *error))failureBlock
 {
-    if (drawing.usesTemplate)
+    if (playbackStrokes.usesTemplate)
     {
         NSString *templateURL = [quest imageURLForKey:DQImageKeyQuestTemplate];
         [self.imageController requestImageForURL:templateURL forceReload:NO completionBlock:^(UIImage *image, STHTTPResourceControllerLoadStatus loadStatus, NSError *error) {
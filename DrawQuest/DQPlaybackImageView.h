@@ -8,7 +8,7 @@
 
 #import "DQImageView.h"
 
-@class CVSDrawing;
+@class CVSPlaybackStrokes;
 
 @interface DQPlaybackImageView : DQImageView
 
@@ -20,7 +20,7 @@
 - (id)initWithCoder:(NSCoder *)aDecoder MSDesignatedInitializer(initForCommentWithServerID:frame:);
 - (id)init MSDesignatedInitializer(initForCommentWithServerID:frame:);
 
-- (void)playbackDrawing:(CVSDrawing *)drawing withTemplateImage:(UIImage *)templateImage completionBlock:(dispatch_block_t)completionBlock;
+- (void)playbackStrokes:(CVSPlaybackStrokes *)playbackStrokes withTemplateImage:(UIImage *)templateImage completionBlock:(dispatch_block_t)completionBlock;
 
 - (void)startPlayback;
 - (void)pausePlayback;
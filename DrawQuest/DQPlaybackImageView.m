@@ -9,7 +9,7 @@
 #import "DQPlaybackImageView.h"
 
 // Models
-#import "CVSDrawing.h"
+#import "CVSPlaybackStrokes.h"
 
 // Views
 #import "DQPlaybackView.h"
@@ -73,7 +73,7 @@
     }
 }
 
-- (void)playbackDrawing:(CVSDrawing *)drawing withTemplateImage:(UIImage *)templateImage completionBlock:(dispatch_block_t)completionBlock
+- (void)playbackStrokes:(CVSPlaybackStrokes *)playbackStrokes withTemplateImage:(UIImage *)templateImage completionBlock:(dispatch_block_t)completionBlock
 {
     self.playbackCompletionBlock = completionBlock;
     if (self.playbackView)
@@ -87,7 +87,7 @@
     CVSTemplateImage * const image = templateImage ? [CVSTemplateImage templateImageWithUIImage:templateImage] : [CVSTemplateImage templateImageWithEmptyTemplateImage];
     self.playbackView = [[DQPlaybackView alloc] initWithFrame:CGRectMake(0.0, 0.0, size.width, size.height) templateImage:image];
     self.playbackView.delegate = self;
-    self.playbackView.drawing = drawing;
+    self.playbackView.playbackStrokes = playbackStrokes;
     self.playbackView.layer.opacity = 0.0;
     [self addSubview:self.playbackView];
     [UIView animateWithDuration:0.5 animations:^{
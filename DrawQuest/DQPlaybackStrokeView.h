@@ -6,7 +6,7 @@
 #import <UIKit/UIKit.h>
 
 @class DQPlaybackView;
-@class CVSDrawing;
+@class CVSPlaybackStrokes;
 @class CVSStrokeArray;
 @class CVSCacheView;
 @class CVSTemplateImage;
@@ -16,7 +16,28 @@
 - (id)initWithFrame:(CGRect)pFrame templateImage:(CVSTemplateImage *)pTemplateImage cacheView:(CVSCacheView *)pCacheView;
 
 @property (nonatomic, weak) DQPlaybackView * playbackView;
-@property (strong, nonatomic) CVSDrawing * drawing;
+@property (strong, nonatomic) CVSPlaybackStrokes * playbackStrokes;
+
+/**
+ @brief playback is paced by time rather than by frames: components are revealed at a rate chosen so that the drawing plays in about
+ targetDuration seconds, bounded by minimumComponentsPerSecond (so short drawings don't crawl) and maximumComponentsPerSecond.
+ */
+@property (nonatomic, assign) NSTimeInterval targetDuration;
+@property (nonatomic, assign) CGFloat minimumComponentsPerSecond;
+@property (nonatomic, assign) CGFloat maximumComponentsPerSecond;
+
+/**
+ @brief the time a display link tick may spend rendering strokes, as estimated by CVSSCRenderCostDefaultModel. a stroke which
+ would exceed it is begun in a following tick (unless it is the tick's first), and playback catches up over the following ticks.
+ @details the model is fitted to the software rasterizer, so where the strokes are drawn with CG its estimates rank the strokes'
+ costs rather than time them. the time the tick has already spent is measured, so a tick which overruns still ends.
+ */
+@property (nonatomic, assign) NSTimeInterval frameBudget;
+
+/**
+ @brief the number of strokes between the keyframes of the cache which are recorded as strokes are played, for seeking.
+ */
+@property (nonatomic, assign) NSUInteger keyframeInterval;
 
 - (void)startPlayback;
 - (void)pausePlayback;
@@ -24,4 +45,16 @@
 
 - (void)clearAllStrokesAndEraseView;
 
+/**
+ @brief shows the first @p pStrokeCount strokes (at most the strokes decoded), from which playback continues. the cache is restored from the
+ nearest keyframe and only the strokes which follow it are rendered. the restore is asynchronous: seeks made while one is in progress are
+ coalesced, so a scrubber may seek on every change of its value.
+ */
+- (void)seekToStrokeCount:(NSUInteger)pStrokeCount;
+
+/**
+ @return the number of strokes which have been played (or sought to)
+ */
+- (NSUInteger)playedStrokeCount;
+
 @end
@@ -5,34 +5,63 @@
 
 #import "DQPlaybackStrokeView.h"
 
-#import "CVSDrawing.h"
-#import "CVSStroke.h"
-#import "CVSStrokeComponent.h"
-#import "CVSStrokeArray.h"
+#import "CVSPlaybackStrokes.h"
 #import "DQPlaybackView.h"
-#import "UIBezierPath+CVSAdditions.h"
-#import "CVSViewsStrokeArray.h"
-#import "CVSTrackingBrush.h"
 #import "CVSCacheView.h"
 #import "CVSEditorViewRenderOptions.h"
+#import "CVSStrokeRenderer.h"
 #import "CVSTemplateImage.h"
+#include "CVSSCGeometry.h"
+#include "CVSSCRenderCost.h"
+
+// the old pace was 4 components per display link frame (at 60Hz)
+static const NSTimeInterval DQPlaybackStrokeViewDefaultTargetDuration = 15.0;
+static const CGFloat DQPlaybackStrokeViewDefaultMinimumComponentsPerSecond = 240.0;
+static const CGFloat DQPlaybackStrokeViewDefaultMaximumComponentsPerSecond = 2400.0;
+// a longer interval between ticks (e.g. a stall) is not made up
+static const NSTimeInterval DQPlaybackStrokeViewMaximumTickInterval = 0.1;
+// the most playback may fall behind, in seconds of components, before the excess is dropped
+static const NSTimeInterval DQPlaybackStrokeViewMaximumLag = 0.25;
+// a seek renders at most about this many strokes past a keyframe
+static const NSUInteger DQPlaybackStrokeViewDefaultKeyframeInterval = 25;
 
 @interface DQPlaybackStrokeView ()
 
 @property (nonatomic, readonly) CVSTemplateImage * templateImage;
 
-@property (nonatomic, assign, getter=shouldIncrementCurrentStrokeIndex) BOOL incrementCurrentStrokeIndex;
-@property (nonatomic) NSUInteger currentStrokeIndex;
-@property (nonatomic) NSUInteger currentStrokeComponentIndex;
 @property (nonatomic, strong) CADisplayLink * displayLink;
 @property (nonatomic, assign, getter=isAnimating) BOOL animating;
-@property (nonatomic, strong) CVSTrackingBrush * trackingBrush;
+// YES while the cache is restored from a keyframe. playback does not advance.
+@property (nonatomic, assign, getter=isSeeking) BOOL seeking;
 @property (nonatomic, readonly) CVSCacheView * cacheView;
+// the color of the active stroke, made once per stroke rather than once per frame
+@property (nonatomic, strong) UIColor * activeStrokeColor;
 
 @end
 
 
 @implementation DQPlaybackStrokeView
+{
+    // the stroke being revealed. the strokes before it are finished.
+    NSUInteger activeStrokeIndex;
+    // the active stroke's components in [activeFirstComponentIndex, activeComponentCount) are drawn by this view
+    NSUInteger activeFirstComponentIndex;
+    NSUInteger activeComponentCount;
+    // the finished strokes which have been rendered into the cache
+    NSUInteger flushedStrokeCount;
+    // the estimated render time of the active stroke, estimated when it is begun
+    double activeRenderCost;
+    // true when the cache holds exactly the strokes before flushedStrokeCount -- so that it may be added to the keyframe index, and a seek
+    // may render forward from it
+    bool cacheHoldsFlushedStrokes;
+    // the stroke count of the latest seek. read when a restore completes.
+    NSUInteger seekStrokeCount;
+    // incremented when playback is stopped. a restore in progress is then abandoned.
+    NSUInteger seekGeneration;
+    // pacing
+    CFTimeInterval lastTickTimestamp;
+    double componentsDue;
+}
 
 - (id)initWithFrame:(CGRect)pFrame templateImage:(CVSTemplateImage *)pTemplateImage cacheView:(CVSCacheView *)pCacheView
 {
@@ -46,12 +75,14 @@
     self.clipsToBounds = YES;
     self.clearsContextBeforeDrawing = NO;
 
-    _currentStrokeIndex = 0;
-    _incrementCurrentStrokeIndex = NO;
-    _currentStrokeComponentIndex = 0;
+    _targetDuration = DQPlaybackStrokeViewDefaultTargetDuration;
+    _minimumComponentsPerSecond = DQPlaybackStrokeViewDefaultMinimumComponentsPerSecond;
+    _maximumComponentsPerSecond = DQPlaybackStrokeViewDefaultMaximumComponentsPerSecond;
+    _frameBudget = CVSSCFrameBudgetDefaultDuration;
+    _keyframeInterval = DQPlaybackStrokeViewDefaultKeyframeInterval;
+    cacheHoldsFlushedStrokes = true;
 
     _animating = NO;
-    _trackingBrush = nil;
     _cacheView = pCacheView;
     _templateImage = pTemplateImage;
     if (!_cacheView || !_templateImage) {
@@ -74,13 +105,19 @@
 
 - (void)clearAllStrokesAndEraseView
 {
-    [self.trackingBrush ifTrackingEndTracking:self];
-    [self.trackingBrush beginTracking];
+    // the revealed part of the active stroke is erased. the rest of it will still be drawn.
+    activeFirstComponentIndex = activeComponentCount;
+    // the cache is cleared with this view. the finished strokes are not rendered into it.
+    flushedStrokeCount = activeStrokeIndex;
+    cacheHoldsFlushedStrokes = 0 == flushedStrokeCount;
+    [self setNeedsDisplay];
 }
 
 - (void)startPlayback
 {
     [self setNeedsDisplay];
+    // the time spent paused is not played
+    lastTickTimestamp = 0;
     _displayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(drawNextFrame)];
     [self.displayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSDefaultRunLoopMode];
     self.animating  = YES;
@@ -97,9 +134,16 @@
     @autoreleasepool {
         [self disposeDisplayLink];
         self.animating = NO;
-        self.incrementCurrentStrokeIndex = NO;
-        self.currentStrokeComponentIndex = 0;
-        self.currentStrokeIndex = 0;
+        [self flushFinishedStrokes];
+        activeStrokeIndex = 0;
+        activeFirstComponentIndex = 0;
+        activeComponentCount = 0;
+        flushedStrokeCount = 0;
+        componentsDue = 0;
+        // the cache still holds the strokes which were played, until the client clears it
+        cacheHoldsFlushedStrokes = false;
+        ++seekGeneration;
+        self.activeStrokeColor = nil;
         [self setNeedsDisplay];
         [self.playbackView.delegate playbackViewDidFinishPlayback:self.playbackView];
     }
@@ -107,9 +151,12 @@
 
 #pragma mark -
 
-- (void)configureContext:(CGContextRef)context withStroke:(CVSStroke *)stroke;
+- (void)configureContext:(CGContextRef)context withStroke:(const CVSPlaybackStroke *)stroke
 {
-    [self configureContext:context withBrush:CVSBrushAttributesForBrushType(stroke.brushType) strokeColor:stroke.strokeColor];
+    if (!self.activeStrokeColor) {
+        self.activeStrokeColor = CVSPlaybackStrokeColor(stroke);
+    }
+    [self configureContext:context withBrush:CVSBrushAttributesForBrushType(stroke->brushType) strokeColor:self.activeStrokeColor];
 }
 
 - (void)configureContext:(CGContextRef)context withBrush:(CVSBrushAttributes)brush strokeColor:(UIColor *)strokeColor
@@ -129,82 +176,176 @@
     }
 }
 
-- (void)drawComponent:(CVSStrokeComponent *)component forStroke:(CVSStroke *)stroke
+#pragma mark - Pacing
+
+- (double)componentsPerSecond
 {
-    assert(component);
-    assert(stroke);
-    const CVSBrushType brushType = stroke.brushType;
-    CVSTrackingBrush * const tmp = [[CVSTrackingBrush alloc] initWithBrushType:brushType];
-    [tmp beginTracking];
-    [tmp addStrokeComponent:component];
-    // do not close the path. it makes for inconsistent strokes.
-    // [tmp closePath];
-    assert(!tmp.isEmpty);
-    if (!self.trackingBrush) {
-        self.trackingBrush = [[CVSTrackingBrush alloc] initWithBrushType:brushType];
-        [self.trackingBrush beginTracking];
-    }
+    const double rate = self.playbackStrokes.componentCount / MAX(self.targetDuration, 0.001);
+    return MIN(MAX(rate, self.minimumComponentsPerSecond), MAX(self.minimumComponentsPerSecond, self.maximumComponentsPerSecond));
+}
 
-    [self.trackingBrush appendPathOfTrackingBrush:tmp];
-    [tmp invalidateTrackingPathAndPathsRectInView:self];
+// renders the finished strokes which have not been rendered into the cache, in one pass
+- (void)flushFinishedStrokes
+{
+    [self renderStrokesToCount:activeStrokeIndex];
 }
 
-- (void)drawNextFrame
+// the estimated time to render the stroke into the cache
+- (double)renderCostOfStroke:(const CVSPlaybackStroke *)pStroke
 {
-    @autoreleasepool {
-        const NSInteger NComponentsPerFrame = 4;
-        for (NSInteger component = 0; component < NComponentsPerFrame; component++) {
-            // Check if current stroke is in bounds
-            // If not, stop playback
-            NSUInteger strokeCount = [self.drawing.strokes count];
-            if (self.isAnimating && (self.currentStrokeIndex >= strokeCount || (self.shouldIncrementCurrentStrokeIndex && self.currentStrokeIndex + 1 >= strokeCount))) {
-                [self stopPlayback];
-                break;
-            }
+    const CGRect bounds = self.bounds;
+    const CVSSCRenderCostFeatures features = CVSSCRenderCostGetFeatures(CVSSCBrushAttributesForBrushType((CVSSCBrushType)pStroke->brushType), pStroke->components, pStroke->componentCount, self.contentScaleFactor,
+                                                                        CVSSCRectMake(bounds.origin.x, bounds.origin.y, bounds.size.width, bounds.size.height));
+    return CVSSCRenderCostEstimate(&CVSSCRenderCostDefaultModel, &features);
+}
 
-            if ([self drawNextComponent]) {
-                break;
-            }
+// renders the strokes in [flushedStrokeCount, pStrokeCount) into the cache. where the keyframe index does not yet reach, keyframes are added
+// every keyframeInterval strokes.
+- (void)renderStrokesToCount:(NSUInteger)pStrokeCount
+{
+    const NSUInteger keyframeInterval = MAX(self.keyframeInterval, (NSUInteger)1);
+    NSUInteger nextKeyframe = NSNotFound;
+    if (cacheHoldsFlushedStrokes) {
+        nextKeyframe = MAX(self.cacheView.strokeCountOfLatestPlaybackKeyframe, flushedStrokeCount) / keyframeInterval * keyframeInterval + keyframeInterval;
+    }
+    while (flushedStrokeCount < pStrokeCount) {
+        const NSUInteger end = MIN(pStrokeCount, nextKeyframe);
+        [self.cacheView renderPlaybackStrokes:self.playbackStrokes range:NSMakeRange(flushedStrokeCount, end - flushedStrokeCount)];
+        flushedStrokeCount = end;
+        if (end == nextKeyframe) {
+            [self.cacheView addPlaybackKeyframeForStrokeCount:end];
+            nextKeyframe += keyframeInterval;
         }
     }
 }
 
-- (BOOL)drawNextComponent
+#pragma mark - Seeking
+
+- (NSUInteger)playedStrokeCount
 {
-    if (self.shouldIncrementCurrentStrokeIndex) {
-        self.currentStrokeIndex += 1;
-    }
+    return self.isSeeking ? seekStrokeCount : activeStrokeIndex;
+}
 
-    CVSStroke *currentStroke = [self.drawing.strokes objectAtIndex:self.currentStrokeIndex];
+// the cache holds the first pStrokeCount strokes. playback continues from there.
+- (void)didSeekToStrokeCount:(NSUInteger)pStrokeCount
+{
+    assert(flushedStrokeCount == pStrokeCount);
+    activeStrokeIndex = pStrokeCount;
+    activeFirstComponentIndex = 0;
+    activeComponentCount = 0;
+    cacheHoldsFlushedStrokes = true;
+    // the time spent seeking is not played
+    lastTickTimestamp = 0;
+    componentsDue = 0;
+    self.activeStrokeColor = nil;
+    [self setNeedsDisplay];
+}
 
-    // Get the next component index
-    // If it's not in bounds, increment the stroke, return;
-    if (self.currentStrokeComponentIndex >= [currentStroke.components count]) {
-        [self.cacheView enqueueAndRenderStrokes:[CVSStrokeArray newStrokeArrayWithStroke:[self.drawing.strokes objectAtIndex:self.currentStrokeIndex]]];
-        if (self.trackingBrush) {
-            [self.trackingBrush invalidateTrackingPathAndPathsRectInView:self];
+- (void)seekToStrokeCount:(NSUInteger)pStrokeCount
+{
+    seekStrokeCount = MIN(pStrokeCount, self.playbackStrokes.strokeCount);
+    if (self.isSeeking) {
+        // sought when the restore completes
+        return;
+    }
+    @autoreleasepool {
+        // the revealed part of the active stroke is dropped
+        [self flushFinishedStrokes];
+        const NSUInteger target = seekStrokeCount;
+        // rendering forward is cheaper than a restore when the target is near, or no keyframe lies between
+        const bool rendersForward = cacheHoldsFlushedStrokes && flushedStrokeCount <= target
+            && (target - flushedStrokeCount <= self.keyframeInterval || self.cacheView.strokeCountOfLatestPlaybackKeyframe <= flushedStrokeCount);
+        if (rendersForward) {
+            [self renderStrokesToCount:target];
+            [self didSeekToStrokeCount:target];
+            return;
         }
-
-        self.trackingBrush = [[CVSTrackingBrush alloc] initWithBrushType:currentStroke.brushType];
-        [self.trackingBrush beginTracking];
-
-        self.incrementCurrentStrokeIndex = YES;
-        self.currentStrokeComponentIndex = 0;
-        return YES;
+        self.seeking = YES;
+        const NSUInteger generation = seekGeneration;
+        [self.cacheView restorePlaybackKeyframeForStrokeCount:target completion:^(NSUInteger pKeyframeStrokeCount) {
+            self.seeking = NO;
+            if (generation != seekGeneration) {
+                return;
+            }
+            flushedStrokeCount = pKeyframeStrokeCount;
+            cacheHoldsFlushedStrokes = true;
+            @autoreleasepool {
+                // a later seek may be served by the restored keyframe, or may need another
+                if (target == seekStrokeCount) {
+                    [self renderStrokesToCount:target];
+                    [self didSeekToStrokeCount:target];
+                }
+                else {
+                    [self didSeekToStrokeCount:pKeyframeStrokeCount];
+                    [self seekToStrokeCount:seekStrokeCount];
+                }
+            }
+        }];
     }
+}
 
-    // Draw the next component
-    CVSStrokeComponent *currentComponent = [currentStroke.components objectAtIndex:self.currentStrokeComponentIndex];
-    [self drawComponent:currentComponent forStroke:currentStroke];
-
-    // Increment the component;
-    self.currentStrokeComponentIndex += 1;
+- (void)drawNextFrame
+{
+    @autoreleasepool {
+        const CFTimeInterval timestamp = self.displayLink.timestamp;
+        const CFTimeInterval interval = lastTickTimestamp ? MIN(timestamp - lastTickTimestamp, DQPlaybackStrokeViewMaximumTickInterval) : 0;
+        lastTickTimestamp = timestamp;
+        if (self.isSeeking) {
+            return;
+        }
+        const double componentsPerSecond = [self componentsPerSecond];
+        componentsDue = MIN(componentsDue + MAX(interval, 0.0) * componentsPerSecond, componentsPerSecond * DQPlaybackStrokeViewMaximumLag);
+
+        // a stroke is begun only if rendering it (with the strokes finished before it in this frame) is estimated to fit in the frame
+        CVSSCFrameBudget budget = CVSSCFrameBudgetMake(CACurrentMediaTime(), self.frameBudget);
+        // the estimated render time of the strokes finished in this frame, which are rendered into the cache together at its end
+        double finishedRenderCost = 0;
+        CVSPlaybackStrokes * const playbackStrokes = self.playbackStrokes;
+        CGRect dirtyRect = CGRectNull;
+        BOOL reachedEnd = NO;
+        while (componentsDue >= 1.0) {
+            if (activeStrokeIndex >= playbackStrokes.strokeCount) {
+                // wait for the stroke to be decoded, or stop playback if decoding has ended
+                reachedEnd = CVSPlaybackStrokesStatusDecoding != playbackStrokes.status;
+                componentsDue = 0;
+                break;
+            }
+            const CVSPlaybackStroke stroke = [playbackStrokes strokeAtIndex:activeStrokeIndex];
+            assert(activeComponentCount < stroke.componentCount);
+            if (0 == activeComponentCount) {
+                activeRenderCost = [self renderCostOfStroke:&stroke];
+                if (!CVSSCFrameBudgetCanAfford(&budget, CACurrentMediaTime() + finishedRenderCost, activeRenderCost)) {
+                    break;
+                }
+            }
+            const NSUInteger count = MIN(stroke.componentCount - activeComponentCount, (NSUInteger)componentsDue);
+            const CVSSCRect bounds = CVSSCComponentsGetStrokeBounds(&stroke.components[activeComponentCount], count, CVSBrushAttributesReferenceForBrushType(stroke.brushType)->lineWidth);
+            if (!CVSSCRectIsNull(bounds)) {
+                dirtyRect = CGRectUnion(dirtyRect, CGRectMake((CGFloat)bounds.x, (CGFloat)bounds.y, (CGFloat)bounds.width, (CGFloat)bounds.height));
+            }
+            activeComponentCount += count;
+            componentsDue -= count;
+            if (activeComponentCount < stroke.componentCount) {
+                continue;
+            }
+            // the stroke is finished. this view draws only the active stroke, so the stroke is rendered into the cache before this
+            // view is next drawn.
+            finishedRenderCost += activeRenderCost;
+            CVSSCFrameBudgetCharge(&budget);
+            ++activeStrokeIndex;
+            activeFirstComponentIndex = 0;
+            activeComponentCount = 0;
+            self.activeStrokeColor = nil;
+        }
+        [self flushFinishedStrokes];
 
-    if (self.shouldIncrementCurrentStrokeIndex) {
-        self.currentStrokeIndex -= 1;
+        if (!CGRectIsNull(dirtyRect)) {
+            [self setNeedsDisplayInRect:dirtyRect];
+        }
+        if (reachedEnd && self.isAnimating) {
+            [self stopPlayback];
+        }
     }
-
-    return NO;
 }
 
 #pragma mark - UIView
@@ -240,13 +381,15 @@
     CGContextRestoreGState(pContext);
 }
 
-- (void)drawTrackingBrush:(CGContextRef)pContext rect:(CGRect)pRect
+- (void)drawActiveStroke:(CGContextRef)pContext rect:(CGRect)pRect
 {
-    if (self.isAnimating && self.currentStrokeIndex < [self.drawing.strokes count]) {
-        CVSStroke * currentStroke = [self.drawing.strokes objectAtIndex:self.currentStrokeIndex];
+    if (self.isAnimating && !self.isSeeking && activeFirstComponentIndex < activeComponentCount && activeStrokeIndex < self.playbackStrokes.strokeCount) {
+        const CVSPlaybackStroke activeStroke = [self.playbackStrokes strokeAtIndex:activeStrokeIndex];
+        assert(activeComponentCount <= activeStroke.componentCount);
         CGContextSaveGState(pContext);
-        [self configureContext:pContext withStroke:currentStroke];
-        [self.trackingBrush addPathToContext:pContext];
+        [self configureContext:pContext withStroke:&activeStroke];
+        CGContextBeginPath(pContext);
+        [CVSStrokeRenderer addComponents:&activeStroke.components[activeFirstComponentIndex] count:activeComponentCount - activeFirstComponentIndex toPathOfContext:pContext];
         CGContextStrokePath(pContext);
         CGContextRestoreGState(pContext);
     }
@@ -254,15 +397,8 @@
 
 - (void)drawCachedAndActiveStrokes:(CGContextRef)pContext rect:(CGRect)pRect
 {
-    if (self.shouldIncrementCurrentStrokeIndex) {
-        self.currentStrokeIndex += 1;
-        self.incrementCurrentStrokeIndex = NO;
-    }
-
     [self drawCachedStrokes:pContext rect:pRect];
-    if (self.trackingBrush && self.trackingBrush.isTracking && !self.trackingBrush.isEmpty) {
-        [self drawTrackingBrush:pContext rect:pRect];
-    }
+    [self drawActiveStroke:pContext rect:pRect];
 }
 
 - (void)drawCachedAndActiveStrokesInTransparencyLayer:(CGContextRef)pContext rect:(CGRect)pRect
@@ -8,7 +8,7 @@
 
 #import <UIKit/UIKit.h>
 
-@class CVSDrawing;
+@class CVSPlaybackStrokes;
 @class CVSStrokeArray;
 @class CVSTemplateImage;
 @protocol DQPlaybackViewDelegate;
@@ -19,7 +19,7 @@
 - (id)initWithFrame:(CGRect)pFrame templateImage:(CVSTemplateImage *)pTemplateImage;
 
 @property (nonatomic, weak) id <DQPlaybackViewDelegate> delegate;
-@property (strong, nonatomic) CVSDrawing *drawing;
+@property (strong, nonatomic) CVSPlaybackStrokes *playbackStrokes;
 
 - (void)startPlayback;
 - (void)pausePlayback;
@@ -27,6 +27,12 @@
 
 - (void)clear;
 
+/**
+ @brief shows the first @p pStrokeCount strokes, from which playback continues. see -[DQPlaybackStrokeView seekToStrokeCount:].
+ */
+- (void)seekToStrokeCount:(NSUInteger)pStrokeCount;
+- (NSUInteger)playedStrokeCount;
+
 @end
 
 @protocol DQPlaybackViewDelegate <NSObject>
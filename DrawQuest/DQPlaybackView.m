@@ -12,10 +12,6 @@
 
 #import "CVSCacheView.h"
 #import "CVSDrawingTypes.h"
-#import "CVSDrawing.h"
-#import "CVSStroke.h"
-#import "CVSStrokeComponent.h"
-#import "CVSStrokeArray.h"
 #import "CVSDrawingModel.h"
 #import "DQPlaybackStrokeView.h"
 #import "CVSTemplateImage.h"
@@ -88,6 +84,7 @@
     // CVSCacheView is used here for its ability to render to a bitmap -- it is no longer part of the view graph
     // NO [self addSubview:_cacheView];
     [_cacheView drawingDidFinishLoading];
+    _cacheView.templateImage = pTemplateImage.image;
 
     _strokeView = [[DQPlaybackStrokeView alloc] initWithFrame:contentFrame templateImage:pTemplateImage cacheView:_cacheView];
     _strokeView.playbackView = self;
@@ -106,9 +103,14 @@
 
 #pragma mark - Accessors
 
-- (void)setDrawing:(CVSDrawing *)drawing
+- (void)setPlaybackStrokes:(CVSPlaybackStrokes *)playbackStrokes
 {
-    self.strokeView.drawing = drawing;
+    self.strokeView.playbackStrokes = playbackStrokes;
+}
+
+- (CVSPlaybackStrokes *)playbackStrokes
+{
+    return self.strokeView.playbackStrokes;
 }
 
 #pragma mark -
@@ -134,5 +136,15 @@
     [self.cacheView clearAllStrokesAndEraseView];
 }
 
+- (void)seekToStrokeCount:(NSUInteger)pStrokeCount
+{
+    [self.strokeView seekToStrokeCount:pStrokeCount];
+}
+
+- (NSUInteger)playedStrokeCount
+{
+    return self.strokeView.playedStrokeCount;
+}
+
 @end
 
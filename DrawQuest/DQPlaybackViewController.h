@@ -9,7 +9,6 @@
 #import "DQViewController.h"
 
 // Models
-@class CVSDrawing;
 @class DQComment;
 @class DQQuest;
 
@@ -9,7 +9,7 @@
 #import "DQPlaybackViewController.h"
 
 // Models
-#import "CVSDrawing.h"
+#import "CVSPlaybackStrokes.h"
 #import "DQComment.h"
 #import "DQQuest.h"
 
@@ -27,7 +27,7 @@
 
 @interface DQPlaybackViewController () <DQPlaybackViewDelegate>
 
-@property (nonatomic, strong) CVSDrawing *drawing;
+@property (nonatomic, strong) CVSPlaybackStrokes *playbackStrokes;
 @property (nonatomic, strong) DQComment *comment;
 @property (nonatomic, strong) DQQuest *quest;
 @property (nonatomic, strong) DQPlaybackView *playbackView;
@@ -57,8 +57,8 @@
 
 - (void)requestPreparePlaybackFromViewController:(UIViewController *)presentingViewController completionBlock:(dispatch_block_t)completionBlock failureBlock:(void (^)(NSError *error))failureBlock
 {
-    [self.playbackDataManager requestDrawingAndTemplateImageForComment:self.comment inQuest:self.quest fromViewController:presentingViewController resultBlock:^(CVSDrawing *drawing, UIImage *templateImage) {
-        self.drawing = drawing;
+    [self.playbackDataManager requestPlaybackStrokesAndTemplateImageForComment:self.comment inQuest:self.quest fromViewController:presentingViewController resultBlock:^(CVSPlaybackStrokes *playbackStrokes, UIImage *templateImage) {
+        self.playbackStrokes = playbackStrokes;
         self.templateImage = templateImage;
         if (completionBlock)
         {
@@ -98,7 +98,7 @@
     // it's possible to create a quest without a template image. use the (blank) fallback in this case.
     CVSTemplateImage * const image = self.templateImage ? [CVSTemplateImage templateImageWithUIImage:self.templateImage] : [CVSTemplateImage templateImageWithEmptyTemplateImage];
     _playbackView = [[DQPlaybackView alloc] initWithFrame:CGRectMake(0.0f, 0.0f, 1024.0f, 768.0f) templateImage:image];
-    _playbackView.drawing = self.drawing;
+    _playbackView.playbackStrokes = self.playbackStrokes;
     _playbackView.delegate = self;
     [self.view addSubview:_playbackView];
 
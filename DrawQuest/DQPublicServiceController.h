@@ -70,7 +70,8 @@
 #pragma mark - Playback
 
 - (void)requestLogPlaybackForCommentID:(NSString *)inCommentID withCompletionBlock:(DQServiceStatusBlock)inCompletionBlock;
-- (void)requestPlaybackDataForCommentID:(NSString *)inCommentID withCompletionBlock:(DQServiceCompletionBlock)inCompletionBlock;
+// the JSONObject of the completion block is the playback JSON as UTF-8 NSData
+- (void)requestPlaybackJSONDataForCommentID:(NSString *)inCommentID withCompletionBlock:(DQServiceCompletionBlock)inCompletionBlock;
 
 #pragma mark - Realtime Sync
 
@@ -641,7 +641,7 @@ NSString *DQAPIMethodGetUsersByEmail = @"existing_users_by_email";
     }];
 }
 
-- (void)requestPlaybackDataForCommentID:(NSString *)inCommentID withCompletionBlock:(DQServiceCompletionBlock)inCompletionBlock
+- (void)requestPlaybackJSONDataForCommentID:(NSString *)inCommentID withCompletionBlock:(DQServiceCompletionBlock)inCompletionBlock
 {
     __weak typeof(self) weakSelf = self;
     [self.serviceQueue hasRequestsForCommand:DQAPIMethodDownloadPlaybackData tag:inCommentID resultBlock:^(BOOL found) {
@@ -664,13 +664,9 @@ NSString *DQAPIMethodGetUsersByEmail = @"existing_users_by_email";
             playbackDataRequest.requestDidFinishBlock = ^(DQHTTPRequest *inRequest) {
                 NSDictionary *responseDictionary = inRequest.dq_responseDictionary;
                 NSString *playbackJSONString = responseDictionary.dq_playbackDataJSONString;
-                NSDictionary *playbackData = nil;
-                if (playbackJSONString)
-                {
-                    // FIXME: this uses a huge amount of memory - instead the download should
-                    // be streamed into a file and then the file should be read incrementally
-                    playbackData = [NSJSONSerialization JSONObjectWithData:[playbackJSONString dataUsingEncoding:NSUTF8StringEncoding] options:0 error:nil];
-                }
+                // the playback JSON is not parsed here. it is decoded as a stream (see CVSPlaybackStrokes).
+                // FIXME: the download should be streamed into the decoder, rather than arriving in the response dictionary
+                NSData *playbackData = [playbackJSONString dataUsingEncoding:NSUTF8StringEncoding];
 
                 if (inCompletionBlock) {
                     inCompletionBlock(inRequest, playbackData);
@@ -10,15 +10,17 @@
 
 #import "CVSDrawingTypes.h"
 
+#include "CVSSCComponent.h"
+
+@class CVSDraftImage;
 @class CVSStroke;
-@class CVSStrokeComponent;
 @class CVSStrokeArray;
 @class CVSStrokeGenerator;
 
 @protocol CVSBackedRenderer <NSObject>
 
 @required
-- (void)rendererShouldRenderStrokeComponent:(CVSStrokeComponent *)pComponent strokeGenerator:(CVSStrokeGenerator *)pStrokeGenerator;
+- (void)rendererShouldRenderStrokeComponent:(const CVSSCComponent *)pComponent strokeGenerator:(CVSStrokeGenerator *)pStrokeGenerator;
 - (void)rendererShouldFinishRenderingStroke:(CVSStroke *)pStroke strokeGenerator:(CVSStrokeGenerator *)pStrokeGenerator;
 
 - (void)rendererShouldUndoStrokes:(CVSStrokeArray *)pStrokes;
@@ -29,4 +31,19 @@
 
 - (void)drawingDidFinishLoading;
 
+/**
+ @brief shows the draft image as the first @p pStrokeCount strokes of the drawing, which are not rendered.
+ @return NO if the image could not be shown, in which case the client renders the strokes
+ */
+- (BOOL)rendererShouldRestoreDraftImage:(CVSDraftImage *)pDraftImage strokeCount:(NSUInteger)pStrokeCount;
+/**
+ @brief provides the strokes the draft image shows, once they are needed (to undo one of them).
+ */
+- (void)rendererShouldAdoptDraftImageStrokes:(CVSStrokeArray *)pStrokes;
+/**
+ @brief saves the rendering of the drawing's @p pStrokeCount strokes to the draft image.
+ @return NO if the rendering was not up to date, in which case nothing was saved
+ */
+- (BOOL)rendererShouldSaveDraftImage:(CVSDraftImage *)pDraftImage journalLength:(uint64_t)pJournalLength strokeCount:(NSUInteger)pStrokeCount;
+
 @end
@@ -12,8 +12,10 @@ typedef void(^CVSCacheViewCompletionBlock)(void);
 
 @class CVSStroke;
 @class CVSStrokeArray;
+@class CVSPlaybackStrokes;
 @class CVSDMEditorBitmapStoreReference;
 @class CVSDMImageSnapshotQueue;
+@class CVSDraftImage;
 
 @protocol CVSEditorViewDelegate;
 
@@ -23,12 +25,55 @@ typedef void(^CVSCacheViewCompletionBlock)(void);
 @interface CVSCacheView : UIView
 
 @property (nonatomic, weak, readwrite) id<CVSEditorViewDelegate> editorViewDelegate;
+/**
+ @brief the quest's template, which is shown below the view, drawn in its bounds. fills are found in the strokes composited over it, so
+ that the template's outlines bound a fill as they appear to. nil if there is none.
+ */
+@property (nonatomic, strong, readwrite) UIImage * templateImage;
 
 - (id)initWithFrame:(CGRect)pFrame bitmapStoreReference:(CVSDMEditorBitmapStoreReference *)pBitmapStoreReference imageSnapshotQueue:(CVSDMImageSnapshotQueue *)pImageSnapshotQueue enableSnapshotting:(BOOL)pEnableSnapshotting;
 
 - (BOOL)hasStrokes;
 
 - (void)enqueueAndRenderStrokes:(CVSStrokeArray *)strokes;
+/**
+ @brief renders playback strokes, which the view does not hold, in one pass over the bitmap. only for views which do not snapshot -- the strokes cannot be undone.
+ */
+- (void)renderPlaybackStrokes:(CVSPlaybackStrokes *)pPlaybackStrokes range:(NSRange)pRange;
+/**
+ @brief adds the bitmap to the playback keyframe index as the image of the first @p pStrokeCount playback strokes. keyframes of greater stroke
+ counts are invalidated. only for views which do not snapshot -- the index is kept in the image snapshot queue.
+ */
+- (void)addPlaybackKeyframeForStrokeCount:(NSUInteger)pStrokeCount;
+/**
+ @return the stroke count of the latest playback keyframe, or 0 if there are none
+ */
+- (NSUInteger)strokeCountOfLatestPlaybackKeyframe;
+/**
+ @brief restores the bitmap from the latest playback keyframe of at most @p pStrokeCount strokes (or clears it, when there is none) asynchronously.
+ @p pCompletion is called on the main queue with the keyframe's stroke count. the client then renders the strokes which follow it.
+ */
+- (void)restorePlaybackKeyframeForStrokeCount:(NSUInteger)pStrokeCount completion:(void(^)(NSUInteger pKeyframeStrokeCount))pCompletion;
+/**
+ @brief shows the draft image as the bitmap of the first @p pStrokeCount strokes of the drawing, which the view does not hold
+ (the base strokes). the view must hold no strokes. strokes enqueued later are rendered over the image.
+ @details the image remains the keyframe of the base strokes until -adoptBaseStrokes: provides them.
+ @return NO if the image is not of the bitmap's dimensions
+ */
+- (BOOL)restoreDraftImage:(CVSDraftImage *)pDraftImage strokeCount:(NSUInteger)pStrokeCount;
+/**
+ @return the number of strokes which are shown but not held (see -restoreDraftImage:strokeCount:)
+ */
+- (NSUInteger)baseStrokeCount;
+/**
+ @brief holds the base strokes, which are already rendered, so that they may be undone. the view must hold no other strokes.
+ */
+- (void)adoptBaseStrokes:(CVSStrokeArray *)pStrokes;
+/**
+ @brief saves the bitmap to the draft image, if it is up to date and shows @p pStrokeCount strokes.
+ @return NO if it was not saved
+ */
+- (BOOL)saveDraftImage:(CVSDraftImage *)pDraftImage journalLength:(uint64_t)pJournalLength strokeCount:(NSUInteger)pStrokeCount;
 - (CVSStroke *)dequeueTopStroke;
 - (CVSStrokeArray *)dequeueStrokesAndClearCache;
 - (void)clearAllStrokesAndEraseView;
@@ -13,9 +13,13 @@
 #import "CVSStroke.h"
 #import "CVSEditorViewRenderOptions.h"
 #import "CVSStrokeArray.h"
+#import "CVSPlaybackStrokes.h"
+#import "CVSStrokeRenderer.h"
 #import "CVSStrictGeometry.h"
 #import "CVSViewsStrokeArray.h"
 #import "CVSDrawingModel.h"
+#import "CVSDraftImage.h"
+#import "CVSUndoRegionStack.h"
 #import "DQHUDView.h"
 
 @interface CVSCacheView ()
@@ -25,12 +29,28 @@
 // @todo JC: rather than -drawRect:, use layers
 @property (nonatomic, strong, readwrite) CVSDMEditorBitmapStoreReference * bitmapStoreReference;
 @property (nonatomic, readonly) CVSDMImageSnapshotQueue * imageSnapshotQueue;
+// the keyframe of the base strokes
+@property (nonatomic, strong) CVSDraftImage * draftImage;
+// the regions under the latest strokes, which undo writes back rather than restoring a snapshot
+@property (nonatomic, readonly) CVSUndoRegionStack * undoRegions;
 
 @end
 
+// restores which complete sooner than this do not show progress
+static const NSTimeInterval CVSCacheViewRestoreProgressDelay = 0.15;
+
 @implementation CVSCacheView
 {
     bool enableSnapshotting;
+    // true when strokes were undone and the bitmap must be restored from a snapshot
+    bool needsRenderFromSnapshot;
+    // true while an asynchronous restore is writing to the bitmap. strokes enqueued meanwhile are rendered when it completes.
+    bool isRestoring;
+    // true while the editor shows that a time consuming undo is in progress, for a restore which has not completed quickly
+    bool isShowingRestoreProgress;
+    NSUInteger restoreGeneration;
+    // the strokes at the bottom of the stack which are shown by the draft image, and are not held
+    NSUInteger baseStrokeCount;
 }
 
 - (id)initWithFrame:(CGRect)pFrame
@@ -62,6 +82,11 @@
         assert(0 && "invalid image snapshot queue");
         return nil;
     }
+    // without snapshotting, strokes are not undone
+    _undoRegions = [[CVSUndoRegionStack alloc] initWithMemoryBudget:CVSUndoRegionStackDefaultMemoryBudget depth:enableSnapshotting ? CVSUndoRegionStackDefaultDepth : 0];
+    if (!_undoRegions) {
+        return nil;
+    }
     self.opaque = NO;
     return self;
 }
@@ -78,9 +103,8 @@
     // if snapshotting is enabled, make sure we have the latest and most complete information.
     // if not, the client is managing that aspect (e.g. the playback view -- append only)
     if (enableSnapshotting) {
-        while (false == [self renderFromSnapshot]) {
-            /* i recommend this to be async where possible. it could take a while for a snapshot to load. */
-        }
+        // the restore is asynchronous. until it completes, the bitmap's present content is drawn.
+        [self renderFromSnapshot];
     }
     [self.bitmapStoreReference drawImageInRect:pRect context:pContext];
 }
@@ -114,18 +138,7 @@
 
 - (void)rebuildSnapshotCache
 {
-    if (CVSDMImageSnapshotQueue_ApplyHack_NotSoSlowIn_3_0_0()) {
-        // memory cache only in this scenario
-        return;
-    }
-    @autoreleasepool {
-        [self incrementTimeConsumingUndo];
-        // this is a quick implementation of a full rebuild. partial rebuild would probably be best UX.
-        for (CVSStroke * at in self.dequeueStrokesAndClearCache) {
-            [self enqueueAndRenderStrokes:[CVSStrokeArray newStrokeArrayWithStroke:at]];
-        }
-        [self decrementTimeConsumingUndo];
-    }
+    // nothing to rebuild. the snapshot queue evicts by distance from the current stroke count, so snapshots remain spread back through the drawing after many undos.
 }
 
 #pragma mark - Rasterization
@@ -150,9 +163,6 @@
 
 - (void)incrementTimeConsumingUndo
 {
-    if (CVSDMImageSnapshotQueue_ApplyHack_NotSoSlowIn_3_0_0()) {
-        assert(0 && "hack should have no time consuming undos (fs reads)");
-    }
     id<CVSEditorViewDelegate> delegate = self.editorViewDelegate;
     assert(delegate);
     const NSUInteger depth = delegate.timeConsumingUndoWillBegin;
@@ -167,7 +177,6 @@
     if (0 != depth) {
         return;
     }
-    [self renderFromSnapshot];
     [self setNeedsDisplay];
 }
 
@@ -175,7 +184,18 @@
 
 - (BOOL)hasStrokes
 {
-    return self.cachedStrokes.hasStrokes;
+    return 0 != baseStrokeCount || self.cachedStrokes.hasStrokes;
+}
+
+- (NSUInteger)baseStrokeCount
+{
+    return baseStrokeCount;
+}
+
+// the number of strokes the bitmap shows, when it is up to date
+- (NSUInteger)strokeCount
+{
+    return baseStrokeCount + self.cachedStrokes.count;
 }
 
 - (void)invalidateSnapshotsGreaterThan:(NSUInteger)pValue
@@ -192,58 +212,163 @@
 - (void)provideBitmapForSnapshotting
 {
     if (enableSnapshotting) {
-        [self invalidateSnapshotsGreaterThanOrEqualTo:self.cachedStrokes.count];
-        [self.imageSnapshotQueue enqueueSnapshotForStrokeCount:self.cachedStrokes.count bitmapReference:self.bitmapStoreReference];
+        [self invalidateSnapshotsGreaterThanOrEqualTo:self.strokeCount];
+        [self.imageSnapshotQueue enqueueSnapshotForStrokeCount:self.strokeCount bitmapReference:self.bitmapStoreReference];
     }
 }
 
 - (void)strokeCountDidChange
 {
-    [self invalidateSnapshotsGreaterThan:self.cachedStrokes.count];
+    [self invalidateSnapshotsGreaterThan:self.strokeCount];
 }
 
-// returns true if the bitmap is up to date
+// returns true if the bitmap is up to date. otherwise, a restore is in progress and the view is redisplayed when it completes.
 - (bool)renderFromSnapshot
 {
+    if (isRestoring) {
+        return false;
+    }
+    if (!needsRenderFromSnapshot) {
+        return true;
+    }
+    needsRenderFromSnapshot = false;
     if (!self.hasStrokes) {
         [self clearBitmap];
         return true;
     }
-    while (1) {
-        CVSDMImageSnapshotQueue * const snapshotQueue = self.imageSnapshotQueue;
-        [self invalidateSnapshotsGreaterThan:self.cachedStrokes.count];
-        BOOL outIsImporting = NO;
-        const NSUInteger strokeCountOfLoadedSnapshot = [snapshotQueue loadMostRecentSnapshot:self.bitmapStoreReference outIsImporting:&outIsImporting initiationBlock:^{
+    [self invalidateSnapshotsGreaterThan:self.strokeCount];
+    isRestoring = true;
+    const NSUInteger generation = ++restoreGeneration;
+    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(CVSCacheViewRestoreProgressDelay * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+        if (isRestoring && generation == restoreGeneration && !isShowingRestoreProgress) {
+            isShowingRestoreProgress = true;
             [self incrementTimeConsumingUndo];
-            return ^{[self decrementTimeConsumingUndo];};
-        }];
-        if (outIsImporting) {
-            return false;
         }
-        if (CVSDMImageSnapshot_NonSnapshotStrokeCount == strokeCountOfLoadedSnapshot) {
-            [self clearBitmap];
+    });
+    [self.imageSnapshotQueue restoreMostRecentSnapshotTo:self.bitmapStoreReference completion:^(NSUInteger pStrokeCount) {
+        isRestoring = false;
+        [self renderStrokesFollowingSnapshot:pStrokeCount];
+        if (isRestoring) {
+            // another restore was needed. it completes the progress.
+            return;
         }
-        const NSUInteger nStrokes = self.cachedStrokes.count;
-        if (nStrokes == strokeCountOfLoadedSnapshot) {
-            return true;
+        if (isShowingRestoreProgress) {
+            isShowingRestoreProgress = false;
+            [self decrementTimeConsumingUndo];
         }
-        else if (strokeCountOfLoadedSnapshot < nStrokes) {
-            CVSStrokeArray * const allStrokes = self.cachedStrokes.copyStrokeArray;
-            const NSUInteger nStrokesToRender = allStrokes.count - strokeCountOfLoadedSnapshot;
-            CVSStrokeArray * const strokesToRender = [allStrokes dequeueLastNStrokes:nStrokesToRender];
-            [self.bitmapStoreReference renderUsingContextRenderBlock:^(CGContextRef pContext) {
-                const CGFloat scale = [[self class] screenScale];
-                CGContextScaleCTM(pContext, scale, scale);
-                [strokesToRender renderInContext:pContext clippingRect:(CGRect){CGPointZero, self.bitmapStoreReference.bitmapDimensionsAsCGSize}];
-            }];
+        else {
+            [self setNeedsDisplay];
+        }
+    }];
+    return false;
+}
+
+- (void)renderStrokesFollowingSnapshot:(NSUInteger)pStrokeCountOfSnapshot
+{
+    if (needsRenderFromSnapshot) {
+        // strokes were undone or cleared during the restore -- the snapshot may no longer apply
+        [self renderFromSnapshot];
+        return;
+    }
+    if (!self.hasStrokes) {
+        [self clearBitmap];
+        return;
+    }
+    if (CVSDMImageSnapshot_NonSnapshotStrokeCount == pStrokeCountOfSnapshot) {
+        [self clearBitmap];
+    }
+    if (pStrokeCountOfSnapshot < baseStrokeCount) {
+        // the snapshots of the base strokes were evicted. the draft image is their keyframe.
+        const BOOL didRestore = [self.draftImage restoreToBitmap:self.bitmapStoreReference];
+        assert(didRestore && "the draft image was restored before");
+#pragma unused(didRestore)
+        pStrokeCountOfSnapshot = baseStrokeCount;
+        if (self.strokeCount == baseStrokeCount) {
             [self provideBitmapForSnapshotting];
-            return true;
+            return;
         }
-        else {
-            // retry render
-            assert(0 && "can this really not be avoided?");
+    }
+    const NSUInteger nStrokes = self.strokeCount;
+    assert(pStrokeCountOfSnapshot <= nStrokes);
+    if (nStrokes == pStrokeCountOfSnapshot) {
+        return;
+    }
+    CVSStrokeArray * const allStrokes = self.cachedStrokes.copyStrokeArray;
+    const NSUInteger nStrokesToRender = nStrokes - pStrokeCountOfSnapshot;
+    CVSStrokeArray * const strokesToRender = [allStrokes dequeueLastNStrokes:nStrokesToRender];
+    [self renderStrokes:strokesToRender strokeIndex:pStrokeCountOfSnapshot];
+    [self provideBitmapForSnapshotting];
+}
+
+// packs the tiles which @p pRect (user space) intersects. the renderer marks no other tiles for a stroke within the rect.
+static NSData * CVSCacheViewNewRegion(CGContextRef pContext, CVSDMTileGrid * pTileGrid, const CGRect pRect)
+{
+    // outset by a pixel for antialiasing, as the renderer does
+    const CGRect deviceRect = CGRectInset(CGContextConvertRectToDeviceSpace(pContext, pRect), -1.0, -1.0);
+    const CVSDMTileRange range = CVSDMTileGridGetTileRangeForRect(pTileGrid, deviceRect);
+    const uint32_t columnCount = CVSDMTileGridGetColumnCount(pTileGrid);
+    size_t length = 0;
+    for (uint32_t row = range.minRow; row < range.maxRow; ++row) {
+        for (uint32_t column = range.minColumn; column < range.maxColumn; ++column) {
+            length += sizeof(CVSDMPackedTileHeader) + CVSDMTileGridGetTileByteCount(pTileGrid, (size_t)row * columnCount + column);
+        }
+    }
+    NSMutableData * const result = [[NSMutableData alloc] initWithLength:length];
+    if (!result) {
+        return nil;
+    }
+    const void * const pixels = CGBitmapContextGetData(pContext);
+    const size_t bytesPerRow = CGBitmapContextGetBytesPerRow(pContext);
+    char * at = result.mutableBytes;
+    for (uint32_t row = range.minRow; row < range.maxRow; ++row) {
+        for (uint32_t column = range.minColumn; column < range.maxColumn; ++column) {
+            const size_t tileIndex = (size_t)row * columnCount + column;
+            const CVSDMPackedTileHeader header = {(uint32_t)tileIndex, (uint32_t)CVSDMTileGridGetTileByteCount(pTileGrid, tileIndex)};
+            memcpy(at, &header, sizeof(header));
+            at += sizeof(header);
+            CVSDMTileGridCopyTilePixels(pTileGrid, tileIndex, pixels, bytesPerRow, at);
+            at += header.byteCount;
         }
     }
+    return result;
+}
+
+/**
+ @brief renders @p pStrokes, the strokes at @p pStrokeIndex and above, over the bitmap of the strokes below them. the regions under
+ the latest of them are saved for undo before each is rendered.
+ */
+- (void)renderStrokes:(CVSStrokeArray *)pStrokes strokeIndex:(NSUInteger)pStrokeIndex
+{
+    const NSUInteger count = pStrokes.count;
+    const NSUInteger nSaved = MIN(count, self.undoRegions.depth);
+    CVSStrokeArray * const unsavedStrokes = [CVSStrokeArray new];
+    [unsavedStrokes addStrokes:pStrokes];
+    CVSStrokeArray * const savedStrokes = [unsavedStrokes dequeueLastNStrokes:nSaved];
+    // the template is shown below the view, in its bounds
+    CGImageRef const templateImage = self.templateImage.CGImage;
+    const CGRect templateRect = self.bounds;
+    [self.bitmapStoreReference renderUsingTiledContextRenderBlock:^(CGContextRef pContext, CVSDMTileGrid * pTileGrid) {
+        const CGFloat scale = [[self class] screenScale];
+        CGContextScaleCTM(pContext, scale, scale);
+        const CGRect clippingRect = (CGRect){CGPointZero, self.bitmapStoreReference.bitmapDimensionsAsCGSize};
+        [unsavedStrokes renderInContext:pContext clippingRect:clippingRect tileGrid:pTileGrid fillUnderlay:templateImage rect:templateRect];
+        NSUInteger strokeIndex = pStrokeIndex + unsavedStrokes.count;
+        for (CVSStroke * at in savedStrokes.strokes) {
+            const CGRect bounds = at.bounds;
+            const bool isVisible = CGRectIntersectsRect(clippingRect, bounds);
+            NSData * const region = isVisible ? CVSCacheViewNewRegion(pContext, pTileGrid, bounds) : [NSData data];
+            if (region) {
+                [self.undoRegions pushRegion:region strokeIndex:strokeIndex];
+            }
+            else {
+                [self.undoRegions removeRegionsFromStrokeIndex:strokeIndex];
+            }
+            if (isVisible) {
+                [[CVSStrokeArray newStrokeArrayWithStroke:at] renderInContext:pContext clippingRect:clippingRect tileGrid:pTileGrid fillUnderlay:templateImage rect:templateRect];
+            }
+            ++strokeIndex;
+        }
+    }];
 }
 
 - (void)enqueueAndRenderStrokes:(CVSStrokeArray *)strokes
@@ -252,16 +377,113 @@
         assert(0 && "careful what you push around to avoid unnecessary drawing");
         return;
     }
-    [self invalidateSnapshotsGreaterThan:self.cachedStrokes.count];
-    [self.bitmapStoreReference renderUsingContextRenderBlock:^(CGContextRef pContext) {
+    [self invalidateSnapshotsGreaterThan:self.strokeCount];
+    if (isRestoring) {
+        // rendered when the restore completes
+        [self.cachedStrokes addStrokes:strokes toView:self];
+        [self strokeCountDidChange];
+        return;
+    }
+    [self renderStrokes:strokes strokeIndex:self.strokeCount];
+    [self.cachedStrokes addStrokes:strokes toView:self];
+    [strokes purgeStrokesCachedPaths];
+    [self strokeCountDidChange];
+    [self provideBitmapForSnapshotting];
+}
+
+- (void)renderPlaybackStrokes:(CVSPlaybackStrokes *)pPlaybackStrokes range:(NSRange)pRange
+{
+    assert(pPlaybackStrokes);
+    assert(NSMaxRange(pRange) <= pPlaybackStrokes.strokeCount);
+    // the bitmap would not match the snapshots, and could not be restored
+    assert(!enableSnapshotting);
+    assert(!isRestoring);
+    if (!pRange.length) {
+        return;
+    }
+    CGImageRef const templateImage = self.templateImage.CGImage;
+    const CGRect templateRect = self.bounds;
+    [self.bitmapStoreReference renderUsingTiledContextRenderBlock:^(CGContextRef pContext, CVSDMTileGrid * pTileGrid) {
         const CGFloat scale = [[self class] screenScale];
         CGContextScaleCTM(pContext, scale, scale);
-        [strokes renderInContext:pContext clippingRect:(CGRect){CGPointZero, self.bitmapStoreReference.bitmapDimensionsAsCGSize}];
+        const CGRect clippingRect = (CGRect){CGPointZero, self.bitmapStoreReference.bitmapDimensionsAsCGSize};
+        for (NSUInteger idx = pRange.location; idx < NSMaxRange(pRange); ++idx) {
+            const CVSPlaybackStroke stroke = [pPlaybackStrokes strokeAtIndex:idx];
+            [CVSStrokeRenderer renderComponents:stroke.components count:stroke.componentCount brushType:stroke.brushType strokeColor:CVSPlaybackStrokeColor(&stroke) clippingRect:clippingRect context:pContext tileGrid:pTileGrid fillUnderlay:templateImage rect:templateRect];
+        }
     }];
-    [self.cachedStrokes addStrokes:strokes toView:self];
-    [strokes purgeStrokesCachedPaths];
+}
+
+- (void)addPlaybackKeyframeForStrokeCount:(NSUInteger)pStrokeCount
+{
+    assert(!enableSnapshotting);
+    assert(!isRestoring);
+    [self.imageSnapshotQueue enqueueSnapshotForStrokeCount:pStrokeCount bitmapReference:self.bitmapStoreReference];
+}
+
+- (NSUInteger)strokeCountOfLatestPlaybackKeyframe
+{
+    assert(!enableSnapshotting);
+    return self.imageSnapshotQueue.strokeCountOfMostRecentSnapshot;
+}
+
+- (void)restorePlaybackKeyframeForStrokeCount:(NSUInteger)pStrokeCount completion:(void(^)(NSUInteger pKeyframeStrokeCount))pCompletion
+{
+    assert(!enableSnapshotting);
+    assert(!isRestoring);
+    assert(pCompletion);
+    isRestoring = true;
+    void (^ const completion)(NSUInteger) = [pCompletion copy];
+    [self.imageSnapshotQueue restoreSnapshotForStrokeCount:pStrokeCount to:self.bitmapStoreReference completion:^(NSUInteger pStrokeCountOfSnapshot) {
+        isRestoring = false;
+        if (CVSDMImageSnapshot_NonSnapshotStrokeCount == pStrokeCountOfSnapshot) {
+            [self clearBitmap];
+        }
+        completion(pStrokeCountOfSnapshot);
+    }];
+}
+
+- (BOOL)restoreDraftImage:(CVSDraftImage *)pDraftImage strokeCount:(NSUInteger)pStrokeCount
+{
+    assert(pDraftImage);
+    assert(pStrokeCount);
+    assert(enableSnapshotting && "the base strokes could not be restored without the snapshots");
+    assert(!self.hasStrokes);
+    assert(!isRestoring);
+    if (![pDraftImage restoreToBitmap:self.bitmapStoreReference]) {
+        return NO;
+    }
+    needsRenderFromSnapshot = false;
+    baseStrokeCount = pStrokeCount;
+    self.draftImage = pDraftImage;
+    [self.undoRegions removeAllRegions];
     [self strokeCountDidChange];
     [self provideBitmapForSnapshotting];
+    [self setNeedsDisplay];
+    return YES;
+}
+
+- (void)adoptBaseStrokes:(CVSStrokeArray *)pStrokes
+{
+    assert(pStrokes.count == baseStrokeCount);
+    assert(!self.cachedStrokes.hasStrokes && "the base strokes are at the bottom of the stack");
+    if (!baseStrokeCount) {
+        return;
+    }
+    [self.cachedStrokes addStrokes:pStrokes toView:self];
+    [pStrokes purgeStrokesCachedPaths];
+    baseStrokeCount = 0;
+    self.draftImage = nil;
+}
+
+- (BOOL)saveDraftImage:(CVSDraftImage *)pDraftImage journalLength:(uint64_t)pJournalLength strokeCount:(NSUInteger)pStrokeCount
+{
+    assert(pDraftImage);
+    if (!enableSnapshotting || isRestoring || needsRenderFromSnapshot || pStrokeCount != self.strokeCount) {
+        return NO;
+    }
+    [pDraftImage saveBitmap:self.bitmapStoreReference journalLength:pJournalLength strokeCount:pStrokeCount];
+    return YES;
 }
 
 - (void)clearAllStrokesAndEraseView
@@ -277,6 +499,17 @@
     CVSStroke * const stroke = [self.cachedStrokes dequeueLastStroke:self];
     assert(stroke);
     [self strokeCountDidChange];
+    // the region under the stroke is written back if the bitmap shows the stroke. otherwise, or when the region was not
+    // saved, the bitmap is restored from a snapshot.
+    const bool isBitmapUpToDate = !isRestoring && !needsRenderFromSnapshot;
+    NSData * const region = isBitmapUpToDate ? [self.undoRegions popRegionForStrokeIndex:self.strokeCount] : nil;
+    if (region) {
+        [self.bitmapStoreReference writeTiles:@[region] skippingTilesNotModifiedSinceStamp:0];
+        [self setNeedsDisplay];
+        return stroke;
+    }
+    [self.undoRegions removeRegionsFromStrokeIndex:self.strokeCount];
+    needsRenderFromSnapshot = true;
     [self renderFromSnapshot];
     return stroke;
 }
@@ -289,8 +522,15 @@
 - (CVSStrokeArray *)dequeueStrokesAndClearCache
 {
     CVSStrokeArray * strokes = [self.cachedStrokes dequeueAllStrokes:self];
+    baseStrokeCount = 0;
+    self.draftImage = nil;
+    [self.undoRegions removeAllRegions];
     [self strokeCountDidChange];
     [self clearBitmap];
+    if (isRestoring) {
+        // the restore in progress would write over the cleared bitmap
+        needsRenderFromSnapshot = true;
+    }
     return strokes;
 }
 
@@ -0,0 +1,53 @@
+// CVSDraftImage.h
+// Editor
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+#import "CVSDrawingModel.h"
+
+/**
+ @class the cache view's bitmap as it was when the draft was last put away, with the journal length and stroke count it
+ shows -- so that a draft is shown without rendering its strokes when it is opened again.
+ @details the file holds the tiles of the bitmap which had been drawn to (CVSDMMutableBitmap packed tiles), after a
+ header. it is mapped when it is read, and written on an I/O queue, atomically: a crash leaves the previous image.
+ */
+@interface CVSDraftImage : NSObject
+
+- (instancetype)initWithPath:(NSString *)pPath;
+
+@property (nonatomic, readonly) NSString * path;
+
+/**
+ @brief maps the image and reads its header.
+ @return NO if there is no image, or it is damaged
+ */
+- (BOOL)read;
+
+/**
+ @brief the journal length (CVSStrokeJournal appendedLength) of the image which was read
+ */
+@property (nonatomic, readonly) uint64_t journalLength;
+
+/**
+ @brief the number of strokes the image which was read shows
+ */
+@property (nonatomic, readonly) NSUInteger strokeCount;
+
+/**
+ @brief clears the bitmap and writes the tiles of the image which was read to it.
+ @return NO if the image is not of the bitmap's dimensions
+ */
+- (BOOL)restoreToBitmap:(CVSDMEditorBitmapStoreReference *)pBitmapReference;
+
+/**
+ @brief copies the bitmap's tiles (on the calling thread) and replaces the image with them on the I/O queue.
+ */
+- (void)saveBitmap:(CVSDMEditorBitmapStoreReference *)pBitmapReference journalLength:(uint64_t)pJournalLength strokeCount:(NSUInteger)pStrokeCount;
+
+/**
+ @brief removes the image once the saves in progress have completed.
+ */
+- (void)remove;
+
+@end
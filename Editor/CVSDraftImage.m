@@ -0,0 +1,164 @@
+// CVSDraftImage.m
+// Editor
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#import "CVSDraftImage.h"
+
+static const uint32_t CVSDraftImageSignature = 0x49535643; // 'CVSI'
+static const uint16_t CVSDraftImageVersion = 1;
+
+typedef struct {
+    uint32_t signature;
+    uint16_t version;
+    uint16_t reserved;
+    uint32_t width;
+    uint32_t height;
+    uint64_t journalLength;
+    uint64_t strokeCount;
+} CVSDraftImageHeader;
+
+@interface CVSDraftImage ()
+
+@property (nonatomic, readonly) CVSDMFileSystemIOQueue * fileSystemIOQueue;
+// the mapping of the image which was read
+@property (nonatomic, strong) CVSDMImmutableDataReference * dataReference;
+
+@end
+
+@implementation CVSDraftImage
+{
+    CVSDraftImageHeader header;
+}
+
+@synthesize path = _path;
+@synthesize fileSystemIOQueue = _fileSystemIOQueue;
+
+- (id)init
+{
+    assert(0 && "invalid initializer");
+    return nil;
+}
+
+- (instancetype)initWithPath:(NSString *)pPath
+{
+    assert(pPath);
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    _path = [pPath copy];
+    _fileSystemIOQueue = [CVSDMFileSystemIOQueue serialQueue];
+    if (!_fileSystemIOQueue) {
+        assert(0 && "failed to create I/O queue");
+        return nil;
+    }
+    return self;
+}
+
+#pragma mark - Reading
+
+- (BOOL)read
+{
+    self.dataReference = nil;
+    CVSDMImmutableDataReference * const dataReference = [[CVSDMImmutableDataReference alloc] initWithMappedFileAtURL:[NSURL fileURLWithPath:self.path]];
+    NSData * const data = dataReference.data;
+    if (sizeof(header) > data.length) {
+        return NO;
+    }
+    memcpy(&header, data.bytes, sizeof(header));
+    if (CVSDraftImageSignature != header.signature || CVSDraftImageVersion != header.version) {
+        return NO;
+    }
+    // the tiles must end with the file
+    const char * at = (const char *)data.bytes + sizeof(header);
+    const char * const end = (const char *)data.bytes + data.length;
+    while (at < end) {
+        CVSDMPackedTileHeader tile;
+        if ((size_t)(end - at) < sizeof(tile)) {
+            return NO;
+        }
+        memcpy(&tile, at, sizeof(tile));
+        at += sizeof(tile);
+        if ((size_t)(end - at) < tile.byteCount) {
+            return NO;
+        }
+        at += tile.byteCount;
+    }
+    self.dataReference = dataReference;
+    return YES;
+}
+
+- (uint64_t)journalLength
+{
+    return self.dataReference ? header.journalLength : 0;
+}
+
+- (NSUInteger)strokeCount
+{
+    return self.dataReference ? (NSUInteger)header.strokeCount : 0;
+}
+
+- (BOOL)restoreToBitmap:(CVSDMEditorBitmapStoreReference *)pBitmapReference
+{
+    assert(pBitmapReference);
+    NSData * const data = self.dataReference.data;
+    if (!data) {
+        assert(0 && "the image was not read");
+        return NO;
+    }
+    if (!CVSDMBitmapDimensionsAreEqual(CVSDMBitmapDimensionsMake(header.width, header.height), pBitmapReference.bitmapDimensions)) {
+        return NO;
+    }
+    // the tiles which were never drawn to were not saved. clearing marks every tile, so that every saved tile is written.
+    [pBitmapReference clear];
+    NSData * const tiles = [[NSData alloc] initWithBytesNoCopy:(char *)data.bytes + sizeof(header) length:data.length - sizeof(header) freeWhenDone:NO];
+    [pBitmapReference writeTiles:@[tiles] skippingTilesNotModifiedSinceStamp:0];
+    return YES;
+}
+
+#pragma mark - Writing
+
+- (void)saveBitmap:(CVSDMEditorBitmapStoreReference *)pBitmapReference journalLength:(uint64_t)pJournalLength strokeCount:(NSUInteger)pStrokeCount
+{
+    assert(pBitmapReference);
+    uint64_t modificationStamp = 0;
+    size_t tileCount = 0;
+    NSData * const tiles = [pBitmapReference newTilesModifiedSinceStamp:0 outModificationStamp:&modificationStamp outTileCount:&tileCount];
+    if (!tiles) {
+        return;
+    }
+    const CVSDMBitmapDimensions dimensions = pBitmapReference.bitmapDimensions;
+    const CVSDraftImageHeader imageHeader = {
+        .signature = CVSDraftImageSignature,
+        .version = CVSDraftImageVersion,
+        .width = dimensions.width,
+        .height = dimensions.height,
+        .journalLength = pJournalLength,
+        .strokeCount = pStrokeCount
+    };
+    NSString * const path = self.path;
+    [self.fileSystemIOQueue dispatch:^{
+        @autoreleasepool {
+            NSMutableData * const data = [[NSMutableData alloc] initWithCapacity:sizeof(imageHeader) + tiles.length];
+            [data appendBytes:&imageHeader length:sizeof(imageHeader)];
+            [data appendData:tiles];
+            NSError * error = nil;
+            if (![data writeToFile:path options:NSDataWritingAtomic error:&error]) {
+                NSLog(@"CVSDraftImage: could not write %@ (%@)", path, error);
+                return;
+            }
+            [[NSURL fileURLWithPath:path] setResourceValue:@YES forKey:NSURLIsExcludedFromBackupKey error:nil];
+        }
+    }];
+}
+
+- (void)remove
+{
+    self.dataReference = nil;
+    NSString * const path = self.path;
+    [self.fileSystemIOQueue dispatch:^{
+        [[NSFileManager new] removeItemAtPath:path error:NULL];
+    }];
+}
+
+@end
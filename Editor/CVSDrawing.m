@@ -60,10 +60,9 @@
     NSString *drawingPreamble = [NSString stringWithFormat:@"{\"usesTemplate\":%@,\"strokes\":[", self.usesTemplate ? @"1" : @"0"];
     [handle writeData:[drawingPreamble dataUsingEncoding:NSUTF8StringEncoding]];
 
-    // keep a cache of the JSON representation of stroke colors
-    NSMutableDictionary *colors = [[NSMutableDictionary alloc] init];
+    // the JSON representation of the stroke colors, by index in the color cache. the palette is small.
     CVSUniqueUIColorCache * colorCache = self.uniqueUIColorCache;
-    
+    NSMutableArray *colorJSONs = [[NSMutableArray alloc] init];
 
     // write the strokes of the drawing
     [self.strokes enumerateObjectsUsingBlock:^(CVSStroke *stroke, NSUInteger idx, BOOL *_) {
@@ -73,16 +72,25 @@
             [handle writeData:commaData];
         }
 
-        // look up the strokeColor's JSON from the cache, creating/caching its JSON if necessary
-        // since we currently have a very limited palette, this cache will not become too big
-        UIColor * strokeColor = stroke.strokeColor;
-        id colorKey = [colorCache uniqueUIColor:strokeColor];
-        NSString *colorJSON = [colors objectForKey:colorKey];
-        if (!colorJSON)
+        // look up the strokeColor's JSON by the color's index, creating the JSON if necessary
+        CVSColorIndex colorIndex = stroke.colorIndex;
+        if (CVSColorIndexNone == colorIndex)
+        {
+            colorIndex = [colorCache indexOfUIColor:stroke.strokeColor];
+        }
+        NSString *colorJSON = colorIndex < colorJSONs.count ? colorJSONs[colorIndex] : nil;
+        if (![colorJSON isKindOfClass:[NSString class]])
         {
-            NSData *JSONData = [NSJSONSerialization dataWithJSONObject:DQDictionaryFromColor(strokeColor) options:0 error:nil];
+            NSData *JSONData = [NSJSONSerialization dataWithJSONObject:DQDictionaryFromColor(stroke.strokeColor) options:0 error:nil];
             colorJSON = [[NSString alloc] initWithData:JSONData encoding:NSUTF8StringEncoding];
-            [colors setObject:colorJSON forKey:colorKey];
+            if (CVSColorIndexNone != colorIndex)
+            {
+                while (colorJSONs.count <= colorIndex)
+                {
+                    [colorJSONs addObject:[NSNull null]];
+                }
+                colorJSONs[colorIndex] = colorJSON;
+            }
         }
 
         // write the preamble of the current stroke
@@ -90,15 +98,19 @@
         [handle writeData:[strokePreamble dataUsingEncoding:NSUTF8StringEncoding]];
 
         // write the components for the current stroke
-        [stroke.components enumerateObjectsUsingBlock:^(CVSStrokeComponent *comp, NSUInteger idx, BOOL *_) {
+        const CVSSCComponent * const components = stroke.componentRecords;
+        const NSUInteger componentCount = stroke.componentCount;
+        for (NSUInteger idx = 0; idx < componentCount; ++idx)
+        {
             // JSON doesn't allow trailing commas, so only write out a comma before the 2nd or later iterations
             if (idx)
             {
                 [handle writeData:commaData];
             }
             // components have a "constant" size so it's safe to use JSONKit's serializer to serialize them directly
-            [handle writeData:[NSJSONSerialization dataWithJSONObject:[comp componentRepresentation] options:0 error:nil]];
-        }];
+            NSDictionary *representation = [CVSStrokeComponent componentRepresentationWithPackedComponent:&components[idx]];
+            [handle writeData:[NSJSONSerialization dataWithJSONObject:representation options:0 error:nil]];
+        }
         // end the stroke with postamble to close the components array and object
         [handle writeData:postambleData];
     }];
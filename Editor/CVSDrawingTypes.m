@@ -20,6 +20,7 @@ UIBezierPath * CVSBrushTypeCreateUIBezierPathWithType(const CVSBrushType pBrushT
 
 #pragma mark - CVSBrushAttributes
 
+// the portable equivalents of these values are in CVSSCBrush.c. keep them in sync.
 static CVSBrushAttributes kDefaultPenBrushAttributes = {
     .brushType = CVSBrushTypePen,
     .lineWidth = 2.9f,
@@ -52,6 +53,23 @@ static CVSBrushAttributes kDefaultEraserBrushAttributes = {
     .lineCap = kCGLineCapRound
 };
 
+// spraypaint and crayon stamp dabs (CVSSCStamp) rather than stroking. their width and alpha are the extent and opacity of the dabs.
+static CVSBrushAttributes kDefaultSpraypaintBrushAttributes = {
+    .brushType = CVSBrushTypeSpraypaint,
+    .lineWidth = 32.0f,
+    .alpha = 1.0f,
+    .lineJoin = kCGLineJoinRound,
+    .lineCap = kCGLineCapRound
+};
+
+static CVSBrushAttributes kDefaultCrayonBrushAttributes = {
+    .brushType = CVSBrushTypeCrayon,
+    .lineWidth = 8.0f,
+    .alpha = 0.9f,
+    .lineJoin = kCGLineJoinRound,
+    .lineCap = kCGLineCapRound
+};
+
 static CVSBrushAttributes kDefaultPaintbucketBrushAttributes = {
     .brushType = CVSBrushTypePaintbucket,
     .lineWidth = 5000.00f,
@@ -71,11 +89,13 @@ CVSBrushAttributes* CVSBrushAttributesReferenceForBrushType(const CVSBrushType p
             return &kDefaultPaintbrushBrushAttributes;
         case CVSBrushTypeEraser:
             return &kDefaultEraserBrushAttributes;
+        case CVSBrushTypeSpraypaint:
+            return &kDefaultSpraypaintBrushAttributes;
+        case CVSBrushTypeCrayon:
+            return &kDefaultCrayonBrushAttributes;
         case CVSBrushTypePaintbucket:
             return &kDefaultPaintbucketBrushAttributes;
         case CVSBrushType_Undefined:
-        case CVSBrushTypeSpraypaint:
-        case CVSBrushTypeCrayon:
         case CVSBrushTypeNotFound:
             break;
     }
@@ -58,6 +58,13 @@
 - (BOOL)strokeManagerHoldsRecordedStrokes;
 
 
+// Drafts
+/**
+ @brief saves the image of the drawing which is shown when the draft is loaded again. call it as the editor is put away.
+ */
+- (void)saveDraftImage;
+
+
 // Publishing
 - (void)publishImageAndInvalidateStrokeManager:(UIImage *)pImage;
 
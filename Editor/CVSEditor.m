@@ -139,6 +139,13 @@
     return [self.strokeManager numberOfStrokes] > 0;
 }
 
+- (void)saveDraftImage
+{
+    @autoreleasepool {
+        [self.strokeManager saveDraftImage];
+    }
+}
+
 #pragma mark - <CVSStrokeRecorder>
 
 - (id<CVSStrokeRecorder>)strokeRecorder
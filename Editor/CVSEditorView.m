@@ -106,6 +106,7 @@ typedef NS_ENUM(uint8_t, CVSEditorViewEditMode) {
     assert(bitmapStoreReference);
     _cacheView = [[CVSCacheView alloc] initWithFrame:self.bounds bitmapStoreReference:bitmapStoreReference imageSnapshotQueue:pImageSnapshotQueue enableSnapshotting:YES];
     self.cacheView.editorViewDelegate = self.delegate;
+    self.cacheView.templateImage = self.backgroundView.image;
     _strokeView = [[CVSStrokeView alloc] initWithFrame:self.bounds];
 
     [self insertSubview:_backgroundView atIndex:0];
@@ -267,6 +268,7 @@ static const NSUInteger SubviewPositionForEraserView = 3;
 - (void)clearTemplateImage
 {
     self.backgroundView.image = nil;
+    self.cacheView.templateImage = nil;
 }
 
 #pragma mark - Accessors
@@ -274,6 +276,7 @@ static const NSUInteger SubviewPositionForEraserView = 3;
 - (void)setTemplateImage:(UIImage *)templateImage
 {
     self.backgroundView.image = templateImage ?: [UIImage imageNamed:@"quest_with_no_template_image"];
+    self.cacheView.templateImage = self.backgroundView.image;
 }
 
 - (void)setDelegate:(id<CVSEditorViewDelegate>)pDelegate
@@ -285,7 +288,7 @@ static const NSUInteger SubviewPositionForEraserView = 3;
 #pragma mark -
 #pragma mark CVSBackedRenderer
 
-- (void)rendererShouldRenderStrokeComponent:(CVSStrokeComponent *)inComponent strokeGenerator:(CVSStrokeGenerator *)pStrokeGenerator
+- (void)rendererShouldRenderStrokeComponent:(const CVSSCComponent *)inComponent strokeGenerator:(CVSStrokeGenerator *)pStrokeGenerator
 {
     assert(pStrokeGenerator);
     const CVSBrushType brushType = pStrokeGenerator.brushType;
@@ -358,7 +361,9 @@ static const NSUInteger SubviewPositionForEraserView = 3;
 {
     assert(pStroke);
     assert(pStrokeGenerator);
-    if (CVSEditorViewEditModeErase == self.currentEditMode) {
+    if (pStroke.isFill) {
+        [self sendFillStrokeToCacheView:pStroke];
+    } else if (CVSEditorViewEditModeErase == self.currentEditMode) {
         [self.erasingView finishRenderingStroke:pStroke];
     } else {
         [self.strokeView finishRenderingStroke:pStroke];
@@ -366,6 +371,17 @@ static const NSUInteger SubviewPositionForEraserView = 3;
     [self maintainEditorCacheBalance];
 }
 
+// a fill is found in the pixels below it, so it is rendered into the cache directly, once the strokes below it are there
+- (void)sendFillStrokeToCacheView:(CVSStroke *)pStroke
+{
+    assert(pStroke.isFill);
+    if (CVSEditorViewEditModeErase == self.currentEditMode) {
+        [self endErasingMode];
+    }
+    [self transferActiveColorStrokesToCacheView:YES];
+    [self sendStrokesToCacheView:[CVSStrokeArray newStrokeArrayWithStroke:pStroke]];
+}
+
 - (void)sendStrokesToCacheView:(CVSStrokeArray *)pStrokes
 {
     assert(pStrokes.count);
@@ -433,7 +449,8 @@ static const NSUInteger SubviewPositionForEraserView = 3;
     const bool isEraserStroke = CVSBrushTypeEraser == stroke.brushType;
     switch (self.currentEditMode) {
         case CVSEditorViewEditModeColor :
-            if (isEraserStroke) {
+            // a fill is found in the cache's pixels, as an eraser stroke clears them
+            if (isEraserStroke || stroke.isFill) {
                 CVSStrokeArray * strokeArray = [CVSStrokeArray newStrokeArrayWithStroke:stroke];
                 [self transferActiveColorStrokesToCacheView:YES];
                 [self sendStrokesToCacheView:strokeArray];
@@ -470,6 +487,28 @@ static const NSUInteger SubviewPositionForEraserView = 3;
     }
 }
 
+#pragma mark - Draft Image
+
+- (BOOL)rendererShouldRestoreDraftImage:(CVSDraftImage *)pDraftImage strokeCount:(NSUInteger)pStrokeCount
+{
+    if (!self.cacheView || self.strokeView.hasStrokes || CVSEditorViewEditModeErase == self.currentEditMode) {
+        return NO;
+    }
+    [self resetCacheRebuildWeightAccumulator];
+    return [self.cacheView restoreDraftImage:pDraftImage strokeCount:pStrokeCount];
+}
+
+- (void)rendererShouldAdoptDraftImageStrokes:(CVSStrokeArray *)pStrokes
+{
+    [self.cacheView adoptBaseStrokes:pStrokes];
+}
+
+- (BOOL)rendererShouldSaveDraftImage:(CVSDraftImage *)pDraftImage journalLength:(uint64_t)pJournalLength strokeCount:(NSUInteger)pStrokeCount
+{
+    [self transferActiveStrokesToCacheView:YES];
+    return [self.cacheView saveDraftImage:pDraftImage journalLength:pJournalLength strokeCount:pStrokeCount];
+}
+
 #pragma mark - Editor State
 
 - (void)beginErasingMode
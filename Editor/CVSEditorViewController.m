@@ -10,6 +10,8 @@
 #import "CVSPadEditorViewController.h"
 #import "CVSPhoneEditorViewController.h"
 
+#import <QuartzCore/QuartzCore.h>
+
 #import "DQAnalyticsConstants.h"
 #import "UIColor+DQAdditions.h"
 
@@ -19,6 +21,7 @@
 #import "DQHUDView.h"
 #import "NSDictionary+DQAPIConveniences.h"
 #import "DQAccount.h"
+#import "DQPapertrailLogger.h"
 #import "CVSEditor.h"
 
 NSString * const DQApplicationCrashRecoveryAttemptsKey = @"CrashRecoveryAttempts";
@@ -53,6 +56,11 @@ typedef NS_ENUM(NSUInteger, CVSEditorViewControllerType) {
 
 @property (nonatomic, assign) CVSEditorViewControllerType editorType;
 
+// measures the time from the start of -loadDrawing to the first frame which shows the drawing
+@property (nonatomic, assign) CFTimeInterval loadStartTime;
+@property (nonatomic, assign) CFTimeInterval loadDuration;
+@property (nonatomic, strong) CADisplayLink *firstFrameDisplayLink;
+
 @end
 
 @implementation CVSEditorViewController
@@ -63,6 +71,8 @@ typedef NS_ENUM(NSUInteger, CVSEditorViewControllerType) {
 {
     [[NSNotificationCenter defaultCenter] removeObserver:self name:CVSColorsUpdatedNotification object:nil];
     [[NSNotificationCenter defaultCenter] removeObserver:self name:CVSBrushesUpdatedNotication object:nil];
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidEnterBackgroundNotification object:nil];
+    [_firstFrameDisplayLink invalidate];
 }
 
 - (id)initQuestEditorWithDraftPath:(NSString *)draftPath source:(NSString *)source delegate:(id<DQViewControllerDelegate>)delegate
@@ -158,6 +168,7 @@ typedef NS_ENUM(NSUInteger, CVSEditorViewControllerType) {
     [d setObject:self.quest.serverID forKey:DQApplicationDrawingCrashProtectionQuestServerIDKey];
     [d synchronize];
     self.isLoadingStrokeBackup = YES;
+    self.loadStartTime = CACurrentMediaTime();
     dispatch_async(dispatch_get_main_queue(), ^{
         @autoreleasepool {
             [self.editor load];
@@ -170,10 +181,35 @@ typedef NS_ENUM(NSUInteger, CVSEditorViewControllerType) {
             [self.editorView drawingDidFinishLoading];
             [d removeObjectForKey:DQApplicationCrashRecoveryAttemptsKey];
             [d synchronize];
+            self.loadDuration = CACurrentMediaTime() - self.loadStartTime;
+            [self.firstFrameDisplayLink invalidate];
+            self.firstFrameDisplayLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(firstFrameAfterLoading:)];
+            [self.firstFrameDisplayLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
         }
     });
 }
 
+// the display link fires once the frame which shows the loaded drawing has been committed
+- (void)firstFrameAfterLoading:(CADisplayLink *)pDisplayLink
+{
+    [pDisplayLink invalidate];
+    self.firstFrameDisplayLink = nil;
+    const CFTimeInterval loadDuration = self.loadDuration;
+    const CFTimeInterval firstFrameDuration = pDisplayLink.timestamp - self.loadStartTime;
+    [DQPapertrailLogger component:@"stroke-manager" category:@"load-first-frame" dataBlock:^NSDictionary *(DQPapertrailLogger *logger, NSString *component, NSDictionary *componentDict, NSString *category, NSDictionary *categoryDict) {
+        return @{@"load_ms": @(loadDuration * 1000.0),
+                 @"first_frame_ms": @(firstFrameDuration * 1000.0)};
+    }];
+}
+
+- (void)applicationDidEnterBackground:(NSNotification *)pNotification
+{
+    if (!self.isLoadingStrokeBackup)
+    {
+        [self.editor saveDraftImage];
+    }
+}
+
 - (void)showCrashAlert
 {
     __weak typeof(self) weakSelf = self;
@@ -307,6 +343,9 @@ typedef NS_ENUM(NSUInteger, CVSEditorViewControllerType) {
     // Shop related listeners
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(colorsUpdated:) name:CVSColorsUpdatedNotification object:nil];
     [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(brushesUpdated:) name:CVSBrushesUpdatedNotication object:nil];
+
+    // the draft's image is saved as the app is put away, so that the draft opens without rendering its strokes
+    [[NSNotificationCenter defaultCenter] addObserver:self selector:@selector(applicationDidEnterBackground:) name:UIApplicationDidEnterBackgroundNotification object:nil];
 }
 
 - (void)initToolBar
@@ -368,6 +407,10 @@ typedef NS_ENUM(NSUInteger, CVSEditorViewControllerType) {
     [d removeObjectForKey:DQApplicationDrawingCrashProtectionQuestServerIDKey];
     [d removeObjectForKey:DQApplicationCrashRecoveryAttemptsKey];
     [d synchronize];
+    if (!self.isLoadingStrokeBackup)
+    {
+        [self.editor saveDraftImage];
+    }
     [super viewWillDisappear:animated];
 }
 
@@ -377,6 +420,7 @@ typedef NS_ENUM(NSUInteger, CVSEditorViewControllerType) {
     {
         [[NSNotificationCenter defaultCenter] removeObserver:self name:CVSColorsUpdatedNotification object:nil];
         [[NSNotificationCenter defaultCenter] removeObserver:self name:CVSBrushesUpdatedNotication object:nil];
+        [[NSNotificationCenter defaultCenter] removeObserver:self name:UIApplicationDidEnterBackgroundNotification object:nil];
         self.colorPicker = nil;
         self.view = nil;
     }
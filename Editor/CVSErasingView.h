@@ -10,8 +10,9 @@
 
 #import "CVSStrokeRenderComplexity.h"
 
+#include "CVSSCComponent.h"
+
 @class CVSDMEditorBitmapStoreReference;
-@class CVSStrokeComponent;
 @class CVSStroke;
 @class CVSStrokeArray;
 
@@ -23,7 +24,7 @@
 
 - (id)initWithFrame:(CGRect)pFrame bitmapStoreReference:(CVSDMEditorBitmapStoreReference *)pBitmapStoreReference;
 
-- (void)drawComponent:(CVSStrokeComponent *)component;
+- (void)drawComponent:(const CVSSCComponent *)component;
 
 - (BOOL)hasStrokes;
 
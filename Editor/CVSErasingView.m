@@ -12,7 +12,6 @@
 
 #import "CVSDrawingTypes.h"
 #import "CVSStroke.h"
-#import "CVSStrokeComponent.h"
 #import "CVSEditorViewRenderOptions.h"
 #import "CVSStrokeArray.h"
 #import "CVSStrokeRenderer.h"
@@ -88,12 +87,12 @@
     return [[CVSTrackingBrush alloc] initWithBrushType:CVSBrushTypeEraser];
 }
 
-- (void)drawComponent:(CVSStrokeComponent *)component
+- (void)drawComponent:(const CVSSCComponent *)component
 {
     assert(component);
     CVSTrackingBrush * const temporaryPath = [[self class] newEraserTrackingBrush];
     [temporaryPath beginTracking];
-    [temporaryPath addStrokeComponent:component];
+    [temporaryPath addPackedStrokeComponent:component];
     if (!self.trackingBrush.isTracking) {
         [self.trackingBrush beginTracking];
     }
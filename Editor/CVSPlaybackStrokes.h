@@ -0,0 +1,68 @@
+// CVSPlaybackStrokes.h
+// DrawQuest
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+#import "CVSDrawingTypes.h"
+#include "CVSSCColor.h"
+#include "CVSSCComponent.h"
+
+@class UIColor;
+
+/**
+ @brief a stroke of a CVSPlaybackStrokes. the components are valid for the life of the container.
+ */
+typedef struct {
+    CVSBrushType brushType;
+    CVSSCColor color;
+    const CVSSCComponent * components;
+    NSUInteger componentCount;
+} CVSPlaybackStroke;
+
+typedef NS_ENUM(NSInteger, CVSPlaybackStrokesStatus) {
+    CVSPlaybackStrokesStatusDecoding = 0,
+    CVSPlaybackStrokesStatusComplete,
+    // the data was malformed. the strokes which were decoded before the error remain.
+    CVSPlaybackStrokesStatusFailed
+};
+
+/**
+ @class the strokes of a drawing for playback, as packed components. no CVSStroke (or other Core Data) objects are created.
+ @details the strokes are decoded from playback data in the background, and may be played while decoding continues: strokes
+ are appended in order, and a stroke is readable once it has been appended. thread safe.
+ */
+@interface CVSPlaybackStrokes : NSObject
+
+/**
+ @brief decodes the playback data on a background queue: JSON (CVSDrawing -writePlaybackDataAsJSONToPath:) or the binary
+ format (CVSSCPlaybackBinary.h), which is recognized by its signature.
+ @p pReadyBlock is called on the main queue once usesTemplate is known and the first stroke has been decoded -- or decoding ended.
+ */
+- (void)decodePlaybackData:(NSData *)pData readyBlock:(dispatch_block_t)pReadyBlock;
+
+- (CVSPlaybackStrokesStatus)status;
+
+/**
+ @return YES if the drawing was made on the quest's template
+ */
+- (BOOL)usesTemplate;
+
+/**
+ @return the number of strokes decoded so far
+ */
+- (NSUInteger)strokeCount;
+
+/**
+ @return the number of components of the strokes decoded so far
+ */
+- (NSUInteger)componentCount;
+
+- (CVSPlaybackStroke)strokeAtIndex:(NSUInteger)pIndex;
+
+@end
+
+/**
+ @return the stroke's color (opaque, as DQColorFromDictionary)
+ */
+extern UIColor * CVSPlaybackStrokeColor(const CVSPlaybackStroke * const pStroke);
@@ -0,0 +1,221 @@
+// CVSPlaybackStrokes.m
+// DrawQuest
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#import "CVSPlaybackStrokes.h"
+
+#import <UIKit/UIKit.h>
+
+#import "CVSDrawingModel.h"
+#include "CVSSCPlaybackBinary.h"
+#include "CVSSCPlaybackJSON.h"
+
+// the minimum number of components of a page. a stroke's components are contiguous, so a larger stroke gets a larger page.
+static const NSUInteger CVSPlaybackStrokesComponentsPerPage = 4096;
+// the size of the chunks the data is read in. small enough that the first stroke is delivered promptly.
+static const NSUInteger CVSPlaybackStrokesChunkLength = 16 * 1024;
+
+@interface CVSPlaybackStrokes ()
+
+// guards every field below
+@property (nonatomic, strong, readonly) NSLock * lock;
+// the components, in pages which are never resized so that the records remain valid while strokes are appended
+@property (nonatomic, strong, readonly) NSMutableArray * pages;
+@property (nonatomic, strong, readonly) NSMutableData * strokes;
+@property (nonatomic, assign, readwrite) CVSPlaybackStrokesStatus status;
+@property (nonatomic, assign, readwrite) BOOL usesTemplate;
+
+@end
+
+@implementation CVSPlaybackStrokes
+{
+    CVSSCComponent * pageComponents;
+    NSUInteger pageCapacity;
+    NSUInteger pageCount;
+    NSUInteger strokeCount;
+    NSUInteger componentCount;
+}
+
+@synthesize lock = _lock;
+@synthesize pages = _pages;
+@synthesize strokes = _strokes;
+@synthesize status = _status;
+@synthesize usesTemplate = _usesTemplate;
+
+- (id)init
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    _lock = [NSLock new];
+    _pages = [NSMutableArray new];
+    _strokes = [NSMutableData new];
+    _status = CVSPlaybackStrokesStatusDecoding;
+    return self;
+}
+
+#pragma mark - Accessors
+
+- (CVSPlaybackStrokesStatus)status
+{
+    __block CVSPlaybackStrokesStatus result = CVSPlaybackStrokesStatusDecoding;
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        result = _status;
+    });
+    return result;
+}
+
+- (void)setStatus:(CVSPlaybackStrokesStatus)pStatus
+{
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        _status = pStatus;
+    });
+}
+
+- (BOOL)usesTemplate
+{
+    __block BOOL result = NO;
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        result = _usesTemplate;
+    });
+    return result;
+}
+
+- (void)setUsesTemplate:(BOOL)pUsesTemplate
+{
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        _usesTemplate = pUsesTemplate;
+    });
+}
+
+- (NSUInteger)strokeCount
+{
+    __block NSUInteger result = 0;
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        result = strokeCount;
+    });
+    return result;
+}
+
+- (NSUInteger)componentCount
+{
+    __block NSUInteger result = 0;
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        result = componentCount;
+    });
+    return result;
+}
+
+- (CVSPlaybackStroke)strokeAtIndex:(NSUInteger)pIndex
+{
+    __block CVSPlaybackStroke result = {0};
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        assert(pIndex < strokeCount);
+        result = ((const CVSPlaybackStroke *)self.strokes.bytes)[pIndex];
+    });
+    return result;
+}
+
+#pragma mark - Appending
+
+// call from the decoding queue only. returns NO on allocation failure.
+- (BOOL)appendStroke:(const CVSSCPlaybackStroke *)pStroke
+{
+    assert(pStroke);
+    assert(pStroke->componentCount);
+    // the page is written outside the lock: only the decoding queue writes, and readers only read appended strokes
+    if (pageCapacity - pageCount < pStroke->componentCount) {
+        const NSUInteger capacity = MAX(CVSPlaybackStrokesComponentsPerPage, pStroke->componentCount);
+        NSMutableData * const page = [[NSMutableData alloc] initWithLength:capacity * sizeof(CVSSCComponent)];
+        if (!page) {
+            return NO;
+        }
+        CVSDMLockingBlock_NSLocking(self.lock, ^{
+            [self.pages addObject:page];
+        });
+        pageComponents = page.mutableBytes;
+        pageCapacity = capacity;
+        pageCount = 0;
+    }
+    CVSSCComponent * const components = &pageComponents[pageCount];
+    memcpy(components, pStroke->components, pStroke->componentCount * sizeof(CVSSCComponent));
+    pageCount += pStroke->componentCount;
+    // opaque, as the color was when strokes were decoded with DQColorFromDictionary
+    const CVSSCColor color = {pStroke->color.red, pStroke->color.green, pStroke->color.blue, 1.0};
+    const CVSPlaybackStroke stroke = {(CVSBrushType)pStroke->brushType, color, components, pStroke->componentCount};
+    CVSDMLockingBlock_NSLocking(self.lock, ^{
+        [self.strokes appendBytes:&stroke length:sizeof(stroke)];
+        ++strokeCount;
+        componentCount += stroke.componentCount;
+    });
+    return YES;
+}
+
+#pragma mark - Decoding
+
+struct CVSPlaybackStrokesDecoder {
+    __unsafe_unretained CVSPlaybackStrokes * strokes;
+    bool hasUsesTemplate;
+};
+
+static void DecoderReadUsesTemplate(void* const pContext, const bool pUsesTemplate) {
+    struct CVSPlaybackStrokesDecoder* const decoder = pContext;
+    decoder->strokes.usesTemplate = pUsesTemplate;
+    decoder->hasUsesTemplate = true;
+}
+
+static bool DecoderReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    struct CVSPlaybackStrokesDecoder* const decoder = pContext;
+    if (!pStroke->componentCount || CVSBrushTypePen > pStroke->brushType || CVSBrushTypeCount < pStroke->brushType) {
+        // as CVSStrokeArray, strokes which cannot be rendered are skipped
+        return true;
+    }
+    return [decoder->strokes appendStroke:pStroke];
+}
+
+- (void)decodePlaybackData:(NSData *)pData readyBlock:(dispatch_block_t)pReadyBlock
+{
+    assert(pData);
+    assert(pReadyBlock);
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+        struct CVSPlaybackStrokesDecoder decoder = {self, false};
+        const CVSSCPlaybackJSONReaderCallbacks callbacks = {
+            .context = &decoder,
+            .readUsesTemplate = DecoderReadUsesTemplate,
+            .readStroke = DecoderReadStroke
+        };
+        const uint8_t * const bytes = pData.bytes;
+        const NSUInteger length = pData.length;
+        // both readers deliver through the same callbacks
+        const bool isBinary = CVSSCPlaybackBinaryHasSignature(bytes, length);
+        CVSSCPlaybackBinaryReader * const binaryReader = isBinary ? CVSSCPlaybackBinaryReaderCreate(&callbacks) : NULL;
+        CVSSCPlaybackJSONReader * const jsonReader = isBinary ? NULL : CVSSCPlaybackJSONReaderCreate(&callbacks);
+        bool succeeded = NULL != binaryReader || NULL != jsonReader;
+        bool isReady = false;
+        for (NSUInteger offset = 0; succeeded && offset < length; offset += CVSPlaybackStrokesChunkLength) {
+            const NSUInteger chunkLength = MIN(CVSPlaybackStrokesChunkLength, length - offset);
+            @autoreleasepool {
+                succeeded = isBinary ? CVSSCPlaybackBinaryReaderAppend(binaryReader, &bytes[offset], chunkLength) : CVSSCPlaybackJSONReaderAppend(jsonReader, &bytes[offset], chunkLength);
+            }
+            if (!isReady && decoder.hasUsesTemplate && self.strokeCount) {
+                isReady = true;
+                dispatch_async(dispatch_get_main_queue(), pReadyBlock);
+            }
+        }
+        succeeded = succeeded && (isBinary ? CVSSCPlaybackBinaryReaderFinish(binaryReader) : CVSSCPlaybackJSONReaderFinish(jsonReader));
+        CVSSCPlaybackBinaryReaderDestroy(binaryReader);
+        CVSSCPlaybackJSONReaderDestroy(jsonReader);
+        self.status = succeeded ? CVSPlaybackStrokesStatusComplete : CVSPlaybackStrokesStatusFailed;
+        if (!isReady) {
+            dispatch_async(dispatch_get_main_queue(), pReadyBlock);
+        }
+    });
+}
+
+@end
+
+UIColor * CVSPlaybackStrokeColor(const CVSPlaybackStroke * const pStroke) {
+    assert(pStroke);
+    return [UIColor colorWithRed:(CGFloat)pStroke->color.red green:(CGFloat)pStroke->color.green blue:(CGFloat)pStroke->color.blue alpha:(CGFloat)pStroke->color.alpha];
+}
@@ -29,7 +29,7 @@
 + (void)invalidateRectOfStroke:(CVSStroke *)pStroke view:(UIView *)pView
 {
     assert(pStroke);
-    if ([pStroke.components count])
+    if (pStroke.componentCount)
     {
         const CGRect bounds = pStroke.bounds;
         if (CGRectIsNull(bounds) || CGRectIsEmpty(bounds)) {
@@ -11,17 +11,30 @@
 
 #import "CVSDrawingTypes.h"
 #import "CVSStrokeRenderComplexity.h"
+#import "CVSUniqueUIColorCache.h"
+#include "CVSSCComponent.h"
 
 @class CVSDrawing;
-@class CVSUniqueUIColorCache;
 @class UIColor;
 
 @interface CVSStroke : NSManagedObject
 
 @property (strong, nonatomic) NSNumber *brushTypeNumber;
-@property (strong, nonatomic) NSOrderedSet *components;
+/**
+ @brief the packed components (see CVSSCComponentBlobWrite). prefer componentRecords/setComponentRecords:count:.
+ */
+@property (strong, nonatomic) NSData *componentsData;
+/**
+ @brief CVSStrokeComponent objects of stores which predate componentsData. emptied by migrateLegacyComponentsIfNeeded.
+ */
+@property (strong, nonatomic) NSOrderedSet *legacyComponents;
 @property (strong, nonatomic) UIColor *strokeColor;
 @property (strong, nonatomic) CVSDrawing *drawing;
+/**
+ @brief the index of the stroke's color in the color cache it was last deduplicated with -- its drawing's (CVSDrawing
+ -uniqueUIColorCache) once it is committed. CVSColorIndexNone until then, and after the color is set. transient.
+ */
+@property (nonatomic, readonly) CVSColorIndex colorIndex;
 
 @property (nonatomic, assign, readwrite) CVSBrushType brushType;
 @property (nonatomic, readonly) CGPathRef path;
@@ -30,8 +43,42 @@
  */
 @property (nonatomic, readonly) CGRect bounds;
 
+/**
+ @return the number of components in the stroke
+ */
+@property (nonatomic, readonly) NSUInteger componentCount;
+
+/**
+ @return the components of the stroke. the records are owned by the stroke and are valid until its components change or it is turned into a fault.
+ */
+- (const CVSSCComponent *)componentRecords NS_RETURNS_INNER_POINTER;
+
+/**
+ @return YES if the stroke is a flood fill (a paint bucket stroke of a single CVSSCComponentTypeFill component), rather than a path
+ */
+@property (nonatomic, readonly) BOOL isFill;
+
+/**
+ @brief replaces the stroke's components with a copy of @p pComponents.
+ */
+- (void)setComponentRecords:(const CVSSCComponent *)pComponents count:(NSUInteger)pCount;
+
+/**
+ @brief replaces the stroke's components with the values of @p pStrokeComponents (CVSStrokeComponent objects). the objects are not retained.
+ */
+- (void)setComponentsWithStrokeComponents:(NSArray *)pStrokeComponents;
+
+/**
+ @brief moves the legacyComponents into componentsData and deletes the legacy objects.
+ @return YES if the stroke was modified
+ */
+- (BOOL)migrateLegacyComponentsIfNeeded;
+
 - (NSDictionary *)strokeRepresentation;
 
+/**
+ @brief replaces the stroke's color with the cache's instance (adding the color to the cache if necessary), and sets the colorIndex.
+ */
 - (void)deduplicateObjectStateUsingUIColorCache:(CVSUniqueUIColorCache *)colorCache;
 
 /**
@@ -39,6 +86,16 @@
  */
 - (CVSSingleStrokeRenderComplexity)singleStrokeRenderComplexity;
 
+/**
+ @return the spans (CVSSCFillSpan[]) of a fill stroke as it was last rendered into a bitmap, or nil. @p pOutTransform receives
+ the transform from the stroke's coordinates to the bitmap's pixels, and @p pOutPixelSize the bitmap's size.
+ @details the spans are transient. a fill depends only on the strokes below it, which cannot change while the fill is
+ committed, so the spans are blended again when the stroke is rendered again (e.g. redo, or a cache rebuild) rather than
+ found again. thread safe.
+ */
+- (NSData *)cachedFillSpansWithTransform:(CGAffineTransform *)pOutTransform pixelSize:(CGSize *)pOutPixelSize;
+- (void)setCachedFillSpans:(NSData *)pSpans transform:(CGAffineTransform)pTransform pixelSize:(CGSize)pPixelSize;
+
 /**
  @brief the path is transient. it may be purged and rebuilt on demand. this method purges that cached path.
  */
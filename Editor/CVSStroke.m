@@ -15,12 +15,20 @@
 #import "UIColor+DQAdditions.h"
 #import "CVSUniqueUIColorCache.h"
 
+#include "CVSSCGeometry.h"
+
 @implementation CVSStroke
 {
     bool hasCalculatedBounds;
+    // the spans of a fill stroke, and the pixels they are in. guarded by @synchronized(self).
+    NSData * cachedFillSpans;
+    CGAffineTransform cachedFillSpansTransform;
+    CGSize cachedFillSpansPixelSize;
+    CVSColorIndex colorIndex;
 }
 
-@dynamic components;
+@dynamic componentsData;
+@dynamic legacyComponents;
 @dynamic brushTypeNumber;
 @dynamic strokeColor;
 @dynamic drawing;
@@ -29,6 +37,16 @@
 
 #pragma mark - Lifetime
 
+- (id)initWithEntity:(NSEntityDescription *)entity insertIntoManagedObjectContext:(NSManagedObjectContext *)context
+{
+    self = [super initWithEntity:entity insertIntoManagedObjectContext:context];
+    if (self == nil) {
+        return nil;
+    }
+    colorIndex = CVSColorIndexNone;
+    return self;
+}
+
 - (void)dealloc
 {
     if (NULL != _path) {
@@ -39,6 +57,7 @@
 - (void)invalidateBounds
 {
     _bounds = CGRectNull;
+    hasCalculatedBounds = false;
 }
 
 - (BOOL)hasCalculatedBounds
@@ -86,6 +105,20 @@
     self.brushTypeNumber = @(brushType);
 }
 
+- (void)setStrokeColor:(UIColor *)strokeColor
+{
+    [self willChangeValueForKey:@"strokeColor"];
+    [self setPrimitiveValue:strokeColor forKey:@"strokeColor"];
+    [self didChangeValueForKey:@"strokeColor"];
+    // the index is of the color which was deduplicated
+    colorIndex = CVSColorIndexNone;
+}
+
+- (CVSColorIndex)colorIndex
+{
+    return colorIndex;
+}
+
 - (CGPathRef)path
 {
     if (!self.hasPath)
@@ -100,23 +133,96 @@
 {
     if (!self.hasCalculatedBounds)
     {
-        [self loadPath];
+        [self loadBounds];
     }
     assert(!CGRectIsNull(_bounds));
     return _bounds;
 }
 
-- (void)setComponents:(NSOrderedSet *)components
+- (void)setComponentsData:(NSData *)componentsData
 {
-    NSString * key = @"components";
+    NSString * key = @"componentsData";
     [self willChangeValueForKey:key];
-    [self setPrimitiveValue:components forKey:key];
+    [self setPrimitiveValue:componentsData forKey:key];
     [self purgeCachedPath];
-    _bounds = CGRectNull;
-    hasCalculatedBounds = false;
+    [self invalidateBounds];
+    [self setCachedFillSpans:nil transform:CGAffineTransformIdentity pixelSize:CGSizeZero];
     [self didChangeValueForKey:key];
 }
 
+#pragma mark - Components
+
+- (bool)readComponentRecords:(const CVSSCComponent **)pOutComponents count:(size_t *)pOutCount
+{
+    NSData * data = self.componentsData;
+    if (!CVSSCComponentBlobRead(data.bytes, data.length, pOutComponents, pOutCount)) {
+        assert(0 && "malformed components data");
+        return false;
+    }
+    return true;
+}
+
+- (NSUInteger)componentCount
+{
+    const CVSSCComponent * components = NULL;
+    size_t count = 0;
+    [self readComponentRecords:&components count:&count];
+    return (NSUInteger)count;
+}
+
+- (const CVSSCComponent *)componentRecords
+{
+    const CVSSCComponent * components = NULL;
+    size_t count = 0;
+    [self readComponentRecords:&components count:&count];
+    return components;
+}
+
+- (BOOL)isFill
+{
+    const CVSSCComponent * components = NULL;
+    size_t count = 0;
+    [self readComponentRecords:&components count:&count];
+    return CVSSCComponentsAreFill(components, count);
+}
+
+- (void)setComponentRecords:(const CVSSCComponent *)pComponents count:(NSUInteger)pCount
+{
+    assert(pComponents || 0 == pCount);
+    NSMutableData * data = [[NSMutableData alloc] initWithLength:CVSSCComponentBlobLength(pCount)];
+    CVSSCComponentBlobWrite(data.mutableBytes, pComponents, pCount);
+    self.componentsData = data;
+}
+
+- (void)setComponentsWithStrokeComponents:(NSArray *)pStrokeComponents
+{
+    const NSUInteger count = pStrokeComponents.count;
+    NSMutableData * data = [[NSMutableData alloc] initWithLength:count * sizeof(CVSSCComponent)];
+    CVSSCComponent * const components = data.mutableBytes;
+    NSUInteger idx = 0;
+    for (CVSStrokeComponent * at in pStrokeComponents) {
+        components[idx++] = at.packedComponent;
+    }
+    [self setComponentRecords:components count:count];
+}
+
+- (BOOL)migrateLegacyComponentsIfNeeded
+{
+    NSOrderedSet * legacyComponents = self.legacyComponents;
+    if (0 == legacyComponents.count) {
+        return NO;
+    }
+    if (0 == self.componentCount) {
+        [self setComponentsWithStrokeComponents:legacyComponents.array];
+    }
+    self.legacyComponents = [NSOrderedSet orderedSet];
+    NSManagedObjectContext * moc = self.managedObjectContext;
+    for (CVSStrokeComponent * at in legacyComponents) {
+        [moc deleteObject:at];
+    }
+    return YES;
+}
+
 #pragma mark - Path Caching
 
 - (bool)hasPath
@@ -135,27 +241,36 @@
     // otherwise, reconstruct and cache
     UIBezierPath * bezierPath = [UIBezierPath bezierPath];
     CVSBrushAttributesConfigureUIBezierPath(CVSBrushAttributesForBrushType(self.brushType), bezierPath);
-    for (CVSStrokeComponent * component in self.components) {
-        [bezierPath cvs_addStrokeComponent:component];
-    }
+    const CVSSCComponent * components = NULL;
+    size_t count = 0;
+    [self readComponentRecords:&components count:&count];
+    [bezierPath cvs_addPackedStrokeComponents:components count:count];
     _path = CGPathCreateCopy(bezierPath.CGPath);
     assert(_path);
-    if (CGPathIsEmpty(_path)) {
+    if (!self.hasCalculatedBounds) {
+        [self loadBounds];
+    }
+    assert(self.hasPath);
+    return bezierPath;
+}
+
+- (void)loadBounds
+{
+    // the bounds are calculated from the components, so the path need not be built
+    const CVSSCComponent * components = NULL;
+    size_t count = 0;
+    [self readComponentRecords:&components count:&count];
+    const CGFloat lineWidth = CVSBrushAttributesForBrushType(self.brushType).lineWidth;
+    assert(0 < lineWidth);
+    const CVSSCRect bounds = CVSSCComponentsGetStrokeBounds(components, count, lineWidth);
+    if (CVSSCRectIsNull(bounds)) {
         // this may cause problems for you if you create a stroke with no components
         _bounds = CGRectNull;
-        hasCalculatedBounds = true;
     }
     else {
-        const CGRect boundingBox = CGPathGetBoundingBox(_path);
-        assert(!CGRectIsNull(boundingBox));
-        const CGFloat lineWidth = CVSBrushAttributesForBrushType(self.brushType).lineWidth;
-        assert(0 < lineWidth);
-        const CGFloat brushWidthScaling = 0.5f * lineWidth;
-        _bounds = CGRectIntegral(CGRectInset(boundingBox, -brushWidthScaling, -brushWidthScaling));
-        hasCalculatedBounds = true;
+        _bounds = CGRectMake((CGFloat)bounds.x, (CGFloat)bounds.y, (CGFloat)bounds.width, (CGFloat)bounds.height);
     }
-    assert(self.hasPath);
-    return bezierPath;
+    hasCalculatedBounds = true;
 }
 
 - (void)loadPath
@@ -179,8 +294,11 @@
 - (NSDictionary *)strokeRepresentation
 {
     NSMutableArray *componentRepresentations = [[NSMutableArray alloc] init];
-    for (CVSStrokeComponent * at in self.components) {
-        [componentRepresentations addObject:[at componentRepresentation]];
+    const CVSSCComponent * components = NULL;
+    size_t count = 0;
+    [self readComponentRecords:&components count:&count];
+    for (size_t idx = 0; idx < count; ++idx) {
+        [componentRepresentations addObject:[CVSStrokeComponent componentRepresentationWithPackedComponent:&components[idx]]];
     }
 
     NSDictionary *representation = @{
@@ -200,7 +318,7 @@
     // yes, this is a very naive estimation. tweak if you need to.
     // an obvious addition would be to evaluate area (bounds).
     // self-intersecting paths have also been mentioned by Jim as complex
-    const NSInteger n = (NSInteger)self.components.count;
+    const NSInteger n = (NSInteger)self.componentCount;
     const NSInteger n10 = n * 10;
     const NSInteger complexity = n10;
     if (0 >= complexity) {
@@ -212,6 +330,28 @@
     return (CVSSingleStrokeRenderComplexity)n;
 }
 
+#pragma mark - Fill Caching
+
+- (NSData *)cachedFillSpansWithTransform:(CGAffineTransform *)pOutTransform pixelSize:(CGSize *)pOutPixelSize
+{
+    assert(pOutTransform);
+    assert(pOutPixelSize);
+    @synchronized(self) {
+        *pOutTransform = cachedFillSpansTransform;
+        *pOutPixelSize = cachedFillSpansPixelSize;
+        return cachedFillSpans;
+    }
+}
+
+- (void)setCachedFillSpans:(NSData *)pSpans transform:(CGAffineTransform)pTransform pixelSize:(CGSize)pPixelSize
+{
+    @synchronized(self) {
+        cachedFillSpans = pSpans;
+        cachedFillSpansTransform = pTransform;
+        cachedFillSpansPixelSize = pPixelSize;
+    }
+}
+
 #pragma mark - Deduplication
 
 - (void)deduplicateObjectStateUsingUIColorCache:(CVSUniqueUIColorCache *)colorCache
@@ -221,11 +361,16 @@
     if (current == nil) {
         return;
     }
-    UIColor * unique = [colorCache uniqueUIColor:current];
-    if (unique == current) {
+    const CVSColorIndex index = [colorCache indexOfUIColor:current];
+    if (CVSColorIndexNone == index) {
+        colorIndex = CVSColorIndexNone;
         return;
     }
-    self.strokeColor = unique;
+    UIColor * unique = [colorCache uiColorAtIndex:index];
+    if (unique != current) {
+        self.strokeColor = unique;
+    }
+    colorIndex = index;
 }
 
 #pragma mark - Purging
@@ -12,6 +12,7 @@
 #import "CVSStrokeRenderComplexity.h"
 
 @class CVSStroke;
+struct CVSDMTileGrid;
 
 /**
  @brief abstraction which helps managing an array of strokes. only add CVSStrokes to this container.
@@ -49,6 +50,17 @@
  */
 - (void)renderInContext:(CGContextRef)pContext clippingRect:(CGRect)pClippingRect;
 - (void)renderInContext:(CGContextRef)pContext clippingRect:(CGRect)pClippingRect useStrokesCGPath:(bool)pUseStrokesCGPath;
+/**
+ @brief renders all strokes into the context, touching only the tiles of @p pTileGrid which the strokes intersect. fills are found over
+ @p pFillUnderlay (drawn in @p pFillUnderlayRect), if it is not NULL. see CVSStrokeRenderer.
+ */
+- (void)renderInContext:(CGContextRef)pContext clippingRect:(CGRect)pClippingRect tileGrid:(struct CVSDMTileGrid *)pTileGrid fillUnderlay:(CGImageRef)pFillUnderlay rect:(CGRect)pFillUnderlayRect;
+
+/**
+ @return the strokes whose bounds intersect @p pRect, in order.
+ @details large arrays are searched with a spatial index of the strokes' bounds, which is built on first use and updated as strokes are added and removed.
+ */
+- (NSArray *)strokesIntersectingRect:(CGRect)pRect;
 
 /**
  @return the union of bounds of all strokes in the collection. self must contain strokes.
@@ -12,6 +12,18 @@
 #import "CVSStrokeRenderer.h"
 #import "DQPapertrailLogger.h"
 
+#include "CVSSCSpatialIndex.h"
+
+// arrays with fewer strokes are searched linearly, rather than building a spatial index
+static const NSUInteger CVSStrokeArraySpatialIndexMinimumCount = 16;
+
+static CVSSCRect CVSSCRectFromCGRect(const CGRect pRect) {
+    if (CGRectIsNull(pRect)) {
+        return CVSSCRectNull();
+    }
+    return CVSSCRectMake(CGRectGetMinX(pRect), CGRectGetMinY(pRect), CGRectGetWidth(pRect), CGRectGetHeight(pRect));
+}
+
 @interface CVSStrokeArray ()
 
 @property (nonatomic, readonly) NSMutableArray * mstrokes;
@@ -19,6 +31,14 @@
 @end
 
 @implementation CVSStrokeArray
+{
+    // the strokes' bounds. NULL until the first query, and discarded when a stroke is removed from the middle.
+    // the key of mstrokes[i] is firstStrokeKey + i, so strokes may be added to or removed from either end.
+    CVSSCSpatialIndex* spatialIndex;
+    uint64_t firstStrokeKey;
+    // CGRectNull when it must be recalculated
+    CGRect cachedUnionOfStrokesBounds;
+}
 
 - (id)init
 {
@@ -27,9 +47,15 @@
         return nil;
     }
     _mstrokes = [NSMutableArray new];
+    cachedUnionOfStrokesBounds = CGRectNull;
     return self;
 }
 
+- (void)dealloc
+{
+    CVSSCSpatialIndexDestroy(spatialIndex);
+}
+
 + (instancetype)newStrokeArrayWithStroke:(CVSStroke *)pStroke
 {
     assert(pStroke);
@@ -78,9 +104,10 @@
 {
     if (pStroke)
     {
-        if ([pStroke.components count])
+        if (pStroke.componentCount)
         {
             [self.mstrokes addObject:pStroke];
+            [self strokesWereAddedFromIndex:self.mstrokes.count - 1];
         }
         else
         {
@@ -107,7 +134,7 @@
     if (pStrokes)
     {
         NSIndexSet *indexes = [pStrokes indexesOfObjectsPassingTest:^BOOL(CVSStroke *stroke, NSUInteger idx, BOOL *stop) {
-            if ([stroke.components count])
+            if (stroke.componentCount)
             {
                 return YES;
             }
@@ -120,6 +147,7 @@
                 return NO;
             }
         }];
+        const NSUInteger firstAddedIndex = self.mstrokes.count;
         if ([indexes count] == [pStrokes count])
         {
             [self.mstrokes addObjectsFromArray:pStrokes];
@@ -132,6 +160,7 @@
                 [self.mstrokes addObjectsFromArray:goodStrokes];
             }
         }
+        [self strokesWereAddedFromIndex:firstAddedIndex];
     }
     else
     {
@@ -144,11 +173,22 @@
 - (void)removeStroke:(CVSStroke *)pStroke
 {
     assert([self containsStroke:pStroke]);
+    const NSUInteger index = [self.mstrokes indexOfObject:pStroke];
+    if (NSNotFound == index) {
+        return;
+    }
+    [self strokesWillBeRemovedInRange:NSMakeRange(index, 1)];
+    const NSUInteger count = self.mstrokes.count;
     [self.mstrokes removeObject:pStroke];
+    if (count - 1 != self.mstrokes.count) {
+        // the stroke was in the array more than once
+        [self discardSpatialIndex];
+    }
 }
 
 - (void)removeAllObjects
 {
+    [self strokesWillBeRemovedInRange:NSMakeRange(0, self.mstrokes.count)];
     @autoreleasepool {
         [self.mstrokes removeAllObjects];
     }
@@ -189,9 +229,41 @@
     }
 }
 
+- (void)renderInContext:(CGContextRef)pContext clippingRect:(CGRect)pClippingRect tileGrid:(CVSDMTileGrid *)pTileGrid fillUnderlay:(CGImageRef)pFillUnderlay rect:(CGRect)pFillUnderlayRect
+{
+    if (0 == self.count) {
+        return;
+    }
+    @autoreleasepool {
+        [CVSStrokeRenderer renderStrokes:self clippingRect:pClippingRect context:pContext tileGrid:pTileGrid fillUnderlay:pFillUnderlay rect:pFillUnderlayRect];
+    }
+}
+
+- (NSArray *)strokesIntersectingRect:(CGRect)pRect
+{
+    NSArray * const strokes = self.mstrokes;
+    const uint64_t* keys = NULL;
+    size_t count = 0;
+    if (strokes.count < CVSStrokeArraySpatialIndexMinimumCount || !self.loadSpatialIndex || !CVSSCSpatialIndexQuery(spatialIndex, CVSSCRectFromCGRect(pRect), &keys, &count)) {
+        NSIndexSet * const indexes = [strokes indexesOfObjectsPassingTest:^BOOL(CVSStroke * at, NSUInteger idx, BOOL * stop) {
+            return CVSSCRectIntersectsRect(CVSSCRectFromCGRect(at.bounds), CVSSCRectFromCGRect(pRect));
+        }];
+        return [strokes objectsAtIndexes:indexes];
+    }
+    NSMutableArray * const result = [[NSMutableArray alloc] initWithCapacity:count];
+    for (size_t idx = 0; idx < count; ++idx) {
+        assert(keys[idx] - firstStrokeKey < strokes.count);
+        [result addObject:strokes[(NSUInteger)(keys[idx] - firstStrokeKey)]];
+    }
+    return result;
+}
+
 - (CGRect)unionOfStrokesBounds
 {
     assert(self.count);
+    if (!CGRectIsNull(cachedUnionOfStrokesBounds)) {
+        return cachedUnionOfStrokesBounds;
+    }
     CGRect rect = CGRectNull;
     for (CVSStroke * at in self.mstrokes) {
         const CGRect bounds = at.bounds;
@@ -201,6 +273,7 @@
         }
         rect = CGRectUnion(rect, bounds);
     }
+    cachedUnionOfStrokesBounds = rect;
     return rect;
 }
 
@@ -230,10 +303,10 @@
 {
     CVSStrokeArray * results = [[self class] new];
     NSMutableArray * strokes = self.mstrokes;
-    for (size_t i = 0, offset = self.count - pNStrokesToDequeue; i < pNStrokesToDequeue; ++i) {
-        [results addStroke:strokes[offset]];
-        [strokes removeObjectAtIndex:offset];
-    }
+    const NSRange range = NSMakeRange(self.count - pNStrokesToDequeue, pNStrokesToDequeue);
+    [results addStrokesFromArray:[strokes subarrayWithRange:range]];
+    [self strokesWillBeRemovedInRange:range];
+    [strokes removeObjectsInRange:range];
     return results;
 }
 
@@ -249,6 +322,7 @@
 {
     const NSUInteger i = 0;
     CVSStroke * stroke = self.mstrokes[i];
+    [self strokesWillBeRemovedInRange:NSMakeRange(i, 1)];
     [self.mstrokes removeObjectAtIndex:i];
     return stroke;
 }
@@ -258,6 +332,7 @@
     NSMutableArray * strokes = self.mstrokes;
     assert(strokes.count);
     CVSStroke * stroke = strokes.lastObject;
+    [self strokesWillBeRemovedInRange:NSMakeRange(strokes.count - 1, 1)];
     [strokes removeLastObject];
     return stroke;
 }
@@ -267,11 +342,87 @@
     assert(pThreshold);
     assert(self.count);
     CVSStrokeArray * dequeued = [CVSStrokeArray new];
-    while (![self isMultipleStrokeRenderComplexityBelow:pThreshold]) {
-        [dequeued addStroke:self.dequeueZeroethStroke];
+    // the sum is updated as strokes are dequeued, rather than summed again for each
+    CVSMultipleStrokeRenderComplexity complexity = self.multipleStrokeRenderComplexity;
+    while (pThreshold <= complexity) {
+        CVSStroke * const stroke = self.dequeueZeroethStroke;
+        complexity -= stroke.singleStrokeRenderComplexity;
+        [dequeued addStroke:stroke];
     }
     assert(dequeued.count);
     return dequeued;
 }
 
+#pragma mark - Spatial Index
+
+// builds the spatial index if needed. returns NO if it could not be built.
+- (BOOL)loadSpatialIndex
+{
+    if (spatialIndex) {
+        return YES;
+    }
+    spatialIndex = CVSSCSpatialIndexCreate(CVSSCSpatialIndexDefaultCellSize);
+    if (!spatialIndex) {
+        assert(0 && "failed to create the spatial index");
+        return NO;
+    }
+    firstStrokeKey = 0;
+    [self strokesWereAddedFromIndex:0];
+    return NULL != spatialIndex;
+}
+
+- (void)discardSpatialIndex
+{
+    CVSSCSpatialIndexDestroy(spatialIndex);
+    spatialIndex = NULL;
+}
+
+// call after strokes were added to the end of mstrokes
+- (void)strokesWereAddedFromIndex:(NSUInteger)pIndex
+{
+    NSArray * const strokes = self.mstrokes;
+    for (NSUInteger idx = pIndex; idx < strokes.count; ++idx) {
+        CVSStroke * const stroke = strokes[idx];
+        const CGRect bounds = stroke.bounds;
+        if (!CGRectIsNull(cachedUnionOfStrokesBounds) && !CGRectIsEmpty(bounds)) {
+            cachedUnionOfStrokesBounds = CGRectUnion(cachedUnionOfStrokesBounds, bounds);
+        }
+        if (spatialIndex && !CVSSCSpatialIndexInsert(spatialIndex, firstStrokeKey + idx, CVSSCRectFromCGRect(bounds))) {
+            [self discardSpatialIndex];
+        }
+    }
+}
+
+// call before strokes are removed from mstrokes
+- (void)strokesWillBeRemovedInRange:(NSRange)pRange
+{
+    if (0 == pRange.length) {
+        return;
+    }
+    cachedUnionOfStrokesBounds = CGRectNull;
+    if (!spatialIndex) {
+        return;
+    }
+    const NSUInteger count = self.mstrokes.count;
+    assert(NSMaxRange(pRange) <= count);
+    if (pRange.length == count) {
+        CVSSCSpatialIndexRemoveAll(spatialIndex);
+        firstStrokeKey = 0;
+    }
+    else if (0 == pRange.location || count == NSMaxRange(pRange)) {
+        for (NSUInteger idx = pRange.location; idx < NSMaxRange(pRange); ++idx) {
+            const bool removed = CVSSCSpatialIndexRemove(spatialIndex, firstStrokeKey + idx);
+            assert(removed);
+            (void)removed;
+        }
+        if (0 == pRange.location) {
+            firstStrokeKey += pRange.length;
+        }
+    }
+    else {
+        // the keys of the following strokes would change
+        [self discardSpatialIndex];
+    }
+}
+
 @end
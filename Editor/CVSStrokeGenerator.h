@@ -12,8 +12,9 @@
 #import "CVSDrawingTypes.h"
 #import "CVSStrokeRecorder.h"
 
+#include "CVSSCComponent.h"
+
 @class CVSStroke;
-@class CVSStrokeComponent;
 @class CVSStrokeManager;
 @class UIColor;
 
@@ -25,6 +26,11 @@
 @property (strong, nonatomic) CVSStrokeManager *strokeManager;
 @property (nonatomic) CVSBrushType brushType;
 @property (strong, nonatomic) UIColor *strokeColor;
+/**
+ @brief when a stroke ends, runs of its curves are merged into fewer curves which stay within this distance of them, in
+ pixels (see CVSSCSimplify.h). the default is 0.5. 0 keeps every component. strokes of square capped brushes are not simplified.
+ */
+@property (nonatomic) CGFloat simplificationTolerance;
 
 /**
  @brief this is used when handling events. the stroke generator determines whether a stroke should be committed or disposed of in the event gestures should be interpreted as zoom events.
@@ -35,8 +41,11 @@
 
 @protocol CVSStrokeGeneratorConsumer <NSObject>
 
-- (void)strokeGenerator:(CVSStrokeGenerator *)generator didStartStrokeWithComponent:(CVSStrokeComponent *)component;
-- (void)strokeGenerator:(CVSStrokeGenerator *)generator didContinueStrokeWithComponent:(CVSStrokeComponent *)component;
+/**
+ @brief the component is valid only for the duration of the call.
+ */
+- (void)strokeGenerator:(CVSStrokeGenerator *)generator didStartStrokeWithComponent:(const CVSSCComponent *)component;
+- (void)strokeGenerator:(CVSStrokeGenerator *)generator didContinueStrokeWithComponent:(const CVSSCComponent *)component;
 - (void)strokeGenerator:(CVSStrokeGenerator *)generator didEndStroke:(CVSStroke *)stroke;
 
 
@@ -10,29 +10,36 @@
 
 #import "CVSStrokeGenerator.h"
 
-#import "UIBezierPath+CVSAdditions.h"
-
-#import "CVSGeometry.h"
 #import "CVSStroke.h"
-#import "CVSStrokeComponent.h"
 #import "CVSStrokeManager.h"
 #import "CVSUniqueUIColorCache.h"
-#import "CVSTrackingBrush.h"
 
-static const NSInteger kStrokeGeneratorPointCount = 4;
+#include "CVSSCBrush.h"
+#include "CVSSCSimplify.h"
+#include "CVSSCStrokeTracker.h"
+
+static const CGFloat kStrokeGeneratorDefaultSimplificationTolerance = 0.5;
+// components reserved for the tracked stroke. the buffer grows (and is kept) for longer strokes.
+static const size_t kStrokeGeneratorComponentCapacity = 1024;
 
 @interface CVSStrokeGenerator()
 
-@property (strong, nonatomic) CVSTrackingBrush * trackingBrush;
-@property (strong, nonatomic) NSMutableArray *trackingComponents;
-@property (strong, nonatomic) NSMutableArray *samplePoints;
+/**
+ @brief the view whose coordinates the samples of the stroke in progress are in. nil if no stroke is in progress.
+ */
+@property (weak, nonatomic) UIView *trackingView;
 
 @end
 
 @implementation CVSStrokeGenerator
 {
     CVSUniqueUIColorCache * uniqueUIColorCache;
-    CGPoint _cSamplePointsArray[kStrokeGeneratorPointCount];
+    // the samples and components of the stroke in progress
+    CVSSCStrokeTracker * _tracker;
+    bool _isTracking;
+    // a paint bucket stroke is a fill, seeded where its touch began. it is not tracked.
+    bool _isFilling;
+    CVSSCPoint _fillSeedPoint;
     struct {
         unsigned int consumerDidStartStrokeWithComponent:1;
         unsigned int consumerDidContinueStrokeWithComponent:1;
@@ -47,16 +54,18 @@ static const NSInteger kStrokeGeneratorPointCount = 4;
         return nil;
     }
     uniqueUIColorCache = [CVSUniqueUIColorCache uniqueUIColorCacheWithDefaultEditorColors];
-    _samplePoints = [[NSMutableArray alloc] init];
-    _trackingComponents = [[NSMutableArray alloc] init];
+    _tracker = CVSSCStrokeTrackerCreate(kStrokeGeneratorComponentCapacity);
+    if (!_tracker) {
+        return nil;
+    }
+    _simplificationTolerance = kStrokeGeneratorDefaultSimplificationTolerance;
 
     return self;
 }
 
-
-- (void)clearSamplePointsArray
+- (void)dealloc
 {
-    [self.samplePoints removeAllObjects];
+    CVSSCStrokeTrackerDestroy(_tracker);
 }
 
 #pragma mark -
@@ -70,16 +79,6 @@ static const NSInteger kStrokeGeneratorPointCount = 4;
     _consumerFlags.consumerDidEndStroke = (bool)[_consumer respondsToSelector:@selector(strokeGenerator: didEndStroke:)];
 }
 
-- (void)addSamplePoint:(CGPoint)point
-{
-    if([self.samplePoints count] == kStrokeGeneratorPointCount) {
-        [self.samplePoints removeObjectAtIndex:0];
-    }
-
-    NSValue *value = [NSValue valueWithCGPoint:point];
-    [self.samplePoints addObject:value];
-}
-
 - (void)setStrokeColor:(UIColor *)strokeColor
 {
     if (strokeColor == nil) {
@@ -96,42 +95,37 @@ static const NSInteger kStrokeGeneratorPointCount = 4;
 {
     // Prepare state for new stroke
     [self disposeActiveStroke];
-    self.trackingBrush = [[CVSTrackingBrush alloc] initWithBrushType:self.brushType];
-    [self.trackingBrush beginTracking];
+    _isTracking = true;
 
+    // the touch's view does not change while it moves, so the editor view is found once per stroke
     UIView *touchedView = inTouch.view;
     while (strcmp(class_getName([touchedView class]), "CVSEditorView") != 0 && class_getName([touchedView class]) != nil) {
         touchedView = touchedView.superview;
     }
-    CGPoint origin = [inTouch locationInView:touchedView];
-    [self addSamplePoint:origin];
+    self.trackingView = touchedView;
 
-    CVSStrokeComponent *component = [self nextStrokeComponent];
-    [self.trackingBrush addStrokeComponent:component];
+    if (CVSBrushTypePaintbucket == self.brushType) {
+        // nothing is drawn until the fill ends
+        const CGPoint location = [inTouch locationInView:touchedView];
+        _fillSeedPoint = (CVSSCPoint){location.x, location.y};
+        _isFilling = true;
+        return;
+    }
 
-    if(_consumerFlags.consumerDidStartStrokeWithComponent) {
+    const CVSSCComponent * const component = [self addSamplePoint:[inTouch locationInView:touchedView]];
+    if (component && _consumerFlags.consumerDidStartStrokeWithComponent) {
         [self.consumer strokeGenerator:self didStartStrokeWithComponent:component];
     }
 }
 
 - (void)addPointWithTouch:(UITouch *)inTouch
 {
-    if (!self.trackingBrush.isTracking)
+    if (!_isTracking || _isFilling)
     {
         return;
     }
-    UIView *touchedView = inTouch.view;
-    while (strcmp(class_getName([touchedView class]), "CVSEditorView") != 0 && class_getName([touchedView class]) != nil) {
-        touchedView = touchedView.superview;
-    }
-
-    CGPoint point = [inTouch locationInView:touchedView];
-
-    [self addSamplePoint:point];
-    CVSStrokeComponent *component = [self nextStrokeComponent];
-    [self.trackingBrush addStrokeComponent:component];
-
-    if(_consumerFlags.consumerDidContinueStrokeWithComponent) {
+    const CVSSCComponent * const component = [self addSamplePoint:[inTouch locationInView:self.trackingView]];
+    if (component && _consumerFlags.consumerDidContinueStrokeWithComponent) {
         [self.consumer strokeGenerator:self didContinueStrokeWithComponent:component];
     }
 }
@@ -148,26 +142,33 @@ static const NSInteger kStrokeGeneratorPointCount = 4;
 
 - (void)endStrokeSinglePoint:(BOOL)singlePoint
 {
-    if (!self.trackingBrush.isTracking)
+    if (!_isTracking)
     {
         return;
     }
-    if (singlePoint) {
-        [self.trackingBrush addLineToPoint:self.trackingBrush.currentPoint];
-
-        if (_consumerFlags.consumerDidContinueStrokeWithComponent) {
-            CVSStrokeComponent *component = [self nextStrokeComponent];
-            [self.consumer strokeGenerator:self didContinueStrokeWithComponent:component];
-
+    if (_isFilling) {
+        if (_consumerFlags.consumerDidEndStroke) {
+            const CVSSCComponent component = CVSSCComponentMakeFill(_fillSeedPoint);
             CVSStroke *stroke = [self strokeForCurrentState];
-            stroke.components = [NSOrderedSet orderedSetWithObject:component];
+            [stroke setComponentRecords:&component count:1];
             [self.consumer strokeGenerator:self didEndStroke:stroke];
         }
+    } else if (singlePoint) {
+        if (_consumerFlags.consumerDidContinueStrokeWithComponent) {
+            const CVSSCComponent * const component = CVSSCStrokeTrackerRepeatComponent(_tracker);
+            if (component) {
+                [self.consumer strokeGenerator:self didContinueStrokeWithComponent:component];
+
+                CVSStroke *stroke = [self strokeForCurrentState];
+                [stroke setComponentRecords:component count:1];
+                [self.consumer strokeGenerator:self didEndStroke:stroke];
+            }
+        }
     } else {
         if(_consumerFlags.consumerDidEndStroke) {
 
             CVSStroke *stroke = [self strokeForCurrentState];
-            stroke.components = [NSOrderedSet orderedSetWithArray:self.trackingComponents];
+            [self setSimplifiedTrackingComponentsOfStroke:stroke];
             [self.consumer strokeGenerator:self didEndStroke:stroke];
         }
     }
@@ -180,8 +181,9 @@ static const NSInteger kStrokeGeneratorPointCount = 4;
     // using the number of events -> components to choose whether or not the tracking stroke should be discarded or committed.
     // events on the iPhone 5 are typically 15-20ms apart. so there is a combination of time and tracking area using this approach.
     const NSUInteger MinComponents = 12;
-    const NSUInteger nComponents = self.trackingComponents.count;
-    if (MinComponents > nComponents) {
+    const NSUInteger nComponents = CVSSCStrokeTrackerGetComponentCount(_tracker);
+    // an interrupted fill is discarded: the touch may have begun a gesture rather than a tap
+    if (_isFilling || MinComponents > nComponents) {
         [self disposeActiveStroke];
         return;
     }
@@ -193,13 +195,31 @@ static const NSInteger kStrokeGeneratorPointCount = 4;
 
 - (void)disposeActiveStroke
 {
-    [self.trackingBrush endTracking];
-    [self clearSamplePointsArray];
-    [self.trackingComponents removeAllObjects];
+    _isTracking = false;
+    _isFilling = false;
+    self.trackingView = nil;
+    CVSSCStrokeTrackerReset(_tracker);
 }
 
 #pragma mark - Path Generation
 
+- (void)setSimplifiedTrackingComponentsOfStroke:(CVSStroke *)pStroke
+{
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType((CVSSCBrushType)self.brushType);
+    const CVSSCComponent * const components = CVSSCStrokeTrackerGetComponents(_tracker);
+    const size_t count = CVSSCStrokeTrackerGetComponentCount(_tracker);
+    if (!(0.0 < self.simplificationTolerance) || CVSSCLineCapRound != brush->lineCap || 2 > count) {
+        [pStroke setComponentRecords:components count:count];
+        return;
+    }
+    NSMutableData *data = [NSMutableData dataWithLength:count * sizeof(CVSSCComponent)];
+    CVSSCComponent* const simplified = (CVSSCComponent*)data.mutableBytes;
+    // the components are in points; the tolerance is in pixels
+    const double tolerance = self.simplificationTolerance / [UIScreen mainScreen].scale;
+    const size_t simplifiedCount = CVSSCSimplifyComponents(components, count, tolerance, simplified);
+    [pStroke setComponentRecords:simplified count:simplifiedCount];
+}
+
 - (CVSStroke *)strokeForCurrentState
 {
     CVSStroke *stroke = [self.strokeManager newStroke];
@@ -212,75 +232,9 @@ static const NSInteger kStrokeGeneratorPointCount = 4;
     return stroke;
 }
 
-- (CVSStrokeComponent *)nextStrokeComponent
+- (const CVSSCComponent *)addSamplePoint:(CGPoint)point
 {
-    if([self.samplePoints count] < kStrokeGeneratorPointCount) {
-        CVSStrokeComponent *component = [self.strokeManager newStrokeComponent];
-
-        if([self.samplePoints count] == 1) {
-            CGPoint point = [[self.samplePoints lastObject] CGPointValue];
-            component.fromPoint = point;
-            component.toPoint = point;
-        } else {
-            CGPoint fromPoint = [[self.samplePoints objectAtIndex:1] CGPointValue];
-            CGPoint toPoint = [[self.samplePoints objectAtIndex:0] CGPointValue];
-            component.fromPoint = fromPoint;
-            component.toPoint = toPoint;
-        }
-
-        [self.trackingComponents addObject:component];
-
-        return component;
-    }
-
-    CGPoint samplePoint0 = [[self.samplePoints lastObject] CGPointValue];
-    CGPoint samplePoint1 = [[self.samplePoints objectAtIndex:2] CGPointValue];
-    CGPoint samplePoint2 = [[self.samplePoints objectAtIndex:1] CGPointValue];
-    CGPoint samplePoint3 = [[self.samplePoints objectAtIndex:0] CGPointValue];
-
-    // Calculate the midpoint of lines formed by sample points
-    CGFloat line1MidpointX = (samplePoint0.x + samplePoint1.x) / 2.0f;
-    CGFloat line1MidpointY = (samplePoint0.y + samplePoint1.y) / 2.0f;
-    CGFloat line2MidpointX = (samplePoint1.x + samplePoint2.x) / 2.0f;
-    CGFloat line2MidpointY = (samplePoint1.y + samplePoint2.y) / 2.0f;
-    CGFloat line3MidpointX = (samplePoint2.x + samplePoint3.x) / 2.0f;
-    CGFloat line3MidpointY = (samplePoint2.y + samplePoint3.y) / 2.0f;
-
-    CGFloat line1Length = CVSLineDistance(samplePoint0, samplePoint1);
-    CGFloat line2Length = CVSLineDistance(samplePoint1, samplePoint2);
-    CGFloat line3Length = CVSLineDistance(samplePoint2, samplePoint3);
-
-    // JC: if the sum of lengths is tiny, the coefficients should be 0. however, i have not seen this manifest (error would be control point with a NaN).
-    CGFloat coefficient1 = line1Length / (line1Length + line2Length);
-    CGFloat coefficient2 = line2Length / (line2Length + line3Length);
-
-    CGFloat xm1 = line1MidpointX + (line2MidpointX - line1MidpointX) * coefficient1;
-    CGFloat ym1 = line1MidpointY + (line2MidpointY - line1MidpointY) * coefficient1;
-    CGFloat xm2 = line2MidpointX + (line3MidpointX - line2MidpointX) * coefficient2;
-    CGFloat ym2 = line2MidpointY + (line3MidpointY - line2MidpointY) * coefficient2;
-
-    CGFloat smoothValue = 0.5f;
-
-    CGFloat controlPoint1x = xm1 + (line2MidpointX - xm1) * smoothValue + samplePoint1.x - xm1;
-    CGFloat controlPoint1y = ym1 + (line2MidpointY - ym1) * smoothValue + samplePoint1.y - ym1;
-    CGFloat controlPoint2x = xm2 + (line2MidpointX - xm2) * smoothValue + samplePoint2.x - xm2;
-    CGFloat controlPoint2y = ym2 + (line2MidpointY - ym2) * smoothValue + samplePoint2.y - ym2;
-
-    CGPoint fromPoint = CGPointMake(samplePoint1.x, samplePoint1.y);
-    CGPoint toPoint = CGPointMake(samplePoint2.x, samplePoint2.y);
-    CGPoint controlPoint1 = CGPointMake(controlPoint1x, controlPoint1y);
-    CGPoint controlPoint2 = CGPointMake(controlPoint2x, controlPoint2y);
-
-    CVSStrokeComponent *component = [self.strokeManager newStrokeComponent];
-    component.type = CVSStrokeComponentTypeCurve;
-    component.fromPoint = fromPoint;
-    component.toPoint = toPoint;
-    component.controlPoint1 = controlPoint1;
-    component.controlPoint2 = controlPoint2;
-    
-    [self.trackingComponents addObject:component];
-    
-    return component;
+    return CVSSCStrokeTrackerAddSample(_tracker, (CVSSCPoint){point.x, point.y});
 }
 
 @end
@@ -0,0 +1,99 @@
+// CVSStrokeJournal.h
+// Editor
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+#include "CVSSCStrokeJournal.h"
+
+@protocol CVSStrokeJournalReader;
+
+/**
+ @brief the longest a written record waits to be synchronized to storage, in seconds.
+ */
+extern const NSTimeInterval CVSStrokeJournalSynchronizationDelay;
+
+/**
+ @class the append-only journal of a draft's edits (see CVSSCStrokeJournal.h).
+ @details records are encoded on the caller's thread, in time proportional to the record, and are written in order on the
+ journal's serial queue. a record is handed to the file system as soon as the queue reaches it, so it survives the app
+ being killed; the file is synchronized to storage (fsync) at most once per CVSStrokeJournalSynchronizationDelay, which
+ bounds what a power loss may take to the records of that interval.
+ */
+@interface CVSStrokeJournal : NSObject
+
+- (instancetype)initWithPath:(NSString *)pPath;
+
+@property (nonatomic, readonly) NSString * path;
+
+/**
+ @return YES if a journal exists at @p pPath
+ */
++ (BOOL)journalExistsAtPath:(NSString *)pPath;
+
+/**
+ @brief replays the journal's records to @p pReader (on the calling thread), truncates a damaged tail, and opens the
+ journal to append records. a journal is created if none exists. a file which is not a journal is moved aside.
+ @return NO if the journal could not be opened, in which case records are not written.
+ */
+- (BOOL)openWithReader:(id<CVSStrokeJournalReader>)pReader;
+
+/**
+ @brief as -openWithReader:, and tells @p pReader when the records up to @p pMark (an appendedLength) have been read.
+ @details a reader which saved state derived from the draft (e.g. an image of it) with the appendedLength of the time
+ knows that the state applies to the records read by then -- if the mark is reached.
+ */
+- (BOOL)openWithReader:(id<CVSStrokeJournalReader>)pReader mark:(uint64_t)pMark;
+
+/**
+ @brief the journal as it was replayed, which the components of the strokes read point into. nil if nothing was read.
+ */
+@property (nonatomic, readonly) NSData * replayedData;
+
+/**
+ @brief the length of the journal once the records appended so far have been written. waits for the pending writes.
+ 0 once a failed write has closed the journal: the journal no longer holds the records appended since, so no state is marked
+ with its length.
+ */
+@property (nonatomic, readonly) uint64_t appendedLength;
+
+/**
+ @brief the stroke refers to its color by its index in the journal's palette. a color which is new to the palette is appended
+ with the stroke.
+ */
+- (void)appendStroke:(const CVSSCPlaybackStroke *)pStroke;
+- (void)appendUndo;
+- (void)appendRedo;
+- (void)appendUsesTemplate:(BOOL)pUsesTemplate;
+
+/**
+ @brief waits until every record has been written and synchronized to storage.
+ */
+- (void)synchronize;
+
+/**
+ @brief discards pending records, closes and deletes the journal. records may not be appended until it is opened again.
+ */
+- (void)closeAndRemove;
+
+@end
+
+@protocol CVSStrokeJournalReader <NSObject>
+
+@required
+/**
+ @brief the stroke's components point into the journal's replayedData, and are valid as long as it.
+ */
+- (void)strokeJournal:(CVSStrokeJournal *)pJournal didReadStroke:(const CVSSCPlaybackStroke *)pStroke;
+/**
+ @param pType Undo, Redo or UsesTemplate
+ */
+- (void)strokeJournal:(CVSStrokeJournal *)pJournal didReadEvent:(CVSSCStrokeJournalRecordType)pType value:(uint32_t)pValue;
+
+@optional
+/**
+ @brief the records up to the mark of -openWithReader:mark: have been read, and the mark is the end of a record.
+ */
+- (void)strokeJournalDidReadToMark:(CVSStrokeJournal *)pJournal;
+
+@end
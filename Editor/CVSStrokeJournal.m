@@ -0,0 +1,315 @@
+// CVSStrokeJournal.m
+// Editor
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#import "CVSStrokeJournal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+const NSTimeInterval CVSStrokeJournalSynchronizationDelay = 0.5;
+
+static const char CVSStrokeJournal_Queue[] = "as.canv.CVSStrokeJournal";
+
+@interface CVSStrokeJournal ()
+
+@property (nonatomic, readonly) dispatch_queue_t queue;
+
+@end
+
+@implementation CVSStrokeJournal
+{
+    // the journal's palette: the colors of its Color records. used on the caller's thread, as records are encoded.
+    CVSSCPalette * palette;
+    // the fields below are only used on the queue (or before it is used, in -openWithReader:)
+    int fileDescriptor;
+    // the length of the intact records. a failed write is truncated to it.
+    off_t length;
+    // true once a failed write has closed the journal
+    bool hasFailed;
+    bool isSynchronizationPending;
+}
+
+@synthesize path = _path;
+@synthesize queue = _queue;
+@synthesize replayedData = _replayedData;
+
+- (id)init
+{
+    assert(0 && "invalid initializer");
+    return nil;
+}
+
+- (instancetype)initWithPath:(NSString *)pPath
+{
+    assert(pPath);
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    _path = [pPath copy];
+    _queue = dispatch_queue_create(CVSStrokeJournal_Queue, DISPATCH_QUEUE_SERIAL);
+    if (!_queue) {
+        assert(0 && "failed to create journal queue");
+        return nil;
+    }
+    palette = CVSSCPaletteCreate();
+    if (!palette) {
+        return nil;
+    }
+    fileDescriptor = -1;
+    return self;
+}
+
+- (void)dealloc
+{
+    CVSSCPaletteDestroy(palette);
+    // pending blocks retain the journal, so nothing is pending
+    if (-1 != fileDescriptor) {
+        fsync(fileDescriptor);
+        close(fileDescriptor);
+    }
+}
+
++ (BOOL)journalExistsAtPath:(NSString *)pPath
+{
+    return [[NSFileManager new] fileExistsAtPath:pPath];
+}
+
+#pragma mark - Opening
+
+struct CVSStrokeJournalReplay {
+    __unsafe_unretained CVSStrokeJournal * journal;
+    __unsafe_unretained id<CVSStrokeJournalReader> reader;
+};
+
+static bool ReplayReadStroke(void* const pContext, const CVSSCPlaybackStroke* const pStroke) {
+    struct CVSStrokeJournalReplay* const replay = pContext;
+    @autoreleasepool {
+        [replay->reader strokeJournal:replay->journal didReadStroke:pStroke];
+    }
+    return true;
+}
+
+static bool ReplayReadEvent(void* const pContext, const CVSSCStrokeJournalRecordType pType, const uint32_t pValue) {
+    struct CVSStrokeJournalReplay* const replay = pContext;
+    [replay->reader strokeJournal:replay->journal didReadEvent:pType value:pValue];
+    return true;
+}
+
+- (BOOL)openWithReader:(id<CVSStrokeJournalReader>)pReader
+{
+    return [self openWithReader:pReader mark:0];
+}
+
+- (BOOL)openWithReader:(id<CVSStrokeJournalReader>)pReader mark:(uint64_t)pMark
+{
+    assert(pReader);
+    assert(-1 == fileDescriptor && "journal is open");
+    const char * const path = self.path.fileSystemRepresentation;
+    size_t validLength = 0;
+    _replayedData = nil;
+    NSData * const data = [NSData dataWithContentsOfFile:self.path options:NSDataReadingMappedIfSafe error:NULL];
+    if (data.length) {
+        struct CVSStrokeJournalReplay replay = {self, pReader};
+        const CVSSCStrokeJournalCallbacks callbacks = {
+            .context = &replay,
+            .readStroke = ReplayReadStroke,
+            .readEvent = ReplayReadEvent
+        };
+        CVSSCStrokeJournalStatus status;
+        if (pMark && pMark <= data.length) {
+            // the records up to the mark, then the records which follow it
+            status = CVSSCStrokeJournalRead(data.bytes, (size_t)pMark, &callbacks, palette, &validLength);
+            if (CVSSCStrokeJournalStatusComplete == status && [pReader respondsToSelector:@selector(strokeJournalDidReadToMark:)]) {
+                [pReader strokeJournalDidReadToMark:self];
+            }
+            if (CVSSCStrokeJournalStatusMalformed != status && CVSSCStrokeJournalStatusFailed != status) {
+                status = CVSSCStrokeJournalReadRecords(data.bytes, data.length, validLength, &callbacks, palette, &validLength);
+            }
+        } else {
+            status = CVSSCStrokeJournalRead(data.bytes, data.length, &callbacks, palette, &validLength);
+        }
+        if (CVSSCStrokeJournalStatusFailed == status) {
+            // the rest of the journal is intact. it is not truncated, and records are not appended to it.
+            NSLog(@"CVSStrokeJournal: %@ could not be read (out of memory).", self.path);
+            return NO;
+        }
+        if (CVSSCStrokeJournalStatusMalformed == status) {
+            NSLog(@"CVSStrokeJournal: %@ is not a journal. it is moved aside.", self.path);
+            rename(path, [[self.path stringByAppendingPathExtension:@"damaged"] fileSystemRepresentation]);
+            validLength = 0;
+            CVSSCPaletteRemoveAll(palette);
+        } else {
+            _replayedData = data;
+            if (CVSSCStrokeJournalStatusTruncated == status) {
+                NSLog(@"CVSStrokeJournal: %@ has a damaged tail of %lu octets. it is truncated.", self.path, (unsigned long)(data.length - validLength));
+            }
+        }
+    }
+    const int descriptor = open(path, O_WRONLY | O_CREAT, 0644);
+    if (-1 == descriptor) {
+        NSLog(@"CVSStrokeJournal: could not open %@ (%d)", self.path, errno);
+        return NO;
+    }
+    if (0 == validLength) {
+        uint8_t header[CVSSCStrokeJournalHeaderLength];
+        CVSSCStrokeJournalWriteHeader(header);
+        if (0 != ftruncate(descriptor, 0) || (ssize_t)sizeof(header) != pwrite(descriptor, header, sizeof(header), 0) || 0 != fsync(descriptor)) {
+            NSLog(@"CVSStrokeJournal: could not create %@ (%d)", self.path, errno);
+            close(descriptor);
+            return NO;
+        }
+        validLength = sizeof(header);
+    } else if (validLength != data.length && 0 != ftruncate(descriptor, (off_t)validLength)) {
+        NSLog(@"CVSStrokeJournal: could not truncate %@ (%d)", self.path, errno);
+        close(descriptor);
+        return NO;
+    }
+    if (-1 == lseek(descriptor, (off_t)validLength, SEEK_SET)) {
+        close(descriptor);
+        return NO;
+    }
+    // a journal which was closed may have a synchronization pending
+    dispatch_sync(self.queue, ^{
+        fileDescriptor = descriptor;
+        length = (off_t)validLength;
+        hasFailed = false;
+    });
+    return YES;
+}
+
+#pragma mark - Appending
+
+// on the queue. the records which follow may depend on this one (an Undo or Redo on its stroke, a stroke on its Color record),
+// so a failed write closes the journal rather than discarding the record.
+- (void)writeRecord:(NSData *)pRecord
+{
+    if (-1 == fileDescriptor) {
+        return;
+    }
+    const uint8_t * bytes = pRecord.bytes;
+    size_t remaining = pRecord.length;
+    while (remaining) {
+        const ssize_t written = write(fileDescriptor, bytes, remaining);
+        if (0 > written) {
+            if (EINTR == errno) {
+                continue;
+            }
+            // a partial record is truncated away, so that the journal ends with the last intact record when it is replayed
+            NSLog(@"CVSStrokeJournal: write failed (%d). the journal is closed.", errno);
+            if (0 != ftruncate(fileDescriptor, length)) {
+                NSLog(@"CVSStrokeJournal: could not discard a partial record (%d).", errno);
+            }
+            close(fileDescriptor);
+            fileDescriptor = -1;
+            hasFailed = true;
+            return;
+        }
+        bytes += written;
+        remaining -= (size_t)written;
+    }
+    length += (off_t)pRecord.length;
+    if (!isSynchronizationPending) {
+        // the records written until then are synchronized together
+        isSynchronizationPending = true;
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(CVSStrokeJournalSynchronizationDelay * NSEC_PER_SEC)), self.queue, ^{
+            [self synchronizeOnQueue];
+        });
+    }
+}
+
+// on the queue
+- (void)synchronizeOnQueue
+{
+    isSynchronizationPending = false;
+    if (-1 != fileDescriptor && 0 != fsync(fileDescriptor)) {
+        NSLog(@"CVSStrokeJournal: fsync failed (%d)", errno);
+    }
+}
+
+- (void)appendRecord:(NSData *)pRecord
+{
+    dispatch_async(self.queue, ^{
+        [self writeRecord:pRecord];
+    });
+}
+
+// waits for the pending writes, so the length only includes records which were written
+- (uint64_t)appendedLength
+{
+    __block uint64_t result = 0;
+    dispatch_sync(self.queue, ^{
+        result = hasFailed ? 0 : (uint64_t)length;
+    });
+    return result;
+}
+
+- (void)appendStroke:(const CVSSCPlaybackStroke *)pStroke
+{
+    assert(pStroke);
+    CVSSCPaletteIndex colorIndex = CVSSCPaletteIndexNone;
+    bool isNewColor = false;
+    if (!CVSSCPaletteFindOrAdd(palette, pStroke->color, &colorIndex, &isNewColor)) {
+        NSLog(@"CVSStrokeJournal: the stroke's color could not be added to the palette. the stroke is not journaled.");
+        return;
+    }
+    // a new color's record precedes the stroke, in the same write
+    const size_t colorRecordLength = isNewColor ? CVSSCStrokeJournalColorRecordLength : 0;
+    NSMutableData * const record = [[NSMutableData alloc] initWithLength:colorRecordLength + CVSSCStrokeJournalStrokeRecordLength(pStroke->componentCount)];
+    uint8_t * const bytes = record.mutableBytes;
+    if (isNewColor) {
+        CVSSCStrokeJournalWriteColorRecord(bytes, colorIndex, pStroke->color);
+    }
+    CVSSCStrokeJournalWriteStrokeRecord(bytes + colorRecordLength, pStroke, colorIndex);
+    [self appendRecord:record];
+}
+
+- (void)appendEvent:(CVSSCStrokeJournalRecordType)pType value:(uint32_t)pValue
+{
+    uint8_t record[CVSSCStrokeJournalEventRecordLength];
+    const size_t recordLength = CVSSCStrokeJournalWriteEventRecord(record, pType, pValue);
+    [self appendRecord:[NSData dataWithBytes:record length:recordLength]];
+}
+
+- (void)appendUndo
+{
+    [self appendEvent:CVSSCStrokeJournalRecordUndo value:0];
+}
+
+- (void)appendRedo
+{
+    [self appendEvent:CVSSCStrokeJournalRecordRedo value:0];
+}
+
+- (void)appendUsesTemplate:(BOOL)pUsesTemplate
+{
+    [self appendEvent:CVSSCStrokeJournalRecordUsesTemplate value:pUsesTemplate ? 1 : 0];
+}
+
+#pragma mark -
+
+- (void)synchronize
+{
+    dispatch_sync(self.queue, ^{
+        [self synchronizeOnQueue];
+    });
+}
+
+- (void)closeAndRemove
+{
+    dispatch_sync(self.queue, ^{
+        if (-1 != fileDescriptor) {
+            close(fileDescriptor);
+            fileDescriptor = -1;
+        }
+        length = 0;
+        hasFailed = false;
+        unlink(self.path.fileSystemRepresentation);
+    });
+    CVSSCPaletteRemoveAll(palette);
+    _replayedData = nil;
+}
+
+@end
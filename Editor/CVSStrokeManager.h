@@ -46,8 +46,13 @@ extern NSString * const CVSStrokeManagerDataIdentifier;
 - (void)redoStroke;
 - (void)clearCurrentStrokes;
 
+/**
+ @brief saves the renderer's image of the drawing, so that the draft is shown without rendering its strokes when it is loaded again.
+ @details the image is saved if the drawing changed since the last image was saved or loaded.
+ */
+- (void)saveDraftImage;
+
 - (CVSStroke *)newStroke;
-- (CVSStrokeComponent *)newStrokeComponent;
 
 @end
 
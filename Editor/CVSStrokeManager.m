@@ -11,11 +11,14 @@
 #import "NSFileManager+STAdditions.h"
 #import "UIColor+DQAdditions.h"
 
+#import <QuartzCore/QuartzCore.h>
+
+#import "CVSDraftImage.h"
 #import "CVSDrawing.h"
 #import "CVSDrawingTypes.h"
 #import "CVSStroke.h"
-#import "CVSStrokeComponent.h"
 #import "CVSStrokeArray.h"
+#import "CVSStrokeJournal.h"
 #import "STDataStoreController.h"
 #import "CVSUniqueUIColorCache.h"
 #import "CVSBackedRenderer.h"
@@ -23,18 +26,44 @@
 
 NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
 
-@interface CVSStrokeManager()
+// the draft's journal, in the root path
+static NSString * const CVSStrokeManagerJournalFileName = @"strokes.journal";
+// the image of the draft's strokes, in the root path
+static NSString * const CVSStrokeManagerDraftImageFileName = @"draft.image";
+
+@interface CVSStrokeManager() <CVSStrokeJournalReader>
 
 @property (nonatomic, readwrite, strong) CVSDrawing *currentDrawing;
+/**
+ @brief the Core Data store of earlier versions, which is imported into the journal once. it also provides the model's entities.
+ */
 @property (nonatomic, strong) STDataStoreController *dataStoreController;
+@property (nonatomic, strong) CVSStrokeJournal *journal;
+@property (nonatomic, strong) CVSDraftImage *draftImage;
 @property (nonatomic, strong) CVSStrokeArray *committedStack;
 @property (nonatomic, strong) CVSStrokeArray *redoStack;
+/**
+ @brief the strokes at the bottom of the drawing which the renderer shows with the draft image, and which have not been
+ materialized (CVSSCPlaybackStroke). they are materialized when one of them is undone, or the drawing is published.
+ */
+@property (nonatomic, strong) NSMutableData *loadedStrokes;
+// the journal's bytes, which the components of the loaded strokes point into
+@property (nonatomic, strong) NSData *loadedStrokesData;
+// the committed and undone strokes of the journal, as it is replayed (CVSSCPlaybackStroke)
+@property (nonatomic, strong) NSMutableData *replayedStrokes;
+@property (nonatomic, strong) NSMutableData *replayedRedoStrokes;
 @property (nonatomic, readwrite, getter = isUndoAvailable) BOOL undoAvailable;
 @property (nonatomic, readwrite, getter = isRedoAvailable) BOOL redoAvailable;
 
 @end
 
 @implementation CVSStrokeManager
+{
+    // the number of strokes the renderer shows with the draft image, which it does not hold. 0 once they are adopted.
+    NSUInteger draftImageStrokeCount;
+    // the journal length of the draft image which was loaded or saved last
+    uint64_t draftImageJournalLength;
+}
 
 - (id)initWithRootPath:(NSString *)rootPath delegate:(id<CVSStrokeManagerDelegate>)delegate
 {
@@ -54,6 +83,8 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
     _dataStoreController = [[STDataStoreController alloc] initWithIdentifier:CVSStrokeManagerDataIdentifier
                                                                rootDirectory:_rootPath
                                                                    modelPath:modelPath];
+    _journal = [[CVSStrokeJournal alloc] initWithPath:[_rootPath stringByAppendingPathComponent:CVSStrokeManagerJournalFileName]];
+    _draftImage = [[CVSDraftImage alloc] initWithPath:[_rootPath stringByAppendingPathComponent:CVSStrokeManagerDraftImageFileName]];
     _committedStack = [CVSStrokeArray new];
     _redoStack = [CVSStrokeArray new];
 
@@ -62,23 +93,50 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
 
 #pragma mark - Accessors
 
+- (NSUInteger)loadedStrokeCount
+{
+    return self.loadedStrokes.length / sizeof(CVSSCPlaybackStroke);
+}
+
 - (NSUInteger)numberOfStrokes
 {
-    return self.currentDrawing.numberOfStrokes;
+    return self.loadedStrokeCount + self.currentDrawing.numberOfStrokes;
 }
 
 #pragma mark - Object Vending
 
+- (NSEntityDescription *)entityForName:(NSString *)pName
+{
+    // the entity is taken from the model so that the persistent store is not opened
+    return [self.dataStoreController.managedObjectModel.entitiesByName objectForKey:pName];
+}
+
 - (CVSStroke *)newStroke
 {
-    NSManagedObjectContext *moc = self.dataStoreController.mainContext;
-    return [[CVSStroke alloc] initWithEntity:[NSEntityDescription entityForName:@"CVSStroke" inManagedObjectContext:moc] insertIntoManagedObjectContext:moc];
+    // strokes are persisted by the journal, so they are never inserted
+    return [[CVSStroke alloc] initWithEntity:[self entityForName:@"CVSStroke"] insertIntoManagedObjectContext:nil];
 }
 
-- (CVSStrokeComponent *)newStrokeComponent
+- (CVSDrawing *)newDrawing
 {
-    NSManagedObjectContext *moc = self.dataStoreController.mainContext;
-    return [[CVSStrokeComponent alloc] initWithEntity:[NSEntityDescription entityForName:@"CVSStrokeComponent" inManagedObjectContext:moc] insertIntoManagedObjectContext:moc];
+    return [[CVSDrawing alloc] initWithEntity:[self entityForName:@"CVSDrawing"] insertIntoManagedObjectContext:nil];
+}
+
+/**
+ @return a stroke which copies @p pStroke, or nil if it cannot be rendered (as CVSStrokeArray, such strokes are skipped)
+ */
+- (CVSStroke *)newStrokeWithPlaybackStroke:(const CVSSCPlaybackStroke *)pStroke
+{
+    if (!pStroke->componentCount || CVSBrushTypePen > pStroke->brushType || CVSBrushTypeCount < pStroke->brushType)
+    {
+        return nil;
+    }
+    CVSStroke *stroke = [self newStroke];
+    stroke.brushType = (CVSBrushType)pStroke->brushType;
+    stroke.strokeColor = [UIColor colorWithRed:(CGFloat)pStroke->color.red green:(CGFloat)pStroke->color.green blue:(CGFloat)pStroke->color.blue alpha:(CGFloat)pStroke->color.alpha];
+    [stroke deduplicateObjectStateUsingUIColorCache:self.currentDrawing.uniqueUIColorCache];
+    [stroke setComponentRecords:pStroke->components count:pStroke->componentCount];
+    return stroke;
 }
 
 #pragma mark -
@@ -96,6 +154,7 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
 {
     if (self.numberOfStrokes)
     {
+        [self materializeLoadedStrokes];
         NSString *imagePath = [self.rootPath stringByAppendingPathComponent:@"image.png"];
         NSString *playbackDataPath = [self.rootPath stringByAppendingPathComponent:@"playback.json"];
         if ([UIImagePNGRepresentation(editorImage) writeToFile:imagePath atomically:NO])
@@ -109,12 +168,19 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
 
 - (void)clearTemplateImage
 {
+    [self lazyLoadDrawing];
     self.currentDrawing.usesTemplate = @(NO);
+    [self.journal appendUsesTemplate:NO];
 }
 
 - (void)clearCurrentStrokes
 {
     self.currentDrawing = nil;
+    [self clearLoadedStrokes];
+    draftImageStrokeCount = 0;
+    [self.journal closeAndRemove];
+    [self.draftImage remove];
+    draftImageJournalLength = 0;
     [self.dataStoreController deletePersistentStore];
     [self emptyRedoStack];
     [self emptyUndoStack];
@@ -128,26 +194,39 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
     if (!self.currentDrawing)
     {
         [self load];
-        if (!self.currentDrawing)
-        {
-            NSManagedObjectContext *moc = self.dataStoreController.mainContext;
-            self.currentDrawing = [[CVSDrawing alloc] initWithEntity:[NSEntityDescription entityForName:@"CVSDrawing" inManagedObjectContext:moc] insertIntoManagedObjectContext:moc];
-        }
     }
 }
 
+// appends the stroke to the drawing and the undo stack, and indexes its color in the drawing's color cache. the caller journals it.
+- (void)commitStroke:(CVSStroke *)pStroke
+{
+    [pStroke deduplicateObjectStateUsingUIColorCache:self.currentDrawing.uniqueUIColorCache];
+    pStroke.drawing = self.currentDrawing;
+    [self.currentDrawing addStrokesObject:pStroke];
+    [self.committedStack addStroke:pStroke];
+}
+
+- (void)appendStrokeToJournal:(CVSStroke *)pStroke
+{
+    CGFloat red = 0.0, green = 0.0, blue = 0.0, alpha = 0.0;
+    [pStroke.strokeColor getRed:&red green:&green blue:&blue alpha:&alpha];
+    const CVSSCPlaybackStroke stroke = {
+        .brushType = (uint32_t)pStroke.brushType,
+        .color = {red, green, blue, alpha},
+        .components = pStroke.componentRecords,
+        .componentCount = pStroke.componentCount
+    };
+    [self.journal appendStroke:&stroke];
+}
+
 - (void)processStroke:(CVSStroke *)inStroke
 {
     [self lazyLoadDrawing];
-    if ([inStroke.components count])
+    if (inStroke.componentCount)
     {
-        // Update the data store
-        inStroke.drawing = self.currentDrawing;
-        [self.currentDrawing addStrokesObject:inStroke];
-
-        // Update undo stack
-        [self.committedStack addStroke:inStroke];
-        [self save];
+        // Update the drawing and the undo stack. the journal's write is asynchronous, so the cost of a commit does not grow with the drawing.
+        [self commitStroke:inStroke];
+        [self appendStrokeToJournal:inStroke];
         [self updateUndoRedoAvailability];
         [self notifyStrokeCountChangeObserver];
     }
@@ -187,7 +266,7 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
     [self.renderer rendererShouldRedoStrokes:pStrokes];
 }
 
-- (void)rendererShouldRenderStrokeComponent:(CVSStrokeComponent *)pComponent strokeGenerator:(CVSStrokeGenerator *)pStrokeGenerator
+- (void)rendererShouldRenderStrokeComponent:(const CVSSCComponent *)pComponent strokeGenerator:(CVSStrokeGenerator *)pStrokeGenerator
 {
     [self.renderer rendererShouldRenderStrokeComponent:pComponent strokeGenerator:pStrokeGenerator];
 }
@@ -204,55 +283,190 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
 
 #pragma mark - Stroke Storage
 
-- (void)save
+- (void)load
 {
     @autoreleasepool {
-        NSError *error = nil;
-        if (![self.dataStoreController.mainContext save:&error])
+        const CFTimeInterval start = CACurrentMediaTime();
+        self.currentDrawing = [self newDrawing];
+        [self clearLoadedStrokes];
+        draftImageStrokeCount = 0;
+        draftImageJournalLength = 0;
+        if (![CVSStrokeJournal journalExistsAtPath:self.journal.path] && [[NSFileManager new] fileExistsAtPath:self.dataStoreController.persistentStorePath])
         {
-            NSLog(@"CVSStrokeManager save error: %@", error);
+            [self importLegacyDrawing];
         }
+        else
+        {
+            // the strokes are indexed as they are replayed. those which the draft image shows are never materialized, unless they are undone.
+            self.replayedStrokes = [NSMutableData new];
+            self.replayedRedoStrokes = [NSMutableData new];
+            const uint64_t mark = [self.draftImage read] ? self.draftImage.journalLength : 0;
+            if (![self.journal openWithReader:self mark:mark])
+            {
+                [self logJournalOpenFailure];
+            }
+            [self materializeReplayedStrokes];
+        }
+        const CFTimeInterval replayed = CACurrentMediaTime();
+        CVSStrokeArray * strokeArray = [CVSStrokeArray new];
+        [strokeArray addStrokesFromArray:self.currentDrawing.strokes.array];
+        if (strokeArray.count) {
+            [self rendererShouldRedoStrokes:strokeArray];
+        }
+        [self updateUndoRedoAvailability];
+        [self notifyStrokeCountChangeObserver];
+        const CFTimeInterval rendered = CACurrentMediaTime();
+        const NSUInteger strokeCount = self.numberOfStrokes;
+        const NSUInteger imageStrokeCount = draftImageStrokeCount;
+        [DQPapertrailLogger component:@"stroke-manager" category:@"load-draft" dataBlock:^NSDictionary *(DQPapertrailLogger *logger, NSString *component, NSDictionary *componentDict, NSString *category, NSDictionary *categoryDict) {
+            return @{@"strokes": @(strokeCount),
+                     @"image_strokes": @(imageStrokeCount),
+                     @"replay_ms": @((replayed - start) * 1000.0),
+                     @"render_ms": @((rendered - replayed) * 1000.0)};
+        }];
     }
 }
 
-- (void)load
+/**
+ @brief shows the draft image, if it applies to the replayed journal, and materializes the strokes which follow it.
+ */
+- (void)materializeReplayedStrokes
+{
+    const CVSSCPlaybackStroke * const strokes = self.replayedStrokes.bytes;
+    const NSUInteger count = self.replayedStrokes.length / sizeof(CVSSCPlaybackStroke);
+    if (draftImageStrokeCount && ![self.renderer rendererShouldRestoreDraftImage:self.draftImage strokeCount:draftImageStrokeCount])
+    {
+        draftImageStrokeCount = 0;
+    }
+    assert(draftImageStrokeCount <= count);
+    if (draftImageStrokeCount)
+    {
+        self.loadedStrokes = [[NSMutableData alloc] initWithBytes:strokes length:draftImageStrokeCount * sizeof(CVSSCPlaybackStroke)];
+        self.loadedStrokesData = self.journal.replayedData;
+        draftImageJournalLength = self.journal.appendedLength == self.draftImage.journalLength ? self.draftImage.journalLength : 0;
+    }
+    // the drawing's strokes are set at once: adding them one at a time copies the ordered set for each
+    NSMutableOrderedSet *committed = [[NSMutableOrderedSet alloc] initWithCapacity:count - draftImageStrokeCount];
+    for (NSUInteger idx = draftImageStrokeCount; idx < count; ++idx)
+    {
+        CVSStroke *stroke = [self newStrokeWithPlaybackStroke:&strokes[idx]];
+        stroke.drawing = self.currentDrawing;
+        [committed addObject:stroke];
+        [self.committedStack addStroke:stroke];
+    }
+    self.currentDrawing.strokes = committed;
+    const CVSSCPlaybackStroke * const redoStrokes = self.replayedRedoStrokes.bytes;
+    const NSUInteger redoCount = self.replayedRedoStrokes.length / sizeof(CVSSCPlaybackStroke);
+    for (NSUInteger idx = 0; idx < redoCount; ++idx)
+    {
+        [self.redoStack addStroke:[self newStrokeWithPlaybackStroke:&redoStrokes[idx]]];
+    }
+    self.replayedStrokes = nil;
+    self.replayedRedoStrokes = nil;
+}
+
+/**
+ @brief materializes the loaded strokes at the bottom of the drawing and the undo stack.
+ */
+- (void)materializeLoadedStrokes
+{
+    const NSUInteger count = self.loadedStrokeCount;
+    if (!count)
+    {
+        return;
+    }
+    const CVSSCPlaybackStroke * const strokes = self.loadedStrokes.bytes;
+    NSMutableOrderedSet *committed = [[NSMutableOrderedSet alloc] initWithCapacity:count + self.currentDrawing.numberOfStrokes];
+    CVSStrokeArray *committedStack = [CVSStrokeArray new];
+    for (NSUInteger idx = 0; idx < count; ++idx)
+    {
+        CVSStroke *stroke = [self newStrokeWithPlaybackStroke:&strokes[idx]];
+        stroke.drawing = self.currentDrawing;
+        [committed addObject:stroke];
+        [committedStack addStroke:stroke];
+    }
+    [committed unionOrderedSet:self.currentDrawing.strokes];
+    self.currentDrawing.strokes = committed;
+    [committedStack addStrokes:self.committedStack];
+    self.committedStack = committedStack;
+    [self clearLoadedStrokes];
+}
+
+- (void)clearLoadedStrokes
 {
+    self.loadedStrokes = nil;
+    self.loadedStrokesData = nil;
+}
+
+- (void)saveDraftImage
+{
+    if (!self.currentDrawing)
+    {
+        return;
+    }
+    const uint64_t journalLength = self.journal.appendedLength;
+    if (journalLength == draftImageJournalLength)
+    {
+        return;
+    }
+    const NSUInteger strokeCount = self.numberOfStrokes;
+    if (!strokeCount)
+    {
+        [self.draftImage remove];
+        draftImageJournalLength = journalLength;
+    }
+    else if ([self.renderer rendererShouldSaveDraftImage:self.draftImage journalLength:journalLength strokeCount:strokeCount])
+    {
+        draftImageJournalLength = journalLength;
+    }
+}
+
+/**
+ @brief copies the drawing of the Core Data store of earlier versions into a new journal, and deletes the store.
+ */
+- (void)importLegacyDrawing
+{
+    if (![self.journal openWithReader:self])
+    {
+        // the store is kept to be imported next time
+        [self logJournalOpenFailure];
+        return;
+    }
     @autoreleasepool {
         NSManagedObjectContext *moc = self.dataStoreController.mainContext;
         NSEntityDescription *entity = [NSEntityDescription entityForName:@"CVSDrawing" inManagedObjectContext:moc];
         NSFetchRequest *request = [[NSFetchRequest alloc] init];
         [request setReturnsObjectsAsFaults:NO];
         request.entity = entity;
-        // TODO: remove strokes.strokeColor from this list as it's not a relationship - added in 4a2610a57426c7ab9f0bf99b427d1a5be6e0302e
-        [request setRelationshipKeyPathsForPrefetching:@[@"strokes", @"strokes.components", @"strokes.strokeColor"]];
+        // legacyComponents is empty once a drawing has been migrated
+        [request setRelationshipKeyPathsForPrefetching:@[@"strokes", @"strokes.legacyComponents"]];
 
         NSError *error = nil;
         NSArray *drawings = [moc executeFetchRequest:request error:&error];
         if ([drawings count])
         {
             CVSDrawing *d = [drawings objectAtIndex:0];
-            self.currentDrawing = d;
-            // JC: note that CoreData re-duplicates our colors. color deduplication was initially a test for the unique object cache,
-            // but the CoreData model will not be around much longer. then color deduplication can be improved.
-            // uses of CVSUniqueUIColorCache really should be reviewed once we move from the old model.
-            CVSUniqueUIColorCache * uniqueUIColorCache = d.uniqueUIColorCache;
-            CVSStrokeArray * strokeArray = [CVSStrokeArray new];
-
+            if (![d.usesTemplate boolValue])
+            {
+                self.currentDrawing.usesTemplate = @(NO);
+                [self.journal appendUsesTemplate:NO];
+            }
             NSMutableArray *badBrushes = [NSMutableArray new];
-            for (CVSStroke *stroke in d.strokes)
+            for (CVSStroke *legacyStroke in d.strokes)
             {
-                if ([stroke.components count])
+                [legacyStroke migrateLegacyComponentsIfNeeded];
+                if (legacyStroke.componentCount)
                 {
-                    [stroke deduplicateObjectStateUsingUIColorCache:uniqueUIColorCache];
-                    [self.committedStack addStroke:stroke]; // instead of processStroke: which adds the stroke to the drawing
-                    [strokeArray addStroke:stroke];
+                    CVSStroke *stroke = [self newStroke];
+                    stroke.brushType = legacyStroke.brushType;
+                    stroke.strokeColor = legacyStroke.strokeColor;
+                    [stroke setComponentRecords:legacyStroke.componentRecords count:legacyStroke.componentCount];
+                    [self commitStroke:stroke];
+                    [self appendStrokeToJournal:stroke];
                 }
                 else
                 {
-                    [badBrushes addObject:stroke.brushTypeNumber ?: [NSNull null]];
-                    [d removeStrokesObject:stroke];
-                    [moc deleteObject:stroke];
-                    [self save];
+                    [badBrushes addObject:legacyStroke.brushTypeNumber ?: [NSNull null]];
                 }
             }
             if ([badBrushes count])
@@ -261,12 +475,84 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
                     return @{@"brushes": badBrushes ?: [NSNull null]};
                 }];
             }
-            if (strokeArray.count) {
-                [self rendererShouldRedoStrokes:strokeArray];
+        }
+        else if (error)
+        {
+            NSLog(@"CVSStrokeManager import error: %@", error);
+            // without a journal, the store is imported next time
+            [self.journal closeAndRemove];
+            return;
+        }
+    }
+    // the store is deleted only once its strokes are in storage
+    [self.journal synchronize];
+    [self.dataStoreController deletePersistentStore];
+}
+
+- (void)logJournalOpenFailure
+{
+    NSString *path = self.journal.path;
+    [DQPapertrailLogger component:@"stroke-manager" category:@"open-journal-failed" dataBlock:^NSDictionary *(DQPapertrailLogger *logger, NSString *component, NSDictionary *componentDict, NSString *category, NSDictionary *categoryDict) {
+        return @{@"path": path ?: [NSNull null]};
+    }];
+}
+
+#pragma mark - CVSStrokeJournalReader
+
+// moves the last stroke of @p pFrom to @p pTo. returns NO if @p pFrom is empty.
+static BOOL CVSStrokeManagerMoveLastPlaybackStroke(NSMutableData *pFrom, NSMutableData *pTo)
+{
+    const NSUInteger length = pFrom.length;
+    if (!length)
+    {
+        return NO;
+    }
+    [pTo appendBytes:(const char *)pFrom.bytes + length - sizeof(CVSSCPlaybackStroke) length:sizeof(CVSSCPlaybackStroke)];
+    [pFrom setLength:length - sizeof(CVSSCPlaybackStroke)];
+    return YES;
+}
+
+- (void)strokeJournal:(CVSStrokeJournal *)pJournal didReadStroke:(const CVSSCPlaybackStroke *)pStroke
+{
+    if (!pStroke->componentCount || CVSBrushTypePen > pStroke->brushType || CVSBrushTypeCount < pStroke->brushType)
+    {
+        // as CVSStrokeArray, strokes which cannot be rendered are skipped
+        return;
+    }
+    [self.replayedStrokes appendBytes:pStroke length:sizeof(*pStroke)];
+    // as when drawing: a new stroke empties the redo stack
+    [self.replayedRedoStrokes setLength:0];
+}
+
+- (void)strokeJournal:(CVSStrokeJournal *)pJournal didReadEvent:(CVSSCStrokeJournalRecordType)pType value:(uint32_t)pValue
+{
+    switch (pType) {
+        case CVSSCStrokeJournalRecordUndo: {
+            CVSStrokeManagerMoveLastPlaybackStroke(self.replayedStrokes, self.replayedRedoStrokes);
+            if (self.replayedStrokes.length / sizeof(CVSSCPlaybackStroke) < draftImageStrokeCount) {
+                // the draft image shows a stroke which was undone after it was saved
+                draftImageStrokeCount = 0;
             }
+            break;
         }
-        [self updateUndoRedoAvailability];
-        [self notifyStrokeCountChangeObserver];
+        case CVSSCStrokeJournalRecordRedo: {
+            CVSStrokeManagerMoveLastPlaybackStroke(self.replayedRedoStrokes, self.replayedStrokes);
+            break;
+        }
+        case CVSSCStrokeJournalRecordUsesTemplate:
+            self.currentDrawing.usesTemplate = @(0 != pValue);
+            break;
+        default:
+            break;
+    }
+}
+
+- (void)strokeJournalDidReadToMark:(CVSStrokeJournal *)pJournal
+{
+    const NSUInteger count = self.replayedStrokes.length / sizeof(CVSSCPlaybackStroke);
+    if (count == self.draftImage.strokeCount)
+    {
+        draftImageStrokeCount = count;
     }
 }
 
@@ -274,15 +560,24 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
 
 - (void)undoStroke
 {
+    if (draftImageStrokeCount && draftImageStrokeCount == self.loadedStrokeCount + self.committedStack.count)
+    {
+        // the stroke to undo is one which the renderer shows with the draft image
+        [self materializeLoadedStrokes];
+        CVSStrokeArray *strokes = [CVSStrokeArray new];
+        [strokes addStrokes:self.committedStack];
+        [self.renderer rendererShouldAdoptDraftImageStrokes:strokes];
+        draftImageStrokeCount = 0;
+    }
     CVSStroke *stroke = self.committedStack.dequeueLastStroke;
 
     // Update undo stack
     [self.redoStack addStroke:stroke];
     [self updateUndoRedoAvailability];
 
-    // Update the data store
+    // Update the drawing
     [self.currentDrawing removeStrokesObject:stroke];
-    [self save];
+    [self.journal appendUndo];
     [self notifyStrokeCountChangeObserver];
     [self rendererShouldUndoStrokes:[CVSStrokeArray newStrokeArrayWithStroke:stroke]];
     [self notifyStrokeCountChangeObserver];
@@ -296,9 +591,9 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
     [self.committedStack addStroke:stroke];
     [self updateUndoRedoAvailability];
 
-    // Update the data store
+    // Update the drawing
     [self.currentDrawing addStrokesObject:stroke];
-    [self save];
+    [self.journal appendRedo];
     [self notifyStrokeCountChangeObserver];
     [self rendererShouldRedoStrokes:[CVSStrokeArray newStrokeArrayWithStroke:stroke]];
     [self notifyStrokeCountChangeObserver];
@@ -320,7 +615,7 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
 
 - (void)updateUndoRedoAvailability
 {
-    self.undoAvailable = [self.committedStack count] > 0;
+    self.undoAvailable = [self.committedStack count] + self.loadedStrokeCount > 0;
     self.redoAvailable = [self.redoStack count] > 0;
 
     [self.delegate strokeManagerUpdatedUndoStacks:self];
@@ -329,7 +624,7 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
 #pragma mark -
 #pragma mark CVSStrokeGeneratorConsumer
 
-- (void)strokeGenerator:(CVSStrokeGenerator *)generator didStartStrokeWithComponent:(CVSStrokeComponent *)component
+- (void)strokeGenerator:(CVSStrokeGenerator *)generator didStartStrokeWithComponent:(const CVSSCComponent *)component
 {
     if (self.renderer)
     {
@@ -343,13 +638,18 @@ NSString * const CVSStrokeManagerDataIdentifier = @"as.canv.drawquest.drawings";
     }
 }
 
-- (void)strokeGenerator:(CVSStrokeGenerator *)generator didContinueStrokeWithComponent:(CVSStrokeComponent *)component
+- (void)strokeGenerator:(CVSStrokeGenerator *)generator didContinueStrokeWithComponent:(const CVSSCComponent *)component
 {
     [self rendererShouldRenderStrokeComponent:component strokeGenerator:generator];
 }
 
 - (void)strokeGenerator:(CVSStrokeGenerator *)generator didEndStroke:(CVSStroke *)stroke
 {
+    // a fill does not start with a component
+    if (self.renderer && self.redoAvailable)
+    {
+        [self emptyRedoStack];
+    }
     [self processStroke:stroke];
     [self rendererShouldFinishRenderingStroke:stroke strokeGenerator:generator];
 }
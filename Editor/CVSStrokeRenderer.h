@@ -9,9 +9,12 @@
 #import <Foundation/Foundation.h>
 
 #import "CVSDrawingTypes.h"
+#include "CVSSCComponent.h"
 
 @class CVSStroke;
+@class UIColor;
 @class CVSStrokeArray;
+struct CVSDMTileGrid;
 
 /**
  @brief basic CVSStroke renderer abstraction
@@ -33,6 +36,24 @@
  */
 + (void)renderStrokes:(CVSStrokeArray *)pStrokes clippingRect:(CGRect)pClippingRect context:(CGContextRef)pContext useStrokesCGPath:(bool)pUseStrokesCGPath;
 
+/**
+ @brief as -renderStrokes:clippingRect:context:, but each stroke is clipped to the tiles of @p pTileGrid which its components intersect, and those tiles are marked as modified.
+ @details use this to render into a CVSDMMutableBitmap with -renderUsingTiledContextRenderBlock:. a long diagonal stroke then touches (and dirties) only the tiles along its path, rather than its bounds.
+ @param pFillUnderlay the image shown below the strokes (the quest's template), drawn upright in @p pFillUnderlayRect (user space), or NULL. a fill is found in the strokes' pixels composited over it, so that the template's outlines bound it.
+ */
++ (void)renderStrokes:(CVSStrokeArray *)pStrokes clippingRect:(CGRect)pClippingRect context:(CGContextRef)pContext tileGrid:(struct CVSDMTileGrid *)pTileGrid fillUnderlay:(CGImageRef)pFillUnderlay rect:(CGRect)pFillUnderlayRect;
+
+/**
+ @brief as -renderStrokes:clippingRect:context:tileGrid:fillUnderlay:rect:, for one stroke which is not a CVSStroke (e.g. a playback stroke).
+ */
++ (void)renderComponents:(const CVSSCComponent *)pComponents count:(NSUInteger)pCount brushType:(CVSBrushType)pBrushType strokeColor:(UIColor *)pStrokeColor clippingRect:(CGRect)pClippingRect context:(CGContextRef)pContext tileGrid:(struct CVSDMTileGrid *)pTileGrid fillUnderlay:(CGImageRef)pFillUnderlay rect:(CGRect)pFillUnderlayRect;
+
+/**
+ @brief adds the components to the context's current path, as the renderer builds a stroke's path. nothing is allocated.
+ @details use this to stroke a partial stroke (e.g. the stroke in progress during playback) without building a CGPath.
+ */
++ (void)addComponents:(const CVSSCComponent *)pComponents count:(NSUInteger)pCount toPathOfContext:(CGContextRef)pContext;
+
 /**
  @brief the blend mode for the specified brush type
  */
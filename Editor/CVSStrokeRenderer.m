@@ -7,11 +7,20 @@
 //
 
 #import <UIKit/UIKit.h>
+#import <libkern/OSAtomic.h>
 #import "CVSStrokeRenderer.h"
 
 #import "CVSStroke.h"
 #import "CVSStrokeArray.h"
 #import "CVSStrokeComponent.h"
+#import "CVSDrawingModel.h"
+
+#include "CVSSCFloodFill.h"
+#include "CVSSCGeometry.h"
+#include "CVSSCRaster.h"
+#include "CVSSCStamp.h"
+#include "CVSSCStrokeBatch.h"
+#include "CVSSCTileReplay.h"
 
 #pragma mark - Rendering Options
 
@@ -26,6 +35,32 @@ static const bool RenderOption_PurgeStrokesCGPathImmediately = false;
 // this is a diagnostic option to ensure rect invalidation and drawing is precise. it should not be enabled in normal circumstances.
 static const bool RenderOption_UseStrictGeometry = false;
 
+// when enabled, strokes rendered into a compatible bitmap context (8bpc RGBA, premultiplied alpha last -- e.g. CVSDMMutableBitmap)
+// are rasterized by CVSStrokeCore's software rasterizer, rather than CGContextStrokePath. other contexts use the CG variants.
+// the rasterizer clips to the paintable surface's pixels; it does not honor non-rectangular context clips.
+// the stamped brushes (spray paint, crayon) are always rendered by CVSStrokeCore's stamper, regardless of this option.
+static const bool RenderOption_UseSoftwareRasterizer = false;
+
+// when the software rasterizer renders at least this many strokes by tiles (e.g. a cache rebuild), the strokes are binned into
+// tiles of pixels and the tiles are rendered concurrently (CVSSCTileReplay). the replay renders one stroke at a time from its
+// components, so such a render does not merge strokes, even where it falls back to rendering serially (e.g. a fill): its
+// pixels are the same whichever way it is rendered.
+static const NSUInteger RenderOption_ConcurrentTileReplayMinimumStrokeCount = 32;
+
+// when enabled, a render by tiles of at least RenderOption_ConcurrentTileReplayMinimumStrokeCount strokes into a compatible
+// context uses the software rasterizer even though RenderOption_UseSoftwareRasterizer is not enabled, so that the rebuilds of
+// the cache (CVSCacheView -renderFromSnapshot, CVSEditorView -rendererShouldRedoStrokes:, CVSStrokeManager -load) are replayed
+// by tiles concurrently. other renders use CG. off: the live strokes and the smaller renders are drawn by CG, so a rebuild would
+// render the strokes which did not change with the rasterizer's antialiasing, and the canvas would shift. enable it once the
+// rasterizer matches CG's goldens (CVSSCRasterBenchmark -golden, within the tolerance of CVSStrokeCore/Goldens/Goldens.txt).
+static const bool RenderOption_UseSoftwareRasterizerForTileReplay = false;
+
+// when enabled, a run of consecutive strokes of the same brush and color is rendered as one path -- one CGContextStrokePath
+// (or CVSSCRasterizerRenderStrokes) rather than one per stroke -- where the paint is opaque or clears, so that blending the
+// run once is the same as blending each stroke (see CVSSCStrokeBatch.h). the translucent paintbrush, the stamped brushes
+// and fills are rendered a stroke at a time.
+static const bool RenderOption_MergeStrokes = true;
+
 
 /*
  These options are the closest approximation to the original, which used UIBezierPath:
@@ -39,9 +74,9 @@ static const bool RenderOption_UseStrictGeometry = false;
 
  I'm keeping the options here for a little while, because rendering is still a work in progress.
  Ultimately:
- - merging should be removed
+ - the former merging (an open path across strokes) should be removed. runs of strokes are merged by RenderOption_MergeStrokes.
  - we should keep the render context component so that we can avoid unnecessary context updates
- Basically, that involves removing .hasOpenPath and the open/stroke/close actions related to it -- we can keep .activeStrokeColor and .activeBrush.
+ Basically, that involves removing .hasOpenPath -- we can keep .activeColorIndex and .activeBrush.
  */
 
 #pragma mark - Rendering Functions/Variants
@@ -57,9 +92,72 @@ struct CVSStrokeRendererContext {
     const CGRect paintableSurface;
     const bool useStrokesCGPath;
     // fields which memo the active state of the CGContext between rendering of individual strokes
-    CGColorRef activeStrokeColor;
+    // the color cache index of the active stroke color. CVSColorIndexNone if no indexed color is active.
+    CVSColorIndex activeColorIndex;
     const CVSBrushAttributes* activeBrush;
     bool hasOpenPath;
+    // the components of the color of the last indexed stroke rendered by the software renderers
+    CVSColorIndex pixelColorIndex;
+    CVSSCColor pixelColor;
+    // pixel access, for fills and the software rasterizer. hasBitmap is false unless the context is compatible.
+    bool hasBitmap;
+    CVSSCBitmap bitmap;
+    CGAffineTransform userToPixels;
+    CVSSCTransform transform;
+    CVSSCPixelRect pixelClip;
+    // rasterizer is NULL unless the context is compatible, and RenderOption_UseSoftwareRasterizer is enabled or the render may
+    // be replayed by tiles (RenderOption_UseSoftwareRasterizerForTileReplay).
+    CVSSCRasterizer* rasterizer;
+    // created by the first fill of the render
+    CVSSCFloodFiller* filler;
+    // the image below the strokes (the quest's template), drawn in fillUnderlayRect, which a fill is found through. NULL if none.
+    CGImageRef fillUnderlayImage;
+    CGRect fillUnderlayRect;
+    // the image rendered to the bitmap's pixels, by the first fill of the render which is found. NULL until then.
+    uint8_t* fillUnderlayPixels;
+    CVSSCBitmap fillUnderlay;
+    // created by the first stroke of a stamped brush of the render
+    CVSSCStamper* stamper;
+    // tiled rendering state. tileGrid is NULL unless rendering by tiles.
+    CVSDMTileGrid* tileGrid;
+    // true if the render is by tiles and has enough strokes to be replayed concurrently (see CVSStrokeRendererContextReplaysByTiles)
+    bool hasTileReplayStrokeCount;
+    // one entry per tile, and room for one clip rect per tile
+    uint8_t* strokeTiles;
+    CGRect* strokeTileClipRects;
+};
+
+// the attributes of a stroke which the render functions use. a CVSStroke, or a stroke which exists only as components (e.g. in playback).
+struct CVSStrokeRendererStroke {
+    const CVSSCComponent* components;
+    NSUInteger componentCount;
+    CVSBrushType brushType;
+    __unsafe_unretained UIColor * color;
+    // the index of the color in the drawing's color cache, or CVSColorIndexNone
+    CVSColorIndex colorIndex;
+    CGRect bounds;
+    // nil if the stroke is not a CVSStroke, in which case it cannot be rendered using the stroke's CGPath
+    __unsafe_unretained CVSStroke * stroke;
+};
+
+static struct CVSStrokeRendererStroke CVSStrokeRendererStrokeMake(CVSStroke * const pStroke) {
+    assert(pStroke);
+    const struct CVSStrokeRendererStroke result = {
+        .components = pStroke.componentRecords,
+        .componentCount = pStroke.componentCount,
+        .brushType = pStroke.brushType,
+        .color = pStroke.strokeColor,
+        .colorIndex = pStroke.colorIndex,
+        .bounds = pStroke.bounds,
+        .stroke = pStroke
+    };
+    return result;
+}
+
+// the strokes of a run which are rendered as one path (RenderOption_MergeStrokes). batch decides which strokes may join.
+struct CVSStrokeRendererBatch {
+    CVSSCStrokeBatch batch;
+    struct CVSStrokeRendererStroke strokes[CVSSCStrokeBatchMaximumStrokeCount];
 };
 
 // returns an initialized renderer context. use this to create the structure, rather than manual initializing it.
@@ -74,10 +172,22 @@ static struct CVSStrokeRendererContext CVSStrokeRendererContextInit(CGContextRef
     struct CVSStrokeRendererContext result = {
         .context = pContext,
         .paintableSurface = CGRectIntersection(pUnionOfStrokesBounds, CGRectIntersection(pClippingRect, CGContextGetClipBoundingBox(pContext))),
-        .activeStrokeColor = NULL,
+        .activeColorIndex = CVSColorIndexNone,
         .activeBrush = NULL,
+        .pixelColorIndex = CVSColorIndexNone,
         .useStrokesCGPath = pUseStrokesCGPath,
-        .hasOpenPath = false
+        .hasOpenPath = false,
+        .hasBitmap = false,
+        .rasterizer = NULL,
+        .filler = NULL,
+        .fillUnderlayImage = NULL,
+        .fillUnderlayRect = CGRectNull,
+        .fillUnderlayPixels = NULL,
+        .stamper = NULL,
+        .tileGrid = NULL,
+        .hasTileReplayStrokeCount = false,
+        .strokeTiles = NULL,
+        .strokeTileClipRects = NULL
     };
     assert(!CGRectIsNull(result.paintableSurface));
     assert(!CGRectIsEmpty(result.paintableSurface));
@@ -123,49 +233,99 @@ static void ConfigBrushAttributes(CGContextRef pContext, const CVSBrushAttribute
     CGContextSetAlpha(pContext, pBrushAttributes->alpha);
 }
 
-// returns true if the colors are equal. one day, the colors will all be properly deduplicated, and may just use a CLUT index.
-static bool AreCGColorsEqual(CGColorRef pA, CGColorRef pB) {
-    assert(pA);
-    assert(pB);
-    if (pA == pB) {
-        return true;
+// returns true if the software rasterizer can write to the context's pixels
+static bool IsSoftwareRasterizerCompatibleContext(CGContextRef pContext) {
+    // CGBitmapContextGetData returns NULL for contexts which are not bitmap contexts
+    if (NULL == CGBitmapContextGetData(pContext)) {
+        return false;
+    }
+    const CGBitmapInfo byteOrder = CGBitmapContextGetBitmapInfo(pContext) & kCGBitmapByteOrderMask;
+    return 8 == CGBitmapContextGetBitsPerComponent(pContext)
+        && 32 == CGBitmapContextGetBitsPerPixel(pContext)
+        && kCGImageAlphaPremultipliedLast == CGBitmapContextGetAlphaInfo(pContext)
+        && (kCGBitmapByteOrderDefault == byteOrder || kCGBitmapByteOrder32Big == byteOrder)
+        && kCGColorSpaceModelRGB == CGColorSpaceGetModel(CGBitmapContextGetColorSpace(pContext));
+}
+
+// prepares access to the context's pixels if the context is compatible, and the software rasterizer if it is enabled or the
+// render may be replayed by tiles.
+// pClipRect is the clip rect of the render, in user space.
+static void CVSStrokeRendererContextBeginBitmapRender(struct CVSStrokeRendererContext* const pContext, const CGRect pClipRect) {
+    CGContextRef gtx = pContext->context;
+    if (!IsSoftwareRasterizerCompatibleContext(gtx)) {
+        return;
+    }
+    const size_t width = CGBitmapContextGetWidth(gtx);
+    const size_t height = CGBitmapContextGetHeight(gtx);
+    // CG's device space has its origin at the bottom left; the bitmap's first row is the top row
+    const CGAffineTransform deviceToPixels = CGAffineTransformMake(1.0, 0.0, 0.0, -1.0, 0.0, (CGFloat)height);
+    const CGAffineTransform userToPixels = CGAffineTransformConcat(CGContextGetCTM(gtx), deviceToPixels);
+    const CGRect clip = CGRectApplyAffineTransform(pClipRect, userToPixels);
+    pContext->hasBitmap = true;
+    pContext->bitmap = CVSSCBitmapMake(CGBitmapContextGetData(gtx), (uint32_t)width, (uint32_t)height, CGBitmapContextGetBytesPerRow(gtx));
+    pContext->userToPixels = userToPixels;
+    pContext->transform = CVSSCTransformMake(userToPixels.a, userToPixels.b, userToPixels.c, userToPixels.d, userToPixels.tx, userToPixels.ty);
+    pContext->pixelClip = (CVSSCPixelRect){
+        (int32_t)floor(CGRectGetMinX(clip)),
+        (int32_t)floor(CGRectGetMinY(clip)),
+        (int32_t)ceil(CGRectGetMaxX(clip)),
+        (int32_t)ceil(CGRectGetMaxY(clip))
+    };
+    const bool mayReplayByTiles = RenderOption_UseSoftwareRasterizerForTileReplay && pContext->hasTileReplayStrokeCount && pContext->tileGrid;
+    if (RenderOption_UseSoftwareRasterizer || mayReplayByTiles) {
+        pContext->rasterizer = CVSSCRasterizerCreate();
     }
-    return CGColorEqualToColor(pA, pB);
+}
+
+// returns true if the render's strokes may be replayed by tiles concurrently (RenderOption_ConcurrentTileReplayMinimumStrokeCount).
+// call after CVSStrokeRendererContextBeginBitmapRender. every path of such a render renders as CVSSCTileReplay does.
+static bool CVSStrokeRendererContextReplaysByTiles(const struct CVSStrokeRendererContext* const pContext) {
+    return pContext->hasTileReplayStrokeCount && pContext->tileGrid && pContext->rasterizer;
 }
 
 // call when a render will begin, before any stroke is rendered
-static void CVSStrokeRendererContextBeginRender(struct CVSStrokeRendererContext* const pContext, CVSStrokeArray * const pStrokes) {
-    assert(pStrokes.count);
+static void CVSStrokeRendererContextBeginRender(struct CVSStrokeRendererContext* const pContext, const CGRect pUnionOfStrokesBounds) {
     CGContextSaveGState(pContext->context);
     // JC: curious, clipping the intersection of the bounding box with the clipping rect results in drawing which is clipped more than it should be.
     // untested suspicion: maybe there is a bug in the bounding box expansion which does not accurately calculate the brush?
 
-    const CGRect strokesBoundingBox = pStrokes.unionOfStrokesBounds;
+    const CGRect strokesBoundingBox = pUnionOfStrokesBounds;
     assert(CGRectIntersectsRect(strokesBoundingBox, pContext->paintableSurface));
     const CGRect intersection = CGRectIntersection(strokesBoundingBox, pContext->paintableSurface);
     CGContextClipToRect(pContext->context, intersection);
     ConfigAntialiasing(pContext->context);
     ConfigInterpolation(pContext->context);
     ConfigFlatnessAndMiterLimit(pContext->context);
+    CVSStrokeRendererContextBeginBitmapRender(pContext, intersection);
 }
 
 // call when a render ends, after all strokes are rendered
 static void CVSStrokeRendererContextEndRender(struct CVSStrokeRendererContext* const pContext) {
     assert(!pContext->hasOpenPath);
+    CVSSCRasterizerDestroy(pContext->rasterizer);
+    pContext->rasterizer = NULL;
+    CVSSCFloodFillerDestroy(pContext->filler);
+    pContext->filler = NULL;
+    free(pContext->fillUnderlayPixels);
+    pContext->fillUnderlayPixels = NULL;
+    CVSSCStamperDestroy(pContext->stamper);
+    pContext->stamper = NULL;
+    pContext->hasBitmap = false;
     CGContextRestoreGState(pContext->context);
 }
 
 // call before a stroke is rendered
-static void CVSStrokeRendererContextWillRenderStroke(struct CVSStrokeRendererContext* const pContext, CVSStroke * const pStroke) {
-    // update the stroke color
-    CGColorRef color = pStroke.strokeColor.CGColor;
-    assert(color);
-    if (!pContext->activeStrokeColor || !AreCGColorsEqual(pContext->activeStrokeColor, color)) {
+static void CVSStrokeRendererContextWillRenderStroke(struct CVSStrokeRendererContext* const pContext, const struct CVSStrokeRendererStroke* const pStroke) {
+    // update the stroke color. the strokes of a drawing share the colors of its color cache, so the indices compare the colors.
+    // a stroke without an index always sets its color.
+    if (CVSColorIndexNone == pStroke->colorIndex || pContext->activeColorIndex != pStroke->colorIndex) {
+        CGColorRef color = pStroke->color.CGColor;
+        assert(color);
         CGContextSetStrokeColorWithColor(pContext->context, color);
-        pContext->activeStrokeColor = color;
+        pContext->activeColorIndex = pStroke->colorIndex;
     }
     // update the brush attributes
-    const CVSBrushAttributes* const brush = CVSBrushAttributesReferenceForBrushType(pStroke.brushType);
+    const CVSBrushAttributes* const brush = CVSBrushAttributesReferenceForBrushType(pStroke->brushType);
     assert(brush);
     if (pContext->activeBrush != brush) {
         ConfigBrushAttributes(pContext->context, brush);
@@ -173,11 +333,27 @@ static void CVSStrokeRendererContextWillRenderStroke(struct CVSStrokeRendererCon
     }
 }
 
+// gets the components of the stroke's color for the software renderers. returns false if the color is not RGB.
+static bool CVSStrokeRendererContextGetPixelColor(struct CVSStrokeRendererContext* const pContext, const struct CVSStrokeRendererStroke* const pStroke, CVSSCColor* const pOutColor) {
+    if (CVSColorIndexNone != pStroke->colorIndex && pContext->pixelColorIndex == pStroke->colorIndex) {
+        *pOutColor = pContext->pixelColor;
+        return true;
+    }
+    CGFloat red, green, blue, alpha;
+    if (![pStroke->color getRed:&red green:&green blue:&blue alpha:&alpha]) {
+        return false;
+    }
+    *pOutColor = (CVSSCColor){red, green, blue, alpha};
+    pContext->pixelColorIndex = pStroke->colorIndex;
+    pContext->pixelColor = *pOutColor;
+    return true;
+}
+
 // returns false if the stroke does not need to be rendered in this render invocation
-static bool CVSStrokeRendererContextShouldRenderStroke(struct CVSStrokeRendererContext* const pContext, CVSStroke * const pStroke) {
+static bool CVSStrokeRendererContextShouldRenderStroke(struct CVSStrokeRendererContext* const pContext, const struct CVSStrokeRendererStroke* const pStroke) {
     assert(pContext);
-    assert(pStroke);
-    const CGRect boundingBox = pStroke.bounds;
+    assert(pStroke->components);
+    const CGRect boundingBox = pStroke->bounds;
     if (CGRectIsEmpty(boundingBox)) {
         return false;
     }
@@ -187,25 +363,34 @@ static bool CVSStrokeRendererContextShouldRenderStroke(struct CVSStrokeRendererC
     return true;
 }
 
+static void ContextPathMoveToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    CGContextMoveToPoint((CGContextRef)pContext, (CGFloat)pPoint.x, (CGFloat)pPoint.y);
+}
+
+static void ContextPathAddLineToPoint(void* const pContext, const CVSSCPoint pPoint) {
+    CGContextAddLineToPoint((CGContextRef)pContext, (CGFloat)pPoint.x, (CGFloat)pPoint.y);
+}
+
+static void ContextPathAddCurveToPoint(void* const pContext, const CVSSCPoint pControlPoint1, const CVSSCPoint pControlPoint2, const CVSSCPoint pPoint) {
+    CGContextAddCurveToPoint((CGContextRef)pContext,
+                             (CGFloat)pControlPoint1.x, (CGFloat)pControlPoint1.y,
+                             (CGFloat)pControlPoint2.x, (CGFloat)pControlPoint2.y,
+                             (CGFloat)pPoint.x, (CGFloat)pPoint.y);
+}
+
 // RenderStroke_CGContext_ContextPath_* functions' individual component renderer, renders all components to the context's CGPath
-static void RenderStroke_CGContext_ContextPath_RenderStrokesComponents(CGContextRef const pContext, CVSStroke * const pStroke) {
-    for (CVSStrokeComponent * component in pStroke.components) {
-        const CGPoint fromPoint = component.fromPoint;
-        CGContextMoveToPoint(pContext, fromPoint.x, fromPoint.y);
-        const CGPoint toPoint = component.toPoint;
-        if (component.type == CVSStrokeComponentTypeCurve) {
-            const CGPoint cp1 = component.controlPoint1;
-            const CGPoint cp2 = component.controlPoint2;
-            CGContextAddCurveToPoint(pContext, cp1.x, cp1.y, cp2.x, cp2.y, toPoint.x, toPoint.y);
-        }
-        else if (component.type == CVSStrokeComponentTypePoint) {
-            CGContextAddLineToPoint(pContext, toPoint.x, toPoint.y);
-        }
-    }
+static void RenderStroke_CGContext_ContextPath_RenderStrokesComponents(CGContextRef const pContext, const struct CVSStrokeRendererStroke* const pStroke) {
+    const CVSSCPathSink sink = {
+        .context = pContext,
+        .moveToPoint = ContextPathMoveToPoint,
+        .addLineToPoint = ContextPathAddLineToPoint,
+        .addCurveToPoint = ContextPathAddCurveToPoint
+    };
+    CVSSCComponentsAddToPathSink(pStroke->components, pStroke->componentCount, &sink);
 }
 
 // renders a stroke to the CGContext using the CGContext's internal CGPath - non-merging specialization
-static void RenderStroke_CGContext_ContextPath_NonMerged(struct CVSStrokeRendererContext* const pRendererContext, CVSStroke * const pStroke) {
+static void RenderStroke_CGContext_ContextPath_NonMerged(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStroke) {
     CGContextRef gtx = pRendererContext->context;
     CVSStrokeRendererContextWillRenderStroke(pRendererContext, pStroke);
     CGContextBeginPath(gtx);
@@ -214,13 +399,13 @@ static void RenderStroke_CGContext_ContextPath_NonMerged(struct CVSStrokeRendere
 }
 
 // renders a stroke to the CGContext using the CGContext's internal CGPath
-static void RenderStroke_CGContext_ContextPath(struct CVSStrokeRendererContext* const pRendererContext, CVSStroke * const pStroke) {
+static void RenderStroke_CGContext_ContextPath(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStroke) {
     RenderStroke_CGContext_ContextPath_NonMerged(pRendererContext, pStroke);
 }
 
 // specialization of RenderStroke_CGContext_CGPath for non-merged drawing option
-static void RenderStroke_CGContext_CGPath_NonMerged(struct CVSStrokeRendererContext* const pRendererContext, CVSStroke * const pStroke) {
-    CGPathRef path = pStroke.path;
+static void RenderStroke_CGContext_CGPath_NonMerged(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStroke) {
+    CGPathRef path = pStroke->stroke.path;
     assert(path);
     CGContextRef gtx = pRendererContext->context;
     CVSStrokeRendererContextWillRenderStroke(pRendererContext, pStroke);
@@ -229,24 +414,480 @@ static void RenderStroke_CGContext_CGPath_NonMerged(struct CVSStrokeRendererCont
 }
 
 // renders a stroke to the CGContext using the CGPath created by the stroke
-static void RenderStroke_CGContext_CGPath(struct CVSStrokeRendererContext* const pRendererContext, CVSStroke * const pStroke) {
+static void RenderStroke_CGContext_CGPath(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStroke) {
     RenderStroke_CGContext_CGPath_NonMerged(pRendererContext, pStroke);
     if (RenderOption_PurgeStrokesCGPathImmediately) {
-        [pStroke purgeCachedPath];
+        [pStroke->stroke purgeCachedPath];
     }
 }
 
+// renders strokes of the same brush and color directly into the bitmap context's pixels as one path using the software rasterizer.
+// returns false if the strokes could not be rendered, in which case they should be rendered with CG.
+static bool RenderStrokes_SoftwareRasterizer(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStrokes, const NSUInteger pCount) {
+    assert(0 < pCount && pCount <= CVSSCStrokeBatchMaximumStrokeCount);
+    CVSSCColor color;
+    if (!CVSStrokeRendererContextGetPixelColor(pRendererContext, &pStrokes[0], &color)) {
+        return false;
+    }
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType((CVSSCBrushType)pStrokes[0].brushType);
+    const CVSSCComponent* components[CVSSCStrokeBatchMaximumStrokeCount];
+    size_t counts[CVSSCStrokeBatchMaximumStrokeCount];
+    for (NSUInteger idx = 0; idx < pCount; ++idx) {
+        components[idx] = pStrokes[idx].components;
+        counts[idx] = pStrokes[idx].componentCount;
+    }
+    return CVSSCRasterizerRenderStrokes(pRendererContext->rasterizer, &pRendererContext->bitmap, &pRendererContext->transform, pRendererContext->pixelClip,
+                                        brush, color, components, counts, pCount);
+}
+
+// renders a stroke directly into the bitmap context's pixels using the software rasterizer.
+// returns false if the stroke could not be rendered, in which case it should be rendered with CG.
+static bool RenderStroke_SoftwareRasterizer(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStroke) {
+    return RenderStrokes_SoftwareRasterizer(pRendererContext, pStroke, 1);
+}
+
+// the largest image of a stamped stroke which is drawn with CG, in pixels
+static const size_t StampedStrokeImageMaximumPixelCount = 4096 * 4096;
+
+// renders a stroke of a stamped brush (spray paint, crayon) with the stamper. a context whose pixels cannot be accessed has
+// the stroke stamped into an image of the stroke's device pixels, which is drawn with CG -- so the dabs are the same in every context.
+static void RenderStroke_Stamped(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStroke, const CVSSCBrushAttributes* const pBrush) {
+    CVSSCColor color;
+    if (!CVSStrokeRendererContextGetPixelColor(pRendererContext, pStroke, &color)) {
+        return;
+    }
+    if (!pRendererContext->stamper) {
+        pRendererContext->stamper = CVSSCStamperCreate();
+        if (!pRendererContext->stamper) {
+            return;
+        }
+    }
+    if (pRendererContext->hasBitmap) {
+        CVSSCStamperRenderStroke(pRendererContext->stamper, &pRendererContext->bitmap, &pRendererContext->transform, pRendererContext->pixelClip,
+                                 pBrush, color, pStroke->components, pStroke->componentCount);
+        return;
+    }
+    CGContextRef gtx = pRendererContext->context;
+    const CGRect deviceRect = CGRectIntegral(CGContextConvertRectToDeviceSpace(gtx, CGRectIntersection(pStroke->bounds, pRendererContext->paintableSurface)));
+    const size_t width = (size_t)CGRectGetWidth(deviceRect);
+    const size_t height = (size_t)CGRectGetHeight(deviceRect);
+    if (0 == width || 0 == height || StampedStrokeImageMaximumPixelCount / width < height) {
+        return;
+    }
+    CGColorSpaceRef space = CGColorSpaceCreateDeviceRGB();
+    CGContextRef imageContext = CGBitmapContextCreate(NULL, width, height, 8, 0, space, (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
+    CGColorSpaceRelease(space);
+    if (!imageContext) {
+        return;
+    }
+    const CVSSCBitmap bitmap = CVSSCBitmapMake(CGBitmapContextGetData(imageContext), (uint32_t)width, (uint32_t)height, CGBitmapContextGetBytesPerRow(imageContext));
+    CVSSCBitmapClear(&bitmap, CVSSCBitmapGetPixelRect(&bitmap));
+    // the image's first row is the top row of the device rect
+    const CGAffineTransform deviceToImage = CGAffineTransformMake(1.0, 0.0, 0.0, -1.0, -CGRectGetMinX(deviceRect), CGRectGetMaxY(deviceRect));
+    const CGAffineTransform userToImage = CGAffineTransformConcat(CGContextGetUserSpaceToDeviceSpaceTransform(gtx), deviceToImage);
+    const CVSSCTransform transform = CVSSCTransformMake(userToImage.a, userToImage.b, userToImage.c, userToImage.d, userToImage.tx, userToImage.ty);
+    const bool rendered = CVSSCStamperRenderStroke(pRendererContext->stamper, &bitmap, &transform, CVSSCBitmapGetPixelRect(&bitmap),
+                                                   pBrush, color, pStroke->components, pStroke->componentCount);
+    CGImageRef image = rendered ? CGBitmapContextCreateImage(imageContext) : NULL;
+    CGContextRelease(imageContext);
+    if (!image) {
+        return;
+    }
+    CGContextSaveGState(gtx);
+    // from the image's pixels, flipped so that the image is drawn upright
+    CGContextConcatCTM(gtx, CGAffineTransformInvert(userToImage));
+    CGContextTranslateCTM(gtx, 0.0, (CGFloat)height);
+    CGContextScaleCTM(gtx, 1.0, -1.0);
+    CGContextSetBlendMode(gtx, kCGBlendModeNormal);
+    CGContextSetAlpha(gtx, 1.0);
+    CGContextSetInterpolationQuality(gtx, kCGInterpolationNone);
+    CGContextDrawImage(gtx, CGRectMake(0.0, 0.0, (CGFloat)width, (CGFloat)height), image);
+    CGContextRestoreGState(gtx);
+    CGImageRelease(image);
+}
+
+// draws the fill spans (in the pixels of pSpansTransform) with CG, for a context whose pixels cannot be accessed
+static void RenderFillSpans_CGContext(struct CVSStrokeRendererContext* const pRendererContext, NSData * const pSpans, const CGAffineTransform pSpansTransform, const struct CVSStrokeRendererStroke* const pStroke) {
+    CGContextRef gtx = pRendererContext->context;
+    const CVSSCFillSpan* const spans = pSpans.bytes;
+    const size_t count = pSpans.length / sizeof(CVSSCFillSpan);
+    CGRect* const rects = malloc(count * sizeof(CGRect));
+    if (!rects) {
+        return;
+    }
+    for (size_t idx = 0; idx < count; ++idx) {
+        rects[idx] = CGRectMake(spans[idx].minX, spans[idx].y, spans[idx].maxX - spans[idx].minX, 1.0);
+    }
+    CGContextSaveGState(gtx);
+    CGContextConcatCTM(gtx, CGAffineTransformInvert(pSpansTransform));
+    // abutting rows must not be antialiased against each other
+    CGContextSetShouldAntialias(gtx, false);
+    CGContextSetBlendMode(gtx, kCGBlendModeNormal);
+    CGContextSetAlpha(gtx, CVSBrushAttributesReferenceForBrushType(pStroke->brushType)->alpha);
+    CGContextSetFillColorWithColor(gtx, pStroke->color.CGColor);
+    CGContextFillRects(gtx, rects, count);
+    CGContextRestoreGState(gtx);
+    free(rects);
+}
+
+// returns the fill underlay rendered to the bitmap's pixels, or NULL if the render has none or memory could not be allocated.
+// the image is drawn upright in the bitmap's user space, as the editor and playback draw the template below the cache.
+static const CVSSCBitmap* CVSStrokeRendererContextGetFillUnderlay(struct CVSStrokeRendererContext* const pContext) {
+    assert(pContext->hasBitmap);
+    if (!pContext->fillUnderlayImage) {
+        return NULL;
+    }
+    if (!pContext->fillUnderlayPixels) {
+        const uint32_t width = pContext->bitmap.width;
+        const uint32_t height = pContext->bitmap.height;
+        uint8_t* const pixels = calloc(height, 4 * (size_t)width);
+        if (!pixels) {
+            return NULL;
+        }
+        CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();
+        CGContextRef gtx = CGBitmapContextCreate(pixels, width, height, 8, 4 * (size_t)width, colorSpace, (CGBitmapInfo)kCGImageAlphaPremultipliedLast);
+        CGColorSpaceRelease(colorSpace);
+        if (!gtx) {
+            free(pixels);
+            return NULL;
+        }
+        CGContextConcatCTM(gtx, CGContextGetCTM(pContext->context));
+        ConfigInterpolation(gtx);
+        const CGRect rect = pContext->fillUnderlayRect;
+        CGContextTranslateCTM(gtx, 0.0, CGRectGetMinY(rect) + CGRectGetMaxY(rect));
+        CGContextScaleCTM(gtx, 1.0, -1.0);
+        CGContextDrawImage(gtx, rect, pContext->fillUnderlayImage);
+        CGContextRelease(gtx);
+        pContext->fillUnderlayPixels = pixels;
+        pContext->fillUnderlay = CVSSCBitmapMake(pixels, width, height, 4 * (size_t)width);
+    }
+    return &pContext->fillUnderlay;
+}
+
+// renders a fill stroke (the paint bucket). the region of the fill is found in the context's pixels as they are seen -- over the
+// fill underlay, if the render has one -- and blended with the stroke's color at the brush's alpha, as a stroke of the brush would be. the region is cached by the stroke and reused while the pixels are the same size and in the same space. a context whose
+// pixels cannot be accessed has the cached region drawn with CG, or nothing if the stroke has not been rendered to a bitmap.
+static void RenderStroke_Fill(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStroke) {
+    CVSStroke * const cachingStroke = pStroke->stroke;
+    CGAffineTransform cachedTransform = CGAffineTransformIdentity;
+    CGSize cachedPixelSize = CGSizeZero;
+    NSData * spans = [cachingStroke cachedFillSpansWithTransform:&cachedTransform pixelSize:&cachedPixelSize];
+    if (!pRendererContext->hasBitmap) {
+        if (spans.length) {
+            if (pRendererContext->tileGrid) {
+                CVSDMTileGridMarkRect(pRendererContext->tileGrid, CGContextConvertRectToDeviceSpace(pRendererContext->context, pRendererContext->paintableSurface));
+            }
+            RenderFillSpans_CGContext(pRendererContext, spans, cachedTransform, pStroke);
+        }
+        return;
+    }
+    CVSSCColor color;
+    if (!CVSStrokeRendererContextGetPixelColor(pRendererContext, pStroke, &color)) {
+        return;
+    }
+    const CVSSCBitmap* const bitmap = &pRendererContext->bitmap;
+    const CGSize pixelSize = CGSizeMake(bitmap->width, bitmap->height);
+    if (!spans || !CGAffineTransformEqualToTransform(cachedTransform, pRendererContext->userToPixels) || !CGSizeEqualToSize(cachedPixelSize, pixelSize)) {
+        if (!pRendererContext->filler) {
+            pRendererContext->filler = CVSSCFloodFillerCreate();
+        }
+        const CVSSCPoint seed = CVSSCTransformApplyToPoint(&pRendererContext->transform, pStroke->components[0].fromPoint);
+        if (!pRendererContext->filler || !(fabs(seed.x) < INT32_MAX && fabs(seed.y) < INT32_MAX)
+            || !CVSSCFloodFillerFind(pRendererContext->filler, bitmap, CVSStrokeRendererContextGetFillUnderlay(pRendererContext), (int32_t)floor(seed.x), (int32_t)floor(seed.y), CVSSCFloodFillDefaultTolerance)) {
+            return;
+        }
+        size_t count = 0;
+        const CVSSCFillSpan* const found = CVSSCFloodFillerGetSpans(pRendererContext->filler, &count);
+        spans = [NSData dataWithBytes:found length:count * sizeof(CVSSCFillSpan)];
+        [cachingStroke setCachedFillSpans:spans transform:pRendererContext->userToPixels pixelSize:pixelSize];
+    }
+    const CVSSCFillSpan* const fillSpans = spans.bytes;
+    const size_t count = spans.length / sizeof(CVSSCFillSpan);
+    const CVSSCPixelRect modified = CVSSCPixelRectIntersection(CVSSCFillSpansGetBounds(fillSpans, count), pRendererContext->pixelClip);
+    if (CVSSCPixelRectIsEmpty(modified)) {
+        return;
+    }
+    if (pRendererContext->tileGrid) {
+        // device space has its origin at the bottom left
+        const CGRect deviceRect = CGRectMake(modified.minX, (CGFloat)bitmap->height - modified.maxY, modified.maxX - modified.minX, modified.maxY - modified.minY);
+        CVSDMTileGridMarkRect(pRendererContext->tileGrid, deviceRect);
+    }
+    CVSSCFillSpansBlend(bitmap, pRendererContext->pixelClip, fillSpans, count, CVSSCBrushAttributesForBrushType((CVSSCBrushType)pStroke->brushType), color);
+}
+
+// prepares the context to render by tiles. returns false if memory could not be allocated (in which case rendering is not tiled).
+static bool CVSStrokeRendererContextBeginTiledRender(struct CVSStrokeRendererContext* const pContext, CVSDMTileGrid* const pTileGrid) {
+    const size_t tileCount = CVSDMTileGridGetTileCount(pTileGrid);
+    pContext->strokeTiles = calloc(tileCount, sizeof(uint8_t));
+    pContext->strokeTileClipRects = malloc(tileCount * sizeof(CGRect));
+    if (!pContext->strokeTiles || !pContext->strokeTileClipRects) {
+        free(pContext->strokeTiles), pContext->strokeTiles = NULL;
+        free(pContext->strokeTileClipRects), pContext->strokeTileClipRects = NULL;
+        return false;
+    }
+    pContext->tileGrid = pTileGrid;
+    return true;
+}
+
+static void CVSStrokeRendererContextEndTiledRender(struct CVSStrokeRendererContext* const pContext) {
+    free(pContext->strokeTiles), pContext->strokeTiles = NULL;
+    free(pContext->strokeTileClipRects), pContext->strokeTileClipRects = NULL;
+    pContext->tileGrid = NULL;
+}
+
+// marks the tiles which the strokes' components intersect as modified, and leaves them set in strokeTiles. returns false (and
+// marks nothing) if the strokes intersect no tile.
+static bool CVSStrokeRendererContextMarkStrokeTiles(struct CVSStrokeRendererContext* const pContext, const struct CVSStrokeRendererStroke* const pStrokes, const NSUInteger pCount) {
+    CGContextRef gtx = pContext->context;
+    CVSDMTileGrid* const tileGrid = pContext->tileGrid;
+    uint8_t* const tiles = pContext->strokeTiles;
+    const uint32_t columnCount = CVSDMTileGridGetColumnCount(tileGrid);
+    memset(tiles, 0, CVSDMTileGridGetTileCount(tileGrid));
+    bool touchesAnyTile = false;
+    for (NSUInteger strokeIdx = 0; strokeIdx < pCount; ++strokeIdx) {
+        const struct CVSStrokeRendererStroke* const stroke = &pStrokes[strokeIdx];
+        const CGFloat lineWidth = CVSBrushAttributesReferenceForBrushType(stroke->brushType)->lineWidth;
+        const CVSSCComponent* const components = stroke->components;
+        const NSUInteger componentCount = stroke->componentCount;
+        for (NSUInteger idx = 0; idx < componentCount; ++idx) {
+            const CVSSCRect bounds = CVSSCComponentsGetStrokeBounds(&components[idx], 1, lineWidth);
+            // outset by a pixel for antialiasing
+            const CGRect deviceBounds = CGRectInset(CGContextConvertRectToDeviceSpace(gtx, CGRectMake(bounds.x, bounds.y, bounds.width, bounds.height)), -1.0, -1.0);
+            const CVSDMTileRange range = CVSDMTileGridGetTileRangeForRect(tileGrid, deviceBounds);
+            for (uint32_t row = range.minRow; row < range.maxRow; ++row) {
+                memset(&tiles[(size_t)row * columnCount + range.minColumn], 1, range.maxColumn - range.minColumn);
+                touchesAnyTile = true;
+            }
+        }
+    }
+    if (!touchesAnyTile) {
+        return false;
+    }
+    CVSDMTileGridMarkTiles(tileGrid, tiles);
+    return true;
+}
+
+// marks the tiles which the strokes' components intersect as modified and clips the context to them. the context's gstate is
+// saved; balance with CVSStrokeRendererContextEndTiledStroke. returns false (and does nothing) if the strokes intersect no tile.
+static bool CVSStrokeRendererContextBeginTiledStroke(struct CVSStrokeRendererContext* const pContext, const struct CVSStrokeRendererStroke* const pStrokes, const NSUInteger pCount) {
+    if (!CVSStrokeRendererContextMarkStrokeTiles(pContext, pStrokes, pCount)) {
+        return false;
+    }
+    CGContextRef gtx = pContext->context;
+    CVSDMTileGrid* const tileGrid = pContext->tileGrid;
+    const uint8_t* const tiles = pContext->strokeTiles;
+    const uint32_t columnCount = CVSDMTileGridGetColumnCount(tileGrid);
+    const uint32_t rowCount = CVSDMTileGridGetRowCount(tileGrid);
+    // one clip rect per run of tiles in a row
+    size_t clipRectCount = 0;
+    for (uint32_t row = 0; row < rowCount; ++row) {
+        const uint8_t* const rowTiles = &tiles[(size_t)row * columnCount];
+        for (uint32_t column = 0; column < columnCount; ++column) {
+            if (!rowTiles[column]) {
+                continue;
+            }
+            const uint32_t runStart = column;
+            while (column + 1 < columnCount && rowTiles[column + 1]) {
+                ++column;
+            }
+            const CGRect first = CVSDMTileGridGetTileRect(tileGrid, (size_t)row * columnCount + runStart);
+            const CGRect last = CVSDMTileGridGetTileRect(tileGrid, (size_t)row * columnCount + column);
+            pContext->strokeTileClipRects[clipRectCount++] = CGContextConvertRectToUserSpace(gtx, CGRectUnion(first, last));
+        }
+    }
+    CGContextSaveGState(gtx);
+    CGContextClipToRects(gtx, pContext->strokeTileClipRects, clipRectCount);
+    return true;
+}
+
+static void CVSStrokeRendererContextEndTiledStroke(struct CVSStrokeRendererContext* const pContext) {
+    CGContextRestoreGState(pContext->context);
+    // the restore discarded the memoized state
+    pContext->activeColorIndex = CVSColorIndexNone;
+    pContext->activeBrush = NULL;
+}
+
 // renders an individual stroke into the context, using the active render options
-static void RenderStroke(struct CVSStrokeRendererContext* const pRendererContext, CVSStroke * const pStroke) {
+static void RenderStroke(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStroke) {
     if (!CVSStrokeRendererContextShouldRenderStroke(pRendererContext, pStroke)) {
         return;
     }
-    if (RenderOption_UseStrokesCGPath || pRendererContext->useStrokesCGPath) {
+    if (CVSSCComponentsAreFill(pStroke->components, pStroke->componentCount)) {
+        // a fill marks its own tiles, and does not use the context's clip
+        RenderStroke_Fill(pRendererContext, pStroke);
+        return;
+    }
+    const bool tiled = NULL != pRendererContext->tileGrid;
+    if (tiled && !CVSStrokeRendererContextBeginTiledStroke(pRendererContext, pStroke, 1)) {
+        return;
+    }
+    const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType((CVSSCBrushType)pStroke->brushType);
+    if (CVSSCBrushStampNone != brush->stamp) {
+        // the dabs are within the brush's width of the path, so they are within the stroke's tiles
+        RenderStroke_Stamped(pRendererContext, pStroke, brush);
+    }
+    else if (pRendererContext->rasterizer && RenderStroke_SoftwareRasterizer(pRendererContext, pStroke)) {
+        // the rasterizer does not use the context's clip. its output is within the stroke's tiles.
+    }
+    else if ((RenderOption_UseStrokesCGPath || pRendererContext->useStrokesCGPath) && pStroke->stroke) {
         RenderStroke_CGContext_CGPath(pRendererContext, pStroke);
     }
     else {
         RenderStroke_CGContext_ContextPath(pRendererContext, pStroke);
     }
+    if (tiled) {
+        CVSStrokeRendererContextEndTiledStroke(pRendererContext);
+    }
+}
+
+// renders two or more strokes of a batch as one path. the strokes have the same brush and color.
+static void RenderMergedStrokes(struct CVSStrokeRendererContext* const pRendererContext, const struct CVSStrokeRendererStroke* const pStrokes, const NSUInteger pCount) {
+    assert(1 < pCount);
+    const bool tiled = NULL != pRendererContext->tileGrid;
+    if (tiled && !CVSStrokeRendererContextBeginTiledStroke(pRendererContext, pStrokes, pCount)) {
+        return;
+    }
+    if (pRendererContext->rasterizer && RenderStrokes_SoftwareRasterizer(pRendererContext, pStrokes, pCount)) {
+        // the rasterizer does not use the context's clip. its output is within the strokes' tiles.
+    }
+    else {
+        CGContextRef gtx = pRendererContext->context;
+        const bool useStrokesCGPath = RenderOption_UseStrokesCGPath || pRendererContext->useStrokesCGPath;
+        CVSStrokeRendererContextWillRenderStroke(pRendererContext, &pStrokes[0]);
+        CGContextBeginPath(gtx);
+        for (NSUInteger idx = 0; idx < pCount; ++idx) {
+            if (useStrokesCGPath && pStrokes[idx].stroke) {
+                CGContextAddPath(gtx, pStrokes[idx].stroke.path);
+            }
+            else {
+                RenderStroke_CGContext_ContextPath_RenderStrokesComponents(gtx, &pStrokes[idx]);
+            }
+        }
+        CGContextStrokePath(gtx);
+        if (useStrokesCGPath && RenderOption_PurgeStrokesCGPathImmediately) {
+            for (NSUInteger idx = 0; idx < pCount; ++idx) {
+                [pStrokes[idx].stroke purgeCachedPath];
+            }
+        }
+    }
+    if (tiled) {
+        CVSStrokeRendererContextEndTiledStroke(pRendererContext);
+    }
+}
+
+// renders the batch's strokes, and empties it
+static void CVSStrokeRendererContextFlushBatch(struct CVSStrokeRendererContext* const pContext, struct CVSStrokeRendererBatch* const pBatch) {
+    const NSUInteger count = pBatch->batch.count;
+    if (1 == count) {
+        RenderStroke(pContext, &pBatch->strokes[0]);
+    }
+    else if (1 < count) {
+        RenderMergedStrokes(pContext, pBatch->strokes, count);
+    }
+    pBatch->batch = CVSSCStrokeBatchMakeEmpty();
+}
+
+// adds the stroke to the batch if it may be merged with the batch's strokes. otherwise, renders the batch, then begins a new
+// batch with the stroke, or renders the stroke if it may not be merged. flush the batch after the last stroke.
+static void RenderStrokeBatched(struct CVSStrokeRendererContext* const pRendererContext, struct CVSStrokeRendererBatch* const pBatch, const struct CVSStrokeRendererStroke* const pStroke) {
+    // a stroke which is not rendered does not end the run
+    if (!CVSStrokeRendererContextShouldRenderStroke(pRendererContext, pStroke)) {
+        return;
+    }
+    CVSSCColor color;
+    if (RenderOption_MergeStrokes
+        && !CVSStrokeRendererContextReplaysByTiles(pRendererContext)
+        && !CVSSCComponentsAreFill(pStroke->components, pStroke->componentCount)
+        && CVSStrokeRendererContextGetPixelColor(pRendererContext, pStroke, &color)) {
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType((CVSSCBrushType)pStroke->brushType);
+        const CGRect bounds = pStroke->bounds;
+        const CVSSCRect strokeBounds = CVSSCRectMake(bounds.origin.x, bounds.origin.y, bounds.size.width, bounds.size.height);
+        if (!CVSSCStrokeBatchAddStroke(&pBatch->batch, brush, color, strokeBounds)) {
+            CVSStrokeRendererContextFlushBatch(pRendererContext, pBatch);
+            CVSSCStrokeBatchAddStroke(&pBatch->batch, brush, color, strokeBounds);
+        }
+        if (pBatch->batch.count) {
+            pBatch->strokes[pBatch->batch.count - 1] = *pStroke;
+            return;
+        }
+    }
+    CVSStrokeRendererContextFlushBatch(pRendererContext, pBatch);
+    RenderStroke(pRendererContext, pStroke);
+}
+
+// renders the strokes with the software rasterizer, by tiles on every core, and marks the tiles of the tile grid which the strokes
+// modify. returns false (having rendered nothing) if the strokes could not be binned (e.g. one is a fill or is stamped), in which case they should be
+// rendered serially.
+static bool RenderStrokesConcurrentlyByTiles(struct CVSStrokeRendererContext* const pRendererContext, NSArray * const pStrokes) {
+    assert(pRendererContext->rasterizer);
+    assert(pRendererContext->tileGrid);
+    CVSSCTileReplay* const replay = CVSSCTileReplayCreate(&pRendererContext->bitmap, &pRendererContext->transform, pRendererContext->pixelClip, CVSSCTileReplayDefaultTileSize);
+    if (!replay) {
+        return false;
+    }
+    // bin on this thread: the strokes and their colors are not read by the workers. the components are valid until the strokes return.
+    bool binned = true;
+    for (CVSStroke * at in pStrokes) {
+        const struct CVSStrokeRendererStroke stroke = CVSStrokeRendererStrokeMake(at);
+        if (!CVSStrokeRendererContextShouldRenderStroke(pRendererContext, &stroke)) {
+            continue;
+        }
+        CVSSCColor color;
+        if (CVSSCComponentsAreFill(stroke.components, stroke.componentCount) || !CVSStrokeRendererContextGetPixelColor(pRendererContext, &stroke, &color)) {
+            binned = false;
+            break;
+        }
+        const CVSSCBrushAttributes* const brush = CVSSCBrushAttributesForBrushType((CVSSCBrushType)stroke.brushType);
+        if (!CVSSCTileReplayAddStroke(replay, brush, color, stroke.components, stroke.componentCount)) {
+            binned = false;
+            break;
+        }
+    }
+    if (!binned) {
+        CVSSCTileReplayDestroy(replay);
+        return false;
+    }
+    for (CVSStroke * at in pStrokes) {
+        const struct CVSStrokeRendererStroke stroke = CVSStrokeRendererStrokeMake(at);
+        if (CVSStrokeRendererContextShouldRenderStroke(pRendererContext, &stroke)) {
+            CVSStrokeRendererContextMarkStrokeTiles(pRendererContext, &stroke, 1);
+        }
+    }
+
+    // one worker per core takes tiles until none remain. worker 0 uses the context's rasterizer.
+    const size_t tileCount = CVSSCTileReplayGetTileCount(replay);
+    const size_t workerCount = MIN((size_t)[NSProcessInfo processInfo].activeProcessorCount, tileCount);
+    uint8_t* const failedTiles = calloc(tileCount, sizeof(uint8_t));
+    CVSSCRasterizer* const contextRasterizer = pRendererContext->rasterizer;
+    __block volatile int32_t nextTile = 0;
+    if (failedTiles && workerCount) {
+        dispatch_apply(workerCount, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^(size_t pWorker) {
+            CVSSCRasterizer* const rasterizer = 0 == pWorker ? contextRasterizer : CVSSCRasterizerCreate();
+            if (!rasterizer) {
+                // the other workers take its tiles
+                return;
+            }
+            for (size_t tile = (size_t)(OSAtomicIncrement32Barrier(&nextTile) - 1); tile < tileCount; tile = (size_t)(OSAtomicIncrement32Barrier(&nextTile) - 1)) {
+                if (CVSSCTileReplayGetTileStrokeCount(replay, tile) && !CVSSCTileReplayRenderTile(replay, rasterizer, tile)) {
+                    failedTiles[tile] = 1;
+                }
+            }
+            if (rasterizer != contextRasterizer) {
+                CVSSCRasterizerDestroy(rasterizer);
+            }
+        });
+    }
+    // tiles whose scratch memory could not be allocated resume serially, once the workers' memory has been freed
+    for (size_t tile = 0; tile < tileCount; ++tile) {
+        if (!failedTiles || failedTiles[tile]) {
+            if (!CVSSCTileReplayRenderTile(replay, contextRasterizer, tile)) {
+                assert(0 && "the tile could not be rendered");
+            }
+        }
+    }
+    free(failedTiles);
+    CVSSCTileReplayDestroy(replay);
+    return true;
 }
 
 @implementation CVSStrokeRenderer
@@ -254,8 +895,9 @@ static void RenderStroke(struct CVSStrokeRendererContext* const pRendererContext
 + (void)renderStroke:(CVSStroke *)pStroke clippingRect:(CGRect)pClippingRect context:(CGContextRef)pContext useStrokesCGPath:(bool)pUseStrokesCGPath
 {
     struct CVSStrokeRendererContext rendererContext = CVSStrokeRendererContextInit(pContext, pClippingRect, pStroke.bounds, pUseStrokesCGPath);
-    CVSStrokeRendererContextBeginRender(&rendererContext, [CVSStrokeArray newStrokeArrayWithStroke:pStroke]);
-    RenderStroke(&rendererContext, pStroke);
+    const struct CVSStrokeRendererStroke stroke = CVSStrokeRendererStrokeMake(pStroke);
+    CVSStrokeRendererContextBeginRender(&rendererContext, stroke.bounds);
+    RenderStroke(&rendererContext, &stroke);
     CVSStrokeRendererContextEndRender(&rendererContext);
 }
 
@@ -288,14 +930,98 @@ static void RenderStroke(struct CVSStrokeRendererContext* const pRendererContext
     }
     else {
         struct CVSStrokeRendererContext rendererContext = CVSStrokeRendererContextInit(pContext, pClippingRect, pStrokes.unionOfStrokesBounds, pUseStrokesCGPath);
-        CVSStrokeRendererContextBeginRender(&rendererContext, pStrokes);
-        for (CVSStroke * at in pStrokes) {
-            RenderStroke(&rendererContext, at);
+        CVSStrokeRendererContextBeginRender(&rendererContext, pStrokes.unionOfStrokesBounds);
+        // the batch refers to the strokes until it is flushed
+        NSArray * const strokes = [pStrokes strokesIntersectingRect:rendererContext.paintableSurface];
+        struct CVSStrokeRendererBatch batch = { .batch = CVSSCStrokeBatchMakeEmpty() };
+        for (CVSStroke * at in strokes) {
+            const struct CVSStrokeRendererStroke stroke = CVSStrokeRendererStrokeMake(at);
+            RenderStrokeBatched(&rendererContext, &batch, &stroke);
         }
+        CVSStrokeRendererContextFlushBatch(&rendererContext, &batch);
         CVSStrokeRendererContextEndRender(&rendererContext);
     }
 }
 
++ (void)renderStrokes:(CVSStrokeArray *)pStrokes clippingRect:(CGRect)pClippingRect context:(CGContextRef)pContext tileGrid:(CVSDMTileGrid *)pTileGrid fillUnderlay:(CGImageRef)pFillUnderlay rect:(CGRect)pFillUnderlayRect
+{
+    assert(pTileGrid);
+    if (!pStrokes.count) {
+        assert(0 && "invalid parameter");
+        return;
+    }
+    struct CVSStrokeRendererContext rendererContext = CVSStrokeRendererContextInit(pContext, pClippingRect, pStrokes.unionOfStrokesBounds, false);
+    rendererContext.fillUnderlayImage = pFillUnderlay;
+    rendererContext.fillUnderlayRect = pFillUnderlayRect;
+    if (!CVSStrokeRendererContextBeginTiledRender(&rendererContext, pTileGrid)) {
+        // untiled: everything the strokes may touch is modified
+        CVSDMTileGridMarkRect(pTileGrid, CGContextConvertRectToDeviceSpace(pContext, rendererContext.paintableSurface));
+    }
+    NSArray * const strokes = [pStrokes strokesIntersectingRect:rendererContext.paintableSurface];
+    rendererContext.hasTileReplayStrokeCount = RenderOption_ConcurrentTileReplayMinimumStrokeCount <= strokes.count;
+    CVSStrokeRendererContextBeginRender(&rendererContext, pStrokes.unionOfStrokesBounds);
+    if (!CVSStrokeRendererContextReplaysByTiles(&rendererContext) || !RenderStrokesConcurrentlyByTiles(&rendererContext, strokes)) {
+        struct CVSStrokeRendererBatch batch = { .batch = CVSSCStrokeBatchMakeEmpty() };
+        for (CVSStroke * at in strokes) {
+            const struct CVSStrokeRendererStroke stroke = CVSStrokeRendererStrokeMake(at);
+            RenderStrokeBatched(&rendererContext, &batch, &stroke);
+        }
+        CVSStrokeRendererContextFlushBatch(&rendererContext, &batch);
+    }
+    CVSStrokeRendererContextEndRender(&rendererContext);
+    CVSStrokeRendererContextEndTiledRender(&rendererContext);
+}
+
++ (void)renderComponents:(const CVSSCComponent *)pComponents count:(NSUInteger)pCount brushType:(CVSBrushType)pBrushType strokeColor:(UIColor *)pStrokeColor clippingRect:(CGRect)pClippingRect context:(CGContextRef)pContext tileGrid:(CVSDMTileGrid *)pTileGrid fillUnderlay:(CGImageRef)pFillUnderlay rect:(CGRect)pFillUnderlayRect
+{
+    assert(pStrokeColor);
+    assert(pTileGrid);
+    if (!pComponents || !pCount) {
+        assert(0 && "invalid parameter");
+        return;
+    }
+    const CGFloat lineWidth = CVSBrushAttributesReferenceForBrushType(pBrushType)->lineWidth;
+    const CVSSCRect bounds = CVSSCComponentsGetStrokeBounds(pComponents, pCount, lineWidth);
+    if (CVSSCRectIsNull(bounds)) {
+        return;
+    }
+    const struct CVSStrokeRendererStroke stroke = {
+        .components = pComponents,
+        .componentCount = pCount,
+        .brushType = pBrushType,
+        .color = pStrokeColor,
+        .colorIndex = CVSColorIndexNone,
+        .bounds = CGRectMake((CGFloat)bounds.x, (CGFloat)bounds.y, (CGFloat)bounds.width, (CGFloat)bounds.height),
+        .stroke = nil
+    };
+    if (!CGRectIntersectsRect(pClippingRect, stroke.bounds)) {
+        return;
+    }
+    struct CVSStrokeRendererContext rendererContext = CVSStrokeRendererContextInit(pContext, pClippingRect, stroke.bounds, false);
+    rendererContext.fillUnderlayImage = pFillUnderlay;
+    rendererContext.fillUnderlayRect = pFillUnderlayRect;
+    if (!CVSStrokeRendererContextBeginTiledRender(&rendererContext, pTileGrid)) {
+        CVSDMTileGridMarkRect(pTileGrid, CGContextConvertRectToDeviceSpace(pContext, rendererContext.paintableSurface));
+    }
+    CVSStrokeRendererContextBeginRender(&rendererContext, stroke.bounds);
+    RenderStroke(&rendererContext, &stroke);
+    CVSStrokeRendererContextEndRender(&rendererContext);
+    CVSStrokeRendererContextEndTiledRender(&rendererContext);
+}
+
++ (void)addComponents:(const CVSSCComponent *)pComponents count:(NSUInteger)pCount toPathOfContext:(CGContextRef)pContext
+{
+    assert(pComponents || !pCount);
+    assert(pContext);
+    const CVSSCPathSink sink = {
+        .context = pContext,
+        .moveToPoint = ContextPathMoveToPoint,
+        .addLineToPoint = ContextPathAddLineToPoint,
+        .addCurveToPoint = ContextPathAddCurveToPoint
+    };
+    CVSSCComponentsAddToPathSink(pComponents, pCount, &sink);
+}
+
 + (CGBlendMode)blendModeForBrushType:(CVSBrushType)pBrushType
 {
     return BlendModeForBrushType(pBrushType);
@@ -11,8 +11,9 @@
 #import "CVSDrawingTypes.h"
 #import "CVSStrokeRenderComplexity.h"
 
+#include "CVSSCComponent.h"
+
 @class CVSStroke;
-@class CVSStrokeComponent;
 @class CVSStrokeArray;
 
 @interface CVSStrokeView : UIView
@@ -32,7 +33,7 @@
 - (CVSStrokeArray *)dequeueStrokesToFitBelowRenderComplexityThreshold:(CVSMultipleStrokeRenderComplexity)pThreshold;
 - (CVSStrokeArray *)dequeueAllStrokesAndEraseView;
 
-- (void)drawComponent:(CVSStrokeComponent *)component brushType:(CVSBrushType)brushType strokeColor:(UIColor *)strokeColor;
+- (void)drawComponent:(const CVSSCComponent *)component brushType:(CVSBrushType)brushType strokeColor:(UIColor *)strokeColor;
 - (void)finishRenderingStroke:(CVSStroke *)stroke;
 
 - (void)drawingDidFinishLoading;
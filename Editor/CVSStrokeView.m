@@ -11,7 +11,6 @@
 #import "UIBezierPath+CVSAdditions.h"
 
 #import "CVSStroke.h"
-#import "CVSStrokeComponent.h"
 #import "CVSEditorViewRenderOptions.h"
 #import "CVSStrokeArray.h"
 #import "CVSStrokeRenderer.h"
@@ -137,14 +136,14 @@
 
 #pragma mark - Drawing Context Configuration
 
-- (void)drawComponent:(CVSStrokeComponent *)component brushType:(CVSBrushType)brushType strokeColor:(UIColor *)strokeColor
+- (void)drawComponent:(const CVSSCComponent *)component brushType:(CVSBrushType)brushType strokeColor:(UIColor *)strokeColor
 {
     self.currentBrushAttributes = CVSBrushAttributesForBrushType(brushType);
     self.currentStrokeColor = strokeColor;
 
     CVSTrackingBrush * tmpBrush = [[CVSTrackingBrush alloc] initWithBrushType:brushType];
     [tmpBrush beginTracking];
-    [tmpBrush addStrokeComponent:component];
+    [tmpBrush addPackedStrokeComponent:component];
     // do not close the path. it makes for inconsistent strokes.
     // [tmpBrush closePath];
 
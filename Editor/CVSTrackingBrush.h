@@ -5,6 +5,7 @@
 
 #import <Foundation/Foundation.h>
 #import "CVSDrawingTypes.h"
+#include "CVSSCComponent.h"
 
 @class CVSStrokeComponent;
 @class UIView;
@@ -81,6 +82,7 @@
 - (void)appendPathOfTrackingBrush:(CVSTrackingBrush *)pTrackingBrush;
 - (void)addLineToPoint:(CGPoint)pPoint;
 - (void)addStrokeComponent:(CVSStrokeComponent *)pStrokeComponent;
+- (void)addPackedStrokeComponent:(const CVSSCComponent *)pStrokeComponent;
 - (void)closePath;
 
 // rendering
@@ -141,6 +141,12 @@
     [self.trackingPath addStrokeComponent:pStrokeComponent];
 }
 
+- (void)addPackedStrokeComponent:(const CVSSCComponent *)pStrokeComponent
+{
+    assert(pStrokeComponent);
+    [self.trackingPath addPackedStrokeComponent:pStrokeComponent];
+}
+
 - (void)closePath
 {
     [self.trackingPath closePath];
@@ -6,6 +6,7 @@
 #import <Foundation/Foundation.h>
 
 #import "CVSDrawingTypes.h"
+#include "CVSSCComponent.h"
 
 @class CVSStrokeComponent;
 @class UIView;
@@ -76,6 +77,7 @@
 - (void)appendBezierPath:(UIBezierPath *)pBezierPath;
 - (void)addLineToPoint:(CGPoint)pPoint;
 - (void)addStrokeComponent:(CVSStrokeComponent *)pStrokeComponent;
+- (void)addPackedStrokeComponent:(const CVSSCComponent *)pStrokeComponent;
 - (void)closePath;
 
 /**
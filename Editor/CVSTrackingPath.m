@@ -111,6 +111,11 @@
     [self.bezierPath cvs_addStrokeComponent:pStrokeComponent];
 }
 
+- (void)addPackedStrokeComponent:(const CVSSCComponent *)pStrokeComponent
+{
+    [self.bezierPath cvs_addPackedStrokeComponent:pStrokeComponent];
+}
+
 - (void)closePath
 {
     [self.bezierPath closePath];
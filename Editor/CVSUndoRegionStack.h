@@ -0,0 +1,55 @@
+// CVSUndoRegionStack.h
+// Editor
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#import <Foundation/Foundation.h>
+
+/**
+ @brief the default number of bytes of saved regions a stack holds
+ */
+extern const size_t CVSUndoRegionStackDefaultMemoryBudget;
+
+/**
+ @brief the default number of strokes whose regions a stack holds
+ */
+extern const NSUInteger CVSUndoRegionStackDefaultDepth;
+
+/**
+ @class the pixels under each of the latest strokes, saved before the stroke was rendered -- so that undoing one of them
+ writes its region back, in time proportional to the region rather than to the drawing.
+ @details a region is the packed tiles (CVSDMPackedTileHeader) of the bitmap which the stroke's bounds intersect, as the
+ bitmap was with the strokes below it. regions are compressed (zlib) on a serial queue after they are pushed. when the
+ memory budget or the depth is exceeded, the regions of the oldest strokes are discarded. use on the main thread.
+ */
+@interface CVSUndoRegionStack : NSObject
+
+- (instancetype)initWithMemoryBudget:(size_t)pMemoryBudget depth:(NSUInteger)pDepth;
+
+@property (nonatomic, readonly) size_t memoryBudget;
+@property (nonatomic, readonly) NSUInteger depth;
+
+/**
+ @return the number of bytes of the regions held, compressed or not
+ */
+@property (nonatomic, readonly) size_t byteCount;
+
+/**
+ @brief pushes the region of the stroke at @p pStrokeIndex (the stroke count before it). the regions of strokes at or
+ above the index are discarded.
+ */
+- (void)pushRegion:(NSData *)pPackedTiles strokeIndex:(NSUInteger)pStrokeIndex;
+
+/**
+ @brief pops the region of the stroke at @p pStrokeIndex, which must be the top stroke. the regions of strokes at or
+ above the index are discarded.
+ @return the packed tiles, or nil if the region of the stroke is not held
+ */
+- (NSData *)popRegionForStrokeIndex:(NSUInteger)pStrokeIndex;
+
+/**
+ @brief discards the regions of strokes at or above @p pStrokeIndex
+ */
+- (void)removeRegionsFromStrokeIndex:(NSUInteger)pStrokeIndex;
+- (void)removeAllRegions;
+
+@end
@@ -0,0 +1,176 @@
+// CVSUndoRegionStack.m
+// Editor
+// Copyright (c) 2013 Canvas. All rights reserved.
+
+#import "CVSUndoRegionStack.h"
+
+#include <zlib.h>
+
+const size_t CVSUndoRegionStackDefaultMemoryBudget = 12U * 1024U * 1024U;
+const NSUInteger CVSUndoRegionStackDefaultDepth = 50;
+
+static const char CVSUndoRegionStack_Queue[] = "as.canv.CVSUndoRegionStack";
+
+// the region of a stroke. its tiles are replaced by their compressed form once it has been made.
+@interface CVSUndoRegion : NSObject
+
+@property (nonatomic, assign) NSUInteger strokeIndex;
+@property (nonatomic, strong) NSData * tiles;
+@property (nonatomic, assign) BOOL isCompressed;
+@property (nonatomic, assign) size_t uncompressedLength;
+
+@end
+
+@implementation CVSUndoRegion
+@end
+
+@interface CVSUndoRegionStack ()
+
+@property (nonatomic, readonly) dispatch_queue_t queue;
+// CVSUndoRegion[], ordered by stroke index
+@property (nonatomic, readonly) NSMutableArray * regions;
+
+@end
+
+@implementation CVSUndoRegionStack
+
+@synthesize queue = _queue;
+@synthesize regions = _regions;
+@synthesize memoryBudget = _memoryBudget;
+@synthesize depth = _depth;
+@synthesize byteCount = _byteCount;
+
+- (id)init
+{
+    assert(0 && "invalid initializer");
+    return nil;
+}
+
+- (instancetype)initWithMemoryBudget:(size_t)pMemoryBudget depth:(NSUInteger)pDepth
+{
+    self = [super init];
+    if (!self) {
+        return nil;
+    }
+    _memoryBudget = pMemoryBudget;
+    _depth = pDepth;
+    _regions = [NSMutableArray new];
+    _queue = dispatch_queue_create(CVSUndoRegionStack_Queue, DISPATCH_QUEUE_SERIAL);
+    if (!_queue) {
+        assert(0 && "failed to create compression queue");
+        return nil;
+    }
+    return self;
+}
+
+#pragma mark - Compression
+
+// deflates at the fastest level: a region is mostly runs of a few colors, which compress well at any level
+static NSData * CVSUndoRegionCompress(NSData * pTiles)
+{
+    uLongf length = compressBound((uLong)pTiles.length);
+    NSMutableData * const result = [[NSMutableData alloc] initWithLength:length];
+    if (!result || Z_OK != compress2(result.mutableBytes, &length, pTiles.bytes, (uLong)pTiles.length, Z_BEST_SPEED)) {
+        return nil;
+    }
+    [result setLength:length];
+    return result;
+}
+
+static NSData * CVSUndoRegionDecompress(NSData * pCompressed, const size_t pLength)
+{
+    NSMutableData * const result = [[NSMutableData alloc] initWithLength:pLength];
+    uLongf length = (uLongf)pLength;
+    if (!result || Z_OK != uncompress(result.mutableBytes, &length, pCompressed.bytes, (uLong)pCompressed.length) || length != pLength) {
+        assert(0 && "failed to decompress region");
+        return nil;
+    }
+    return result;
+}
+
+- (void)compressRegion:(CVSUndoRegion *)pRegion
+{
+    NSData * const tiles = pRegion.tiles;
+    __weak CVSUndoRegion * const weakRegion = pRegion;
+    __weak CVSUndoRegionStack * const weakSelf = self;
+    dispatch_async(self.queue, ^{
+        @autoreleasepool {
+            NSData * const compressed = CVSUndoRegionCompress(tiles);
+            if (!compressed || compressed.length >= tiles.length) {
+                return;
+            }
+            dispatch_async(dispatch_get_main_queue(), ^{
+                CVSUndoRegion * const region = weakRegion;
+                CVSUndoRegionStack * const stack = weakSelf;
+                // the region may have been popped or discarded meanwhile
+                if (!region || !stack || region.isCompressed || ![stack.regions containsObject:region]) {
+                    return;
+                }
+                stack->_byteCount -= region.tiles.length;
+                region.tiles = compressed;
+                region.isCompressed = YES;
+                stack->_byteCount += compressed.length;
+            });
+        }
+    });
+}
+
+#pragma mark - Regions
+
+- (void)removeRegionAtIndex:(NSUInteger)pIndex
+{
+    CVSUndoRegion * const region = self.regions[pIndex];
+    _byteCount -= region.tiles.length;
+    [self.regions removeObjectAtIndex:pIndex];
+}
+
+- (void)enforceBudget
+{
+    // the newest region is kept even if it alone exceeds the budget
+    while (1 < self.regions.count && (self.depth < self.regions.count || self.memoryBudget < self.byteCount)) {
+        [self removeRegionAtIndex:0];
+    }
+}
+
+- (void)pushRegion:(NSData *)pPackedTiles strokeIndex:(NSUInteger)pStrokeIndex
+{
+    assert(pPackedTiles);
+    [self removeRegionsFromStrokeIndex:pStrokeIndex];
+    if (!self.depth) {
+        return;
+    }
+    CVSUndoRegion * const region = [CVSUndoRegion new];
+    region.strokeIndex = pStrokeIndex;
+    region.tiles = pPackedTiles;
+    region.uncompressedLength = pPackedTiles.length;
+    [self.regions addObject:region];
+    _byteCount += pPackedTiles.length;
+    [self enforceBudget];
+    [self compressRegion:region];
+}
+
+- (NSData *)popRegionForStrokeIndex:(NSUInteger)pStrokeIndex
+{
+    CVSUndoRegion * const region = self.regions.lastObject;
+    if (!region || pStrokeIndex != region.strokeIndex) {
+        [self removeRegionsFromStrokeIndex:pStrokeIndex];
+        return nil;
+    }
+    [self removeRegionAtIndex:self.regions.count - 1];
+    return region.isCompressed ? CVSUndoRegionDecompress(region.tiles, region.uncompressedLength) : region.tiles;
+}
+
+- (void)removeRegionsFromStrokeIndex:(NSUInteger)pStrokeIndex
+{
+    while (self.regions.count && pStrokeIndex <= [self.regions.lastObject strokeIndex]) {
+        [self removeRegionAtIndex:self.regions.count - 1];
+    }
+}
+
+- (void)removeAllRegions
+{
+    [self.regions removeAllObjects];
+    _byteCount = 0;
+}
+
+@end
@@ -21,6 +21,7 @@ typedef NS_ENUM(uint8_t, CVSUniqueObjectCacheObjectInsertionPolicy) {
 /**
  @class the unique object cache is a simple homogenous collection which contains a set of objects. objects this represents should generally be immutable (and copied where possible).
  @details this type is not thread safe. this class presently offers no mutable/immutable distinction.
+ the objects are ordered as they were added, so an object may be identified by its index. removing an object moves the objects after it.
  */
 @interface CVSUniqueObjectCache : NSObject <NSCopying,NSFastEnumeration>
 
@@ -32,6 +33,15 @@ typedef NS_ENUM(uint8_t, CVSUniqueObjectCacheObjectInsertionPolicy) {
 /** @method returns an NSSet containing all elements */
 - (NSSet *)allObjects;
 
+/** @return the number of objects */
+- (NSUInteger)count;
+
+/** @return the index of the object equal to @p pObject, NSNotFound if not found */
+- (NSUInteger)indexOfObject:(id)pObject;
+
+/** @return the object at @p pIndex, which must be less than the count */
+- (id)objectAtIndex:(NSUInteger)pIndex;
+
 /** @method adds @p pObject to the set */
 - (void)addObject:(id)pObject;
 /** @method adds all objects in @p pObjects into the collection */
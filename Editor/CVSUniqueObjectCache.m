@@ -10,7 +10,7 @@
 
 @interface CVSUniqueObjectCache ()
 
-@property (nonatomic, readonly) NSMutableSet * objects;
+@property (nonatomic, readonly) NSMutableOrderedSet * objects;
 @property (nonatomic, readonly) Class objectType;
 @property (nonatomic, readonly) CVSUniqueObjectCacheObjectInsertionPolicy objectInsertionPolicy;
 
@@ -25,7 +25,7 @@
     if (self == nil) {
         return nil;
     }
-    _objects = [NSMutableSet set];
+    _objects = [NSMutableOrderedSet orderedSet];
     _objectType = pObjectType;
     _objectInsertionPolicy = pObjectInsertionPolicy;
     if (pObjectInsertionPolicy == CVSUniqueObjectCacheObjectInsertionPolicyCopy) {
@@ -56,12 +56,28 @@
 
 - (NSSet *)allObjects
 {
-    return self.objects.copy;
+    return [NSSet setWithArray:self.objects.array];
+}
+
+- (NSUInteger)count
+{
+    return self.objects.count;
+}
+
+- (NSUInteger)indexOfObject:(id)pObject
+{
+    return [self.objects indexOfObject:pObject];
+}
+
+- (id)objectAtIndex:(NSUInteger)pIndex
+{
+    return [self.objects objectAtIndex:pIndex];
 }
 
 - (id)member:(id)pObject
 {
-    return [self.objects member:pObject];
+    const NSUInteger index = [self.objects indexOfObject:pObject];
+    return NSNotFound == index ? nil : [self.objects objectAtIndex:index];
 }
 
 - (void)imp_insertObject:(id)pObject
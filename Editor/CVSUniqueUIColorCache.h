@@ -8,11 +8,24 @@
 
 #import <Foundation/Foundation.h>
 #import "CVSUniqueObjectCache.h"
+#include "CVSSCPalette.h"
 
 @class UIColor;
 
+/**
+ @brief the index of a color in a CVSUniqueUIColorCache.
+ */
+typedef CVSSCPaletteIndex CVSColorIndex;
+
+/**
+ @constant the index of no color (e.g. of a stroke whose color has not been deduplicated).
+ */
+enum { CVSColorIndexNone = CVSSCPaletteIndexNone };
+
 /**
  @class a collection of unique UIColors
+ @details the cache of a drawing is its color lookup table: a color keeps its index as long as colors are only added, so
+ the drawing's strokes (and the renderer, and the serializers) identify their colors by index.
  */
 @interface CVSUniqueUIColorCache : CVSUniqueObjectCache <NSCopying>
 
@@ -28,4 +41,10 @@
 /** @return the unique color instance, adding it if necessary */
 - (UIColor *)uniqueUIColor:(UIColor *)pColor;
 
+/** @return the index of the color, adding it if necessary. CVSColorIndexNone if the cache has CVSSCPaletteMaxCount colors. */
+- (CVSColorIndex)indexOfUIColor:(UIColor *)pColor;
+
+/** @return the unique color at @p pIndex, which must be less than the count */
+- (UIColor *)uiColorAtIndex:(CVSColorIndex)pIndex;
+
 @end
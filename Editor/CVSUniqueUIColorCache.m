@@ -57,4 +57,25 @@
     return [self uniqueObject:pColor];
 }
 
+- (CVSColorIndex)indexOfUIColor:(UIColor *)pColor
+{
+    assert(pColor);
+    NSUInteger index = [self indexOfObject:pColor];
+    if (NSNotFound == index) {
+        if (CVSSCPaletteMaxCount <= self.count) {
+            return CVSColorIndexNone;
+        }
+        [self addObject:pColor];
+        index = self.count - 1;
+    }
+    assert(index < CVSColorIndexNone);
+    return (CVSColorIndex)index;
+}
+
+- (UIColor *)uiColorAtIndex:(CVSColorIndex)pIndex
+{
+    assert(pIndex < self.count);
+    return [self objectAtIndex:pIndex];
+}
+
 @end
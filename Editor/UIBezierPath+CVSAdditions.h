@@ -7,11 +7,14 @@
 //
 
 #import <UIKit/UIKit.h>
+#include "CVSSCComponent.h"
 
 @class CVSStrokeComponent;
 
 @interface UIBezierPath (CVSAdditions)
 
 - (void)cvs_addStrokeComponent:(CVSStrokeComponent *)component;
+- (void)cvs_addPackedStrokeComponent:(const CVSSCComponent *)component;
+- (void)cvs_addPackedStrokeComponents:(const CVSSCComponent *)components count:(NSUInteger)count;
 
 @end
@@ -10,6 +10,8 @@
 
 #import "CVSStrokeComponent.h"
 
+#include "CVSSCGeometry.h"
+
 @implementation UIBezierPath (CVSAdditions)
 
 - (void)cvs_addStrokeComponent:(CVSStrokeComponent *)component
@@ -23,4 +25,37 @@
     }
 }
 
+static CGPoint CGPointFromSCPoint(const CVSSCPoint p) {
+    return CGPointMake((CGFloat)p.x, (CGFloat)p.y);
+}
+
+static void BezierPathMoveToPoint(void * const pContext, const CVSSCPoint pPoint) {
+    [(__bridge UIBezierPath *)pContext moveToPoint:CGPointFromSCPoint(pPoint)];
+}
+
+static void BezierPathAddLineToPoint(void * const pContext, const CVSSCPoint pPoint) {
+    [(__bridge UIBezierPath *)pContext addLineToPoint:CGPointFromSCPoint(pPoint)];
+}
+
+static void BezierPathAddCurveToPoint(void * const pContext, const CVSSCPoint pControlPoint1, const CVSSCPoint pControlPoint2, const CVSSCPoint pPoint) {
+    [(__bridge UIBezierPath *)pContext addCurveToPoint:CGPointFromSCPoint(pPoint) controlPoint1:CGPointFromSCPoint(pControlPoint1) controlPoint2:CGPointFromSCPoint(pControlPoint2)];
+}
+
+- (void)cvs_addPackedStrokeComponent:(const CVSSCComponent *)component
+{
+    assert(component);
+    [self cvs_addPackedStrokeComponents:component count:1];
+}
+
+- (void)cvs_addPackedStrokeComponents:(const CVSSCComponent *)components count:(NSUInteger)count
+{
+    const CVSSCPathSink sink = {
+        .context = (__bridge void *)self,
+        .moveToPoint = BezierPathMoveToPoint,
+        .addLineToPoint = BezierPathAddLineToPoint,
+        .addCurveToPoint = BezierPathAddCurveToPoint
+    };
+    CVSSCComponentsAddToPathSink(components, count, &sink);
+}
+
 @end